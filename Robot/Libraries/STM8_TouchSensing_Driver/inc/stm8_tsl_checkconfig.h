@@ -495,6 +495,14 @@
 // TSL PARAMETERS CONFIGURATION
 //============================================================================
 
+#if !defined(SLICED_ACQUISITION)
+#define SLICED_ACQUISITION (0)
+#endif
+
+#if SLICED_ACQUISITION && defined(CHARGE_TRANSFER)
+#error "SLICED_ACQUISITION is only available with the RC acquisition !"
+#endif
+
 #if !defined(NEGDETECT_AUTOCAL)
 #error "Please define NEGDETECT_AUTOCAL (with value at 0 or 1)"
 #endif
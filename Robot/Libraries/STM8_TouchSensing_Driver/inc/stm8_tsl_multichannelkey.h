@@ -35,6 +35,9 @@
 void TSL_MCKey_Init(void);
 void TSL_MCKey1_Acquisition(void);
 void TSL_MCKey2_Acquisition(void);
+#if SLICED_ACQUISITION
+u8 TSL_MCKey_Acquisition_Slice(u8 Key, u8 ShieldMask);
+#endif
 void TSL_MCKey_Process(void);
 void TSL_MCKey_IdleTreatment(void);
 void TSL_MCKey_PreDetectTreatment(void);
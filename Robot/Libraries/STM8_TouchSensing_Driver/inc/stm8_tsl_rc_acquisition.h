@@ -91,6 +91,8 @@ extern CONST u16 Table_MCKEY_PORTS[];
 void TSL_IO_Init(void);
 void TSL_IO_Clamp(void);
 void TSL_IO_Acquisition(u8 AcqNumber, u8 AdjustmentEnable);
+void TSL_IO_Acquisition_Start(u8 AcqNumber, u8 AdjustmentLevel);
+u8 TSL_IO_Acquisition_Slice(void);
 void TSL_IO_SW_Burst_TestSyncShift(void);
 void TSL_IO_SW_Burst_Wait_Vil(void);
 void TSL_IO_SW_Burst_Wait_Vih(void);
@@ -37,6 +37,9 @@ void TSL_SCKey_SetAcquisitionMasks(void);
 void TSL_SCKEY_P1_Acquisition(void);
 void TSL_SCKEY_P2_Acquisition(void);
 void TSL_SCKEY_P3_Acquisition(void);
+#if SLICED_ACQUISITION
+u8 TSL_SCKey_Acquisition_Slice(u16 PortAddr, u8 FirstKey, u8 EndKey, u8 ShieldMask);
+#endif
 void TSL_SCKey_Process(void);
 void TSL_RefKey_Process(void);
 void TSL_SCKey_IdleTreatment(void);
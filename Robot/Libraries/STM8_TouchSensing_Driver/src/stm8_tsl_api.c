@@ -206,7 +206,14 @@ void TSL_Action(void)
       break;
 
     case TSL_SCKEY_P1_ACQ_STATE:
+#if SLICED_ACQUISITION
+      if (!TSL_SCKey_Acquisition_Slice(SCKEY_P1_PORT_ADDR, 0, SCKEY_P1_KEY_COUNT, SCKEY_P1_DRIVEN_SHIELD_MASK))
+      {
+        break;
+      }
+#else
       TSL_SCKEY_P1_Acquisition();
+#endif
 #if NUMBER_OF_SINGLE_CHANNEL_PORTS > 0
       TSLState = TSL_SCKEY_P1_PROC_STATE;
       break;
@@ -231,7 +238,14 @@ void TSL_Action(void)
 
 #if NUMBER_OF_ACQUISITION_PORTS > 1
     case TSL_SCKEY_P2_ACQ_STATE:
+#if SLICED_ACQUISITION
+      if (!TSL_SCKey_Acquisition_Slice(SCKEY_P2_PORT_ADDR, SCKEY_P1_KEY_COUNT, (SCKEY_P1_KEY_COUNT + SCKEY_P2_KEY_COUNT), SCKEY_P2_DRIVEN_SHIELD_MASK))
+      {
+        break;
+      }
+#else
       TSL_SCKEY_P2_Acquisition();
+#endif
 #if NUMBER_OF_SINGLE_CHANNEL_PORTS > 1
       TSLState = TSL_SCKEY_P2_PROC_STATE;
       break;
@@ -256,7 +270,14 @@ void TSL_Action(void)
 
 #if NUMBER_OF_ACQUISITION_PORTS > 2
     case TSL_SCKEY_P3_ACQ_STATE:
+#if SLICED_ACQUISITION
+      if (!TSL_SCKey_Acquisition_Slice(SCKEY_P3_PORT_ADDR, (SCKEY_P1_KEY_COUNT + SCKEY_P2_KEY_COUNT), (SCKEY_P1_KEY_COUNT + SCKEY_P2_KEY_COUNT + SCKEY_P3_KEY_COUNT), SCKEY_P3_DRIVEN_SHIELD_MASK))
+      {
+        break;
+      }
+#else
       TSL_SCKEY_P3_Acquisition();
+#endif
 #if NUMBER_OF_SINGLE_CHANNEL_PORTS > 2
       TSLState = TSL_SCKEY_P3_PROC_STATE;
       break;
@@ -277,7 +298,14 @@ void TSL_Action(void)
 
 #if NUMBER_OF_MULTI_CHANNEL_KEYS > 0
     case TSL_MCKEY1_ACQ_STATE:
+#if SLICED_ACQUISITION
+      if (!TSL_MCKey_Acquisition_Slice(0, MCKEY1_DRIVEN_SHIELD_MASK))
+      {
+        break;
+      }
+#else
       TSL_MCKey1_Acquisition();
+#endif
 #if NUMBER_OF_MULTI_CHANNEL_KEYS > 1
       TSLState = TSL_MCKEY2_ACQ_STATE;
 #else
@@ -287,7 +315,14 @@ void TSL_Action(void)
 
 #if NUMBER_OF_MULTI_CHANNEL_KEYS > 1
     case TSL_MCKEY2_ACQ_STATE:
+#if SLICED_ACQUISITION
+      if (!TSL_MCKey_Acquisition_Slice(1, MCKEY2_DRIVEN_SHIELD_MASK))
+      {
+        break;
+      }
+#else
       TSL_MCKey2_Acquisition();
+#endif
       TSLState = TSL_MCKEY_PROC_STATE;
       break;
 #endif
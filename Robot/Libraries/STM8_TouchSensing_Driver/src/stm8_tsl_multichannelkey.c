@@ -39,6 +39,11 @@
 /* Private define ------------------------------------------------------------*/
 /* Private macro -------------------------------------------------------------*/
 /* Private variables ---------------------------------------------------------*/
+#if SLICED_ACQUISITION
+/* Channel measured by the sliced acquisition, valid while SliceBusy is set */
+static u8 SliceChannelIndex;
+static u8 SliceBusy;
+#endif
 /* Private function prototypes -----------------------------------------------*/
 /* Private functions ---------------------------------------------------------*/
 
@@ -1034,6 +1039,63 @@ void TSL_MCKey2_Acquisition(void)
 }
 #endif
 
+#if SLICED_ACQUISITION
+/**
+  ******************************************************************************
+  * @brief Take one sample of the channels of a MCKey. The channels are
+  * measured in turn, one sample per call, so the calls are short enough to
+  * let the application run between them.
+  * @param[in] Key MCKey index (0 = MCKEY1, 1 = MCKEY2).
+  * @param[in] ShieldMask Driven shield mask of the MCKey.
+  * @retval u8 1 when every channel of the MCKey is measured, 0 otherwise.
+  * @par Required preconditions:
+  * The same MCKey must be passed until it is measured.
+  ******************************************************************************
+  */
+u8 TSL_MCKey_Acquisition_Slice(u8 Key, u8 ShieldMask)
+{
+  u8 Channel;
+
+  KeyIndex = Key;
+  TSL_MCKey_SetStructPointer();
+
+  if (SliceBusy)
+  {
+    if (!TSL_IO_Acquisition_Slice())
+    {
+      return 0;
+    }
+    SliceChannelIndex++;
+  }
+  else
+  {
+    if ((pMCKeyStruct->State.whole == ERROR_STATE) || (pMCKeyStruct->State.whole == DISABLED_STATE))
+    {
+      return 1;
+    }
+    SliceChannelIndex = 0;
+  }
+
+  /* Start the next channel, its samples are taken by the next calls */
+  if (SliceChannelIndex < CHANNEL_PER_MCKEY)
+  {
+    Channel = (u8)(Key * CHANNEL_PER_MCKEY + SliceChannelIndex);
+    sTouchIO.PORT_ADDR = (GPIO_TypeDef *)(Table_MCKEY_PORTS[Channel]);
+    sTouchIO.AcqMask = Table_MCKEY_BITS[Channel];
+    sTouchIO.DriveMask = (u8)(sTouchIO.AcqMask | ShieldMask);
+    sTouchIO.Measurement = &sMCKeyInfo[Key].Channel[SliceChannelIndex].LastMeas;
+    sTouchIO.RejectedNb = &sMCKeyInfo[Key].Channel[SliceChannelIndex].LastMeasRejectNb;
+    sTouchIO.Type = MCKEY_TYPE;
+    TSL_IO_Acquisition_Start(MCKEY_ACQ_NUM, MCKEY_ADJUST_LEVEL);
+    SliceBusy = 1;
+    return 0;
+  }
+
+  SliceBusy = 0;
+  return 1;
+}
+#endif
+
 
 /**
   ******************************************************************************
@@ -61,6 +61,11 @@ u8 TINY SamplingShifter;
 u8 TINY AcquisitionBitMask;
 static u8 SpreadCounter;
 
+/* Measurement in progress, see TSL_IO_Acquisition_Start */
+static u8 RejectionCounter;
+static u8 AcqRemaining;
+static u8 AcqAdjustmentLevel;
+
 /* Private function prototypes -----------------------------------------------*/
 /* Private functions ---------------------------------------------------------*/
 /* Public functions ----------------------------------------------------------*/
@@ -596,28 +601,24 @@ void TSL_IO_SW_Burst_Stop_Timer(void)
 
 /**
   ******************************************************************************
-  * @brief Handles RC charge / discharge timing measurement.
+  * @brief Start an RC charge / discharge timing measurement, the samples are
+  * taken by TSL_IO_Acquisition_Slice.
   * @param[in] AcqNumber Number of times the acquisition is done.
   * @param[in] AdjustmentLevel Used to adjust the measured level.
   * @retval void None
   * @par Required preconditions:
-  * None
+  * sTouchIO must describe the channel to measure.
   ******************************************************************************
   */
-void TSL_IO_Acquisition(u8 AcqNumber, u8 AdjustmentLevel)
+void TSL_IO_Acquisition_Start(u8 AcqNumber, u8 AdjustmentLevel)
 {
 
-  u16 MaxMeasurement, MinMeasurement, CumulatedMeasurement, Measurement;
-  u8 MeasRejected, RejectionCounter;
-  u8 AcqLoopIndex;
-  u32 tmpval;
-
   AcquisitionBitMask = sTouchIO.AcqMask;
 
-  MinMeasurement = 0;
-  MaxMeasurement = 0;
   FinalMeasurementValue = 0;
   RejectionCounter = 0;
+  AcqRemaining = AcqNumber;
+  AcqAdjustmentLevel = AdjustmentLevel;
 
   /* Whole acquisition synchronisation */
   /* The IT_Sync_Flag.start must be set to 1 inside an IT or it will loop forever */
@@ -629,8 +630,32 @@ void TSL_IO_Acquisition(u8 AcqNumber, u8 AdjustmentLevel)
   }
 #endif
 
+}
+
+
+/**
+  ******************************************************************************
+  * @brief Take one sample of the measurement started by
+  * TSL_IO_Acquisition_Start, the result is stored with the last one.
+  * Interrupts are enabled between two samples.
+  * @par Parameters:
+  * None
+  * @retval u8 1 when the measurement is done, 0 if samples are left.
+  * @par Required preconditions:
+  * sTouchIO must not change until the measurement is done.
+  ******************************************************************************
+  */
+u8 TSL_IO_Acquisition_Slice(void)
+{
+
+  u16 MaxMeasurement, MinMeasurement, CumulatedMeasurement, Measurement;
+  u8 MeasRejected, AdjustmentLevel;
+  u32 tmpval;
+
+  MinMeasurement = 0;
+  MaxMeasurement = 0;
 
-  for (AcqLoopIndex = 0; AcqLoopIndex < AcqNumber; AcqLoopIndex++)
+  if (AcqRemaining != 0)
   {
     /* single measurement synchronisation */
     /* The IT_Sync_Flag.start must be set to 1 inside an IT or it will loop forever */
@@ -739,16 +764,25 @@ void TSL_IO_Acquisition(u8 AcqNumber, u8 AdjustmentLevel)
     }
     while (MeasRejected && (RejectionCounter <= MAX_REJECTED_MEASUREMENTS));
 
+    enableInterrupts();
+
     if (MeasRejected == 0)
     {
       FinalMeasurementValue += CumulatedMeasurement;
+      AcqRemaining--;
     }
     else // RejectionCounter > MAX_REJECTED_MEASUREMENTS
     {
-      break; // Out from 'for AcqLoopIndex' loop !!!
+      AcqRemaining = 0;
     }
 
-  } /* for AcqLoopIndex... */
+    if (AcqRemaining != 0)
+    {
+      return 0;
+    }
+  }
+
+  AdjustmentLevel = AcqAdjustmentLevel;
 
   TSL_IO_Clamp(); // To avoid consumption
   enableInterrupts();
@@ -780,6 +814,28 @@ void TSL_IO_Acquisition(u8 AcqNumber, u8 AdjustmentLevel)
 #endif
   }
 
+  return 1;
+
+}
+
+
+/**
+  ******************************************************************************
+  * @brief Handles RC charge / discharge timing measurement.
+  * @param[in] AcqNumber Number of times the acquisition is done.
+  * @param[in] AdjustmentLevel Used to adjust the measured level.
+  * @retval void None
+  * @par Required preconditions:
+  * None
+  ******************************************************************************
+  */
+void TSL_IO_Acquisition(u8 AcqNumber, u8 AdjustmentLevel)
+{
+
+  TSL_IO_Acquisition_Start(AcqNumber, AdjustmentLevel);
+
+  while (!TSL_IO_Acquisition_Slice());
+
 }
 
 #endif
@@ -36,6 +36,11 @@
 /* Private define ------------------------------------------------------------*/
 /* Private macro -------------------------------------------------------------*/
 /* Private variables ---------------------------------------------------------*/
+#if SLICED_ACQUISITION
+/* Key measured by the sliced acquisition, valid while SliceBusy is set */
+static u8 SliceKeyIndex;
+static u8 SliceBusy;
+#endif
 /* Private function prototypes -----------------------------------------------*/
 /* Private functions ---------------------------------------------------------*/
 
@@ -281,6 +286,62 @@ void TSL_SCKEY_P3_Acquisition(void)
 }
 #endif
 
+#if SLICED_ACQUISITION
+/**
+  ******************************************************************************
+  * @brief Take one sample of the keys of a port. The keys are measured in
+  * turn, one sample per call, so the calls are short enough to let the
+  * application run between them.
+  * @param[in] PortAddr GPIO base address of the port.
+  * @param[in] FirstKey Index of the first key of the port.
+  * @param[in] EndKey Index after the last key of the port.
+  * @param[in] ShieldMask Driven shield mask of the port.
+  * @retval u8 1 when every key of the port is measured, 0 otherwise.
+  * @par Required preconditions:
+  * The same port must be passed until it is measured.
+  ******************************************************************************
+  */
+u8 TSL_SCKey_Acquisition_Slice(u16 PortAddr, u8 FirstKey, u8 EndKey, u8 ShieldMask)
+{
+  if (SliceBusy)
+  {
+    KeyIndex = SliceKeyIndex;
+    TSL_SetStructPointer();
+    if (!TSL_IO_Acquisition_Slice())
+    {
+      return 0;
+    }
+    SliceKeyIndex++;
+  }
+  else
+  {
+    sTouchIO.PORT_ADDR = (GPIO_TypeDef *)(PortAddr);
+    SliceKeyIndex = FirstKey;
+  }
+
+  /* Start the next key, its samples are taken by the next calls */
+  for (; SliceKeyIndex < EndKey; SliceKeyIndex++)
+  {
+    KeyIndex = SliceKeyIndex;
+    TSL_SetStructPointer();
+    if ((pKeyStruct->State.whole != ERROR_STATE) && (pKeyStruct->State.whole != DISABLED_STATE))
+    {
+      sTouchIO.AcqMask = Table_SCKEY_BITS[KeyIndex];
+      sTouchIO.DriveMask = (u8)(sTouchIO.AcqMask | ShieldMask);
+      sTouchIO.Measurement = &sSCKeyInfo[KeyIndex].Channel.LastMeas;
+      sTouchIO.RejectedNb = &sSCKeyInfo[KeyIndex].Channel.LastMeasRejectNb;
+      sTouchIO.Type = SCKEY_TYPE;
+      TSL_IO_Acquisition_Start(SCKEY_ACQ_NUM, SCKEY_ADJUST_LEVEL);
+      SliceBusy = 1;
+      return 0;
+    }
+  }
+
+  SliceBusy = 0;
+  return 1;
+}
+#endif
+
 #if NUMBER_OF_SINGLE_CHANNEL_KEYS > 0
 
 /**
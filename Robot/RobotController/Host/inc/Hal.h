@@ -0,0 +1,158 @@
+/*******************************************************************************
+  * @file Hal.h
+  * @brief Defines the simulated peripheral state shared between the host
+  *        peripheral library (hal.c) and the simulator
+  * @author David Sharpe
+  * @version V1.0.0
+  * @date 14-October-2026
+  *
+  * Host build using GCC
+  *****************************************************************************/
+#ifndef HAL_H
+#define HAL_H
+
+////////////////////////////////////////////////////////////////////////////////
+// Includes
+////////////////////////////////////////////////////////////////////////////////
+#include "stm8s.h"
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Definitions
+////////////////////////////////////////////////////////////////////////////////
+#define HAL_CLOCK_FREQ      16000000UL
+#define HAL_EXTI_PORTS      5
+#define HAL_EEPROM_SIZE     1024
+#define HAL_FLASH_SIZE      0x8000 //program memory from 0x8000
+#define HAL_ADC_CHANNELS    10
+#define HAL_IRQ_COUNT       25
+#define HAL_TOUCH_SLIDER    0xFF //touchKey of the slider
+
+//Simulated peripheral state
+typedef struct
+{
+    //Interrupt enables
+    unsigned char tim1UpdateIt;
+    unsigned char tim1Cc4It;
+    unsigned char uartTxeIt;
+    unsigned char uartRxneIt;
+    unsigned char uartIdleIt;
+    unsigned char spiRxneIt;
+
+    //Software priority of each interrupt, ITC_PRIORITYLEVEL_ value. The 
+    //simulator delivers the interrupts one at a time whatever the level.
+    unsigned char itcPriority[HAL_IRQ_COUNT];
+
+    //Peripheral enables and settings
+    unsigned char tim1Enabled;
+    unsigned char tim2Enabled;
+    unsigned char uartEnabled;
+    unsigned char spiEnabled;
+    unsigned char extiSensitivity[HAL_EXTI_PORTS];
+
+    //SPI byte written to DR and not yet clocked out, and the clock divider
+    //the bytes per ms follow
+    unsigned char spiTx;
+    unsigned char spiTxFull;
+    unsigned char spiDivider;
+
+    //TIM1 count within the current tick in us. The simulated interrupts
+    //set it while they run, in the main loop it follows the real time
+    //since the tick.
+    unsigned short tim1Counter;
+    unsigned char inInterrupt;
+    long long tickStart;   //ns
+    long long tickLength;  //ns
+
+    //TIM1 trigger output, TIM1_TRGOSOURCE_ value
+    unsigned char tim1Trgo;
+
+    //TIM1 channel 4 input capture, the count at the last edge
+    unsigned char tim1Cc4Enabled;
+    unsigned short tim1Capture4;
+
+    //ADC1 settings, the analog inputs in counts and the data buffer
+    unsigned char adcEnabled;
+    unsigned char adcEocIt;
+    unsigned char adcExtTrigger;
+    unsigned char adcScan;
+    unsigned char adcBuffered;
+    unsigned char adcChannel;
+    unsigned short adcInput[HAL_ADC_CHANNELS];
+    unsigned short adcBuffer[HAL_ADC_CHANNELS];
+    unsigned long adcScans;
+
+    //TIM2 compare values (PWM duty) and their preload registers, moved to
+    //the compare values on each update event unless updates are disabled.
+    //The auto-reload is preloaded the same way.
+    unsigned short pwmCompare[2];
+    unsigned short pwmReload;
+    unsigned short pwmReloadPreload;
+    unsigned char pwmReloadPreloadEnabled;
+    unsigned short pwmPreload[2];
+    unsigned char pwmPreloadEnabled[2];
+    unsigned char tim2UpdateDisabled;
+    unsigned char tim2UpdateIt;
+    unsigned char tim2UpdateFlag;
+
+    //Touch key or slider, one at a time, where the slider is touched, how 
+    //long it is held in ms and when it is let go, and the 0.5ms library 
+    //timebase calls
+    unsigned char touchPending;
+    unsigned char touchKey;
+    unsigned char touchPosition;
+    unsigned long touchHold;
+    long long touchRelease; //ns
+    unsigned long tslTicks;
+
+    //Time spent in wfi
+    long long idleNanos;
+
+    //CPU clock divider, the times it was raised and touch acquisitions run
+    //below full speed. The peripherals keep the master clock.
+    unsigned char cpuDivider;
+    unsigned long cpuSlowdowns;
+    unsigned long tslSlowActions;
+
+    //Data EEPROM, erased bytes read 0. A word write finishes on the next
+    //tick.
+    unsigned char eeprom[HAL_EEPROM_SIZE];
+    unsigned char eepromUnlocked;
+    unsigned char eepromBusy;
+    unsigned char eepromEop;
+    unsigned long eepromWords;
+    unsigned long eepromErrors;
+
+    //Program memory, erased bytes read 0. The CPU stalls while a block or
+    //word is written, so a write is done when the call returns.
+    unsigned char flash[HAL_FLASH_SIZE];
+    unsigned char flashUnlocked;
+    unsigned long flashBlocks;
+    unsigned long flashErrors;
+
+    //Independent watchdog, ms since the last reload and the longest gap
+    unsigned char iwdgEnabled;
+    unsigned char iwdgWriteAccess;
+    unsigned char iwdgPrescaler;
+    unsigned char iwdgReload;
+    unsigned short iwdgElapsed;
+    unsigned short iwdgWorst;
+
+    //Reset status flags, RST_FLAG_ bits of the reset the run starts from.
+    //None is a power up.
+    unsigned char rstFlags;
+} HalState;
+
+extern HalState hal;
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Functions
+////////////////////////////////////////////////////////////////////////////////
+void Hal_Initialize(void);
+long long Hal_GetNanos(void);
+void Hal_UartTransmit(unsigned char byte);
+unsigned short Hal_GetWatchdogTimeout(void);
+unsigned long Hal_GetUartBaud(void);
+
+#endif
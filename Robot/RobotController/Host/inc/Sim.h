@@ -0,0 +1,128 @@
+/*******************************************************************************
+  * @file Sim.h
+  * @brief Defines the host simulator: the scripted ESP8266, the script
+  *        engine and the wheel model
+  * @author David Sharpe
+  * @version V1.0.0
+  * @date 14-October-2026
+  *
+  * Host build using GCC
+  *****************************************************************************/
+#ifndef SIM_H
+#define SIM_H
+
+////////////////////////////////////////////////////////////////////////////////
+// Includes
+////////////////////////////////////////////////////////////////////////////////
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Definitions
+////////////////////////////////////////////////////////////////////////////////
+#define SIM_RECORD_SIZE     256  //Longest line or datagram sent by the robot
+#define SIM_RECORD_COUNT    64
+#define SIM_RX_QUEUE_SIZE   4096
+#define SIM_UART_BITS       10   //Bits per byte, 8N1
+#define SIM_MODULE_BAUD     115200 //Module baud rate after a reset
+#define SIM_BAUD_TOLERANCE  2    //Percent difference the line survives
+
+#define SIM_SPI_CREDIT      4    //Chunks the SPI link module has room for
+#define SIM_SPI_QUEUE       64   //Chunks it holds for the robot
+#define SIM_SPI_BOOT        120  //ms until it answers after power up
+
+#define SIM_WHEEL_MAX       600  //Encoder edges/s at full duty
+#define SIM_WHEEL_LAG       50   //ms time constant of the wheel speed
+
+#define SIM_BATTERY_MV      7400 //Battery voltage with the motors off
+#define SIM_BATTERY_MOHM    250  //Battery internal resistance
+#define SIM_MOTOR_MA        800  //Motor current at full duty
+
+#define SIM_ECHO_DELAY      450  //us from the range trigger to the echo
+
+#define SIM_REPLAY_SIZE     65536 //Largest receive corpus
+#define SIM_REPLAY_PASSES   1000  //Times each corpus is parsed when timed
+
+//Traffic sent by the robot, split into command lines and the datagram
+//payloads that follow each CIPSEND
+enum SimRecordType
+{
+    SIM_RECORD_LINE,
+    SIM_RECORD_DATA
+};
+
+typedef struct
+{
+    unsigned char type;
+    unsigned short length;
+    unsigned char data[SIM_RECORD_SIZE];
+} SimRecord;
+
+//Script results
+enum SimResult
+{
+    SIM_RUNNING,
+    SIM_PASS,
+    SIM_FAIL
+};
+
+//Totals for the end of run report
+typedef struct
+{
+    unsigned long txBytes;
+    unsigned long rxBytes;
+    unsigned long txRecords;
+    unsigned long rxDatagrams;
+    unsigned long encoderEdges;
+} SimStats;
+
+extern SimStats simStats;
+extern int simVerbose;
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Functions
+////////////////////////////////////////////////////////////////////////////////
+
+//Scripted ESP8266, Esp8266Sim.c for the AT firmware on the UART or
+//Esp8266SpiSim.c for the SPI link firmware
+void EspSim_Initialize(void);
+void EspSim_Transmit(unsigned char byte);
+int  EspSim_Receive(unsigned char *byte);
+int  EspSim_IsRxEmpty(void);
+void EspSim_Reply(const unsigned char *data, unsigned short length);
+void EspSim_Datagram(unsigned char link, const char *ip, unsigned long port,
+                     const unsigned char *data, unsigned short length);
+void EspSim_SetBaud(unsigned long baud);
+void EspSim_SetLineError(unsigned char flags);
+unsigned char EspSim_GetByteError(void);
+int  EspSim_IsBaudMatched(void);
+int  EspSim_GetRecord(SimRecord *record);
+
+//SPI link side of the scripted ESP8266
+unsigned char EspSim_Exchange(unsigned char byte, unsigned char first);
+void EspSim_EndTransfer(void);
+int  EspSim_UpdateReady(unsigned long now);
+
+//Script engine
+int  Script_Load(const char *path);
+unsigned char Script_Tick(unsigned long now);
+unsigned long Script_GetReplies(unsigned char *buffer, unsigned long size);
+int  Script_GetExpectRx(long *counts);
+
+//Receive corpus replay
+int  Replay_Run(const char *path);
+
+//Wheel model
+void Wheel_Tick(void);
+signed short Wheel_GetSpeed(unsigned char wheel);
+signed short Wheel_GetPwm(unsigned char wheel);
+void Wheel_SetGain(unsigned char left, unsigned char right);
+
+//Obstacle ahead of the range sensor
+void Obstacle_Set(unsigned short mm);
+void Obstacle_Tick(void);
+
+//Motor current sense comparator
+void Overcurrent_Set(unsigned char on);
+
+#endif
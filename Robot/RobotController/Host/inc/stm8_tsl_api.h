@@ -0,0 +1,106 @@
+/*******************************************************************************
+  * @file stm8_tsl_api.h
+  * @brief Host stand-in for the STM8 Touch Sensing library. Provides the key
+  *        state used by the firmware, touches are injected by the simulator.
+  *        The host builds the touch panel of stm8_tsl_conf.h, its two keys
+  *        and slider follow the key on PC1.
+  * @author David Sharpe
+  * @version V1.0.0
+  * @date 14-October-2026
+  *
+  * Host build using GCC
+  *****************************************************************************/
+#ifndef STM8_TSL_API_H
+#define STM8_TSL_API_H
+
+////////////////////////////////////////////////////////////////////////////////
+// Includes
+////////////////////////////////////////////////////////////////////////////////
+#include "stm8s.h"
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Definitions
+////////////////////////////////////////////////////////////////////////////////
+#ifndef TOUCH_PANEL_ENABLE
+#define TOUCH_PANEL_ENABLE  1
+#endif
+
+#if TOUCH_PANEL_ENABLE
+#define NUMBER_OF_SINGLE_CHANNEL_KEYS   3
+#define NUMBER_OF_MULTI_CHANNEL_KEYS    1
+#else
+#define NUMBER_OF_SINGLE_CHANNEL_KEYS   1
+#define NUMBER_OF_MULTI_CHANNEL_KEYS    0
+#endif
+
+#define MCKEY_RESOLUTION_DEFAULT        4
+
+//A scan runs in one step on the host, the other states are for the schedule
+typedef enum
+{
+    TSL_IDLE_STATE          = 0x01,
+    TSL_SCKEY_P1_ACQ_STATE  = 0x02,
+    TSL_SCKEY_P1_PROC_STATE = 0x03,
+    TSL_SCKEY_P2_ACQ_STATE  = 0x04,
+    TSL_SCKEY_P2_PROC_STATE = 0x05,
+    TSL_SCKEY_P3_ACQ_STATE  = 0x06,
+    TSL_SCKEY_P3_PROC_STATE = 0x07,
+    TSL_MCKEY1_ACQ_STATE    = 0x08,
+    TSL_MCKEY2_ACQ_STATE    = 0x09,
+    TSL_MCKEY_PROC_STATE    = 0x0A,
+    TSL_ECS_STATE           = 0x0B
+} TSLState_T;
+
+typedef union
+{
+    unsigned char whole;
+    struct
+    {
+        unsigned char IMPLEMENTED : 1;
+        unsigned char ENABLED     : 1;
+        unsigned char DETECTED    : 1;
+        unsigned char CHANGED     : 1;
+        unsigned char POSCHANGED  : 1;
+    } b;
+} KeyFlag_T;
+
+typedef union
+{
+    unsigned char whole;
+    struct
+    {
+        unsigned char User1_Start_100ms : 1;
+    } b;
+} TimerFlag_T;
+
+typedef struct
+{
+    KeyFlag_T Setting;
+    unsigned char DxSGroup;
+} Single_Channel_Complete_Info_T;
+
+typedef struct
+{
+    KeyFlag_T Setting;
+    unsigned char DxSGroup;
+    unsigned char Position;
+} Penta_Channel_Complete_Info_T;
+
+extern TSLState_T TSLState;
+extern KeyFlag_T TSL_GlobalSetting;
+extern TimerFlag_T TSL_Tick_Flags;
+extern Single_Channel_Complete_Info_T sSCKeyInfo[NUMBER_OF_SINGLE_CHANNEL_KEYS];
+#if NUMBER_OF_MULTI_CHANNEL_KEYS > 0
+extern Penta_Channel_Complete_Info_T sMCKeyInfo[NUMBER_OF_MULTI_CHANNEL_KEYS];
+#endif
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Functions
+////////////////////////////////////////////////////////////////////////////////
+void TSL_Init(void);
+void TSL_Action(void);
+void TSL_Timer_ISR(void);
+
+#endif
@@ -0,0 +1,593 @@
+/*******************************************************************************
+  * @file stm8s.h
+  * @brief Host stand-in for the STM8S standard peripheral library. Only the
+  *        registers, constants and functions used by the firmware are
+  *        provided, the peripherals are simulated in hal.c.
+  * @author David Sharpe
+  * @version V1.0.0
+  * @date 14-October-2026
+  *
+  * Host build using GCC
+  *****************************************************************************/
+#ifndef STM8S_H
+#define STM8S_H
+
+////////////////////////////////////////////////////////////////////////////////
+// Includes
+////////////////////////////////////////////////////////////////////////////////
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Definitions
+////////////////////////////////////////////////////////////////////////////////
+typedef signed char     int8_t;
+typedef signed short    int16_t;
+typedef unsigned char   uint8_t;
+typedef unsigned short  uint16_t;
+typedef unsigned int    uint32_t;
+
+typedef uint8_t  u8;
+typedef uint16_t u16;
+typedef uint32_t u32;
+
+typedef enum {FALSE = 0, TRUE = !FALSE} bool;
+typedef enum {RESET = 0, SET = !RESET} FlagStatus, ITStatus;
+typedef enum {DISABLE = 0, ENABLE = !DISABLE} FunctionalState;
+
+//Interrupt mask, the simulated interrupts are signals
+void Hal_EnableInterrupts(void);
+void Hal_DisableInterrupts(void);
+void Hal_WaitForInterrupt(void);
+#define enableInterrupts()    Hal_EnableInterrupts()
+#define disableInterrupts()   Hal_DisableInterrupts()
+#define wfi()                 Hal_WaitForInterrupt()
+
+//Memory placement, the host has one flat space
+#define TINY
+#define NEAR
+
+//Stand-in for the stack region, the firmware runs on the host stack so it
+//is only painted and never used
+extern unsigned char Hal_Stack[512];
+#define MEMORY_STACK_BOTTOM   Hal_Stack
+
+//Microbenchmark clock, host time in ns, so the results are ns per call 
+//rather than cycles. The scheduler's count follows the simulated time, 
+//which stands still while a batch runs.
+unsigned short Hal_GetBenchCount(void);
+#define MICRO_CLOCK()           Hal_GetBenchCount()
+#define MICRO_CYCLES_PER_COUNT  1
+
+//The simulator sees the peripherals through the library calls, FastIo.h 
+//keeps them
+#undef FAST_IO_ENABLE
+#define FAST_IO_ENABLE          0
+
+//Mask inside an interrupt routine and put the previous mask back
+unsigned char Hal_MaskInterrupts(void);
+void Hal_RestoreInterrupts(unsigned char mask);
+#define maskInterrupts(cc)    ((cc) = Hal_MaskInterrupts())
+#define restoreInterrupts(cc) Hal_RestoreInterrupts(cc)
+
+//Registers
+typedef struct
+{
+    volatile uint8_t ODR;
+    volatile uint8_t IDR;
+    volatile uint8_t DDR;
+    volatile uint8_t CR1;
+    volatile uint8_t CR2;
+    volatile uint8_t falls; //host only, pins GPIO_WriteLow took high to low
+} GPIO_TypeDef;
+
+typedef struct
+{
+    volatile uint8_t SR1;
+    volatile uint8_t CCER2;
+} TIM1_TypeDef;
+
+typedef struct
+{
+    volatile uint8_t SR;
+    volatile uint8_t DR;
+    volatile uint8_t BRR1;
+    volatile uint8_t BRR2;
+} UART2_TypeDef;
+
+typedef struct
+{
+    volatile uint8_t SR;
+    volatile uint8_t DR;    //the byte clocked in, a write goes to hal.spiTx
+} SPI_TypeDef;
+
+extern GPIO_TypeDef Hal_GPIOA;
+extern GPIO_TypeDef Hal_GPIOB;
+extern GPIO_TypeDef Hal_GPIOC;
+extern GPIO_TypeDef Hal_GPIOD;
+extern GPIO_TypeDef Hal_GPIOE;
+extern GPIO_TypeDef Hal_GPIOG;
+extern TIM1_TypeDef Hal_TIM1;
+extern UART2_TypeDef Hal_UART2;
+extern SPI_TypeDef Hal_SPI;
+
+#define GPIOA   (&Hal_GPIOA)
+#define GPIOB   (&Hal_GPIOB)
+#define GPIOC   (&Hal_GPIOC)
+#define GPIOD   (&Hal_GPIOD)
+#define GPIOE   (&Hal_GPIOE)
+#define GPIOG   (&Hal_GPIOG)
+#define TIM1    (&Hal_TIM1)
+#define UART2   (&Hal_UART2)
+#define SPI     (&Hal_SPI)
+
+#define TIM1_SR1_UIF    ((uint8_t)0x01)
+#define TIM1_CCER2_CC4P ((uint8_t)0x20)
+
+#define UART2_SR_TXE    ((uint8_t)0x80)
+#define UART2_SR_TC     ((uint8_t)0x40)
+#define UART2_SR_RXNE   ((uint8_t)0x20)
+#define UART2_SR_IDLE   ((uint8_t)0x10)
+#define UART2_SR_OR     ((uint8_t)0x08)
+#define UART2_SR_NF     ((uint8_t)0x04)
+#define UART2_SR_FE     ((uint8_t)0x02)
+
+#define SPI_SR_TXE      ((uint8_t)0x02)
+#define SPI_SR_RXNE     ((uint8_t)0x01)
+
+//Clock
+typedef enum
+{
+    CLK_PRESCALER_HSIDIV1 = 0x00,
+    CLK_PRESCALER_CPUDIV1 = 0x80,
+    CLK_PRESCALER_CPUDIV2 = 0x81,
+    CLK_PRESCALER_CPUDIV4 = 0x82,
+    CLK_PRESCALER_CPUDIV8 = 0x83,
+    CLK_PRESCALER_CPUDIV16 = 0x84,
+    CLK_PRESCALER_CPUDIV32 = 0x85,
+    CLK_PRESCALER_CPUDIV64 = 0x86,
+    CLK_PRESCALER_CPUDIV128 = 0x87
+} CLK_Prescaler_TypeDef;
+
+typedef enum
+{
+    CLK_PERIPHERAL_I2C,
+    CLK_PERIPHERAL_SPI,
+    CLK_PERIPHERAL_UART2,
+    CLK_PERIPHERAL_TIMER4,
+    CLK_PERIPHERAL_TIMER2,
+    CLK_PERIPHERAL_TIMER3,
+    CLK_PERIPHERAL_TIMER1,
+    CLK_PERIPHERAL_AWU,
+    CLK_PERIPHERAL_ADC
+} CLK_Peripheral_TypeDef;
+
+//GPIO
+typedef enum
+{
+    GPIO_PIN_0   = 0x01,
+    GPIO_PIN_1   = 0x02,
+    GPIO_PIN_2   = 0x04,
+    GPIO_PIN_3   = 0x08,
+    GPIO_PIN_4   = 0x10,
+    GPIO_PIN_5   = 0x20,
+    GPIO_PIN_6   = 0x40,
+    GPIO_PIN_7   = 0x80,
+    GPIO_PIN_ALL = 0xFF
+} GPIO_Pin_TypeDef;
+
+typedef enum
+{
+    GPIO_MODE_IN_FL_NO_IT      = 0x00,
+    GPIO_MODE_IN_PU_NO_IT      = 0x40,
+    GPIO_MODE_IN_FL_IT         = 0x20,
+    GPIO_MODE_IN_PU_IT         = 0x60,
+    GPIO_MODE_OUT_PP_LOW_FAST  = 0xE0,
+    GPIO_MODE_OUT_PP_HIGH_FAST = 0xF0
+} GPIO_Mode_TypeDef;
+
+//External interrupts
+typedef enum
+{
+    EXTI_PORT_GPIOA,
+    EXTI_PORT_GPIOB,
+    EXTI_PORT_GPIOC,
+    EXTI_PORT_GPIOD,
+    EXTI_PORT_GPIOE
+} EXTI_Port_TypeDef;
+
+typedef enum
+{
+    EXTI_SENSITIVITY_FALL_LOW  = 0x00,
+    EXTI_SENSITIVITY_RISE_ONLY = 0x01,
+    EXTI_SENSITIVITY_FALL_ONLY = 0x02,
+    EXTI_SENSITIVITY_RISE_FALL = 0x03
+} EXTI_Sensitivity_TypeDef;
+
+typedef enum
+{
+    ITC_IRQ_PORTB    = 4,
+    ITC_IRQ_PORTD    = 6,
+    ITC_IRQ_PORTE    = 7,
+    ITC_IRQ_SPI      = 10,
+    ITC_IRQ_TIM1_OVF = 11,
+    ITC_IRQ_TIM1_CAPCOM = 12,
+    ITC_IRQ_TIM2_OVF = 13,
+    ITC_IRQ_UART2_TX = 20,
+    ITC_IRQ_UART2_RX = 21,
+    ITC_IRQ_ADC1     = 22
+} ITC_Irq_TypeDef;
+
+typedef enum
+{
+    ITC_PRIORITYLEVEL_1 = 0x01,
+    ITC_PRIORITYLEVEL_2 = 0x00,
+    ITC_PRIORITYLEVEL_3 = 0x03
+} ITC_PriorityLevel_TypeDef;
+
+//TIM1
+typedef enum
+{
+    TIM1_COUNTERMODE_UP = 0x00
+} TIM1_CounterMode_TypeDef;
+
+typedef enum
+{
+    TIM1_IT_UPDATE = 0x01,
+    TIM1_IT_CC4    = 0x10
+} TIM1_IT_TypeDef;
+
+typedef enum
+{
+    TIM1_CHANNEL_4 = 0x03
+} TIM1_Channel_TypeDef;
+
+typedef enum
+{
+    TIM1_ICPOLARITY_RISING  = 0x00,
+    TIM1_ICPOLARITY_FALLING = 0x01
+} TIM1_ICPolarity_TypeDef;
+
+typedef enum
+{
+    TIM1_ICSELECTION_DIRECTTI = 0x01
+} TIM1_ICSelection_TypeDef;
+
+typedef enum
+{
+    TIM1_ICPSC_DIV1 = 0x00
+} TIM1_ICPSC_TypeDef;
+
+typedef enum
+{
+    TIM1_TRGOSOURCE_RESET  = 0x00,
+    TIM1_TRGOSOURCE_UPDATE = 0x20
+} TIM1_TRGOSource_TypeDef;
+
+//TIM2
+typedef enum
+{
+    TIM2_PRESCALER_1 = 0x00
+} TIM2_Prescaler_TypeDef;
+
+typedef enum
+{
+    TIM2_OCMODE_PWM1 = 0x60,
+    TIM2_OCMODE_PWM2 = 0x70
+} TIM2_OCMode_TypeDef;
+
+typedef enum
+{
+    TIM2_OUTPUTSTATE_DISABLE = 0x00,
+    TIM2_OUTPUTSTATE_ENABLE  = 0x11
+} TIM2_OutputState_TypeDef;
+
+typedef enum
+{
+    TIM2_OCPOLARITY_HIGH = 0x00,
+    TIM2_OCPOLARITY_LOW  = 0x22
+} TIM2_OCPolarity_TypeDef;
+
+typedef enum
+{
+    TIM2_IT_UPDATE = 0x01
+} TIM2_IT_TypeDef;
+
+typedef enum
+{
+    TIM2_PSCRELOADMODE_UPDATE    = 0x00,
+    TIM2_PSCRELOADMODE_IMMEDIATE = 0x01
+} TIM2_PSCReloadMode_TypeDef;
+
+//ADC1
+typedef enum
+{
+    ADC1_CONVERSIONMODE_SINGLE     = 0x00,
+    ADC1_CONVERSIONMODE_CONTINUOUS = 0x01
+} ADC1_ConvMode_TypeDef;
+
+typedef enum
+{
+    ADC1_CHANNEL_0 = 0x00,
+    ADC1_CHANNEL_1 = 0x01,
+    ADC1_CHANNEL_2 = 0x02
+} ADC1_Channel_TypeDef;
+
+typedef enum
+{
+    ADC1_PRESSEL_FCPU_D8 = 0x40
+} ADC1_PresSel_TypeDef;
+
+typedef enum
+{
+    ADC1_EXTTRIG_TIM  = 0x00,
+    ADC1_EXTTRIG_GPIO = 0x10
+} ADC1_ExtTrig_TypeDef;
+
+typedef enum
+{
+    ADC1_ALIGN_LEFT  = 0x00,
+    ADC1_ALIGN_RIGHT = 0x08
+} ADC1_Align_TypeDef;
+
+typedef enum
+{
+    ADC1_SCHMITTTRIG_CHANNEL0 = 0x00,
+    ADC1_SCHMITTTRIG_CHANNEL1 = 0x01,
+    ADC1_SCHMITTTRIG_CHANNEL2 = 0x02
+} ADC1_SchmittTrigg_TypeDef;
+
+typedef enum
+{
+    ADC1_IT_EOCIE = 0x020,
+    ADC1_IT_EOC   = 0x080
+} ADC1_IT_TypeDef;
+
+//FLASH, the program memory and data EEPROM are simulated
+#define FLASH_PROG_START_PHYSICAL_ADDRESS ((uint32_t)0x008000)
+#define FLASH_PROG_END_PHYSICAL_ADDRESS   ((uint32_t)0x00FFFF)
+#define FLASH_DATA_START_PHYSICAL_ADDRESS ((uint32_t)0x004000)
+#define FLASH_DATA_END_PHYSICAL_ADDRESS   ((uint32_t)0x0043FF)
+#define FLASH_BLOCK_SIZE                  ((uint8_t)128)
+
+typedef enum
+{
+    FLASH_MEMTYPE_PROG = 0xFD,
+    FLASH_MEMTYPE_DATA = 0xF7
+} FLASH_MemType_TypeDef;
+
+typedef enum
+{
+    FLASH_FLAG_HVOFF = 0x40,
+    FLASH_FLAG_DUL   = 0x08,
+    FLASH_FLAG_EOP   = 0x04
+} FLASH_Flag_TypeDef;
+
+typedef enum
+{
+    FLASH_PROGRAMMODE_STANDARD = 0x00,
+    FLASH_PROGRAMMODE_FAST     = 0x10
+} FLASH_ProgramMode_TypeDef;
+
+typedef enum
+{
+    FLASH_STATUS_END_HIGH_VOLTAGE       = 0x40,
+    FLASH_STATUS_SUCCESSFUL_OPERATION   = 0x04,
+    FLASH_STATUS_TIMEOUT                = 0x02,
+    FLASH_STATUS_WRITE_PROTECTION_ERROR = 0x01
+} FLASH_Status_TypeDef;
+
+//IWDG
+typedef enum
+{
+    IWDG_WriteAccess_Enable  = 0x55,
+    IWDG_WriteAccess_Disable = 0x00
+} IWDG_WriteAccess_TypeDef;
+
+typedef enum
+{
+    IWDG_Prescaler_4   = 0x00,
+    IWDG_Prescaler_8   = 0x01,
+    IWDG_Prescaler_16  = 0x02,
+    IWDG_Prescaler_32  = 0x03,
+    IWDG_Prescaler_64  = 0x04,
+    IWDG_Prescaler_128 = 0x05,
+    IWDG_Prescaler_256 = 0x06
+} IWDG_Prescaler_TypeDef;
+
+//RST
+typedef enum
+{
+    RST_FLAG_EMCF   = 0x10,
+    RST_FLAG_SWIMF  = 0x08,
+    RST_FLAG_ILLOPF = 0x04,
+    RST_FLAG_IWDGF  = 0x02,
+    RST_FLAG_WWDGF  = 0x01
+} RST_Flag_TypeDef;
+
+//UART2
+typedef enum
+{
+    UART2_WORDLENGTH_8D = 0x00
+} UART2_WordLength_TypeDef;
+
+typedef enum
+{
+    UART2_STOPBITS_1 = 0x00
+} UART2_StopBits_TypeDef;
+
+typedef enum
+{
+    UART2_PARITY_NO = 0x00
+} UART2_Parity_TypeDef;
+
+typedef enum
+{
+    UART2_SYNCMODE_CLOCK_DISABLE = 0x80
+} UART2_SyncMode_TypeDef;
+
+typedef enum
+{
+    UART2_MODE_TXRX_ENABLE = 0x0C
+} UART2_Mode_TypeDef;
+
+typedef enum
+{
+    UART2_IT_TXE  = 0x0277,
+    UART2_IT_TC   = 0x0266,
+    UART2_IT_RXNE = 0x0255,
+    UART2_IT_IDLE = 0x0244
+} UART2_IT_TypeDef;
+
+//SPI
+typedef enum
+{
+    SPI_DATADIRECTION_2LINES_FULLDUPLEX = 0x00
+} SPI_DataDirection_TypeDef;
+
+typedef enum
+{
+    SPI_NSS_SOFT = 0x02
+} SPI_NSS_TypeDef;
+
+typedef enum
+{
+    SPI_MODE_MASTER = 0x04
+} SPI_Mode_TypeDef;
+
+typedef enum
+{
+    SPI_BAUDRATEPRESCALER_2 = 0x00,
+    SPI_BAUDRATEPRESCALER_4 = 0x08,
+    SPI_BAUDRATEPRESCALER_8 = 0x10
+} SPI_BaudRatePrescaler_TypeDef;
+
+typedef enum
+{
+    SPI_CLOCKPOLARITY_LOW = 0x00
+} SPI_ClockPolarity_TypeDef;
+
+typedef enum
+{
+    SPI_CLOCKPHASE_1EDGE = 0x00
+} SPI_ClockPhase_TypeDef;
+
+typedef enum
+{
+    SPI_FIRSTBIT_MSB = 0x00
+} SPI_FirstBit_TypeDef;
+
+typedef enum
+{
+    SPI_IT_TXE  = 0x17,
+    SPI_IT_RXNE = 0x06
+} SPI_IT_TypeDef;
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Functions
+////////////////////////////////////////////////////////////////////////////////
+void ADC1_DeInit(void);
+void ADC1_Init(ADC1_ConvMode_TypeDef mode, ADC1_Channel_TypeDef channel,
+               ADC1_PresSel_TypeDef prescaler, ADC1_ExtTrig_TypeDef trigger,
+               FunctionalState triggerState, ADC1_Align_TypeDef align,
+               ADC1_SchmittTrigg_TypeDef schmitt, FunctionalState schmittState);
+void ADC1_Cmd(FunctionalState state);
+void ADC1_ScanModeCmd(FunctionalState state);
+void ADC1_DataBufferCmd(FunctionalState state);
+void ADC1_ITConfig(ADC1_IT_TypeDef it, FunctionalState state);
+void ADC1_SchmittTriggerConfig(ADC1_SchmittTrigg_TypeDef channel,
+                               FunctionalState state);
+uint16_t ADC1_GetBufferValue(uint8_t buffer);
+void ADC1_ClearITPendingBit(ADC1_IT_TypeDef it);
+
+void CLK_HSIPrescalerConfig(CLK_Prescaler_TypeDef prescaler);
+void CLK_SYSCLKConfig(CLK_Prescaler_TypeDef prescaler);
+void CLK_PeripheralClockConfig(CLK_Peripheral_TypeDef peripheral,
+                               FunctionalState state);
+uint32_t CLK_GetClockFreq(void);
+
+void GPIO_DeInit(GPIO_TypeDef *port);
+void GPIO_Init(GPIO_TypeDef *port, GPIO_Pin_TypeDef pins, GPIO_Mode_TypeDef mode);
+void GPIO_WriteHigh(GPIO_TypeDef *port, GPIO_Pin_TypeDef pins);
+void GPIO_WriteLow(GPIO_TypeDef *port, GPIO_Pin_TypeDef pins);
+void GPIO_WriteReverse(GPIO_TypeDef *port, GPIO_Pin_TypeDef pins);
+uint8_t GPIO_ReadInputData(GPIO_TypeDef *port);
+
+void EXTI_SetExtIntSensitivity(EXTI_Port_TypeDef port,
+                               EXTI_Sensitivity_TypeDef sensitivity);
+
+void ITC_SetSoftwarePriority(ITC_Irq_TypeDef irq, ITC_PriorityLevel_TypeDef priority);
+
+void FLASH_Unlock(FLASH_MemType_TypeDef memType);
+void FLASH_Lock(FLASH_MemType_TypeDef memType);
+uint8_t FLASH_ReadByte(uint32_t address);
+void FLASH_ProgramWord(uint32_t address, uint32_t data);
+FlagStatus FLASH_GetFlagStatus(FLASH_Flag_TypeDef flag);
+void FLASH_ProgramBlock(uint16_t blockNum, FLASH_MemType_TypeDef memType,
+                        FLASH_ProgramMode_TypeDef progMode, uint8_t *buffer);
+FLASH_Status_TypeDef FLASH_WaitForLastOperation(FLASH_MemType_TypeDef memType);
+
+void IWDG_WriteAccessCmd(IWDG_WriteAccess_TypeDef access);
+void IWDG_SetPrescaler(IWDG_Prescaler_TypeDef prescaler);
+void IWDG_SetReload(uint8_t reload);
+void IWDG_ReloadCounter(void);
+void IWDG_Enable(void);
+
+FlagStatus RST_GetFlagStatus(RST_Flag_TypeDef flag);
+void RST_ClearFlag(RST_Flag_TypeDef flag);
+
+void TIM1_DeInit(void);
+void TIM1_TimeBaseInit(uint16_t prescaler, TIM1_CounterMode_TypeDef mode,
+                       uint16_t period, uint8_t repetition);
+void TIM1_ARRPreloadConfig(FunctionalState state);
+void TIM1_ITConfig(TIM1_IT_TypeDef it, FunctionalState state);
+void TIM1_Cmd(FunctionalState state);
+uint16_t TIM1_GetCounter(void);
+void TIM1_ClearITPendingBit(TIM1_IT_TypeDef it);
+void TIM1_SelectOutputTrigger(TIM1_TRGOSource_TypeDef source);
+void TIM1_ICInit(TIM1_Channel_TypeDef channel, TIM1_ICPolarity_TypeDef polarity,
+                 TIM1_ICSelection_TypeDef selection, TIM1_ICPSC_TypeDef prescaler,
+                 uint8_t filter);
+uint16_t TIM1_GetCapture4(void);
+
+void TIM2_DeInit(void);
+void TIM2_TimeBaseInit(TIM2_Prescaler_TypeDef prescaler, uint16_t period);
+void TIM2_OC1Init(TIM2_OCMode_TypeDef mode, TIM2_OutputState_TypeDef state,
+                  uint16_t pulse, TIM2_OCPolarity_TypeDef polarity);
+void TIM2_OC2Init(TIM2_OCMode_TypeDef mode, TIM2_OutputState_TypeDef state,
+                  uint16_t pulse, TIM2_OCPolarity_TypeDef polarity);
+void TIM2_OC1PreloadConfig(FunctionalState state);
+void TIM2_OC2PreloadConfig(FunctionalState state);
+void TIM2_ARRPreloadConfig(FunctionalState state);
+void TIM2_Cmd(FunctionalState state);
+void TIM2_SetCompare1(uint16_t compare);
+void TIM2_SetCompare2(uint16_t compare);
+void TIM2_ITConfig(TIM2_IT_TypeDef it, FunctionalState state);
+void TIM2_ClearITPendingBit(TIM2_IT_TypeDef it);
+void TIM2_UpdateDisableConfig(FunctionalState state);
+void TIM2_PrescalerConfig(TIM2_Prescaler_TypeDef prescaler,
+                          TIM2_PSCReloadMode_TypeDef mode);
+void TIM2_SetAutoreload(uint16_t autoreload);
+
+void UART2_DeInit(void);
+void UART2_Init(uint32_t baud, UART2_WordLength_TypeDef wordLength,
+                UART2_StopBits_TypeDef stopBits, UART2_Parity_TypeDef parity,
+                UART2_SyncMode_TypeDef syncMode, UART2_Mode_TypeDef mode);
+void UART2_Cmd(FunctionalState state);
+void UART2_ITConfig(UART2_IT_TypeDef it, FunctionalState state);
+void UART2_ClearITPendingBit(UART2_IT_TypeDef it);
+void UART2_SendData8(uint8_t data);
+uint8_t UART2_ReceiveData8(void);
+
+void SPI_DeInit(void);
+void SPI_Init(SPI_FirstBit_TypeDef firstBit,
+              SPI_BaudRatePrescaler_TypeDef prescaler, SPI_Mode_TypeDef mode,
+              SPI_ClockPolarity_TypeDef polarity, SPI_ClockPhase_TypeDef phase,
+              SPI_DataDirection_TypeDef direction, SPI_NSS_TypeDef nss,
+              uint8_t crcPolynomial);
+void SPI_Cmd(FunctionalState state);
+void SPI_ITConfig(SPI_IT_TypeDef it, FunctionalState state);
+void SPI_SendData(uint8_t data);
+uint8_t SPI_ReceiveData(void);
+
+#endif
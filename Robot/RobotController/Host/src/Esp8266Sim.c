@@ -0,0 +1,356 @@
+/*******************************************************************************
+  * @file Esp8266Sim.c
+  * @brief Implements the UART side of the simulated ESP8266. Bytes sent by
+  *        the robot are split into command lines and the datagram payloads
+  *        announced by CIPSEND and prompted, the script matches them in 
+  *        order. Replies
+  *        are queued for the robot and delivered at the UART byte rate.
+  * @author David Sharpe
+  * @version V1.0.0
+  * @date 14-October-2026
+  *
+  * Host build using GCC
+  *****************************************************************************/
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Includes
+////////////////////////////////////////////////////////////////////////////////
+#include "Sim.h"
+#include "Hal.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Variables
+////////////////////////////////////////////////////////////////////////////////
+SimStats simStats;
+
+//Robot to module records
+static SimRecord records[SIM_RECORD_COUNT];
+static unsigned char recordHead = 0;
+static unsigned char recordCount = 0;
+static SimRecord current;
+static unsigned short dataRemaining = 0;
+static unsigned short sendLength = 0;
+static unsigned char lastRxByte = 0;
+
+//Module to robot bytes
+static unsigned char rxQueue[SIM_RX_QUEUE_SIZE];
+static unsigned short rxHead = 0;
+static unsigned short rxCount = 0;
+
+//Module baud rate, bytes are lost both ways while the robot differs
+static unsigned long moduleBaud = SIM_MODULE_BAUD;
+
+//Receive error for the next byte and the error flags of the last one
+static unsigned char lineError = 0;
+static unsigned char byteError = 0;
+
+
+/*******************************************************************************
+  * @brief Reset the simulated module
+  * @par Parameters: None
+  * @retval None
+  *****************************************************************************/
+void EspSim_Initialize(void)
+{
+    memset(&simStats, 0, sizeof(simStats));
+    recordHead = 0;
+    recordCount = 0;
+    current.length = 0;
+    dataRemaining = 0;
+    sendLength = 0;
+    lastRxByte = 0;
+    rxHead = 0;
+    rxCount = 0;
+    moduleBaud = SIM_MODULE_BAUD;
+    lineError = 0;
+    byteError = 0;
+}
+
+/*******************************************************************************
+  * @brief Queue the record being assembled for the script
+  * @par Parameters:
+  * type - SIM_RECORD_LINE or SIM_RECORD_DATA
+  * @retval None
+  *****************************************************************************/
+static void EspSim_PushRecord(unsigned char type)
+{
+    unsigned char index = (recordHead + recordCount) % SIM_RECORD_COUNT;
+
+    if(recordCount >= SIM_RECORD_COUNT)
+    {
+        fprintf(stderr, "sim: record queue overflow\n");
+        exit(2);
+    }
+
+    current.type = type;
+    records[index] = current;
+    recordCount++;
+    simStats.txRecords++;
+    current.length = 0;
+}
+
+/*******************************************************************************
+  * @brief Get the payload length announced by a CIPSEND command line
+  * @par Parameters:
+  * record - command line without the line ending
+  * @retval payload length, 0 if the line is not a CIPSEND with a length
+  *****************************************************************************/
+static unsigned short EspSim_GetSendLength(const SimRecord *record)
+{
+    char line[SIM_RECORD_SIZE + 1];
+    char *value = 0;
+
+    memcpy(line, record->data, record->length);
+    line[record->length] = 0;
+
+    if(strncmp(line, "AT+CIPSEND=", 11) != 0)
+    {
+        return 0;
+    }
+
+    //The length is the last field, after the link id if there is one
+    value = strrchr(line, ',');
+    value = value ? value + 1 : line + 11;
+
+    return (unsigned short)atoi(value);
+}
+
+/*******************************************************************************
+  * @brief Called for each byte the robot transmits
+  * @par Parameters:
+  * byte - transmitted byte
+  * @retval None
+  *****************************************************************************/
+void EspSim_Transmit(unsigned char byte)
+{
+    simStats.txBytes++;
+
+    if(!EspSim_IsBaudMatched())
+    {
+        return;
+    }
+
+    if(current.length >= SIM_RECORD_SIZE)
+    {
+        fprintf(stderr, "sim: line too long\n");
+        exit(2);
+    }
+
+    current.data[current.length++] = byte;
+
+    //Datagram payload, the module takes exactly the announced length
+    if(dataRemaining)
+    {
+        if(--dataRemaining == 0)
+        {
+            EspSim_PushRecord(SIM_RECORD_DATA);
+        }
+        return;
+    }
+
+    //Command line
+    if(current.length >= 2 && current.data[current.length - 2] == '\r' &&
+       byte == '\n')
+    {
+        current.length -= 2;
+        sendLength = EspSim_GetSendLength(&current);
+        EspSim_PushRecord(SIM_RECORD_LINE);
+    }
+}
+
+/*******************************************************************************
+  * @brief Get the next byte to deliver to the robot
+  * @par Parameters:
+  * byte - set to the byte
+  * @retval 1 if a byte was returned, 0 if nothing is waiting
+  *****************************************************************************/
+int EspSim_Receive(unsigned char *byte)
+{
+    //Garbled, the robot sees nothing it can use
+    if(!EspSim_IsBaudMatched())
+    {
+        rxHead = (rxHead + rxCount) % SIM_RX_QUEUE_SIZE;
+        rxCount = 0;
+    }
+
+    if(rxCount == 0)
+    {
+        return 0;
+    }
+
+    //An overrun loses the byte before the flagged one
+    byteError = lineError;
+    lineError = 0;
+
+    if((byteError & UART2_SR_OR) && rxCount > 1)
+    {
+        rxHead = (rxHead + 1) % SIM_RX_QUEUE_SIZE;
+        rxCount--;
+        simStats.rxBytes++;
+    }
+
+    *byte = rxQueue[rxHead];
+    rxHead = (rxHead + 1) % SIM_RX_QUEUE_SIZE;
+    rxCount--;
+    simStats.rxBytes++;
+
+    //The payload is taken once the prompt is out, a busy module ignores 
+    //the CIPSEND and sends no prompt
+    if(lastRxByte == '>' && *byte == ' ' && sendLength)
+    {
+        dataRemaining = sendLength;
+        sendLength = 0;
+    }
+
+    lastRxByte = *byte;
+
+    return 1;
+}
+
+/*******************************************************************************
+  * @brief Check if every reply has been delivered
+  * @par Parameters: None
+  * @retval 1 if nothing is waiting, 0 otherwise
+  *****************************************************************************/
+int EspSim_IsRxEmpty(void)
+{
+    return (rxCount == 0);
+}
+
+/*******************************************************************************
+  * @brief Queue bytes for the robot
+  * @par Parameters:
+  * data - bytes to send
+  * length - number of bytes
+  * @retval None
+  *****************************************************************************/
+void EspSim_Reply(const unsigned char *data, unsigned short length)
+{
+    unsigned short i = 0;
+
+    if(rxCount + length > SIM_RX_QUEUE_SIZE)
+    {
+        fprintf(stderr, "sim: reply queue overflow\n");
+        exit(2);
+    }
+
+    for(i = 0; i < length; i++)
+    {
+        rxQueue[(rxHead + rxCount) % SIM_RX_QUEUE_SIZE] = data[i];
+        rxCount++;
+    }
+}
+
+/*******************************************************************************
+  * @brief Queue a datagram for the robot behind its +IPD header
+  * @par Parameters:
+  * link - link id
+  * ip - sender address for the AT+CIPDINFO=1 header, 0 for none
+  * port - sender port, as the script gives it
+  * data - datagram
+  * length - datagram length in bytes
+  * @retval None
+  *****************************************************************************/
+void EspSim_Datagram(unsigned char link, const char *ip, unsigned long port,
+                     const unsigned char *data, unsigned short length)
+{
+    unsigned char header[48];
+    int size = 0;
+
+    if(ip)
+    {
+        size = snprintf((char *)header, sizeof(header), "+IPD,%u,%u,%s,%lu:",
+                        link, length, ip, port);
+    }
+    else
+    {
+        size = snprintf((char *)header, sizeof(header), "+IPD,%u,%u:", link,
+                        length);
+    }
+
+    EspSim_Reply(header, (unsigned short)size);
+    EspSim_Reply(data, length);
+}
+
+/*******************************************************************************
+  * @brief Set the module baud rate, as AT+UART_CUR does once it has replied
+  * @par Parameters:
+  * baud - baud rate
+  * @retval None
+  *****************************************************************************/
+void EspSim_SetBaud(unsigned long baud)
+{
+    moduleBaud = baud;
+}
+
+/*******************************************************************************
+  * @brief Set a receive error for the next byte delivered to the robot
+  * @par Parameters:
+  * flags - UART2_SR_OR, UART2_SR_NF or UART2_SR_FE
+  * @retval None
+  *****************************************************************************/
+void EspSim_SetLineError(unsigned char flags)
+{
+    lineError = flags;
+}
+
+/*******************************************************************************
+  * @brief Get the receive error flags of the byte last delivered
+  * @par Parameters: None
+  * @retval UART2_SR error flags, 0 if it arrived cleanly
+  *****************************************************************************/
+unsigned char EspSim_GetByteError(void)
+{
+    return byteError;
+}
+
+/*******************************************************************************
+  * @brief Check if the robot UART is close enough to the module baud rate 
+  *        for bytes to get through
+  * @par Parameters: None
+  * @retval 1 if matched, 0 otherwise
+  *****************************************************************************/
+int EspSim_IsBaudMatched(void)
+{
+    unsigned long baud = Hal_GetUartBaud();
+    unsigned long diff = (baud > moduleBaud) ? baud - moduleBaud : 
+                                               moduleBaud - baud;
+
+    return (diff * 100 <= moduleBaud * SIM_BAUD_TOLERANCE);
+}
+
+/*******************************************************************************
+  * @brief Take the oldest record sent by the robot
+  * @par Parameters:
+  * record - set to the record
+  * @retval 1 if a record was returned, 0 if nothing has been sent
+  *****************************************************************************/
+int EspSim_GetRecord(SimRecord *record)
+{
+    if(recordCount == 0)
+    {
+        return 0;
+    }
+
+    *record = records[recordHead];
+    recordHead = (recordHead + 1) % SIM_RECORD_COUNT;
+    recordCount--;
+
+    return 1;
+}
+
+/*******************************************************************************
+  * @brief Peripheral library hook for bytes written to the UART data register
+  * @par Parameters:
+  * byte - transmitted byte
+  * @retval None
+  *****************************************************************************/
+void Hal_UartTransmit(unsigned char byte)
+{
+    EspSim_Transmit(byte);
+}
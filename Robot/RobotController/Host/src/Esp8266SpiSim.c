@@ -0,0 +1,625 @@
+/*******************************************************************************
+  * @file Esp8266SpiSim.c
+  * @brief Implements the SPI side of the simulated ESP8266, a module running
+  *        the SPI link firmware as the README describes it, built in place
+  *        of Esp8266Sim.c with BOARD_ESP8266_SPI. The robot clocks each
+  *        transaction through it a byte at a time. The chunks it writes
+  *        are put back together into a send line and the datagram for the
+  *        script, its set up into set lines. Datagrams from the script are
+  *        cut into chunks for it to read, the status word and the ready
+  *        output tell it what is waiting.
+  * @author David Sharpe
+  * @version V1.0.0
+  * @date 14-October-2026
+  *
+  * Host build using GCC
+  *****************************************************************************/
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Includes
+////////////////////////////////////////////////////////////////////////////////
+#include "Sim.h"
+#include "Hal.h"
+#include "Esp8266.h"
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Definitions
+////////////////////////////////////////////////////////////////////////////////
+
+//Chunk and status word fields, as Esp8266Spi.c has them
+#define CHUNK_TYPE          0
+#define CHUNK_LINK          1
+#define CHUNK_LENGTH        2
+#define CHUNK_PAYLOAD       3
+#define CHUNK_CHECK         (ESP8266_SPI_CHUNK_SIZE - 1)
+
+#define STATUS_FLAGS        0
+#define STATUS_CREDIT       1
+#define STATUS_LINKS        2
+#define STATUS_SESSION      3
+
+#define SIM_SPI_SESSION     0x3C //Session of the one boot simulated
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Variables
+////////////////////////////////////////////////////////////////////////////////
+SimStats simStats;
+
+//Module to script records
+static SimRecord records[SIM_RECORD_COUNT];
+static unsigned char recordHead = 0;
+static unsigned char recordCount = 0;
+
+//Transaction in progress, its command, the bytes so far and what came in.
+//A status read sends the word as it was at the command byte.
+static unsigned char xferCommand = 0;
+static unsigned char xferCount = 0;
+static unsigned char xferData[2 + ESP8266_SPI_CHUNK_SIZE];
+static unsigned char xferStatus[ESP8266_SPI_STATUS_SIZE];
+
+//Module state. Before it has booted MISO floats high and writes are lost.
+//failed is set for a datagram on a link that is down until the next status
+//read.
+static unsigned char booted = 0;
+static unsigned char links = 0;
+static unsigned char failed = 0;
+
+//The last status word read, and the credit it gave less the chunks
+//written since. The ready output is high while the word differs from it or
+//the credit is more than the robot counts on.
+static unsigned char readStatus[ESP8266_SPI_STATUS_SIZE];
+static unsigned char readValid = 0;
+static unsigned char shownCredit = 0;
+
+//Datagram from the robot being put together, the chunks of it held take
+//the credit
+static SimRecord assembly;
+static unsigned char assemblyLink = 0;
+static unsigned char assemblyChunks = 0;
+
+//Chunks waiting for the robot to read
+static unsigned char rxChunks[SIM_SPI_QUEUE][ESP8266_SPI_CHUNK_SIZE];
+static unsigned char rxHead = 0;
+static unsigned char rxCount = 0;
+
+//Client peer from the set up and the sender of the latest datagram on the
+//client link that was not from it, for ESP8266_SPI_SET_FOLLOW
+static char peerIp[16];
+static unsigned long peerPort = 0;
+static char foreignIp[16];
+static unsigned long foreignPort = 0;
+
+
+/*******************************************************************************
+  * @brief Reset the simulated module, it boots SIM_SPI_BOOT ms after power up
+  * @par Parameters: None
+  * @retval None
+  *****************************************************************************/
+void EspSim_Initialize(void)
+{
+    memset(&simStats, 0, sizeof(simStats));
+    recordHead = 0;
+    recordCount = 0;
+    xferCount = 0;
+    booted = 0;
+    links = 0;
+    failed = 0;
+    readValid = 0;
+    shownCredit = 0;
+    assemblyChunks = 0;
+    rxHead = 0;
+    rxCount = 0;
+    peerIp[0] = 0;
+    peerPort = 0;
+    foreignIp[0] = 0;
+    foreignPort = 0;
+}
+
+/*******************************************************************************
+  * @brief Queue a record for the script
+  * @par Parameters:
+  * record - line or datagram
+  * @retval None
+  *****************************************************************************/
+static void EspSim_PushRecord(const SimRecord *record)
+{
+    if(recordCount >= SIM_RECORD_COUNT)
+    {
+        fprintf(stderr, "sim: record queue overflow\n");
+        exit(2);
+    }
+
+    records[(recordHead + recordCount) % SIM_RECORD_COUNT] = *record;
+    recordCount++;
+    simStats.txRecords++;
+}
+
+/*******************************************************************************
+  * @brief Queue a line for the script
+  * @par Parameters:
+  * format - printf format, then its arguments
+  * @retval None
+  *****************************************************************************/
+static void EspSim_PushLine(const char *format, ...)
+{
+    SimRecord record;
+    va_list args;
+    int length = 0;
+
+    va_start(args, format);
+    length = vsnprintf((char *)record.data, sizeof(record.data), format, args);
+    va_end(args);
+
+    record.type = SIM_RECORD_LINE;
+    record.length = (length < (int)sizeof(record.data)) ? (unsigned short)length :
+                                                          sizeof(record.data) - 1;
+    EspSim_PushRecord(&record);
+}
+
+/*******************************************************************************
+  * @brief Work out the check byte of a chunk
+  * @par Parameters:
+  * chunk - the chunk
+  * @retval complement of the sum of the bytes before the check
+  *****************************************************************************/
+static unsigned char EspSim_Check(const unsigned char *chunk)
+{
+    unsigned char sum = 0;
+    unsigned char i = 0;
+
+    for(i = 0; i < CHUNK_CHECK; i++)
+    {
+        sum += chunk[i];
+    }
+
+    return (unsigned char)~sum;
+}
+
+/*******************************************************************************
+  * @brief Get the chunks the module has room for
+  * @par Parameters: None
+  * @retval free credit
+  *****************************************************************************/
+static unsigned char EspSim_GetCredit(void)
+{
+    return SIM_SPI_CREDIT - assemblyChunks;
+}
+
+/*******************************************************************************
+  * @brief Build the status word
+  * @par Parameters:
+  * status - set to the ESP8266_SPI_STATUS_SIZE bytes
+  * @retval None
+  *****************************************************************************/
+static void EspSim_GetStatus(unsigned char *status)
+{
+    status[STATUS_FLAGS] = ESP8266_SPI_STATUS_MARK |
+                           (rxCount ? ESP8266_SPI_STATUS_DATA : 0) |
+                           (failed ? ESP8266_SPI_STATUS_FAIL : 0);
+    status[STATUS_CREDIT] = EspSim_GetCredit();
+    status[STATUS_LINKS] = links;
+    status[STATUS_SESSION] = SIM_SPI_SESSION;
+}
+
+/*******************************************************************************
+  * @brief Act on a set up chunk from the robot, each is a set line for the
+  *        script. The client link is up once it is set.
+  * @par Parameters:
+  * payload - ESP8266_SPI_SET_ value then its fields
+  * length - payload bytes
+  * @retval None
+  *****************************************************************************/
+static void EspSim_TakeSetup(const unsigned char *payload, unsigned char length)
+{
+    unsigned short port = 0;
+    int text = 0;
+
+    switch(payload[0])
+    {
+        case ESP8266_SPI_SET_AP_NAME:
+            EspSim_PushLine("set ap-name %.*s", length - 1, &payload[1]);
+            break;
+
+        case ESP8266_SPI_SET_CLIENT:
+            port = payload[2] | (payload[3] << 8);
+            text = (length - 4 < (int)sizeof(peerIp)) ? length - 4 :
+                                                        (int)sizeof(peerIp) - 1;
+            memcpy(peerIp, &payload[4], text);
+            peerIp[text] = 0;
+            peerPort = port;
+            links |= 1 << ESP8266_PRIMARY_LINK;
+            EspSim_PushLine("set client %s %s:%u",
+                            (payload[1] == ESP8266_SPI_TCP) ? "tcp" : "udp",
+                            peerIp, port);
+            break;
+
+        case ESP8266_SPI_SET_SERVER:
+            EspSim_PushLine("set server %u", payload[1] | (payload[2] << 8));
+            break;
+
+        case ESP8266_SPI_SET_PROFILE:
+            EspSim_PushLine("set profile %u %u", payload[1], payload[2]);
+            break;
+
+        case ESP8266_SPI_SET_FOLLOW:
+            //The client link moves to the sender found last
+            if(foreignIp[0])
+            {
+                strcpy(peerIp, foreignIp);
+                peerPort = foreignPort;
+            }
+            EspSim_PushLine("set follow %s:%lu", peerIp, peerPort);
+            break;
+
+        default:
+            EspSim_PushLine("set unknown %02X", payload[0]);
+            break;
+    };
+}
+
+/*******************************************************************************
+  * @brief Take a chunk the robot has written. A datagram goes on once its
+  *        last chunk is in, as a send line with the link and length then
+  *        the datagram. One for a link that is down fails instead.
+  * @par Parameters:
+  * chunk - the ESP8266_SPI_CHUNK_SIZE bytes
+  * @retval None
+  *****************************************************************************/
+static void EspSim_TakeChunk(const unsigned char *chunk)
+{
+    unsigned char type = chunk[CHUNK_TYPE];
+    unsigned char link = chunk[CHUNK_LINK];
+    unsigned char length = chunk[CHUNK_LENGTH];
+
+    if(shownCredit)
+    {
+        shownCredit--;
+    }
+
+    //Lines the script does not expect, so a bad write fails the trace
+    if(chunk[CHUNK_CHECK] != EspSim_Check(chunk) || length == 0 ||
+       length > ESP8266_SPI_PAYLOAD_SIZE)
+    {
+        EspSim_PushLine("bad chunk");
+        return;
+    }
+
+    if(EspSim_GetCredit() == 0)
+    {
+        EspSim_PushLine("no credit");
+        return;
+    }
+
+    if((type & ESP8266_SPI_TYPE_MASK) == ESP8266_SPI_CONFIG)
+    {
+        EspSim_TakeSetup(&chunk[CHUNK_PAYLOAD], length);
+        return;
+    }
+
+    if((type & ESP8266_SPI_TYPE_MASK) != ESP8266_SPI_DATAGRAM)
+    {
+        EspSim_PushLine("bad chunk type %02X", type);
+        return;
+    }
+
+    if(!(type & ESP8266_SPI_CONTINUED))
+    {
+        assembly.length = 0;
+        assemblyLink = link;
+    }
+    else if(assemblyChunks == 0 || link != assemblyLink)
+    {
+        EspSim_PushLine("chunk with no start");
+        return;
+    }
+
+    if(assembly.length + length > SIM_RECORD_SIZE)
+    {
+        fprintf(stderr, "sim: datagram too long\n");
+        exit(2);
+    }
+
+    memcpy(&assembly.data[assembly.length], &chunk[CHUNK_PAYLOAD], length);
+    assembly.length += length;
+    assemblyChunks++;
+
+    if(type & ESP8266_SPI_MORE)
+    {
+        return;
+    }
+
+    assemblyChunks = 0;
+
+    if(link != ESP8266_SPI_OBSERVERS &&
+       (link >= ESP8266_MAX_LINKS || !(links & (1 << link))))
+    {
+        failed = 1;
+        return;
+    }
+
+    EspSim_PushLine("send %u,%u", link, assembly.length);
+    assembly.type = SIM_RECORD_DATA;
+    EspSim_PushRecord(&assembly);
+    simStats.txBytes += assembly.length;
+}
+
+/*******************************************************************************
+  * @brief Called for each byte the robot clocks through
+  * @par Parameters:
+  * byte - byte on MOSI
+  * first - 1 if chip select has fallen since the last byte
+  * @retval byte for MISO
+  *****************************************************************************/
+unsigned char EspSim_Exchange(unsigned char byte, unsigned char first)
+{
+    unsigned char index = 0;
+    unsigned char reply = 0;
+
+    if(first)
+    {
+        xferCount = 0;
+    }
+
+    if(!booted)
+    {
+        return 0xFF;
+    }
+
+    index = xferCount;
+
+    if(index == 0)
+    {
+        xferCommand = byte;
+
+        if(byte == ESP8266_SPI_READ_STATUS)
+        {
+            EspSim_GetStatus(xferStatus);
+        }
+    }
+    else if(xferCommand == ESP8266_SPI_READ_STATUS &&
+            index <= ESP8266_SPI_STATUS_SIZE)
+    {
+        reply = xferStatus[index - 1];
+    }
+    else if(xferCommand == ESP8266_SPI_READ_DATA && index >= 2 &&
+            index < sizeof(xferData) && rxCount)
+    {
+        reply = rxChunks[rxHead][index - 2];
+    }
+
+    if(index < sizeof(xferData))
+    {
+        xferData[index] = byte;
+        xferCount++;
+    }
+
+    return reply;
+}
+
+/*******************************************************************************
+  * @brief Called as chip select rises at the end of a transaction. Only a
+  *        transaction clocked through in full takes effect.
+  * @par Parameters: None
+  * @retval None
+  *****************************************************************************/
+void EspSim_EndTransfer(void)
+{
+    unsigned char count = xferCount;
+
+    xferCount = 0;
+
+    if(!booted || count == 0)
+    {
+        return;
+    }
+
+    switch(xferCommand)
+    {
+        case ESP8266_SPI_READ_STATUS:
+            if(count >= 1 + ESP8266_SPI_STATUS_SIZE)
+            {
+                memcpy(readStatus, xferStatus, sizeof(readStatus));
+                readValid = 1;
+                shownCredit = xferStatus[STATUS_CREDIT];
+                failed = 0;
+            }
+            break;
+
+        case ESP8266_SPI_READ_DATA:
+            if(count >= sizeof(xferData) && rxCount)
+            {
+                simStats.rxBytes += rxChunks[rxHead][CHUNK_LENGTH];
+                rxHead = (rxHead + 1) % SIM_SPI_QUEUE;
+                rxCount--;
+            }
+            break;
+
+        case ESP8266_SPI_WRITE_DATA:
+            if(count >= sizeof(xferData))
+            {
+                EspSim_TakeChunk(&xferData[2]);
+            }
+            break;
+
+        default:
+            EspSim_PushLine("bad command %02X", xferCommand);
+            break;
+    };
+}
+
+/*******************************************************************************
+  * @brief Advance the module to the simulated time and get its ready output
+  * @par Parameters:
+  * now - simulated time in ms
+  * @retval 1 if ready is high, the status word has news for the robot
+  *****************************************************************************/
+int EspSim_UpdateReady(unsigned long now)
+{
+    unsigned char status[ESP8266_SPI_STATUS_SIZE];
+
+    if(!booted)
+    {
+        if(now < SIM_SPI_BOOT)
+        {
+            return 0;
+        }
+        booted = 1;
+    }
+
+    EspSim_GetStatus(status);
+
+    return !readValid || status[STATUS_FLAGS] != readStatus[STATUS_FLAGS] ||
+           status[STATUS_LINKS] != readStatus[STATUS_LINKS] ||
+           status[STATUS_SESSION] != readStatus[STATUS_SESSION] ||
+           status[STATUS_CREDIT] > shownCredit;
+}
+
+/*******************************************************************************
+  * @brief Queue a datagram for the robot, cut into chunks. A datagram on a
+  *        link that is down connects it first, as an observer does. One on
+  *        the client link from someone other than its peer is marked
+  *        ESP8266_SPI_FOREIGN.
+  * @par Parameters:
+  * link - link id
+  * ip - sender address, 0 for the link's peer
+  * port - sender port
+  * data - datagram
+  * length - datagram length in bytes
+  * @retval None
+  *****************************************************************************/
+void EspSim_Datagram(unsigned char link, const char *ip, unsigned long port,
+                     const unsigned char *data, unsigned short length)
+{
+    unsigned char type = ESP8266_SPI_DATAGRAM;
+    unsigned char *chunk = 0;
+    unsigned short offset = 0;
+    unsigned char size = 0;
+
+    if(link < ESP8266_MAX_LINKS)
+    {
+        links |= 1 << link;
+    }
+
+    if(ip && link == ESP8266_PRIMARY_LINK &&
+       (strcmp(ip, peerIp) != 0 || port != peerPort))
+    {
+        snprintf(foreignIp, sizeof(foreignIp), "%s", ip);
+        foreignPort = port;
+        type |= ESP8266_SPI_FOREIGN;
+    }
+
+    for(offset = 0; offset < length; offset += size)
+    {
+        if(rxCount >= SIM_SPI_QUEUE)
+        {
+            fprintf(stderr, "sim: chunk queue overflow\n");
+            exit(2);
+        }
+
+        size = (length - offset > ESP8266_SPI_PAYLOAD_SIZE) ?
+               ESP8266_SPI_PAYLOAD_SIZE : (unsigned char)(length - offset);
+        chunk = rxChunks[(rxHead + rxCount) % SIM_SPI_QUEUE];
+        memset(chunk, 0, ESP8266_SPI_CHUNK_SIZE);
+        chunk[CHUNK_TYPE] = type | (offset ? ESP8266_SPI_CONTINUED : 0) |
+                            ((offset + size < length) ? ESP8266_SPI_MORE : 0);
+        chunk[CHUNK_LINK] = link;
+        chunk[CHUNK_LENGTH] = size;
+        memcpy(&chunk[CHUNK_PAYLOAD], &data[offset], size);
+        chunk[CHUNK_CHECK] = EspSim_Check(chunk);
+        rxCount++;
+    }
+}
+
+/*******************************************************************************
+  * @brief Check if every chunk for the robot has been read
+  * @par Parameters: None
+  * @retval 1 if nothing is waiting, 0 otherwise
+  *****************************************************************************/
+int EspSim_IsRxEmpty(void)
+{
+    return (rxCount == 0);
+}
+
+/*******************************************************************************
+  * @brief AT reply, the SPI link has none, a trace with one fails
+  * @par Parameters:
+  * data - bytes to send
+  * length - number of bytes
+  * @retval None
+  *****************************************************************************/
+void EspSim_Reply(const unsigned char *data, unsigned short length)
+{
+    (void)data;
+    (void)length;
+
+    fprintf(stderr, "sim: no AT replies on the SPI link\n");
+    exit(2);
+}
+
+/*******************************************************************************
+  * @brief Module baud rate, the SPI link has none, a trace with one fails
+  * @par Parameters:
+  * baud - baud rate
+  * @retval None
+  *****************************************************************************/
+void EspSim_SetBaud(unsigned long baud)
+{
+    (void)baud;
+
+    fprintf(stderr, "sim: no baud rate on the SPI link\n");
+    exit(2);
+}
+
+/*******************************************************************************
+  * @brief UART receive error, the SPI link has none, a trace with one fails
+  * @par Parameters:
+  * flags - UART2_SR_OR, UART2_SR_NF or UART2_SR_FE
+  * @retval None
+  *****************************************************************************/
+void EspSim_SetLineError(unsigned char flags)
+{
+    (void)flags;
+
+    fprintf(stderr, "sim: no UART errors on the SPI link\n");
+    exit(2);
+}
+
+/*******************************************************************************
+  * @brief Take the oldest record sent by the robot
+  * @par Parameters:
+  * record - set to the record
+  * @retval 1 if a record was returned, 0 if nothing has been sent
+  *****************************************************************************/
+int EspSim_GetRecord(SimRecord *record)
+{
+    if(recordCount == 0)
+    {
+        return 0;
+    }
+
+    *record = records[recordHead];
+    recordHead = (recordHead + 1) % SIM_RECORD_COUNT;
+    recordCount--;
+
+    return 1;
+}
+
+/*******************************************************************************
+  * @brief Peripheral library hook for bytes written to the UART data
+  *        register. The UART is not wired to the module on the SPI link.
+  * @par Parameters:
+  * byte - transmitted byte
+  * @retval None
+  *****************************************************************************/
+void Hal_UartTransmit(unsigned char byte)
+{
+    fprintf(stderr, "sim: UART byte %02X on the SPI link\n", byte);
+    exit(2);
+}
@@ -0,0 +1,162 @@
+/*******************************************************************************
+  * @file Replay.c
+  * @brief Implements the receive corpus replay. The replies of a corpus
+  *        script, captured module output, are fed straight into the
+  *        receive parser as fast as it takes them, with no UART, interrupt
+  *        or main loop in between. Each packet the parser publishes has its
+  *        frame checked and is returned to the pool at once, so the pool
+  *        never fills and only the parser decides what is lost.
+  *
+  *        The counts must match the expect-rx steps of the corpus on every
+  *        pass and the parser must end between lines. The same corpus
+  *        included in a trace plays it at the UART byte rate through the
+  *        interrupt and the firmware main loop instead. The SPI link has
+  *        no receive parser, the replay is only built for the AT firmware.
+  * @author David Sharpe
+  * @version V1.0.0
+  * @date 14-October-2026
+  *
+  * Host build using GCC
+  *****************************************************************************/
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Includes
+////////////////////////////////////////////////////////////////////////////////
+#include "Sim.h"
+#include "Hal.h"
+#include "Esp8266.h"
+#include "Protocol.h"
+#include <stdio.h>
+
+#if !ESP8266_SPI_LINK
+
+////////////////////////////////////////////////////////////////////////////////
+// Variables
+////////////////////////////////////////////////////////////////////////////////
+static unsigned char corpus[SIM_REPLAY_SIZE];
+
+//Frames that failed their check in the current pass
+static unsigned short replayRejected = 0;
+
+
+/*******************************************************************************
+  * @brief Frame handler, the commands of a replayed frame are not run
+  * @par Parameters:
+  * type - command type
+  * value - command value
+  * length - value length
+  * @retval None
+  *****************************************************************************/
+static void Replay_Command(unsigned char type, const unsigned char *value,
+                           unsigned char length)
+{
+    (void)type;
+    (void)value;
+    (void)length;
+}
+
+/*******************************************************************************
+  * @brief Check and release every packet the parser has published
+  * @par Parameters: None
+  * @retval None
+  *****************************************************************************/
+static void Replay_Drain(void)
+{
+    const unsigned char *packet = 0;
+    unsigned char length = 0;
+
+    while(length = Esp8266_AcquirePacket(&packet))
+    {
+        //Sequence numbers repeat from pass to pass, only the frame is checked
+        if(Protocol_ParseBulkFrame(packet, length, Replay_Command) != PROTO_OK)
+        {
+            replayRejected++;
+        }
+
+        Esp8266_ReleasePacket();
+    }
+}
+
+/*******************************************************************************
+  * @brief Replay a corpus SIM_REPLAY_PASSES times and print the parse rate
+  * @par Parameters:
+  * path - corpus script
+  * @retval 1 if every pass matched the corpus, 0 otherwise
+  *****************************************************************************/
+int Replay_Run(const char *path)
+{
+    unsigned long length = 0;
+    unsigned long i = 0;
+    unsigned short pass = 0;
+    unsigned short packets = 0;
+    unsigned short lost = 0;
+    long expected[3];
+    long long start = 0;
+    long long elapsed = 0;
+
+    if(!Script_Load(path))
+    {
+        return 0;
+    }
+
+    length = Script_GetReplies(corpus, sizeof(corpus));
+
+    if(length == 0 || !Script_GetExpectRx(expected))
+    {
+        fprintf(stderr, "%s: no replies or no expect-rx\n", path);
+        return 0;
+    }
+
+    for(pass = 0; pass < SIM_REPLAY_PASSES; pass++)
+    {
+        packets = Esp8266_GetRxPacketCount();
+        lost = Esp8266_GetRxDropCount() + Esp8266_GetRxOversizeCount();
+        replayRejected = 0;
+
+        start = Hal_GetNanos();
+
+        for(i = 0; i < length; i++)
+        {
+            Esp8266_ProcessRxByte(corpus[i]);
+            Replay_Drain();
+        }
+
+        elapsed += Hal_GetNanos() - start;
+
+        packets = Esp8266_GetRxPacketCount() - packets;
+        lost = Esp8266_GetRxDropCount() + Esp8266_GetRxOversizeCount() - lost;
+
+        if(packets != expected[0] || lost != expected[1] ||
+           replayRejected != expected[2] || !Esp8266_IsRxIdle())
+        {
+            fprintf(stderr, "%s: FAIL pass %u: rx %u %u %u, expected %ld %ld "
+                    "%ld%s\n", path, pass, packets, lost, replayRejected,
+                    expected[0], expected[1], expected[2],
+                    Esp8266_IsRxIdle() ? "" : ", parser left mid-line");
+            return 0;
+        }
+    }
+
+    fprintf(stderr, "PASS %s: %lu bytes, rx %u %u %u, %.1f ns/byte\n", path,
+            length, packets, lost, replayRejected,
+            elapsed / ((double)length * SIM_REPLAY_PASSES));
+
+    return 1;
+}
+
+#else
+
+/*******************************************************************************
+  * @brief Replay a corpus, the SPI link has no receive parser to feed
+  * @par Parameters:
+  * path - corpus script
+  * @retval 0
+  *****************************************************************************/
+int Replay_Run(const char *path)
+{
+    fprintf(stderr, "%s: no receive parser on the SPI link\n", path);
+    return 0;
+}
+
+#endif
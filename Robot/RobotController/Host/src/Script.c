@@ -0,0 +1,952 @@
+/*******************************************************************************
+  * @file Script.c
+  * @brief Implements the script engine that plays the part of the ESP8266
+  *        and the outside world. A script is a captured AT exchange, one step
+  *        per line:
+  *
+  *        expect <line>          next line sent by the robot, a trailing *
+  *                               matches any remainder
+  *        expect-data <hex>      next CIPSEND payload, .. matches any byte
+  *        reply <text>           bytes for the robot, \r \n \\ \xNN escapes
+  *        ipd <hex>              datagram for the robot on link 1
+  *        ipd-link <link> <hex>  datagram for the robot on another link
+  *        ipd-from <ip> <port> <hex>
+  *                               datagram for the robot on link 1 with the
+  *                               sender in the header, as AT+CIPDINFO=1
+  *        wait <ms>              let time pass
+  *        baud <rate>            switch the module baud rate once the 
+  *                               replies before it are out
+  *        line-error <error>     receive error on the next byte for the
+  *                               robot: overrun (the byte before it is 
+  *                               lost), noise or framing
+  *        expect-pwm <l> <r>     signed PWM compare values, negative is
+  *                               backward
+  *        expect-wheel <l> <r> <tolerance>
+  *                               simulated wheel speeds in edges/s
+  *        expect-pose <x> <y> <degrees> <tolerance>
+  *                               odometry pose in mm and degrees, within
+  *                               the tolerance in mm and degrees
+  *        expect-eeprom <offset> <hex>
+  *                               data EEPROM contents, .. matches any byte
+  *        expect-flash <address> <hex>
+  *                               program memory contents the same way
+  *        expect-rx <packets> <lost> <rejected>
+  *                               datagrams received, lost to a full pool or
+  *                               their size and frames rejected since the
+  *                               last expect-rx
+  *        expect-cpu <divider>   CPU clock divider, 1 at full speed
+  *        touch [ms] [key]       press a touch key, held for the time
+  *                               given, one acquisition if none. Key 0 is
+  *                               the one on PC1, the default.
+  *        slide <position> [ms]  touch the slider at a position, held the
+  *                               same way. One key or the slider is 
+  *                               touched at a time.
+  *        wheel-gain <l> <r>     full duty speed of each wheel in percent
+  *                               of SIM_WHEEL_MAX, mismatched motors
+  *        obstacle <mm>          obstacle ahead of the range sensor, 0 for
+  *                               none
+  *        overcurrent <0|1>      motor current sense comparator, 1 trips
+  *        timeout <ms>           time allowed for each following expect
+  *        reset-cause <cause>    the run starts from a reset by iwdg, wwdg,
+  *                               illop, swim or emc instead of a power up,
+  *                               wherever it is in the script
+  *        end                    pass
+  *        include <file>         steps of another script, relative to
+  *                               this one
+  *
+  *        Blank lines and lines starting with # are ignored.
+  * @author David Sharpe
+  * @version V1.0.0
+  * @date 14-October-2026
+  *
+  * Host build using GCC
+  *****************************************************************************/
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Includes
+////////////////////////////////////////////////////////////////////////////////
+#include "Sim.h"
+#include "Hal.h"
+#include "Esp8266.h"
+#include "Odometry.h"
+#include "Protocol.h"
+#include "TouchPanel.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Definitions
+////////////////////////////////////////////////////////////////////////////////
+#define SCRIPT_MAX_STEPS        1024
+#define SCRIPT_MAX_FILES        16
+#define SCRIPT_TIMEOUT_DEFAULT  2000 //ms
+#define SCRIPT_ANY_BYTE         0x100
+
+enum ScriptOp
+{
+    SCRIPT_EXPECT,
+    SCRIPT_EXPECT_DATA,
+    SCRIPT_REPLY,
+    SCRIPT_IPD,
+    SCRIPT_WAIT,
+    SCRIPT_BAUD,
+    SCRIPT_LINE_ERROR,
+    SCRIPT_EXPECT_PWM,
+    SCRIPT_EXPECT_WHEEL,
+    SCRIPT_EXPECT_POSE,
+    SCRIPT_EXPECT_EEPROM,
+    SCRIPT_EXPECT_FLASH,
+    SCRIPT_EXPECT_RX,
+    SCRIPT_EXPECT_CPU,
+    SCRIPT_TOUCH,
+    SCRIPT_SLIDE,
+    SCRIPT_WHEEL_GAIN,
+    SCRIPT_OBSTACLE,
+    SCRIPT_OVERCURRENT,
+    SCRIPT_TIMEOUT,
+    SCRIPT_END
+};
+
+typedef struct
+{
+    unsigned char op;
+    unsigned char file;
+    unsigned short line;
+    unsigned short length;
+    unsigned short data[SIM_RECORD_SIZE]; //Bytes or SCRIPT_ANY_BYTE
+    unsigned char prefix;                 //expect matches a prefix
+    char sender[16];                      //ipd-from address, port in args[1]
+    long args[4];
+} ScriptStep;
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Variables
+////////////////////////////////////////////////////////////////////////////////
+static ScriptStep steps[SCRIPT_MAX_STEPS];
+static unsigned short stepCount = 0;
+static unsigned short stepIndex = 0;
+static unsigned long stepStart = 0;
+static unsigned char stepStarted = 0;
+static unsigned long timeout = SCRIPT_TIMEOUT_DEFAULT;
+static char *scriptFiles[SCRIPT_MAX_FILES];
+static unsigned char fileCount = 0;
+
+//Receive counters at the last expect-rx
+static unsigned short rxPackets = 0;
+static unsigned short rxLost = 0;
+static unsigned short rxRejected = 0;
+
+
+/*******************************************************************************
+  * @brief Parse the escaped text of a reply or expect step
+  * @par Parameters:
+  * text - escaped text
+  * step - step to fill
+  * @retval 1 if parsed, 0 on a bad escape
+  *****************************************************************************/
+static int Script_ParseText(const char *text, ScriptStep *step)
+{
+    unsigned int value = 0;
+
+    step->length = 0;
+
+    while(*text && step->length < SIM_RECORD_SIZE)
+    {
+        if(*text != '\\')
+        {
+            step->data[step->length++] = (unsigned char)*text++;
+            continue;
+        }
+
+        text++;
+
+        switch(*text)
+        {
+            case 'r':
+                step->data[step->length++] = '\r';
+                text++;
+                break;
+
+            case 'n':
+                step->data[step->length++] = '\n';
+                text++;
+                break;
+
+            case '\\':
+                step->data[step->length++] = '\\';
+                text++;
+                break;
+
+            case 'x':
+                if(sscanf(text + 1, "%2x", &value) != 1)
+                {
+                    return 0;
+                }
+                step->data[step->length++] = (unsigned char)value;
+                text += 3;
+                break;
+
+            default:
+                return 0;
+        };
+    }
+
+    return 1;
+}
+
+/*******************************************************************************
+  * @brief Parse space separated hex bytes, .. is a wildcard
+  * @par Parameters:
+  * text - hex text
+  * step - step to fill
+  * @retval 1 if parsed, 0 on a bad byte
+  *****************************************************************************/
+static int Script_ParseHex(const char *text, ScriptStep *step)
+{
+    unsigned int value = 0;
+    int used = 0;
+
+    step->length = 0;
+
+    while(step->length < SIM_RECORD_SIZE)
+    {
+        while(*text == ' ' || *text == '\t')
+        {
+            text++;
+        }
+
+        if(*text == 0)
+        {
+            break;
+        }
+
+        if(text[0] == '.' && text[1] == '.')
+        {
+            step->data[step->length++] = SCRIPT_ANY_BYTE;
+            text += 2;
+        }
+        else if(sscanf(text, "%2x%n", &value, &used) == 1)
+        {
+            step->data[step->length++] = (unsigned char)value;
+            text += used;
+        }
+        else
+        {
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
+/*******************************************************************************
+  * @brief Append the steps of a script file
+  * @par Parameters:
+  * path - script file
+  * @retval 1 if loaded, 0 on an error
+  *****************************************************************************/
+static int Script_LoadFile(const char *path)
+{
+    char text[1024];
+    char word[32];
+    char include[1024];
+    unsigned short line = 0;
+    unsigned char index = fileCount;
+    FILE *file = 0;
+    ScriptStep *step = 0;
+    char *rest = 0;
+    char *slash = 0;
+    int consumed = 0;
+    int ok = 0;
+
+    if(fileCount >= SCRIPT_MAX_FILES)
+    {
+        fprintf(stderr, "%s: too many includes\n", path);
+        return 0;
+    }
+
+    file = fopen(path, "r");
+
+    if(!file)
+    {
+        perror(path);
+        return 0;
+    }
+
+    scriptFiles[fileCount++] = strdup(path);
+
+    while(fgets(text, sizeof(text), file))
+    {
+        line++;
+        text[strcspn(text, "\r\n")] = 0;
+
+        if(sscanf(text, "%31s", word) != 1 || word[0] == '#')
+        {
+            continue;
+        }
+
+        if(stepCount >= SCRIPT_MAX_STEPS)
+        {
+            fprintf(stderr, "%s:%u: too many steps\n", path, line);
+            fclose(file);
+            return 0;
+        }
+
+        step = &steps[stepCount];
+        memset(step, 0, sizeof(*step));
+        step->file = index;
+        step->line = line;
+
+        //The argument text starts after one separating space
+        rest = strstr(text, word) + strlen(word);
+        if(*rest == ' ')
+        {
+            rest++;
+        }
+
+        ok = 1;
+
+        if(strcmp(word, "include") == 0)
+        {
+            //Path is relative to the including script
+            slash = strrchr(path, '/');
+            snprintf(include, sizeof(include), "%.*s%s",
+                     slash ? (int)(slash - path + 1) : 0, path, rest);
+
+            if(!Script_LoadFile(include))
+            {
+                fprintf(stderr, "%s:%u: included from here\n", path, line);
+                fclose(file);
+                return 0;
+            }
+            continue;
+        }
+        else if(strcmp(word, "reset-cause") == 0)
+        {
+            //Taken as the script loads, the firmware reads it at start up
+            hal.rstFlags = (strcmp(rest, "iwdg") == 0) ? RST_FLAG_IWDGF :
+                           (strcmp(rest, "wwdg") == 0) ? RST_FLAG_WWDGF :
+                           (strcmp(rest, "illop") == 0) ? RST_FLAG_ILLOPF :
+                           (strcmp(rest, "swim") == 0) ? RST_FLAG_SWIMF :
+                           (strcmp(rest, "emc") == 0) ? RST_FLAG_EMCF : 0;
+
+            if(!hal.rstFlags)
+            {
+                fprintf(stderr, "%s:%u: bad reset cause\n", path, line);
+                fclose(file);
+                return 0;
+            }
+            continue;
+        }
+        else if(strcmp(word, "expect") == 0)
+        {
+            step->op = SCRIPT_EXPECT;
+            ok = Script_ParseText(rest, step);
+
+            if(step->length > 0 && step->data[step->length - 1] == '*')
+            {
+                step->prefix = 1;
+                step->length--;
+            }
+        }
+        else if(strcmp(word, "expect-data") == 0)
+        {
+            step->op = SCRIPT_EXPECT_DATA;
+            ok = Script_ParseHex(rest, step);
+        }
+        else if(strcmp(word, "reply") == 0)
+        {
+            step->op = SCRIPT_REPLY;
+            ok = Script_ParseText(rest, step);
+        }
+        else if(strcmp(word, "ipd") == 0)
+        {
+            step->op = SCRIPT_IPD;
+            step->args[0] = 1;
+            ok = Script_ParseHex(rest, step) && step->length > 0;
+        }
+        else if(strcmp(word, "ipd-link") == 0)
+        {
+            step->op = SCRIPT_IPD;
+            ok = sscanf(rest, "%ld %n", &step->args[0], &consumed) == 1 &&
+                 step->args[0] >= 0 && step->args[0] <= 4 &&
+                 Script_ParseHex(rest + consumed, step) && step->length > 0;
+        }
+        else if(strcmp(word, "ipd-from") == 0)
+        {
+            step->op = SCRIPT_IPD;
+            step->args[0] = 1;
+            ok = sscanf(rest, "%15s %ld %n", step->sender, &step->args[1], 
+                        &consumed) == 2 &&
+                 Script_ParseHex(rest + consumed, step) && step->length > 0;
+        }
+        else if(strcmp(word, "wait") == 0)
+        {
+            step->op = SCRIPT_WAIT;
+            ok = sscanf(rest, "%ld", &step->args[0]) == 1;
+        }
+        else if(strcmp(word, "baud") == 0)
+        {
+            step->op = SCRIPT_BAUD;
+            ok = sscanf(rest, "%ld", &step->args[0]) == 1 && step->args[0] > 0;
+        }
+        else if(strcmp(word, "line-error") == 0)
+        {
+            step->op = SCRIPT_LINE_ERROR;
+            step->args[0] = (strcmp(rest, "overrun") == 0) ? UART2_SR_OR :
+                            (strcmp(rest, "noise") == 0) ? UART2_SR_NF :
+                            (strcmp(rest, "framing") == 0) ? UART2_SR_FE : 0;
+            ok = step->args[0] != 0;
+        }
+        else if(strcmp(word, "expect-pwm") == 0)
+        {
+            step->op = SCRIPT_EXPECT_PWM;
+            ok = sscanf(rest, "%ld %ld", &step->args[0], &step->args[1]) == 2;
+        }
+        else if(strcmp(word, "expect-wheel") == 0)
+        {
+            step->op = SCRIPT_EXPECT_WHEEL;
+            ok = sscanf(rest, "%ld %ld %ld", &step->args[0], &step->args[1],
+                        &step->args[2]) == 3;
+        }
+        else if(strcmp(word, "expect-pose") == 0)
+        {
+            step->op = SCRIPT_EXPECT_POSE;
+            ok = sscanf(rest, "%ld %ld %ld %ld", &step->args[0], &step->args[1],
+                        &step->args[2], &step->args[3]) == 4;
+        }
+        else if(strcmp(word, "expect-eeprom") == 0)
+        {
+            step->op = SCRIPT_EXPECT_EEPROM;
+            ok = sscanf(rest, "%lx %n", (unsigned long *)&step->args[0],
+                        &consumed) == 1 &&
+                 Script_ParseHex(rest + consumed, step) &&
+                 step->args[0] + step->length <= HAL_EEPROM_SIZE;
+        }
+        else if(strcmp(word, "expect-flash") == 0)
+        {
+            step->op = SCRIPT_EXPECT_FLASH;
+            ok = sscanf(rest, "%lx %n", (unsigned long *)&step->args[0],
+                        &consumed) == 1 &&
+                 Script_ParseHex(rest + consumed, step) &&
+                 step->args[0] >= FLASH_PROG_START_PHYSICAL_ADDRESS &&
+                 step->args[0] + step->length <= FLASH_PROG_START_PHYSICAL_ADDRESS +
+                                                 HAL_FLASH_SIZE;
+        }
+        else if(strcmp(word, "expect-rx") == 0)
+        {
+            step->op = SCRIPT_EXPECT_RX;
+            ok = sscanf(rest, "%ld %ld %ld", &step->args[0], &step->args[1],
+                        &step->args[2]) == 3;
+        }
+        else if(strcmp(word, "expect-cpu") == 0)
+        {
+            step->op = SCRIPT_EXPECT_CPU;
+            ok = sscanf(rest, "%ld", &step->args[0]) == 1;
+        }
+        else if(strcmp(word, "touch") == 0)
+        {
+            step->op = SCRIPT_TOUCH;
+            step->args[0] = 0;
+            step->args[1] = 0;
+            sscanf(rest, "%ld %ld", &step->args[0], &step->args[1]);
+            ok = step->args[0] >= 0 && step->args[1] >= 0 &&
+                 step->args[1] < NUMBER_OF_SINGLE_CHANNEL_KEYS;
+        }
+        else if(strcmp(word, "slide") == 0)
+        {
+            step->op = SCRIPT_SLIDE;
+            step->args[1] = 0;
+            ok = sscanf(rest, "%ld %ld", &step->args[2], &step->args[1]) >= 1 &&
+                 step->args[2] >= 0 && step->args[2] < TOUCH_SLIDER_STEPS &&
+                 step->args[1] >= 0;
+        }
+        else if(strcmp(word, "wheel-gain") == 0)
+        {
+            step->op = SCRIPT_WHEEL_GAIN;
+            ok = sscanf(rest, "%ld %ld", &step->args[0], &step->args[1]) == 2;
+        }
+        else if(strcmp(word, "obstacle") == 0)
+        {
+            step->op = SCRIPT_OBSTACLE;
+            ok = sscanf(rest, "%ld", &step->args[0]) == 1 &&
+                 step->args[0] >= 0 && step->args[0] <= 0xFFFF;
+        }
+        else if(strcmp(word, "overcurrent") == 0)
+        {
+            step->op = SCRIPT_OVERCURRENT;
+            ok = sscanf(rest, "%ld", &step->args[0]) == 1 &&
+                 (step->args[0] == 0 || step->args[0] == 1);
+        }
+        else if(strcmp(word, "timeout") == 0)
+        {
+            step->op = SCRIPT_TIMEOUT;
+            ok = sscanf(rest, "%ld", &step->args[0]) == 1;
+        }
+        else if(strcmp(word, "end") == 0)
+        {
+            step->op = SCRIPT_END;
+        }
+        else
+        {
+            ok = 0;
+        }
+
+        if(!ok)
+        {
+            fprintf(stderr, "%s:%u: bad step: %s\n", path, line, text);
+            fclose(file);
+            return 0;
+        }
+
+        stepCount++;
+    }
+
+    fclose(file);
+    return 1;
+}
+
+/*******************************************************************************
+  * @brief Load a script
+  * @par Parameters:
+  * path - script file
+  * @retval 1 if loaded, 0 on an error
+  *****************************************************************************/
+int Script_Load(const char *path)
+{
+    stepCount = 0;
+    stepIndex = 0;
+    stepStarted = 0;
+    fileCount = 0;
+    timeout = SCRIPT_TIMEOUT_DEFAULT;
+    rxPackets = 0;
+    rxLost = 0;
+    rxRejected = 0;
+
+    return Script_LoadFile(path);
+}
+
+/*******************************************************************************
+  * @brief Get the bytes of every reply step in the loaded script, in order,
+  *        as the module would send them. Other steps are left out.
+  * @par Parameters:
+  * buffer - set to the bytes
+  * size - size of the buffer
+  * @retval number of bytes, 0 if they do not fit
+  *****************************************************************************/
+unsigned long Script_GetReplies(unsigned char *buffer, unsigned long size)
+{
+    unsigned long length = 0;
+    unsigned short i = 0;
+    unsigned short j = 0;
+
+    for(i = 0; i < stepCount; i++)
+    {
+        if(steps[i].op != SCRIPT_REPLY)
+        {
+            continue;
+        }
+
+        if(length + steps[i].length > size)
+        {
+            return 0;
+        }
+
+        for(j = 0; j < steps[i].length; j++)
+        {
+            buffer[length++] = (unsigned char)steps[i].data[j];
+        }
+    }
+
+    return length;
+}
+
+/*******************************************************************************
+  * @brief Get the receive counts the loaded script expects, the sum of its
+  *        expect-rx steps
+  * @par Parameters:
+  * counts - set to the packets, lost and rejected counts
+  * @retval 1 if the script has an expect-rx step, 0 otherwise
+  *****************************************************************************/
+int Script_GetExpectRx(long *counts)
+{
+    unsigned short i = 0;
+    int found = 0;
+
+    counts[0] = 0;
+    counts[1] = 0;
+    counts[2] = 0;
+
+    for(i = 0; i < stepCount; i++)
+    {
+        if(steps[i].op == SCRIPT_EXPECT_RX)
+        {
+            counts[0] += steps[i].args[0];
+            counts[1] += steps[i].args[1];
+            counts[2] += steps[i].args[2];
+            found = 1;
+        }
+    }
+
+    return found;
+}
+
+/*******************************************************************************
+  * @brief Print a record for a failure or the verbose log
+  * @par Parameters:
+  * record - record sent by the robot
+  * @retval None
+  *****************************************************************************/
+static void Script_PrintRecord(const SimRecord *record)
+{
+    unsigned short i = 0;
+
+    if(record->type == SIM_RECORD_DATA)
+    {
+        fprintf(stderr, "data");
+
+        for(i = 0; i < record->length; i++)
+        {
+            fprintf(stderr, " %02X", record->data[i]);
+        }
+    }
+    else
+    {
+        fprintf(stderr, "line \"");
+
+        for(i = 0; i < record->length; i++)
+        {
+            if(record->data[i] >= 0x20 && record->data[i] < 0x7F)
+            {
+                fputc(record->data[i], stderr);
+            }
+            else
+            {
+                fprintf(stderr, "\\x%02X", record->data[i]);
+            }
+        }
+
+        fprintf(stderr, "\"");
+    }
+
+    fprintf(stderr, "\n");
+}
+
+/*******************************************************************************
+  * @brief Match a record against an expect step
+  * @par Parameters:
+  * step - expect or expect-data step
+  * record - record sent by the robot
+  * @retval 1 if it matches, 0 otherwise
+  *****************************************************************************/
+static int Script_Match(const ScriptStep *step, const SimRecord *record)
+{
+    unsigned short i = 0;
+    unsigned char type = (step->op == SCRIPT_EXPECT_DATA) ? SIM_RECORD_DATA :
+                                                            SIM_RECORD_LINE;
+
+    if(record->type != type || record->length < step->length ||
+       (!step->prefix && record->length != step->length))
+    {
+        return 0;
+    }
+
+    for(i = 0; i < step->length; i++)
+    {
+        if(step->data[i] != SCRIPT_ANY_BYTE && step->data[i] != record->data[i])
+        {
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
+/*******************************************************************************
+  * @brief Report a failed step
+  * @par Parameters:
+  * step - failed step
+  * now - simulated time in ms
+  * reason - what went wrong
+  * @retval SIM_FAIL
+  *****************************************************************************/
+static unsigned char Script_Fail(const ScriptStep *step, unsigned long now,
+                                 const char *reason)
+{
+    fprintf(stderr, "%s:%u: FAIL at %lums: %s\n", scriptFiles[step->file],
+            step->line, now, reason);
+    return SIM_FAIL;
+}
+
+/*******************************************************************************
+  * @brief Run the script steps that are ready. Called every simulated ms.
+  * @par Parameters:
+  * now - simulated time in ms
+  * @retval SIM_RUNNING, SIM_PASS or SIM_FAIL
+  *****************************************************************************/
+unsigned char Script_Tick(unsigned long now)
+{
+    unsigned char buffer[SIM_RECORD_SIZE + 16];
+    unsigned short i = 0;
+    ScriptStep *step = 0;
+    SimRecord record;
+    long diff = 0;
+    long x = 0;
+    long y = 0;
+    long degrees = 0;
+    const unsigned char *memory = 0;
+
+    while(stepIndex < stepCount)
+    {
+        step = &steps[stepIndex];
+
+        if(!stepStarted)
+        {
+            stepStart = now;
+            stepStarted = 1;
+        }
+
+        switch(step->op)
+        {
+            case SCRIPT_EXPECT:
+            case SCRIPT_EXPECT_DATA:
+                if(!EspSim_GetRecord(&record))
+                {
+                    if(now - stepStart >= timeout)
+                    {
+                        return Script_Fail(step, now, "nothing sent");
+                    }
+                    return SIM_RUNNING;
+                }
+
+                if(simVerbose)
+                {
+                    fprintf(stderr, "%8lu tx ", now);
+                    Script_PrintRecord(&record);
+                }
+
+                if(!Script_Match(step, &record))
+                {
+                    Script_Fail(step, now, "unexpected");
+                    Script_PrintRecord(&record);
+                    return SIM_FAIL;
+                }
+                break;
+
+            case SCRIPT_REPLY:
+                for(i = 0; i < step->length; i++)
+                {
+                    buffer[i] = (unsigned char)step->data[i];
+                }
+                EspSim_Reply(buffer, step->length);
+                break;
+
+            case SCRIPT_IPD:
+                for(i = 0; i < step->length; i++)
+                {
+                    buffer[i] = (unsigned char)step->data[i];
+                }
+                EspSim_Datagram((unsigned char)step->args[0],
+                                step->sender[0] ? step->sender : 0,
+                                (unsigned long)step->args[1], buffer,
+                                step->length);
+                simStats.rxDatagrams++;
+                break;
+
+            case SCRIPT_WAIT:
+                if(now - stepStart < (unsigned long)step->args[0])
+                {
+                    return SIM_RUNNING;
+                }
+                break;
+
+            case SCRIPT_BAUD:
+                if(!EspSim_IsRxEmpty())
+                {
+                    return SIM_RUNNING;
+                }
+                EspSim_SetBaud((unsigned long)step->args[0]);
+                break;
+
+            case SCRIPT_LINE_ERROR:
+                EspSim_SetLineError((unsigned char)step->args[0]);
+                break;
+
+            case SCRIPT_EXPECT_PWM:
+                if(Wheel_GetPwm(0) != step->args[0] ||
+                   Wheel_GetPwm(1) != step->args[1])
+                {
+                    if(now - stepStart >= timeout)
+                    {
+                        fprintf(stderr, "pwm %d %d\n", Wheel_GetPwm(0),
+                                Wheel_GetPwm(1));
+                        return Script_Fail(step, now, "pwm mismatch");
+                    }
+                    return SIM_RUNNING;
+                }
+                break;
+
+            case SCRIPT_EXPECT_WHEEL:
+                diff = labs(Wheel_GetSpeed(0) - step->args[0]);
+
+                if(labs(Wheel_GetSpeed(1) - step->args[1]) > diff)
+                {
+                    diff = labs(Wheel_GetSpeed(1) - step->args[1]);
+                }
+
+                if(diff > step->args[2])
+                {
+                    if(now - stepStart >= timeout)
+                    {
+                        fprintf(stderr, "wheel %d %d\n", Wheel_GetSpeed(0),
+                                Wheel_GetSpeed(1));
+                        return Script_Fail(step, now, "wheel speed mismatch");
+                    }
+                    return SIM_RUNNING;
+                }
+                break;
+
+            case SCRIPT_EXPECT_POSE:
+                Odometry_GetReport(buffer);
+                x = (signed short)(buffer[0] | (buffer[1] << 8));
+                y = (signed short)(buffer[2] | (buffer[3] << 8));
+                degrees = (long)Odometry_GetHeading() * 360 / 65536;
+
+                //Heading error the short way round
+                diff = labs((degrees - step->args[2] + 540) % 360 - 180);
+
+                if(labs(x - step->args[0]) > step->args[3] ||
+                   labs(y - step->args[1]) > step->args[3] ||
+                   diff > step->args[3])
+                {
+                    if(now - stepStart >= timeout)
+                    {
+                        fprintf(stderr, "pose %ld %ld %ld\n", x, y, degrees);
+                        return Script_Fail(step, now, "pose mismatch");
+                    }
+                    return SIM_RUNNING;
+                }
+                break;
+
+            case SCRIPT_EXPECT_EEPROM:
+            case SCRIPT_EXPECT_FLASH:
+                memory = (step->op == SCRIPT_EXPECT_EEPROM) ?
+                         &hal.eeprom[step->args[0]] :
+                         &hal.flash[step->args[0] - FLASH_PROG_START_PHYSICAL_ADDRESS];
+
+                for(i = 0; i < step->length; i++)
+                {
+                    if(step->data[i] != SCRIPT_ANY_BYTE &&
+                       step->data[i] != memory[i])
+                    {
+                        break;
+                    }
+                }
+
+                if(i < step->length)
+                {
+                    if(now - stepStart >= timeout)
+                    {
+                        fprintf(stderr, "%s %03lX:", (step->op == SCRIPT_EXPECT_EEPROM) ?
+                                "eeprom" : "flash", step->args[0] + i);
+
+                        for(; i < step->length; i++)
+                        {
+                            fprintf(stderr, " %02X", memory[i]);
+                        }
+                        fprintf(stderr, "\n");
+                        return Script_Fail(step, now, (step->op == SCRIPT_EXPECT_EEPROM) ?
+                                           "eeprom mismatch" : "flash mismatch");
+                    }
+                    return SIM_RUNNING;
+                }
+                break;
+
+            case SCRIPT_EXPECT_RX:
+                x = (unsigned short)(Esp8266_GetRxPacketCount() - rxPackets);
+                y = (unsigned short)(Esp8266_GetRxDropCount() + 
+                                     Esp8266_GetRxOversizeCount() - rxLost);
+                diff = (unsigned short)(Protocol_GetRejectCount() - rxRejected);
+
+                if(x != step->args[0] || y != step->args[1] || 
+                   diff != step->args[2])
+                {
+                    if(now - stepStart >= timeout)
+                    {
+                        fprintf(stderr, "rx %ld %ld %ld\n", x, y, diff);
+                        return Script_Fail(step, now, "receive count mismatch");
+                    }
+                    return SIM_RUNNING;
+                }
+
+                rxPackets = Esp8266_GetRxPacketCount();
+                rxLost = Esp8266_GetRxDropCount() + Esp8266_GetRxOversizeCount();
+                rxRejected = Protocol_GetRejectCount();
+                break;
+
+            case SCRIPT_EXPECT_CPU:
+                if(hal.cpuDivider != step->args[0])
+                {
+                    if(now - stepStart >= timeout)
+                    {
+                        fprintf(stderr, "cpu divider %u\n", hal.cpuDivider);
+                        return Script_Fail(step, now, "cpu clock mismatch");
+                    }
+                    return SIM_RUNNING;
+                }
+                break;
+
+            case SCRIPT_TOUCH:
+                hal.touchPending = 1;
+                hal.touchHold = (unsigned long)step->args[0];
+                hal.touchKey = (unsigned char)step->args[1];
+                break;
+
+            case SCRIPT_SLIDE:
+                hal.touchPending = 1;
+                hal.touchHold = (unsigned long)step->args[1];
+                hal.touchKey = HAL_TOUCH_SLIDER;
+                hal.touchPosition = (unsigned char)step->args[2];
+                break;
+
+            case SCRIPT_WHEEL_GAIN:
+                Wheel_SetGain((unsigned char)step->args[0],
+                              (unsigned char)step->args[1]);
+                break;
+
+            case SCRIPT_OBSTACLE:
+                Obstacle_Set((unsigned short)step->args[0]);
+                break;
+
+            case SCRIPT_OVERCURRENT:
+                Overcurrent_Set((unsigned char)step->args[0]);
+                break;
+
+            case SCRIPT_TIMEOUT:
+                timeout = (unsigned long)step->args[0];
+                break;
+
+            case SCRIPT_END:
+                return SIM_PASS;
+
+            default:
+                return Script_Fail(step, now, "bad step");
+        };
+
+        if(simVerbose && step->op != SCRIPT_EXPECT &&
+           step->op != SCRIPT_EXPECT_DATA)
+        {
+            fprintf(stderr, "%8lu step %u done\n", now, step->line);
+        }
+
+        stepIndex++;
+        stepStarted = 0;
+    }
+
+    //Ran off the end without an end step
+    return SIM_PASS;
+}
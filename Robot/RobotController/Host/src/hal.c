@@ -0,0 +1,996 @@
+/*******************************************************************************
+  * @file hal.c
+  * @brief Implements the host stand-in for the STM8S standard peripheral
+  *        library and the touch sensing library on simulated registers.
+  *        Interrupts are delivered by the simulator as SIGALRM, masking
+  *        interrupts blocks the signal.
+  * @author David Sharpe
+  * @version V1.0.0
+  * @date 14-October-2026
+  *
+  * Host build using GCC
+  *****************************************************************************/
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Includes
+////////////////////////////////////////////////////////////////////////////////
+#include "Hal.h"
+#include "stm8_tsl_api.h"
+#include <signal.h>
+#include <string.h>
+#include <time.h>
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Variables
+////////////////////////////////////////////////////////////////////////////////
+HalState hal;
+
+unsigned char Hal_Stack[512];
+
+GPIO_TypeDef Hal_GPIOA;
+GPIO_TypeDef Hal_GPIOB;
+GPIO_TypeDef Hal_GPIOC;
+GPIO_TypeDef Hal_GPIOD;
+GPIO_TypeDef Hal_GPIOE;
+GPIO_TypeDef Hal_GPIOG;
+TIM1_TypeDef Hal_TIM1;
+UART2_TypeDef Hal_UART2;
+SPI_TypeDef Hal_SPI;
+
+TSLState_T TSLState = TSL_IDLE_STATE;
+KeyFlag_T TSL_GlobalSetting;
+TimerFlag_T TSL_Tick_Flags;
+Single_Channel_Complete_Info_T sSCKeyInfo[NUMBER_OF_SINGLE_CHANNEL_KEYS];
+#if NUMBER_OF_MULTI_CHANNEL_KEYS > 0
+Penta_Channel_Complete_Info_T sMCKeyInfo[NUMBER_OF_MULTI_CHANNEL_KEYS];
+#endif
+
+
+/*******************************************************************************
+  * @brief Reset the simulated peripherals
+  * @par Parameters: None
+  * @retval None
+  *****************************************************************************/
+void Hal_Initialize(void)
+{
+    memset(&hal, 0, sizeof(hal));
+    hal.iwdgReload = 0xFF;
+    hal.cpuDivider = 1;
+    memset(hal.itcPriority, ITC_PRIORITYLEVEL_3, sizeof(hal.itcPriority));
+    memset(&Hal_GPIOA, 0, sizeof(GPIO_TypeDef));
+    memset(&Hal_GPIOB, 0, sizeof(GPIO_TypeDef));
+    memset(&Hal_GPIOC, 0, sizeof(GPIO_TypeDef));
+    memset(&Hal_GPIOD, 0, sizeof(GPIO_TypeDef));
+    memset(&Hal_GPIOE, 0, sizeof(GPIO_TypeDef));
+    memset(&Hal_GPIOG, 0, sizeof(GPIO_TypeDef));
+    Hal_TIM1.SR1 = 0;
+    Hal_TIM1.CCER2 = 0;
+    Hal_UART2.SR = UART2_SR_TXE | UART2_SR_TC;
+    Hal_UART2.DR = 0;
+    Hal_SPI.SR = SPI_SR_TXE;
+    Hal_SPI.DR = 0;
+    hal.spiDivider = 2;
+}
+
+/*******************************************************************************
+  * @brief Get a monotonic time
+  * @par Parameters: None
+  * @retval time in ns
+  *****************************************************************************/
+long long Hal_GetNanos(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (long long)now.tv_sec * 1000000000LL + now.tv_nsec;
+}
+
+/*******************************************************************************
+  * @brief Get the microbenchmark clock
+  * @par Parameters: None
+  * @retval host time in ns, wraps every 65us
+  *****************************************************************************/
+unsigned short Hal_GetBenchCount(void)
+{
+    return (unsigned short)Hal_GetNanos();
+}
+
+/*******************************************************************************
+  * @brief Unmask the simulated interrupts
+  * @par Parameters: None
+  * @retval None
+  *****************************************************************************/
+void Hal_EnableInterrupts(void)
+{
+    sigset_t set;
+
+    sigemptyset(&set);
+    sigaddset(&set, SIGALRM);
+    sigprocmask(SIG_UNBLOCK, &set, 0);
+}
+
+/*******************************************************************************
+  * @brief Mask the simulated interrupts
+  * @par Parameters: None
+  * @retval None
+  *****************************************************************************/
+void Hal_DisableInterrupts(void)
+{
+    sigset_t set;
+
+    sigemptyset(&set);
+    sigaddset(&set, SIGALRM);
+    sigprocmask(SIG_BLOCK, &set, 0);
+}
+
+/*******************************************************************************
+  * @brief Mask the simulated interrupts, the handler may already run masked
+  * @par Parameters: None
+  * @retval 1 if they were masked before, 0 otherwise
+  *****************************************************************************/
+unsigned char Hal_MaskInterrupts(void)
+{
+    sigset_t set;
+    sigset_t old;
+
+    sigemptyset(&set);
+    sigaddset(&set, SIGALRM);
+    sigprocmask(SIG_BLOCK, &set, &old);
+
+    return sigismember(&old, SIGALRM) == 1;
+}
+
+/*******************************************************************************
+  * @brief Put back the mask Hal_MaskInterrupts found
+  * @par Parameters:
+  * mask - value returned by Hal_MaskInterrupts
+  * @retval None
+  *****************************************************************************/
+void Hal_RestoreInterrupts(unsigned char mask)
+{
+    if(!mask)
+    {
+        Hal_EnableInterrupts();
+    }
+}
+
+/*******************************************************************************
+  * @brief Sleep until the next simulated interrupt. Like the WFI instruction
+  *        interrupts are unmasked while waiting and stay unmasked.
+  * @par Parameters: None
+  * @retval None
+  *****************************************************************************/
+void Hal_WaitForInterrupt(void)
+{
+    sigset_t set;
+    long long start = Hal_GetNanos();
+
+    sigemptyset(&set);
+    sigsuspend(&set);
+    Hal_EnableInterrupts();
+
+    hal.idleNanos += Hal_GetNanos() - start;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Clock
+////////////////////////////////////////////////////////////////////////////////
+void CLK_HSIPrescalerConfig(CLK_Prescaler_TypeDef prescaler)
+{
+    (void)prescaler;
+}
+
+void CLK_SYSCLKConfig(CLK_Prescaler_TypeDef prescaler)
+{
+    unsigned char divider = (unsigned char)(1 << (prescaler & 0x07));
+
+    if(!(prescaler & CLK_PRESCALER_CPUDIV1))
+    {
+        return;
+    }
+
+    if(divider > 1 && hal.cpuDivider <= 1)
+    {
+        hal.cpuSlowdowns++;
+    }
+
+    hal.cpuDivider = divider;
+}
+
+void CLK_PeripheralClockConfig(CLK_Peripheral_TypeDef peripheral,
+                               FunctionalState state)
+{
+    (void)peripheral;
+    (void)state;
+}
+
+uint32_t CLK_GetClockFreq(void)
+{
+    return HAL_CLOCK_FREQ;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+// GPIO
+////////////////////////////////////////////////////////////////////////////////
+void GPIO_DeInit(GPIO_TypeDef *port)
+{
+    port->ODR = 0;
+    port->DDR = 0;
+    port->CR1 = 0;
+    port->CR2 = 0;
+}
+
+void GPIO_Init(GPIO_TypeDef *port, GPIO_Pin_TypeDef pins, GPIO_Mode_TypeDef mode)
+{
+    if(mode & 0x80)
+    {
+        port->DDR |= pins;
+
+        if(mode & 0x10)
+        {
+            port->ODR |= pins;
+        }
+        else
+        {
+            port->ODR &= ~pins;
+        }
+    }
+    else
+    {
+        port->DDR &= ~pins;
+    }
+
+    port->CR1 = (mode & 0x40) ? (port->CR1 | pins) : (port->CR1 & ~pins);
+    port->CR2 = (mode & 0x20) ? (port->CR2 | pins) : (port->CR2 & ~pins);
+}
+
+void GPIO_WriteHigh(GPIO_TypeDef *port, GPIO_Pin_TypeDef pins)
+{
+    port->ODR |= pins;
+}
+
+void GPIO_WriteLow(GPIO_TypeDef *port, GPIO_Pin_TypeDef pins)
+{
+    //Latched so the simulator sees a pulse shorter than its tick
+    port->falls |= port->ODR & pins;
+    port->ODR &= ~pins;
+}
+
+void GPIO_WriteReverse(GPIO_TypeDef *port, GPIO_Pin_TypeDef pins)
+{
+    port->ODR ^= pins;
+}
+
+uint8_t GPIO_ReadInputData(GPIO_TypeDef *port)
+{
+    return port->IDR;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+// External interrupts
+////////////////////////////////////////////////////////////////////////////////
+void EXTI_SetExtIntSensitivity(EXTI_Port_TypeDef port,
+                               EXTI_Sensitivity_TypeDef sensitivity)
+{
+    hal.extiSensitivity[port] = sensitivity;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Interrupt controller
+////////////////////////////////////////////////////////////////////////////////
+void ITC_SetSoftwarePriority(ITC_Irq_TypeDef irq, ITC_PriorityLevel_TypeDef priority)
+{
+    if(irq < HAL_IRQ_COUNT)
+    {
+        hal.itcPriority[irq] = priority;
+    }
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+// ADC1
+////////////////////////////////////////////////////////////////////////////////
+void ADC1_DeInit(void)
+{
+    hal.adcEnabled = 0;
+    hal.adcEocIt = 0;
+    hal.adcExtTrigger = 0;
+    hal.adcScan = 0;
+    hal.adcBuffered = 0;
+    hal.adcChannel = 0;
+    memset(hal.adcBuffer, 0, sizeof(hal.adcBuffer));
+}
+
+void ADC1_Init(ADC1_ConvMode_TypeDef mode, ADC1_Channel_TypeDef channel,
+               ADC1_PresSel_TypeDef prescaler, ADC1_ExtTrig_TypeDef trigger,
+               FunctionalState triggerState, ADC1_Align_TypeDef align,
+               ADC1_SchmittTrigg_TypeDef schmitt, FunctionalState schmittState)
+{
+    (void)mode;
+    (void)prescaler;
+    (void)align;
+    (void)schmitt;
+    (void)schmittState;
+
+    //Only the TIM1 trigger is simulated
+    hal.adcChannel = channel;
+    hal.adcExtTrigger = (trigger == ADC1_EXTTRIG_TIM && triggerState == ENABLE);
+}
+
+void ADC1_Cmd(FunctionalState state)
+{
+    hal.adcEnabled = (state == ENABLE);
+}
+
+void ADC1_ScanModeCmd(FunctionalState state)
+{
+    hal.adcScan = (state == ENABLE);
+}
+
+void ADC1_DataBufferCmd(FunctionalState state)
+{
+    hal.adcBuffered = (state == ENABLE);
+}
+
+void ADC1_ITConfig(ADC1_IT_TypeDef it, FunctionalState state)
+{
+    if(it == ADC1_IT_EOCIE)
+    {
+        hal.adcEocIt = (state == ENABLE);
+    }
+}
+
+void ADC1_SchmittTriggerConfig(ADC1_SchmittTrigg_TypeDef channel,
+                               FunctionalState state)
+{
+    (void)channel;
+    (void)state;
+}
+
+uint16_t ADC1_GetBufferValue(uint8_t buffer)
+{
+    return (buffer < HAL_ADC_CHANNELS) ? hal.adcBuffer[buffer] : 0;
+}
+
+void ADC1_ClearITPendingBit(ADC1_IT_TypeDef it)
+{
+    (void)it;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// FLASH
+////////////////////////////////////////////////////////////////////////////////
+void FLASH_Unlock(FLASH_MemType_TypeDef memType)
+{
+    if(memType == FLASH_MEMTYPE_DATA)
+    {
+        hal.eepromUnlocked = 1;
+    }
+    else
+    {
+        hal.flashUnlocked = 1;
+    }
+}
+
+void FLASH_Lock(FLASH_MemType_TypeDef memType)
+{
+    if(memType == FLASH_MEMTYPE_DATA)
+    {
+        hal.eepromUnlocked = 0;
+    }
+    else
+    {
+        hal.flashUnlocked = 0;
+    }
+}
+
+uint8_t FLASH_ReadByte(uint32_t address)
+{
+    if(address >= FLASH_PROG_START_PHYSICAL_ADDRESS &&
+       address <= FLASH_PROG_END_PHYSICAL_ADDRESS)
+    {
+        return hal.flash[address - FLASH_PROG_START_PHYSICAL_ADDRESS];
+    }
+
+    if(address < FLASH_DATA_START_PHYSICAL_ADDRESS ||
+       address > FLASH_DATA_END_PHYSICAL_ADDRESS)
+    {
+        return 0;
+    }
+
+    return hal.eeprom[address - FLASH_DATA_START_PHYSICAL_ADDRESS];
+}
+
+void FLASH_ProgramWord(uint32_t address, uint32_t data)
+{
+    //The CPU stalls for a program memory word, it is written at once
+    if(address >= FLASH_PROG_START_PHYSICAL_ADDRESS)
+    {
+        if(!hal.flashUnlocked || (address & 3) ||
+           address + 3 > FLASH_PROG_END_PHYSICAL_ADDRESS)
+        {
+            hal.flashErrors++;
+            return;
+        }
+
+        memcpy(&hal.flash[address - FLASH_PROG_START_PHYSICAL_ADDRESS], &data, 4);
+        return;
+    }
+
+    //Words are written byte by byte from the lowest address like the
+    //library, left locked, out of range, unaligned or overlapping a write
+    //in progress they are lost
+    if(!hal.eepromUnlocked || hal.eepromBusy || (address & 3) ||
+       address < FLASH_DATA_START_PHYSICAL_ADDRESS ||
+       address + 3 > FLASH_DATA_END_PHYSICAL_ADDRESS)
+    {
+        hal.eepromErrors++;
+        return;
+    }
+
+    memcpy(&hal.eeprom[address - FLASH_DATA_START_PHYSICAL_ADDRESS], &data, 4);
+    hal.eepromBusy = 1;
+    hal.eepromWords++;
+}
+
+void FLASH_ProgramBlock(uint16_t blockNum, FLASH_MemType_TypeDef memType,
+                        FLASH_ProgramMode_TypeDef progMode, uint8_t *buffer)
+{
+    uint32_t offset = (uint32_t)blockNum * FLASH_BLOCK_SIZE;
+    sigset_t mask;
+
+    (void)progMode;
+    sigprocmask(SIG_BLOCK, 0, &mask);
+
+    //Program memory only, left locked or out of range the block is lost.
+    //Block writes must run with interrupts off, as they do from RAM.
+    if(memType != FLASH_MEMTYPE_PROG || !hal.flashUnlocked ||
+       offset + FLASH_BLOCK_SIZE > HAL_FLASH_SIZE || sigismember(&mask, SIGALRM) != 1)
+    {
+        hal.flashErrors++;
+        return;
+    }
+
+    memcpy(&hal.flash[offset], buffer, FLASH_BLOCK_SIZE);
+    hal.flashBlocks++;
+}
+
+FLASH_Status_TypeDef FLASH_WaitForLastOperation(FLASH_MemType_TypeDef memType)
+{
+    (void)memType;
+
+    return FLASH_STATUS_SUCCESSFUL_OPERATION;
+}
+
+FlagStatus FLASH_GetFlagStatus(FLASH_Flag_TypeDef flag)
+{
+    FlagStatus result = RESET;
+
+    switch(flag)
+    {
+        case FLASH_FLAG_EOP:
+            //Cleared by reading
+            result = hal.eepromEop ? SET : RESET;
+            hal.eepromEop = 0;
+            break;
+
+        case FLASH_FLAG_HVOFF:
+            result = hal.eepromBusy ? RESET : SET;
+            break;
+
+        case FLASH_FLAG_DUL:
+            result = hal.eepromUnlocked ? SET : RESET;
+            break;
+    };
+
+    return result;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+// IWDG
+////////////////////////////////////////////////////////////////////////////////
+void IWDG_WriteAccessCmd(IWDG_WriteAccess_TypeDef access)
+{
+    hal.iwdgWriteAccess = (access == IWDG_WriteAccess_Enable);
+}
+
+void IWDG_SetPrescaler(IWDG_Prescaler_TypeDef prescaler)
+{
+    if(hal.iwdgWriteAccess)
+    {
+        hal.iwdgPrescaler = prescaler;
+    }
+}
+
+void IWDG_SetReload(uint8_t reload)
+{
+    if(hal.iwdgWriteAccess)
+    {
+        hal.iwdgReload = reload;
+    }
+}
+
+void IWDG_ReloadCounter(void)
+{
+    //The refresh key also locks the registers
+    hal.iwdgWriteAccess = 0;
+
+    if(hal.iwdgElapsed > hal.iwdgWorst)
+    {
+        hal.iwdgWorst = hal.iwdgElapsed;
+    }
+    hal.iwdgElapsed = 0;
+}
+
+void IWDG_Enable(void)
+{
+    hal.iwdgEnabled = 1;
+    hal.iwdgElapsed = 0;
+}
+
+/*******************************************************************************
+  * @brief Get the watchdog timeout from its settings, the counter runs from
+  *        the 128kHz LSI divided by 2 and the prescaler
+  * @par Parameters: None
+  * @retval timeout in ms
+  *****************************************************************************/
+unsigned short Hal_GetWatchdogTimeout(void)
+{
+    return (unsigned short)(((4UL << hal.iwdgPrescaler) *
+                             (hal.iwdgReload + 1UL)) / 64);
+}
+
+/*******************************************************************************
+  * @brief Get the UART baud rate from the divider in BRR1 and BRR2
+  * @par Parameters: None
+  * @retval baud rate, 0 if the divider has not been set
+  *****************************************************************************/
+unsigned long Hal_GetUartBaud(void)
+{
+    unsigned short divider = ((Hal_UART2.BRR2 & 0xF0) << 8) |
+                             (Hal_UART2.BRR1 << 4) | (Hal_UART2.BRR2 & 0x0F);
+
+    return divider ? HAL_CLOCK_FREQ / divider : 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// RST
+////////////////////////////////////////////////////////////////////////////////
+FlagStatus RST_GetFlagStatus(RST_Flag_TypeDef flag)
+{
+    return (hal.rstFlags & flag) ? SET : RESET;
+}
+
+void RST_ClearFlag(RST_Flag_TypeDef flag)
+{
+    //Written 1 to clear
+    hal.rstFlags &= (unsigned char)~flag;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// TIM1
+////////////////////////////////////////////////////////////////////////////////
+void TIM1_DeInit(void)
+{
+    hal.tim1Enabled = 0;
+    hal.tim1UpdateIt = 0;
+    hal.tim1Cc4It = 0;
+    hal.tim1Cc4Enabled = 0;
+    hal.tim1Counter = 0;
+    Hal_TIM1.SR1 = 0;
+    Hal_TIM1.CCER2 = 0;
+}
+
+void TIM1_TimeBaseInit(uint16_t prescaler, TIM1_CounterMode_TypeDef mode,
+                       uint16_t period, uint8_t repetition)
+{
+    //The simulator ticks every 1ms with a 1MHz count, the firmware
+    //settings are not checked
+    (void)prescaler;
+    (void)mode;
+    (void)period;
+    (void)repetition;
+}
+
+void TIM1_ARRPreloadConfig(FunctionalState state)
+{
+    (void)state;
+}
+
+void TIM1_ITConfig(TIM1_IT_TypeDef it, FunctionalState state)
+{
+    if(it & TIM1_IT_UPDATE)
+    {
+        hal.tim1UpdateIt = (state == ENABLE);
+    }
+
+    if(it & TIM1_IT_CC4)
+    {
+        hal.tim1Cc4It = (state == ENABLE);
+    }
+}
+
+void TIM1_Cmd(FunctionalState state)
+{
+    hal.tim1Enabled = (state == ENABLE);
+}
+
+uint16_t TIM1_GetCounter(void)
+{
+    long long count = 0;
+
+    if(hal.inInterrupt || hal.tickLength == 0)
+    {
+        return hal.tim1Counter;
+    }
+
+    count = (Hal_GetNanos() - hal.tickStart) * 1000 / hal.tickLength;
+
+    return (count > 999) ? 999 : (count < 0) ? 0 : (uint16_t)count;
+}
+
+void TIM1_SelectOutputTrigger(TIM1_TRGOSource_TypeDef source)
+{
+    hal.tim1Trgo = source;
+}
+
+void TIM1_ClearITPendingBit(TIM1_IT_TypeDef it)
+{
+    Hal_TIM1.SR1 &= ~(uint8_t)it;
+}
+
+void TIM1_ICInit(TIM1_Channel_TypeDef channel, TIM1_ICPolarity_TypeDef polarity,
+                 TIM1_ICSelection_TypeDef selection, TIM1_ICPSC_TypeDef prescaler,
+                 uint8_t filter)
+{
+    //Only channel 4 on its own input is simulated
+    (void)channel;
+    (void)selection;
+    (void)prescaler;
+    (void)filter;
+
+    hal.tim1Cc4Enabled = 1;
+    Hal_TIM1.CCER2 = (polarity == TIM1_ICPOLARITY_FALLING) ? TIM1_CCER2_CC4P : 0;
+}
+
+uint16_t TIM1_GetCapture4(void)
+{
+    return hal.tim1Capture4;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+// TIM2
+////////////////////////////////////////////////////////////////////////////////
+void TIM2_DeInit(void)
+{
+    hal.tim2Enabled = 0;
+    hal.tim2UpdateDisabled = 0;
+    hal.tim2UpdateIt = 0;
+    hal.tim2UpdateFlag = 0;
+    memset(hal.pwmCompare, 0, sizeof(hal.pwmCompare));
+    memset(hal.pwmPreload, 0, sizeof(hal.pwmPreload));
+    memset(hal.pwmPreloadEnabled, 0, sizeof(hal.pwmPreloadEnabled));
+    hal.pwmReload = 0xFFFF;
+    hal.pwmReloadPreload = 0xFFFF;
+    hal.pwmReloadPreloadEnabled = 0;
+}
+
+void TIM2_TimeBaseInit(TIM2_Prescaler_TypeDef prescaler, uint16_t period)
+{
+    //Only the period scales the wheel model, the prescaler is not checked
+    (void)prescaler;
+    hal.pwmReload = period;
+    hal.pwmReloadPreload = period;
+}
+
+void TIM2_OC1Init(TIM2_OCMode_TypeDef mode, TIM2_OutputState_TypeDef state,
+                  uint16_t pulse, TIM2_OCPolarity_TypeDef polarity)
+{
+    (void)mode;
+    (void)state;
+    (void)polarity;
+    hal.pwmCompare[0] = pulse;
+    hal.pwmPreload[0] = pulse;
+}
+
+void TIM2_OC2Init(TIM2_OCMode_TypeDef mode, TIM2_OutputState_TypeDef state,
+                  uint16_t pulse, TIM2_OCPolarity_TypeDef polarity)
+{
+    (void)mode;
+    (void)state;
+    (void)polarity;
+    hal.pwmCompare[1] = pulse;
+    hal.pwmPreload[1] = pulse;
+}
+
+void TIM2_OC1PreloadConfig(FunctionalState state)
+{
+    hal.pwmPreloadEnabled[0] = (state == ENABLE);
+}
+
+void TIM2_OC2PreloadConfig(FunctionalState state)
+{
+    hal.pwmPreloadEnabled[1] = (state == ENABLE);
+}
+
+void TIM2_ARRPreloadConfig(FunctionalState state)
+{
+    hal.pwmReloadPreloadEnabled = (state == ENABLE);
+}
+
+void TIM2_Cmd(FunctionalState state)
+{
+    hal.tim2Enabled = (state == ENABLE);
+}
+
+void TIM2_SetCompare1(uint16_t compare)
+{
+    hal.pwmPreload[0] = compare;
+
+    if(!hal.pwmPreloadEnabled[0])
+    {
+        hal.pwmCompare[0] = compare;
+    }
+}
+
+void TIM2_SetCompare2(uint16_t compare)
+{
+    hal.pwmPreload[1] = compare;
+
+    if(!hal.pwmPreloadEnabled[1])
+    {
+        hal.pwmCompare[1] = compare;
+    }
+}
+
+void TIM2_ITConfig(TIM2_IT_TypeDef it, FunctionalState state)
+{
+    if(it & TIM2_IT_UPDATE)
+    {
+        hal.tim2UpdateIt = (state == ENABLE);
+    }
+}
+
+void TIM2_ClearITPendingBit(TIM2_IT_TypeDef it)
+{
+    if(it & TIM2_IT_UPDATE)
+    {
+        hal.tim2UpdateFlag = 0;
+    }
+}
+
+void TIM2_UpdateDisableConfig(FunctionalState state)
+{
+    hal.tim2UpdateDisabled = (state == ENABLE);
+}
+
+void TIM2_PrescalerConfig(TIM2_Prescaler_TypeDef prescaler,
+                          TIM2_PSCReloadMode_TypeDef mode)
+{
+    (void)prescaler;
+    (void)mode;
+}
+
+void TIM2_SetAutoreload(uint16_t autoreload)
+{
+    hal.pwmReloadPreload = autoreload;
+
+    if(!hal.pwmReloadPreloadEnabled)
+    {
+        hal.pwmReload = autoreload;
+    }
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+// UART2
+////////////////////////////////////////////////////////////////////////////////
+void UART2_DeInit(void)
+{
+    hal.uartEnabled = 0;
+    hal.uartTxeIt = 0;
+    hal.uartRxneIt = 0;
+    hal.uartIdleIt = 0;
+    Hal_UART2.SR = UART2_SR_TXE | UART2_SR_TC;
+}
+
+void UART2_Init(uint32_t baud, UART2_WordLength_TypeDef wordLength,
+                UART2_StopBits_TypeDef stopBits, UART2_Parity_TypeDef parity,
+                UART2_SyncMode_TypeDef syncMode, UART2_Mode_TypeDef mode)
+{
+    uint32_t mantissa = 0;
+    uint32_t mantissa100 = 0;
+
+    (void)wordLength;
+    (void)stopBits;
+    (void)parity;
+    (void)syncMode;
+    (void)mode;
+
+    //The divider as the library sets it, truncated to 1/16
+    mantissa = HAL_CLOCK_FREQ / (baud << 4);
+    mantissa100 = HAL_CLOCK_FREQ * 100 / (baud << 4);
+    Hal_UART2.BRR2 = (uint8_t)((((mantissa100 - mantissa * 100) << 4) / 100) & 0x0F);
+    Hal_UART2.BRR2 |= (uint8_t)((mantissa >> 4) & 0xF0);
+    Hal_UART2.BRR1 = (uint8_t)mantissa;
+}
+
+void UART2_Cmd(FunctionalState state)
+{
+    hal.uartEnabled = (state == ENABLE);
+}
+
+void UART2_ITConfig(UART2_IT_TypeDef it, FunctionalState state)
+{
+    unsigned char enable = (state == ENABLE);
+
+    switch(it)
+    {
+        case UART2_IT_TXE:
+            hal.uartTxeIt = enable;
+            break;
+
+        case UART2_IT_RXNE:
+            hal.uartRxneIt = enable;
+            break;
+
+        case UART2_IT_IDLE:
+            hal.uartIdleIt = enable;
+            break;
+
+        default:
+            break;
+    };
+}
+
+void UART2_ClearITPendingBit(UART2_IT_TypeDef it)
+{
+    (void)it;
+}
+
+void UART2_SendData8(uint8_t data)
+{
+    Hal_UART2.DR = data;
+    Hal_UartTransmit(data);
+}
+
+uint8_t UART2_ReceiveData8(void)
+{
+    //Reading DR after SR clears RXNE, IDLE and the error flags
+    Hal_UART2.SR &= ~(UART2_SR_RXNE | UART2_SR_IDLE | UART2_SR_OR |
+                      UART2_SR_NF | UART2_SR_FE);
+    return Hal_UART2.DR;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+// SPI
+////////////////////////////////////////////////////////////////////////////////
+void SPI_DeInit(void)
+{
+    hal.spiEnabled = 0;
+    hal.spiRxneIt = 0;
+    hal.spiTxFull = 0;
+    hal.spiDivider = 2;
+    Hal_SPI.SR = SPI_SR_TXE;
+    Hal_SPI.DR = 0;
+}
+
+void SPI_Init(SPI_FirstBit_TypeDef firstBit,
+              SPI_BaudRatePrescaler_TypeDef prescaler, SPI_Mode_TypeDef mode,
+              SPI_ClockPolarity_TypeDef polarity, SPI_ClockPhase_TypeDef phase,
+              SPI_DataDirection_TypeDef direction, SPI_NSS_TypeDef nss,
+              uint8_t crcPolynomial)
+{
+    //Only master mode 0 is simulated, the prescaler sets the byte rate
+    (void)firstBit;
+    (void)mode;
+    (void)polarity;
+    (void)phase;
+    (void)direction;
+    (void)nss;
+    (void)crcPolynomial;
+
+    hal.spiDivider = (unsigned char)(2 << (prescaler >> 3));
+}
+
+void SPI_Cmd(FunctionalState state)
+{
+    hal.spiEnabled = (state == ENABLE);
+}
+
+void SPI_ITConfig(SPI_IT_TypeDef it, FunctionalState state)
+{
+    if(it == SPI_IT_RXNE)
+    {
+        hal.spiRxneIt = (state == ENABLE);
+    }
+}
+
+void SPI_SendData(uint8_t data)
+{
+    //Clocked out by the simulator, which puts the reply in DR
+    hal.spiTx = data;
+    hal.spiTxFull = 1;
+    Hal_SPI.SR &= ~SPI_SR_TXE;
+}
+
+uint8_t SPI_ReceiveData(void)
+{
+    //Reading DR clears RXNE
+    Hal_SPI.SR &= ~SPI_SR_RXNE;
+    return Hal_SPI.DR;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Touch sensing
+////////////////////////////////////////////////////////////////////////////////
+void TSL_Init(void)
+{
+    memset(sSCKeyInfo, 0, sizeof(sSCKeyInfo));
+#if NUMBER_OF_MULTI_CHANNEL_KEYS > 0
+    memset(sMCKeyInfo, 0, sizeof(sMCKeyInfo));
+#endif
+    TSL_GlobalSetting.whole = 0;
+    TSL_Tick_Flags.whole = 0;
+    TSLState = TSL_IDLE_STATE;
+}
+
+void TSL_Timer_ISR(void)
+{
+    hal.tslTicks++;
+}
+
+static KeyFlag_T *Hal_TouchKey(unsigned char key)
+{
+#if NUMBER_OF_MULTI_CHANNEL_KEYS > 0
+    if(key == HAL_TOUCH_SLIDER)
+    {
+        return &sMCKeyInfo[0].Setting;
+    }
+#endif
+
+    return &sSCKeyInfo[key].Setting;
+}
+
+void TSL_Action(void)
+{
+    KeyFlag_T *key = Hal_TouchKey(hal.touchKey);
+
+    //The charge transfer bursts are timed in CPU cycles
+    if(hal.cpuDivider > 1)
+    {
+        hal.tslSlowActions++;
+    }
+
+    //A touch is held for its time, at least one acquisition, then released
+    if(hal.touchPending)
+    {
+        hal.touchPending = 0;
+        hal.touchRelease = Hal_GetNanos() + hal.touchHold * 1000000LL;
+        key->b.DETECTED = 1;
+        TSL_GlobalSetting.b.CHANGED = 1;
+
+#if NUMBER_OF_MULTI_CHANNEL_KEYS > 0
+        if(hal.touchKey == HAL_TOUCH_SLIDER)
+        {
+            sMCKeyInfo[0].Position = hal.touchPosition;
+        }
+#endif
+    }
+    else if(key->b.DETECTED && Hal_GetNanos() >= hal.touchRelease)
+    {
+        key->b.DETECTED = 0;
+        TSL_GlobalSetting.b.CHANGED = 1;
+    }
+}
@@ -0,0 +1,757 @@
+/*******************************************************************************
+  * @file sim_main.c
+  * @brief Host simulator entry point. The firmware main loop runs on the
+  *        process main thread and the simulated hardware runs every 1ms
+  *        from a SIGALRM handler that stands in for the interrupt vector
+  *        table, so interrupts preempt the main loop as they do on target.
+  *
+  *        usage: robot_sim [-v] [-b] [-s speed] script
+  *               robot_sim -r corpus...
+  *
+  *        -v        log the traffic and script steps
+  *        -b        print the microbenchmark results of the last run
+  *        -s speed  simulated ms per real ms, default 1
+  *        -r        replay receive corpora straight into the parser, the
+  *                  firmware is not started
+  * @author David Sharpe
+  * @version V1.0.0
+  * @date 14-October-2026
+  *
+  * Host build using GCC
+  *****************************************************************************/
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Includes
+////////////////////////////////////////////////////////////////////////////////
+#include "Sim.h"
+#include "Hal.h"
+#include "DriveController.h"
+#include "Encoder.h"
+#include "Esp8266.h"
+#include "Failsafe.h"
+#include "MicroBench.h"
+#include "Pool.h"
+#include "Protocol.h"
+#include "Range.h"
+#include "Scheduler.h"
+#include "Spi.h"
+#include "Telemetry.h"
+#include "Uart.h"
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Definitions
+////////////////////////////////////////////////////////////////////////////////
+#define SIM_TICK_US     1000
+
+//Firmware entry point, main.c is built with main renamed
+void Firmware_Main(void);
+
+#if MICRO_ENABLE
+//Microbenchmark kernels in MicroKernel order
+static const char *const MICRO_NAMES[MICRO_KERNEL_COUNT] =
+{
+    "ring put+get", "uart fifo put+get", "esp +ipd datagram",
+    "drive set speed", "cmd build cipsend"
+};
+#endif
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Variables
+////////////////////////////////////////////////////////////////////////////////
+int simVerbose = 0;
+static int simBench = 0;
+
+static unsigned long simTime = 0;
+static long long simStart = 0;
+#if !ESP8266_SPI_LINK
+static unsigned char rxActive = 0;
+#endif
+
+//Wheel model, speed in edges/s and the half period phase of each encoder
+static double wheelSpeed[2];
+static double wheelPhase[2];
+static unsigned char wheelGain[2] = {100, 100};
+
+//Obstacle range in mm, 0 for none, and the echo edges still to come in us
+//of simulated time
+static unsigned short obstacleMm = 0;
+#if RANGE_ENABLE
+static unsigned long echoEdge[2];
+static unsigned char echoEdges = 0;
+#endif
+
+
+/*******************************************************************************
+  * @brief Get the signed PWM applied to a wheel from the compare value and
+  *        the H-bridge inputs
+  * @par Parameters:
+  * wheel - 0 left, 1 right
+  * @retval compare value, negative when driven backward, 0 when stopped
+  *****************************************************************************/
+signed short Wheel_GetPwm(unsigned char wheel)
+{
+    unsigned char odr = wheel ? (GPIOG->ODR & 0x03) : ((GPIOA->ODR >> 3) & 0x03);
+    signed short compare = (signed short)hal.pwmCompare[wheel];
+
+    switch(odr)
+    {
+        case 0x01:
+            return compare;
+
+        case 0x02:
+            return -compare;
+
+        default:
+            return 0;
+    };
+}
+
+/*******************************************************************************
+  * @brief Run a TIM2 update event. The PWM period is 0.5ms, one event per
+  *        ms is enough for the wheel model.
+  * @par Parameters: None
+  * @retval None
+  *****************************************************************************/
+void Pwm_Tick(void)
+{
+    unsigned char channel = 0;
+
+    if(!hal.tim2Enabled || hal.tim2UpdateDisabled)
+    {
+        return;
+    }
+
+    if(hal.pwmReloadPreloadEnabled)
+    {
+        hal.pwmReload = hal.pwmReloadPreload;
+    }
+
+    for(channel = 0; channel < 2; channel++)
+    {
+        if(hal.pwmPreloadEnabled[channel])
+        {
+            hal.pwmCompare[channel] = hal.pwmPreload[channel];
+        }
+    }
+
+    hal.tim2UpdateFlag = 1;
+
+    //irq13, TIM2 update
+    if(hal.tim2UpdateIt)
+    {
+        DriveCtrl_PwmISR();
+    }
+}
+
+/*******************************************************************************
+  * @brief Set how fast each wheel turns at full duty
+  * @par Parameters:
+  * left - left wheel, percent of SIM_WHEEL_MAX
+  * right - right wheel, percent of SIM_WHEEL_MAX
+  * @retval None
+  *****************************************************************************/
+void Wheel_SetGain(unsigned char left, unsigned char right)
+{
+    wheelGain[0] = left;
+    wheelGain[1] = right;
+}
+
+/*******************************************************************************
+  * @brief Get the simulated speed of a wheel
+  * @par Parameters:
+  * wheel - 0 left, 1 right
+  * @retval speed in edges/s, negative backward
+  *****************************************************************************/
+signed short Wheel_GetSpeed(unsigned char wheel)
+{
+    return (signed short)(wheelSpeed[wheel] + (wheelSpeed[wheel] < 0 ? -0.5 : 0.5));
+}
+
+/*******************************************************************************
+  * @brief Advance the wheels by one ms. Each wheel follows its PWM with a
+  *        first order lag and the encoder pins toggle every half period,
+  *        the EXTI interrupt runs on the edges the sensitivity selects.
+  * @par Parameters: None
+  * @retval None
+  *****************************************************************************/
+void Wheel_Tick(void)
+{
+    const unsigned char PINS[2] = {ENCODER_LEFT_PIN, ENCODER_RIGHT_PIN};
+    unsigned char sensitivity = hal.extiSensitivity[EXTI_PORT_GPIOB];
+    double target = 0;
+    double rate = 0;
+    unsigned char wheel = 0;
+    unsigned char rising = 0;
+
+    for(wheel = 0; wheel < 2; wheel++)
+    {
+        target = (double)Wheel_GetPwm(wheel) * SIM_WHEEL_MAX *
+                 wheelGain[wheel] / 100.0 / ((double)hal.pwmReload + 1.0);
+        wheelSpeed[wheel] += (target - wheelSpeed[wheel]) / SIM_WHEEL_LAG;
+
+        //Half periods per ms
+        rate = 2.0 * (wheelSpeed[wheel] < 0 ? -wheelSpeed[wheel] :
+                                              wheelSpeed[wheel]) / 1000.0;
+        wheelPhase[wheel] += rate;
+
+        while(wheelPhase[wheel] >= 1.0)
+        {
+            wheelPhase[wheel] -= 1.0;
+
+            //Timestamp the edge within the ms
+            hal.tim1Counter = (unsigned short)(1000.0 *
+                              (1.0 - wheelPhase[wheel] / rate));
+            if(hal.tim1Counter > 999)
+            {
+                hal.tim1Counter = 999;
+            }
+
+            GPIOB->IDR ^= PINS[wheel];
+            rising = (GPIOB->IDR & PINS[wheel]) != 0;
+
+            if(rising)
+            {
+                simStats.encoderEdges++;
+            }
+
+            if((GPIOB->CR2 & PINS[wheel]) &&
+               (sensitivity == EXTI_SENSITIVITY_RISE_FALL ||
+                (sensitivity == EXTI_SENSITIVITY_RISE_ONLY && rising) ||
+                (sensitivity == EXTI_SENSITIVITY_FALL_ONLY && !rising)))
+            {
+                //irq4, EXTI port B
+                Encoder_ISR();
+            }
+        }
+    }
+
+    hal.tim1Counter = 0;
+}
+
+/*******************************************************************************
+  * @brief Place an obstacle ahead of the range sensor
+  * @par Parameters:
+  * mm - range to it, 0 to take it away
+  * @retval None
+  *****************************************************************************/
+void Obstacle_Set(unsigned short mm)
+{
+    obstacleMm = mm;
+}
+
+/*******************************************************************************
+  * @brief Set the motor current sense comparator, its output pulls the trip
+  *        pin low while on. The EXTI interrupt runs on the edges the 
+  *        sensitivity selects.
+  * @par Parameters:
+  * on - 1 for an overcurrent, 0 once it has passed
+  * @retval None
+  *****************************************************************************/
+void Overcurrent_Set(unsigned char on)
+{
+    unsigned char sensitivity = hal.extiSensitivity[DRIVE_TRIP_EXTI];
+    unsigned char was = (DRIVE_TRIP_PORT->IDR & DRIVE_TRIP_PIN) == 0;
+
+    if(on)
+    {
+        DRIVE_TRIP_PORT->IDR &= ~DRIVE_TRIP_PIN;
+    }
+    else
+    {
+        DRIVE_TRIP_PORT->IDR |= DRIVE_TRIP_PIN;
+    }
+
+    if(on != was && (DRIVE_TRIP_PORT->CR2 & DRIVE_TRIP_PIN) &&
+       (sensitivity == EXTI_SENSITIVITY_RISE_FALL ||
+        (sensitivity == EXTI_SENSITIVITY_RISE_ONLY && !on) ||
+        (sensitivity == EXTI_SENSITIVITY_FALL_ONLY && on)))
+    {
+        //irq7, EXTI port E
+        DriveCtrl_TripISR();
+    }
+}
+
+/*******************************************************************************
+  * @brief Answer a range trigger with an echo and run the TIM1 channel 4 
+  *        capture on the edges the polarity selects. The trigger is taken
+  *        as sent at the start of the ms.
+  * @par Parameters: None
+  * @retval None
+  *****************************************************************************/
+void Obstacle_Tick(void)
+{
+#if RANGE_ENABLE
+    unsigned long start = simTime * 1000;
+    unsigned char falling = 0;
+
+    if(RANGE_TRIGGER_PORT->falls & RANGE_TRIGGER_PIN)
+    {
+        RANGE_TRIGGER_PORT->falls &= ~RANGE_TRIGGER_PIN;
+        echoEdges = 0;
+
+        if(obstacleMm)
+        {
+            echoEdge[0] = start + SIM_ECHO_DELAY;
+            echoEdge[1] = echoEdge[0] + 
+                          (unsigned long)obstacleMm * RANGE_US_PER_10MM / 10;
+            echoEdges = 2;
+        }
+    }
+
+    while(echoEdges && echoEdge[2 - echoEdges] < start + 1000)
+    {
+        falling = (echoEdges == 1);
+        hal.tim1Counter = (unsigned short)(echoEdge[2 - echoEdges] - start);
+        echoEdges--;
+
+        if(falling)
+        {
+            RANGE_ECHO_PORT->IDR &= ~RANGE_ECHO_PIN;
+        }
+        else
+        {
+            RANGE_ECHO_PORT->IDR |= RANGE_ECHO_PIN;
+        }
+
+        if(!hal.tim1Cc4Enabled ||
+           falling != ((TIM1->CCER2 & TIM1_CCER2_CC4P) != 0))
+        {
+            continue;
+        }
+
+        hal.tim1Capture4 = hal.tim1Counter;
+
+        //irq12, TIM1 capture
+        if(hal.tim1Cc4It)
+        {
+            Range_CaptureISR();
+        }
+    }
+
+    hal.tim1Counter = 0;
+#endif
+}
+
+/*******************************************************************************
+  * @brief Convert a voltage at an analog pin to ADC counts
+  * @par Parameters:
+  * mv - pin voltage in mV
+  * @retval 10-bit conversion result
+  *****************************************************************************/
+static unsigned short Sim_AdcCounts(double mv)
+{
+    double counts = mv * 1024.0 / TELEMETRY_VREF_MV;
+
+    return (counts > 1023.0) ? 1023 : (counts < 0) ? 0 : (unsigned short)counts;
+}
+
+/*******************************************************************************
+  * @brief Update the analog inputs and run the conversions started by the 
+  *        TIM1 trigger output. The motor current follows the PWM and the 
+  *        battery sags with the load.
+  * @par Parameters: None
+  * @retval None
+  *****************************************************************************/
+static void Sim_AdcTick(void)
+{
+    double current[2];
+    unsigned char wheel = 0;
+    unsigned char i = 0;
+
+    for(wheel = 0; wheel < 2; wheel++)
+    {
+        current[wheel] = (double)abs(Wheel_GetPwm(wheel)) * SIM_MOTOR_MA /
+                         ((double)hal.pwmReload + 1.0);
+    }
+
+    hal.adcInput[TELEMETRY_BATTERY] = Sim_AdcCounts((SIM_BATTERY_MV -
+        (current[0] + current[1]) * SIM_BATTERY_MOHM / 1000.0) /
+        TELEMETRY_BATTERY_RATIO);
+    hal.adcInput[TELEMETRY_LEFT_CURRENT] =
+        Sim_AdcCounts(current[0] * 1000.0 / TELEMETRY_MA_PER_V);
+    hal.adcInput[TELEMETRY_RIGHT_CURRENT] =
+        Sim_AdcCounts(current[1] * 1000.0 / TELEMETRY_MA_PER_V);
+
+    if(!hal.adcEnabled || !hal.adcExtTrigger ||
+       hal.tim1Trgo != TIM1_TRGOSOURCE_UPDATE)
+    {
+        return;
+    }
+
+    //A scan converts from AIN0 up to the selected channel
+    for(i = hal.adcScan ? 0 : hal.adcChannel; i <= hal.adcChannel; i++)
+    {
+        hal.adcBuffer[i] = hal.adcInput[i];
+    }
+    hal.adcScans++;
+
+    //irq22, ADC1 end of conversion
+    if(hal.adcEocIt)
+    {
+        Telemetry_ADCISR();
+    }
+}
+
+#if ESP8266_SPI_LINK
+/*******************************************************************************
+  * @brief Clock the SPI for one ms at the byte rate its prescaler gives and
+  *        drive the module's ready output, the EXTI interrupt runs on the
+  *        ready edges the sensitivity selects. The receive interrupt runs
+  *        for each byte, the module sees the chip select fall before the
+  *        first byte of a transaction and rise after its last.
+  * @par Parameters: None
+  * @retval None
+  *****************************************************************************/
+static void Sim_SpiTick(void)
+{
+    unsigned char sensitivity = hal.extiSensitivity[BOARD_SPI_READY_EXTI];
+    unsigned char was = (BOARD_SPI_READY_PORT->IDR & BOARD_SPI_READY_PIN) != 0;
+    unsigned char ready = (unsigned char)EspSim_UpdateReady(simTime);
+    unsigned short bytesMs = (unsigned short)(HAL_CLOCK_FREQ /
+                                              (hal.spiDivider * 8UL * 1000));
+    unsigned char first = 0;
+    unsigned short i = 0;
+
+    if(ready)
+    {
+        BOARD_SPI_READY_PORT->IDR |= BOARD_SPI_READY_PIN;
+    }
+    else
+    {
+        BOARD_SPI_READY_PORT->IDR &= ~BOARD_SPI_READY_PIN;
+    }
+
+    if(ready != was && (BOARD_SPI_READY_PORT->CR2 & BOARD_SPI_READY_PIN) &&
+       (sensitivity == EXTI_SENSITIVITY_RISE_FALL ||
+        (sensitivity == EXTI_SENSITIVITY_RISE_ONLY && ready) ||
+        (sensitivity == EXTI_SENSITIVITY_FALL_ONLY && !ready)))
+    {
+        //irq6, EXTI port D
+        Esp8266_ReadyISR();
+    }
+
+    if(!hal.spiEnabled)
+    {
+        return;
+    }
+
+    //A byte written while the interrupt was off is clocked through and
+    //waits in DR for it
+    for(i = 0; i < bytesMs; i++)
+    {
+        if(hal.spiTxFull)
+        {
+            first = (SPI_CS_PORT->falls & SPI_CS_PIN) != 0;
+            SPI_CS_PORT->falls &= ~SPI_CS_PIN;
+            hal.tim1Counter = (unsigned short)(i * 1000UL / bytesMs);
+            hal.spiTxFull = 0;
+            SPI->DR = EspSim_Exchange(hal.spiTx, first);
+            SPI->SR |= SPI_SR_RXNE | SPI_SR_TXE;
+        }
+        else if(!(SPI->SR & SPI_SR_RXNE))
+        {
+            break;
+        }
+
+        if(!hal.spiRxneIt)
+        {
+            break;
+        }
+
+        //irq10, SPI receive buffer not empty
+        Spi_ISR();
+
+        if(SPI_CS_PORT->ODR & SPI_CS_PIN)
+        {
+            EspSim_EndTransfer();
+        }
+    }
+
+    hal.tim1Counter = 0;
+}
+#else
+/*******************************************************************************
+  * @brief Move bytes over the UART for one ms in each direction at the 
+  *        baud rate in the robot UART divider. The TX
+  *        and RX interrupts run for each byte and the idle line interrupt
+  *        follows the last byte of a reply.
+  * @par Parameters: None
+  * @retval None
+  *****************************************************************************/
+static void Sim_UartTick(void)
+{
+    unsigned char byte = 0;
+    unsigned char i = 0;
+    unsigned char bytesMs = (unsigned char)(Hal_GetUartBaud() / 
+                                            (SIM_UART_BITS * 1000));
+
+    if(!hal.uartEnabled)
+    {
+        return;
+    }
+
+    //irq20, transmit data register empty
+    for(i = 0; i < bytesMs && hal.uartTxeIt; i++)
+    {
+        Uart_TransmitISR();
+    }
+
+#if UART_FLOW_CONTROL
+    //The module holds its data while RTS is high
+    if(UART_RTS_PORT->ODR & UART_RTS_PIN)
+    {
+        bytesMs = 0;
+    }
+#endif
+
+    //irq21, receive data register full and idle line. Bytes are spread
+    //over the ms at the baud rate.
+    for(i = 0; i < bytesMs && EspSim_Receive(&byte); i++)
+    {
+        rxActive = 1;
+        hal.tim1Counter = (unsigned short)(i * 1000 / bytesMs);
+        UART2->DR = byte;
+        UART2->SR |= UART2_SR_RXNE | EspSim_GetByteError();
+
+        if(hal.uartRxneIt)
+        {
+            Uart_ReceiveISR();
+        }
+    }
+
+    if(rxActive && i < bytesMs && EspSim_IsRxEmpty())
+    {
+        rxActive = 0;
+        UART2->SR |= UART2_SR_IDLE;
+
+        if(hal.uartIdleIt)
+        {
+            Uart_ReceiveISR();
+        }
+    }
+}
+#endif
+
+/*******************************************************************************
+  * @brief Print the end of run report
+  * @par Parameters:
+  * result - SIM_PASS or SIM_FAIL
+  * @retval None
+  *****************************************************************************/
+static void Sim_Report(unsigned char result)
+{
+    fprintf(stderr, "%s after %lums\n", (result == SIM_PASS) ? "PASS" : "FAIL",
+            simTime);
+    fprintf(stderr, "  module tx %lu bytes, %lu records\n", simStats.txBytes,
+            simStats.txRecords);
+    fprintf(stderr, "  module rx %lu bytes, %lu datagrams\n", simStats.rxBytes,
+            simStats.rxDatagrams);
+    fprintf(stderr, "  link up at %lums\n", Esp8266_GetLinkUpTime());
+    fprintf(stderr, "  encoder edges %lu\n", simStats.encoderEdges);
+    fprintf(stderr, "  rx packets %u, dropped %u, oversize %u, tx failed %u\n",
+            Esp8266_GetRxPacketCount(), Esp8266_GetRxDropCount(),
+            Esp8266_GetRxOversizeCount(),
+            Esp8266_GetTxFailCount());
+    fprintf(stderr, "  module recoveries %u\n", Esp8266_GetRecoveryCount());
+    fprintf(stderr, "  pool peak datagrams %u, observer %u\n",
+            Pool_GetPeak(POOL_TX_DATAGRAM), Pool_GetPeak(POOL_OBSERVER));
+    fprintf(stderr, "  frames rejected %u\n", Protocol_GetRejectCount());
+    fprintf(stderr, "  commands recovered %u\n", Protocol_GetRecoveredCount());
+    fprintf(stderr, "  overruns drive %u\n",
+            Sched_GetOverruns(DriveCtrl_Update));
+    fprintf(stderr, "  overcurrent trips %u\n", DriveCtrl_GetTripCount());
+    fprintf(stderr, "  failsafe trips %u, worst stop %ums\n",
+            Failsafe_GetTrips(), Failsafe_GetWorstStop());
+    fprintf(stderr, "  watchdog longest reload %ums\n", hal.iwdgWorst);
+    fprintf(stderr, "  touch timebase ticks %lu\n", hal.tslTicks);
+    fprintf(stderr, "  cpu slowdowns %lu, slow touch steps %lu\n",
+            hal.cpuSlowdowns, hal.tslSlowActions);
+    fprintf(stderr, "  eeprom words %lu, errors %lu\n", hal.eepromWords,
+            hal.eepromErrors);
+    fprintf(stderr, "  flash blocks %lu, errors %lu\n", hal.flashBlocks,
+            hal.flashErrors);
+    fprintf(stderr, "  idle %.1f%%\n",
+            100.0 * hal.idleNanos / (double)(Hal_GetNanos() - simStart));
+
+#if MICRO_ENABLE
+    if(simBench)
+    {
+        unsigned char report[MICRO_REPORT_SIZE];
+        unsigned char i = 0;
+
+        Micro_GetReport(report);
+
+        //Host time, compare runs on the same machine
+        for(i = 0; i < MICRO_KERNEL_COUNT; i++)
+        {
+            fprintf(stderr, "  micro %-18s min %5u mean %5u ns\n",
+                    MICRO_NAMES[i], report[1 + i * 4] | (report[2 + i * 4] << 8),
+                    report[3 + i * 4] | (report[4 + i * 4] << 8));
+        }
+    }
+#endif
+}
+
+/*******************************************************************************
+  * @brief SIGALRM handler, one simulated ms of hardware
+  * @par Parameters:
+  * signal - signal number
+  * @retval None
+  *****************************************************************************/
+static void Sim_Tick(int signal)
+{
+    unsigned char result = SIM_RUNNING;
+
+    (void)signal;
+
+    hal.inInterrupt = 1;
+    hal.tim1Counter = 0;
+#if ESP8266_SPI_LINK
+    Sim_SpiTick();
+#else
+    Sim_UartTick();
+#endif
+    Pwm_Tick();
+    Wheel_Tick();
+    Obstacle_Tick();
+
+    //EEPROM programming time
+    if(hal.eepromBusy)
+    {
+        hal.eepromBusy = 0;
+        hal.eepromEop = 1;
+    }
+
+    //A watchdog reset ends the run, the firmware is not restarted
+    if(hal.iwdgEnabled && ++hal.iwdgElapsed >= Hal_GetWatchdogTimeout())
+    {
+        fprintf(stderr, "watchdog reset at %lums\n", simTime);
+        Sim_Report(SIM_FAIL);
+        exit(1);
+    }
+
+    //irq11, TIM1 update
+    if(hal.tim1Enabled)
+    {
+        TIM1->SR1 |= TIM1_SR1_UIF;
+
+        if(hal.tim1UpdateIt)
+        {
+            Sched_TickISR();
+        }
+
+        Sim_AdcTick();
+    }
+
+    simTime++;
+    hal.tickStart = Hal_GetNanos();
+    hal.inInterrupt = 0;
+    result = Script_Tick(simTime);
+
+    if(result != SIM_RUNNING)
+    {
+        Sim_Report(result);
+        exit(result == SIM_PASS ? 0 : 1);
+    }
+}
+
+/*******************************************************************************
+  * @brief Simulator entry point
+  * @par Parameters:
+  * argc - argument count
+  * argv - arguments
+  * @retval exit status, 0 if the script passed
+  *****************************************************************************/
+int main(int argc, char **argv)
+{
+    struct itimerval timer;
+    struct sigaction action;
+    int speed = 1;
+    int option = 0;
+    int replay = 0;
+
+    while((option = getopt(argc, argv, "vbrs:")) != -1)
+    {
+        switch(option)
+        {
+            case 'v':
+                simVerbose = 1;
+                break;
+
+            case 'b':
+                simBench = 1;
+                break;
+
+            case 'r':
+                replay = 1;
+                break;
+
+            case 's':
+                speed = atoi(optarg);
+                break;
+
+            default:
+                optind = argc + 1;
+                break;
+        };
+    }
+
+    if((replay ? optind >= argc : optind != argc - 1) || speed < 1 ||
+       speed > SIM_TICK_US)
+    {
+        fprintf(stderr, "usage: %s [-v] [-b] [-s speed] script\n"
+                        "       %s -r corpus...\n", argv[0], argv[0]);
+        return 2;
+    }
+
+    Hal_Initialize();
+    EspSim_Initialize();
+    Overcurrent_Set(0);
+
+    if(replay)
+    {
+        for(; optind < argc; optind++)
+        {
+            if(!Replay_Run(argv[optind]))
+            {
+                return 1;
+            }
+        }
+        return 0;
+    }
+
+    if(!Script_Load(argv[optind]))
+    {
+        return 2;
+    }
+
+    //Interrupts are masked out of reset until the firmware enables them
+    disableInterrupts();
+
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = Sim_Tick;
+    sigemptyset(&action.sa_mask);
+    action.sa_flags = SA_RESTART;
+    sigaction(SIGALRM, &action, 0);
+
+    timer.it_interval.tv_sec = 0;
+    timer.it_interval.tv_usec = SIM_TICK_US / speed;
+    timer.it_value = timer.it_interval;
+    hal.tickLength = (long long)timer.it_interval.tv_usec * 1000;
+    hal.tickStart = Hal_GetNanos();
+    simStart = hal.tickStart;
+    setitimer(ITIMER_REAL, &timer, 0);
+
+    Firmware_Main();
+
+    return 0;
+}
@@ -0,0 +1,60 @@
+/*******************************************************************************
+  * @file Benchmark.h
+  * @brief Defines the link benchmark statistics
+  * @author David Sharpe
+  * @version V1.0.0
+  * @date 14-October-2026
+  *
+  * ST Visual Develop 4.2.1 using STM8 Cosmic C Compiler
+  *****************************************************************************/
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+////////////////////////////////////////////////////////////////////////////////
+// Includes
+////////////////////////////////////////////////////////////////////////////////
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Definitions
+////////////////////////////////////////////////////////////////////////////////
+
+//Measured intervals, timestamps are taken from the TIM1 microsecond count
+enum BenchInterval
+{
+    BENCH_RX_TO_DISPATCH,   //+IPD header received to command dispatch
+    BENCH_DISPATCH_TO_SENT, //dispatch to the return of Esp8266_SendMsg
+    BENCH_SENT_TO_DONE,     //datagram queued to SEND OK
+    BENCH_RX_TO_STOP,       //+IPD header received to a stop applied
+    BENCH_INTERVAL_COUNT
+};
+
+//Statistics report, all values 16-bit LSB first:
+//  frames                      pings dispatched
+//  min, max, mean              for each interval, us
+//  rx lost                     packets dropped by the receive pool
+//  tx failed                   datagrams the module failed to send
+//  overrun, noise, framing,    UART receive errors
+//  ring full
+#define BENCH_REPORT_SIZE   (2 + (BENCH_INTERVAL_COUNT * 6) + 4 + 8)
+
+typedef struct
+{
+    unsigned short count;
+    unsigned short min;
+    unsigned short max;
+    unsigned long sum;
+} BenchStat;
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Functions
+////////////////////////////////////////////////////////////////////////////////
+void Bench_Start(void);
+void Bench_Stop(void);
+int  Bench_IsRunning(void);
+void Bench_Record(unsigned char interval, unsigned short micros);
+void Bench_SendCallback(unsigned char result, unsigned short micros);
+unsigned char Bench_GetReport(unsigned char *report);
+
+#endif
@@ -0,0 +1,154 @@
+/*******************************************************************************
+  * @file Board.h
+  * @brief Defines the board profile, every pin the firmware drives or reads
+  *        for the chassis revision it is built for. The modules take their
+  *        pins from here, the motor driver builds its pin and direction
+  *        tables from them, so porting to another board is a new profile
+  *        in this file.
+  * @author David Sharpe
+  * @version V1.0.0
+  * @date 14-October-2026
+  *
+  * ST Visual Develop 4.2.1 using STM8 Cosmic C Compiler
+  *****************************************************************************/
+#ifndef BOARD_H
+#define BOARD_H
+
+////////////////////////////////////////////////////////////////////////////////
+// Includes
+////////////////////////////////////////////////////////////////////////////////
+#include "stm8s.h"
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Definitions
+////////////////////////////////////////////////////////////////////////////////
+
+//Board profiles, set BOARD_PROFILE in the project to build for another
+#define BOARD_DISCOVERY         1     //STM8S105 Discovery on the robot chassis
+
+#ifndef BOARD_PROFILE
+#define BOARD_PROFILE           BOARD_DISCOVERY
+#endif
+
+//Ports as numbers for the touch sensing pins, the library tests its
+//electrode masks with #if so they are worked out by the preprocessor
+#define BOARD_PORT_A            0
+#define BOARD_PORT_B            1
+#define BOARD_PORT_C            2
+#define BOARD_PORT_D            3
+#define BOARD_PORT_E            4
+#define BOARD_PORT_F            5
+#define BOARD_PORT_G            6
+#define BOARD_PORT_H            7
+#define BOARD_PORT_I            8
+#define BOARD_PORT_ADDR(port)   (GPIOA_BaseAddress + ((port) * 5))
+
+#if BOARD_PROFILE == BOARD_DISCOVERY
+
+//H-bridge inputs of each motor. Pin A high drives forward and pin B high
+//drives backward, both low is STOP. Set REVERSED for a motor wired the
+//other way round. The PWM is the TIM2 channel, 1 or 2, on the bridge
+//enable.
+#define BOARD_LEFT_PORT         GPIOA
+#define BOARD_LEFT_PIN_A        GPIO_PIN_3
+#define BOARD_LEFT_PIN_B        GPIO_PIN_4
+#define BOARD_LEFT_REVERSED     0
+#define BOARD_LEFT_PWM          1     //PD4
+
+#define BOARD_RIGHT_PORT        GPIOG
+#define BOARD_RIGHT_PIN_A       GPIO_PIN_0
+#define BOARD_RIGHT_PIN_B       GPIO_PIN_1
+#define BOARD_RIGHT_REVERSED    0
+#define BOARD_RIGHT_PWM         2     //PD3
+
+//Current sense comparator, low while the motors draw too much
+#define BOARD_TRIP_PORT         GPIOE
+#define BOARD_TRIP_PIN          GPIO_PIN_3
+#define BOARD_TRIP_EXTI         EXTI_PORT_GPIOE
+
+//Wheel encoders, both on one port with its EXTI interrupt
+#define BOARD_ENCODER_PORT      GPIOB
+#define BOARD_ENCODER_EXTI      EXTI_PORT_GPIOB
+#define BOARD_ENCODER_LEFT      GPIO_PIN_6
+#define BOARD_ENCODER_RIGHT     GPIO_PIN_7
+
+//Module link. Set BOARD_ESP8266_SPI to 1 for a module running the SPI link
+//firmware, see Esp8266Spi.c. SCK, MOSI and MISO are PC5, PC6 and PC7 to its
+//HSPI GPIO14, GPIO13 and GPIO12, chip select goes to GPIO15 and its ready
+//output GPIO4 comes back on an EXTI input. The UART pins are free then.
+#ifndef BOARD_ESP8266_SPI
+#define BOARD_ESP8266_SPI       0
+#endif
+#define BOARD_SPI_CS_PORT       GPIOE
+#define BOARD_SPI_CS_PIN        GPIO_PIN_5  //RTS, the UART is not used
+#define BOARD_SPI_READY_PORT    GPIOD
+#define BOARD_SPI_READY_PIN     GPIO_PIN_6  //UART2 RX
+#define BOARD_SPI_READY_EXTI    EXTI_PORT_GPIOD
+
+//Range sensor, the echo must stay on TIM1 channel 4. The trigger moves off
+//MOSI to the UART2 TX pin with the SPI link.
+#if BOARD_ESP8266_SPI
+#define BOARD_RANGE_TRIGGER_PORT GPIOD
+#define BOARD_RANGE_TRIGGER_PIN GPIO_PIN_5
+#else
+#define BOARD_RANGE_TRIGGER_PORT GPIOC
+#define BOARD_RANGE_TRIGGER_PIN GPIO_PIN_6
+#endif
+#define BOARD_RANGE_ECHO_PORT   GPIOC
+#define BOARD_RANGE_ECHO_PIN    GPIO_PIN_4
+
+//Battery, motor current and spare analog inputs, ADC channels 0 to 2
+#define BOARD_ANALOG_PORT       GPIOB
+#define BOARD_ANALOG_PINS       (GPIO_PIN_0 | GPIO_PIN_1 | GPIO_PIN_2)
+
+//Status LED, LD1
+#define BOARD_LED_PORT          GPIOD
+#define BOARD_LED_PIN           GPIO_PIN_0
+
+//Software RTS to the module's CTS (GPIO13), see UART_FLOW_CONTROL
+#define BOARD_RTS_PORT          GPIOE
+#define BOARD_RTS_PIN           GPIO_PIN_5
+
+//Touch sensing. The key, its driven shield and the load reference are on
+//the board, the touch panel keys and slider (TOUCH_PANEL_ENABLE) are on
+//the chassis. Pins are plain masks for the preprocessor.
+#define BOARD_TSL_LOADREF_PORT  BOARD_PORT_C
+#define BOARD_TSL_LOADREF_PIN   0x04  //PC2
+#define BOARD_TSL_KEY_PORT      BOARD_PORT_C
+#define BOARD_TSL_KEY_PIN       0x02  //PC1
+#define BOARD_TSL_SHIELD_PIN    0x08  //PC3
+#define BOARD_TSL_PANEL_PORT    BOARD_PORT_E
+#define BOARD_TSL_PANEL_A_PIN   0x40  //PE6
+#define BOARD_TSL_PANEL_B_PIN   0x80  //PE7
+#define BOARD_TSL_SLIDER_A_PORT BOARD_PORT_B
+#define BOARD_TSL_SLIDER_A_PIN  0x08  //PB3
+#define BOARD_TSL_SLIDER_B_PORT BOARD_PORT_B
+#define BOARD_TSL_SLIDER_B_PIN  0x10  //PB4
+#define BOARD_TSL_SLIDER_C_PORT BOARD_PORT_B
+#define BOARD_TSL_SLIDER_C_PIN  0x20  //PB5
+#define BOARD_TSL_SLIDER_D_PORT BOARD_PORT_E
+#define BOARD_TSL_SLIDER_D_PIN  0x01  //PE0
+#define BOARD_TSL_SLIDER_E_PORT BOARD_PORT_E
+#define BOARD_TSL_SLIDER_E_PIN  0x02  //PE1
+
+#else
+#error Unknown BOARD_PROFILE
+#endif
+
+//Touch sensing electrodes on a port, the key and its shield and, with the
+//touch panel, the panel keys and the slider. The load reference is not an
+//electrode.
+#define BOARD_TSL_ON(port, pinPort, pins)   (((pinPort) == (port)) ? (pins) : 0)
+#define BOARD_TSL_ELECTRODES(port)                                                  \
+    (BOARD_TSL_ON(port, BOARD_TSL_KEY_PORT, BOARD_TSL_KEY_PIN | BOARD_TSL_SHIELD_PIN) | \
+     (TOUCH_PANEL_ENABLE ?                                                          \
+      (BOARD_TSL_ON(port, BOARD_TSL_PANEL_PORT,                                     \
+                    BOARD_TSL_PANEL_A_PIN | BOARD_TSL_PANEL_B_PIN) |                \
+       BOARD_TSL_ON(port, BOARD_TSL_SLIDER_A_PORT, BOARD_TSL_SLIDER_A_PIN) |        \
+       BOARD_TSL_ON(port, BOARD_TSL_SLIDER_B_PORT, BOARD_TSL_SLIDER_B_PIN) |        \
+       BOARD_TSL_ON(port, BOARD_TSL_SLIDER_C_PORT, BOARD_TSL_SLIDER_C_PIN) |        \
+       BOARD_TSL_ON(port, BOARD_TSL_SLIDER_D_PORT, BOARD_TSL_SLIDER_D_PIN) |        \
+       BOARD_TSL_ON(port, BOARD_TSL_SLIDER_E_PORT, BOARD_TSL_SLIDER_E_PIN)) : 0))
+
+#endif
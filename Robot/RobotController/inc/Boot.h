@@ -0,0 +1,39 @@
+/*******************************************************************************
+  * @file Boot.h
+  * @brief Defines the resident boot copier. It runs from the reset vector
+  *        before the C startup and copies an image staged by Ota.c over
+  *        the application, then starts the application through its vector
+  *        table.
+  * @author David Sharpe
+  * @version V1.0.0
+  * @date 14-October-2026
+  *
+  * ST Visual Develop 4.2.1 using STM8 Cosmic C Compiler
+  *****************************************************************************/
+#ifndef BOOT_H
+#define BOOT_H
+
+////////////////////////////////////////////////////////////////////////////////
+// Includes
+////////////////////////////////////////////////////////////////////////////////
+#include "Ota.h"
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Definitions
+////////////////////////////////////////////////////////////////////////////////
+
+//The copier lives in the .boot segment below OTA_APP_START and is never
+//updated over the air, so it may not call anything in the application,
+//the peripheral library included, or use initialised data. Changing it
+//means flashing with the ST-Link.
+#define BOOT_WORD_SIZE          4
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Functions
+////////////////////////////////////////////////////////////////////////////////
+int  Boot_Apply(void);
+void Boot_Reset(void);
+
+#endif
@@ -0,0 +1,39 @@
+/*******************************************************************************
+  * @file Calibration.h
+  * @brief Defines the wheel characterization run that builds the duty
+  *        calibration of each wheel from encoder measurements
+  * @author David Sharpe
+  * @version V1.0.0
+  * @date 14-October-2026
+  *
+  * ST Visual Develop 4.2.1 using STM8 Cosmic C Compiler
+  *****************************************************************************/
+#ifndef CALIBRATION_H
+#define CALIBRATION_H
+
+////////////////////////////////////////////////////////////////////////////////
+// Includes
+////////////////////////////////////////////////////////////////////////////////
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Definitions
+////////////////////////////////////////////////////////////////////////////////
+#define CALIBRATION_PERIOD      10  //ms
+
+//Each calibration point drives both wheels at its duty, waits for the speed
+//to settle through the ramp and the motor lag, then counts encoder edges.
+//The run takes DRIVE_CAL_POINTS times the two, 4s at the defaults.
+#define CALIBRATION_SETTLE_TIME 500 //ms
+#define CALIBRATION_MEASURE_TIME 500 //ms
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Functions
+////////////////////////////////////////////////////////////////////////////////
+void Calibration_Start(void);
+void Calibration_Cancel(void);
+int  Calibration_IsRunning(void);
+void Calibration_Task(void);
+
+#endif
@@ -0,0 +1,56 @@
+/*******************************************************************************
+  * @file Clock.h
+  * @brief Defines the command clock. The controller syncs its clock to the
+  *        robot's tick and may send commands stamped with the time they are
+  *        to run, the robot holds them in a small time ordered queue so the
+  *        jitter of the link does not reach the wheels.
+  * @author David Sharpe
+  * @version V1.0.0
+  * @date 14-October-2026
+  *
+  * ST Visual Develop 4.2.1 using STM8 Cosmic C Compiler
+  *****************************************************************************/
+#ifndef CLOCK_H
+#define CLOCK_H
+
+////////////////////////////////////////////////////////////////////////////////
+// Includes
+////////////////////////////////////////////////////////////////////////////////
+#include "Protocol.h"
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Definitions
+////////////////////////////////////////////////////////////////////////////////
+
+//The controller measures the offset of its clock from the robot's with 
+//PROTO_CLOCK_QUERY round trips, NTP style, and sets it with 
+//PROTO_CLOCK_SET. Timed commands carry controller time, so robots with 
+//different offsets run a broadcast command together. A time already past 
+//runs at once, one more than CLOCK_HORIZON ms ahead is refused.
+#define CLOCK_QUEUE_SIZE    4
+#define CLOCK_VALUE_SIZE    5     //longest command held, a move
+#define CLOCK_HORIZON       2000  //ms
+#define CLOCK_PERIOD        1     //ms, the task running the held commands
+
+typedef struct
+{
+    unsigned long time;     //robot time to run at
+    unsigned char type;
+    unsigned char length;
+    unsigned char value[CLOCK_VALUE_SIZE];
+} ClockEntry;
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Functions
+////////////////////////////////////////////////////////////////////////////////
+void Clock_Initialize(void);
+void Clock_SetOffset(unsigned long offset);
+unsigned long Clock_GetRobotTime(unsigned long time);
+int  Clock_Schedule(unsigned long time, unsigned char type, 
+                    const unsigned char *value, unsigned char length);
+void Clock_Clear(void);
+int  Clock_Run(ProtoHandler handler);
+
+#endif
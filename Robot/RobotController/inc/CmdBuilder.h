@@ -0,0 +1,51 @@
+/*******************************************************************************
+  * @file CmdBuilder.h
+  * @brief Defines the AT command builder. Commands are put together from 
+  *        constant text, which stays in flash, and integers formatted by 
+  *        subtracting powers of ten, so neither sprintf nor a 32-bit divide 
+  *        is needed. A command is built straight into its destination, a 
+  *        command queue slot or a ring, and only published once it is 
+  *        complete.
+  * @author David Sharpe
+  * @version V1.0.0
+  * @date 14-October-2026
+  *
+  * ST Visual Develop 4.2.1 using STM8 Cosmic C Compiler
+  *****************************************************************************/
+#ifndef CMD_BUILDER_H
+#define CMD_BUILDER_H
+
+////////////////////////////////////////////////////////////////////////////////
+// Includes
+////////////////////////////////////////////////////////////////////////////////
+#include "Ring.h"
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Definitions
+////////////////////////////////////////////////////////////////////////////////
+#define CMD_MAX_DIGITS  10 //Longest unsigned long
+
+typedef struct
+{
+    unsigned char *buffer;  //destination
+    unsigned char mask;     //index mask, 0xFF for a plain buffer
+    unsigned char start;    //index of the first byte
+    unsigned char length;   //bytes written so far
+    unsigned char room;     //bytes the destination can take
+    unsigned char overflow; //set once something did not fit
+    Ring *ring;             //ring to publish to, 0 for a plain buffer
+} CmdBuilder;
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Functions
+////////////////////////////////////////////////////////////////////////////////
+void Cmd_Begin(CmdBuilder *cmd, unsigned char *buffer, unsigned char size);
+void Cmd_BeginRing(CmdBuilder *cmd, Ring *ring);
+void Cmd_AppendText(CmdBuilder *cmd, const char *text);
+void Cmd_AppendChar(CmdBuilder *cmd, char c);
+void Cmd_AppendUnsigned(CmdBuilder *cmd, unsigned long value);
+unsigned char Cmd_End(CmdBuilder *cmd);
+
+#endif
@@ -0,0 +1,94 @@
+/*******************************************************************************
+  * @file Config.h
+  * @brief Defines the persistent configuration record kept in data EEPROM
+  * @author David Sharpe
+  * @version V1.0.0
+  * @date 14-October-2026
+  *
+  * ST Visual Develop 4.2.1 using STM8 Cosmic C Compiler
+  *****************************************************************************/
+#ifndef CONFIG_H
+#define CONFIG_H
+
+////////////////////////////////////////////////////////////////////////////////
+// Includes
+////////////////////////////////////////////////////////////////////////////////
+#include "DriveController.h"
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Definitions
+////////////////////////////////////////////////////////////////////////////////
+#define CONFIG_VERSION      5   //Change when the record layout changes
+
+#define CONFIG_NAME_SIZE    20  //Access point name including the terminator
+#define CONFIG_IP_SIZE      16  //Dotted peer address including the terminator
+
+//The 1KB data EEPROM is split into slots and each save goes to the next
+//slot, the valid record with the newest sequence number is loaded
+#define CONFIG_SLOT_SIZE    64
+#define CONFIG_SLOT_COUNT   16
+
+//One word is programmed per run of Config_Task, a word takes up to 6.6ms
+#define CONFIG_WRITE_PERIOD 10 //ms
+
+//Fields set by the remote with PROTO_CMD_CONFIG
+enum ConfigField
+{
+    CONFIG_FIELD_AP_NAME,   //access point name, up to 19 characters
+    CONFIG_FIELD_PEER_IP,   //dotted peer address, up to 15 characters
+    CONFIG_FIELD_PEER_PORT, //16-bit UDP port, LSB first
+    CONFIG_FIELD_BAUD,      //32-bit module baud rate, LSB first, saved at 
+                            //start up with the rate the link settled at
+    CONFIG_FIELD_TRIM,      //left and right wheel output scale, percent
+    CONFIG_FIELD_ACCEL,     //speed ramp step, percent per drive update
+    CONFIG_FIELD_ACK_MODE,  //acknowledgement mode
+    CONFIG_FIELD_FAILSAFE,  //command timeout while moving, 10ms units
+    CONFIG_FIELD_TELEMETRY, //telemetry sample period, 10ms units, 0 is off
+    CONFIG_FIELD_PWM,       //PWM profile, DrivePwmProfile value
+    CONFIG_FIELD_CALIBRATION, //left then right wheel duty calibration, 
+                              //see DRIVE_CAL_POINTS
+    CONFIG_FIELD_ROBOT_ID,  //fleet id, 1 to PROTO_FLEET_ID_MAX
+    CONFIG_FIELD_TELEMETRY_FORMAT, //TelemetryFormat value
+    CONFIG_FIELD_COUNT,
+    CONFIG_FIELD_SAVE = 0xF0,   //write the record to EEPROM
+    CONFIG_FIELD_DEFAULTS       //restore the defaults, not saved
+};
+
+//Configuration record. The network settings are used at start up, the
+//others are applied as soon as they are set. The fields have the same 
+//widths on the host, the record must fit a slot, see Config.c.
+typedef struct
+{
+    unsigned char version;
+    unsigned char sequence;
+    char apName[CONFIG_NAME_SIZE];
+    char peerIp[CONFIG_IP_SIZE];
+    unsigned short peerPort;
+    uint32_t baud;              //stm8s.h width, 32 bits on the host too
+    unsigned char trim[2];
+    unsigned char accel;
+    unsigned char ackMode;
+    unsigned char failsafe;     //10ms units, 0 for the default
+    unsigned char telemetry;    //10ms units, 0 when off
+    unsigned char pwmProfile;   //DrivePwmProfile, 0 for the build default
+    unsigned char calibration[2][DRIVE_CAL_POINTS];
+    unsigned char robotId;      //fleet id, see PROTO_CMD_FLEET
+    unsigned char telemetryFormat; //TelemetryFormat, 0 for full samples
+    unsigned char crc;          //CRC-8 of everything before it
+} ConfigRecord;
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Functions
+////////////////////////////////////////////////////////////////////////////////
+int  Config_Load(void);
+ConfigRecord *Config_Get(void);
+void Config_SetDefaults(void);
+int  Config_SetField(unsigned char field, const unsigned char *value,
+                     unsigned char length);
+int  Config_Save(void);
+int  Config_IsSaving(void);
+void Config_Task(void);
+
+#endif
@@ -1,45 +1,144 @@
-/*******************************************************************************
-  * @file DriveController.h
-  * @brief Defines the functions for controlling the drive motors
-  * @author David Sharpe
-  * @version V1.0.0
-  * @date 02-June-2015
-  *
-  * ST Visual Develop 4.2.1 using STM8 Cosmic C Compiler
-  *****************************************************************************/
-#ifndef DRIVE_CONTROLLER_H
-#define DRIVE_CONTROLLER_H
-
-////////////////////////////////////////////////////////////////////////////////
-// Includes
-////////////////////////////////////////////////////////////////////////////////
-
-
-////////////////////////////////////////////////////////////////////////////////
-// Definitions
-////////////////////////////////////////////////////////////////////////////////
-enum Directions
-{
-    STOP,          
-    FORWARD,       
-    BACKWARD, 
-    LEFT,
-    SHARP_LEFT,    
-    RIGHT,         
-    SHARP_RIGHT        
-};
-
-#define SPEED_STOP    0
-#define SPEED_FULL    100
-
-////////////////////////////////////////////////////////////////////////////////
-// Functions
-////////////////////////////////////////////////////////////////////////////////
-void DriveCtrl_Initialize(void);
-void DriveCtrl_SetSpeed(unsigned char percentSpeed);
-void DriveCtrl_Stop(void);
-void DriveCtrl_Forward(void);
-void DriveCtrl_Backward(void);
-void DriveCtrl_Turn(unsigned char direction);
-
+/*******************************************************************************
+  * @file DriveController.h
+  * @brief Defines the functions for controlling the drive motors
+  * @author David Sharpe
+  * @version V1.0.0
+  * @date 02-June-2015
+  *
+  * ST Visual Develop 4.2.1 using STM8 Cosmic C Compiler
+  *****************************************************************************/
+#ifndef DRIVE_CONTROLLER_H
+#define DRIVE_CONTROLLER_H
+
+////////////////////////////////////////////////////////////////////////////////
+// Includes
+////////////////////////////////////////////////////////////////////////////////
+#include "stm8s.h"
+#include "Board.h"
+
+////////////////////////////////////////////////////////////////////////////////
+// Definitions
+////////////////////////////////////////////////////////////////////////////////
+enum Directions
+{
+    STOP,          
+    FORWARD,       
+    BACKWARD, 
+    LEFT,
+    SHARP_LEFT,    
+    RIGHT,         
+    SHARP_RIGHT        
+};
+
+#define SPEED_STOP    0
+#define SPEED_FULL    100
+
+//Motors, the id every per motor function takes and the index of its pins
+#define MOTOR_LEFT    0
+#define MOTOR_RIGHT   1
+#define MOTOR_COUNT   2
+
+//PWM profiles, frequency and duty steps from the 16MHz timer clock. The 
+//default is the build's DRIVE_PWM_PROFILE, a saved configuration can pick 
+//another to suit the motors and driver.
+enum DrivePwmProfile
+{
+    DRIVE_PWM_DEFAULT,
+    DRIVE_PWM_16KHZ,        //1000 steps
+    DRIVE_PWM_20KHZ,        //800 steps, above hearing
+    DRIVE_PWM_32KHZ,        //500 steps, less switching ripple in the current
+    DRIVE_PWM_2KHZ,         //8000 steps, for slow switching drivers
+    DRIVE_PWM_PROFILE_COUNT
+};
+
+#ifndef DRIVE_PWM_PROFILE
+#define DRIVE_PWM_PROFILE    DRIVE_PWM_16KHZ
+#endif
+
+//Duty calibration, each wheel has the duty percent that gives the common
+//speed at 25, 50, 75 and 100% and the commands in between are interpolated.
+//An uncalibrated table holds the points themselves.
+#define DRIVE_CAL_POINTS     4
+#define DRIVE_CAL_STEP       (SPEED_FULL / DRIVE_CAL_POINTS)
+
+//Speed ramp. The ramp advances every DRIVE_UPDATE_PERIOD ms by at most 
+//DRIVE_ACCEL_DEFAULT percent, 0 to full speed takes 200ms.
+#define DRIVE_UPDATE_PERIOD  10 //ms
+#define DRIVE_ACCEL_DEFAULT  5  //percent per update
+
+//Wheel velocity control, velocities are encoder edges per second. The PI 
+//gains are Q8 fixed point and give the duty percentage, the integral is 
+//summed once per update.
+#define DRIVE_VELOCITY_MAX   1000
+#define DRIVE_VELOCITY_KP    26
+#define DRIVE_VELOCITY_KI    3
+
+//Distance and turn moves slow down to DRIVE_MOVE_GAIN edges/s for each 
+//edge left to go, but not below DRIVE_MOVE_MIN_VELOCITY
+#define DRIVE_MOVE_GAIN          3
+#define DRIVE_MOVE_MIN_VELOCITY  40
+
+//Reflex stop. With an obstacle ahead the forward speed is held to 1% for 
+//each DRIVE_REFLEX_MM_PER_PERCENT mm of range past DRIVE_REFLEX_MARGIN, so
+//the faster the command the further out the robot starts to slow. Full 
+//speed needs 500mm.
+#define DRIVE_REFLEX_MARGIN          100 //mm
+#define DRIVE_REFLEX_MM_PER_PERCENT  4
+
+//Overcurrent trip. The current sense comparator pulls PE3 low while the 
+//motors draw more than the driver is rated for. Its falling edge puts both
+//H-bridges to STOP from the interrupt, without waiting for the drive update
+//or the PWM period, so the bridges stop within the interrupt latency. The
+//trip is counted and the speed folded back at the next drive update, up to
+//one control tick, DRIVE_UPDATE_PERIOD ms, later. The wheels start again 
+//from a stop after DRIVE_TRIP_RETRY ms with the speed limit folded back 
+//DRIVE_TRIP_FOLDBACK percent for each trip, and a step of it is given back
+//for every DRIVE_TRIP_RECOVER ms without one. DRIVE_TRIP_LATCH trips before
+//the fold back is all given back hold the motors off until the commands 
+//stop. PE3 is also the TIM1 break input, kept for a board with the PWM on 
+//TIM1.
+#ifndef DRIVE_TRIP_ENABLE
+#define DRIVE_TRIP_ENABLE    1
+#endif
+#define DRIVE_TRIP_PORT      BOARD_TRIP_PORT
+#define DRIVE_TRIP_PIN       BOARD_TRIP_PIN
+#define DRIVE_TRIP_EXTI      BOARD_TRIP_EXTI
+#define DRIVE_TRIP_RETRY     200  //ms
+#define DRIVE_TRIP_FOLDBACK  25   //percent per trip
+#define DRIVE_TRIP_RECOVER   1000 //ms
+#define DRIVE_TRIP_LATCH     3
+
+////////////////////////////////////////////////////////////////////////////////
+// Functions
+////////////////////////////////////////////////////////////////////////////////
+void DriveCtrl_Initialize(void);
+void DriveCtrl_SetSpeed(unsigned char percentSpeed);
+void DriveCtrl_SetWheelDuty(signed char left, signed char right);
+void DriveCtrl_SetTwist(signed char speed, signed char turn);
+void DriveCtrl_SetWheelVelocity(signed short left, signed short right);
+void DriveCtrl_DriveDistance(signed short mm, unsigned short velocity);
+void DriveCtrl_TurnAngle(signed short degrees, unsigned short velocity);
+int  DriveCtrl_IsMoveActive(void);
+void DriveCtrl_SetAcceleration(unsigned char step);
+unsigned char DriveCtrl_GetAcceleration(void);
+void DriveCtrl_SetSpeedLimit(unsigned char percent);
+unsigned char DriveCtrl_GetSpeedLimit(void);
+void DriveCtrl_SetTrim(unsigned char left, unsigned char right);
+void DriveCtrl_SetCalibration(const unsigned char *left, 
+                              const unsigned char *right);
+void DriveCtrl_SetPwmProfile(unsigned char profile);
+unsigned char DriveCtrl_GetPwmProfile(void);
+void DriveCtrl_Update(void);
+void DriveCtrl_PwmISR(void);
+void DriveCtrl_TripISR(void);
+unsigned short DriveCtrl_GetTripCount(void);
+int  DriveCtrl_IsMoving(void);
+signed char DriveCtrl_GetDuty(unsigned char motor);
+unsigned long DriveCtrl_GetSwitchTime(void);
+void DriveCtrl_EmergencyStop(void);
+void DriveCtrl_Stop(void);
+void DriveCtrl_Forward(void);
+void DriveCtrl_Backward(void);
+void DriveCtrl_Turn(unsigned char direction);
+
 #endif
\ No newline at end of file
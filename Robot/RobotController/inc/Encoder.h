@@ -0,0 +1,46 @@
+/*******************************************************************************
+  * @file Encoder.h
+  * @brief Defines the functions for reading the wheel encoders
+  * @author David Sharpe
+  * @version V1.0.0
+  * @date 14-October-2026
+  *
+  * ST Visual Develop 4.2.1 using STM8 Cosmic C Compiler
+  *****************************************************************************/
+#ifndef ENCODER_H
+#define ENCODER_H
+
+////////////////////////////////////////////////////////////////////////////////
+// Includes
+////////////////////////////////////////////////////////////////////////////////
+#include "Board.h"
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Definitions
+////////////////////////////////////////////////////////////////////////////////
+
+//Encoder inputs, one channel per wheel on the port with the EXTI interrupt
+#define ENCODER_PORT         BOARD_ENCODER_PORT
+#define ENCODER_EXTI         BOARD_ENCODER_EXTI
+#define ENCODER_LEFT_PIN     BOARD_ENCODER_LEFT
+#define ENCODER_RIGHT_PIN    BOARD_ENCODER_RIGHT
+
+#define ENCODER_LEFT         0
+#define ENCODER_RIGHT        1
+#define ENCODER_COUNT        2
+
+#define ENCODER_MIN_PERIOD   100   //us, shorter edge periods are noise
+#define ENCODER_TIMEOUT      50000 //us without an edge means stopped
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Functions
+////////////////////////////////////////////////////////////////////////////////
+void Encoder_Initialize(void);
+void Encoder_Update(void);
+unsigned short Encoder_GetVelocity(unsigned char encoder);
+unsigned short Encoder_GetCount(unsigned char encoder);
+void Encoder_ISR(void);
+
+#endif
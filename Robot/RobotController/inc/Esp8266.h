@@ -1,70 +1,394 @@
-/*******************************************************************************
-  * @file Esp8266.h
-  * @brief Defines the functions for interfacing to ESP8266 WIFI chip
-  * @author David Sharpe
-  * @version V1.0.0
-  * @date 02-June-2015
-  *
-  * ST Visual Develop 4.2.1 using STM8 Cosmic C Compiler
-  *****************************************************************************/
-#ifndef ESP_8266_H
-#define ESP_8266_H
-
-////////////////////////////////////////////////////////////////////////////////
-// Includes
-////////////////////////////////////////////////////////////////////////////////
-
-
-////////////////////////////////////////////////////////////////////////////////
-// Definitions
-////////////////////////////////////////////////////////////////////////////////
-#define ESP8266_BAUD            115200
-
-#define ESP8266_RX_BUFFER_SIZE  64
-
-#define ESP8266_SERVER_TIMEOUT  300 //seconds
-
-#define ESP8266_UDP             "UDP"
-#define ESP8266_TCP             "TCP"
-
-#define TIMEOUT_LONG            0xFFFFFFFF
-#define TIMEOUT_SHORT           0x00FFFFFF
-
-
-enum RxState
-{
-    ESP8266_RESET,
-    ESP8266_GET_READY,
-    ESP8266_GET_OK,
-    ESP8266_GET_RX_HEADER,
-    ESP8266_GET_RX_PACKET_SIZE,
-    ESP8266_GET_RX_PACKET,
-    ESP8266_GET_TX
-};
-
-//Status word bits
-#define ESP8266_OK_MESSAGE        0x01
-#define ESP8266_READY_MESSAGE     0x02
-#define ESP8266_TX_READY_MESSAGE  0x04
-#define ESP8266_RX_PACKET_MESSAGE 0x08
-
-
-////////////////////////////////////////////////////////////////////////////////
-// Functions
-////////////////////////////////////////////////////////////////////////////////
-void Esp8266_Initialize(void);
-void Esp8266_Validate(void);
-void Esp8266_Reset(void);
-void Esp8266_SetAccessPointName(const char *name);
-void Esp8266_DisableEcho(void);
-void Esp8266_StartClient(const char *type, const char *ip, 
-                         const unsigned short port);
-void Esp8266_StartTcpServer(const unsigned short port);
-void Esp8266_SetTcpServerTimeout(const unsigned short seconds);
-void Esp8266_GetRemoteClientIp();
-void Esp8266_SendMsg(unsigned char *buffer, unsigned short length);
-int  Esp8266_ReceiveMsg(unsigned char *packet);
-void Esp8266_ProcessRxByte(unsigned char byte);
-int  WaitForResponse(unsigned char msgType, unsigned long timeout);
-
+/*******************************************************************************
+  * @file Esp8266.h
+  * @brief Defines the functions for interfacing to ESP8266 WIFI chip
+  * @author David Sharpe
+  * @version V1.0.0
+  * @date 02-June-2015
+  *
+  * ST Visual Develop 4.2.1 using STM8 Cosmic C Compiler
+  *****************************************************************************/
+#ifndef ESP_8266_H
+#define ESP_8266_H
+
+////////////////////////////////////////////////////////////////////////////////
+// Includes
+////////////////////////////////////////////////////////////////////////////////
+#include "Board.h"
+
+////////////////////////////////////////////////////////////////////////////////
+// Definitions
+////////////////////////////////////////////////////////////////////////////////
+#define ESP8266_BAUD            115200 //Module default, restored on reset
+
+//Set to 1 to raise the baud rate at start up. Each rate is set with 
+//AT+UART_CUR, which the module forgets on reset, and checked with AT before
+//it is used. A rate that fails is left and the next one tried, the rate the
+//link settles at is saved and tried first next time.
+#define ESP8266_BAUD_NEGOTIATE  1
+#define ESP8266_BAUD_RATES      {460800, 230400} //Fastest first
+#define ESP8266_VERIFY_COUNT    3  //AT probes at a new rate before giving up
+
+#define ESP8266_RX_BUFFER_SIZE  64
+#define ESP8266_RX_PACKET_COUNT 4  //Receive packet pool slots
+#define ESP8266_RX_MAX_DIGITS   4  //+IPD length digits, module max is 2048
+#define ESP8266_RX_HOLD_FREE    1  //Free slots left when the module is held,
+                                   //see UART_FLOW_CONTROL
+#define ESP8266_RX_PRIORITY_SIZE 16 //Control packets up to this size that
+                                    //find the pool full are still shown to
+                                    //the priority callback, then dropped
+
+//The RX interrupt only queues bytes, they are parsed from the main loop in
+//bursts of ESP8266_RX_BURST. With ESP8266_RX_HIGH_WATER or more waiting the
+//ring is drained in one go so it cannot overflow behind a long burst.
+#define ESP8266_RX_BURST        32 //bytes parsed per main loop pass
+#define ESP8266_RX_HIGH_WATER   64 //bytes waiting that force a full drain
+
+#define ESP8266_SERVER_TIMEOUT  300 //seconds
+#define ESP8266_SERVER_PORT     49999
+
+#define ESP8266_UDP             "UDP"
+#define ESP8266_TCP             "TCP"
+
+#define TIMEOUT_LONG            5000 //ms
+#define TIMEOUT_SHORT           1000 //ms
+
+//Start up probe, the module takes a few hundred ms to boot
+#define ESP8266_PROBE_INTERVAL  50 //ms between AT probes
+#define ESP8266_PROBE_COUNT     60 //probes before giving up
+
+//AT command queue depth and per command storage
+#define ESP8266_CMD_QUEUE_SIZE  8
+#define ESP8266_CMD_BUFFER_SIZE 56 //Longest is CIPSTART with a 15 character IP
+
+//Response events. The parser queues one for each response token in the 
+//order the module sent them, the command queue or the send pipeline, 
+//whichever is waiting, takes them one at a time. A response sent twice is 
+//seen twice, and a response nothing was waiting for is dropped when the 
+//next command or datagram starts.
+#define ESP8266_EVENT_COUNT     8  //holds one less
+
+//Outgoing datagram queue depth and maximum datagram size
+#define ESP8266_TX_PACKET_COUNT 4
+#define ESP8266_TX_PACKET_SIZE  56 //Fits a full telemetry batch and the pose
+
+#define ESP8266_BUSY_BACKOFF    5  //ms to wait before retrying CIPSEND on busy
+
+//Connection table. The client is started on ESP8266_PRIMARY_LINK, the phone
+//in control. Any other link that connects is an observer: its frames are 
+//not obeyed and it is sent a copy of the telemetry. Observer datagrams are 
+//kept once in their own queue with the links still to send to, so they 
+//are only sent while nothing is waiting for the primary link.
+#define ESP8266_MAX_LINKS       5  //Module limit in multiple connection mode
+#define ESP8266_PRIMARY_LINK    1
+#define ESP8266_OBSERVER_COUNT  2  //Observer datagram queue depth
+
+//Bulk lane. Observers connect to the TCP server and may ask for reports and
+//upload configuration over it. The replies are a byte stream to one link at
+//a time, sent ESP8266_BULK_CHUNK bytes per CIPSEND when nothing else is 
+//waiting, so a control datagram waits behind one chunk at most.
+#define ESP8266_BULK_BUFFER_SIZE 64 //Power of 2, see RING_DEFINE
+#define ESP8266_BULK_CHUNK       32 //bytes per CIPSEND
+
+//Set to 1 to run the client link in transparent (passthrough) mode. Data is
+//exchanged as raw bytes without CIPSEND or +IPD headers. Datagrams sent 
+//within 20ms of each other may be merged by the module, the application 
+//framing must allow for it.
+#define ESP8266_TRANSPARENT     0
+
+#define ESP8266_ESCAPE_GUARD    50   //ms of quiet line before "+++"
+#define ESP8266_ESCAPE_WAIT     1000 //ms after "+++" before AT commands
+
+//Link profiles trade latency for power, see LinkProfile. Low latency turns
+//sleep off and sets full transmit power. Idle allows modem sleep, which the
+//module only uses while it is a station, and cuts the transmit power, which
+//saves power as an access point too. With ESP8266_AUTO_PROFILE the link 
+//goes idle after ESP8266_IDLE_TIMEOUT ms without a datagram from the 
+//controller and the next one wakes it. Not in transparent mode, where AT
+//commands wait until passthrough is left.
+#define ESP8266_AUTO_PROFILE    1
+#define ESP8266_IDLE_TIMEOUT    30000 //ms
+#define ESP8266_FULL_RFPOWER    82 //0.25dBm steps, 20.5dBm
+#define ESP8266_IDLE_RFPOWER    40 //10dBm
+
+//Set to 1 to follow the controller to whatever address it has. With 
+//AT+CIPDINFO=1 the +IPD header also has the sender's address and port, and 
+//a valid frame from anywhere other than the client's peer moves the client 
+//link to it, see Esp8266_FollowPeer. The configured peer is only where the 
+//link starts. Not in transparent mode, which has no +IPD header.
+#define ESP8266_PEER_DISCOVERY  1
+#define ESP8266_ADDRESS_SIZE    4 //IPv4
+
+//Set to 1 to watch the module once the link is up. A missed deadline, a 
+//CIPSEND without its prompt or SEND OK or an AT command without an answer,
+//is a fault, and so is an Esp8266_Probe left unanswered, which main sends
+//when the failsafe finds the controller silent. 
+//Recovery steps up: AT to resync, then the client link is closed and 
+//started again, then the module is reset and set up again. A module that 
+//does not answer the resync is reset, a fault within ESP8266_SETTLE_TIME of 
+//a recovery starts at the step after the one that recovered. Not in 
+//transparent mode, where the module does not answer.
+#define ESP8266_HEALTH_MONITOR  1
+#define ESP8266_RESYNC_COUNT    3    //AT probes before the reset
+#define ESP8266_SETTLE_TIME     2000 //ms a recovery must hold
+#define ESP8266_RESET_RETRY     5000 //ms between resets of a dead module
+
+//Module link, see BOARD_ESP8266_SPI. With the SPI link the module runs the
+//SPI link firmware in place of the AT firmware, see Esp8266Spi.c. The 
+//functions are the same for both but for the AT command queue, the baud 
+//rate and passthrough, which only the AT firmware has.
+#define ESP8266_SPI_LINK        BOARD_ESP8266_SPI
+
+//SPI link transactions, the module's HSPI slave commands. Data goes both
+//ways in chunks, each command byte is followed by a 0 address byte and the
+//chunk. The status word is read with no address.
+#define ESP8266_SPI_WRITE_DATA  0x02
+#define ESP8266_SPI_READ_DATA   0x03
+#define ESP8266_SPI_READ_STATUS 0x04
+#define ESP8266_SPI_CHUNK_SIZE  32
+#define ESP8266_SPI_STATUS_SIZE 4
+
+//SPI link chunk
+//  type        ESP8266_SPI_ value, with ESP8266_SPI_MORE when the datagram
+//              goes on in the next chunk, ESP8266_SPI_CONTINUED on every 
+//              chunk after its first and, from the module, 
+//              ESP8266_SPI_FOREIGN when it is not from the client's peer
+//  link        link id the datagram is for or from, ESP8266_SPI_OBSERVERS
+//              for every observer
+//  length      payload bytes
+//  payload     ESP8266_SPI_PAYLOAD_SIZE bytes
+//  check       complement of the sum of the bytes before it, so a chunk of
+//              all ones or all zeros fails
+#define ESP8266_SPI_PAYLOAD_SIZE (ESP8266_SPI_CHUNK_SIZE - 4)
+#define ESP8266_SPI_NONE        0x00
+#define ESP8266_SPI_DATAGRAM    0x01
+#define ESP8266_SPI_CONFIG      0x02 //to the module, the payload starts
+                                     //with an ESP8266_SPI_SET_ value
+#define ESP8266_SPI_MORE        0x80
+#define ESP8266_SPI_FOREIGN     0x40
+#define ESP8266_SPI_CONTINUED   0x20
+#define ESP8266_SPI_TYPE_MASK   0x0F
+#define ESP8266_SPI_OBSERVERS   0xFF
+
+//SPI link status word, the module keeps it up to date and raises its ready
+//output whenever it changes or a chunk is waiting to be read
+//  flags       ESP8266_SPI_STATUS_ bits
+//  credit      chunks the module has room for
+//  links       bit mask of the connected link ids
+//  session     picked at random as the module boots, a new one means it 
+//              must be set up again
+#define ESP8266_SPI_STATUS_MARK 0x80 //always set, with 0x40 always clear
+#define ESP8266_SPI_STATUS_DATA 0x01 //a chunk is waiting to be read
+#define ESP8266_SPI_STATUS_FAIL 0x02 //a datagram failed since the last read
+
+//SPI link set up, in the order they are sent
+//  AP_NAME     name
+//  CLIENT      ESP8266_SPI_UDP or ESP8266_SPI_TCP, peer port LSB first, 
+//              peer address as text
+//  SERVER      port LSB first
+//  PROFILE     LinkProfile value, transmit power
+//  FOLLOW      move the client link to the sender of the latest 
+//              ESP8266_SPI_FOREIGN datagram
+#define ESP8266_SPI_SET_AP_NAME 0x01
+#define ESP8266_SPI_SET_CLIENT  0x02
+#define ESP8266_SPI_SET_SERVER  0x04
+#define ESP8266_SPI_SET_PROFILE 0x08
+#define ESP8266_SPI_SET_FOLLOW  0x10
+#define ESP8266_SPI_UDP         0
+#define ESP8266_SPI_TCP         1
+
+
+enum RxState
+{
+    ESP8266_MATCH,
+    ESP8266_GET_RX_PACKET_SIZE,
+    ESP8266_GET_RX_PACKET,
+    ESP8266_SKIP_RX_PACKET,
+    ESP8266_GET_PRIORITY_PACKET,
+    ESP8266_GET_RAW_PACKET,
+    ESP8266_SKIP_RAW_PACKET,
+    ESP8266_CHECK_AP_NAME,
+    ESP8266_GET_RX_PEER,    //after the others, so their traced values stay
+    ESP8266_GET_LINK_STATUS
+};
+
+enum CmdState
+{
+    ESP8266_CMD_IDLE,
+    ESP8266_CMD_WAIT_RESPONSE
+};
+
+//Datagram send pipeline states
+enum SendState
+{
+    ESP8266_SEND_IDLE,
+    ESP8266_SEND_WAIT_PROMPT,
+    ESP8266_SEND_WAIT_SENT,
+    ESP8266_SEND_BACKOFF,
+    ESP8266_SEND_ESCAPE_GUARD,
+    ESP8266_SEND_ESCAPE_WAIT
+};
+
+//Send pipeline lanes, in priority order
+enum SendLane
+{
+    ESP8266_LANE_PRIMARY,
+    ESP8266_LANE_OBSERVER,
+    ESP8266_LANE_BULK
+};
+
+//Passthrough states
+enum Passthrough
+{
+    ESP8266_PASSTHROUGH_OFF,
+    ESP8266_PASSTHROUGH_ENTERING,
+    ESP8266_PASSTHROUGH_ON,
+    ESP8266_PASSTHROUGH_ESCAPING
+};
+
+//AT command completion results
+enum AtResult
+{
+    ESP8266_AT_OK,
+    ESP8266_AT_TIMEOUT,
+    ESP8266_AT_ERROR
+};
+
+//Link profiles
+enum LinkProfile
+{
+    ESP8266_PROFILE_LOW_LATENCY,
+    ESP8266_PROFILE_IDLE,
+    ESP8266_PROFILE_NONE    //not set since start up
+};
+
+//Link status
+enum LinkStatus
+{
+    ESP8266_LINK_DOWN,
+    ESP8266_LINK_READY,
+    ESP8266_LINK_ERROR
+};
+
+//Health monitor recovery steps, in the order they are tried
+enum HealthStep
+{
+    ESP8266_HEALTH_OK,
+    ESP8266_HEALTH_RESYNC,
+    ESP8266_HEALTH_RELINK,
+    ESP8266_HEALTH_RESET
+};
+
+//SPI link transaction in flight
+enum SpiTransaction
+{
+    ESP8266_SPI_XFER_IDLE,
+    ESP8266_SPI_XFER_STATUS,
+    ESP8266_SPI_XFER_READ,
+    ESP8266_SPI_XFER_WRITE
+};
+
+//Connection table roles
+enum LinkRole
+{
+    ESP8266_ROLE_NONE,
+    ESP8266_ROLE_PRIMARY,
+    ESP8266_ROLE_OBSERVER
+};
+
+//Response classes, the events each token stands for. An AT command 
+//completes on an event of its response class.
+#define ESP8266_OK_MESSAGE        0x01
+#define ESP8266_READY_MESSAGE     0x02
+#define ESP8266_TX_READY_MESSAGE  0x04
+#define ESP8266_ERROR_MESSAGE     0x08  //ERROR or FAIL
+#define ESP8266_SEND_OK_MESSAGE   0x10
+#define ESP8266_SEND_FAIL_MESSAGE 0x20
+#define ESP8266_BUSY_MESSAGE      0x40
+#define ESP8266_CONNECT_MESSAGE   0x80
+
+//Response event
+typedef struct
+{
+    unsigned char token;    //ESP8266_TOKEN_ value, see Esp8266Matcher.h
+    unsigned char link;     //link id in front of it, ESP8266_MAX_LINKS if none
+    unsigned short time;    //Sched_GetMicros when it was parsed
+} Esp8266Event;
+
+typedef void(*AtCallback)(unsigned char result);
+typedef void(*SendCallback)(unsigned char result, unsigned short micros);
+typedef void(*BaudCallback)(unsigned long baud);
+typedef void(*PacketCallback)(const unsigned char *packet, unsigned char length, 
+                              unsigned short micros);
+
+//Queued AT command
+typedef struct
+{
+    unsigned char data[ESP8266_CMD_BUFFER_SIZE];
+    unsigned char cmdLength;
+    unsigned char response;
+    unsigned short timeout;
+    AtCallback callback;
+} AtCommand;
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Functions
+////////////////////////////////////////////////////////////////////////////////
+void Esp8266_Initialize(unsigned long baud);
+void Esp8266_SetWarmStart(void);
+void Esp8266_SetAccessPointName(const char *name);
+void Esp8266_StartClient(const char *type, const char *ip, 
+                         const unsigned short port);
+void Esp8266_StartTcpServer(const unsigned short port);
+int  Esp8266_SendMsg(const unsigned char *buffer, unsigned short length);
+int  Esp8266_SendObservers(const unsigned char *buffer, unsigned short length);
+int  Esp8266_SendBulk(unsigned char link, const unsigned char *buffer, 
+                      unsigned char length);
+unsigned char Esp8266_GetLinkRole(unsigned char link);
+int  Esp8266_SetLinkProfile(unsigned char profile);
+unsigned char Esp8266_GetLinkProfile(void);
+unsigned char Esp8266_AcquirePacket(const unsigned char **packet);
+unsigned short Esp8266_GetPacketTime(void);
+unsigned char Esp8266_GetPacketLink(void);
+int  Esp8266_FollowPeer(void);
+void Esp8266_ReleasePacket(void);
+int  Esp8266_IsRxIdle(void);
+unsigned short Esp8266_GetRxPacketCount(void);
+unsigned short Esp8266_GetRxDropCount(void);
+unsigned short Esp8266_GetRxOversizeCount(void);
+unsigned short Esp8266_GetTxFailCount(void);
+unsigned short Esp8266_GetBusyCount(void);
+void Esp8266_Probe(void);
+unsigned short Esp8266_GetRecoveryCount(void);
+unsigned char Esp8266_GetHealth(void);
+void Esp8266_SetSendCallback(SendCallback callback);
+void Esp8266_SetBaudCallback(BaudCallback callback);
+void Esp8266_SetPriorityCallback(PacketCallback callback);
+int  Esp8266_ProcessRx(void);
+int  Esp8266_Process(void);
+int  Esp8266_IsBusy(void);
+unsigned char Esp8266_GetLinkStatus(void);
+unsigned long Esp8266_GetLinkUpTime(void);
+
+//SPI link firmware only
+#if ESP8266_SPI_LINK
+void Esp8266_ReadyISR(void);
+#endif
+
+//AT firmware only
+#if !ESP8266_SPI_LINK
+void Esp8266_Validate(void);
+void Esp8266_Reset(void);
+void Esp8266_DisableEcho(void);
+void Esp8266_SetTcpServerTimeout(const unsigned short seconds);
+void Esp8266_GetRemoteClientIp();
+void Esp8266_ExitPassthrough(void);
+int  Esp8266_IsPassthrough(void);
+void Esp8266_ProcessRxByte(unsigned char byte);
+unsigned long Esp8266_GetBaud(void);
+int  Esp8266_QueueCommand(const char *cmd, unsigned char length, 
+                          unsigned char response, unsigned short timeout, 
+                          AtCallback callback);
+#endif
+
 #endif
\ No newline at end of file
@@ -0,0 +1,40 @@
+/*******************************************************************************
+  * @file Esp8266Matcher.h
+  * @brief ESP8266 response matcher tables
+  *
+  * Generated by tools/GenerateEsp8266Matcher.py, do not edit
+  *****************************************************************************/
+#ifndef ESP_8266_MATCHER_H
+#define ESP_8266_MATCHER_H
+
+////////////////////////////////////////////////////////////////////////////////
+// Definitions
+////////////////////////////////////////////////////////////////////////////////
+#define ESP8266_MATCH_STATES   84
+#define ESP8266_MATCH_CLASSES  33
+
+//Tokens reported by the matcher
+enum MatchToken
+{
+    ESP8266_TOKEN_NONE,
+    ESP8266_TOKEN_OK,
+    ESP8266_TOKEN_ERROR,
+    ESP8266_TOKEN_FAIL,
+    ESP8266_TOKEN_READY,
+    ESP8266_TOKEN_SEND_OK,
+    ESP8266_TOKEN_SEND_FAIL,
+    ESP8266_TOKEN_BUSY,
+    ESP8266_TOKEN_TX_READY,
+    ESP8266_TOKEN_RX_HEADER,
+    ESP8266_TOKEN_CONNECT,
+    ESP8266_TOKEN_CLOSED,
+    ESP8266_TOKEN_AP_NAME,
+    ESP8266_TOKEN_LINK_STATUS
+};
+
+//Next state = ESP8266_MATCH_NEXT[state][ESP8266_MATCH_CLASS[byte]]
+extern const unsigned char ESP8266_MATCH_CLASS[256];
+extern const unsigned char ESP8266_MATCH_NEXT[ESP8266_MATCH_STATES][ESP8266_MATCH_CLASSES];
+extern const unsigned char ESP8266_MATCH_TOKEN[ESP8266_MATCH_STATES];
+
+#endif
\ No newline at end of file
@@ -0,0 +1,44 @@
+/*******************************************************************************
+  * @file Failsafe.h
+  * @brief Defines the command failsafe that stops the robot when the remote
+  *        goes quiet
+  * @author David Sharpe
+  * @version V1.0.0
+  * @date 14-October-2026
+  *
+  * ST Visual Develop 4.2.1 using STM8 Cosmic C Compiler
+  *****************************************************************************/
+#ifndef FAILSAFE_H
+#define FAILSAFE_H
+
+////////////////////////////////////////////////////////////////////////////////
+// Includes
+////////////////////////////////////////////////////////////////////////////////
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Definitions
+////////////////////////////////////////////////////////////////////////////////
+
+//The remote sends a keepalive every 100ms while driving, the default window
+//allows two of them to be lost
+#define FAILSAFE_TIMEOUT_DEFAULT    300  //ms
+#define FAILSAFE_TIMEOUT_MIN        50   //ms
+#define FAILSAFE_PERIOD             10   //ms
+
+//Worst case from the last accepted frame to both wheels stopped is the
+//timeout plus FAILSAFE_PERIOD plus the ramp down from full speed, 510ms at
+//the defaults
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Functions
+////////////////////////////////////////////////////////////////////////////////
+void Failsafe_Initialize(void);
+void Failsafe_SetTimeout(unsigned short ms);
+void Failsafe_Feed(void);
+void Failsafe_Task(void);
+unsigned short Failsafe_GetTrips(void);
+unsigned short Failsafe_GetWorstStop(void);
+
+#endif
@@ -0,0 +1,88 @@
+/*******************************************************************************
+  * @file FastIo.h
+  * @brief Inline register access for the peripheral calls on the hot paths,
+  *        the UART and SPI data registers, the scheduler and range timer
+  *        reads, the PWM compares, the GPIO writes and the watchdog reload.
+  *        Each is a one or two instruction register operation that the
+  *        library makes a call with its parameter checks.
+  *
+  *        The release profiles set FAST_IO_ENABLE. The macros take the
+  *        library names, so a module including this header gets them in
+  *        place of the calls while the library stays built for the cold
+  *        initialisation code. Include it after stm8s.h.
+  * @author David Sharpe
+  * @version V1.0.0
+  * @date 14-October-2026
+  *
+  * ST Visual Develop 4.2.1 using STM8 Cosmic C Compiler
+  *****************************************************************************/
+#ifndef FAST_IO_H
+#define FAST_IO_H
+
+////////////////////////////////////////////////////////////////////////////////
+// Includes
+////////////////////////////////////////////////////////////////////////////////
+#include "stm8s.h"
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Definitions
+////////////////////////////////////////////////////////////////////////////////
+
+//Set to 1 to replace the library calls below with register access, set by
+//the release profiles of the STVD and EWSTM8 projects
+#ifndef FAST_IO_ENABLE
+#define FAST_IO_ENABLE  0
+#endif
+
+#if FAST_IO_ENABLE
+
+#define UART2_SendData8(data)       (UART2->DR = (uint8_t)(data))
+#define UART2_ReceiveData8()        ((uint8_t)UART2->DR)
+
+#define SPI_SendData(data)          (SPI->DR = (uint8_t)(data))
+#define SPI_ReceiveData()           ((uint8_t)SPI->DR)
+
+#define TIM1_ClearITPendingBit(it)  (TIM1->SR1 = (uint8_t)~(uint8_t)(it))
+
+//The high byte is read or written first, it latches the low byte
+#define TIM2_SetCompare1(compare)                                             \
+    do {                                                                      \
+        TIM2->CCR1H = (uint8_t)((compare) >> 8);                              \
+        TIM2->CCR1L = (uint8_t)(compare);                                     \
+    } while(0)
+
+#define TIM2_SetCompare2(compare)                                             \
+    do {                                                                      \
+        TIM2->CCR2H = (uint8_t)((compare) >> 8);                              \
+        TIM2->CCR2L = (uint8_t)(compare);                                     \
+    } while(0)
+
+#define GPIO_WriteHigh(port, pins)      ((port)->ODR |= (uint8_t)(pins))
+#define GPIO_WriteLow(port, pins)       ((port)->ODR &= (uint8_t)~(uint8_t)(pins))
+#define GPIO_WriteReverse(port, pins)   ((port)->ODR ^= (uint8_t)(pins))
+
+#define IWDG_ReloadCounter()        (IWDG->KR = IWDG_KEY_REFRESH)
+
+//16-bit timer reads, statements so the high byte is read first. The order
+//of the two reads in one expression would be up to the compiler.
+#define FAST_TIM1_COUNTER(value)                                              \
+    do {                                                                      \
+        (value) = (unsigned short)TIM1->CNTRH << 8;                           \
+        (value) |= TIM1->CNTRL;                                               \
+    } while(0)
+
+#define FAST_TIM1_CAPTURE4(value)                                             \
+    do {                                                                      \
+        (value) = (unsigned short)TIM1->CCR4H << 8;                           \
+        (value) |= TIM1->CCR4L;                                               \
+    } while(0)
+
+#else
+
+#define FAST_TIM1_COUNTER(value)    ((value) = TIM1_GetCounter())
+#define FAST_TIM1_CAPTURE4(value)   ((value) = TIM1_GetCapture4())
+
+#endif
+
+#endif
@@ -0,0 +1,56 @@
+/*******************************************************************************
+  * @file Gesture.h
+  * @brief Defines the touch key gesture decoder. The key state from each 
+  *        touch acquisition is turned into taps, double taps and long 
+  *        presses on the robot, so the key acts at once with no round trip
+  *        to the remote. The gestures are queued for the remote to be told
+  *        of later.
+  * @author David Sharpe
+  * @version V1.0.0
+  * @date 14-October-2026
+  *
+  * ST Visual Develop 4.2.1 using STM8 Cosmic C Compiler
+  *****************************************************************************/
+#ifndef GESTURE_H
+#define GESTURE_H
+
+////////////////////////////////////////////////////////////////////////////////
+// Includes
+////////////////////////////////////////////////////////////////////////////////
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Definitions
+////////////////////////////////////////////////////////////////////////////////
+
+//A release before GESTURE_LONG_TIME is a tap, and a second press within 
+//GESTURE_GAP_TIME of it makes a double tap. So a tap is only known once 
+//the gap has passed, the first touch is reported at once for the actions 
+//that cannot wait.
+#define GESTURE_LONG_TIME       800 //ms held
+#define GESTURE_GAP_TIME        250 //ms from the release to the next press
+
+//Gestures waiting for the remote, power of 2, the oldest are kept
+#define GESTURE_QUEUE_SIZE      4
+
+//Events, also the values sent to the remote
+enum GestureEvent
+{
+    GESTURE_NONE,
+    GESTURE_TOUCH,          //first touch of a gesture, not queued
+    GESTURE_TAP,
+    GESTURE_DOUBLE_TAP,
+    GESTURE_LONG_PRESS      //reported while still held
+};
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Functions
+////////////////////////////////////////////////////////////////////////////////
+void Gesture_Initialize(void);
+unsigned char Gesture_Update(unsigned char pressed);
+int  Gesture_IsPending(void);
+unsigned char Gesture_GetReport(unsigned char *report);
+void Gesture_Release(void);
+
+#endif
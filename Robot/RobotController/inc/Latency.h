@@ -0,0 +1,64 @@
+/*******************************************************************************
+  * @file Latency.h
+  * @brief Defines the latency probe, which follows one stamped command from
+  *        the +IPD header to the PWM period its new duty was loaded in. The
+  *        controller stamps a frame with the time of the input that caused
+  *        it and is sent back the robot's stage times, which it combines 
+  *        with its own and the clock offset into the whole path.
+  * @author David Sharpe
+  * @version V1.0.0
+  * @date 14-October-2026
+  *
+  * ST Visual Develop 4.2.1 using STM8 Cosmic C Compiler
+  *****************************************************************************/
+#ifndef LATENCY_H
+#define LATENCY_H
+
+////////////////////////////////////////////////////////////////////////////////
+// Includes
+////////////////////////////////////////////////////////////////////////////////
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Definitions
+////////////////////////////////////////////////////////////////////////////////
+
+//Set to 0 to leave the probe out, it costs 21 bytes of RAM and a check in
+//the command dispatch and the PWM interrupt
+#ifndef LATENCY_ENABLE
+#define LATENCY_ENABLE      1
+#endif
+
+//One stamp is followed at a time, a new one replaces it. A command that
+//leaves the outputs as they were is reported after LATENCY_TIMEOUT with no
+//PWM time.
+#define LATENCY_TIMEOUT     100     //ms from the dispatch
+#define LATENCY_NONE        0xFFFF  //stage did not happen
+
+//Report, LSB first:
+//  stamp                   controller time of the input, 32-bit, returned 
+//                          unchanged
+//  header                  robot time the +IPD header arrived, ms, 32-bit
+//  uart                    header to the main loop taking the packet, the 
+//                          rest of the datagram and its wait in the pool, us
+//  parse                   packet taken to the command after the stamp 
+//                          dispatched, us
+//  apply                   dispatch to the TIM2 update loading the new 
+//                          duty, us, LATENCY_NONE if the outputs did not
+//                          change
+#define LATENCY_REPORT_SIZE 14
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Functions
+////////////////////////////////////////////////////////////////////////////////
+#if LATENCY_ENABLE
+void Latency_Stamp(const unsigned char *stamp, unsigned short headerTime, 
+                   unsigned short takenTime);
+void Latency_Dispatch(unsigned char type);
+void Latency_ApplyISR(void);
+int  Latency_IsReady(void);
+unsigned char Latency_GetReport(unsigned char *report);
+#endif
+
+#endif
@@ -0,0 +1,59 @@
+/*******************************************************************************
+  * @file Load.h
+  * @brief Defines the main loop load monitor. The time the loop sleeps and
+  *        the time between its iterations are measured over each window,
+  *        so the headroom left is known on the robot itself and the cost of
+  *        a feature shows as it is turned on.
+  * @author David Sharpe
+  * @version V1.0.0
+  * @date 14-October-2026
+  *
+  * ST Visual Develop 4.2.1 using STM8 Cosmic C Compiler
+  *****************************************************************************/
+#ifndef LOAD_H
+#define LOAD_H
+
+////////////////////////////////////////////////////////////////////////////////
+// Includes
+////////////////////////////////////////////////////////////////////////////////
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Definitions
+////////////////////////////////////////////////////////////////////////////////
+
+//Set to 0 to leave the load monitor out
+#ifndef LOAD_ENABLE
+#define LOAD_ENABLE         1
+#endif
+
+//The window closes after LOAD_WINDOW ms and its report rides along with
+//the next telemetry batch
+#define LOAD_WINDOW         1000 //ms
+
+//Loop period histogram, bin n counts periods below LOAD_BIN_BASE << n us
+//and the last bin the rest. The 99th percentile is the top of its bin.
+#define LOAD_BINS           12
+#define LOAD_BIN_BASE       16   //us
+#define LOAD_PERIOD_MAX     0xFFFF //us, periods that are longer
+
+//Report of the last window, 16-bit LSB first:
+//  busy                    permille of the time the loop was not asleep
+//  loops                   iterations
+//  min, p99, max           loop period in us
+#define LOAD_REPORT_SIZE    10
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Functions
+////////////////////////////////////////////////////////////////////////////////
+#if LOAD_ENABLE
+void Load_Initialize(void);
+void Load_Loop(void);
+void Load_Sleep(void);
+int  Load_IsPending(void);
+unsigned char Load_GetReport(unsigned char *report);
+void Load_Release(void);
+#endif
+
+#endif
@@ -0,0 +1,72 @@
+/*******************************************************************************
+  * @file Log.h
+  * @brief Defines the event log. A record is a message id and its raw 16-bit
+  *        arguments, the text is kept off the robot and put back by the
+  *        remote or the host from the table made by tools/GenerateLogTable.py
+  * @author David Sharpe
+  * @version V1.0.0
+  * @date 14-October-2026
+  *
+  * ST Visual Develop 4.2.1 using STM8 Cosmic C Compiler
+  *****************************************************************************/
+#ifndef LOG_H
+#define LOG_H
+
+////////////////////////////////////////////////////////////////////////////////
+// Includes
+////////////////////////////////////////////////////////////////////////////////
+#include "LogMessages.h"
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Definitions
+////////////////////////////////////////////////////////////////////////////////
+
+//Set to 0 to leave the log out, the LOG macros then compile to nothing
+#ifndef LOG_ENABLE
+#define LOG_ENABLE          1
+#endif
+
+#define LOG_SIZE            32 //bytes, power of 2, new records are dropped when full
+#define LOG_BATCH_SIZE      LOG_SIZE //record bytes per batch at most
+#define LOG_ID_MAX          64
+#define LOG_ARGS_MAX        3
+
+//Record:
+//  header                  argument count in the top 2 bits, the id below
+//  arguments               16-bit LSB first
+#define LOG_HEADER(id, count)   (unsigned char)(((count) << 6) | (id))
+#define LOG_RECORD_MAX          (1 + (LOG_ARGS_MAX * 2))
+
+//Batch:
+//  dropped                 records lost since the last batch, saturates
+//  records                 whole records, oldest first
+#define LOG_REPORT_SIZE     (1 + LOG_BATCH_SIZE)
+
+//Log a message with as many arguments as its format takes. Safe from the
+//main loop and from interrupts.
+#if LOG_ENABLE
+#define LOG0(id)            Log_Write(LOG_HEADER(id, 0), 0, 0, 0)
+#define LOG1(id, a)         Log_Write(LOG_HEADER(id, 1), a, 0, 0)
+#define LOG2(id, a, b)      Log_Write(LOG_HEADER(id, 2), a, b, 0)
+#define LOG3(id, a, b, c)   Log_Write(LOG_HEADER(id, 3), a, b, c)
+#else
+#define LOG0(id)
+#define LOG1(id, a)
+#define LOG2(id, a, b)
+#define LOG3(id, a, b, c)
+#endif
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Functions
+////////////////////////////////////////////////////////////////////////////////
+#if LOG_ENABLE
+void Log_Write(unsigned char header, unsigned short a, unsigned short b,
+               unsigned short c);
+int  Log_IsPending(void);
+unsigned char Log_GetReport(unsigned char *report);
+void Log_Release(void);
+#endif
+
+#endif
@@ -0,0 +1,41 @@
+/*******************************************************************************
+  * @file LogMessages.h
+  * @brief Log message ids, the text is only on the remote and the host
+  *
+  * Generated by tools/GenerateLogTable.py, do not edit
+  *****************************************************************************/
+#ifndef LOG_MESSAGES_H
+#define LOG_MESSAGES_H
+
+////////////////////////////////////////////////////////////////////////////////
+// Definitions
+////////////////////////////////////////////////////////////////////////////////
+
+//Messages, log each with LOG0 to LOG3 to match its arguments
+enum LogId
+{
+    LOG_FAILSAFE_TRIP,      //1: "Failsafe stopped the robot %u ms after the last command"
+    LOG_BAUD_SETTLED,       //1: "Module link settled at %u00 baud"
+    LOG_CONFIG_SAVED,       //1: "Configuration saved to slot %u"
+    LOG_CONFIG_SAVE_FAILED, //1: "Configuration save to slot %u failed to verify"
+    LOG_SEQUENCE_REFUSED,   //1: "Sequence of %u bytes refused"
+    LOG_LINK_OPENED,        //2: "Link %u connected, role %u"
+    LOG_LINK_CLOSED,        //1: "Link %u closed"
+    LOG_CALIBRATION_POINT,  //3: "Calibration at duty %u, left %u right %u edges/s"
+    LOG_CALIBRATION_FAILED, //0: "Calibration stopped, a wheel did not turn at full duty"
+    LOG_REFLEX_LIMIT,       //2: "Obstacle at %u mm, forward speed held to %u percent"
+    LOG_PEER_FOLLOWED,      //3: "Link moved to the controller at *.*.%u.%u port %u"
+    LOG_SPEED_LIMIT,        //1: "Speed limit set to %u percent on the robot"
+    LOG_PATH_REFUSED,       //1: "Path of %u bytes refused"
+    LOG_PATH_DONE,          //1: "Path of %u waypoints finished"
+    LOG_OTA_BEGIN,          //1: "Firmware update of %u blocks started"
+    LOG_OTA_FAILED,         //1: "Firmware update failed, result %u"
+    LOG_OTA_STAGED,         //1: "Firmware update of %u blocks staged"
+    LOG_OTA_APPLY,          //0: "Resetting to apply the firmware update"
+    LOG_ESP_RECOVERY,       //1: "Module fault, recovery step %u started"
+    LOG_ESP_RECOVERED,      //1: "Module recovered at step %u"
+    LOG_DRIVE_TRIP,         //2: "Overcurrent trip %u, speed held to %u percent"
+    LOG_DRIVE_LATCHED       //1: "Overcurrent trip %u in a row, motors off until the commands stop"
+};
+
+#endif
\ No newline at end of file
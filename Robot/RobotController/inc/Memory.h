@@ -0,0 +1,71 @@
+/*******************************************************************************
+  * @file Memory.h
+  * @brief Defines the RAM budget report, the stack high-water mark from a
+  *        painted stack and the sizes of the static buffers
+  * @author David Sharpe
+  * @version V1.0.0
+  * @date 14-October-2026
+  *
+  * ST Visual Develop 4.2.1 using STM8 Cosmic C Compiler
+  *****************************************************************************/
+#ifndef MEMORY_H
+#define MEMORY_H
+
+////////////////////////////////////////////////////////////////////////////////
+// Includes
+////////////////////////////////////////////////////////////////////////////////
+#include "Pool.h"
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Definitions
+////////////////////////////////////////////////////////////////////////////////
+
+//Stack region, must match the linker settings of the project. The RAM
+//segment for .data and .bss ends at 0x5FF and the stack starts at 0x7FF, so
+//the 512 bytes in between are only ever stack.
+#ifndef MEMORY_STACK_BOTTOM
+#define MEMORY_STACK_BOTTOM ((unsigned char *)0x0600)
+#endif
+#define MEMORY_STACK_SIZE   512
+
+#define MEMORY_PAINT        0xCD
+#define MEMORY_PAINT_MARGIN 16 //bytes left unpainted below the painting frame
+
+//Static buffers in the budget, the largest users of RAM outside the stack
+enum MemoryBuffer
+{
+    MEMORY_UART_RX,         //receive and idle rings
+    MEMORY_UART_TX,         //transmit ring
+    MEMORY_ESP_RX,          //receive packet pool and the priority buffer
+    MEMORY_ESP_TX,          //block pool, datagrams and observer datagrams
+    MEMORY_ESP_BULK,        //bulk lane ring
+    MEMORY_ESP_COMMANDS,    //AT command queue and response events
+    MEMORY_TELEMETRY,       //sample ring
+    MEMORY_TRACE,           //link trace ring, 0 when left out
+    MEMORY_LOG,             //log ring, 0 when left out
+    MEMORY_SEQUENCER,       //motion steps
+    MEMORY_SCHEDULER,       //task table
+    MEMORY_CONFIG,          //configuration image
+    MEMORY_PROFILE,         //profiling counters, 0 when left out
+    MEMORY_TOUCH,           //touch sensing key state and step times
+    MEMORY_BUFFER_COUNT
+};
+
+//Report, 16-bit values LSB first:
+//  stack size              bytes in the stack region
+//  stack peak              most bytes of it ever used since start up
+//  count                   number of buffers, 8-bit
+//  sizes                   bytes of each buffer, see MemoryBuffer
+//  pool                    block pool usage, see POOL_REPORT_SIZE
+#define MEMORY_REPORT_SIZE  (5 + (MEMORY_BUFFER_COUNT * 2) + POOL_REPORT_SIZE)
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Functions
+////////////////////////////////////////////////////////////////////////////////
+void Memory_PaintStack(void);
+unsigned short Memory_GetStackPeak(void);
+unsigned char Memory_GetReport(unsigned char *report);
+
+#endif
@@ -0,0 +1,73 @@
+/*******************************************************************************
+  * @file MicroBench.h
+  * @brief Defines the microbenchmarks of the hot routines. Each kernel runs 
+  *        in batches timed with a free-running count and the cost is given
+  *        in CPU cycles per call, so the effect of a change to one routine 
+  *        can be read straight off the report, on the robot or on the host.
+  * @author David Sharpe
+  * @version V1.0.0
+  * @date 14-October-2026
+  *
+  * ST Visual Develop 4.2.1 using STM8 Cosmic C Compiler
+  *****************************************************************************/
+#ifndef MICRO_BENCH_H
+#define MICRO_BENCH_H
+
+////////////////////////////////////////////////////////////////////////////////
+// Includes
+////////////////////////////////////////////////////////////////////////////////
+#include "Scheduler.h"
+#include "stm8s.h"
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Definitions
+////////////////////////////////////////////////////////////////////////////////
+
+//Set to 0 to leave the microbenchmarks out
+#ifndef MICRO_ENABLE
+#define MICRO_ENABLE            1
+#endif
+
+//Free-running count the batches are timed with and the CPU cycles in each
+//of its counts. On the robot it is the TIM1 microsecond count, so a batch 
+//has to be long enough for 16 cycle steps not to matter. The host build 
+//sets its own, see stm8s.h there.
+#ifndef MICRO_CLOCK
+#define MICRO_CLOCK()           Sched_GetMicros()
+#define MICRO_CYCLES_PER_COUNT  16
+#endif
+
+//Kernels
+enum MicroKernel
+{
+    MICRO_RING,         //Ring_Put then Ring_Get, the SPSC ring
+    MICRO_UART_FIFO,    //RING_PUT then RING_GET, the UART receive FIFO
+    MICRO_ESP_IPD,      //Esp8266_ProcessRxByte on one +IPD datagram
+    MICRO_DRIVE_SPEED,  //DriveCtrl_SetSpeed, the duty math
+    MICRO_CMD_BUILD,    //an AT+CIPSEND command from the builder
+    MICRO_KERNEL_COUNT
+};
+
+//Each kernel runs MICRO_BATCHES batches, the fastest batch is the one 
+//least disturbed by interrupts. A batch is MICRO_CALLS calls, or one 
+//datagram for the parser.
+#define MICRO_BATCHES           8
+#define MICRO_CALLS             16
+
+//Report: kernel count, then the fastest and mean batch of each kernel in 
+//cycles per call, 16-bit LSB first. A kernel that could not run, the 
+//parser while the module is talking or the duty math while the robot 
+//moves, reads 0.
+#define MICRO_REPORT_SIZE       (1 + (MICRO_KERNEL_COUNT * 4))
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Functions
+////////////////////////////////////////////////////////////////////////////////
+#if MICRO_ENABLE
+void Micro_Run(void);
+unsigned char Micro_GetReport(unsigned char *report);
+#endif
+
+#endif
@@ -0,0 +1,58 @@
+/*******************************************************************************
+  * @file Odometry.h
+  * @brief Defines the wheel odometry, a dead reckoning estimate of the robot
+  *        pose from the encoder edges
+  * @author David Sharpe
+  * @version V1.0.0
+  * @date 14-October-2026
+  *
+  * ST Visual Develop 4.2.1 using STM8 Cosmic C Compiler
+  *****************************************************************************/
+#ifndef ODOMETRY_H
+#define ODOMETRY_H
+
+////////////////////////////////////////////////////////////////////////////////
+// Includes
+////////////////////////////////////////////////////////////////////////////////
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Definitions
+////////////////////////////////////////////////////////////////////////////////
+
+//Geometry. A 65mm wheel with 40 rising edges per turn travels 5105um per
+//edge, the wheels are 130mm apart.
+#define ODOMETRY_UM_PER_EDGE    5105
+#define ODOMETRY_TRACK_UM       130000UL
+
+//Heading change for a wheel travel difference, heading units per um in
+//Q16, 2^32 / (2 pi track)
+#define ODOMETRY_TURN_SCALE     ((0xFFFFFFFFUL / ODOMETRY_TRACK_UM) * 1000 / 6283)
+
+//Headings are binary angles, 65536 units to the turn so they wrap for free.
+//Sines are Q14.
+#define ODOMETRY_HEADING_TURN   65536L
+#define ODOMETRY_SIN_ONE        16384
+
+//Pose report, 16-bit values LSB first:
+//  x, y                    position in mm from the start, signed
+//  heading                 binary angle, 0 along x and counterclockwise
+#define ODOMETRY_REPORT_SIZE    6
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Functions
+////////////////////////////////////////////////////////////////////////////////
+void Odometry_Initialize(void);
+void Odometry_Reset(void);
+void Odometry_Update(void);
+signed long Odometry_GetTravel(void);
+signed long Odometry_GetRotation(void);
+unsigned short Odometry_GetHeading(void);
+signed long Odometry_GetX(void);
+signed long Odometry_GetY(void);
+signed short Odometry_Sin(unsigned short angle);
+signed short Odometry_Cos(unsigned short angle);
+unsigned char Odometry_GetReport(unsigned char *report);
+
+#endif
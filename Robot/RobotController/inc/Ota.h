@@ -0,0 +1,129 @@
+/*******************************************************************************
+  * @file Ota.h
+  * @brief Defines the firmware update over the control link. The 
+  *        controller streams a new image in CRC'd chunks, it is block 
+  *        programmed into a staging region while the running firmware 
+  *        carries on, and the resident boot copier in Boot.c moves it over
+  *        the running image at the next reset.
+  * @author David Sharpe
+  * @version V1.0.0
+  * @date 14-October-2026
+  *
+  * ST Visual Develop 4.2.1 using STM8 Cosmic C Compiler
+  *****************************************************************************/
+#ifndef OTA_H
+#define OTA_H
+
+////////////////////////////////////////////////////////////////////////////////
+// Includes
+////////////////////////////////////////////////////////////////////////////////
+#include "stm8s.h"
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Definitions
+////////////////////////////////////////////////////////////////////////////////
+
+//Set to 1 to take firmware updates. The begin is not authenticated, so 
+//with it set whoever holds the primary link can replace the firmware, 
+//leave it off in builds that go out. Observers are never let update.
+#ifndef OTA_ENABLE
+#define OTA_ENABLE          0
+#endif
+
+//Program memory layout. 32KB leaves no room for two runnable images, so
+//the new one is staged and copied:
+//  0x8000-0x87FF  boot: the vector table, forwarding to the application's,
+//                 and the boot copier. Only ever written with the ST-Link.
+//  0x8800-0xC37F  application, starting with its own vector table
+//  0xC400-0xFF7F  staging, an image of up to OTA_IMAGE_MAX bytes
+//  0xFF80-0xFFFF  staging header, written last once the image checks out
+//The linker segments in the STVD project follow it, the map file must end
+//.text below OTA_STAGING_START.
+#define OTA_BLOCK_SIZE          FLASH_BLOCK_SIZE
+#define OTA_APP_START           0x8800U
+#define OTA_STAGING_START       0xC400U
+#define OTA_HEADER_START        0xFF80U
+#define OTA_IMAGE_MAX           0x3B80U //bytes, 119 blocks
+#define OTA_MAGIC               0x4F54  //"OT"
+
+//Transfer. Chunks are taken in order one at a time, the sender waits for
+//the report before the next so no more than one chunk is ever waiting 
+//in the receive pool. A chunk may not cross a block. The block is
+//programmed once it is full with the CPU stalled and interrupts off for a
+//few ms, so with UART_FLOW_CONTROL its last chunk is reported first and
+//the module is held while it is written, the next chunk already on its way.
+//Without it the report waits for the write, so no more of the image is on
+//its way to be lost.
+#define OTA_CHUNK_MAX           32
+#define OTA_CHUNK_HEADER        3   //action and 16-bit offset
+#define OTA_WRITE_WAIT          50  //ms for the report to leave before a write
+
+//Command: action, then for OTA_BEGIN the 16-bit length and CRC-16 of the
+//image, for OTA_CHUNK the 16-bit offset and the data, LSB first
+enum OtaAction
+{
+    OTA_STATUS,     //report the state
+    OTA_BEGIN,      //start a transfer, the staged image is dropped
+    OTA_CHUNK,      //image bytes at an offset
+    OTA_END,        //write the last block and check the image
+    OTA_APPLY,      //reset into the boot copier
+    OTA_ABORT       //drop the transfer
+};
+
+//Report: result, state, then the 16-bit offset of the next chunk wanted
+#define OTA_REPORT_SIZE         4
+
+enum OtaResult
+{
+    OTA_OK,
+    OTA_REFUSED,    //moving, no transfer or nothing staged
+    OTA_TOO_BIG,    //longer than OTA_IMAGE_MAX
+    OTA_BAD_CHUNK,  //not the next offset, too long or across a block
+    OTA_BAD_IMAGE,  //the image does not match its CRC
+    OTA_WRITE_FAILED,
+    OTA_PENDING     //reported once the write is done
+};
+
+enum OtaState
+{
+    OTA_IDLE,
+    OTA_RECEIVING,
+    OTA_WRITING,    //a block is waiting to be written
+    OTA_STAGED,     //a checked image waits for OTA_APPLY
+    OTA_APPLYING
+};
+
+//Staging header, LSB first. The boot copier takes the image when the
+//magic is set and the staged bytes match the CRC.
+#define OTA_HEADER_MAGIC        0
+#define OTA_HEADER_LENGTH       2
+#define OTA_HEADER_CRC          4
+#define OTA_HEADER_SIZE         6
+
+#if !OTA_ENABLE
+#define Ota_IsActive()          0
+#endif
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Functions
+////////////////////////////////////////////////////////////////////////////////
+#if OTA_ENABLE
+void Ota_Initialize(void);
+unsigned char Ota_Begin(unsigned short length, unsigned short crc);
+unsigned char Ota_Chunk(unsigned short offset, const unsigned char *data,
+                        unsigned char length);
+unsigned char Ota_End(void);
+unsigned char Ota_Apply(void);
+void Ota_Abort(void);
+int  Ota_IsActive(void);
+unsigned char Ota_GetState(void);
+void Ota_GetReport(unsigned char result, unsigned char *report);
+int  Ota_IsReplyDue(unsigned char *result);
+int  Ota_Run(void);
+unsigned short Ota_Crc16(unsigned short crc, const unsigned char *data,
+                         unsigned char length);
+#endif
+
+#endif
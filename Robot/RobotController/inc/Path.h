@@ -0,0 +1,66 @@
+/*******************************************************************************
+  * @file Path.h
+  * @brief Defines the waypoint follower. A list of waypoints arrives in one
+  *        frame and the robot steers through them on its own odometry at 
+  *        the control rate, so a path is driven as precisely with a slow 
+  *        or jittery link as with none.
+  * @author David Sharpe
+  * @version V1.0.0
+  * @date 14-October-2026
+  *
+  * ST Visual Develop 4.2.1 using STM8 Cosmic C Compiler
+  *****************************************************************************/
+#ifndef PATH_H
+#define PATH_H
+
+////////////////////////////////////////////////////////////////////////////////
+// Includes
+////////////////////////////////////////////////////////////////////////////////
+#include "DriveController.h"
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Definitions
+////////////////////////////////////////////////////////////////////////////////
+
+//Waypoints are in mm in the odometry frame, see Odometry_Reset. Each is 
+//steered for with pure pursuit, the arc through it tangent to the heading,
+//and is reached within PATH_RADIUS. The wheels slow over the last
+//PATH_SLOW_DISTANCE to the end of the path and then stop. The path feeds
+//the failsafe as a sequence does, a stop command or any drive command ends
+//it early.
+#define PATH_MAX_POINTS         12
+#define PATH_PERIOD             DRIVE_UPDATE_PERIOD
+#define PATH_RADIUS             40  //mm
+#define PATH_SLOW_DISTANCE      200 //mm
+#define PATH_VELOCITY_MIN       40  //edges/s approaching the end
+
+//Turn in Q8, half the curvature times the track. PATH_TURN_ONE stops the
+//inner wheel and PATH_TURN_MAX runs it back at 3/5 of the outer, a turn 
+//tight enough to reach a waypoint close to the side. A waypoint behind is
+//turned toward at PATH_TURN_MAX.
+#define PATH_TURN_ONE           256
+#define PATH_TURN_MAX           1024
+
+//Command: 16-bit outer wheel velocity in edges/s, then x and y of each 
+//waypoint, signed 16-bit mm, LSB first
+#define PATH_HEADER_SIZE        2
+#define PATH_POINT_SIZE         4
+
+typedef struct
+{
+    signed short x;
+    signed short y;
+} PathPoint;
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Functions
+////////////////////////////////////////////////////////////////////////////////
+void Path_Initialize(void);
+int  Path_Load(const unsigned char *value, unsigned char length);
+void Path_Cancel(void);
+int  Path_IsRunning(void);
+void Path_Task(void);
+
+#endif
@@ -0,0 +1,60 @@
+/*******************************************************************************
+  * @file Pool.h
+  * @brief Defines the block pool. Fixed size blocks are shared by the
+  *        buffer users in PoolClass, each capped by its quota, so RAM is
+  *        sized once for the pool rather than for every queue at its worst.
+  * @author David Sharpe
+  * @version V1.0.0
+  * @date 14-October-2026
+  *
+  * ST Visual Develop 4.2.1 using STM8 Cosmic C Compiler
+  *****************************************************************************/
+#ifndef POOL_H
+#define POOL_H
+
+////////////////////////////////////////////////////////////////////////////////
+// Includes
+////////////////////////////////////////////////////////////////////////////////
+#include "stm8s.h"
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Definitions
+////////////////////////////////////////////////////////////////////////////////
+
+//Blocks fit the longest datagram, ESP8266_TX_PACKET_SIZE. There are 
+//enough for every class to hold its full quota at once, Pool.c checks the
+//quotas add up to no more.
+#define POOL_BLOCK_SIZE         56
+#define POOL_BLOCK_COUNT        4
+#define POOL_NONE               0xFF //end of the free list, owner of a free block
+
+//Pool users and the most blocks each may hold, see POOL_QUOTA in Pool.c
+enum PoolClass
+{
+    POOL_TX_DATAGRAM,       //primary link datagram queue
+    POOL_OBSERVER,          //observer datagram queue
+    POOL_CLASS_COUNT
+};
+
+//Usage of each class, 8-bit values:
+//  quota                   most blocks it may hold
+//  used                    blocks it holds now
+//  peak                    most it has held since start up
+//  failed                  allocations refused, saturates
+#define POOL_CLASS_REPORT_SIZE  4
+#define POOL_REPORT_SIZE        (1 + (POOL_CLASS_COUNT * POOL_CLASS_REPORT_SIZE))
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Functions
+////////////////////////////////////////////////////////////////////////////////
+void Pool_Initialize(void);
+void Pool_Release(unsigned char poolClass);
+unsigned char *Pool_Alloc(unsigned char poolClass);
+void Pool_Free(unsigned char *block);
+unsigned char Pool_GetUsed(unsigned char poolClass);
+unsigned char Pool_GetPeak(unsigned char poolClass);
+unsigned char Pool_GetReport(unsigned char *report);
+
+#endif
@@ -0,0 +1,64 @@
+/*******************************************************************************
+  * @file Power.h
+  * @brief Defines the CPU clock scaling. The CPU prescaler is raised while
+  *        the robot is parked and nothing has come in for a while, and put
+  *        back to full speed by the first byte from the module, a control
+  *        frame or a touch. Only the CPU divider changes, the peripherals
+  *        run from the master clock, so the UART baud, the tick and the PWM
+  *        keep their timing without their dividers being recomputed.
+  * @author David Sharpe
+  * @version V1.0.0
+  * @date 14-October-2026
+  *
+  * ST Visual Develop 4.2.1 using STM8 Cosmic C Compiler
+  *****************************************************************************/
+#ifndef POWER_H
+#define POWER_H
+
+////////////////////////////////////////////////////////////////////////////////
+// Includes
+////////////////////////////////////////////////////////////////////////////////
+#include "stm8s.h"
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Definitions
+////////////////////////////////////////////////////////////////////////////////
+
+//Set to 0 to leave the CPU at full speed
+#ifndef POWER_ENABLE
+#define POWER_ENABLE            1
+#endif
+
+//CPU clock while parked, 2MHz. The UART receive interrupt restores full
+//speed as it starts, well inside a byte time at 460800 baud.
+#define POWER_SLOW_DIVIDER      CLK_PRESCALER_CPUDIV8
+
+//Parked this long with nothing coming in before the CPU slows
+#define POWER_IDLE_TIME         1000 //ms
+
+//Restore full speed from the UART receive interrupt, a single test per byte
+//at full speed. The first byte after a slow down restarts the idle time,
+//later ones only the frames do.
+#if POWER_ENABLE
+extern volatile unsigned char powerSlow;
+#define POWER_WAKE_FROM_ISR()   do { if(powerSlow) { Power_Wake(); } } while(0)
+#else
+#define POWER_WAKE_FROM_ISR()
+#endif
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Functions
+////////////////////////////////////////////////////////////////////////////////
+#if POWER_ENABLE
+void Power_Initialize(void);
+void Power_Run(void);
+void Power_Wake(void);
+unsigned char Power_Hold(void);
+void Power_Resume(unsigned char held);
+int  Power_IsSlow(void);
+unsigned short Power_GetSlowCount(void);
+#endif
+
+#endif
@@ -0,0 +1,81 @@
+/*******************************************************************************
+  * @file Profile.h
+  * @brief Defines the hot path profiling counters. With PROFILE_ENABLE set
+  *        to 0 the probes compile to nothing.
+  * @author David Sharpe
+  * @version V1.0.0
+  * @date 14-October-2026
+  *
+  * ST Visual Develop 4.2.1 using STM8 Cosmic C Compiler
+  *****************************************************************************/
+#ifndef PROFILE_H
+#define PROFILE_H
+
+////////////////////////////////////////////////////////////////////////////////
+// Includes
+////////////////////////////////////////////////////////////////////////////////
+#include "Scheduler.h"
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Definitions
+////////////////////////////////////////////////////////////////////////////////
+
+//Set to 1 to build the profiling counters, release builds leave this at 0
+#ifndef PROFILE_ENABLE
+#define PROFILE_ENABLE      0
+#endif
+
+//Profiled sections
+enum ProfilePoint
+{
+    PROFILE_UART_RX_ISR,    //Uart_ReceiveISR
+    PROFILE_ESP_RX_BYTE,    //Esp8266_ProcessRxByte
+    PROFILE_TSL_ACTION,     //TSL_Action
+    PROFILE_COMMAND,        //command dispatch
+    PROFILE_SEND_MSG,       //Esp8266_SendMsg
+    PROFILE_TICK_ISR,       //touch timebase in Sched_TickISR, with anything
+                            //that nests in it
+    PROFILE_TOUCH_SCAN,     //TouchPanel_Scan, the steps within TOUCH_BUDGET
+    PROFILE_POINT_COUNT
+};
+
+//Histogram bin n counts times below 4 << n us, the last bin is the rest
+#define PROFILE_BINS        8
+
+//Report: point, then count, min, max, mean and each bin, 16-bit LSB first
+#define PROFILE_REPORT_SIZE (1 + 8 + (PROFILE_BINS * 2))
+
+#define PROFILE_RESET       0xFF //Report request that clears the counters
+
+typedef struct
+{
+    unsigned short count;
+    unsigned short min;
+    unsigned short max;
+    unsigned long sum;
+    unsigned short bins[PROFILE_BINS];
+} ProfileStat;
+
+//Probes, timed with the TIM1 microsecond count (16 CPU cycles)
+#if PROFILE_ENABLE
+extern unsigned short profileStart[PROFILE_POINT_COUNT];
+#define PROFILE_START(point)    (profileStart[point] = Sched_GetMicros())
+#define PROFILE_END(point)      Profile_Record(point, \
+                                    Sched_GetMicros() - profileStart[point])
+#else
+#define PROFILE_START(point)
+#define PROFILE_END(point)
+#endif
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Functions
+////////////////////////////////////////////////////////////////////////////////
+#if PROFILE_ENABLE
+void Profile_Reset(void);
+void Profile_Record(unsigned char point, unsigned short micros);
+unsigned char Profile_GetReport(unsigned char point, unsigned char *report);
+#endif
+
+#endif
@@ -0,0 +1,179 @@
+/*******************************************************************************
+  * @file Protocol.h
+  * @brief Defines the binary control protocol exchanged with the remote
+  * @author David Sharpe
+  * @version V1.0.0
+  * @date 14-October-2026
+  *
+  * ST Visual Develop 4.2.1 using STM8 Cosmic C Compiler
+  *****************************************************************************/
+#ifndef PROTOCOL_H
+#define PROTOCOL_H
+
+////////////////////////////////////////////////////////////////////////////////
+// Includes
+////////////////////////////////////////////////////////////////////////////////
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Definitions
+////////////////////////////////////////////////////////////////////////////////
+
+//Frame layout:
+//  [0]       sync byte PROTO_SYNC
+//  [1]       version (high nibble) and flags (low nibble)
+//  [2]       sequence number
+//  [3]       length of the command list in bytes
+//  [4..n-2]  command list, each command is type, length, value
+//  [n-1]     CRC-8 (poly 0x07, init 0) of bytes 1 through n-2
+#define PROTO_SYNC              0xA5
+#define PROTO_VERSION           1
+#define PROTO_HEADER_SIZE       4
+#define PROTO_OVERHEAD          (PROTO_HEADER_SIZE + 1)
+
+//Flags
+#define PROTO_FLAG_SEQ_RESET    0x01  //Sender restarted, accept any sequence
+
+//Command types
+enum ProtoCommand
+{
+    PROTO_CMD_DRIVE     = 0x01,  //direction, speed percent
+    PROTO_CMD_WHEELS    = 0x02,  //signed left percent, signed right percent
+    PROTO_CMD_ACK_MODE  = 0x03,  //acknowledgement mode
+    PROTO_CMD_VELOCITY  = 0x04,  //signed 16-bit left and right edges/s, LSB first
+    PROTO_CMD_BENCH     = 0x05,  //benchmark action
+    PROTO_CMD_PING      = 0x06,  //16-bit tag, answered at once with a pong
+    PROTO_CMD_PROFILE   = 0x07,  //profiled section to report, 0xFF to clear
+    PROTO_CMD_CONFIG    = 0x08,  //configuration field, see Config.h, then data
+    PROTO_CMD_KEEPALIVE = 0x09,  //no data, holds off the failsafe stop
+    PROTO_CMD_SEQUENCE  = 0x0A,  //motion steps, see Sequencer.h
+    PROTO_CMD_MOVE      = 0x0B,  //move kind, signed 16-bit amount, 16-bit edges/s
+    PROTO_CMD_ESTOP     = 0x0C,  //no data, stops both wheels without a ramp
+    PROTO_CMD_TRACE     = 0x0D,  //trace action, the first event for a report
+    PROTO_CMD_MEMORY    = 0x0E,  //no data, answered with the RAM budget
+    PROTO_CMD_CALIBRATE = 0x0F,  //no data, starts a wheel characterization run
+    PROTO_CMD_DISCOVER  = 0x10,  //no data, a controller announcing its address
+    PROTO_CMD_FLEET     = 0x11,  //fleet wheel targets, see PROTO_FLEET_ENTRY
+    PROTO_CMD_CLOCK     = 0x12,  //clock action, 32-bit time, LSB first
+    PROTO_CMD_AT        = 0x13,  //32-bit controller time, then one command
+    PROTO_CMD_SETPOINT  = 0x14,  //32-bit controller time, signed left, right percent
+    PROTO_CMD_STAMP     = 0x15,  //32-bit controller time of the input, traces the next command
+    PROTO_CMD_PATH      = 0x16,  //16-bit edges/s, then waypoints, see Path.h
+    PROTO_CMD_OTA       = 0x17,  //firmware update action, controller only, see Ota.h
+    PROTO_CMD_REPEAT    = 0x18,  //sequence of an earlier frame, then one of its commands
+    PROTO_CMD_TWIST     = 0x19,  //signed forward percent, signed turn percent, one arc
+    PROTO_CMD_ACK       = 0x80,  //robot to remote, last accepted sequence
+    PROTO_CMD_PONG      = 0x81,  //robot to remote, tag of the ping
+    PROTO_CMD_STATS     = 0x82,  //robot to remote, benchmark statistics
+    PROTO_CMD_TIMING    = 0x83,  //robot to remote, profiling counters
+    PROTO_CMD_TELEMETRY = 0x84,  //robot to remote, batched telemetry samples
+    PROTO_CMD_POSE      = 0x85,  //robot to remote, odometry pose
+    PROTO_CMD_TRACE_LOG = 0x86,  //robot to remote, a page of the link trace
+    PROTO_CMD_LOG       = 0x87,  //robot to remote, a batch of log records
+    PROTO_CMD_MEMORY_REPORT = 0x88, //robot to remote, the RAM budget
+    PROTO_CMD_CLOCK_REPLY = 0x89, //robot to remote, controller then robot time
+    PROTO_CMD_MICRO_REPORT = 0x8A, //robot to remote, microbenchmark cycles
+    PROTO_CMD_GESTURE   = 0x8B,  //robot to remote, touch key gestures
+    PROTO_CMD_LATENCY   = 0x8C,  //robot to remote, stage times of a stamped command
+    PROTO_CMD_TELEMETRY_COMPACT = 0x8D, //robot to remote, delta coded samples
+    PROTO_CMD_OTA_REPORT = 0x8E, //robot to remote, firmware update progress
+    PROTO_CMD_LOAD_REPORT = 0x8F, //robot to remote, main loop load, see Load.h
+    PROTO_CMD_SOAK_REPORT = 0x90 //robot to remote, counter snapshot, see Soak.h
+};
+
+//Fleet wheel targets. A controller may broadcast one frame to a fleet, the
+//command holds an entry of id, signed left percent and signed right percent
+//for each robot. A robot obeys the entry with its own configured id or 
+//PROTO_FLEET_ALL and ignores the others.
+#define PROTO_FLEET_ENTRY       3     //bytes per entry
+#define PROTO_FLEET_ID_MAX      0xFE
+#define PROTO_FLEET_ALL         0xFF  //entry for every robot
+
+//Clock actions. A query carries the controller's time and is answered at 
+//once with it and the robot's time, see Clock.h. A timed command runs when
+//the robot's clock plus the offset set reaches its time, it holds the inner
+//command's type, length and data.
+enum ClockAction
+{
+    PROTO_CLOCK_QUERY,  //time is the controller's, answered with a reply
+    PROTO_CLOCK_SET     //time is the offset, controller minus robot
+};
+
+#define PROTO_AT_HEADER         6     //time, inner type and length
+
+//Repeated commands. On a lossy link the controller adds copies of the last
+//control commands it sent to each new frame, ahead of the frame's own, so
+//a lost frame is made good by the next without waiting for a resend. Each
+//copy holds the sequence number of the frame it first went in, then the 
+//command's type, length and data. A copy is run only if that frame is one 
+//of the PROTO_REPEAT_WINDOW before the newest accepted and never arrived, 
+//and at most once. Copies are ignored on the bulk lane.
+#define PROTO_REPEAT_HEADER     3     //sequence, inner type and length
+#define PROTO_REPEAT_WINDOW     8     //frames, bits in the received mask
+
+//Closed loop moves
+enum MoveKind
+{
+    PROTO_MOVE_DISTANCE,  //amount in mm, negative is backward
+    PROTO_MOVE_TURN,      //amount in degrees, positive is counterclockwise
+    PROTO_MOVE_RESET_POSE //no amount, the pose starts again at the origin
+};
+
+//Benchmark actions
+enum BenchAction
+{
+    PROTO_BENCH_STOP,    //Stop recording
+    PROTO_BENCH_START,   //Clear the statistics and start recording
+    PROTO_BENCH_REPORT,  //Send the statistics
+    PROTO_BENCH_MICRO,   //Run the microbenchmarks and send the cycles
+    PROTO_BENCH_SOAK     //Snapshot the counters every data[1] seconds, 0 stops
+};
+
+//Trace actions
+enum TraceAction
+{
+    PROTO_TRACE_STOP,    //Stop recording, the trace is kept
+    PROTO_TRACE_START,   //Empty the trace and start recording
+    PROTO_TRACE_REPORT   //Send a page of the trace
+};
+
+//Acknowledgement modes
+enum AckMode
+{
+    PROTO_ACK_NONE,        //Nothing is sent back
+    PROTO_ACK_CUMULATIVE,  //Last accepted sequence, at most every interval
+    PROTO_ACK_ECHO         //Every packet is echoed back, for debugging
+};
+
+//Frame parse results
+enum ProtoResult
+{
+    PROTO_OK,
+    PROTO_BAD_FRAME,
+    PROTO_BAD_CRC,
+    PROTO_STALE
+};
+
+typedef void(*ProtoHandler)(unsigned char type, const unsigned char *value, 
+                            unsigned char length);
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Functions
+////////////////////////////////////////////////////////////////////////////////
+void Protocol_Initialize(void);
+unsigned char Protocol_ParseFrame(const unsigned char *frame, unsigned char length, 
+                                  ProtoHandler handler);
+unsigned char Protocol_ParseBulkFrame(const unsigned char *frame, unsigned char length, 
+                                      ProtoHandler handler);
+unsigned char Protocol_PeekFrame(const unsigned char *frame, unsigned char length, 
+                                 ProtoHandler handler);
+void Protocol_Fence(const unsigned char *frame);
+unsigned char Protocol_BuildFrame(unsigned char *frame, const unsigned char *payload, 
+                                  unsigned char length);
+unsigned char Protocol_Crc8(const unsigned char *data, unsigned char length);
+unsigned char Protocol_GetLastSeq(void);
+unsigned short Protocol_GetRejectCount(void);
+unsigned short Protocol_GetRecoveredCount(void);
+
+#endif
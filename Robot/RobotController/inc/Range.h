@@ -0,0 +1,65 @@
+/*******************************************************************************
+  * @file Range.h
+  * @brief Defines the forward range sensor, an HC-SR04 style ultrasonic
+  *        ranger timed by TIM1 input capture
+  * @author David Sharpe
+  * @version V1.0.0
+  * @date 14-October-2026
+  *
+  * ST Visual Develop 4.2.1 using STM8 Cosmic C Compiler
+  *****************************************************************************/
+#ifndef RANGE_H
+#define RANGE_H
+
+////////////////////////////////////////////////////////////////////////////////
+// Includes
+////////////////////////////////////////////////////////////////////////////////
+#include "stm8s.h"
+#include "Board.h"
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Definitions
+////////////////////////////////////////////////////////////////////////////////
+
+//Set to 0 to leave the range sensor out, the drive reflex then never acts
+#ifndef RANGE_ENABLE
+#define RANGE_ENABLE        1
+#endif
+
+//A pulse on the trigger starts a ping and the echo output is high for
+//RANGE_US_PER_10MM us per 10mm of range. The echo is on TIM1 channel 4, so
+//its edges are captured against the 1MHz scheduler count.
+#define RANGE_TRIGGER_PORT  BOARD_RANGE_TRIGGER_PORT
+#define RANGE_TRIGGER_PIN   BOARD_RANGE_TRIGGER_PIN
+#define RANGE_ECHO_PORT     BOARD_RANGE_ECHO_PORT
+#define RANGE_ECHO_PIN      BOARD_RANGE_ECHO_PIN //TIM1_CH4
+
+#define RANGE_TRIGGER_US    10
+#define RANGE_US_PER_10MM   58
+
+//Range_Task runs every RANGE_PERIOD ms, 1ms ahead of the drive update, and
+//passes an echo on the run after it ends. A ping goes out every
+//RANGE_PING_PERIOD ms, long enough for the echoes of the last to die away.
+//An echo that has not ended by the next ping found nothing.
+#define RANGE_PERIOD        10 //ms
+#define RANGE_PING_PERIOD   60 //ms
+#define RANGE_MAX           4000 //mm, further echoes read clear
+#define RANGE_CLEAR         0xFFFF //distance with nothing in range
+
+#if !RANGE_ENABLE
+#define Range_GetDistance() RANGE_CLEAR
+#endif
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Functions
+////////////////////////////////////////////////////////////////////////////////
+#if RANGE_ENABLE
+void Range_Initialize(void);
+void Range_Task(void);
+unsigned short Range_GetDistance(void);
+void Range_CaptureISR(void);
+#endif
+
+#endif
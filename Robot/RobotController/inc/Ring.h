@@ -0,0 +1,102 @@
+/*******************************************************************************
+  * @file Ring.h
+  * @brief Defines a single producer, single consumer byte ring. One side may
+  *        be an interrupt and the other main context without disabling
+  *        interrupts: the head is only written by the producer and the tail
+  *        only by the consumer, and both are 8-bit so each read and write is
+  *        a single instruction. The indices run freely and are masked on
+  *        use, so the whole buffer holds data and the count is a subtraction.
+  * @author David Sharpe
+  * @version V1.0.0
+  * @date 14-October-2026
+  *
+  * ST Visual Develop 4.2.1 using STM8 Cosmic C Compiler
+  *****************************************************************************/
+#ifndef RING_H
+#define RING_H
+
+////////////////////////////////////////////////////////////////////////////////
+// Includes
+////////////////////////////////////////////////////////////////////////////////
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Definitions
+////////////////////////////////////////////////////////////////////////////////
+
+//Largest ring, the 8-bit difference of the indices must hold the count
+#define RING_MAX_SIZE   128
+
+typedef struct
+{
+    unsigned char *buffer;
+    unsigned char mask;             //size - 1
+    volatile unsigned char head;    //written by the producer
+    volatile unsigned char tail;    //written by the consumer
+} Ring;
+
+//Define a ring and its buffer. The size must be a power of 2 no larger than
+//RING_MAX_SIZE, anything else fails to compile.
+#define RING_SIZE_CHECK(name, size)                                           \
+    typedef char name##_size_check[((size) > 0 && (size) <= RING_MAX_SIZE &&  \
+                                    ((size) & ((size) - 1)) == 0) ? 1 : -1]
+
+#define RING_DEFINE(name, size)                                               \
+    RING_SIZE_CHECK(name, size);                                              \
+    unsigned char name##_buffer[size];                                        \
+    Ring name = {name##_buffer, (unsigned char)((size) - 1), 0, 0}
+
+//The same with the indices in page zero, for a ring an interrupt routine 
+//uses by name. The buffer stays in near memory. TINY is from stm8s.h.
+#define RING_DEFINE_TINY(name, size)                                          \
+    RING_SIZE_CHECK(name, size);                                              \
+    unsigned char name##_buffer[size];                                        \
+    TINY Ring name = {name##_buffer, (unsigned char)((size) - 1), 0, 0}
+
+//Producer and consumer steps for a ring named directly, for the interrupt 
+//routines that run once per byte. The buffer and indices are addressed 
+//directly instead of through a pointer and the mask is a constant. The size
+//must be the one the ring was defined with, the order is that of the 
+//functions.
+#define RING_IS_FULL(name, size)    ((unsigned char)((name).head - (name).tail) >= (size))
+#define RING_IS_EMPTY(name)         ((name).head == (name).tail)
+
+#define RING_PUT(name, size, byte)                                            \
+    do                                                                        \
+    {                                                                         \
+        unsigned char head_ = (name).head;                                    \
+        name##_buffer[head_ & ((size) - 1)] = (byte);                         \
+        (name).head = head_ + 1;                                              \
+    } while(0)
+
+#define RING_GET(name, size, byte)                                            \
+    do                                                                        \
+    {                                                                         \
+        unsigned char tail_ = (name).tail;                                    \
+        (byte) = name##_buffer[tail_ & ((size) - 1)];                         \
+        (name).tail = tail_ + 1;                                              \
+    } while(0)
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Functions
+////////////////////////////////////////////////////////////////////////////////
+
+//Producer side
+int Ring_Put(Ring *ring, unsigned char byte);
+int Ring_Write(Ring *ring, unsigned char *data, unsigned char length);
+unsigned char Ring_Space(Ring *ring);
+
+//Consumer side
+int Ring_Get(Ring *ring, unsigned char *byte);
+int Ring_Peek(Ring *ring, unsigned char *byte);
+unsigned char Ring_PeekAt(Ring *ring, unsigned char offset);
+unsigned char Ring_PeekBlock(Ring *ring, unsigned char **data);
+void Ring_Read(Ring *ring, unsigned char *data, unsigned char length);
+void Ring_Discard(Ring *ring, unsigned char length);
+void Ring_Clear(Ring *ring);
+
+//Either side
+unsigned char Ring_Count(Ring *ring);
+
+#endif
@@ -0,0 +1,74 @@
+/*******************************************************************************
+  * @file Scheduler.h
+  * @brief Defines the cooperative periodic task scheduler
+  * @author David Sharpe
+  * @version V1.0.0
+  * @date 14-October-2026
+  *
+  * ST Visual Develop 4.2.1 using STM8 Cosmic C Compiler
+  *****************************************************************************/
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+////////////////////////////////////////////////////////////////////////////////
+// Includes
+////////////////////////////////////////////////////////////////////////////////
+#include "stm8s.h"
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Definitions
+////////////////////////////////////////////////////////////////////////////////
+#define SCHED_MAX_TASKS     13 //at most 15, one watchdog check in bit each
+#define SCHED_TICK          1 //ms
+
+//Mask every interrupt for a few instructions, from an interrupt routine as
+//well, and put the level it ran at back after. enableInterrupts would drop 
+//the level to the main loop's.
+#ifndef maskInterrupts
+#if defined(_COSMIC_)
+#define maskInterrupts(cc)      ((cc) = _asm("push cc\npop a\nsim\n"))
+#define restoreInterrupts(cc)   _asm("push a\npop cc\n", (cc))
+#else //_IAR_
+#define maskInterrupts(cc)      ((cc) = __get_interrupt_state(), __disable_interrupt())
+#define restoreInterrupts(cc)   __set_interrupt_state(cc)
+#endif
+#endif
+
+//Touch sensing timebase calls per tick, the library counts 0.5ms ticks. It 
+//is built with RTOS_MANAGEMENT so the timebase is a plain function.
+#define SCHED_TSL_TICKS     (SCHED_TICK * 2)
+
+//Independent watchdog, LSI/2 through the /128 prescaler counts every 2ms so
+//the full reload gives 510ms. It is reloaded only once every registered 
+//task has run since the last reload, a task that hangs or is starved resets
+//the robot. The longest task period has to stay well inside the timeout.
+#define SCHED_WATCHDOG_RELOAD   0xFF
+
+typedef void(*TaskFunc)(void);
+
+//Periodic task. The deadline of each release is the next release.
+typedef struct
+{
+    TaskFunc func;
+    unsigned short period;
+    unsigned long next;
+    unsigned short overruns;
+} SchedTask;
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Functions
+////////////////////////////////////////////////////////////////////////////////
+void Sched_Initialize(void);
+int  Sched_AddTask(TaskFunc func, unsigned short period, unsigned short offset);
+int  Sched_Run(void);
+void Sched_StartWatchdog(void);
+unsigned long Sched_GetTime(void);
+unsigned short Sched_GetMicros(void);
+int  Sched_IsExpired(unsigned long deadline);
+void Sched_Delay(unsigned short ms);
+unsigned short Sched_GetOverruns(TaskFunc func);
+void Sched_TickISR(void);
+
+#endif
@@ -0,0 +1,55 @@
+/*******************************************************************************
+  * @file Sequencer.h
+  * @brief Defines the motion sequencer. A list of motion steps arrives in one
+  *        frame and is run on the robot's own clock, so a maneuver times the
+  *        same however late or bunched up its frames were.
+  * @author David Sharpe
+  * @version V1.0.0
+  * @date 14-October-2026
+  *
+  * ST Visual Develop 4.2.1 using STM8 Cosmic C Compiler
+  *****************************************************************************/
+#ifndef SEQUENCER_H
+#define SEQUENCER_H
+
+////////////////////////////////////////////////////////////////////////////////
+// Includes
+////////////////////////////////////////////////////////////////////////////////
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Definitions
+////////////////////////////////////////////////////////////////////////////////
+#define SEQUENCER_PERIOD        1  //ms, the resolution of a hold
+#define SEQUENCER_MAX_STEPS     12
+
+//Step types. In a frame each step is the type followed by its data, 16-bit
+//values LSB first.
+enum SeqOp
+{
+    SEQ_OP_STOP     = 0x00,  //no data, ramps both wheels to a stop
+    SEQ_OP_WHEELS   = 0x01,  //signed left percent, signed right percent
+    SEQ_OP_VELOCITY = 0x02,  //signed 16-bit left and right edges/s
+    SEQ_OP_HOLD     = 0x03,  //16-bit time in ms before the next step
+    SEQ_OP_ACCEL    = 0x04   //ramp step, see DriveCtrl_SetAcceleration
+};
+
+typedef struct
+{
+    unsigned char op;
+    signed short left;      //or the hold time, or the ramp step
+    signed short right;
+} SeqStep;
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Functions
+////////////////////////////////////////////////////////////////////////////////
+void Sequencer_Initialize(void);
+int  Sequencer_Load(const unsigned char *steps, unsigned char length);
+int  Sequencer_Replay(void);
+void Sequencer_Cancel(void);
+int  Sequencer_IsRunning(void);
+void Sequencer_Task(void);
+
+#endif
@@ -0,0 +1,56 @@
+/*******************************************************************************
+  * @file Setpoint.h
+  * @brief Defines the setpoint jitter buffer. Continuous wheel targets from
+  *        a joystick are stamped with the time they were taken and played 
+  *        out a fixed delay later, interpolated between the samples either 
+  *        side, so a burst of late samples still gives smooth motion.
+  * @author David Sharpe
+  * @version V1.0.0
+  * @date 14-October-2026
+  *
+  * ST Visual Develop 4.2.1 using STM8 Cosmic C Compiler
+  *****************************************************************************/
+#ifndef SETPOINT_H
+#define SETPOINT_H
+
+////////////////////////////////////////////////////////////////////////////////
+// Includes
+////////////////////////////////////////////////////////////////////////////////
+#include "DriveController.h"
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Definitions
+////////////////////////////////////////////////////////////////////////////////
+
+//Samples are in controller time, see Clock.h, and play out SETPOINT_DELAY 
+//ms after they were taken. The delay must cover the link's jitter, a 
+//sample arriving later than that is too late to interpolate to. Samples 
+//older than the newest held are dropped, so repeats on a lossy link are 
+//harmless.
+#define SETPOINT_BUFFER_SIZE    4
+#define SETPOINT_DELAY          60  //ms
+#define SETPOINT_PERIOD         DRIVE_UPDATE_PERIOD
+
+//When the stream stalls the last slope is carried on for 
+//SETPOINT_EXTRAPOLATE ms, then the wheels ramp to a stop
+#define SETPOINT_EXTRAPOLATE    100 //ms
+
+typedef struct
+{
+    unsigned long time;     //robot time taken
+    signed char left;       //percent
+    signed char right;      //percent
+} SetpointSample;
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Functions
+////////////////////////////////////////////////////////////////////////////////
+void Setpoint_Initialize(void);
+void Setpoint_Add(unsigned long time, signed char left, signed char right);
+void Setpoint_Cancel(void);
+int  Setpoint_IsActive(void);
+void Setpoint_Task(void);
+
+#endif
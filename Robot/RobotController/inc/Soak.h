@@ -0,0 +1,64 @@
+/*******************************************************************************
+  * @file Soak.h
+  * @brief Defines the soak test counter snapshots. While a soak test runs
+  *        the robot sends every performance and error counter it keeps at a
+  *        fixed period, so a controller driving it for hours can chart how
+  *        they grow and catch a slow leak or a link that degrades.
+  * @author David Sharpe
+  * @version V1.0.0
+  * @date 14-October-2026
+  *
+  * ST Visual Develop 4.2.1 using STM8 Cosmic C Compiler
+  *****************************************************************************/
+#ifndef SOAK_H
+#define SOAK_H
+
+////////////////////////////////////////////////////////////////////////////////
+// Includes
+////////////////////////////////////////////////////////////////////////////////
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Definitions
+////////////////////////////////////////////////////////////////////////////////
+
+//Set to 0 to leave the soak snapshots out
+#ifndef SOAK_ENABLE
+#define SOAK_ENABLE         1
+#endif
+
+//A snapshot that cannot be queued is tried again this much later
+#define SOAK_RETRY          100 //ms
+
+//Snapshot of the counters since start up, 16-bit LSB first unless noted.
+//The counters saturate, uptime going back is a restart.
+//  uptime                  ms, 32-bit
+//  snapshot                number since the soak test started
+//  rx packets, dropped,    datagrams from the module and the ones lost
+//  oversize
+//  tx failed               datagrams the module failed to send
+//  module busy             times the module was busy when asked to send
+//  module recoveries       resyncs, link restarts and module resets
+//  frames rejected         frames that failed the checks
+//  commands recovered      repeated commands run in place of lost ones
+//  overrun, noise, framing,    UART receive errors
+//  ring full
+//  drive overruns          drive updates started late
+//  overcurrent trips
+//  failsafe trips
+//  stack peak              bytes
+//  datagrams queued, peak  primary link transmit pool blocks
+#define SOAK_REPORT_SIZE    42
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Functions
+////////////////////////////////////////////////////////////////////////////////
+#if SOAK_ENABLE
+void Soak_Start(unsigned char seconds);
+int  Soak_IsDue(void);
+unsigned char Soak_GetReport(unsigned char *report);
+void Soak_Release(int queued);
+#endif
+
+#endif
@@ -0,0 +1,43 @@
+/*******************************************************************************
+  * @file Spi.h
+  * @brief Defines the functions for the STM8S SPI as bus master. A transfer
+  *        is clocked out a byte per interrupt with the chip select held low
+  *        for the whole of it, so the main loop starts it and comes back
+  *        for the result.
+  * @author David Sharpe
+  * @version V1.0.0
+  * @date 14-October-2026
+  *
+  * ST Visual Develop 4.2.1 using STM8 Cosmic C Compiler
+  *****************************************************************************/
+#ifndef SPI_H
+#define SPI_H
+
+////////////////////////////////////////////////////////////////////////////////
+// Includes
+////////////////////////////////////////////////////////////////////////////////
+#include "Board.h"
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Definitions
+////////////////////////////////////////////////////////////////////////////////
+
+//Mode 0, MSB first, fMASTER / 4 is 4MHz. The interrupt takes each byte as
+//it completes and sends the next, so the line runs as fast as the
+//interrupt keeps up.
+#define SPI_BAUD_PRESCALER  SPI_BAUDRATEPRESCALER_4
+#define SPI_CS_PORT         BOARD_SPI_CS_PORT
+#define SPI_CS_PIN          BOARD_SPI_CS_PIN
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Functions
+////////////////////////////////////////////////////////////////////////////////
+void Spi_Initialize(void);
+int  Spi_Transfer(const unsigned char *tx, unsigned char *rx,
+                  unsigned char length);
+int  Spi_IsBusy(void);
+void Spi_ISR(void);
+
+#endif
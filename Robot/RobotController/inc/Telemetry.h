@@ -0,0 +1,114 @@
+/*******************************************************************************
+  * @file Telemetry.h
+  * @brief Defines the battery, motor current and drive telemetry
+  * @author David Sharpe
+  * @version V1.0.0
+  * @date 14-October-2026
+  *
+  * ST Visual Develop 4.2.1 using STM8 Cosmic C Compiler
+  *****************************************************************************/
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+////////////////////////////////////////////////////////////////////////////////
+// Includes
+////////////////////////////////////////////////////////////////////////////////
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Definitions
+////////////////////////////////////////////////////////////////////////////////
+
+//Analog inputs, ADC1 scans AIN0 up to the last channel
+enum TelemetryChannel
+{
+    TELEMETRY_BATTERY,      //PB0 AIN0, battery through the divider
+    TELEMETRY_LEFT_CURRENT, //PB1 AIN1, left motor current sense
+    TELEMETRY_RIGHT_CURRENT,//PB2 AIN2, right motor current sense
+    TELEMETRY_CHANNEL_COUNT
+};
+
+//Scaling. The ADC reference is VDD, the battery divider is 20k over 10k and
+//the current sense amplifiers give 1V per A.
+#define TELEMETRY_VREF_MV       5000
+#define TELEMETRY_BATTERY_RATIO 3
+#define TELEMETRY_MA_PER_V      1000
+
+//Each scan is filtered by an exponential average with a time constant of
+//2^TELEMETRY_FILTER_SHIFT scans, one scan per 1ms tick
+#define TELEMETRY_FILTER_SHIFT  4
+
+//Sample rate. Telemetry_Update runs every TELEMETRY_PERIOD ms and the 
+//sample period is a multiple of it.
+#define TELEMETRY_PERIOD        10 //ms
+
+//Samples are kept in a ring and sent TELEMETRY_BATCH at a time so each 
+//CIPSEND carries several. The oldest sample is dropped if the ring fills.
+#define TELEMETRY_RING_SIZE     8  //Power of 2, 64 bytes of ring
+#define TELEMETRY_BATCH         4
+
+//Rate adaptation. Each congested batch doubles the sample period, up to 
+//2^TELEMETRY_MAX_SHIFT times the configured one. TELEMETRY_RECOVER_BATCHES
+//clean batches in a row halve it again.
+#define TELEMETRY_MAX_SHIFT       3
+#define TELEMETRY_RECOVER_BATCHES 8
+
+//Sample, 16-bit values LSB first:
+//  battery                 filtered battery voltage, mV
+//  left, right             filtered motor currents, mA
+//  left duty, right duty   signed duty percentages
+#define TELEMETRY_SAMPLE_SIZE   8
+
+//Report header followed by the samples, oldest first:
+//  period                  sample period, 10ms units
+//  count                   number of samples
+//  dropped                 samples lost since the last report, saturates
+//  overruns                drive update overruns, low byte
+//  battery min             lowest filtered voltage since the last report, mV
+//  range min               nearest obstacle since the last report, mm, 
+//                          0xFFFF when clear
+#define TELEMETRY_HEADER_SIZE   8
+#define TELEMETRY_REPORT_SIZE   (TELEMETRY_HEADER_SIZE + \
+                                 TELEMETRY_BATCH * TELEMETRY_SAMPLE_SIZE)
+
+//Report formats. A compact report holds the same header, then a key byte
+//and the samples coded against the sample before them, oldest first:
+//  key                     bit 7 set on a keyframe, the first sample is 
+//                          then coded against zero. Bits 0 to 6 count the 
+//                          reports, a decoder that misses one waits for 
+//                          the next keyframe.
+//  sample                  a mask with bit n set for each field that 
+//                          changed, battery, left, right, left duty then 
+//                          right duty, then the change of each of those as
+//                          a zig-zag varint, 7 bits a byte LSB first with 
+//                          bit 7 set on all but the last
+//A steady sample is the 1 byte mask. The report takes as many samples as
+//fit in TELEMETRY_REPORT_SIZE, the rest wait for the next one.
+enum TelemetryFormat
+{
+    TELEMETRY_FORMAT_FULL,
+    TELEMETRY_FORMAT_COMPACT,
+    TELEMETRY_FORMAT_COUNT
+};
+
+#define TELEMETRY_FIELD_COUNT   5
+#define TELEMETRY_KEY_INTERVAL  8 //reports from one keyframe to the next
+#define TELEMETRY_KEY_FLAG      0x80
+#define TELEMETRY_CODED_MAX     (1 + TELEMETRY_FIELD_COUNT * 3)
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Functions
+////////////////////////////////////////////////////////////////////////////////
+void Telemetry_Initialize(void);
+void Telemetry_SetPeriod(unsigned short ms);
+void Telemetry_SetFormat(unsigned char format);
+unsigned char Telemetry_GetFormat(void);
+int  Telemetry_Update(void);
+void Telemetry_SetCongested(int congested);
+unsigned short Telemetry_GetBattery(void);
+unsigned short Telemetry_GetCurrent(unsigned char motor);
+unsigned char Telemetry_GetReport(unsigned char *report);
+void Telemetry_ADCISR(void);
+
+#endif
@@ -0,0 +1,59 @@
+/*******************************************************************************
+  * @file TouchPanel.h
+  * @brief Defines the touch panel, the keys and slider of the Touch Sensing
+  *        library read once a scan of them has finished. The library works
+  *        through a scan one step at a time, as many steps are run on each
+  *        call as fit the acquisition budget so adding channels makes the 
+  *        scans take more calls rather than the calls take longer.
+  * @author David Sharpe
+  * @version V1.0.0
+  * @date 14-October-2026
+  *
+  * ST Visual Develop 4.2.1 using STM8 Cosmic C Compiler
+  *****************************************************************************/
+#ifndef TOUCH_PANEL_H
+#define TOUCH_PANEL_H
+
+////////////////////////////////////////////////////////////////////////////////
+// Includes
+////////////////////////////////////////////////////////////////////////////////
+#include "stm8_tsl_api.h"
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Definitions
+////////////////////////////////////////////////////////////////////////////////
+
+//Acquisition time allowed in each TouchPanel_Scan call. A step is only 
+//started if the worst time it has taken so far still fits, at least one 
+//step is run. TOUCH_PANEL_ENABLE in stm8_tsl_conf.h selects the channels.
+#define TOUCH_BUDGET            500 //us
+#define TOUCH_COST_UNIT         16  //us, resolution of the step times kept
+
+//Keys in the mask from TouchPanel_GetKeys, in the library's key order
+#define TOUCH_KEY_STOP          0x01 //PC1, the gesture key
+#if TOUCH_PANEL_ENABLE
+#define TOUCH_KEY_SLOW          0x02 //PE6, selects TOUCH_PRESET_SLOW
+#define TOUCH_KEY_FULL          0x04 //PE7, selects full speed
+
+#define TOUCH_PRESET_SLOW       50 //percent
+
+//Slider positions, 0 at the PB3 end
+#define TOUCH_SLIDER_STEPS      (1 << MCKEY_RESOLUTION_DEFAULT)
+#endif
+
+#define TOUCH_NO_SLIDER         0xFF //slider position when it is not touched
+
+//Library scan states, each has its worst step time kept
+#define TOUCH_STATE_COUNT       (TSL_ECS_STATE + 1)
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Functions
+////////////////////////////////////////////////////////////////////////////////
+void TouchPanel_Initialize(void);
+int  TouchPanel_Scan(void);
+unsigned char TouchPanel_GetKeys(void);
+unsigned char TouchPanel_GetSlider(void);
+
+#endif
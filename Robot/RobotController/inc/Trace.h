@@ -0,0 +1,77 @@
+/*******************************************************************************
+  * @file Trace.h
+  * @brief Defines the link trace recorder, a RAM ring of timestamped UART
+  *        bytes, receive parser events and command dispatches kept for
+  *        reading back when the ESP8266 link misbehaves
+  * @author David Sharpe
+  * @version V1.0.0
+  * @date 14-October-2026
+  *
+  * ST Visual Develop 4.2.1 using STM8 Cosmic C Compiler
+  *****************************************************************************/
+#ifndef TRACE_H
+#define TRACE_H
+
+////////////////////////////////////////////////////////////////////////////////
+// Includes
+////////////////////////////////////////////////////////////////////////////////
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Definitions
+////////////////////////////////////////////////////////////////////////////////
+
+//Set to 0 to leave the recorder out. Recording an event is a masked store of
+//4 bytes so it is kept in release builds, the ring costs TRACE_SIZE * 4 bytes
+//of RAM.
+#ifndef TRACE_ENABLE
+#define TRACE_ENABLE        1
+#endif
+
+#define TRACE_SIZE          64 //events, power of 2, the oldest is overwritten
+#define TRACE_PAGE          8  //events per report
+
+//Recorded events and their data
+enum TraceType
+{
+    TRACE_UART_RX,      //byte received
+    TRACE_UART_TX,      //byte sent
+    TRACE_UART_ERROR,   //receive status register with an error flag set
+    TRACE_RX_STATE,     //receive parser state entered, see RxState
+    TRACE_RX_TOKEN,     //response token matched, see Esp8266Matcher.h
+    TRACE_COMMAND       //protocol command dispatched, see ProtoCommand
+};
+
+typedef struct
+{
+    unsigned char type;
+    unsigned char data;
+    unsigned short time;    //ms, low 16 bits of the scheduler time
+} TraceEvent;
+
+//Report:
+//  first                   index of the first event, 0 is the oldest
+//  count                   events held, up to TRACE_SIZE
+//  type, data, time        for up to TRACE_PAGE events from the first, the
+//                          time 16-bit LSB first
+#define TRACE_REPORT_SIZE   (2 + (TRACE_PAGE * 4))
+
+//Probe
+#if TRACE_ENABLE
+#define TRACE(type, data)   Trace_Record(type, data)
+#else
+#define TRACE(type, data)
+#endif
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Functions
+////////////////////////////////////////////////////////////////////////////////
+#if TRACE_ENABLE
+void Trace_Start(void);
+void Trace_Stop(void);
+void Trace_Record(unsigned char type, unsigned char data);
+unsigned char Trace_GetReport(unsigned char first, unsigned char *report);
+#endif
+
+#endif
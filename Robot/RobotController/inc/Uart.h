@@ -1,39 +1,77 @@
-/*******************************************************************************
-  * @file Uart.h
-  * @brief Defines the functions for interfacing to the STMS8 UART
-  * @author David Sharpe
-  * @version V1.0.0
-  * @date 02-June-2015
-  *
-  * ST Visual Develop 4.2.1 using STM8 Cosmic C Compiler
-  *****************************************************************************/
-#ifndef UART_H
-#define UART_H
-
-////////////////////////////////////////////////////////////////////////////////
-// Includes
-////////////////////////////////////////////////////////////////////////////////
-
-
-////////////////////////////////////////////////////////////////////////////////
-// Definitions
-////////////////////////////////////////////////////////////////////////////////
-#define UART_BUFFER_SIZE  64
-
-typedef void(*Callback)(unsigned char);
-
-////////////////////////////////////////////////////////////////////////////////
-// Functions
-////////////////////////////////////////////////////////////////////////////////
-void Uart_Initialize(unsigned long baud);
-void Uart_Send(unsigned char *buffer, unsigned long length);
-void Uart_SendByte(unsigned char byte);
-void Uart_ReceiveISR(void);
-int  Uart_IsRxDataReady(void);
-unsigned char Uart_GetRxData(void);
-void Uart_ClearRxFifo(void);
-void Uart_EnableRxInterrupt(void);
-void Uart_SetRxCallback(Callback func);
-void Uart_Print(char *str);
-
+/*******************************************************************************
+  * @file Uart.h
+  * @brief Defines the functions for interfacing to the STMS8 UART
+  * @author David Sharpe
+  * @version V1.0.0
+  * @date 02-June-2015
+  *
+  * ST Visual Develop 4.2.1 using STM8 Cosmic C Compiler
+  *****************************************************************************/
+#ifndef UART_H
+#define UART_H
+
+////////////////////////////////////////////////////////////////////////////////
+// Includes
+////////////////////////////////////////////////////////////////////////////////
+#include "CmdBuilder.h"
+#include "Board.h"
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Definitions
+////////////////////////////////////////////////////////////////////////////////
+#define UART_BUFFER_SIZE     128 //Power of 2, at most RING_MAX_SIZE
+#define UART_IDLE_MARKS      8   //Idle line events queued, power of 2
+#define UART_TX_BUFFER_SIZE  128 //Power of 2, at most RING_MAX_SIZE
+
+//Set to 1 to hold the module's data with an RTS line driven in software 
+//while the receiver falls behind, UART2 has no hardware flow control. The
+//module is told to watch its CTS input by AT+UART_CUR.
+#define UART_FLOW_CONTROL    0
+#define UART_RTS_PORT        BOARD_RTS_PORT
+#define UART_RTS_PIN         BOARD_RTS_PIN //To the module CTS (GPIO13)
+#define UART_RX_HIGH_WATER   96  //Bytes in the receive ring that hold it
+
+//Receive errors counted by the RX interrupt
+enum UartError
+{
+    UART_ERROR_OVERRUN,   //bytes lost, one arrived before the last was read
+    UART_ERROR_NOISE,     //noise while receiving, the byte is kept
+    UART_ERROR_FRAMING,   //no stop bit, the byte is dropped
+    UART_ERROR_RING_FULL, //receive ring full, the byte is dropped
+    UART_ERROR_COUNT
+};
+
+//Receive events, see Uart_GetRxEvent
+enum UartRxEvent
+{
+    UART_RX_NONE,
+    UART_RX_BYTE,
+    UART_RX_IDLE
+};
+
+////////////////////////////////////////////////////////////////////////////////
+// Functions
+////////////////////////////////////////////////////////////////////////////////
+void Uart_Initialize(unsigned long baud);
+void Uart_Send(unsigned char *buffer, unsigned short length);
+void Uart_SendByte(unsigned char byte);
+int  Uart_SendAsync(unsigned char *buffer, unsigned short length);
+void Uart_BeginCommand(CmdBuilder *cmd);
+int  Uart_EndCommand(CmdBuilder *cmd);
+unsigned short Uart_GetTxSpace(void);
+int  Uart_IsTxEmpty(void);
+void Uart_ReceiveISR(void);
+void Uart_TransmitISR(void);
+unsigned char Uart_GetRxEvent(unsigned char *byte);
+unsigned char Uart_GetRxCount(void);
+int  Uart_IsRxDataReady(void);
+unsigned char Uart_GetRxData(void);
+void Uart_ClearRxFifo(void);
+void Uart_EnableRxInterrupt(void);
+void Uart_EnableIdleInterrupt(void);
+unsigned short Uart_GetErrorCount(unsigned char error);
+void Uart_SetRxHold(unsigned char hold);
+void Uart_Print(char *str);
+
 #endif
\ No newline at end of file
@@ -0,0 +1,199 @@
+/*******************************************************************************
+  * @file Benchmark.c
+  * @brief Implements the link benchmark statistics. While running, the time
+  *        each ping spends between the stages of the receive and reply path
+  *        is recorded and reported to the remote as a compact binary packet.
+  * @author David Sharpe
+  * @version V1.0.0
+  * @date 14-October-2026
+  *
+  * ST Visual Develop 4.2.1 using STM8 Cosmic C Compiler
+  *****************************************************************************/
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Includes
+////////////////////////////////////////////////////////////////////////////////
+#include "Benchmark.h"
+#include "Esp8266.h"
+#include "Uart.h"
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Prototypes
+////////////////////////////////////////////////////////////////////////////////
+unsigned char *Bench_PutShort(unsigned char *buffer, unsigned short value);
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Variables
+////////////////////////////////////////////////////////////////////////////////
+unsigned char benchRunning = 0;
+BenchStat benchStats[BENCH_INTERVAL_COUNT];
+
+//Link error counts when the benchmark started
+unsigned short benchRxLostStart = 0;
+unsigned short benchTxFailStart = 0;
+unsigned short benchUartErrorStart[UART_ERROR_COUNT];
+
+
+/*******************************************************************************
+  * @brief Clear the statistics and start recording
+  * @par Parameters: None
+  * @retval None
+  *****************************************************************************/
+void Bench_Start(void)
+{
+    unsigned char i = 0;
+
+    for(i = 0; i < BENCH_INTERVAL_COUNT; i++)
+    {
+        benchStats[i].count = 0;
+        benchStats[i].min = 0xFFFF;
+        benchStats[i].max = 0;
+        benchStats[i].sum = 0;
+    }
+
+    benchRxLostStart = Esp8266_GetRxDropCount() + Esp8266_GetRxOversizeCount();
+    benchTxFailStart = Esp8266_GetTxFailCount();
+    
+    for(i = 0; i < UART_ERROR_COUNT; i++)
+    {
+        benchUartErrorStart[i] = Uart_GetErrorCount(i);
+    }
+    
+    benchRunning = 1;
+}
+
+/*******************************************************************************
+  * @brief Stop recording, the statistics are kept for the report
+  * @par Parameters: None
+  * @retval None
+  *****************************************************************************/
+void Bench_Stop(void)
+{
+    benchRunning = 0;
+}
+
+/*******************************************************************************
+  * @brief Check if the benchmark is recording
+  * @par Parameters: None
+  * @retval 1 if running, 0 otherwise
+  *****************************************************************************/
+int Bench_IsRunning(void)
+{
+    return benchRunning;
+}
+
+/*******************************************************************************
+  * @brief Record one measurement of an interval
+  * @par Parameters:
+  * interval - one of BenchInterval
+  * micros - measured time in us
+  * @retval None
+  *****************************************************************************/
+void Bench_Record(unsigned char interval, unsigned short micros)
+{
+    BenchStat *stat = 0;
+
+    if(!benchRunning || interval >= BENCH_INTERVAL_COUNT)
+    {
+        return;
+    }
+
+    stat = &benchStats[interval];
+
+    //Hold the statistics once the count is full rather than wrap
+    if(stat->count == 0xFFFF)
+    {
+        return;
+    }
+
+    stat->count++;
+    stat->sum += micros;
+
+    if(micros < stat->min)
+    {
+        stat->min = micros;
+    }
+
+    if(micros > stat->max)
+    {
+        stat->max = micros;
+    }
+}
+
+/*******************************************************************************
+  * @brief Datagram completion callback, records the time the module took to
+  *        send each datagram
+  * @par Parameters:
+  * result - send result
+  * micros - time from queueing to completion in us
+  * @retval None
+  *****************************************************************************/
+void Bench_SendCallback(unsigned char result, unsigned short micros)
+{
+    if(result == ESP8266_AT_OK)
+    {
+        Bench_Record(BENCH_SENT_TO_DONE, micros);
+    }
+}
+
+/*******************************************************************************
+  * @brief Write the statistics report
+  * @par Parameters:
+  * report - buffer of at least BENCH_REPORT_SIZE bytes
+  * @retval report length in bytes
+  *****************************************************************************/
+unsigned char Bench_GetReport(unsigned char *report)
+{
+    unsigned char *next = report;
+    BenchStat *stat = 0;
+    unsigned char i = 0;
+
+    next = Bench_PutShort(next, benchStats[BENCH_RX_TO_DISPATCH].count);
+
+    for(i = 0; i < BENCH_INTERVAL_COUNT; i++)
+    {
+        stat = &benchStats[i];
+
+        if(stat->count == 0)
+        {
+            next = Bench_PutShort(next, 0);
+            next = Bench_PutShort(next, 0);
+            next = Bench_PutShort(next, 0);
+        }
+        else
+        {
+            next = Bench_PutShort(next, stat->min);
+            next = Bench_PutShort(next, stat->max);
+            next = Bench_PutShort(next, (unsigned short)(stat->sum / stat->count));
+        }
+    }
+
+    next = Bench_PutShort(next, Esp8266_GetRxDropCount() +
+                          Esp8266_GetRxOversizeCount() - benchRxLostStart);
+    next = Bench_PutShort(next, Esp8266_GetTxFailCount() - benchTxFailStart);
+
+    for(i = 0; i < UART_ERROR_COUNT; i++)
+    {
+        next = Bench_PutShort(next, Uart_GetErrorCount(i) - benchUartErrorStart[i]);
+    }
+
+    return (unsigned char)(next - report);
+}
+
+/*******************************************************************************
+  * @brief Write a 16-bit value LSB first
+  * @par Parameters:
+  * buffer - destination
+  * value - value to write
+  * @retval position after the value
+  *****************************************************************************/
+unsigned char *Bench_PutShort(unsigned char *buffer, unsigned short value)
+{
+    buffer[0] = (unsigned char)value;
+    buffer[1] = (unsigned char)(value >> 8);
+
+    return buffer + 2;
+}
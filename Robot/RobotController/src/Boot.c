@@ -0,0 +1,210 @@
+/*******************************************************************************
+  * @file Boot.c
+  * @brief Implements the resident boot copier. When the staging header
+  *        holds the magic and the staged image matches its CRC, the image
+  *        is copied over the application a word at a time and checked, and
+  *        only then is the header cleared. Power lost part way leaves the
+  *        header set and the copy starts over at the next reset, words
+  *        already copied are skipped.
+  *
+  *        Block writes would have to run from RAM, which the C startup
+  *        fills and the copier runs before, so it uses word writes that
+  *        stall the CPU from flash. A whole image takes around 20 s, the
+  *        watchdog is reloaded on every word. Addresses and sums are all
+  *        16-bit, long arithmetic would call the compiler's library, which
+  *        is in the application.
+  * @author David Sharpe
+  * @version V1.0.0
+  * @date 14-October-2026
+  *
+  * ST Visual Develop 4.2.1 using STM8 Cosmic C Compiler
+  *****************************************************************************/
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Includes
+////////////////////////////////////////////////////////////////////////////////
+#include "Boot.h"
+#include <string.h>
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Definitions
+////////////////////////////////////////////////////////////////////////////////
+#if defined(_COSMIC_)
+
+//Register access, the library is in the application
+#define BOOT_READ(address)      (*(volatile const unsigned char *)(address))
+#define BOOT_RELOAD()           (IWDG->KR = IWDG_KEY_REFRESH)
+
+#else
+
+#define BOOT_READ(address)      FLASH_ReadByte(address)
+#define BOOT_RELOAD()           IWDG_ReloadCounter()
+
+#endif
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Prototypes
+////////////////////////////////////////////////////////////////////////////////
+unsigned short Boot_Crc16(unsigned short address, unsigned short length);
+void Boot_WriteWord(unsigned short address, const unsigned char *bytes);
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Functions
+////////////////////////////////////////////////////////////////////////////////
+#if defined(_COSMIC_)
+#pragma section (boot)
+#endif
+
+/*******************************************************************************
+  * @brief Reset entry, in place of the C startup. The stack pointer is
+  *        already at the top of RAM. The application is started through
+  *        the reset entry of its vector table.
+  * @par Parameters: None
+  * @retval None
+  *****************************************************************************/
+void Boot_Reset(void)
+{
+    Boot_Apply();
+
+    ((void (*)(void))OTA_APP_START)();
+}
+
+/*******************************************************************************
+  * @brief Copy the staged image over the application if there is one
+  * @par Parameters: None
+  * @retval 1 if an image was copied, 0 otherwise
+  *****************************************************************************/
+int Boot_Apply(void)
+{
+    unsigned short length = 0;
+    unsigned short crc = 0;
+    unsigned short offset = 0;
+    unsigned char word[BOOT_WORD_SIZE];
+    unsigned char i = 0;
+
+    if(BOOT_READ(OTA_HEADER_START + OTA_HEADER_MAGIC) != (unsigned char)OTA_MAGIC ||
+       BOOT_READ(OTA_HEADER_START + OTA_HEADER_MAGIC + 1) != (unsigned char)(OTA_MAGIC >> 8))
+    {
+        return 0;
+    }
+
+    length = BOOT_READ(OTA_HEADER_START + OTA_HEADER_LENGTH) |
+             (unsigned short)BOOT_READ(OTA_HEADER_START + OTA_HEADER_LENGTH + 1) << 8;
+    crc = BOOT_READ(OTA_HEADER_START + OTA_HEADER_CRC) |
+          (unsigned short)BOOT_READ(OTA_HEADER_START + OTA_HEADER_CRC + 1) << 8;
+
+    if(length == 0 || length > OTA_IMAGE_MAX ||
+       Boot_Crc16(OTA_STAGING_START, length) != crc)
+    {
+        return 0;
+    }
+
+    for(offset = 0; offset < length; offset += BOOT_WORD_SIZE)
+    {
+        //Bytes past the end of the image are copied too, the staging
+        //block reads as erased there
+        for(i = 0; i < BOOT_WORD_SIZE; i++)
+        {
+            word[i] = BOOT_READ(OTA_STAGING_START + offset + i);
+        }
+
+        for(i = 0; i < BOOT_WORD_SIZE; i++)
+        {
+            if(BOOT_READ(OTA_APP_START + offset + i) != word[i])
+            {
+                Boot_WriteWord(OTA_APP_START + offset, word);
+                break;
+            }
+        }
+
+        BOOT_RELOAD();
+    }
+
+    //Copied wrong the header stays and the copy is tried again
+    if(Boot_Crc16(OTA_APP_START, length) != crc)
+    {
+        return 0;
+    }
+
+    for(i = 0; i < BOOT_WORD_SIZE; i++)
+    {
+        word[i] = 0;
+    }
+
+    Boot_WriteWord(OTA_HEADER_START + OTA_HEADER_MAGIC, word);
+    return 1;
+}
+
+/*******************************************************************************
+  * @brief Compute the CRC-16/CCITT-FALSE of program memory, the same as
+  *        Ota_Crc16
+  * @par Parameters:
+  * address - first byte
+  * length - length in bytes
+  * @retval CRC-16
+  *****************************************************************************/
+unsigned short Boot_Crc16(unsigned short address, unsigned short length)
+{
+    unsigned short crc = 0xFFFF;
+    unsigned short i = 0;
+    unsigned char bit = 0;
+
+    for(i = 0; i < length; i++)
+    {
+        crc ^= (unsigned short)BOOT_READ(address + i) << 8;
+
+        for(bit = 0; bit < 8; bit++)
+        {
+            crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+        }
+    }
+
+    return crc;
+}
+
+/*******************************************************************************
+  * @brief Write a word of program memory, the CPU stalls until it is done
+  * @par Parameters:
+  * address - first byte, a multiple of 4
+  * bytes - BOOT_WORD_SIZE bytes to write
+  * @retval None
+  *****************************************************************************/
+void Boot_WriteWord(unsigned short address, const unsigned char *bytes)
+{
+#if defined(_COSMIC_)
+    volatile unsigned char *target = (volatile unsigned char *)address;
+    unsigned char i = 0;
+
+    FLASH->PUKR = 0x56;
+    FLASH->PUKR = 0xAE;
+    FLASH->CR2 |= FLASH_CR2_WPRG;
+    FLASH->NCR2 &= (unsigned char)~FLASH_NCR2_NWPRG;
+
+    for(i = 0; i < BOOT_WORD_SIZE; i++)
+    {
+        target[i] = bytes[i];
+    }
+
+    while(!(FLASH->IAPSR & (FLASH_IAPSR_EOP | FLASH_IAPSR_WR_PG_DIS)))
+    {
+    }
+
+    FLASH->IAPSR &= (unsigned char)~FLASH_IAPSR_PUL;
+#else
+    unsigned long word = 0;
+
+    //The library takes the word in memory order, as Config.c gives it
+    FLASH_Unlock(FLASH_MEMTYPE_PROG);
+    memcpy(&word, bytes, BOOT_WORD_SIZE);
+    FLASH_ProgramWord(address, word);
+    FLASH_Lock(FLASH_MEMTYPE_PROG);
+#endif
+}
+
+#if defined(_COSMIC_)
+#pragma section ()
+#endif
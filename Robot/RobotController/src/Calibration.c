@@ -0,0 +1,269 @@
+/*******************************************************************************
+  * @file Calibration.c
+  * @brief Implements the wheel characterization run. Both wheels are driven
+  *        open loop at each calibration point with the trim and calibration
+  *        out of the way, and the encoder edges over a fixed window give the
+  *        speed of each. The slower wheel sets the speed of each point and
+  *        the faster one gets the duty on its own curve that matches it, so
+  *        a straight command drives straight with the velocity loop off. The
+  *        result replaces the trim and is saved with the configuration. Like
+  *        a sequence the run holds off the failsafe and any drive command 
+  *        from the remote cancels it.
+  * @author David Sharpe
+  * @version V1.0.0
+  * @date 14-October-2026
+  *
+  * ST Visual Develop 4.2.1 using STM8 Cosmic C Compiler
+  *****************************************************************************/
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Includes
+////////////////////////////////////////////////////////////////////////////////
+#include "Calibration.h"
+#include "Config.h"
+#include "DriveController.h"
+#include "Encoder.h"
+#include "Failsafe.h"
+#include "Log.h"
+#include "Scheduler.h"
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Prototypes
+////////////////////////////////////////////////////////////////////////////////
+void StartPoint(void);
+void FinishCalibration(void);
+void RestoreCalibration(void);
+unsigned char MatchSpeed(const unsigned short *speeds, unsigned short target);
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Variables
+////////////////////////////////////////////////////////////////////////////////
+
+//Duties of an uncalibrated wheel
+const unsigned char CAL_IDENTITY[DRIVE_CAL_POINTS] = {25, 50, 75, 100};
+
+unsigned char calRunning = 0;
+unsigned char calPoint = 0;
+unsigned char calMeasuring = 0;
+unsigned long calEnd = 0;
+
+//Encoder counts at the start of the window and the speeds measured at each
+//point, edges/s
+unsigned short calStartCount[ENCODER_COUNT];
+unsigned short calSpeed[ENCODER_COUNT][DRIVE_CAL_POINTS];
+
+
+/*******************************************************************************
+  * @brief Start a characterization run from the first point, replacing a
+  *        run in progress
+  * @par Parameters: None
+  * @retval None
+  *****************************************************************************/
+void Calibration_Start(void)
+{
+    DriveCtrl_SetTrim(SPEED_FULL, SPEED_FULL);
+    DriveCtrl_SetCalibration(CAL_IDENTITY, CAL_IDENTITY);
+    
+    calRunning = 1;
+    calPoint = 0;
+    StartPoint();
+}
+
+/*******************************************************************************
+  * @brief Stop the run and put back the saved trim and calibration. The 
+  *        wheels are left as they are for the command that replaces it.
+  * @par Parameters: None
+  * @retval None
+  *****************************************************************************/
+void Calibration_Cancel(void)
+{
+    if(calRunning)
+    {
+        calRunning = 0;
+        RestoreCalibration();
+    }
+}
+
+/*******************************************************************************
+  * @brief Check if a characterization run is in progress
+  * @par Parameters: None
+  * @retval 1 if running, 0 otherwise
+  *****************************************************************************/
+int Calibration_IsRunning(void)
+{
+    return calRunning;
+}
+
+/*******************************************************************************
+  * @brief Calibration task, opens and closes the measurement window of each
+  *        point. Called every CALIBRATION_PERIOD ms.
+  * @par Parameters: None
+  * @retval None
+  *****************************************************************************/
+void Calibration_Task(void)
+{
+    unsigned char wheel = 0;
+    
+    if(!calRunning)
+    {
+        return;
+    }
+    
+    //The remote is quiet on purpose while the run drives
+    Failsafe_Feed();
+    
+    if(!Sched_IsExpired(calEnd))
+    {
+        return;
+    }
+    
+    if(!calMeasuring)
+    {
+        for(wheel = 0; wheel < ENCODER_COUNT; wheel++)
+        {
+            calStartCount[wheel] = Encoder_GetCount(wheel);
+        }
+        
+        calMeasuring = 1;
+        calEnd += CALIBRATION_MEASURE_TIME;
+        return;
+    }
+    
+    for(wheel = 0; wheel < ENCODER_COUNT; wheel++)
+    {
+        calSpeed[wheel][calPoint] = (unsigned short)
+            ((unsigned long)(unsigned short)(Encoder_GetCount(wheel) - 
+                                             calStartCount[wheel]) * 
+             1000 / CALIBRATION_MEASURE_TIME);
+    }
+    
+    LOG3(LOG_CALIBRATION_POINT, CAL_IDENTITY[calPoint], 
+         calSpeed[ENCODER_LEFT][calPoint], calSpeed[ENCODER_RIGHT][calPoint]);
+    
+    if(++calPoint < DRIVE_CAL_POINTS)
+    {
+        StartPoint();
+    }
+    else
+    {
+        FinishCalibration();
+    }
+}
+
+/*******************************************************************************
+  * @brief Drive both wheels at the duty of the current point and time the
+  *        settling
+  * @par Parameters: None
+  * @retval None
+  *****************************************************************************/
+void StartPoint(void)
+{
+    DriveCtrl_SetWheelDuty(CAL_IDENTITY[calPoint], CAL_IDENTITY[calPoint]);
+    calMeasuring = 0;
+    calEnd = Sched_GetTime() + CALIBRATION_SETTLE_TIME;
+}
+
+/*******************************************************************************
+  * @brief End the run, stop the wheels and save the calibration built from
+  *        the measurements. A wheel that did not turn at full duty leaves 
+  *        the saved calibration as it was.
+  * @par Parameters: None
+  * @retval None
+  *****************************************************************************/
+void FinishCalibration(void)
+{
+    unsigned char tables[ENCODER_COUNT][DRIVE_CAL_POINTS];
+    unsigned char trim[2] = {SPEED_FULL, SPEED_FULL};
+    unsigned short target = 0;
+    unsigned char wheel = 0;
+    unsigned char i = 0;
+    
+    calRunning = 0;
+    DriveCtrl_SetWheelDuty(0, 0);
+    
+    if(calSpeed[ENCODER_LEFT][DRIVE_CAL_POINTS - 1] == 0 ||
+       calSpeed[ENCODER_RIGHT][DRIVE_CAL_POINTS - 1] == 0)
+    {
+        LOG0(LOG_CALIBRATION_FAILED);
+        RestoreCalibration();
+        return;
+    }
+    
+    for(i = 0; i < DRIVE_CAL_POINTS; i++)
+    {
+        target = calSpeed[ENCODER_LEFT][i];
+        
+        if(calSpeed[ENCODER_RIGHT][i] < target)
+        {
+            target = calSpeed[ENCODER_RIGHT][i];
+        }
+        
+        for(wheel = 0; wheel < ENCODER_COUNT; wheel++)
+        {
+            tables[wheel][i] = MatchSpeed(calSpeed[wheel], target);
+            
+            //A noisy curve must still give a rising table
+            if(i > 0 && tables[wheel][i] < tables[wheel][i - 1])
+            {
+                tables[wheel][i] = tables[wheel][i - 1];
+            }
+        }
+    }
+    
+    //The tables take over from the trim
+    Config_SetField(CONFIG_FIELD_TRIM, trim, sizeof(trim));
+    Config_SetField(CONFIG_FIELD_CALIBRATION, &tables[0][0], sizeof(tables));
+    Config_Save();
+    RestoreCalibration();
+}
+
+/*******************************************************************************
+  * @brief Apply the trim and calibration of the configuration
+  * @par Parameters: None
+  * @retval None
+  *****************************************************************************/
+void RestoreCalibration(void)
+{
+    ConfigRecord *config = Config_Get();
+    
+    DriveCtrl_SetTrim(config->trim[0], config->trim[1]);
+    DriveCtrl_SetCalibration(config->calibration[0], config->calibration[1]);
+}
+
+/*******************************************************************************
+  * @brief Find the duty that gives a speed on the measured curve of a wheel,
+  *        interpolated between the points either side. The curve starts at
+  *        standstill with no duty.
+  * @par Parameters:
+  * speeds - speed of the wheel at each calibration point
+  * target - speed to match, at most the speed of the wheel at full duty
+  * @retval duty percentage
+  *****************************************************************************/
+unsigned char MatchSpeed(const unsigned short *speeds, unsigned short target)
+{
+    unsigned short low = 0;
+    unsigned char i = 0;
+    
+    for(i = 0; i < DRIVE_CAL_POINTS; i++)
+    {
+        if(target <= speeds[i])
+        {
+            //A point still in the dead band keeps its duty
+            if(speeds[i] == low)
+            {
+                return CAL_IDENTITY[i];
+            }
+            
+            return (unsigned char)(i * DRIVE_CAL_STEP + 
+                (((unsigned long)(target - low) * DRIVE_CAL_STEP + 
+                  ((speeds[i] - low) / 2)) / (speeds[i] - low)));
+        }
+        
+        low = speeds[i];
+    }
+    
+    return SPEED_FULL;
+}
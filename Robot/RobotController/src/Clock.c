@@ -0,0 +1,152 @@
+/*******************************************************************************
+  * @file Clock.c
+  * @brief Implements the command clock. The queue is kept in time order by
+  *        inserting each command behind the ones due no later, so the head
+  *        is always the next to run and commands for the same time run in
+  *        the order they arrived.
+  * @author David Sharpe
+  * @version V1.0.0
+  * @date 14-October-2026
+  *
+  * ST Visual Develop 4.2.1 using STM8 Cosmic C Compiler
+  *****************************************************************************/
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Includes
+////////////////////////////////////////////////////////////////////////////////
+#include "Clock.h"
+#include "Scheduler.h"
+#include "string.h"
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Variables
+////////////////////////////////////////////////////////////////////////////////
+
+//Controller time minus robot time
+unsigned long clockOffset = 0;
+
+//Held commands, the first clockCount in time order
+ClockEntry clockQueue[CLOCK_QUEUE_SIZE];
+unsigned char clockCount = 0;
+
+
+/*******************************************************************************
+  * @brief Empty the queue and forget the controller's clock
+  * @par Parameters: None
+  * @retval None
+  *****************************************************************************/
+void Clock_Initialize(void)
+{
+    clockOffset = 0;
+    clockCount = 0;
+}
+
+/*******************************************************************************
+  * @brief Set the offset of the controller's clock, commands already held
+  *        keep their time
+  * @par Parameters:
+  * offset - controller time minus robot time, ms
+  * @retval None
+  *****************************************************************************/
+void Clock_SetOffset(unsigned long offset)
+{
+    clockOffset = offset;
+}
+
+/*******************************************************************************
+  * @brief Convert a controller time to robot time
+  * @par Parameters:
+  * time - controller time, ms
+  * @retval robot time, ms, see Sched_GetTime
+  *****************************************************************************/
+unsigned long Clock_GetRobotTime(unsigned long time)
+{
+    return time - clockOffset;
+}
+
+/*******************************************************************************
+  * @brief Hold a command to run at a controller time
+  * @par Parameters:
+  * time - controller time, ms
+  * type - command type
+  * value - command data
+  * length - command data length in bytes
+  * @retval 1 if held, 0 if the queue is full, the command is too long or 
+  *         the time is too far ahead
+  *****************************************************************************/
+int Clock_Schedule(unsigned long time, unsigned char type, 
+                   const unsigned char *value, unsigned char length)
+{
+    unsigned long robotTime = Clock_GetRobotTime(time);
+    unsigned char i = clockCount;
+    
+    if(clockCount >= CLOCK_QUEUE_SIZE || length > CLOCK_VALUE_SIZE)
+    {
+        return 0;
+    }
+    
+    //Past times wrap to far ahead, they are due now
+    if((signed long)(robotTime - Sched_GetTime()) > CLOCK_HORIZON)
+    {
+        return 0;
+    }
+    
+    //Behind everything due no later
+    while(i > 0 && (signed long)(clockQueue[i - 1].time - robotTime) > 0)
+    {
+        clockQueue[i] = clockQueue[i - 1];
+        i--;
+    }
+    
+    clockQueue[i].time = robotTime;
+    clockQueue[i].type = type;
+    clockQueue[i].length = length;
+    memcpy(clockQueue[i].value, value, length);
+    clockCount++;
+    
+    return 1;
+}
+
+/*******************************************************************************
+  * @brief Drop every held command, for a stop that must not be undone by 
+  *        one held from before it
+  * @par Parameters: None
+  * @retval None
+  *****************************************************************************/
+void Clock_Clear(void)
+{
+    clockCount = 0;
+}
+
+/*******************************************************************************
+  * @brief Run the held command that is due, if any. Called from a task
+  *        every CLOCK_PERIOD so a command runs within a tick of its time.
+  * @par Parameters:
+  * handler - command handler
+  * @retval 1 if a command ran, 0 otherwise
+  *****************************************************************************/
+int Clock_Run(ProtoHandler handler)
+{
+    ClockEntry entry;
+    unsigned char i = 0;
+    
+    if(clockCount == 0 || !Sched_IsExpired(clockQueue[0].time))
+    {
+        return 0;
+    }
+    
+    //Off the queue first, the handler may hold another
+    entry = clockQueue[0];
+    clockCount--;
+    
+    for(i = 0; i < clockCount; i++)
+    {
+        clockQueue[i] = clockQueue[i + 1];
+    }
+    
+    handler(entry.type, entry.value, entry.length);
+    
+    return 1;
+}
@@ -0,0 +1,157 @@
+/*******************************************************************************
+  * @file CmdBuilder.c
+  * @brief Implements the AT command builder
+  * @author David Sharpe
+  * @version V1.0.0
+  * @date 14-October-2026
+  *
+  * ST Visual Develop 4.2.1 using STM8 Cosmic C Compiler
+  *****************************************************************************/
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Includes
+////////////////////////////////////////////////////////////////////////////////
+#include "CmdBuilder.h"
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Definitions
+////////////////////////////////////////////////////////////////////////////////
+//Place value of each digit, highest first
+const unsigned long POWERS_OF_TEN[CMD_MAX_DIGITS] =
+{
+    1000000000, 100000000, 10000000, 1000000, 100000,
+    10000, 1000, 100, 10, 1
+};
+
+
+/*******************************************************************************
+  * @brief Start a command in a plain buffer
+  * @par Parameters:
+  * cmd - the builder
+  * buffer - destination
+  * size - bytes the destination can take
+  * @retval None
+  *****************************************************************************/
+void Cmd_Begin(CmdBuilder *cmd, unsigned char *buffer, unsigned char size)
+{
+    cmd->buffer = buffer;
+    cmd->mask = 0xFF;
+    cmd->start = 0;
+    cmd->length = 0;
+    cmd->room = size;
+    cmd->overflow = 0;
+    cmd->ring = 0;
+}
+
+/*******************************************************************************
+  * @brief Start a command at the head of a ring. The bytes are written into
+  *        the free part of the ring and the consumer only sees them once 
+  *        Cmd_End publishes the whole command.
+  * @par Parameters:
+  * cmd - the builder
+  * ring - destination, the caller must be its producer
+  * @retval None
+  *****************************************************************************/
+void Cmd_BeginRing(CmdBuilder *cmd, Ring *ring)
+{
+    cmd->buffer = ring->buffer;
+    cmd->mask = ring->mask;
+    cmd->start = ring->head;
+    cmd->length = 0;
+    cmd->room = Ring_Space(ring);
+    cmd->overflow = 0;
+    cmd->ring = ring;
+}
+
+/*******************************************************************************
+  * @brief Add a character to the command
+  * @par Parameters:
+  * cmd - the builder
+  * c - the character
+  * @retval None
+  *****************************************************************************/
+void Cmd_AppendChar(CmdBuilder *cmd, char c)
+{
+    if(cmd->length >= cmd->room)
+    {
+        cmd->overflow = 1;
+        return;
+    }
+    
+    cmd->buffer[(unsigned char)(cmd->start + cmd->length) & cmd->mask] = c;
+    cmd->length++;
+}
+
+/*******************************************************************************
+  * @brief Add text to the command
+  * @par Parameters:
+  * cmd - the builder
+  * text - null terminated text
+  * @retval None
+  *****************************************************************************/
+void Cmd_AppendText(CmdBuilder *cmd, const char *text)
+{
+    while(*text)
+    {
+        Cmd_AppendChar(cmd, *text++);
+    }
+}
+
+/*******************************************************************************
+  * @brief Add an unsigned decimal to the command. Each digit is found by 
+  *        subtracting its place value, at most 9 times, which is far 
+  *        cheaper on the STM8 than dividing by 10.
+  * @par Parameters:
+  * cmd - the builder
+  * value - the number
+  * @retval None
+  *****************************************************************************/
+void Cmd_AppendUnsigned(CmdBuilder *cmd, unsigned long value)
+{
+    unsigned char i = 0;
+    char digit = 0;
+    
+    //Skip the leading zeros, zero itself keeps its last digit
+    while(i < CMD_MAX_DIGITS - 1 && value < POWERS_OF_TEN[i])
+    {
+        i++;
+    }
+    
+    for(; i < CMD_MAX_DIGITS; i++)
+    {
+        digit = '0';
+        
+        while(value >= POWERS_OF_TEN[i])
+        {
+            value -= POWERS_OF_TEN[i];
+            digit++;
+        }
+        
+        Cmd_AppendChar(cmd, digit);
+    }
+}
+
+/*******************************************************************************
+  * @brief Finish the command. A command built in a ring is published to the
+  *        consumer in one go.
+  * @par Parameters:
+  * cmd - the builder
+  * @retval command length in bytes, 0 if it did not fit and nothing was 
+  *         published
+  *****************************************************************************/
+unsigned char Cmd_End(CmdBuilder *cmd)
+{
+    if(cmd->overflow)
+    {
+        return 0;
+    }
+    
+    if(cmd->ring)
+    {
+        cmd->ring->head = cmd->start + cmd->length;
+    }
+    
+    return cmd->length;
+}
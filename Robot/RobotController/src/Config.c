@@ -0,0 +1,428 @@
+/*******************************************************************************
+  * @file Config.c
+  * @brief Implements the persistent configuration record. The record is
+  *        loaded from data EEPROM once at start up and kept in RAM. Saves
+  *        rotate through the EEPROM slots to spread the wear and are
+  *        programmed one word at a time by a periodic task, the EEPROM is
+  *        written while the program keeps running from flash.
+  * @author David Sharpe
+  * @version V1.0.0
+  * @date 14-October-2026
+  *
+  * ST Visual Develop 4.2.1 using STM8 Cosmic C Compiler
+  *****************************************************************************/
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Includes
+////////////////////////////////////////////////////////////////////////////////
+#include "Config.h"
+#include "DriveController.h"
+#include "Esp8266.h"
+#include "Failsafe.h"
+#include "Log.h"
+#include "Protocol.h"
+#include "Telemetry.h"
+#include "stm8s.h"
+#include "stddef.h"
+#include "string.h"
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Definitions
+////////////////////////////////////////////////////////////////////////////////
+//The CRC covers everything before it, not any padding the compiler adds
+#define CONFIG_CRC_LENGTH   offsetof(ConfigRecord, crc)
+#define CONFIG_WORDS        ((sizeof(ConfigRecord) + 3) / 4)
+
+//A record that outgrows its slot fails to compile
+typedef char ConfigRecordSizeCheck[(CONFIG_WORDS * 4 <= CONFIG_SLOT_SIZE) ? 
+                                   1 : -1];
+
+#define CONFIG_NO_SLOT      0xFF
+
+//Address of an EEPROM slot
+#define CONFIG_SLOT_ADDRESS(slot) \
+    (FLASH_DATA_START_PHYSICAL_ADDRESS + ((unsigned short)(slot) * CONFIG_SLOT_SIZE))
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Prototypes
+////////////////////////////////////////////////////////////////////////////////
+int  Config_ReadSlot(unsigned char slot);
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Variables
+////////////////////////////////////////////////////////////////////////////////
+ConfigRecord config;
+
+//The slot the record was loaded from or last saved to
+unsigned char configSlot = CONFIG_NO_SLOT;
+
+//Copy being written during a save, slot contents while loading
+ConfigRecord configImage;
+unsigned char configWriteSlot = 0;
+unsigned char configWriteWord = 0;
+unsigned char configSaving = 0;
+
+
+/*******************************************************************************
+  * @brief Load the newest valid record from EEPROM, the defaults are used if
+  *        there is none
+  * @par Parameters: None
+  * @retval 1 if a record was loaded, 0 if the defaults are used
+  *****************************************************************************/
+int Config_Load(void)
+{
+    unsigned char slot = 0;
+    unsigned char newest = CONFIG_NO_SLOT;
+
+    for(slot = 0; slot < CONFIG_SLOT_COUNT; slot++)
+    {
+        if(!Config_ReadSlot(slot))
+        {
+            continue;
+        }
+
+        //Sequence numbers wrap, newer is ahead by less than half the range
+        if(newest == CONFIG_NO_SLOT ||
+           (signed char)(configImage.sequence - config.sequence) > 0)
+        {
+            newest = slot;
+            config = configImage;
+        }
+    }
+
+    configSlot = newest;
+
+    if(newest == CONFIG_NO_SLOT)
+    {
+        Config_SetDefaults();
+        return 0;
+    }
+
+    return 1;
+}
+
+/*******************************************************************************
+  * @brief Get the configuration held in RAM
+  * @par Parameters: None
+  * @retval configuration record
+  *****************************************************************************/
+ConfigRecord *Config_Get(void)
+{
+    return &config;
+}
+
+/*******************************************************************************
+  * @brief Restore the default configuration in RAM, the EEPROM is unchanged
+  *        until the next save
+  * @par Parameters: None
+  * @retval None
+  *****************************************************************************/
+void Config_SetDefaults(void)
+{
+    unsigned char sequence = config.sequence;
+    unsigned char i = 0;
+
+    memset(&config, 0, sizeof(config));
+    config.version = CONFIG_VERSION;
+    config.sequence = sequence;
+    strcpy(config.apName, "STM8S_Robot");
+    strcpy(config.peerIp, "192.168.4.2");
+    config.peerPort = 49999;
+    config.baud = ESP8266_BAUD;
+    config.trim[0] = 100;
+    config.trim[1] = 100;
+    config.accel = DRIVE_ACCEL_DEFAULT;
+    config.ackMode = PROTO_ACK_CUMULATIVE;
+    config.failsafe = FAILSAFE_TIMEOUT_DEFAULT / 10;
+    config.robotId = 1;
+
+    for(i = 0; i < DRIVE_CAL_POINTS; i++)
+    {
+        config.calibration[0][i] = (i + 1) * DRIVE_CAL_STEP;
+        config.calibration[1][i] = (i + 1) * DRIVE_CAL_STEP;
+    }
+}
+
+/*******************************************************************************
+  * @brief Set one field of the configuration in RAM
+  * @par Parameters:
+  * field - CONFIG_FIELD_ value
+  * value - field data
+  * length - field data length in bytes
+  * @retval 1 if the field was set, 0 if the field or its value is not valid
+  *****************************************************************************/
+int Config_SetField(unsigned char field, const unsigned char *value,
+                    unsigned char length)
+{
+    unsigned long baud = 0;
+    unsigned char i = 0;
+
+    switch(field)
+    {
+        case CONFIG_FIELD_AP_NAME:
+            if(length == 0 || length >= CONFIG_NAME_SIZE)
+            {
+                return 0;
+            }
+
+            memcpy(config.apName, value, length);
+            config.apName[length] = 0;
+            break;
+
+        case CONFIG_FIELD_PEER_IP:
+            if(length < 7 || length >= CONFIG_IP_SIZE)
+            {
+                return 0;
+            }
+
+            memcpy(config.peerIp, value, length);
+            config.peerIp[length] = 0;
+            break;
+
+        case CONFIG_FIELD_PEER_PORT:
+            if(length < 2)
+            {
+                return 0;
+            }
+
+            config.peerPort = value[0] | (value[1] << 8);
+            break;
+
+        case CONFIG_FIELD_BAUD:
+            if(length < 4)
+            {
+                return 0;
+            }
+
+            baud = value[0] | ((unsigned long)value[1] << 8) |
+                   ((unsigned long)value[2] << 16) |
+                   ((unsigned long)value[3] << 24);
+
+            if(baud < 9600 || baud > 921600)
+            {
+                return 0;
+            }
+
+            config.baud = baud;
+            break;
+
+        case CONFIG_FIELD_TRIM:
+            if(length < 2 || value[0] > 100 || value[1] > 100)
+            {
+                return 0;
+            }
+
+            config.trim[0] = value[0];
+            config.trim[1] = value[1];
+            break;
+
+        case CONFIG_FIELD_ACCEL:
+            if(length < 1)
+            {
+                return 0;
+            }
+
+            config.accel = value[0];
+            break;
+
+        case CONFIG_FIELD_ACK_MODE:
+            if(length < 1 || value[0] > PROTO_ACK_ECHO)
+            {
+                return 0;
+            }
+
+            config.ackMode = value[0];
+            break;
+
+        case CONFIG_FIELD_FAILSAFE:
+            //The failsafe cannot be turned off
+            if(length < 1 || value[0] < FAILSAFE_TIMEOUT_MIN / 10)
+            {
+                return 0;
+            }
+
+            config.failsafe = value[0];
+            break;
+
+        case CONFIG_FIELD_TELEMETRY:
+            if(length < 1)
+            {
+                return 0;
+            }
+
+            config.telemetry = value[0];
+            break;
+
+        case CONFIG_FIELD_PWM:
+            if(length < 1 || value[0] >= DRIVE_PWM_PROFILE_COUNT)
+            {
+                return 0;
+            }
+
+            config.pwmProfile = value[0];
+            break;
+
+        case CONFIG_FIELD_CALIBRATION:
+            if(length < 2 * DRIVE_CAL_POINTS)
+            {
+                return 0;
+            }
+
+            //Each wheel rises to at most full duty
+            for(i = 0; i < 2 * DRIVE_CAL_POINTS; i++)
+            {
+                if(value[i] > SPEED_FULL ||
+                   ((i % DRIVE_CAL_POINTS) != 0 && value[i] < value[i - 1]))
+                {
+                    return 0;
+                }
+            }
+
+            memcpy(config.calibration, value, 2 * DRIVE_CAL_POINTS);
+            break;
+
+        case CONFIG_FIELD_ROBOT_ID:
+            if(length < 1 || value[0] == 0 || value[0] > PROTO_FLEET_ID_MAX)
+            {
+                return 0;
+            }
+
+            config.robotId = value[0];
+            break;
+
+        case CONFIG_FIELD_TELEMETRY_FORMAT:
+            if(length < 1 || value[0] >= TELEMETRY_FORMAT_COUNT)
+            {
+                return 0;
+            }
+
+            config.telemetryFormat = value[0];
+            break;
+
+        default:
+            return 0;
+    };
+
+    return 1;
+}
+
+/*******************************************************************************
+  * @brief Start writing the configuration to the next EEPROM slot. The write
+  *        is done by Config_Task, the previous record stays valid until the
+  *        new one is complete.
+  * @par Parameters: None
+  * @retval 1 if the save was started, 0 if a save is already in progress
+  *****************************************************************************/
+int Config_Save(void)
+{
+    if(configSaving)
+    {
+        return 0;
+    }
+
+    config.version = CONFIG_VERSION;
+    config.sequence++;
+    config.crc = Protocol_Crc8((const unsigned char *)&config, CONFIG_CRC_LENGTH);
+    configImage = config;
+
+    configWriteSlot = (configSlot == CONFIG_NO_SLOT) ? 0 : configSlot + 1;
+
+    if(configWriteSlot >= CONFIG_SLOT_COUNT)
+    {
+        configWriteSlot = 0;
+    }
+
+    configWriteWord = 0;
+    configSaving = 1;
+
+    FLASH_Unlock(FLASH_MEMTYPE_DATA);
+
+    return 1;
+}
+
+/*******************************************************************************
+  * @brief Check if a save is in progress
+  * @par Parameters: None
+  * @retval 1 if saving, 0 otherwise
+  *****************************************************************************/
+int Config_IsSaving(void)
+{
+    return configSaving;
+}
+
+/*******************************************************************************
+  * @brief EEPROM write task, programs the next word of a save once the
+  *        previous one has finished. Called every CONFIG_WRITE_PERIOD ms.
+  * @par Parameters: None
+  * @retval None
+  *****************************************************************************/
+void Config_Task(void)
+{
+    unsigned long word = 0;
+
+    if(!configSaving)
+    {
+        return;
+    }
+
+    //Still programming the previous word
+    if(configWriteWord > 0 && FLASH_GetFlagStatus(FLASH_FLAG_EOP) == RESET)
+    {
+        return;
+    }
+
+    if(configWriteWord < CONFIG_WORDS)
+    {
+        //Bytes past the end of the record are padding
+        memcpy(&word, (unsigned char *)&configImage + (configWriteWord * 4),
+               (configWriteWord < CONFIG_WORDS - 1) ? 4 :
+               sizeof(ConfigRecord) - (configWriteWord * 4));
+
+        FLASH_ProgramWord(CONFIG_SLOT_ADDRESS(configWriteSlot) +
+                          (configWriteWord * 4), word);
+        configWriteWord++;
+        return;
+    }
+
+    //Done, check the record before moving to the new slot
+    FLASH_Lock(FLASH_MEMTYPE_DATA);
+    configSaving = 0;
+
+    if(Config_ReadSlot(configWriteSlot))
+    {
+        configSlot = configWriteSlot;
+        LOG1(LOG_CONFIG_SAVED, configWriteSlot);
+    }
+    else
+    {
+        LOG1(LOG_CONFIG_SAVE_FAILED, configWriteSlot);
+    }
+}
+
+/*******************************************************************************
+  * @brief Read an EEPROM slot into configImage and check its version and CRC
+  * @par Parameters:
+  * slot - EEPROM slot
+  * @retval 1 if the slot holds a valid record, 0 otherwise
+  *****************************************************************************/
+int Config_ReadSlot(unsigned char slot)
+{
+    unsigned char *record = (unsigned char *)&configImage;
+    unsigned char i = 0;
+
+    if(FLASH_ReadByte(CONFIG_SLOT_ADDRESS(slot)) != CONFIG_VERSION)
+    {
+        return 0;
+    }
+
+    for(i = 0; i < sizeof(ConfigRecord); i++)
+    {
+        record[i] = FLASH_ReadByte(CONFIG_SLOT_ADDRESS(slot) + i);
+    }
+
+    return (Protocol_Crc8(record, CONFIG_CRC_LENGTH) == configImage.crc);
+}
@@ -1,232 +1,1274 @@
-/*******************************************************************************
-  * @file DriveController.c
-  * @brief Implements the functions for controlling the drive motors
-  * @author David Sharpe
-  * @version V1.0.0
-  * @date 02-June-2015
-  *
-  * ST Visual Develop 4.2.1 using STM8 Cosmic C Compiler
-  *****************************************************************************/
-
-
-////////////////////////////////////////////////////////////////////////////////
-// Includes
-////////////////////////////////////////////////////////////////////////////////
-#include "DriveController.h"
-#include "stm8s.h"
-
-
-////////////////////////////////////////////////////////////////////////////////
-// Definitions
-////////////////////////////////////////////////////////////////////////////////
-#define PWM_TIMER_MAX_COUNT 1000
-
-
-/*******************************************************************************
-  * @brief Setup timer 2 (TIM2) for two PWM outputs on TIM2 channels 1 and 2
-  * @par Parameters: None
-  * @retval None
-  *****************************************************************************/
-void InitMotorPwmTimer(void)
-{
-    unsigned short startingDutyCycle = 0;
-    
-    //TIM2 Peripheral Configuration
-    TIM2_DeInit();
-
-    //Set TIM2 Frequency to 2Mhz
-    TIM2_TimeBaseInit(TIM2_PRESCALER_1, PWM_TIMER_MAX_COUNT - 1);
-    
-    //Channel 1 PWM configuration
-    TIM2_OC1Init(TIM2_OCMODE_PWM2, TIM2_OUTPUTSTATE_ENABLE, startingDutyCycle, TIM2_OCPOLARITY_LOW ); 
-    TIM2_OC1PreloadConfig(ENABLE);
-    
-    //Channel 2 PWM configuration
-    TIM2_OC2Init(TIM2_OCMODE_PWM2, TIM2_OUTPUTSTATE_ENABLE, startingDutyCycle, TIM2_OCPOLARITY_LOW );
-    TIM2_OC2PreloadConfig(ENABLE);
-    
-    //Enables TIM2 peripheral Preload register on ARR
-    TIM2_ARRPreloadConfig(ENABLE);
-        
-    //Enable TIM2
-    TIM2_Cmd(ENABLE);
-}
-
-/*******************************************************************************
-  * @brief Configures GPIOs used for motor control
-  * @par Parameters: None
-  * @retval None
-  *****************************************************************************/
-void InitMotorGpio(void)
-{
-    //Reset GPIO port A and G
-    GPIO_DeInit(GPIOA);
-    GPIO_DeInit(GPIOG);
-    
-    //Configure PA3 and PA4 as output push-pull low
-    GPIO_Init(GPIOA, GPIO_PIN_3, GPIO_MODE_OUT_PP_LOW_FAST);
-    GPIO_Init(GPIOA, GPIO_PIN_4, GPIO_MODE_OUT_PP_LOW_FAST);
-    
-    //Configure PG0 and PG1 as output push-pull low
-    GPIO_Init(GPIOG, GPIO_PIN_0, GPIO_MODE_OUT_PP_LOW_FAST);
-    GPIO_Init(GPIOG, GPIO_PIN_1, GPIO_MODE_OUT_PP_LOW_FAST);
-}
-
-/*******************************************************************************
-  * @brief Set a specific motor to turn in the specified direction or stop
-  * @par Parameters:
-  * motor - the motor ID
-  * direction - the desired direction of travel
-  * @retval None
-  *****************************************************************************/
-void Motor(unsigned char motor, unsigned char direction)
-{
-    GPIO_TypeDef *port;
-    unsigned char pin1, pin2;
-    
-    //Get the port and pins for the desired motor
-    switch(motor)
-    {
-        case LEFT:
-            port = GPIOA;
-            pin1 = GPIO_PIN_3;
-            pin2 = GPIO_PIN_4;
-            break;
-        
-        case RIGHT:
-            port = GPIOG;
-            pin1 = GPIO_PIN_0;
-            pin2 = GPIO_PIN_1;
-            break;
-        
-        default:
-            //Invalid motor, do nothing
-            return;
-            break;
-    };
-    
-    //Set the motor inputs for the desired direction of travel
-    switch(direction)
-    {
-        case STOP:
-            GPIO_WriteLow(port, pin1);
-            GPIO_WriteLow(port, pin2);
-            break;
-        
-        case FORWARD:
-            GPIO_WriteHigh(port, pin1);
-            GPIO_WriteLow(port, pin2);
-            break;
-            
-        case BACKWARD:
-            GPIO_WriteLow(port, pin1);
-            GPIO_WriteHigh(port, pin2);
-            break;
-        
-        default:
-            break;
-    };
-}
-
-/*******************************************************************************
-  * @brief Initialize the motor drive controller
-  * @par Parameters: None
-  * @retval None
-  *****************************************************************************/
-void DriveCtrl_Initialize()
-{
-    //Configures motor GPIOs
-    InitMotorGpio();
-    
-    //Setup the motor PWM timer
-    InitMotorPwmTimer();  
-}
-
-/*******************************************************************************
-  * @brief Set the motor PWM for the desired speed
-  * @par Parameters:
-  * percentSpeed - motor speed percentage (0 to 100)
-  * @retval None
-  *****************************************************************************/
-void DriveCtrl_SetSpeed(unsigned char percentSpeed)
-{
-    const float SCALE_FACTOR = PWM_TIMER_MAX_COUNT / 100;
-    
-    //Do not allow speed greater than 100%
-    if(percentSpeed > 100)
-    {
-        percentSpeed = 100;
-    }
-    
-    //Set PWM for each motor
-    TIM2_SetCompare1((SCALE_FACTOR * percentSpeed) + 0.5);
-    TIM2_SetCompare2((SCALE_FACTOR * percentSpeed) + 0.5);
-}
-
-/*******************************************************************************
-  * @brief Set the motors to stop movement
-  * @par Parameters: None
-  * @retval None
-  *****************************************************************************/
-void DriveCtrl_Stop()
-{
-    Motor(LEFT, STOP);
-    Motor(RIGHT, STOP);
-}
-
-/*******************************************************************************
-  * @brief Set the motors for forward movement
-  * @par Parameters: None
-  * @retval None
-  *****************************************************************************/
-void DriveCtrl_Forward()
-{
-    Motor(LEFT, FORWARD);
-    Motor(RIGHT, FORWARD);
-}
-
-/*******************************************************************************
-  * @brief Set the motors for backward movement
-  * @par Parameters: None
-  * @retval None
-  *****************************************************************************/
-void DriveCtrl_Backward()
-{
-    Motor(LEFT, BACKWARD);
-    Motor(RIGHT, BACKWARD);
-}
-
-/*******************************************************************************
-  * @brief Set the motors to turn the vehicle
-  * @par Parameters:
-  * direction - the direction to turn
-  * @retval None
-  *****************************************************************************/
-void DriveCtrl_Turn(unsigned char direction)
-{
-    switch(direction)
-    {
-        case LEFT:
-            Motor(LEFT, STOP);
-            Motor(RIGHT, FORWARD);
-            break;
-            
-        case SHARP_LEFT:
-            Motor(LEFT, BACKWARD);
-            Motor(RIGHT, FORWARD);
-            break;
-            
-        case RIGHT:
-            Motor(LEFT, FORWARD);
-            Motor(RIGHT, STOP);
-            break;        
-            
-        case SHARP_RIGHT:
-            Motor(LEFT, FORWARD);
-            Motor(RIGHT, BACKWARD);
-            break;
-    };
-}
-
-
-
+/*******************************************************************************
+  * @file DriveController.c
+  * @brief Implements the functions for controlling the drive motors
+  * @author David Sharpe
+  * @version V1.0.0
+  * @date 02-June-2015
+  *
+  * ST Visual Develop 4.2.1 using STM8 Cosmic C Compiler
+  *****************************************************************************/
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Includes
+////////////////////////////////////////////////////////////////////////////////
+#include "DriveController.h"
+#include "Encoder.h"
+#include "Latency.h"
+#include "Log.h"
+#include "Odometry.h"
+#include "Range.h"
+#include "Scheduler.h"
+#include "stm8s.h"
+#include "FastIo.h"
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Definitions
+////////////////////////////////////////////////////////////////////////////////
+//Compare value for a speed percentage with a timer period of n counts, 
+//rounded to nearest
+#define DUTY(n, p)      ((unsigned short)(((unsigned long)(n) * (p) + 50) / 100))
+#define DUTY_ROW(n, p)  DUTY(n, p),     DUTY(n, p + 1), DUTY(n, p + 2), \
+                        DUTY(n, p + 3), DUTY(n, p + 4), DUTY(n, p + 5), \
+                        DUTY(n, p + 6), DUTY(n, p + 7), DUTY(n, p + 8), \
+                        DUTY(n, p + 9)
+#define DUTY_TABLE(n)   {DUTY_ROW(n, 0),  DUTY_ROW(n, 10), DUTY_ROW(n, 20), \
+                         DUTY_ROW(n, 30), DUTY_ROW(n, 40), DUTY_ROW(n, 50), \
+                         DUTY_ROW(n, 60), DUTY_ROW(n, 70), DUTY_ROW(n, 80), \
+                         DUTY_ROW(n, 90), DUTY(n, 100)}
+
+//Timer period of each profile in counts, see DrivePwmProfile
+#define PWM_PERIOD_16KHZ    1000
+#define PWM_PERIOD_20KHZ    800
+#define PWM_PERIOD_32KHZ    500
+#define PWM_PERIOD_2KHZ     8000
+
+//Pin table entry of a board profile motor, the output register value of
+//each direction swapped for a reversed motor
+#define MOTOR_ENTRY(port, a, b, reversed)                                     \
+    {port, (a) | (b), {0, (reversed) ? (b) : (a), (reversed) ? (a) : (b)}}
+
+//Compare and output channel setup of a board profile motor's TIM2 channel
+#define PWM_SET(channel, compare)   PWM_SET_(channel, compare)
+#define PWM_SET_(channel, compare)  TIM2_SetCompare##channel(compare)
+#define PWM_INIT(channel, compare)  PWM_INIT_(channel, compare)
+#define PWM_INIT_(channel, compare)                                           \
+    TIM2_OC##channel##Init(TIM2_OCMODE_PWM2, TIM2_OUTPUTSTATE_ENABLE,         \
+                           compare, TIM2_OCPOLARITY_LOW);                     \
+    TIM2_OC##channel##PreloadConfig(ENABLE)
+
+//H-bridge inputs of each motor. The output register value for each 
+//direction is indexed by STOP, FORWARD and BACKWARD.
+typedef struct
+{
+    GPIO_TypeDef *port;
+    unsigned char mask;
+    unsigned char odr[BACKWARD + 1];
+} MotorPins;
+
+//Timer setup of a PWM profile and its percent speed to compare value table
+typedef struct
+{
+    unsigned char prescaler;    //TIM2_PRESCALER_ value
+    unsigned short period;      //counts
+    const unsigned short *duty;
+} PwmProfile;
+
+//Closed loop moves, ended by the odometry
+enum DriveMove
+{
+    DRIVE_MOVE_NONE,
+    DRIVE_MOVE_DISTANCE,
+    DRIVE_MOVE_TURN
+};
+
+//Overcurrent trip state, see DRIVE_TRIP_ENABLE
+enum DriveTrip
+{
+    DRIVE_TRIP_CLEAR,
+    DRIVE_TRIP_WAIT,        //waiting out the retry
+    DRIVE_TRIP_LATCHED      //held off until the commands stop
+};
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Prototypes
+////////////////////////////////////////////////////////////////////////////////
+void UpdateTargets(void);
+signed char ClampSpeed(signed char value);
+signed char RampSpeed(signed char current, signed char target);
+unsigned char CalibrateDuty(const unsigned char *table, unsigned char percent);
+unsigned char ReflexLimit(void);
+void ApplyWheel(unsigned char motor, signed char value);
+void CommitOutputs(void);
+void UpdateMove(void);
+int  UpdateTrip(void);
+int  TakeTrip(unsigned long now);
+signed char VelocityControl(signed short target, signed char applied, 
+                            unsigned char encoder, signed long *integral);
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Variables
+////////////////////////////////////////////////////////////////////////////////
+
+//Percent speed to PWM compare value of each profile, computed by the 
+//compiler
+const unsigned short DUTY_16KHZ[SPEED_FULL + 1] = DUTY_TABLE(PWM_PERIOD_16KHZ);
+const unsigned short DUTY_20KHZ[SPEED_FULL + 1] = DUTY_TABLE(PWM_PERIOD_20KHZ);
+const unsigned short DUTY_32KHZ[SPEED_FULL + 1] = DUTY_TABLE(PWM_PERIOD_32KHZ);
+const unsigned short DUTY_2KHZ[SPEED_FULL + 1] = DUTY_TABLE(PWM_PERIOD_2KHZ);
+
+//PWM profiles, indexed by DrivePwmProfile
+const PwmProfile PWM_PROFILES[DRIVE_PWM_PROFILE_COUNT] =
+{
+    {0, 0, 0},
+    {TIM2_PRESCALER_1, PWM_PERIOD_16KHZ, DUTY_16KHZ},
+    {TIM2_PRESCALER_1, PWM_PERIOD_20KHZ, DUTY_20KHZ},
+    {TIM2_PRESCALER_1, PWM_PERIOD_32KHZ, DUTY_32KHZ},
+    {TIM2_PRESCALER_1, PWM_PERIOD_2KHZ, DUTY_2KHZ}
+};
+
+//H-bridge inputs of each motor, from the board profile
+const MotorPins MOTOR_PINS[MOTOR_COUNT] =
+{
+    MOTOR_ENTRY(BOARD_LEFT_PORT, BOARD_LEFT_PIN_A, BOARD_LEFT_PIN_B, 
+                BOARD_LEFT_REVERSED),
+    MOTOR_ENTRY(BOARD_RIGHT_PORT, BOARD_RIGHT_PIN_A, BOARD_RIGHT_PIN_B, 
+                BOARD_RIGHT_REVERSED)
+};
+
+//Commanded direction of each wheel (-1, 0 or 1) and speed percentage
+signed char leftDir = 0;
+signed char rightDir = 0;
+unsigned char speed = 0;
+
+//Ramp targets and the signed speeds currently applied
+signed char leftTarget = 0;
+signed char rightTarget = 0;
+signed char leftSpeed = 0;
+signed char rightSpeed = 0;
+unsigned char accelStep = DRIVE_ACCEL_DEFAULT;
+
+//PWM profile in use, never DRIVE_PWM_DEFAULT
+unsigned char pwmProfile = DRIVE_PWM_PROFILE;
+
+//Output scale of each wheel in percent, evens out mismatched motors
+unsigned char leftTrim = SPEED_FULL;
+unsigned char rightTrim = SPEED_FULL;
+
+//Duty calibration of each wheel, see DRIVE_CAL_POINTS
+unsigned char leftCal[DRIVE_CAL_POINTS] = {25, 50, 75, 100};
+unsigned char rightCal[DRIVE_CAL_POINTS] = {25, 50, 75, 100};
+
+//Closed loop velocity control state
+unsigned char velocityMode = 0;
+signed short leftVelocity = 0;
+signed short rightVelocity = 0;
+signed long leftIntegral = 0;
+signed long rightIntegral = 0;
+
+//Set while the reflex holds the forward speed below the command
+unsigned char reflexActive = 0;
+
+//Speed both wheels are held to in either direction, selected on the robot
+signed char speedLimit = SPEED_FULL;
+
+//Time the motor outputs last changed
+unsigned long switchTime = 0;
+
+//H-bridge direction of each wheel for the next PWM period, the duty waits in
+//the TIM2 compare preload registers. Set until the update interrupt has
+//applied them.
+unsigned char stagedDir[MOTOR_COUNT] = {STOP, STOP};
+volatile unsigned char commitPending = 0;
+
+//Overcurrent trip. The interrupt counts the trips and holds the bridges at
+//STOP, the drive update takes each one and lets go once it is waited out.
+//The fold back is taken off the speed limit.
+volatile unsigned char tripHold = 0;
+volatile unsigned char tripEdges = 0;
+unsigned char tripSeen = 0;
+unsigned char tripState = DRIVE_TRIP_CLEAR;
+unsigned char tripRun = 0;
+unsigned char tripFold = 0;
+unsigned short tripTotal = 0;
+unsigned long tripTime = 0;
+
+//Move in progress, the target is um of travel or heading units of rotation
+//from where the move started
+unsigned char moveMode = DRIVE_MOVE_NONE;
+signed long moveStart = 0;
+signed long moveTarget = 0;
+unsigned short moveVelocity = 0;
+
+
+/*******************************************************************************
+  * @brief Setup timer 2 (TIM2) for the two PWM outputs on the board 
+  *        profile's channels
+  * @par Parameters: None
+  * @retval None
+  *****************************************************************************/
+void InitMotorPwmTimer(void)
+{
+    const PwmProfile *profile = &PWM_PROFILES[pwmProfile];
+    unsigned short startingDutyCycle = 0;
+    
+    //TIM2 Peripheral Configuration
+    TIM2_DeInit();
+
+    //Set the TIM2 frequency for the profile
+    TIM2_TimeBaseInit((TIM2_Prescaler_TypeDef)profile->prescaler, 
+                      profile->period - 1);
+    
+    //Left and right PWM channel configuration
+    PWM_INIT(BOARD_LEFT_PWM, startingDutyCycle);
+    PWM_INIT(BOARD_RIGHT_PWM, startingDutyCycle);
+    
+    //Enables TIM2 peripheral Preload register on ARR
+    TIM2_ARRPreloadConfig(ENABLE);
+    
+    //The update interrupt is only enabled while a commit is pending
+    TIM2_ITConfig(TIM2_IT_UPDATE, DISABLE);
+    commitPending = 0;
+        
+    //Enable TIM2
+    TIM2_Cmd(ENABLE);
+}
+
+/*******************************************************************************
+  * @brief Configures GPIOs used for motor control
+  * @par Parameters: None
+  * @retval None
+  *****************************************************************************/
+void InitMotorGpio(void)
+{
+    unsigned char i = 0;
+    
+    //Reset the motor ports, then the H-bridge inputs as output push-pull 
+    //low
+    for(i = 0; i < MOTOR_COUNT; i++)
+    {
+        GPIO_DeInit(MOTOR_PINS[i].port);
+    }
+    
+    for(i = 0; i < MOTOR_COUNT; i++)
+    {
+        GPIO_Init(MOTOR_PINS[i].port, (GPIO_Pin_TypeDef)MOTOR_PINS[i].mask, 
+                  GPIO_MODE_OUT_PP_LOW_FAST);
+    }
+}
+
+/*******************************************************************************
+  * @brief Set a specific motor to turn in the specified direction or stop
+  * @par Parameters:
+  * motor - MOTOR_LEFT or MOTOR_RIGHT
+  * direction - the desired direction of travel
+  * @retval None
+  *****************************************************************************/
+void Motor(unsigned char motor, unsigned char direction)
+{
+    const MotorPins *pins;
+    GPIO_TypeDef *port;
+    
+    //Only STOP, FORWARD and BACKWARD are valid motor directions
+    if(motor >= MOTOR_COUNT || direction > BACKWARD)
+    {
+        return;
+    }
+    
+    pins = &MOTOR_PINS[motor];
+    
+    //Set both motor inputs with a single write so they change together
+    port = pins->port;
+    port->ODR = (port->ODR & (unsigned char)~pins->mask) | pins->odr[direction];
+}
+
+/*******************************************************************************
+  * @brief Initialize the motor drive controller. Must be called with 
+  *        interrupts disabled since the EXTI sensitivity can only be changed
+  *        then.
+  * @par Parameters: None
+  * @retval None
+  *****************************************************************************/
+void DriveCtrl_Initialize()
+{
+    accelStep = DRIVE_ACCEL_DEFAULT;
+    
+    //Configures motor GPIOs
+    InitMotorGpio();
+    
+#if DRIVE_TRIP_ENABLE
+    //Comparator output with pull up, the interrupt on the falling edge
+    tripHold = 0;
+    tripEdges = 0;
+    tripSeen = 0;
+    tripState = DRIVE_TRIP_CLEAR;
+    tripRun = 0;
+    tripFold = 0;
+    GPIO_Init(DRIVE_TRIP_PORT, DRIVE_TRIP_PIN, GPIO_MODE_IN_PU_IT);
+    EXTI_SetExtIntSensitivity(DRIVE_TRIP_EXTI, EXTI_SENSITIVITY_FALL_ONLY);
+#endif
+    
+    //Setup the motor PWM timer
+    InitMotorPwmTimer();  
+    
+    //Setup the wheel encoders and the pose estimate
+    Encoder_Initialize();
+    Odometry_Initialize();
+}
+
+/*******************************************************************************
+  * @brief Set the motor PWM for the desired speed. The motors ramp to the 
+  *        new speed.
+  * @par Parameters:
+  * percentSpeed - motor speed percentage (0 to 100)
+  * @retval None
+  *****************************************************************************/
+void DriveCtrl_SetSpeed(unsigned char percentSpeed)
+{
+    //Do not allow speed greater than 100%
+    if(percentSpeed > SPEED_FULL)
+    {
+        percentSpeed = SPEED_FULL;
+    }
+    
+    speed = percentSpeed;
+    UpdateTargets();
+}
+
+/*******************************************************************************
+  * @brief Set the direction and PWM of each wheel for differential steering.
+  *        The motors ramp to the new speeds.
+  * @par Parameters:
+  * left - left wheel speed percentage (-100 to 100, negative is backward)
+  * right - right wheel speed percentage (-100 to 100, negative is backward)
+  * @retval None
+  *****************************************************************************/
+void DriveCtrl_SetWheelDuty(signed char left, signed char right)
+{
+    velocityMode = 0;
+    moveMode = DRIVE_MOVE_NONE;
+    
+    //Do not allow speed greater than 100%
+    leftTarget = ClampSpeed(left);
+    rightTarget = ClampSpeed(right);
+    
+    //Keep the direction commands in step so a following SetSpeed scales 
+    //the same motion
+    leftDir = (left > 0) ? 1 : (left < 0) ? -1 : 0;
+    rightDir = (right > 0) ? 1 : (right < 0) ? -1 : 0;
+}
+
+/*******************************************************************************
+  * @brief Drive along an arc, the forward speed and turn rate give the duty 
+  *        of each wheel. A pair past full speed is scaled back together so
+  *        the faster wheel is at full speed and the ratio between them, the
+  *        curvature of the arc, is kept. The motors ramp to the new speeds.
+  * @par Parameters:
+  * speed - forward speed percentage (-100 to 100, negative is backward)
+  * turn - turn rate percentage (-100 to 100, positive is counterclockwise),
+  *        the wheels differ by twice this
+  * @retval None
+  *****************************************************************************/
+void DriveCtrl_SetTwist(signed char speed, signed char turn)
+{
+    signed short left = (signed short)ClampSpeed(speed) - ClampSpeed(turn);
+    signed short right = (signed short)ClampSpeed(speed) + ClampSpeed(turn);
+    signed short peak = (left < 0) ? -left : left;
+    signed short other = (right < 0) ? -right : right;
+    
+    if(other > peak)
+    {
+        peak = other;
+    }
+    
+    //Scale both by full speed over the peak, rounded to nearest
+    if(peak > SPEED_FULL)
+    {
+        left = (left * SPEED_FULL + ((left < 0) ? -peak : peak) / 2) / peak;
+        right = (right * SPEED_FULL + ((right < 0) ? -peak : peak) / 2) / peak;
+    }
+    
+    DriveCtrl_SetWheelDuty((signed char)left, (signed char)right);
+}
+
+/*******************************************************************************
+  * @brief Hold each wheel at a velocity using the encoders. The PI loops run
+  *        in DriveCtrl_Update and their output goes through the ramp. Any 
+  *        open loop command ends velocity control.
+  * @par Parameters:
+  * left - left wheel velocity in encoder edges per second, negative is 
+  *        backward
+  * right - right wheel velocity in encoder edges per second, negative is 
+  *         backward
+  * @retval None
+  *****************************************************************************/
+void DriveCtrl_SetWheelVelocity(signed short left, signed short right)
+{
+    moveMode = DRIVE_MOVE_NONE;
+    
+    if(!velocityMode)
+    {
+        leftIntegral = 0;
+        rightIntegral = 0;
+        velocityMode = 1;
+    }
+    
+    leftVelocity = (left > DRIVE_VELOCITY_MAX) ? DRIVE_VELOCITY_MAX : 
+                   (left < -DRIVE_VELOCITY_MAX) ? -DRIVE_VELOCITY_MAX : left;
+    rightVelocity = (right > DRIVE_VELOCITY_MAX) ? DRIVE_VELOCITY_MAX : 
+                    (right < -DRIVE_VELOCITY_MAX) ? -DRIVE_VELOCITY_MAX : right;
+}
+
+/*******************************************************************************
+  * @brief Drive straight for a distance under velocity control. The wheels
+  *        slow down on the way in and ramp to a stop once the odometry has 
+  *        seen the distance travelled, any other drive command ends the 
+  *        move.
+  * @par Parameters:
+  * mm - distance, negative is backward
+  * velocity - wheel velocity in encoder edges per second
+  * @retval None
+  *****************************************************************************/
+void DriveCtrl_DriveDistance(signed short mm, unsigned short velocity)
+{
+    signed short wheel = (mm < 0) ? -(signed short)velocity : velocity;
+    
+    if(mm == 0 || velocity == 0)
+    {
+        DriveCtrl_SetWheelDuty(0, 0);
+        return;
+    }
+    
+    DriveCtrl_SetWheelVelocity(wheel, wheel);
+    moveMode = DRIVE_MOVE_DISTANCE;
+    moveVelocity = velocity;
+    moveStart = Odometry_GetTravel();
+    moveTarget = (signed long)mm * 1000;
+}
+
+/*******************************************************************************
+  * @brief Turn on the spot through an angle under velocity control. The 
+  *        wheels slow down on the way in and ramp to a stop once the 
+  *        odometry has seen the heading change, any other drive command 
+  *        ends the move.
+  * @par Parameters:
+  * degrees - angle, positive is counterclockwise
+  * velocity - wheel velocity in encoder edges per second
+  * @retval None
+  *****************************************************************************/
+void DriveCtrl_TurnAngle(signed short degrees, unsigned short velocity)
+{
+    signed short wheel = (degrees < 0) ? -(signed short)velocity : velocity;
+    
+    if(degrees == 0 || velocity == 0)
+    {
+        DriveCtrl_SetWheelDuty(0, 0);
+        return;
+    }
+    
+    DriveCtrl_SetWheelVelocity(-wheel, wheel);
+    moveMode = DRIVE_MOVE_TURN;
+    moveVelocity = velocity;
+    moveStart = Odometry_GetRotation();
+    moveTarget = (signed long)degrees * ODOMETRY_HEADING_TURN / 360;
+}
+
+/*******************************************************************************
+  * @brief Check if a distance or turn move is in progress
+  * @par Parameters: None
+  * @retval 1 if a move is in progress, 0 otherwise
+  *****************************************************************************/
+int DriveCtrl_IsMoveActive(void)
+{
+    return (moveMode != DRIVE_MOVE_NONE);
+}
+
+/*******************************************************************************
+  * @brief Set the ramp acceleration
+  * @par Parameters:
+  * step - speed change in percent per DriveCtrl_Update call, 0 disables the 
+  *        ramp
+  * @retval None
+  *****************************************************************************/
+void DriveCtrl_SetAcceleration(unsigned char step)
+{
+    accelStep = (step == 0 || step > 2 * SPEED_FULL) ? 2 * SPEED_FULL : step;
+}
+
+/*******************************************************************************
+  * @brief Get the ramp acceleration
+  * @par Parameters: None
+  * @retval speed change in percent per DriveCtrl_Update call
+  *****************************************************************************/
+unsigned char DriveCtrl_GetAcceleration(void)
+{
+    return accelStep;
+}
+
+/*******************************************************************************
+  * @brief Set the speed limit. Every command is held to it in both 
+  *        directions, the wheels ramp down to it.
+  * @par Parameters:
+  * percent - limit in percent, 0 holds the robot stopped
+  * @retval None
+  *****************************************************************************/
+void DriveCtrl_SetSpeedLimit(unsigned char percent)
+{
+    speedLimit = (signed char)((percent > SPEED_FULL) ? SPEED_FULL : percent);
+}
+
+/*******************************************************************************
+  * @brief Get the speed limit
+  * @par Parameters: None
+  * @retval limit in percent
+  *****************************************************************************/
+unsigned char DriveCtrl_GetSpeedLimit(void)
+{
+    return (unsigned char)speedLimit;
+}
+
+/*******************************************************************************
+  * @brief Set the wheel trims. The PWM of each wheel is scaled so that both
+  *        wheels turn at the same speed for the same command.
+  * @par Parameters:
+  * left - left wheel output scale, percent
+  * right - right wheel output scale, percent
+  * @retval None
+  *****************************************************************************/
+void DriveCtrl_SetTrim(unsigned char left, unsigned char right)
+{
+    leftTrim = (left > SPEED_FULL) ? SPEED_FULL : left;
+    rightTrim = (right > SPEED_FULL) ? SPEED_FULL : right;
+}
+
+/*******************************************************************************
+  * @brief Set the duty calibration of the wheels, applied to every command
+  *        from the next drive update on
+  * @par Parameters:
+  * left - left wheel duty percent at each calibration point, non-decreasing
+  * right - right wheel duty percent at each calibration point
+  * @retval None
+  *****************************************************************************/
+void DriveCtrl_SetCalibration(const unsigned char *left, 
+                              const unsigned char *right)
+{
+    unsigned char i = 0;
+    
+    for(i = 0; i < DRIVE_CAL_POINTS; i++)
+    {
+        leftCal[i] = left[i];
+        rightCal[i] = right[i];
+    }
+}
+
+/*******************************************************************************
+  * @brief Change the PWM frequency and resolution. The new period starts
+  *        with the wheels at the same duty as before.
+  * @par Parameters:
+  * profile - DrivePwmProfile value, DRIVE_PWM_DEFAULT or one not known 
+  *           selects the build's DRIVE_PWM_PROFILE
+  * @retval None
+  *****************************************************************************/
+void DriveCtrl_SetPwmProfile(unsigned char profile)
+{
+    const PwmProfile *settings = 0;
+    
+    if(profile == DRIVE_PWM_DEFAULT || profile >= DRIVE_PWM_PROFILE_COUNT)
+    {
+        profile = DRIVE_PWM_PROFILE;
+    }
+    
+    if(profile == pwmProfile)
+    {
+        return;
+    }
+    
+    pwmProfile = profile;
+    settings = &PWM_PROFILES[profile];
+    
+    //Preloaded with the compare values so all of it starts on one update
+    TIM2_UpdateDisableConfig(ENABLE);
+    TIM2_PrescalerConfig((TIM2_Prescaler_TypeDef)settings->prescaler, 
+                         TIM2_PSCRELOADMODE_UPDATE);
+    TIM2_SetAutoreload(settings->period - 1);
+    CommitOutputs();
+}
+
+/*******************************************************************************
+  * @brief Get the PWM profile in use
+  * @par Parameters: None
+  * @retval DrivePwmProfile value
+  *****************************************************************************/
+unsigned char DriveCtrl_GetPwmProfile(void)
+{
+    return pwmProfile;
+}
+
+/*******************************************************************************
+  * @brief Check if either wheel is driven or commanded to move
+  * @par Parameters: None
+  * @retval 1 if moving, 0 if stopped
+  *****************************************************************************/
+int DriveCtrl_IsMoving(void)
+{
+    if(velocityMode && (leftVelocity != 0 || rightVelocity != 0))
+    {
+        return 1;
+    }
+    
+    return (leftSpeed != 0 || rightSpeed != 0 || 
+            leftTarget != 0 || rightTarget != 0);
+}
+
+/*******************************************************************************
+  * @brief Get the duty applied to a motor, the ramp output before trim
+  * @par Parameters:
+  * motor - MOTOR_LEFT or MOTOR_RIGHT
+  * @retval speed percentage (-100 to 100, negative is backward)
+  *****************************************************************************/
+signed char DriveCtrl_GetDuty(unsigned char motor)
+{
+    return (motor == MOTOR_RIGHT) ? rightSpeed : leftSpeed;
+}
+
+/*******************************************************************************
+  * @brief Get the time the motor outputs last changed. The current step in
+  *        the motor supply couples into the touch key for a while after.
+  * @par Parameters: None
+  * @retval time in ms, see Sched_GetTime
+  *****************************************************************************/
+unsigned long DriveCtrl_GetSwitchTime(void)
+{
+    return switchTime;
+}
+
+/*******************************************************************************
+  * @brief Run the velocity loops, if enabled, and step each motor toward its
+  *        target speed. A motor that has to reverse is driven through zero 
+  *        first so the H-bridge never flips while the motor is powered. 
+  *        Both wheels are held to the speed limit and forward speed to the
+  *        reflex limit of the range ahead. Called every DRIVE_UPDATE_PERIOD
+  *        ms.
+  * @par Parameters: None
+  * @retval None
+  *****************************************************************************/
+void DriveCtrl_Update(void)
+{
+    signed char left = 0;
+    signed char right = 0;
+    signed short held = 0;
+    signed char limit = SPEED_FULL;
+    signed char cap = SPEED_FULL;
+    unsigned char cut = 0;
+    
+    //Keep the encoder timeouts current and the pose up to date, then end
+    //a move that has got there
+    Encoder_Update();
+    Odometry_Update();
+    UpdateMove();
+    
+#if DRIVE_TRIP_ENABLE
+    //Nothing is driven while a trip is waited out
+    if(UpdateTrip())
+    {
+        return;
+    }
+#endif
+    
+    if(velocityMode)
+    {
+        leftTarget = VelocityControl(leftVelocity, leftSpeed, ENCODER_LEFT, 
+                                     &leftIntegral);
+        rightTarget = VelocityControl(rightVelocity, rightSpeed, ENCODER_RIGHT, 
+                                      &rightIntegral);
+    }
+    
+    left = leftTarget;
+    right = rightTarget;
+    
+    //Hold both wheels to the limit selected on the robot, less the fold back
+    cap = (speedLimit > tripFold) ? speedLimit - tripFold : 0;
+    left = (left > cap) ? cap : (left < -cap) ? -cap : left;
+    right = (right > cap) ? cap : (right < -cap) ? -cap : right;
+    held = left + right;
+    
+    //Hold forward motion to what the range allows. Turning on the spot and
+    //backing away are left alone.
+    if(left + right > 0)
+    {
+        limit = (signed char)ReflexLimit();
+        left = (left > limit) ? limit : left;
+        right = (right > limit) ? limit : right;
+    }
+    
+    //A wheel already faster is cut at once rather than ramped down
+    if(leftSpeed > limit)
+    {
+        leftSpeed = limit;
+        cut = 1;
+    }
+    
+    if(rightSpeed > limit)
+    {
+        rightSpeed = limit;
+        cut = 1;
+    }
+    
+    if(left + right != held)
+    {
+        if(!reflexActive)
+        {
+            LOG2(LOG_REFLEX_LIMIT, Range_GetDistance(), limit);
+            reflexActive = 1;
+        }
+    }
+    else
+    {
+        reflexActive = 0;
+    }
+    
+    if(!cut && leftSpeed == left && rightSpeed == right)
+    {
+        return;
+    }
+    
+    leftSpeed = RampSpeed(leftSpeed, left);
+    rightSpeed = RampSpeed(rightSpeed, right);
+    CommitOutputs();
+}
+
+/*******************************************************************************
+  * @brief TIM2 update interrupt, the start of a PWM period. Applies the 
+  *        staged wheel directions in the period the staged duties were just
+  *        loaded for, then turns itself off until the next commit.
+  * @par Parameters: None
+  * @retval None
+  *****************************************************************************/
+void DriveCtrl_PwmISR(void)
+{
+    TIM2_ClearITPendingBit(TIM2_IT_UPDATE);
+    
+    if(commitPending)
+    {
+        Motor(MOTOR_LEFT, tripHold ? STOP : stagedDir[MOTOR_LEFT]);
+        Motor(MOTOR_RIGHT, tripHold ? STOP : stagedDir[MOTOR_RIGHT]);
+        commitPending = 0;
+        
+#if LATENCY_ENABLE
+        Latency_ApplyISR();
+#endif
+    }
+    
+    TIM2_ITConfig(TIM2_IT_UPDATE, DISABLE);
+}
+
+/*******************************************************************************
+  * @brief EXTI port E interrupt, the current sense comparator has tripped.
+  *        Both H-bridges are put to STOP at once and held there until the 
+  *        drive update has waited out the retry. It runs at the PWM 
+  *        commit's level, so neither lands inside the other's pin write.
+  * @par Parameters: None
+  * @retval None
+  *****************************************************************************/
+void DriveCtrl_TripISR(void)
+{
+    tripHold = 1;
+    tripEdges++;
+    Motor(MOTOR_LEFT, STOP);
+    Motor(MOTOR_RIGHT, STOP);
+}
+
+/*******************************************************************************
+  * @brief Get the number of overcurrent trips since start up
+  * @par Parameters: None
+  * @retval trip count
+  *****************************************************************************/
+unsigned short DriveCtrl_GetTripCount(void)
+{
+    return tripTotal;
+}
+
+/*******************************************************************************
+  * @brief Stop both motors immediately, bypassing the ramp
+  * @par Parameters: None
+  * @retval None
+  *****************************************************************************/
+void DriveCtrl_EmergencyStop(void)
+{
+    velocityMode = 0;
+    moveMode = DRIVE_MOVE_NONE;
+    leftDir = 0;
+    rightDir = 0;
+    speed = 0;
+    leftTarget = 0;
+    rightTarget = 0;
+    leftSpeed = 0;
+    rightSpeed = 0;
+    
+    CommitOutputs();
+}
+
+/*******************************************************************************
+  * @brief Set the motors to stop movement
+  * @par Parameters: None
+  * @retval None
+  *****************************************************************************/
+void DriveCtrl_Stop()
+{
+    leftDir = 0;
+    rightDir = 0;
+    UpdateTargets();
+}
+
+/*******************************************************************************
+  * @brief Set the motors for forward movement
+  * @par Parameters: None
+  * @retval None
+  *****************************************************************************/
+void DriveCtrl_Forward()
+{
+    leftDir = 1;
+    rightDir = 1;
+    UpdateTargets();
+}
+
+/*******************************************************************************
+  * @brief Set the motors for backward movement
+  * @par Parameters: None
+  * @retval None
+  *****************************************************************************/
+void DriveCtrl_Backward()
+{
+    leftDir = -1;
+    rightDir = -1;
+    UpdateTargets();
+}
+
+/*******************************************************************************
+  * @brief Set the motors to turn the vehicle
+  * @par Parameters:
+  * direction - the direction to turn
+  * @retval None
+  *****************************************************************************/
+void DriveCtrl_Turn(unsigned char direction)
+{
+    switch(direction)
+    {
+        case LEFT:
+            leftDir = 0;
+            rightDir = 1;
+            break;
+            
+        case SHARP_LEFT:
+            leftDir = -1;
+            rightDir = 1;
+            break;
+            
+        case RIGHT:
+            leftDir = 1;
+            rightDir = 0;
+            break;        
+            
+        case SHARP_RIGHT:
+            leftDir = 1;
+            rightDir = -1;
+            break;
+    };
+    
+    UpdateTargets();
+}
+
+/*******************************************************************************
+  * @brief Compute the target speed of each wheel from the direction commands
+  *        and the speed setting, ends velocity control
+  * @par Parameters: None
+  * @retval None
+  *****************************************************************************/
+void UpdateTargets(void)
+{
+    velocityMode = 0;
+    moveMode = DRIVE_MOVE_NONE;
+    leftTarget = leftDir * (signed char)speed;
+    rightTarget = rightDir * (signed char)speed;
+}
+
+/*******************************************************************************
+  * @brief Limit a signed speed to -100% to 100%
+  * @par Parameters:
+  * value - signed speed percentage
+  * @retval limited speed
+  *****************************************************************************/
+signed char ClampSpeed(signed char value)
+{
+    if(value > SPEED_FULL)
+    {
+        return SPEED_FULL;
+    }
+    
+    if(value < -SPEED_FULL)
+    {
+        return -SPEED_FULL;
+    }
+    
+    return value;
+}
+
+/*******************************************************************************
+  * @brief Move a speed one acceleration step toward a target. Stops at zero 
+  *        when the sign changes so reversals pass through zero.
+  * @par Parameters:
+  * current - current signed speed
+  * target - target signed speed
+  * @retval next signed speed
+  *****************************************************************************/
+signed char RampSpeed(signed char current, signed char target)
+{
+    signed short next = 0;
+    
+    if(target > current)
+    {
+        next = current + accelStep;
+        
+        if(next > target)
+        {
+            next = target;
+        }
+        
+        if(current < 0 && next > 0)
+        {
+            next = 0;
+        }
+    }
+    else
+    {
+        next = current - accelStep;
+        
+        if(next < target)
+        {
+            next = target;
+        }
+        
+        if(current > 0 && next < 0)
+        {
+            next = 0;
+        }
+    }
+    
+    return (signed char)next;
+}
+
+/*******************************************************************************
+  * @brief Get the fastest forward speed the range ahead allows, enough to
+  *        stop DRIVE_REFLEX_MARGIN mm short of an obstacle
+  * @par Parameters: None
+  * @retval speed percentage
+  *****************************************************************************/
+unsigned char ReflexLimit(void)
+{
+    unsigned short range = Range_GetDistance();
+    
+    if(range >= DRIVE_REFLEX_MARGIN + SPEED_FULL * DRIVE_REFLEX_MM_PER_PERCENT)
+    {
+        return SPEED_FULL;
+    }
+    
+    if(range <= DRIVE_REFLEX_MARGIN)
+    {
+        return SPEED_STOP;
+    }
+    
+    return (unsigned char)((range - DRIVE_REFLEX_MARGIN) / 
+                           DRIVE_REFLEX_MM_PER_PERCENT);
+}
+
+/*******************************************************************************
+  * @brief Look up the calibrated duty of a wheel, interpolated between the
+  *        two calibration points either side
+  * @par Parameters:
+  * table - calibration of the wheel
+  * percent - commanded duty percentage (0 to 100)
+  * @retval duty percentage to apply
+  *****************************************************************************/
+unsigned char CalibrateDuty(const unsigned char *table, unsigned char percent)
+{
+    unsigned char point = percent / DRIVE_CAL_STEP;
+    unsigned char low = 0;
+    
+    if(point == DRIVE_CAL_POINTS)
+    {
+        return table[DRIVE_CAL_POINTS - 1];
+    }
+    
+    low = (point == 0) ? 0 : table[point - 1];
+    
+    return low + (unsigned char)(((unsigned short)(table[point] - low) * 
+                                  (percent % DRIVE_CAL_STEP) + 
+                                  (DRIVE_CAL_STEP / 2)) / DRIVE_CAL_STEP);
+}
+
+/*******************************************************************************
+  * @brief Stage a motor at a signed speed for the next commit. The direction 
+  *        is staged from the sign and the PWM preloaded from the magnitude, 
+  *        calibrated and scaled by the wheel trim.
+  * @par Parameters:
+  * motor - MOTOR_LEFT or MOTOR_RIGHT
+  * value - signed speed percentage
+  * @retval None
+  *****************************************************************************/
+void ApplyWheel(unsigned char motor, signed char value)
+{
+    const unsigned char *cal = (motor == MOTOR_LEFT) ? leftCal : rightCal;
+    unsigned char percent = CalibrateDuty(cal, (value < 0) ? -value : value);
+    unsigned short duty = PWM_PROFILES[pwmProfile].duty[percent];
+    unsigned char scale = (motor == MOTOR_LEFT) ? leftTrim : rightTrim;
+    
+    if(scale < SPEED_FULL)
+    {
+        duty = (unsigned short)(((unsigned long)duty * scale) / SPEED_FULL);
+    }
+    
+    if(motor == MOTOR_LEFT)
+    {
+        stagedDir[MOTOR_LEFT] = (value > 0) ? FORWARD : (value < 0) ? BACKWARD : STOP;
+        PWM_SET(BOARD_LEFT_PWM, duty);
+    }
+    else
+    {
+        stagedDir[MOTOR_RIGHT] = (value > 0) ? FORWARD : (value < 0) ? BACKWARD : STOP;
+        PWM_SET(BOARD_RIGHT_PWM, duty);
+    }
+}
+
+/*******************************************************************************
+  * @brief Stage both wheels at the applied speeds and have them start 
+  *        together at the next PWM period. Update events are held off while
+  *        staging so the two compare preloads always move to the outputs in
+  *        the same period, and the update interrupt sets the direction pins
+  *        as that period starts.
+  * @par Parameters: None
+  * @retval None
+  *****************************************************************************/
+void CommitOutputs(void)
+{
+    TIM2_UpdateDisableConfig(ENABLE);
+    
+    ApplyWheel(MOTOR_LEFT, leftSpeed);
+    ApplyWheel(MOTOR_RIGHT, rightSpeed);
+    commitPending = 1;
+    
+    //A flag left from an earlier period would apply the pins early
+    TIM2_ClearITPendingBit(TIM2_IT_UPDATE);
+    TIM2_ITConfig(TIM2_IT_UPDATE, ENABLE);
+    TIM2_UpdateDisableConfig(DISABLE);
+    
+    switchTime = Sched_GetTime();
+}
+
+/*******************************************************************************
+  * @brief Fixed point PI velocity controller for one wheel
+  * @par Parameters:
+  * target - target velocity in edges per second
+  * applied - signed speed currently applied, gives the measurement its sign
+  *           since the encoders have a single channel
+  * encoder - encoder ID
+  * integral - controller integral term
+  * @retval signed speed percentage to apply
+  *****************************************************************************/
+signed char VelocityControl(signed short target, signed char applied, 
+                            unsigned char encoder, signed long *integral)
+{
+    const signed long INTEGRAL_LIMIT = ((signed long)SPEED_FULL << 8) / 
+                                       DRIVE_VELOCITY_KI;
+    signed short measured = (signed short)Encoder_GetVelocity(encoder);
+    signed short error = 0;
+    signed long output = 0;
+    
+    //Stop cleanly rather than hunting around zero
+    if(target == 0)
+    {
+        *integral = 0;
+        return 0;
+    }
+    
+    if(applied < 0)
+    {
+        measured = -measured;
+    }
+    
+    error = target - measured;
+    
+    //Integrate with the term limited to full scale so it cannot wind up
+    *integral += error;
+    
+    if(*integral > INTEGRAL_LIMIT)
+    {
+        *integral = INTEGRAL_LIMIT;
+    }
+    else if(*integral < -INTEGRAL_LIMIT)
+    {
+        *integral = -INTEGRAL_LIMIT;
+    }
+    
+    output = ((signed long)DRIVE_VELOCITY_KP * error + 
+              (signed long)DRIVE_VELOCITY_KI * *integral) >> 8;
+    
+    if(output > SPEED_FULL)
+    {
+        output = SPEED_FULL;
+    }
+    else if(output < -SPEED_FULL)
+    {
+        output = -SPEED_FULL;
+    }
+    
+    return (signed char)output;
+}
+
+/*******************************************************************************
+  * @brief Slow the move in progress down as it closes in and stop it once 
+  *        the odometry has seen it through. The wheel velocity is 
+  *        proportional to the distance the wheels have left to go, so little
+  *        is left for the ramp to carry past the target.
+  * @par Parameters: None
+  * @retval None
+  *****************************************************************************/
+void UpdateMove(void)
+{
+    signed long left = 0;
+    unsigned long remaining = 0;
+    signed short velocity = 0;
+    
+    if(moveMode == DRIVE_MOVE_NONE)
+    {
+        return;
+    }
+    
+    if(moveMode == DRIVE_MOVE_DISTANCE)
+    {
+        left = moveTarget - (Odometry_GetTravel() - moveStart);
+    }
+    else
+    {
+        left = moveTarget - (Odometry_GetRotation() - moveStart);
+    }
+    
+    //Got there once the sign of what is left flips
+    if(left == 0 || (left < 0) != (moveTarget < 0))
+    {
+        DriveCtrl_SetWheelDuty(0, 0);
+        return;
+    }
+    
+    remaining = (left < 0) ? -left : left;
+    
+    //Heading units to um each wheel has left, far away is full speed anyway
+    if(moveMode == DRIVE_MOVE_TURN)
+    {
+        remaining = (remaining > ODOMETRY_HEADING_TURN) ? 0xFFFFFFFFUL : 
+                    (remaining << 15) / ODOMETRY_TURN_SCALE;
+    }
+    
+    remaining = remaining / ODOMETRY_UM_PER_EDGE * DRIVE_MOVE_GAIN;
+    
+    velocity = (remaining > moveVelocity) ? moveVelocity : 
+               (remaining < DRIVE_MOVE_MIN_VELOCITY) ? DRIVE_MOVE_MIN_VELOCITY :
+               (signed short)remaining;
+    
+    if(moveTarget < 0)
+    {
+        velocity = -velocity;
+    }
+    
+    leftVelocity = (moveMode == DRIVE_MOVE_TURN) ? -velocity : velocity;
+    rightVelocity = velocity;
+}
+
+/*******************************************************************************
+  * @brief Take the trips the interrupt has counted, let go of the motors 
+  *        once the retry is waited out and give the fold back a step at a 
+  *        time while no trip comes. A comparator still low at the end of the
+  *        retry is another trip.
+  * @par Parameters: None
+  * @retval 1 while the motors are held off, 0 to drive them
+  *****************************************************************************/
+int UpdateTrip(void)
+{
+    unsigned long now = Sched_GetTime();
+    
+    if(tripEdges != tripSeen)
+    {
+        tripSeen = tripEdges;
+        return TakeTrip(now);
+    }
+    
+    if(tripState == DRIVE_TRIP_WAIT && now - tripTime >= DRIVE_TRIP_RETRY)
+    {
+        if(!(DRIVE_TRIP_PORT->IDR & DRIVE_TRIP_PIN))
+        {
+            return TakeTrip(now);
+        }
+        
+        tripState = DRIVE_TRIP_CLEAR;
+        tripTime = now;
+        tripHold = 0;
+    }
+    else if(tripState == DRIVE_TRIP_LATCHED && !DriveCtrl_IsMoving())
+    {
+        tripState = DRIVE_TRIP_CLEAR;
+        tripRun = 0;
+        tripTime = now;
+        tripHold = 0;
+    }
+    else if(tripState == DRIVE_TRIP_CLEAR && tripFold != 0 && 
+            now - tripTime >= DRIVE_TRIP_RECOVER)
+    {
+        tripFold = (tripFold > DRIVE_TRIP_FOLDBACK) ? 
+                   tripFold - DRIVE_TRIP_FOLDBACK : 0;
+        tripTime = now;
+        
+        if(tripFold == 0)
+        {
+            tripRun = 0;
+        }
+    }
+    
+    return (tripState != DRIVE_TRIP_CLEAR);
+}
+
+/*******************************************************************************
+  * @brief Fold the speed back for a trip and hold the motors off. The wheels
+  *        start again from a stop, the velocity loops drop what they wound 
+  *        up against the stall.
+  * @par Parameters:
+  * now - time in ms, see Sched_GetTime
+  * @retval 1, the motors are held off
+  *****************************************************************************/
+int TakeTrip(unsigned long now)
+{
+    tripTotal++;
+    tripTime = now;
+    tripFold = (tripFold + DRIVE_TRIP_FOLDBACK > SPEED_FULL) ? 
+               SPEED_FULL : tripFold + DRIVE_TRIP_FOLDBACK;
+    
+    leftSpeed = 0;
+    rightSpeed = 0;
+    leftIntegral = 0;
+    rightIntegral = 0;
+    CommitOutputs();
+    
+    if(++tripRun >= DRIVE_TRIP_LATCH)
+    {
+        tripState = DRIVE_TRIP_LATCHED;
+        LOG1(LOG_DRIVE_LATCHED, tripRun);
+    }
+    else
+    {
+        tripState = DRIVE_TRIP_WAIT;
+        LOG2(LOG_DRIVE_TRIP, tripTotal, SPEED_FULL - tripFold);
+    }
+    
+    return 1;
+}
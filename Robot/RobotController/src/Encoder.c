@@ -0,0 +1,165 @@
+/*******************************************************************************
+  * @file Encoder.c
+  * @brief Implements the functions for reading the wheel encoders. Each 
+  *        rising edge is timestamped with the microsecond scheduler time and
+  *        the wheel speed is taken from the period between edges.
+  * @author David Sharpe
+  * @version V1.0.0
+  * @date 14-October-2026
+  *
+  * ST Visual Develop 4.2.1 using STM8 Cosmic C Compiler
+  *****************************************************************************/
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Includes
+////////////////////////////////////////////////////////////////////////////////
+#include "Encoder.h"
+#include "Scheduler.h"
+#include "stm8s.h"
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Definitions
+////////////////////////////////////////////////////////////////////////////////
+#define US_PER_SECOND   1000000UL
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Variables
+////////////////////////////////////////////////////////////////////////////////
+const unsigned char ENCODER_PINS[ENCODER_COUNT] = 
+{
+    ENCODER_LEFT_PIN, 
+    ENCODER_RIGHT_PIN
+};
+
+//Written by the EXTI interrupt, in page zero for short addressing there
+TINY volatile unsigned short edgeTime[ENCODER_COUNT];
+TINY volatile unsigned short edgePeriod[ENCODER_COUNT];
+TINY volatile unsigned short edgeCount[ENCODER_COUNT];
+TINY unsigned char lastInput = 0;
+
+
+/*******************************************************************************
+  * @brief Initialize the encoder inputs. Must be called with interrupts 
+  *        disabled since the EXTI sensitivity can only be changed then.
+  * @par Parameters: None
+  * @retval None
+  *****************************************************************************/
+void Encoder_Initialize(void)
+{
+    unsigned char i = 0;
+    
+    for(i = 0; i < ENCODER_COUNT; i++)
+    {
+        edgeTime[i] = 0;
+        edgePeriod[i] = 0;
+        edgeCount[i] = 0;
+    }
+    
+    //Inputs with pull up and interrupt. The interrupt runs on both edges so
+    //the last input level stays current, only rising edges are counted.
+    GPIO_Init(ENCODER_PORT, ENCODER_LEFT_PIN | ENCODER_RIGHT_PIN, GPIO_MODE_IN_PU_IT);
+    EXTI_SetExtIntSensitivity(ENCODER_EXTI, EXTI_SENSITIVITY_RISE_FALL);
+    
+    lastInput = GPIO_ReadInputData(ENCODER_PORT);
+}
+
+/*******************************************************************************
+  * @brief Mark encoders that have not seen an edge for ENCODER_TIMEOUT as 
+  *        stopped. Must be called more often than the 65ms wrap of the 
+  *        microsecond timestamps, the drive control loop does this.
+  * @par Parameters: None
+  * @retval None
+  *****************************************************************************/
+void Encoder_Update(void)
+{
+    unsigned short now = Sched_GetMicros();
+    unsigned char i = 0;
+    
+    for(i = 0; i < ENCODER_COUNT; i++)
+    {
+        disableInterrupts();
+        
+        if((unsigned short)(now - edgeTime[i]) > ENCODER_TIMEOUT)
+        {
+            edgePeriod[i] = 0;
+            edgeTime[i] = now - ENCODER_TIMEOUT;
+        }
+        
+        enableInterrupts();
+    }
+}
+
+/*******************************************************************************
+  * @brief Get the speed of an encoder
+  * @par Parameters:
+  * encoder - ENCODER_LEFT or ENCODER_RIGHT
+  * @retval edges per second, 0 if stopped
+  *****************************************************************************/
+unsigned short Encoder_GetVelocity(unsigned char encoder)
+{
+    unsigned short period = 0;
+    
+    disableInterrupts();
+    period = edgePeriod[encoder];
+    enableInterrupts();
+    
+    if(period == 0)
+    {
+        return 0;
+    }
+    
+    return (unsigned short)(US_PER_SECOND / period);
+}
+
+/*******************************************************************************
+  * @brief Get the number of edges an encoder has seen, wraps at 65536
+  * @par Parameters:
+  * encoder - ENCODER_LEFT or ENCODER_RIGHT
+  * @retval edge count
+  *****************************************************************************/
+unsigned short Encoder_GetCount(unsigned char encoder)
+{
+    unsigned short count = 0;
+    
+    disableInterrupts();
+    count = edgeCount[encoder];
+    enableInterrupts();
+    
+    return count;
+}
+
+/*******************************************************************************
+  * @brief Interrupt service routine invoked on an edge of an encoder input.
+  *        Runs in fixed time, one timestamp and a compare per encoder.
+  * @par Parameters: None
+  * @retval None
+  *****************************************************************************/
+void Encoder_ISR(void)
+{
+    unsigned short now = Sched_GetMicros();
+    unsigned char input = GPIO_ReadInputData(ENCODER_PORT);
+    unsigned char rising = input & ~lastInput;
+    unsigned short period = 0;
+    unsigned char i = 0;
+    
+    lastInput = input;
+    
+    for(i = 0; i < ENCODER_COUNT; i++)
+    {
+        if(rising & ENCODER_PINS[i])
+        {
+            period = now - edgeTime[i];
+            
+            if(period >= ENCODER_MIN_PERIOD)
+            {
+                //The first edge after a stop only starts the measurement
+                edgePeriod[i] = (period >= ENCODER_TIMEOUT) ? 0 : period;
+                edgeTime[i] = now;
+                edgeCount[i]++;
+            }
+        }
+    }
+}
@@ -1,471 +1,3069 @@
-/*******************************************************************************
-  * @file Esp8266.c
-  * @brief Implements functions for interfacing to ESP8266 WIFI chip
-  * @author David Sharpe
-  * @version V1.0.0
-  * @date 02-June-2015
-  *
-  * ST Visual Develop 4.2.1 using STM8 Cosmic C Compiler
-  *****************************************************************************/
-
-
-////////////////////////////////////////////////////////////////////////////////
-// Includes
-////////////////////////////////////////////////////////////////////////////////
-#include "Esp8266.h"
-#include "Uart.h"
-#include "stm8s.h"
-#include "stdio.h"
-#include "string.h"
-
-
-////////////////////////////////////////////////////////////////////////////////
-// Definitions
-////////////////////////////////////////////////////////////////////////////////
-const char OK_MSG[] = "OK\r\n";
-const char READY_MSG[] = "ready\r\n";
-const char TX_READY_MSG[] = "> ";
-const char RX_PACKET_MSG[] = "+IPD,1,";
-
-
-////////////////////////////////////////////////////////////////////////////////
-// Variables
-////////////////////////////////////////////////////////////////////////////////
-unsigned char packet[ESP8266_RX_BUFFER_SIZE] = {0};
-int packetSize = 0;
-unsigned char status = 0;
-
-
-/*******************************************************************************
-  * @brief Initialize the Esp8266 and any associated communications interfaces
-  * @par Parameters: None
-  * @retval None
-  *****************************************************************************/
-void Esp8266_Initialize(void)
-{ 
-    status = 0;
-
-    //Setup UART used for Esp8266 card communications
-    Uart_Initialize(ESP8266_BAUD);
-    Uart_SetRxCallback(Esp8266_ProcessRxByte);
-    Uart_EnableRxInterrupt();
-    
-    //Make sure communications are working
-    Esp8266_Validate();
-    
-    //Reset ESP8266
-    Esp8266_Reset();
-    
-    //Stop ESP8266 from echoing all the commands we send it
-    Esp8266_DisableEcho();
-    
-    //Clear the status word
-    status = 0;
-}
-
-/*******************************************************************************
-  * @brief Validate communications with the Esp8266 are functioning
-  * @par Parameters: None
-  * @retval None
-  *****************************************************************************/
-void Esp8266_Validate()
-{  
-    char cmd[] = "AT\r\n";
-    
-    Uart_Send(cmd, sizeof(cmd)-1);
-  
-    //wait for OK
-    WaitForResponse(ESP8266_OK_MESSAGE, TIMEOUT_SHORT);
-}
-
-/*******************************************************************************
-  * @brief Reset the Esp8266
-  * @par Parameters: None
-  * @retval None
-  *****************************************************************************/
-void Esp8266_Reset()
-{  
-    char cmd[] = "AT+RST\r\n";
-    
-    Uart_Send(cmd, sizeof(cmd)-1);
-    
-    //wait for ready message
-    WaitForResponse(ESP8266_READY_MESSAGE, TIMEOUT_LONG);
-}
-
-/*******************************************************************************
-  * @brief Set the Esp8266 WIFI access point name
-  * @par Parameters:
-  * name - WIFI access point name
-  * @retval None
-  *****************************************************************************/
-void Esp8266_SetAccessPointName(const char *name)
-{
-    long size = 0; 
-    char buf[64] = {0};
-    
-    //Build set AP command and send it  
-    size = sprintf(buf, "AT+CWSAP=\"%s\",\"\",5,0\r\n", name);  
-    Uart_Send(buf, size);
-    
-    //wait for OK response message
-    WaitForResponse(ESP8266_OK_MESSAGE, TIMEOUT_SHORT);
-}
-
-/*******************************************************************************
-  * @brief Disable the Esp8266 from echoing back all commands on the 
-  *        communications interface
-  * @par Parameters:
-  * name - WIFI access point name
-  * @retval None
-  *****************************************************************************/
-void Esp8266_DisableEcho()
-{  
-    char cmd[] = "ATE0\r\n";
-    
-    Uart_Send(cmd, sizeof(cmd)-1);
-    
-    //wait for OK
-    WaitForResponse(ESP8266_OK_MESSAGE, TIMEOUT_SHORT);
-}
-
-/*******************************************************************************
-  * @brief Start a client connection 
-  * @par Parameters:
-  * type - Connection type (TCP or UDP)
-  * ip - IP address string
-  * port - port number
-  * @retval None
-  *****************************************************************************/
-void Esp8266_StartClient(const char *type, const char *ip, const unsigned short port)
-{
-    long size = 0; 
-    char buf[64] = {0};
-    
-    //Set MUX for multi  
-    size = sprintf(buf, "AT+CIPMUX=1\r\n");  
-    Uart_Send(buf, size);
-    
-    //wait for OK
-    WaitForResponse(ESP8266_OK_MESSAGE, TIMEOUT_SHORT);
-    
-    //Setup the socket  
-    size = sprintf(buf, "AT+CIPSTART=1,\"%s\",\"%s\",%u,%u,0\r\n", type, ip, port, port);  
-    Uart_Send(buf, size);
-    
-    //wait for OK
-    WaitForResponse(ESP8266_OK_MESSAGE, TIMEOUT_SHORT);
-}
-
-/*******************************************************************************
-  * @brief Start a TCP server
-  * @par Parameters:
-  * port - server port number
-  * @retval None
-  *****************************************************************************/
-void Esp8266_StartTcpServer(const unsigned short port)
-{
-    long size = 0; 
-    char buf[64] = {0};
-    
-    //Set MUX for multi  
-    size = sprintf(buf, "AT+CIPMUX=1\r\n");  
-    Uart_Send(buf, size);
-    
-    //wait for OK
-    WaitForResponse(ESP8266_OK_MESSAGE, TIMEOUT_SHORT);
-    
-    //Setup TCP server socket  
-    size = sprintf(buf, "AT+CIPSERVER=1,%u\r\n", port);  
-    Uart_Send(buf, size);
-    
-    //wait for OK
-    WaitForResponse(ESP8266_OK_MESSAGE, TIMEOUT_SHORT);
-    
-    //Set default server timeout
-    Esp8266_SetTcpServerTimeout(ESP8266_SERVER_TIMEOUT);
-}
-
-/*******************************************************************************
-  * @brief Set the TCP timeout
-  * @par Parameters:
-  * seconds - timeout in seconds
-  * @retval None
-  *****************************************************************************/
-void Esp8266_SetTcpServerTimeout(const unsigned short seconds)
-{
-    long size = 0; 
-    char buf[64] = {0};
-        
-    //Setup TCP server timeout  
-    size = sprintf(buf, "AT+CIPSTO=%u\r\n", seconds);  
-    Uart_Send(buf, size);
-    
-    //wait for OK
-    WaitForResponse(ESP8266_OK_MESSAGE, TIMEOUT_SHORT);
-}
-
-/*******************************************************************************
-  * @brief Get the remote client's IP address
-  * @par Parameters: None
-  * @retval None
-  *****************************************************************************/
-void Esp8266_GetRemoteClientIp()
-{
-    //TODO
-}
-
-/*******************************************************************************
-  * @brief Send a message 
-  * @par Parameters:
-  * buffer - data to send
-  * length - data length in bytes
-  * @retval None
-  *****************************************************************************/
-void Esp8266_SendMsg(unsigned char *buffer, unsigned short length)
-{ 
-    long size = 0; 
-    char buf[32] = {0};
-    
-    //Send the command
-    size = sprintf(buf, "AT+CIPSEND=1,%d\r\n", length);  
-    Uart_Send(buf, size);
-    
-    //Wait for TX ready
-    WaitForResponse(ESP8266_TX_READY_MESSAGE, TIMEOUT_SHORT);
-        
-    //Send the data
-    Uart_Send(buffer, length);
-    
-    //Terminate command
-    Uart_Send("\r\n", 2);
-}
-
-/*******************************************************************************
-  * @brief Receive a message 
-  * @par Parameters:
-  * p - pointer to packet buffer
-  * @retval number of bytes received
-  *****************************************************************************/
-int Esp8266_ReceiveMsg(unsigned char *p)
-{
-    //If the RX status bit is set
-    if(status & ESP8266_RX_PACKET_MESSAGE)
-    {
-        //Clear the status bit, copy received data for caller 
-        //and return number of bytes received
-        status &= ~ESP8266_RX_PACKET_MESSAGE;
-        memcpy(p, packet, packetSize);
-        return packetSize;
-    }
-        
-    return 0;
-}
-
-/*******************************************************************************
-  * @brief State machine to process incoming bytes on the ESP8266 serial 
-  *        interface
-  * @par Parameters:
-  * byte - byte received from ESP8266
-  * @retval None
-  *****************************************************************************/
-void Esp8266_ProcessRxByte(unsigned char byte)
-{
-    static long esp_state = ESP8266_RESET;
-    static long count     = 0;
-    
-    int size = 0;
-
-    //State machine
-    switch(esp_state)
-    {
-        ////////////////////////////////////////////
-        //The initial state for the state machine
-        case ESP8266_RESET:
-        
-            //Reset state variables
-            count = 0;
-            
-            //Check for first byte in the desired message
-            switch(byte)
-            {        
-                case (const)OK_MSG[0]:               
-                    //Found first byte of OK message
-                    esp_state = ESP8266_GET_OK;          
-                    break;
-                    
-                case (const)READY_MSG[0]:
-                    //Found first byte of READY message
-                    esp_state = ESP8266_GET_READY;        
-                    break;
-                    
-                case (const)RX_PACKET_MSG[0]:
-                    //Found first byte of RX message
-                    esp_state = ESP8266_GET_RX_HEADER;
-                    break;
-                
-                case (const)TX_READY_MSG[0]:
-                    //Found first byte of TX message
-                    esp_state = ESP8266_GET_TX;
-                    break;
-            };
-            count++;
-            break;
-        
-        ////////////////////////////////////////////
-        //Process ready message state
-        case ESP8266_GET_READY:
-            if(byte == READY_MSG[count])
-            {    
-                //Increment count and check if all bytes have been received
-                if(++count >= sizeof(READY_MSG) - 1)
-                {
-                    //Got the entire ready message. 
-                    //Reset state machine and set return value for ready message
-                    esp_state = ESP8266_RESET;
-                    status |= ESP8266_READY_MESSAGE;
-                }
-            }
-            else
-            {
-                //Message did not match, reset state machine
-                esp_state = ESP8266_RESET; 
-            }
-            break;
-        
-        ////////////////////////////////////////////
-        //Process OK message state
-        case ESP8266_GET_OK:
-            if(byte == OK_MSG[count])
-            {    
-                //Increment count and check if all bytes have been received
-                if(++count >= sizeof(OK_MSG) - 1)
-                {
-                    //Got the entire OK message. 
-                    //Reset state machine and set return value for OK message
-                    esp_state = ESP8266_RESET;
-                    status |= ESP8266_OK_MESSAGE;
-                }
-            }
-            else
-            {
-                //Message did not match, reset state machine
-                esp_state = ESP8266_RESET; 
-            }
-            break;
-        
-        ////////////////////////////////////////////
-        //Process RX header state
-        case ESP8266_GET_RX_HEADER:
-            if(byte == RX_PACKET_MSG[count])
-            {    
-                //Increment count and check if all bytes have been received
-                if(++count >= sizeof(RX_PACKET_MSG) - 1)
-                {
-                    //Got the entire RX ready message header. 
-                    //Next get length
-                    esp_state = ESP8266_GET_RX_PACKET_SIZE;
-                    count = 0;
-                }
-            }
-            else
-            {
-                //Message did not match, reset state machine
-                esp_state = ESP8266_RESET; 
-            }
-            break;
-            
-        ////////////////////////////////////////////
-        //Process RX size state
-        case ESP8266_GET_RX_PACKET_SIZE:
-            //Keep reading length string until colon character is found
-            if(byte != ':')
-            {
-                packet[count++] = byte;
-            }
-            else
-            {        
-                //Null terminate the lenght string
-                packet[count] = 0;
-                
-                //Try to convert packet length string into a decimal number
-                if(sscanf(packet, "%d", &size) == 1)
-                {
-                    //Record the packet size and clear packet buffer 
-                    //for receiving packet data
-                    packetSize = size;
-                    esp_state = ESP8266_GET_RX_PACKET;
-                    count = 0;
-                }
-                else
-                {
-                    //Error reading length, Reset state machine
-                    esp_state = ESP8266_RESET;
-                }
-            }
-            break;
-        
-        ////////////////////////////////////////////
-        //Process RX packet data state
-        case ESP8266_GET_RX_PACKET:
-            packet[count++] = byte;
-            if(count >= packetSize)
-            {
-                //Reset state machine and set return value for OK message
-                esp_state = ESP8266_RESET;
-                status |= ESP8266_RX_PACKET_MESSAGE;
-            }
-            break;
-            
-        ////////////////////////////////////////////
-        //Process TX ready state
-        case ESP8266_GET_TX:
-            if(byte == TX_READY_MSG[count])
-            {    
-                //Increment count and check if all bytes have been received
-                if(++count >= sizeof(TX_READY_MSG) - 1)
-                {
-                    //Got the entire TX Ready message. 
-                    //Reset state machine and set return value for OK message
-                    esp_state = ESP8266_RESET;
-                    status |= ESP8266_TX_READY_MESSAGE;
-                }
-            }
-            else
-            {
-                //Message did not match, reset state machine
-                esp_state = ESP8266_RESET; 
-            }
-            break;
-        
-        ////////////////////////////////////////////
-        //Catch invalid states and reset
-        default:
-            esp_state = ESP8266_RESET;
-            break;
-        
-    };
-}
-
-/*******************************************************************************
-  * @brief Poll for a response message 
-  * @par Parameters:
-  * msgType - message type to poll for
-  * timeout - delay count
-  * @retval None
-  *****************************************************************************/
-int WaitForResponse(unsigned char msgType, unsigned long timeout)
-{  
-    while(1/*timeout--*/)
-    {
-        //If the status bit for the desired message to be set
-        if((status & msgType) == msgType)
-        {
-            //Clear the status bit and return success
-            status &= ~msgType;
-            return 1;
-        }
-    }
-    
-    return 0;
-}
\ No newline at end of file
+/*******************************************************************************
+  * @file Esp8266.c
+  * @brief Implements functions for interfacing to ESP8266 WIFI chip running
+  *        the AT firmware on the UART. Esp8266Spi.c implements them for the
+  *        SPI link firmware in its place, see ESP8266_SPI_LINK.
+  * @author David Sharpe
+  * @version V1.0.0
+  * @date 02-June-2015
+  *
+  * ST Visual Develop 4.2.1 using STM8 Cosmic C Compiler
+  *****************************************************************************/
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Includes
+////////////////////////////////////////////////////////////////////////////////
+#include "Esp8266.h"
+#include "Esp8266Matcher.h"
+#include "CmdBuilder.h"
+#include "Log.h"
+#include "Pool.h"
+#include "Profile.h"
+#include "Ring.h"
+#include "Uart.h"
+#include "Scheduler.h"
+#include "Trace.h"
+#include "stm8s.h"
+#include "string.h"
+
+#if !ESP8266_SPI_LINK
+
+////////////////////////////////////////////////////////////////////////////////
+// Definitions
+////////////////////////////////////////////////////////////////////////////////
+//Response class of each matcher token, indexed by token number. Tokens 
+//without one are not queued as events.
+const unsigned char TOKEN_STATUS[] =
+{
+    0,                          //ESP8266_TOKEN_NONE
+    ESP8266_OK_MESSAGE,         //ESP8266_TOKEN_OK
+    ESP8266_ERROR_MESSAGE,      //ESP8266_TOKEN_ERROR
+    ESP8266_ERROR_MESSAGE,      //ESP8266_TOKEN_FAIL
+    ESP8266_READY_MESSAGE,      //ESP8266_TOKEN_READY
+    ESP8266_SEND_OK_MESSAGE,    //ESP8266_TOKEN_SEND_OK
+    ESP8266_SEND_FAIL_MESSAGE,  //ESP8266_TOKEN_SEND_FAIL
+    ESP8266_BUSY_MESSAGE,       //ESP8266_TOKEN_BUSY
+    ESP8266_TX_READY_MESSAGE,   //ESP8266_TOKEN_TX_READY
+    0,                          //ESP8266_TOKEN_RX_HEADER
+    ESP8266_CONNECT_MESSAGE,    //ESP8266_TOKEN_CONNECT
+    0,                          //ESP8266_TOKEN_CLOSED
+    0,                          //ESP8266_TOKEN_AP_NAME
+    0                           //ESP8266_TOKEN_LINK_STATUS
+};
+
+//AT+UART_CUR flow control setting, 2 has the module watch its CTS input
+#if UART_FLOW_CONTROL
+#define UART_CUR_FLOW   2
+#else
+#define UART_CUR_FLOW   0
+#endif
+
+//Baud rates tried at start up, see ESP8266_BAUD_NEGOTIATE
+const unsigned long BAUD_RATES[] = ESP8266_BAUD_RATES;
+#define BAUD_RATE_COUNT (sizeof(BAUD_RATES) / sizeof(BAUD_RATES[0]))
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Prototypes
+////////////////////////////////////////////////////////////////////////////////
+AtCommand *Esp8266_GetFreeCommand(void);
+void Esp8266_PushCommand(void);
+AtCommand *Esp8266_GetFirstCommand(void);
+void Esp8266_PushFirstCommand(void);
+int  Esp8266_QueueFirst(const char *cmd, unsigned char length, 
+                        unsigned char response, unsigned short timeout, 
+                        AtCallback callback);
+void Esp8266_ProbeCallback(unsigned char result);
+void Esp8266_ResetCallback(unsigned char result);
+void Esp8266_ResumeCallback(unsigned char result);
+void Esp8266_BaudResetCallback(unsigned char result);
+void Esp8266_SetBaud(unsigned long baud);
+void Esp8266_QueueBaud(void);
+void Esp8266_QueueUartCur(unsigned long baud, unsigned short timeout, 
+                          AtCallback callback);
+void Esp8266_BaudCallback(unsigned char result);
+void Esp8266_VerifyCallback(unsigned char result);
+void Esp8266_FallbackCallback(unsigned char result);
+void Esp8266_ApQueryCallback(unsigned char result);
+void Esp8266_QueueSetAccessPoint(void);
+void Esp8266_CompleteCommand(unsigned char result);
+void Esp8266_ConfigCallback(unsigned char result);
+void Esp8266_ClientCallback(unsigned char result);
+void Esp8266_PutEvent(unsigned char token);
+int  Esp8266_GetEvent(Esp8266Event *event);
+void Esp8266_FlushEvents(void);
+void Esp8266_ProcessCommand(void);
+void Esp8266_ProcessSend(void);
+void Esp8266_CompleteSend(unsigned char result, unsigned short time);
+void Esp8266_ProcessRxIdle(void);
+void Esp8266_PassthroughCallback(unsigned char result);
+void Esp8266_UpdateRxHold(void);
+void Esp8266_OpenLink(unsigned char link);
+void Esp8266_CloseLink(unsigned char link);
+void Esp8266_UpdateProfile(void);
+unsigned char Esp8266_GetQueueSpace(void);
+void Esp8266_StartRxPacket(void);
+int  Esp8266_ParseAddress(const char *ip, unsigned char *address);
+void Esp8266_BuildClientStart(AtCommand *cmd);
+void Esp8266_CheckHealth(void);
+void Esp8266_Fault(void);
+void Esp8266_StartRecovery(unsigned char step);
+void Esp8266_Recovered(void);
+void Esp8266_Restart(void);
+void Esp8266_HealthCallback(unsigned char result);
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Variables
+////////////////////////////////////////////////////////////////////////////////
+//Response events, see ESP8266_EVENT_COUNT. readySeen stays set once the 
+//module has reported ready since start up.
+Esp8266Event eventQueue[ESP8266_EVENT_COUNT];
+unsigned char eventWriteIndex = 0;
+unsigned char eventReadIndex = 0;
+unsigned char readySeen = 0;
+
+//Receive packet pool. The parser fills the slot at rxWriteIndex and the 
+//application borrows the slot at rxReadIndex, so a packet is never 
+//overwritten while it is being processed.
+unsigned char rxPool[ESP8266_RX_PACKET_COUNT][ESP8266_RX_BUFFER_SIZE];
+unsigned char rxPoolLength[ESP8266_RX_PACKET_COUNT];
+unsigned short rxPoolTime[ESP8266_RX_PACKET_COUNT];
+unsigned char rxPoolLink[ESP8266_RX_PACKET_COUNT];
+unsigned char rxWriteIndex = 0;
+unsigned char rxReadIndex = 0;
+unsigned short rxPacketCount = 0;
+unsigned short rxDropCount = 0;
+unsigned short rxOversizeCount = 0;
+
+//Parser state, used for every received byte so it is in page zero
+TINY unsigned short packetSize = 0;
+TINY unsigned char rxState = ESP8266_MATCH;
+TINY unsigned short rxCount = 0;
+unsigned short rxHeaderTime = 0;
+
+//Control packets are shown to the priority callback as they complete, ahead
+//of the pool. rxPriority takes the small ones that find the pool full.
+PacketCallback priorityCallback = 0;
+unsigned char rxPriority[ESP8266_RX_PRIORITY_SIZE];
+
+//Connection table, the role of each link id. lineLink is the link id in
+//front of the last comma on the current line, ESP8266_MAX_LINKS if none.
+unsigned char linkRole[ESP8266_MAX_LINKS];
+TINY unsigned char lineLink = ESP8266_MAX_LINKS;
+TINY unsigned char lastRxByte = 0;
+
+//AT command queue
+AtCommand cmdQueue[ESP8266_CMD_QUEUE_SIZE];
+unsigned char cmdEnqueueIndex = 0;
+unsigned char cmdDequeueIndex = 0;
+unsigned char cmdState = ESP8266_CMD_IDLE;
+unsigned long cmdDeadline = 0;
+unsigned char linkStatus = ESP8266_LINK_DOWN;
+unsigned long linkUpTime = 0;
+
+//Start up. The module is probed until it answers, the access point name is
+//compared with the saved one as the query reply arrives. warmStart is set
+//while a module found running may be kept as it is, see 
+//Esp8266_SetWarmStart.
+unsigned char probeCount = 0;
+unsigned char warmStart = 0;
+const char *apName = 0;
+unsigned char apNameIndex = 0;
+unsigned char apNameMatch = 0;
+
+//Client and server set up, kept to set the module up again after a reset
+const char *clientType = ESP8266_UDP;
+const char *clientIp = 0;
+unsigned short clientPeerPort = 0;
+unsigned short serverPort = 0;
+
+//Baud rate negotiation. baudIndex is the next rate in BAUD_RATES to try.
+unsigned long uartBaud = ESP8266_BAUD;
+unsigned char baudIndex = 0;
+BaudCallback baudCallback = 0;
+
+//Outgoing datagram queue. Datagrams are sent back to back by the send 
+//pipeline whenever no AT command is using the module. Each is held in a 
+//block from the pool until it is retired.
+#if ESP8266_TX_PACKET_SIZE > POOL_BLOCK_SIZE
+#error "Datagrams do not fit a pool block"
+#endif
+unsigned char *txPool[ESP8266_TX_PACKET_COUNT];
+unsigned char txPoolLength[ESP8266_TX_PACKET_COUNT];
+unsigned short txPoolTime[ESP8266_TX_PACKET_COUNT];
+unsigned char txPoolEnqueueIndex = 0;
+unsigned char txPoolDequeueIndex = 0;
+unsigned char sendState = ESP8266_SEND_IDLE;
+unsigned long sendDeadline = 0;
+unsigned char *sendData = 0;
+unsigned char sendLength = 0;
+unsigned char sendLink = ESP8266_PRIMARY_LINK;
+unsigned char sendLane = ESP8266_LANE_PRIMARY;
+unsigned short txFailCount = 0;
+unsigned short txBusyCount = 0;
+SendCallback sendCallback = 0;
+
+//Observer datagram queue. Each datagram keeps a bit for every observer link 
+//it has still to be sent to and is retired once they are all clear.
+unsigned char *obsPool[ESP8266_OBSERVER_COUNT];
+unsigned char obsPoolLength[ESP8266_OBSERVER_COUNT];
+unsigned char obsPoolLinks[ESP8266_OBSERVER_COUNT];
+unsigned char obsEnqueueIndex = 0;
+unsigned char obsDequeueIndex = 0;
+
+//Bulk lane stream and the link it is for, ESP8266_MAX_LINKS once that link
+//has closed. Chunks are sent straight from the ring.
+RING_DEFINE(bulkRing, ESP8266_BULK_BUFFER_SIZE);
+unsigned char bulkLink = ESP8266_MAX_LINKS;
+
+//Transparent (passthrough) mode state, see ESP8266_TRANSPARENT
+unsigned char passthrough = ESP8266_PASSTHROUGH_OFF;
+unsigned char escapeRequested = 0;
+
+//Link profile last queued, and the last datagram from the controller for
+//the automatic switch
+unsigned char linkProfile = ESP8266_PROFILE_NONE;
+unsigned long activityTime = 0;
+unsigned char activitySeen = 0;
+
+#if ESP8266_PEER_DISCOVERY
+//Sender of each packet in the pool from its +IPD header, port 0 if the 
+//header had none, and the client link's peer and local port
+unsigned char rxPoolAddress[ESP8266_RX_PACKET_COUNT][ESP8266_ADDRESS_SIZE];
+unsigned short rxPoolPort[ESP8266_RX_PACKET_COUNT];
+unsigned char peerAddress[ESP8266_ADDRESS_SIZE];
+unsigned short peerPort = 0;
+unsigned short clientPort = 0;
+unsigned char dinfoQueued = 0;
+#endif
+
+//Health monitor, see ESP8266_HEALTH_MONITOR. healthStep is the recovery in
+//progress, lastStep the step that last recovered and lastRecovery when.
+unsigned char healthStep = ESP8266_HEALTH_OK;
+unsigned char healthTries = 0;
+unsigned char lastStep = ESP8266_HEALTH_OK;
+unsigned long lastRecovery = 0;
+unsigned long resetTime = 0;
+unsigned short recoveryCount = 0;
+
+
+/*******************************************************************************
+  * @brief Initialize the Esp8266 and any associated communications interfaces.
+  *        The start up commands are queued and run by Esp8266_Process. The
+  *        module powers up alongside the robot so it is probed rather than 
+  *        reset, AT+RST is only sent if it was already running. The baud 
+  *        rate is raised once the module answers, see 
+  *        ESP8266_BAUD_NEGOTIATE.
+  * @par Parameters:
+  * baud - rate the link settled at last time, ESP8266_BAUD if unknown
+  * @retval None
+  *****************************************************************************/
+void Esp8266_Initialize(unsigned long baud)
+{ 
+    unsigned long first = ESP8266_BAUD;
+    unsigned char i = 0;
+    
+    Esp8266_FlushEvents();
+    readySeen = 0;
+    warmStart = 0;
+    linkStatus = ESP8266_LINK_DOWN;
+    linkUpTime = 0;
+    probeCount = 0;
+    
+    //Empty the command and datagram queues
+    Pool_Release(POOL_TX_DATAGRAM);
+    Pool_Release(POOL_OBSERVER);
+    cmdEnqueueIndex = 0;
+    cmdDequeueIndex = 0;
+    cmdState = ESP8266_CMD_IDLE;
+    txPoolEnqueueIndex = 0;
+    txPoolDequeueIndex = 0;
+    obsEnqueueIndex = 0;
+    obsDequeueIndex = 0;
+    Ring_Clear(&bulkRing);
+    sendState = ESP8266_SEND_IDLE;
+    passthrough = ESP8266_PASSTHROUGH_OFF;
+    escapeRequested = 0;
+#if ESP8266_PEER_DISCOVERY && !ESP8266_TRANSPARENT
+    dinfoQueued = 0;
+#endif
+    
+    //No connections until the module reports them
+    for(i = 0; i < ESP8266_MAX_LINKS; i++)
+    {
+        linkRole[i] = ESP8266_ROLE_NONE;
+    }
+    
+    lineLink = ESP8266_MAX_LINKS;
+
+    //Start from the saved rate, a slower one means the faster ones failed
+    baudIndex = 0;
+    
+    for(i = 0; i < BAUD_RATE_COUNT; i++)
+    {
+        if(BAUD_RATES[i] == baud)
+        {
+            baudIndex = i;
+            first = baud;
+        }
+    }
+    
+    //Drop anything received before the module was set up
+    Uart_ClearRxFifo();
+    
+#if ESP8266_BAUD_NEGOTIATE
+    //A module left running by a robot reset is still at the saved rate and
+    //answers the first probe straight away. A module that is booting takes 
+    //longer than that and is probed at the default.
+    Esp8266_SetBaud(first);
+#else
+    Esp8266_SetBaud(baud);
+#endif
+    
+    //Wait for the module to answer
+    Esp8266_Validate();
+    
+    //Stop ESP8266 from echoing all the commands we send it
+    Esp8266_DisableEcho();
+}
+
+/*******************************************************************************
+  * @brief Let the start up keep a module that is found running. Call after 
+  *        Esp8266_Initialize when only the robot was reset and the module 
+  *        kept its power. If the module then answers the first probe with 
+  *        the client link still connected, the start up queued behind the 
+  *        probe is dropped and the link is ready straight away. Otherwise
+  *        the module is reset and set up as usual. A module in passthrough 
+  *        does not answer the probe, it is always reset.
+  * @par Parameters: None
+  * @retval None
+  *****************************************************************************/
+void Esp8266_SetWarmStart(void)
+{
+#if !ESP8266_TRANSPARENT
+    warmStart = 1;
+#endif
+}
+
+/*******************************************************************************
+  * @brief Validate communications with the Esp8266 are functioning. The 
+  *        probe is repeated until the module has booted and answers.
+  * @par Parameters: None
+  * @retval None
+  *****************************************************************************/
+void Esp8266_Validate()
+{  
+    const char cmd[] = "AT\r\n";
+    
+    //Queue command, completes on OK
+    Esp8266_QueueCommand(cmd, sizeof(cmd)-1, ESP8266_OK_MESSAGE, 
+                         ESP8266_PROBE_INTERVAL, Esp8266_ProbeCallback);
+}
+
+/*******************************************************************************
+  * @brief Reset the Esp8266
+  * @par Parameters: None
+  * @retval None
+  *****************************************************************************/
+void Esp8266_Reset()
+{  
+    const char cmd[] = "AT+RST\r\n";
+    
+    //Queue command, completes on ready message
+    Esp8266_QueueCommand(cmd, sizeof(cmd)-1, ESP8266_READY_MESSAGE, 
+                         TIMEOUT_LONG, Esp8266_ConfigCallback);
+}
+
+/*******************************************************************************
+  * @brief Set the Esp8266 WIFI access point name. The module keeps the 
+  *        access point settings in its flash, so the saved name is queried 
+  *        first and only set if it is different.
+  * @par Parameters:
+  * name - WIFI access point name, must stay valid
+  * @retval None
+  *****************************************************************************/
+void Esp8266_SetAccessPointName(const char *name)
+{
+    const char cmd[] = "AT+CWSAP?\r\n";
+    
+    apName = name;
+    apNameMatch = 0;
+    
+    //Queue the query, completes on OK
+    Esp8266_QueueCommand(cmd, sizeof(cmd)-1, ESP8266_OK_MESSAGE, 
+                         TIMEOUT_SHORT, Esp8266_ApQueryCallback);
+}
+
+/*******************************************************************************
+  * @brief Set the access point name ahead of the commands already queued
+  * @par Parameters: None
+  * @retval None
+  *****************************************************************************/
+void Esp8266_QueueSetAccessPoint(void)
+{
+    AtCommand *cmd = Esp8266_GetFirstCommand();
+    CmdBuilder builder;
+    
+    if(cmd)
+    {
+        //Build set AP command and queue it, completes on OK
+        Cmd_Begin(&builder, cmd->data, ESP8266_CMD_BUFFER_SIZE);
+        Cmd_AppendText(&builder, "AT+CWSAP=\"");
+        Cmd_AppendText(&builder, apName);
+        Cmd_AppendText(&builder, "\",\"\",5,0\r\n");
+        cmd->cmdLength = Cmd_End(&builder);
+        cmd->response = ESP8266_OK_MESSAGE;
+        cmd->timeout = TIMEOUT_SHORT;
+        cmd->callback = Esp8266_ConfigCallback;
+        
+        if(cmd->cmdLength)
+        {
+            Esp8266_PushFirstCommand();
+        }
+    }
+}
+
+/*******************************************************************************
+  * @brief Disable the Esp8266 from echoing back all commands on the 
+  *        communications interface
+  * @par Parameters:
+  * name - WIFI access point name
+  * @retval None
+  *****************************************************************************/
+void Esp8266_DisableEcho()
+{  
+    const char cmd[] = "ATE0\r\n";
+    
+    //Queue command, completes on OK
+    Esp8266_QueueCommand(cmd, sizeof(cmd)-1, ESP8266_OK_MESSAGE, 
+                         TIMEOUT_SHORT, Esp8266_ConfigCallback);
+}
+
+/*******************************************************************************
+  * @brief Start a client connection 
+  * @par Parameters:
+  * type - Connection type (TCP or UDP)
+  * ip - IP address string
+  * port - port number
+  * @retval None
+  *****************************************************************************/
+void Esp8266_StartClient(const char *type, const char *ip, const unsigned short port)
+{
+#if ESP8266_TRANSPARENT
+    const char mux[] = "AT+CIPMUX=0\r\n";
+    const char mode[] = "AT+CIPMODE=1\r\n";
+    const char send[] = "AT+CIPSEND\r\n";
+#else
+    const char mux[] = "AT+CIPMUX=1\r\n";
+#endif
+    AtCommand *cmd = 0;
+    CmdBuilder builder;
+    
+    clientType = type;
+    clientIp = ip;
+    clientPeerPort = port;
+    
+#if ESP8266_TRANSPARENT
+    //Passthrough needs a single connection
+    Esp8266_QueueCommand(mux, sizeof(mux)-1, ESP8266_OK_MESSAGE, 
+                         TIMEOUT_SHORT, Esp8266_ConfigCallback);
+#else
+    //Set MUX for multi  
+    Esp8266_QueueCommand(mux, sizeof(mux)-1, ESP8266_OK_MESSAGE, 
+                         TIMEOUT_SHORT, Esp8266_ConfigCallback);
+    
+#if ESP8266_PEER_DISCOVERY
+    //Where the link starts, see Esp8266_FollowPeer
+    if(!Esp8266_ParseAddress(ip, peerAddress))
+    {
+        memset(peerAddress, 0, sizeof(peerAddress));
+    }
+    
+    peerPort = port;
+    clientPort = port;
+#endif
+#endif
+    
+    //Setup the socket. The link is ready once this completes
+    cmd = Esp8266_GetFreeCommand();
+    
+    if(cmd)
+    {
+        Cmd_Begin(&builder, cmd->data, ESP8266_CMD_BUFFER_SIZE);
+#if ESP8266_TRANSPARENT
+        Cmd_AppendText(&builder, "AT+CIPSTART=\"");
+        cmd->callback = Esp8266_ConfigCallback;
+#else
+        Cmd_AppendText(&builder, "AT+CIPSTART=");
+        Cmd_AppendUnsigned(&builder, ESP8266_PRIMARY_LINK);
+        Cmd_AppendText(&builder, ",\"");
+        cmd->callback = Esp8266_ClientCallback;
+#endif
+        Cmd_AppendText(&builder, type);
+        Cmd_AppendText(&builder, "\",\"");
+        Cmd_AppendText(&builder, ip);
+        Cmd_AppendText(&builder, "\",");
+        Cmd_AppendUnsigned(&builder, port);
+        Cmd_AppendChar(&builder, ',');
+        Cmd_AppendUnsigned(&builder, port);
+        Cmd_AppendText(&builder, ",0\r\n");
+        cmd->cmdLength = Cmd_End(&builder);
+        cmd->response = ESP8266_OK_MESSAGE;
+        cmd->timeout = TIMEOUT_SHORT;
+        
+        if(cmd->cmdLength)
+        {
+            Esp8266_PushCommand();
+        }
+    }
+    
+#if ESP8266_TRANSPARENT
+    //Switch to passthrough. The parser enters raw mode on the "> " 
+    //prompt that answers the CIPSEND, the link is ready once it completes
+    Esp8266_QueueCommand(mode, sizeof(mode)-1, ESP8266_OK_MESSAGE, 
+                         TIMEOUT_SHORT, Esp8266_PassthroughCallback);
+    Esp8266_QueueCommand(send, sizeof(send)-1, ESP8266_TX_READY_MESSAGE, 
+                         TIMEOUT_SHORT, Esp8266_ClientCallback);
+#endif
+}
+
+#if !ESP8266_TRANSPARENT
+/*******************************************************************************
+  * @brief Build the CIPSTART of the client link into a command slot, to the
+  *        peer it was last started with
+  * @par Parameters:
+  * cmd - command slot, the callback is left to the caller
+  * @retval None
+  *****************************************************************************/
+void Esp8266_BuildClientStart(AtCommand *cmd)
+{
+    CmdBuilder builder;
+#if ESP8266_PEER_DISCOVERY
+    unsigned char i = 0;
+#endif
+    
+    Cmd_Begin(&builder, cmd->data, ESP8266_CMD_BUFFER_SIZE);
+    Cmd_AppendText(&builder, "AT+CIPSTART=");
+    Cmd_AppendUnsigned(&builder, ESP8266_PRIMARY_LINK);
+    Cmd_AppendText(&builder, ",\"");
+    Cmd_AppendText(&builder, clientType);
+    Cmd_AppendText(&builder, "\",\"");
+    
+#if ESP8266_PEER_DISCOVERY
+    //Wherever the link was moved to, the same local port
+    for(i = 0; i < ESP8266_ADDRESS_SIZE; i++)
+    {
+        if(i > 0)
+        {
+            Cmd_AppendChar(&builder, '.');
+        }
+        
+        Cmd_AppendUnsigned(&builder, peerAddress[i]);
+    }
+    
+    Cmd_AppendText(&builder, "\",");
+    Cmd_AppendUnsigned(&builder, peerPort);
+    Cmd_AppendChar(&builder, ',');
+    Cmd_AppendUnsigned(&builder, clientPort);
+#else
+    Cmd_AppendText(&builder, clientIp);
+    Cmd_AppendText(&builder, "\",");
+    Cmd_AppendUnsigned(&builder, clientPeerPort);
+    Cmd_AppendChar(&builder, ',');
+    Cmd_AppendUnsigned(&builder, clientPeerPort);
+#endif
+    
+    Cmd_AppendText(&builder, ",0\r\n");
+    cmd->cmdLength = Cmd_End(&builder);
+    cmd->response = ESP8266_OK_MESSAGE;
+    cmd->timeout = TIMEOUT_SHORT;
+}
+#endif
+
+#if ESP8266_PEER_DISCOVERY
+/*******************************************************************************
+  * @brief Parse a dotted IPv4 address
+  * @par Parameters:
+  * ip - dotted address string
+  * address - set to the ESP8266_ADDRESS_SIZE address bytes
+  * @retval 1 if parsed, 0 if the string is not an address
+  *****************************************************************************/
+int Esp8266_ParseAddress(const char *ip, unsigned char *address)
+{
+    unsigned short value = 0;
+    unsigned char digits = 0;
+    unsigned char i = 0;
+    
+    while(i < ESP8266_ADDRESS_SIZE)
+    {
+        if(*ip >= '0' && *ip <= '9' && digits < 3)
+        {
+            value = (value * 10) + (*ip - '0');
+            digits++;
+        }
+        else if(digits == 0 || value > 255 || 
+                *ip != ((i < ESP8266_ADDRESS_SIZE - 1) ? '.' : 0))
+        {
+            return 0;
+        }
+        else
+        {
+            address[i++] = (unsigned char)value;
+            value = 0;
+            digits = 0;
+        }
+        
+        ip++;
+    }
+    
+    return 1;
+}
+#endif
+
+/*******************************************************************************
+  * @brief Start a TCP server next to the client, its connections are the 
+  *        observer links. Needs the multiple connection mode set by 
+  *        Esp8266_StartClient, setting it again once the client link is up 
+  *        fails.
+  * @par Parameters:
+  * port - server port number
+  * @retval None
+  *****************************************************************************/
+void Esp8266_StartTcpServer(const unsigned short port)
+{
+    AtCommand *cmd = 0;
+    CmdBuilder builder;
+    
+    serverPort = port;
+    
+    //Setup TCP server socket  
+    cmd = Esp8266_GetFreeCommand();
+    
+    if(cmd)
+    {
+        Cmd_Begin(&builder, cmd->data, ESP8266_CMD_BUFFER_SIZE);
+        Cmd_AppendText(&builder, "AT+CIPSERVER=1,");
+        Cmd_AppendUnsigned(&builder, port);
+        Cmd_AppendText(&builder, "\r\n");
+        cmd->cmdLength = Cmd_End(&builder);
+        cmd->response = ESP8266_OK_MESSAGE;
+        cmd->timeout = TIMEOUT_SHORT;
+        cmd->callback = Esp8266_ConfigCallback;
+        Esp8266_PushCommand();
+    }
+    
+    //Set default server timeout
+    Esp8266_SetTcpServerTimeout(ESP8266_SERVER_TIMEOUT);
+}
+
+/*******************************************************************************
+  * @brief Set the TCP timeout
+  * @par Parameters:
+  * seconds - timeout in seconds
+  * @retval None
+  *****************************************************************************/
+void Esp8266_SetTcpServerTimeout(const unsigned short seconds)
+{
+    AtCommand *cmd = Esp8266_GetFreeCommand();
+    CmdBuilder builder;
+    
+    if(cmd)
+    {
+        //Setup TCP server timeout  
+        Cmd_Begin(&builder, cmd->data, ESP8266_CMD_BUFFER_SIZE);
+        Cmd_AppendText(&builder, "AT+CIPSTO=");
+        Cmd_AppendUnsigned(&builder, seconds);
+        Cmd_AppendText(&builder, "\r\n");
+        cmd->cmdLength = Cmd_End(&builder);
+        cmd->response = ESP8266_OK_MESSAGE;
+        cmd->timeout = TIMEOUT_SHORT;
+        cmd->callback = Esp8266_ConfigCallback;
+        Esp8266_PushCommand();
+    }
+}
+
+/*******************************************************************************
+  * @brief Get the remote client's IP address
+  * @par Parameters: None
+  * @retval None
+  *****************************************************************************/
+void Esp8266_GetRemoteClientIp()
+{
+    //TODO
+}
+
+/*******************************************************************************
+  * @brief Send a message on the primary link. The message is copied into the
+  *        datagram queue and sent once the Esp8266 is ready for it, this 
+  *        does not block.
+  * @par Parameters:
+  * buffer - data to send
+  * length - data length in bytes
+  * @retval 1 if the message was queued, 0 if the link is not ready, the queue 
+  *         is full or the message is larger than ESP8266_TX_PACKET_SIZE
+  *****************************************************************************/
+int Esp8266_SendMsg(const unsigned char *buffer, unsigned short length)
+{ 
+    unsigned char next = txPoolEnqueueIndex + 1;
+    unsigned char *block = 0;
+    
+    PROFILE_START(PROFILE_SEND_MSG);
+    
+    if(next >= ESP8266_TX_PACKET_COUNT)
+    {
+        next = 0;
+    }
+    
+    if(linkStatus != ESP8266_LINK_READY || next == txPoolDequeueIndex || 
+       length == 0 || length > ESP8266_TX_PACKET_SIZE || 
+       (block = Pool_Alloc(POOL_TX_DATAGRAM)) == 0)
+    {
+        PROFILE_END(PROFILE_SEND_MSG);
+        return 0;
+    }
+    
+    memcpy(block, buffer, length);
+    txPool[txPoolEnqueueIndex] = block;
+    txPoolLength[txPoolEnqueueIndex] = (unsigned char)length;
+    txPoolTime[txPoolEnqueueIndex] = Sched_GetMicros();
+    txPoolEnqueueIndex = next;
+    
+    PROFILE_END(PROFILE_SEND_MSG);
+    
+    return 1;
+}
+
+/*******************************************************************************
+  * @brief Send a message to every observer link. The message is copied once
+  *        into the observer queue and sent to each observer in turn while 
+  *        nothing is waiting for the primary link, this does not block.
+  * @par Parameters:
+  * buffer - data to send
+  * length - data length in bytes
+  * @retval 1 if the message was queued, 0 if no observer is connected, the 
+  *         queue is full or the message is larger than ESP8266_TX_PACKET_SIZE
+  *****************************************************************************/
+int Esp8266_SendObservers(const unsigned char *buffer, unsigned short length)
+{
+    unsigned char next = obsEnqueueIndex + 1;
+    unsigned char links = 0;
+    unsigned char i = 0;
+    unsigned char *block = 0;
+    
+    if(next >= ESP8266_OBSERVER_COUNT)
+    {
+        next = 0;
+    }
+    
+    for(i = 0; i < ESP8266_MAX_LINKS; i++)
+    {
+        if(linkRole[i] == ESP8266_ROLE_OBSERVER)
+        {
+            links |= (unsigned char)(1 << i);
+        }
+    }
+    
+    if(links == 0 || passthrough != ESP8266_PASSTHROUGH_OFF || 
+       next == obsDequeueIndex || length == 0 || length > ESP8266_TX_PACKET_SIZE ||
+       (block = Pool_Alloc(POOL_OBSERVER)) == 0)
+    {
+        return 0;
+    }
+    
+    memcpy(block, buffer, length);
+    obsPool[obsEnqueueIndex] = block;
+    obsPoolLength[obsEnqueueIndex] = (unsigned char)length;
+    obsPoolLinks[obsEnqueueIndex] = links;
+    obsEnqueueIndex = next;
+    
+    return 1;
+}
+
+/*******************************************************************************
+  * @brief Send a message on the bulk lane. The message is added to the 
+  *        stream for the link and sent in chunks while neither the primary 
+  *        link nor the observers are waiting, this does not block.
+  * @par Parameters:
+  * link - observer link to send to
+  * buffer - data to send
+  * length - data length in bytes
+  * @retval 1 if the message was queued, 0 if the link is not an observer, 
+  *         the lane is still sending to another link or there is no room
+  *****************************************************************************/
+int Esp8266_SendBulk(unsigned char link, const unsigned char *buffer, 
+                     unsigned char length)
+{
+    if(Esp8266_GetLinkRole(link) != ESP8266_ROLE_OBSERVER || 
+       (Ring_Count(&bulkRing) && link != bulkLink) ||
+       !Ring_Write(&bulkRing, (unsigned char *)buffer, length))
+    {
+        return 0;
+    }
+    
+    bulkLink = link;
+    
+    return 1;
+}
+
+/*******************************************************************************
+  * @brief Get the role of a link in the connection table
+  * @par Parameters:
+  * link - link id
+  * @retval ESP8266_ROLE_NONE, ESP8266_ROLE_PRIMARY or ESP8266_ROLE_OBSERVER
+  *****************************************************************************/
+unsigned char Esp8266_GetLinkRole(unsigned char link)
+{
+    return (link < ESP8266_MAX_LINKS) ? linkRole[link] : ESP8266_ROLE_NONE;
+}
+
+/*******************************************************************************
+  * @brief Add a link the module reported as connected to the connection 
+  *        table
+  * @par Parameters:
+  * link - link id, ESP8266_MAX_LINKS or more if the report had none
+  * @retval None
+  *****************************************************************************/
+void Esp8266_OpenLink(unsigned char link)
+{
+    if(link < ESP8266_MAX_LINKS)
+    {
+        linkRole[link] = (link == ESP8266_PRIMARY_LINK) ? ESP8266_ROLE_PRIMARY :
+                                                          ESP8266_ROLE_OBSERVER;
+        LOG2(LOG_LINK_OPENED, link, linkRole[link]);
+    }
+}
+
+/*******************************************************************************
+  * @brief Remove a link the module reported as closed from the connection 
+  *        table. Datagrams still queued for it are not sent. The link is
+  *        down if it was the primary one or the module only has one.
+  * @par Parameters:
+  * link - link id, ESP8266_MAX_LINKS or more if the report had none
+  * @retval None
+  *****************************************************************************/
+void Esp8266_CloseLink(unsigned char link)
+{
+    unsigned char i = 0;
+    
+    LOG1(LOG_LINK_CLOSED, link);
+    
+    if(link >= ESP8266_MAX_LINKS || link == ESP8266_PRIMARY_LINK)
+    {
+        linkStatus = ESP8266_LINK_DOWN;
+    }
+    
+    if(link < ESP8266_MAX_LINKS)
+    {
+        linkRole[link] = ESP8266_ROLE_NONE;
+        
+        for(i = 0; i < ESP8266_OBSERVER_COUNT; i++)
+        {
+            obsPoolLinks[i] &= (unsigned char)~(1 << link);
+        }
+        
+        //The rest of its stream is dropped by the send pipeline
+        if(link == bulkLink)
+        {
+            bulkLink = ESP8266_MAX_LINKS;
+        }
+    }
+}
+
+/*******************************************************************************
+  * @brief Queue the AT commands for a link profile. They go out behind the
+  *        commands already queued, so the main loop never waits for them. A
+  *        module that does not know a command answers ERROR, which is 
+  *        ignored.
+  * @par Parameters:
+  * profile - ESP8266_PROFILE_LOW_LATENCY or ESP8266_PROFILE_IDLE
+  * @retval 1 if the profile is queued or already set, 0 if the queue is 
+  *         full
+  *****************************************************************************/
+int Esp8266_SetLinkProfile(unsigned char profile)
+{
+    const char sleepOff[] = "AT+SLEEP=0\r\n";
+    const char sleepModem[] = "AT+SLEEP=2\r\n";
+    AtCommand *cmd = 0;
+    CmdBuilder builder;
+    
+    if(profile == linkProfile)
+    {
+        return 1;
+    }
+    
+    //Both commands or neither
+    if(Esp8266_GetQueueSpace() < 2)
+    {
+        return 0;
+    }
+    
+    Esp8266_QueueCommand((profile == ESP8266_PROFILE_IDLE) ? sleepModem : 
+                         sleepOff, sizeof(sleepOff)-1, ESP8266_OK_MESSAGE, 
+                         TIMEOUT_SHORT, 0);
+    
+    cmd = Esp8266_GetFreeCommand();
+    Cmd_Begin(&builder, cmd->data, ESP8266_CMD_BUFFER_SIZE);
+    Cmd_AppendText(&builder, "AT+RFPOWER=");
+    Cmd_AppendUnsigned(&builder, (profile == ESP8266_PROFILE_IDLE) ? 
+                                 ESP8266_IDLE_RFPOWER : ESP8266_FULL_RFPOWER);
+    Cmd_AppendText(&builder, "\r\n");
+    cmd->cmdLength = Cmd_End(&builder);
+    cmd->response = ESP8266_OK_MESSAGE;
+    cmd->timeout = TIMEOUT_SHORT;
+    cmd->callback = 0;
+    Esp8266_PushCommand();
+    
+    linkProfile = profile;
+    activityTime = Sched_GetTime();
+    activitySeen = 0;
+    
+    return 1;
+}
+
+/*******************************************************************************
+  * @brief Get the link profile last queued
+  * @par Parameters: None
+  * @retval LinkProfile value
+  *****************************************************************************/
+unsigned char Esp8266_GetLinkProfile(void)
+{
+    return linkProfile;
+}
+
+/*******************************************************************************
+  * @brief Switch the link profile on the controller's activity, see 
+  *        ESP8266_AUTO_PROFILE. Starts low latency once the link is up and 
+  *        the start up commands have left room in the queue.
+  * @par Parameters: None
+  * @retval None
+  *****************************************************************************/
+void Esp8266_UpdateProfile(void)
+{
+    if(linkStatus != ESP8266_LINK_READY)
+    {
+        return;
+    }
+    
+    if(linkProfile == ESP8266_PROFILE_NONE || 
+       (linkProfile == ESP8266_PROFILE_IDLE && activitySeen))
+    {
+        Esp8266_SetLinkProfile(ESP8266_PROFILE_LOW_LATENCY);
+    }
+    else if(linkProfile == ESP8266_PROFILE_LOW_LATENCY && 
+            Sched_IsExpired(activityTime + ESP8266_IDLE_TIMEOUT))
+    {
+        Esp8266_SetLinkProfile(ESP8266_PROFILE_IDLE);
+    }
+}
+
+/*******************************************************************************
+  * @brief Leave passthrough mode. Queued datagrams are sent first, then the 
+  *        "+++" escape is sent between two guard times and passthrough is 
+  *        turned off so AT commands can be used again.
+  * @par Parameters: None
+  * @retval None
+  *****************************************************************************/
+void Esp8266_ExitPassthrough(void)
+{
+    if(passthrough == ESP8266_PASSTHROUGH_ON)
+    {
+        escapeRequested = 1;
+    }
+}
+
+/*******************************************************************************
+  * @brief Check if the module is in passthrough mode
+  * @par Parameters: None
+  * @retval 1 if datagrams are exchanged as raw bytes, 0 otherwise
+  *****************************************************************************/
+int Esp8266_IsPassthrough(void)
+{
+    return (passthrough == ESP8266_PASSTHROUGH_ON);
+}
+
+/*******************************************************************************
+  * @brief Borrow the oldest received packet from the packet pool. The packet 
+  *        stays valid until Esp8266_ReleasePacket is called.
+  * @par Parameters:
+  * packet - set to point at the packet data
+  * @retval number of bytes in the packet, 0 if no packet is waiting
+  *****************************************************************************/
+unsigned char Esp8266_AcquirePacket(const unsigned char **packet)
+{
+    unsigned char index = rxReadIndex;
+    
+    //Pool is empty
+    if(index == rxWriteIndex)
+    {
+        return 0;
+    }
+    
+    *packet = rxPool[index];
+    return rxPoolLength[index];
+}
+
+/*******************************************************************************
+  * @brief Get the time the packet returned by Esp8266_AcquirePacket started
+  *        to arrive
+  * @par Parameters: None
+  * @retval microsecond timestamp of the +IPD header, see Sched_GetMicros
+  *****************************************************************************/
+unsigned short Esp8266_GetPacketTime(void)
+{
+    return rxPoolTime[rxReadIndex];
+}
+
+/*******************************************************************************
+  * @brief Get the link the packet returned by Esp8266_AcquirePacket came in 
+  *        on
+  * @par Parameters: None
+  * @retval link id, ESP8266_PRIMARY_LINK if the module has only one link
+  *****************************************************************************/
+unsigned char Esp8266_GetPacketLink(void)
+{
+    return rxPoolLink[rxReadIndex];
+}
+
+/*******************************************************************************
+  * @brief Move the client link to the sender of the packet returned by 
+  *        Esp8266_AcquirePacket if it is not the client's peer, see 
+  *        ESP8266_PEER_DISCOVERY. Call once the packet has passed as a frame
+  *        from the controller, so a stray datagram cannot take the link. The
+  *        link is closed and started again through the command queue, 
+  *        datagrams sent before it is back are lost.
+  * @par Parameters: None
+  * @retval 1 if the link is being moved, 0 if not
+  *****************************************************************************/
+int Esp8266_FollowPeer(void)
+{
+#if ESP8266_PEER_DISCOVERY && !ESP8266_TRANSPARENT
+    unsigned char index = rxReadIndex;
+    const unsigned char *address = rxPoolAddress[index];
+    AtCommand *cmd = 0;
+    CmdBuilder builder;
+    
+    if(index == rxWriteIndex || rxPoolLink[index] != ESP8266_PRIMARY_LINK ||
+       rxPoolPort[index] == 0)
+    {
+        return 0;
+    }
+    
+    if(rxPoolPort[index] == peerPort && 
+       memcmp(address, peerAddress, ESP8266_ADDRESS_SIZE) == 0)
+    {
+        return 0;
+    }
+    
+    //Both commands or neither, a later frame tries again
+    if(Esp8266_GetQueueSpace() < 2)
+    {
+        return 0;
+    }
+    
+    cmd = Esp8266_GetFreeCommand();
+    Cmd_Begin(&builder, cmd->data, ESP8266_CMD_BUFFER_SIZE);
+    Cmd_AppendText(&builder, "AT+CIPCLOSE=");
+    Cmd_AppendUnsigned(&builder, ESP8266_PRIMARY_LINK);
+    Cmd_AppendText(&builder, "\r\n");
+    cmd->cmdLength = Cmd_End(&builder);
+    cmd->response = ESP8266_OK_MESSAGE;
+    cmd->timeout = TIMEOUT_SHORT;
+    cmd->callback = 0;
+    Esp8266_PushCommand();
+    
+    //Same local port, the controller's address and port
+    memcpy(peerAddress, address, ESP8266_ADDRESS_SIZE);
+    peerPort = rxPoolPort[index];
+    
+    cmd = Esp8266_GetFreeCommand();
+    Esp8266_BuildClientStart(cmd);
+    cmd->callback = Esp8266_ClientCallback;
+    Esp8266_PushCommand();
+    
+    LOG3(LOG_PEER_FOLLOWED, address[2], address[3], peerPort);
+    
+    return 1;
+#else
+    return 0;
+#endif
+}
+
+/*******************************************************************************
+  * @brief Hand the packet returned by Esp8266_AcquirePacket back to the pool
+  * @par Parameters: None
+  * @retval None
+  *****************************************************************************/
+void Esp8266_ReleasePacket(void)
+{
+    unsigned char index = rxReadIndex;
+    
+    if(index != rxWriteIndex)
+    {
+        //The controller is active, see ESP8266_AUTO_PROFILE
+        if(rxPoolLink[index] == ESP8266_PRIMARY_LINK)
+        {
+            activityTime = Sched_GetTime();
+            activitySeen = 1;
+        }
+        
+        if(++index >= ESP8266_RX_PACKET_COUNT)
+        {
+            index = 0;
+        }
+        
+        rxReadIndex = index;
+        
+#if UART_FLOW_CONTROL
+        Esp8266_UpdateRxHold();
+#endif
+    }
+}
+
+/*******************************************************************************
+  * @brief Hold the module's data while the packet pool is close to full, 
+  *        see UART_FLOW_CONTROL. Also lets go of the hold the RX interrupt 
+  *        sets while the receive ring is nearly full.
+  * @par Parameters: None
+  * @retval None
+  *****************************************************************************/
+void Esp8266_UpdateRxHold(void)
+{
+    unsigned char used = rxWriteIndex - rxReadIndex;
+    
+    if(rxWriteIndex < rxReadIndex)
+    {
+        used += ESP8266_RX_PACKET_COUNT;
+    }
+    
+    //One slot is always left empty to tell a full pool from an empty one
+    Uart_SetRxHold((ESP8266_RX_PACKET_COUNT - 1) - used <= ESP8266_RX_HOLD_FREE);
+}
+
+/*******************************************************************************
+  * @brief Get the number of received packets published to the pool
+  * @par Parameters: None
+  * @retval received packet count
+  *****************************************************************************/
+unsigned short Esp8266_GetRxPacketCount(void)
+{
+    return rxPacketCount;
+}
+
+/*******************************************************************************
+  * @brief Get the number of received packets that were dropped because the
+  *        packet pool was full
+  * @par Parameters: None
+  * @retval dropped packet count
+  *****************************************************************************/
+unsigned short Esp8266_GetRxDropCount(void)
+{
+    return rxDropCount;
+}
+
+/*******************************************************************************
+  * @brief Get the number of received packets that were dropped because they
+  *        were larger than ESP8266_RX_BUFFER_SIZE
+  * @par Parameters: None
+  * @retval oversize packet count
+  *****************************************************************************/
+unsigned short Esp8266_GetRxOversizeCount(void)
+{
+    return rxOversizeCount;
+}
+
+/*******************************************************************************
+  * @brief Get the number of queued datagrams the module failed to send
+  * @par Parameters: None
+  * @retval failed datagram count
+  *****************************************************************************/
+unsigned short Esp8266_GetTxFailCount(void)
+{
+    return txFailCount;
+}
+
+/*******************************************************************************
+  * @brief Get the number of times the module was too busy to take a CIPSEND
+  * @par Parameters: None
+  * @retval busy count
+  *****************************************************************************/
+unsigned short Esp8266_GetBusyCount(void)
+{
+    return txBusyCount;
+}
+
+/*******************************************************************************
+  * @brief Get the number of faults the health monitor has recovered from or
+  *        is recovering from
+  * @par Parameters: None
+  * @retval recovery count
+  *****************************************************************************/
+unsigned short Esp8266_GetRecoveryCount(void)
+{
+    return recoveryCount;
+}
+
+/*******************************************************************************
+  * @brief Check the module still answers, for when the controller has gone
+  *        quiet and the line with it. An AT probe is queued, its timeout is
+  *        taken as a fault.
+  * @par Parameters: None
+  * @retval None
+  *****************************************************************************/
+void Esp8266_Probe(void)
+{
+#if ESP8266_HEALTH_MONITOR && !ESP8266_TRANSPARENT
+    const char probe[] = "AT\r\n";
+    
+    if(linkStatus == ESP8266_LINK_READY && healthStep == ESP8266_HEALTH_OK)
+    {
+        Esp8266_QueueCommand(probe, sizeof(probe)-1, ESP8266_OK_MESSAGE, 
+                             ESP8266_PROBE_INTERVAL, 0);
+    }
+#endif
+}
+
+/*******************************************************************************
+  * @brief Get the recovery step in progress
+  * @par Parameters: None
+  * @retval HealthStep value, ESP8266_HEALTH_OK if none
+  *****************************************************************************/
+unsigned char Esp8266_GetHealth(void)
+{
+    return healthStep;
+}
+
+/*******************************************************************************
+  * @brief Parse the bytes the UART RX interrupt has queued. Up to 
+  *        ESP8266_RX_BURST bytes are parsed per call so the periodic tasks 
+  *        are not held up, once ESP8266_RX_HIGH_WATER bytes are waiting the
+  *        whole ring is drained before returning. Called from the main loop.
+  * @par Parameters: None
+  * @retval 1 if anything was parsed, 0 if the ring was empty
+  *****************************************************************************/
+int Esp8266_ProcessRx(void)
+{
+    unsigned char byte = 0;
+    unsigned char event = 0;
+    unsigned char budget = ESP8266_RX_BURST;
+    unsigned char parsed = 0;
+    
+    while((event = Uart_GetRxEvent(&byte)) != UART_RX_NONE)
+    {
+        if(event == UART_RX_IDLE)
+        {
+            //Passthrough data has no header, datagrams are framed by the 
+            //idle line
+            Esp8266_ProcessRxIdle();
+        }
+        else
+        {
+            Esp8266_ProcessRxByte(byte);
+        }
+        
+        parsed = 1;
+        
+        //End of the burst, carry on while over the high water mark
+        if(--budget == 0 && Uart_GetRxCount() < ESP8266_RX_HIGH_WATER)
+        {
+            break;
+        }
+    }
+    
+#if UART_FLOW_CONTROL
+    //Let go of the hold the RX interrupt may have set
+    Esp8266_UpdateRxHold();
+#endif
+    
+    return parsed;
+}
+
+/*******************************************************************************
+  * @brief Check the receive path is between lines with nothing waiting, so
+  *        bytes fed to Esp8266_ProcessRxByte from elsewhere cannot split a
+  *        response. With no command or send in flight the module has 
+  *        finished its last line.
+  * @par Parameters: None
+  * @retval 1 if idle, 0 otherwise
+  *****************************************************************************/
+int Esp8266_IsRxIdle(void)
+{
+    return (rxState == ESP8266_MATCH && cmdState == ESP8266_CMD_IDLE &&
+            sendState == ESP8266_SEND_IDLE && rxReadIndex == rxWriteIndex &&
+            !Uart_IsRxDataReady());
+}
+
+/*******************************************************************************
+  * @brief State machine to process incoming bytes on the ESP8266 serial 
+  *        interface. Responses are recognised by the generated matcher in
+  *        Esp8266Matcher.c which tracks every token at once, one table 
+  *        lookup per byte.
+  * @par Parameters:
+  * byte - byte received from ESP8266
+  * @retval None
+  *****************************************************************************/
+void Esp8266_ProcessRxByte(unsigned char byte)
+{
+    static TINY unsigned char match  = 0;
+    static TINY unsigned char fields = 0;
+#if ESP8266_PEER_DISCOVERY
+    static unsigned short peerValue = 0;
+#endif
+    
+    unsigned char next = 0;
+    unsigned char token = 0;
+    unsigned char entryState = rxState;
+
+    PROFILE_START(PROFILE_ESP_RX_BYTE);
+
+    //State machine
+    switch(rxState)
+    {
+        ////////////////////////////////////////////
+        //Match response tokens
+        case ESP8266_MATCH:
+            match = ESP8266_MATCH_NEXT[match][ESP8266_MATCH_CLASS[byte]];
+            token = ESP8266_MATCH_TOKEN[match];
+            
+            if(token)
+            {
+                //Token consumed, start matching again from the root
+                match = 0;
+                TRACE(TRACE_RX_TOKEN, token);
+                
+                if(token == ESP8266_TOKEN_RX_HEADER)
+                {
+                    //Got the +IPD, header. Next get length
+                    rxHeaderTime = Sched_GetMicros();
+                    rxState = ESP8266_GET_RX_PACKET_SIZE;
+                    packetSize = 0;
+                    fields = 0;
+                    rxCount = 0;
+                    rxPoolLink[rxWriteIndex] = ESP8266_PRIMARY_LINK;
+#if ESP8266_PEER_DISCOVERY
+                    rxPoolPort[rxWriteIndex] = 0;
+#endif
+                }
+                else if(token == ESP8266_TOKEN_CONNECT)
+                {
+                    Esp8266_OpenLink(lineLink);
+                    Esp8266_PutEvent(token);
+                }
+                else if(token == ESP8266_TOKEN_CLOSED)
+                {
+                    Esp8266_CloseLink(lineLink);
+                }
+                else if(token == ESP8266_TOKEN_AP_NAME)
+                {
+                    //Compare the saved name up to the closing quote
+                    rxState = ESP8266_CHECK_AP_NAME;
+                    apNameIndex = 0;
+                    apNameMatch = (apName != 0);
+                }
+                else if(token == ESP8266_TOKEN_LINK_STATUS)
+                {
+                    //A connection the module already has, its id is next
+                    rxState = ESP8266_GET_LINK_STATUS;
+                }
+                else if(token == ESP8266_TOKEN_TX_READY && 
+                        passthrough == ESP8266_PASSTHROUGH_ENTERING)
+                {
+                    //Everything after the prompt is raw datagram data
+                    passthrough = ESP8266_PASSTHROUGH_ON;
+                    Esp8266_PutEvent(token);
+                    rxState = ESP8266_SKIP_RAW_PACKET;
+                }
+                else if(TOKEN_STATUS[token])
+                {
+                    Esp8266_PutEvent(token);
+                }
+            }
+            
+            //In multiple connection mode CONNECT and CLOSED are preceded by
+            //"<link>," on their line, keep the digit in front of the comma
+            if(byte == ',')
+            {
+                lineLink = lastRxByte - '0';
+            }
+            else if(byte == '\n')
+            {
+                lineLink = ESP8266_MAX_LINKS;
+            }
+            
+            lastRxByte = byte;
+            break;
+            
+        ////////////////////////////////////////////
+        //Process RX size state
+        case ESP8266_GET_RX_PACKET_SIZE:
+            //Accumulate the decimal length one digit at a time 
+            //until the colon character is found
+            if(byte >= '0' && byte <= '9')
+            {
+                //The module never sends more than ESP8266_RX_MAX_DIGITS 
+                //digits, anything longer is garbage so resync
+                if(++rxCount > ESP8266_RX_MAX_DIGITS)
+                {
+                    rxState = ESP8266_MATCH;
+                }
+                else
+                {
+                    packetSize = (packetSize * 10) + (byte - '0');
+                }
+            }
+            else if(byte == ',' && rxCount > 0 && fields == 0 && 
+                    packetSize < ESP8266_MAX_LINKS)
+            {
+                //In multiple connection mode the link id comes first, 
+                //keep it and read the length that follows
+                rxPoolLink[rxWriteIndex] = (unsigned char)packetSize;
+                fields++;
+                packetSize = 0;
+                rxCount = 0;
+            }
+#if ESP8266_PEER_DISCOVERY
+            else if(byte == ',' && rxCount > 0 && fields == 1)
+            {
+                //With AT+CIPDINFO=1 the sender's address and port follow 
+                //the length
+                rxState = ESP8266_GET_RX_PEER;
+                fields++;
+                rxCount = 0;
+                peerValue = 0;
+            }
+#endif
+            else if(byte == ':' && rxCount > 0 && packetSize > 0)
+            {
+                Esp8266_StartRxPacket();
+            }
+            else
+            {
+                //Error reading length, Reset state machine
+                rxState = ESP8266_MATCH;
+            }
+            break;
+            
+#if ESP8266_PEER_DISCOVERY
+        ////////////////////////////////////////////
+        //Process RX sender state, "<a>.<b>.<c>.<d>,<port>:" with fields 
+        //counting on from 2 for the first byte of the address
+        case ESP8266_GET_RX_PEER:
+            if(byte >= '0' && byte <= '9')
+            {
+                //Three digits at most in an address byte and five in the 
+                //port, which has to fit 16 bits
+                if(++rxCount > ((fields < 6) ? 3 : 5) || 
+                   peerValue > (65535 - (byte - '0')) / 10)
+                {
+                    rxState = ESP8266_MATCH;
+                }
+                else
+                {
+                    peerValue = (peerValue * 10) + (byte - '0');
+                }
+            }
+            else if(rxCount == 0 || (fields < 6 && peerValue > 255))
+            {
+                //Empty field or an address byte out of range, resync
+                rxState = ESP8266_MATCH;
+            }
+            else if(fields < 6 && byte == ((fields < 5) ? '.' : ','))
+            {
+                rxPoolAddress[rxWriteIndex][fields - 2] = (unsigned char)peerValue;
+                fields++;
+                rxCount = 0;
+                peerValue = 0;
+            }
+            else if(fields == 6 && byte == ':')
+            {
+                rxPoolPort[rxWriteIndex] = peerValue;
+                Esp8266_StartRxPacket();
+            }
+            else
+            {
+                rxState = ESP8266_MATCH;
+            }
+            break;
+#endif
+        
+        ////////////////////////////////////////////
+        //Process RX packet data state
+        case ESP8266_GET_RX_PACKET:
+            rxPool[rxWriteIndex][rxCount++] = byte;
+            if(rxCount >= packetSize)
+            {
+                //Publish the packet to the main loop and move on to the 
+                //next pool slot. Reset state machine.
+                rxPoolLength[rxWriteIndex] = (unsigned char)rxCount;
+                
+                if(priorityCallback && rxPoolLink[rxWriteIndex] == ESP8266_PRIMARY_LINK)
+                {
+                    priorityCallback(rxPool[rxWriteIndex], (unsigned char)rxCount, 
+                                     rxHeaderTime);
+                }
+                
+                next = rxWriteIndex + 1;
+                rxWriteIndex = (next >= ESP8266_RX_PACKET_COUNT) ? 0 : next;
+                rxPacketCount++;
+                rxState = ESP8266_MATCH;
+#if UART_FLOW_CONTROL
+                Esp8266_UpdateRxHold();
+#endif
+            }
+            break;
+        
+        ////////////////////////////////////////////
+        //Control packet that found the pool full, shown to the priority 
+        //callback and dropped
+        case ESP8266_GET_PRIORITY_PACKET:
+            rxPriority[rxCount++] = byte;
+            if(rxCount >= packetSize)
+            {
+                priorityCallback(rxPriority, (unsigned char)rxCount, rxHeaderTime);
+                rxState = ESP8266_MATCH;
+            }
+            break;
+        
+        ////////////////////////////////////////////
+        //Discard the data of a dropped packet
+        case ESP8266_SKIP_RX_PACKET:
+            if(++rxCount >= packetSize)
+            {
+                rxState = ESP8266_MATCH;
+            }
+            break;
+        
+        ////////////////////////////////////////////
+        //Passthrough data, framed by Esp8266_ProcessRxIdle
+        case ESP8266_GET_RAW_PACKET:
+            if(passthrough != ESP8266_PASSTHROUGH_ON)
+            {
+                rxState = ESP8266_MATCH;
+            }
+            else if(rxCount >= ESP8266_RX_BUFFER_SIZE)
+            {
+                //Datagram does not fit, drop it
+                rxOversizeCount++;
+                rxState = ESP8266_SKIP_RAW_PACKET;
+            }
+            else
+            {
+                //Passthrough data has no header, time the first byte
+                if(rxCount == 0)
+                {
+                    rxPoolTime[rxWriteIndex] = Sched_GetMicros();
+                    rxPoolLink[rxWriteIndex] = ESP8266_PRIMARY_LINK;
+#if ESP8266_PEER_DISCOVERY
+                    rxPoolPort[rxWriteIndex] = 0;
+#endif
+                }
+                
+                rxPool[rxWriteIndex][rxCount++] = byte;
+            }
+            break;
+        
+        ////////////////////////////////////////////
+        //Discard passthrough data until the line goes idle
+        case ESP8266_SKIP_RAW_PACKET:
+            if(passthrough != ESP8266_PASSTHROUGH_ON)
+            {
+                rxState = ESP8266_MATCH;
+            }
+            break;
+        
+        ////////////////////////////////////////////
+        //Compare the access point name in a query reply
+        case ESP8266_CHECK_AP_NAME:
+            if(byte == '"')
+            {
+                apNameMatch = apNameMatch && (apName[apNameIndex] == 0);
+                rxState = ESP8266_MATCH;
+            }
+            else if(byte == '\r' || byte == '\n')
+            {
+                //Unterminated, resync
+                apNameMatch = 0;
+                rxState = ESP8266_MATCH;
+            }
+            else if(apNameMatch && apName[apNameIndex] == byte)
+            {
+                apNameIndex++;
+            }
+            else
+            {
+                apNameMatch = 0;
+            }
+            break;
+        
+        ////////////////////////////////////////////
+        //Take the link id of a +CIPSTATUS reply line, the rest of the line
+        //goes through the matcher
+        case ESP8266_GET_LINK_STATUS:
+            if(byte >= '0' && byte < '0' + ESP8266_MAX_LINKS && 
+               linkRole[byte - '0'] == ESP8266_ROLE_NONE)
+            {
+                Esp8266_OpenLink(byte - '0');
+            }
+            
+            rxState = ESP8266_MATCH;
+            break;
+        
+        ////////////////////////////////////////////
+        //Catch invalid states and reset
+        default:
+            rxState = ESP8266_MATCH;
+            match = 0;
+            break;
+        
+    };
+    
+    //The bytes themselves are recorded by the UART interrupt
+    if(rxState != entryState)
+    {
+        TRACE(TRACE_RX_STATE, rxState);
+    }
+    
+    PROFILE_END(PROFILE_ESP_RX_BYTE);
+}
+
+/*******************************************************************************
+  * @brief Start receiving the data of a packet once the +IPD header has 
+  *        been read, into the pool slot being filled unless it has to be 
+  *        dropped
+  * @par Parameters: None
+  * @retval None
+  *****************************************************************************/
+void Esp8266_StartRxPacket(void)
+{
+    unsigned char next = 0;
+    
+    rxCount = 0;
+    
+    //Next pool slot, the current one is being filled
+    next = rxWriteIndex + 1;
+    if(next >= ESP8266_RX_PACKET_COUNT)
+    {
+        next = 0;
+    }
+    
+    //Drop the packet if it does not fit or the pool is full
+    if(packetSize > ESP8266_RX_BUFFER_SIZE)
+    {
+        rxOversizeCount++;
+        rxState = ESP8266_SKIP_RX_PACKET;
+    }
+    else if(next == rxReadIndex)
+    {
+        rxDropCount++;
+        rxState = ESP8266_SKIP_RX_PACKET;
+        
+        //A stop must not wait for the burst in front of it
+        if(priorityCallback && packetSize <= ESP8266_RX_PRIORITY_SIZE &&
+           rxPoolLink[rxWriteIndex] == ESP8266_PRIMARY_LINK)
+        {
+            rxState = ESP8266_GET_PRIORITY_PACKET;
+        }
+    }
+    else
+    {
+        rxPoolTime[rxWriteIndex] = rxHeaderTime;
+        rxState = ESP8266_GET_RX_PACKET;
+    }
+}
+
+/*******************************************************************************
+  * @brief Called from the receive parser when the line goes idle. In 
+  *        passthrough mode the module forwards each datagram as one burst so
+  *        an idle line marks the end of a datagram.
+  * @par Parameters: None
+  * @retval None
+  *****************************************************************************/
+void Esp8266_ProcessRxIdle(void)
+{
+    unsigned char next = 0;
+    
+    if(passthrough != ESP8266_PASSTHROUGH_ON)
+    {
+        return;
+    }
+    
+    next = rxWriteIndex + 1;
+    if(next >= ESP8266_RX_PACKET_COUNT)
+    {
+        next = 0;
+    }
+    
+    if(rxState == ESP8266_GET_RAW_PACKET && rxCount > 0)
+    {
+        //Publish the datagram to the main loop
+        rxPoolLength[rxWriteIndex] = (unsigned char)rxCount;
+        
+        if(priorityCallback)
+        {
+            priorityCallback(rxPool[rxWriteIndex], (unsigned char)rxCount, 
+                             rxPoolTime[rxWriteIndex]);
+        }
+        
+        rxWriteIndex = next;
+        rxPacketCount++;
+#if UART_FLOW_CONTROL
+        Esp8266_UpdateRxHold();
+#endif
+        
+        if(++next >= ESP8266_RX_PACKET_COUNT)
+        {
+            next = 0;
+        }
+    }
+    
+    //Receive the next datagram into the following slot if there is one
+    rxCount = 0;
+    
+    if(next == rxReadIndex)
+    {
+        rxDropCount++;
+        rxState = ESP8266_SKIP_RAW_PACKET;
+    }
+    else
+    {
+        rxState = ESP8266_GET_RAW_PACKET;
+    }
+}
+
+/*******************************************************************************
+  * @brief Queue an AT command
+  * @par Parameters:
+  * cmd - command text
+  * length - command length in bytes
+  * response - status bit that completes the command
+  * timeout - time to wait for the response in ms
+  * callback - function invoked with the result, may be null
+  * @retval 1 if the command was queued, 0 otherwise
+  *****************************************************************************/
+int Esp8266_QueueCommand(const char *cmd, unsigned char length, 
+                         unsigned char response, unsigned short timeout, 
+                         AtCallback callback)
+{
+    AtCommand *slot = 0;
+    
+    //Make sure the command fits
+    if(length > ESP8266_CMD_BUFFER_SIZE)
+    {
+        return 0;
+    }
+    
+    slot = Esp8266_GetFreeCommand();
+    
+    if(!slot)
+    {
+        return 0;
+    }
+    
+    memcpy(slot->data, cmd, length);
+    slot->cmdLength = length;
+    slot->response = response;
+    slot->timeout = timeout;
+    slot->callback = callback;
+    Esp8266_PushCommand();
+    
+    return 1;
+}
+
+/*******************************************************************************
+  * @brief Queue an AT command ahead of the commands already queued, it is 
+  *        the next one sent. Used by the completion callbacks to insert a 
+  *        step into the start up sequence.
+  * @par Parameters:
+  * cmd - command text including the line ending
+  * length - command length in bytes
+  * response - status bits that complete the command
+  * timeout - time to wait for the response in ms
+  * callback - called with the command result, may be 0
+  * @retval 1 if the command was queued, 0 if the queue is full or the 
+  *         command is too long
+  *****************************************************************************/
+int Esp8266_QueueFirst(const char *cmd, unsigned char length, 
+                       unsigned char response, unsigned short timeout, 
+                       AtCallback callback)
+{
+    AtCommand *slot = 0;
+    
+    //Make sure the command fits
+    if(length > ESP8266_CMD_BUFFER_SIZE)
+    {
+        return 0;
+    }
+    
+    slot = Esp8266_GetFirstCommand();
+    
+    if(!slot)
+    {
+        return 0;
+    }
+    
+    memcpy(slot->data, cmd, length);
+    slot->cmdLength = length;
+    slot->response = response;
+    slot->timeout = timeout;
+    slot->callback = callback;
+    Esp8266_PushFirstCommand();
+    
+    return 1;
+}
+
+/*******************************************************************************
+  * @brief Get the next free slot in the command queue. The slot is not queued
+  *        until Esp8266_PushCommand is called.
+  * @par Parameters: None
+  * @retval pointer to the free command slot or null if the queue is full
+  *****************************************************************************/
+AtCommand *Esp8266_GetFreeCommand(void)
+{
+    unsigned char next = cmdEnqueueIndex + 1;
+    AtCommand *cmd = 0;
+    
+    if(next >= ESP8266_CMD_QUEUE_SIZE)
+    {
+        next = 0;
+    }
+    
+    //Queue is full
+    if(next == cmdDequeueIndex)
+    {
+        return 0;
+    }
+    
+    cmd = &cmdQueue[cmdEnqueueIndex];
+    
+    return cmd;
+}
+
+/*******************************************************************************
+  * @brief Get the number of free slots in the command queue, for callers 
+  *        that need more than one
+  * @par Parameters: None
+  * @retval free slots
+  *****************************************************************************/
+unsigned char Esp8266_GetQueueSpace(void)
+{
+    unsigned char used = (cmdEnqueueIndex + ESP8266_CMD_QUEUE_SIZE - 
+                          cmdDequeueIndex) % ESP8266_CMD_QUEUE_SIZE;
+    
+    //The queue holds one less than its size
+    return (ESP8266_CMD_QUEUE_SIZE - 1) - used;
+}
+
+/*******************************************************************************
+  * @brief Add the slot returned by Esp8266_GetFreeCommand to the queue
+  * @par Parameters: None
+  * @retval None
+  *****************************************************************************/
+void Esp8266_PushCommand(void)
+{
+    if(++cmdEnqueueIndex >= ESP8266_CMD_QUEUE_SIZE)
+    {
+        cmdEnqueueIndex = 0;
+    }
+}
+
+/*******************************************************************************
+  * @brief Get the slot in front of the next command to be sent. Only valid 
+  *        while no command is active, i.e. from a completion callback or 
+  *        before Esp8266_Process runs.
+  * @par Parameters: None
+  * @retval command slot, 0 if the queue is full or a command is active
+  *****************************************************************************/
+AtCommand *Esp8266_GetFirstCommand(void)
+{
+    unsigned char first = cmdDequeueIndex;
+    
+    first = (first == 0) ? (ESP8266_CMD_QUEUE_SIZE - 1) : (first - 1);
+    
+    //Queue is full or the next command has already been sent
+    if(first == cmdEnqueueIndex || cmdState != ESP8266_CMD_IDLE)
+    {
+        return 0;
+    }
+    
+    return &cmdQueue[first];
+}
+
+/*******************************************************************************
+  * @brief Add the slot returned by Esp8266_GetFirstCommand to the front of 
+  *        the queue
+  * @par Parameters: None
+  * @retval None
+  *****************************************************************************/
+void Esp8266_PushFirstCommand(void)
+{
+    cmdDequeueIndex = (cmdDequeueIndex == 0) ? (ESP8266_CMD_QUEUE_SIZE - 1) : 
+                                               (cmdDequeueIndex - 1);
+}
+
+/*******************************************************************************
+  * @brief Finish the active command, report the result and move to the next
+  * @par Parameters:
+  * result - command result
+  * @retval None
+  *****************************************************************************/
+void Esp8266_CompleteCommand(unsigned char result)
+{
+    AtCallback callback = cmdQueue[cmdDequeueIndex].callback;
+    
+    //Remove the command from the queue before the callback so the 
+    //callback is free to queue new commands or flush the queue
+    if(++cmdDequeueIndex >= ESP8266_CMD_QUEUE_SIZE)
+    {
+        cmdDequeueIndex = 0;
+    }
+    
+    cmdState = ESP8266_CMD_IDLE;
+    
+    if(callback)
+    {
+        callback(result);
+    }
+}
+
+/*******************************************************************************
+  * @brief Advance the AT command queue and the datagram send pipeline. Both 
+  *        share the module so only one of them is active at a time, queued
+  *        AT commands go first. Called from the main loop.
+  * @par Parameters: None
+  * @retval 1 if either moved on and may be able to move on again, 0 if both
+  *         are waiting for an interrupt or a deadline
+  *****************************************************************************/
+int Esp8266_Process(void)
+{
+    unsigned char lastCmdState = cmdState;
+    unsigned char lastCmdIndex = cmdDequeueIndex;
+    unsigned char lastSendState = sendState;
+    unsigned char lastSendIndex = txPoolDequeueIndex;
+    unsigned char lastObsIndex = obsDequeueIndex;
+    unsigned char lastBulkCount = Ring_Count(&bulkRing);
+    
+#if ESP8266_AUTO_PROFILE && !ESP8266_TRANSPARENT
+    Esp8266_UpdateProfile();
+#endif
+    
+#if ESP8266_HEALTH_MONITOR && !ESP8266_TRANSPARENT
+    Esp8266_CheckHealth();
+#endif
+    
+    //AT commands are queued until passthrough is left
+    if(sendState == ESP8266_SEND_IDLE && cmdDequeueIndex != cmdEnqueueIndex && 
+       passthrough != ESP8266_PASSTHROUGH_ON)
+    {
+        Esp8266_ProcessCommand();
+    }
+    else if(cmdState == ESP8266_CMD_IDLE)
+    {
+        Esp8266_ProcessSend();
+    }
+    
+    return (cmdState != lastCmdState || cmdDequeueIndex != lastCmdIndex ||
+            sendState != lastSendState || txPoolDequeueIndex != lastSendIndex ||
+            obsDequeueIndex != lastObsIndex || 
+            Ring_Count(&bulkRing) != lastBulkCount);
+}
+
+/*******************************************************************************
+  * @brief Advance the AT command queue
+  * @par Parameters: None
+  * @retval None
+  *****************************************************************************/
+void Esp8266_ProcessCommand(void)
+{
+    AtCommand *cmd = &cmdQueue[cmdDequeueIndex];
+    Esp8266Event event;
+    unsigned char response = 0;
+    
+    switch(cmdState)
+    {
+        ////////////////////////////////////////////
+        //Start the next command
+        case ESP8266_CMD_IDLE:
+            
+            //Drop any stale response before sending the command.
+            //If the TX ring is full try again on the next pass.
+            Esp8266_FlushEvents();
+            
+            if(Uart_SendAsync(cmd->data, cmd->cmdLength))
+            {
+                cmdDeadline = Sched_GetTime() + cmd->timeout;
+                cmdState = ESP8266_CMD_WAIT_RESPONSE;
+            }
+            break;
+        
+        ////////////////////////////////////////////
+        //Wait for the command response, the first of its class or an 
+        //error completes it and other responses are passed over
+        case ESP8266_CMD_WAIT_RESPONSE:
+            while(!response && Esp8266_GetEvent(&event))
+            {
+                response = TOKEN_STATUS[event.token] & 
+                           (cmd->response | ESP8266_ERROR_MESSAGE);
+            }
+            
+            if(response & cmd->response)
+            {
+                Esp8266_CompleteCommand(ESP8266_AT_OK);
+            }
+            else if(response)
+            {
+                Esp8266_CompleteCommand(ESP8266_AT_ERROR);
+            }
+            else if(Sched_IsExpired(cmdDeadline))
+            {
+                Esp8266_CompleteCommand(ESP8266_AT_TIMEOUT);
+                Esp8266_Fault();
+            }
+            break;
+        
+        ////////////////////////////////////////////
+        //Catch invalid states and reset
+        default:
+            cmdState = ESP8266_CMD_IDLE;
+            break;
+    };
+}
+
+/*******************************************************************************
+  * @brief Advance the datagram send pipeline. Each datagram is sent with 
+  *        CIPSEND, the payload goes out on the "> " prompt and the datagram 
+  *        is retired on SEND OK, at which point the next CIPSEND is issued 
+  *        straight away. A busy module is retried after a short backoff.
+  * @par Parameters: None
+  * @retval None
+  *****************************************************************************/
+void Esp8266_ProcessSend(void)
+{
+    CmdBuilder builder;
+    Esp8266Event event;
+    unsigned char response = 0;
+    
+    switch(sendState)
+    {
+        ////////////////////////////////////////////
+        //Start the next datagram
+        case ESP8266_SEND_IDLE:
+            if(passthrough == ESP8266_PASSTHROUGH_ON && 
+               txPoolDequeueIndex == txPoolEnqueueIndex && escapeRequested)
+            {
+                //Queue drained, wait for the UART before the escape guard
+                if(Uart_IsTxEmpty())
+                {
+                    sendDeadline = Sched_GetTime() + ESP8266_ESCAPE_GUARD;
+                    sendState = ESP8266_SEND_ESCAPE_GUARD;
+                }
+                break;
+            }
+            
+            if(passthrough == ESP8266_PASSTHROUGH_ON)
+            {
+                //Raw data, no command or prompt needed
+                if(txPoolDequeueIndex != txPoolEnqueueIndex && 
+                   Uart_SendAsync(txPool[txPoolDequeueIndex], 
+                                  txPoolLength[txPoolDequeueIndex]))
+                {
+                    sendLane = ESP8266_LANE_PRIMARY;
+                    Esp8266_CompleteSend(ESP8266_AT_OK, Sched_GetMicros());
+                }
+                break;
+            }
+            
+            //Observer data left with no link to go to is dropped
+            while(obsDequeueIndex != obsEnqueueIndex && 
+                  obsPoolLinks[obsDequeueIndex] == 0)
+            {
+                Pool_Free(obsPool[obsDequeueIndex]);
+                
+                if(++obsDequeueIndex >= ESP8266_OBSERVER_COUNT)
+                {
+                    obsDequeueIndex = 0;
+                }
+            }
+            
+            if(bulkLink >= ESP8266_MAX_LINKS)
+            {
+                Ring_Clear(&bulkRing);
+            }
+            
+            //The primary link goes first, observers and then the bulk lane
+            //get the gaps
+            if(txPoolDequeueIndex != txPoolEnqueueIndex)
+            {
+                sendLane = ESP8266_LANE_PRIMARY;
+                sendLink = ESP8266_PRIMARY_LINK;
+                sendData = txPool[txPoolDequeueIndex];
+                sendLength = txPoolLength[txPoolDequeueIndex];
+            }
+            else if(obsDequeueIndex != obsEnqueueIndex)
+            {
+                //Lowest observer link the datagram has still to go to
+                sendLane = ESP8266_LANE_OBSERVER;
+                sendLink = 0;
+                
+                while(!(obsPoolLinks[obsDequeueIndex] & (1 << sendLink)))
+                {
+                    sendLink++;
+                }
+                
+                sendData = obsPool[obsDequeueIndex];
+                sendLength = obsPoolLength[obsDequeueIndex];
+            }
+            else if(Ring_Count(&bulkRing))
+            {
+                sendLane = ESP8266_LANE_BULK;
+                sendLink = bulkLink;
+                sendLength = Ring_PeekBlock(&bulkRing, &sendData);
+                
+                if(sendLength > ESP8266_BULK_CHUNK)
+                {
+                    sendLength = ESP8266_BULK_CHUNK;
+                }
+            }
+            else
+            {
+                break;
+            }
+            
+            //Drop any stale responses before sending the command.
+            //If the TX ring is full try again on the next pass.
+            Esp8266_FlushEvents();
+            
+            //Built straight into the TX ring
+            Uart_BeginCommand(&builder);
+            Cmd_AppendText(&builder, "AT+CIPSEND=");
+#if !ESP8266_TRANSPARENT
+            Cmd_AppendChar(&builder, '0' + sendLink);
+            Cmd_AppendChar(&builder, ',');
+#endif
+            Cmd_AppendUnsigned(&builder, sendLength);
+            Cmd_AppendText(&builder, "\r\n");
+            
+            if(Uart_EndCommand(&builder))
+            {
+                sendDeadline = Sched_GetTime() + TIMEOUT_SHORT;
+                sendState = ESP8266_SEND_WAIT_PROMPT;
+            }
+            break;
+        
+        ////////////////////////////////////////////
+        //Wait for the prompt, then send the payload
+        case ESP8266_SEND_WAIT_PROMPT:
+            while(!response && Esp8266_GetEvent(&event))
+            {
+                response = TOKEN_STATUS[event.token] & 
+                           (ESP8266_TX_READY_MESSAGE | ESP8266_BUSY_MESSAGE | 
+                            ESP8266_ERROR_MESSAGE);
+            }
+            
+            if(response & ESP8266_TX_READY_MESSAGE)
+            {
+                //The module takes exactly the announced number of bytes,
+                //anything more would be parsed as a new command
+                Uart_Send(sendData, sendLength);
+                sendDeadline = Sched_GetTime() + TIMEOUT_SHORT;
+                sendState = ESP8266_SEND_WAIT_SENT;
+            }
+            else if(response & ESP8266_BUSY_MESSAGE)
+            {
+                //Still working on the previous request, CIPSEND was ignored
+                txBusyCount++;
+                sendDeadline = Sched_GetTime() + ESP8266_BUSY_BACKOFF;
+                sendState = ESP8266_SEND_BACKOFF;
+            }
+            else if(response)
+            {
+                Esp8266_CompleteSend(ESP8266_AT_ERROR, event.time);
+            }
+            else if(Sched_IsExpired(sendDeadline))
+            {
+                Esp8266_CompleteSend(ESP8266_AT_TIMEOUT, Sched_GetMicros());
+                Esp8266_Fault();
+            }
+            break;
+        
+        ////////////////////////////////////////////
+        //Wait for the payload to be sent
+        case ESP8266_SEND_WAIT_SENT:
+            while(!response && Esp8266_GetEvent(&event))
+            {
+                response = TOKEN_STATUS[event.token] & 
+                           (ESP8266_SEND_OK_MESSAGE | ESP8266_SEND_FAIL_MESSAGE |
+                            ESP8266_ERROR_MESSAGE);
+            }
+            
+            if(response & ESP8266_SEND_OK_MESSAGE)
+            {
+                Esp8266_CompleteSend(ESP8266_AT_OK, event.time);
+                
+                //Keep the pipeline full unless an AT command is waiting
+                if(cmdDequeueIndex == cmdEnqueueIndex)
+                {
+                    Esp8266_ProcessSend();
+                }
+            }
+            else if(response)
+            {
+                Esp8266_CompleteSend(ESP8266_AT_ERROR, event.time);
+            }
+            else if(Sched_IsExpired(sendDeadline))
+            {
+                Esp8266_CompleteSend(ESP8266_AT_TIMEOUT, Sched_GetMicros());
+                Esp8266_Fault();
+            }
+            break;
+        
+        ////////////////////////////////////////////
+        //Wait before retrying a CIPSEND the module was too busy for
+        case ESP8266_SEND_BACKOFF:
+            if(Sched_IsExpired(sendDeadline))
+            {
+                sendState = ESP8266_SEND_IDLE;
+            }
+            break;
+        
+        ////////////////////////////////////////////
+        //Quiet line before the escape, then send it on its own
+        case ESP8266_SEND_ESCAPE_GUARD:
+            if(Sched_IsExpired(sendDeadline) && 
+               Uart_SendAsync((unsigned char *)"+++", 3))
+            {
+                passthrough = ESP8266_PASSTHROUGH_ESCAPING;
+                sendDeadline = Sched_GetTime() + ESP8266_ESCAPE_WAIT;
+                sendState = ESP8266_SEND_ESCAPE_WAIT;
+            }
+            break;
+        
+        ////////////////////////////////////////////
+        //Wait for the module to return to command mode
+        case ESP8266_SEND_ESCAPE_WAIT:
+            if(Sched_IsExpired(sendDeadline))
+            {
+                const char mode[] = "AT+CIPMODE=0\r\n";
+                
+                escapeRequested = 0;
+                passthrough = ESP8266_PASSTHROUGH_OFF;
+                sendState = ESP8266_SEND_IDLE;
+                
+                //Back to normal sends on the same connection
+                Esp8266_QueueCommand(mode, sizeof(mode)-1, ESP8266_OK_MESSAGE, 
+                                     TIMEOUT_SHORT, Esp8266_ConfigCallback);
+            }
+            break;
+        
+        ////////////////////////////////////////////
+        //Catch invalid states and reset
+        default:
+            sendState = ESP8266_SEND_IDLE;
+            break;
+    };
+}
+
+/*******************************************************************************
+  * @brief Retire the datagram being sent, the callback only hears about 
+  *        the primary link
+  * @par Parameters:
+  * result - send result
+  * time - Sched_GetMicros when the module answered or the wait ended
+  * @retval None
+  *****************************************************************************/
+void Esp8266_CompleteSend(unsigned char result, unsigned short time)
+{
+    if(result != ESP8266_AT_OK)
+    {
+        txFailCount++;
+    }
+    
+    //A bulk chunk leaves the stream whatever the result, the frames in it
+    //carry their own CRC
+    if(sendLane == ESP8266_LANE_BULK)
+    {
+        Ring_Discard(&bulkRing, sendLength);
+        sendState = ESP8266_SEND_IDLE;
+        return;
+    }
+    
+    //An observer datagram is retired once every observer has had it
+    if(sendLane == ESP8266_LANE_OBSERVER)
+    {
+        obsPoolLinks[obsDequeueIndex] &= (unsigned char)~(1 << sendLink);
+        
+        if(obsPoolLinks[obsDequeueIndex] == 0)
+        {
+            Pool_Free(obsPool[obsDequeueIndex]);
+            
+            if(++obsDequeueIndex >= ESP8266_OBSERVER_COUNT)
+            {
+                obsDequeueIndex = 0;
+            }
+        }
+        
+        sendState = ESP8266_SEND_IDLE;
+        return;
+    }
+    
+    if(sendCallback)
+    {
+        sendCallback(result, time - txPoolTime[txPoolDequeueIndex]);
+    }
+    
+    Pool_Free(txPool[txPoolDequeueIndex]);
+    
+    if(++txPoolDequeueIndex >= ESP8266_TX_PACKET_COUNT)
+    {
+        txPoolDequeueIndex = 0;
+    }
+    
+    sendState = ESP8266_SEND_IDLE;
+}
+
+/*******************************************************************************
+  * @brief Set a callback to be invoked as each queued datagram is retired
+  * @par Parameters:
+  * callback - function invoked with the send result and the time the 
+  *            datagram spent in the queue and the module, may be null
+  * @retval None
+  *****************************************************************************/
+void Esp8266_SetSendCallback(SendCallback callback)
+{
+    sendCallback = callback;
+}
+
+/*******************************************************************************
+  * @brief Set a callback to be invoked once the baud rate has been settled 
+  *        at start up
+  * @par Parameters:
+  * callback - function invoked with the baud rate, may be null
+  * @retval None
+  *****************************************************************************/
+void Esp8266_SetBaudCallback(BaudCallback callback)
+{
+    baudCallback = callback;
+}
+
+/*******************************************************************************
+  * @brief Set a callback to be invoked as each packet from the controller
+  *        completes, before it waits its turn in the receive pool. The
+  *        callback runs inside the receive parser, it may look at the packet
+  *        but must not call back into the module driver.
+  * @par Parameters:
+  * callback - function invoked with the packet, its length and the time its
+  *            header arrived in us, may be null
+  * @retval None
+  *****************************************************************************/
+void Esp8266_SetPriorityCallback(PacketCallback callback)
+{
+    priorityCallback = callback;
+}
+
+/*******************************************************************************
+  * @brief Get the baud rate the UART is running at
+  * @par Parameters: None
+  * @retval baud rate
+  *****************************************************************************/
+unsigned long Esp8266_GetBaud(void)
+{
+    return uartBaud;
+}
+
+/*******************************************************************************
+  * @brief Queue a response event. Called by the receive parser, which runs 
+  *        in main context like the consumers. A full queue drops the event,
+  *        the waiting step then times out.
+  * @par Parameters:
+  * token - ESP8266_TOKEN_ value with a response class
+  * @retval None
+  *****************************************************************************/
+void Esp8266_PutEvent(unsigned char token)
+{
+    unsigned char next = eventWriteIndex + 1;
+    Esp8266Event *event = &eventQueue[eventWriteIndex];
+    
+    if(token == ESP8266_TOKEN_READY)
+    {
+        readySeen = 1;
+    }
+    
+    if(next >= ESP8266_EVENT_COUNT)
+    {
+        next = 0;
+    }
+    
+    if(next == eventReadIndex)
+    {
+        return;
+    }
+    
+    event->token = token;
+    event->link = lineLink;
+    event->time = Sched_GetMicros();
+    eventWriteIndex = next;
+}
+
+/*******************************************************************************
+  * @brief Take the oldest response event
+  * @par Parameters:
+  * event - set to the event
+  * @retval 1 if an event was taken, 0 if there are none
+  *****************************************************************************/
+int Esp8266_GetEvent(Esp8266Event *event)
+{
+    if(eventReadIndex == eventWriteIndex)
+    {
+        return 0;
+    }
+    
+    *event = eventQueue[eventReadIndex];
+    
+    if(++eventReadIndex >= ESP8266_EVENT_COUNT)
+    {
+        eventReadIndex = 0;
+    }
+    
+    return 1;
+}
+
+/*******************************************************************************
+  * @brief Drop the response events nothing has taken
+  * @par Parameters: None
+  * @retval None
+  *****************************************************************************/
+void Esp8266_FlushEvents(void)
+{
+    eventReadIndex = eventWriteIndex;
+}
+
+/*******************************************************************************
+  * @brief Check if AT commands or datagrams are queued or in progress
+  * @par Parameters: None
+  * @retval 1 if busy, 0 if all the queues are empty
+  *****************************************************************************/
+int Esp8266_IsBusy(void)
+{
+    return (cmdDequeueIndex != cmdEnqueueIndex) || 
+           (txPoolDequeueIndex != txPoolEnqueueIndex) ||
+           (obsDequeueIndex != obsEnqueueIndex) ||
+           (Ring_Count(&bulkRing) != 0);
+}
+
+/*******************************************************************************
+  * @brief Get the link status
+  * @par Parameters: None
+  * @retval ESP8266_LINK_DOWN, ESP8266_LINK_READY or ESP8266_LINK_ERROR
+  *****************************************************************************/
+unsigned char Esp8266_GetLinkStatus(void)
+{
+    return linkStatus;
+}
+
+/*******************************************************************************
+  * @brief Get the time the link first became ready, for measuring start up
+  * @par Parameters: None
+  * @retval scheduler time in ms, 0 if the link has not been ready yet
+  *****************************************************************************/
+unsigned long Esp8266_GetLinkUpTime(void)
+{
+    return linkUpTime;
+}
+
+/*******************************************************************************
+  * @brief Probe completion callback. The probe is repeated until the module
+  *        answers. A module that answers without having reported ready since
+  *        the robot started was already running and may hold connections 
+  *        from before, so it is reset, unless a warm start finds it still 
+  *        set up, see Esp8266_SetWarmStart.
+  * @par Parameters:
+  * result - command result
+  * @retval None
+  *****************************************************************************/
+void Esp8266_ProbeCallback(unsigned char result)
+{
+    const char probe[] = "AT\r\n";
+    const char reset[] = "AT+RST\r\n";
+    const char status[] = "AT+CIPSTATUS\r\n";
+    
+    //A line caught half way through the boot may be answered with ERROR
+    if(result != ESP8266_AT_OK && ++probeCount < ESP8266_PROBE_COUNT)
+    {
+#if ESP8266_BAUD_NEGOTIATE
+        //Only the first probe is at the saved rate
+        if(uartBaud != ESP8266_BAUD)
+        {
+            Esp8266_SetBaud(ESP8266_BAUD);
+        }
+#endif
+        
+        Esp8266_QueueFirst(probe, sizeof(probe)-1, ESP8266_OK_MESSAGE, 
+                           ESP8266_PROBE_INTERVAL, Esp8266_ProbeCallback);
+    }
+    else if(result != ESP8266_AT_OK)
+    {
+        Esp8266_ConfigCallback(result);
+    }
+    else if(readySeen)
+    {
+        readySeen = 0;
+        Esp8266_QueueBaud();
+    }
+    else if(warmStart)
+    {
+        //Only the robot was reset, the module may still be set up
+        warmStart = 0;
+        Esp8266_QueueFirst(status, sizeof(status)-1, ESP8266_OK_MESSAGE, 
+                           TIMEOUT_SHORT, Esp8266_ResumeCallback);
+    }
+#if ESP8266_BAUD_NEGOTIATE
+    else if(uartBaud != ESP8266_BAUD)
+    {
+        //The ready message after the reset is at the default rate, switch
+        //on the OK that goes out before it
+        Esp8266_QueueFirst(reset, sizeof(reset)-1, ESP8266_OK_MESSAGE, 
+                           TIMEOUT_SHORT, Esp8266_BaudResetCallback);
+    }
+#endif
+    else
+    {
+        //Completes on ready message
+        Esp8266_QueueFirst(reset, sizeof(reset)-1, ESP8266_READY_MESSAGE, 
+                           TIMEOUT_LONG, Esp8266_ResetCallback);
+    }
+}
+
+/*******************************************************************************
+  * @brief Completion callback for the reset of a module that was already 
+  *        running, the baud rate is raised once it is back
+  * @par Parameters:
+  * result - command result
+  * @retval None
+  *****************************************************************************/
+void Esp8266_ResetCallback(unsigned char result)
+{
+    if(result == ESP8266_AT_OK)
+    {
+        Esp8266_QueueBaud();
+    }
+    else
+    {
+        Esp8266_ConfigCallback(result);
+    }
+}
+
+/*******************************************************************************
+  * @brief AT+CIPSTATUS completion callback on a warm start. The links in 
+  *        the reply have been opened as it arrived. With the client link 
+  *        among them the module is set up as the robot left it, so the rest
+  *        of the start up is dropped and the link is ready at the rate it 
+  *        answered at. Only the access point name is checked again, the 
+  *        saved one may have changed before the reset. Otherwise the module
+  *        is reset as one found running.
+  * @par Parameters:
+  * result - command result
+  * @retval None
+  *****************************************************************************/
+void Esp8266_ResumeCallback(unsigned char result)
+{
+    unsigned char i = 0;
+    
+    if(result == ESP8266_AT_OK && 
+       linkRole[ESP8266_PRIMARY_LINK] != ESP8266_ROLE_NONE)
+    {
+        //Echo, client and server are all still in place
+        cmdDequeueIndex = cmdEnqueueIndex;
+        
+        if(apName)
+        {
+            Esp8266_SetAccessPointName(apName);
+        }
+        
+        linkStatus = ESP8266_LINK_READY;
+        linkUpTime = Sched_GetTime();
+#if ESP8266_PEER_DISCOVERY && !ESP8266_TRANSPARENT
+        dinfoQueued = 1;
+#endif
+        
+        if(baudCallback)
+        {
+            baudCallback(uartBaud);
+        }
+        
+        return;
+    }
+    
+    //The reset closes whatever the reply opened
+    for(i = 0; i < ESP8266_MAX_LINKS; i++)
+    {
+        linkRole[i] = ESP8266_ROLE_NONE;
+    }
+    
+    Esp8266_ProbeCallback(ESP8266_AT_OK);
+}
+
+/*******************************************************************************
+  * @brief Completion callback for the reset of a module that was left 
+  *        running at the saved rate. The module comes back at the default 
+  *        rate and is probed until it has booted.
+  * @par Parameters:
+  * result - command result
+  * @retval None
+  *****************************************************************************/
+void Esp8266_BaudResetCallback(unsigned char result)
+{
+    const char probe[] = "AT\r\n";
+    
+    if(result == ESP8266_AT_OK)
+    {
+        Esp8266_SetBaud(ESP8266_BAUD);
+        probeCount = 0;
+        Esp8266_QueueFirst(probe, sizeof(probe)-1, ESP8266_OK_MESSAGE, 
+                           ESP8266_PROBE_INTERVAL, Esp8266_ProbeCallback);
+    }
+    else
+    {
+        Esp8266_ConfigCallback(result);
+    }
+}
+
+/*******************************************************************************
+  * @brief Set the UART baud rate. Only called while the line is idle.
+  * @par Parameters:
+  * baud - baud rate
+  * @retval None
+  *****************************************************************************/
+void Esp8266_SetBaud(unsigned long baud)
+{
+    uartBaud = baud;
+    
+    //Initializing the UART turns its interrupts off
+    Uart_Initialize(baud);
+    Uart_EnableRxInterrupt();
+    
+#if ESP8266_TRANSPARENT
+    Uart_EnableIdleInterrupt();
+#endif
+}
+
+/*******************************************************************************
+  * @brief Ask the module for the next baud rate to try, ahead of the 
+  *        commands already queued. Reports the rate the link settled at 
+  *        once there are none left.
+  * @par Parameters: None
+  * @retval None
+  *****************************************************************************/
+void Esp8266_QueueBaud(void)
+{
+#if ESP8266_BAUD_NEGOTIATE
+    if(baudIndex < BAUD_RATE_COUNT)
+    {
+        Esp8266_QueueUartCur(BAUD_RATES[baudIndex], TIMEOUT_SHORT, 
+                             Esp8266_BaudCallback);
+        return;
+    }
+#endif
+    
+    if(baudCallback)
+    {
+        baudCallback(uartBaud);
+    }
+}
+
+/*******************************************************************************
+  * @brief Queue AT+UART_CUR ahead of the commands already queued
+  * @par Parameters:
+  * baud - baud rate for the module
+  * timeout - time to wait for the response in ms
+  * callback - called with the command result
+  * @retval None
+  *****************************************************************************/
+void Esp8266_QueueUartCur(unsigned long baud, unsigned short timeout, 
+                          AtCallback callback)
+{
+    AtCommand *cmd = Esp8266_GetFirstCommand();
+    CmdBuilder builder;
+    
+    if(cmd)
+    {
+        //8 data bits, 1 stop bit and no parity
+        Cmd_Begin(&builder, cmd->data, ESP8266_CMD_BUFFER_SIZE);
+        Cmd_AppendText(&builder, "AT+UART_CUR=");
+        Cmd_AppendUnsigned(&builder, baud);
+        Cmd_AppendText(&builder, ",8,1,0,");
+        Cmd_AppendUnsigned(&builder, UART_CUR_FLOW);
+        Cmd_AppendText(&builder, "\r\n");
+        cmd->cmdLength = Cmd_End(&builder);
+        cmd->response = ESP8266_OK_MESSAGE;
+        cmd->timeout = timeout;
+        cmd->callback = callback;
+        Esp8266_PushFirstCommand();
+    }
+}
+
+/*******************************************************************************
+  * @brief AT+UART_CUR completion callback. The module answers at the old 
+  *        rate and switches after, so the UART follows and the new rate is 
+  *        checked with AT. A module without the command stays at the 
+  *        default rate.
+  * @par Parameters:
+  * result - command result
+  * @retval None
+  *****************************************************************************/
+void Esp8266_BaudCallback(unsigned char result)
+{
+    const char probe[] = "AT\r\n";
+    
+    if(result == ESP8266_AT_OK)
+    {
+        Esp8266_SetBaud(BAUD_RATES[baudIndex]);
+        probeCount = 0;
+        Esp8266_QueueFirst(probe, sizeof(probe)-1, ESP8266_OK_MESSAGE, 
+                           ESP8266_PROBE_INTERVAL, Esp8266_VerifyCallback);
+    }
+    else
+    {
+        baudIndex = BAUD_RATE_COUNT;
+        Esp8266_QueueBaud();
+    }
+}
+
+/*******************************************************************************
+  * @brief Completion callback for the AT that checks a new baud rate. The 
+  *        rate is used if the module answers, otherwise the default rate is
+  *        asked for at the new rate in case it gets through and the next 
+  *        rate is tried.
+  * @par Parameters:
+  * result - command result
+  * @retval None
+  *****************************************************************************/
+void Esp8266_VerifyCallback(unsigned char result)
+{
+    const char probe[] = "AT\r\n";
+    
+    if(result == ESP8266_AT_OK)
+    {
+        baudIndex = BAUD_RATE_COUNT;
+        Esp8266_QueueBaud();
+    }
+    else if(++probeCount < ESP8266_VERIFY_COUNT)
+    {
+        Esp8266_QueueFirst(probe, sizeof(probe)-1, ESP8266_OK_MESSAGE, 
+                           ESP8266_PROBE_INTERVAL, Esp8266_VerifyCallback);
+    }
+    else
+    {
+        Esp8266_QueueUartCur(ESP8266_BAUD, ESP8266_PROBE_INTERVAL, 
+                             Esp8266_FallbackCallback);
+    }
+}
+
+/*******************************************************************************
+  * @brief Completion callback for the fall back to the default rate, the 
+  *        reply is not expected to get through. The next rate is asked for 
+  *        at the default rate, which also checks the fall back worked.
+  * @par Parameters:
+  * result - command result, ignored
+  * @retval None
+  *****************************************************************************/
+void Esp8266_FallbackCallback(unsigned char result)
+{
+    Esp8266_SetBaud(ESP8266_BAUD);
+    baudIndex++;
+    Esp8266_QueueBaud();
+}
+
+/*******************************************************************************
+  * @brief Access point query completion callback, sets the name unless the 
+  *        module already has it. Modules that do not support the query are
+  *        always set.
+  * @par Parameters:
+  * result - command result
+  * @retval None
+  *****************************************************************************/
+void Esp8266_ApQueryCallback(unsigned char result)
+{
+    if(result == ESP8266_AT_TIMEOUT)
+    {
+        Esp8266_ConfigCallback(result);
+    }
+    else if(result != ESP8266_AT_OK || !apNameMatch)
+    {
+        Esp8266_QueueSetAccessPoint();
+    }
+}
+
+/*******************************************************************************
+  * @brief Completion callback for configuration commands. A failed step 
+  *        flushes the rest of the configuration since it depends on it.
+  * @par Parameters:
+  * result - command result
+  * @retval None
+  *****************************************************************************/
+void Esp8266_ConfigCallback(unsigned char result)
+{
+    if(result != ESP8266_AT_OK)
+    {
+        linkStatus = ESP8266_LINK_ERROR;
+        cmdDequeueIndex = cmdEnqueueIndex;
+    }
+}
+
+/*******************************************************************************
+  * @brief Completion callback for the client connection command
+  * @par Parameters:
+  * result - command result
+  * @retval None
+  *****************************************************************************/
+void Esp8266_ClientCallback(unsigned char result)
+{
+#if ESP8266_PEER_DISCOVERY && !ESP8266_TRANSPARENT
+    const char dinfo[] = "AT+CIPDINFO=1\r\n";
+#endif
+    
+    if(result == ESP8266_AT_OK)
+    {
+        linkStatus = ESP8266_LINK_READY;
+        
+        if(linkUpTime == 0)
+        {
+            linkUpTime = Sched_GetTime();
+        }
+        
+#if ESP8266_PEER_DISCOVERY && !ESP8266_TRANSPARENT
+        //Show the sender in each +IPD header from here on, once after 
+        //each reset. A module without the command answers ERROR and the 
+        //link stays with the configured peer.
+        if(!dinfoQueued)
+        {
+            dinfoQueued = 1;
+            Esp8266_QueueFirst(dinfo, sizeof(dinfo)-1, ESP8266_OK_MESSAGE, 
+                               TIMEOUT_SHORT, 0);
+        }
+#endif
+    }
+    else
+    {
+        linkStatus = ESP8266_LINK_ERROR;
+    }
+}
+
+/*******************************************************************************
+  * @brief Completion callback for the CIPMODE=1 command. Arms the receive 
+  *        parser to enter passthrough on the next "> " prompt.
+  * @par Parameters:
+  * result - command result
+  * @retval None
+  *****************************************************************************/
+void Esp8266_PassthroughCallback(unsigned char result)
+{
+    if(result == ESP8266_AT_OK)
+    {
+        passthrough = ESP8266_PASSTHROUGH_ENTERING;
+    }
+    else
+    {
+        Esp8266_ConfigCallback(result);
+    }
+}
+
+/*******************************************************************************
+  * @brief Start recovering from a fault. Only once the link has been up and
+  *        with no recovery in progress, start up has its own handling.
+  *        Only called with no command active.
+  * @par Parameters: None
+  * @retval None
+  *****************************************************************************/
+void Esp8266_Fault(void)
+{
+#if ESP8266_HEALTH_MONITOR && !ESP8266_TRANSPARENT
+    unsigned char step = ESP8266_HEALTH_RESYNC;
+    
+    if(healthStep != ESP8266_HEALTH_OK || linkUpTime == 0)
+    {
+        return;
+    }
+    
+    //The last recovery did not hold, go a step further
+    if(lastStep != ESP8266_HEALTH_OK && 
+       !Sched_IsExpired(lastRecovery + ESP8266_SETTLE_TIME))
+    {
+        step = (lastStep < ESP8266_HEALTH_RESET) ? lastStep + 1 : 
+                                                   ESP8266_HEALTH_RESET;
+    }
+    
+    recoveryCount++;
+    Esp8266_StartRecovery(step);
+#endif
+}
+
+#if ESP8266_HEALTH_MONITOR && !ESP8266_TRANSPARENT
+/*******************************************************************************
+  * @brief Run the health monitor. Starts again a link that failed once it 
+  *        had been up and finishes or retries a reset.
+  * @par Parameters: None
+  * @retval None
+  *****************************************************************************/
+void Esp8266_CheckHealth(void)
+{
+    if(healthStep == ESP8266_HEALTH_RESET)
+    {
+        if(linkStatus == ESP8266_LINK_READY)
+        {
+            Esp8266_Recovered();
+        }
+        else if(linkStatus == ESP8266_LINK_ERROR && 
+                Sched_IsExpired(resetTime + ESP8266_RESET_RETRY))
+        {
+            Esp8266_Restart();
+        }
+        return;
+    }
+    
+    if(healthStep != ESP8266_HEALTH_OK)
+    {
+        return;
+    }
+    
+    if(linkStatus == ESP8266_LINK_ERROR)
+    {
+        Esp8266_Fault();
+    }
+}
+
+/*******************************************************************************
+  * @brief Queue a recovery step ahead of the commands already queued. A step
+  *        that does not fit in the queue goes on to the next, as does a 
+  *        relink with no client started.
+  * @par Parameters:
+  * step - HealthStep value
+  * @retval None
+  *****************************************************************************/
+void Esp8266_StartRecovery(unsigned char step)
+{
+    const char probe[] = "AT\r\n";
+    AtCommand *cmd = 0;
+    CmdBuilder builder;
+    
+    LOG1(LOG_ESP_RECOVERY, step);
+    healthTries = 0;
+    
+    //A header the module will never finish would swallow the answers
+    rxState = ESP8266_MATCH;
+    
+    if(step == ESP8266_HEALTH_RESYNC && 
+       Esp8266_QueueFirst(probe, sizeof(probe)-1, ESP8266_OK_MESSAGE, 
+                          ESP8266_PROBE_INTERVAL, Esp8266_HealthCallback))
+    {
+        healthStep = step;
+        return;
+    }
+    
+    if(step <= ESP8266_HEALTH_RELINK && clientIp && 
+       Esp8266_GetQueueSpace() >= 2)
+    {
+        //Pushed in front the other way round, CIPCLOSE goes first and 
+        //fails harmlessly if the module has already closed the link
+        cmd = Esp8266_GetFirstCommand();
+        Esp8266_BuildClientStart(cmd);
+        cmd->callback = Esp8266_HealthCallback;
+        Esp8266_PushFirstCommand();
+        
+        cmd = Esp8266_GetFirstCommand();
+        Cmd_Begin(&builder, cmd->data, ESP8266_CMD_BUFFER_SIZE);
+        Cmd_AppendText(&builder, "AT+CIPCLOSE=");
+        Cmd_AppendUnsigned(&builder, ESP8266_PRIMARY_LINK);
+        Cmd_AppendText(&builder, "\r\n");
+        cmd->cmdLength = Cmd_End(&builder);
+        cmd->response = ESP8266_OK_MESSAGE;
+        cmd->timeout = TIMEOUT_SHORT;
+        cmd->callback = 0;
+        Esp8266_PushFirstCommand();
+        
+        healthStep = ESP8266_HEALTH_RELINK;
+        return;
+    }
+    
+    healthStep = ESP8266_HEALTH_RESET;
+    Esp8266_Restart();
+}
+
+/*******************************************************************************
+  * @brief Finish the recovery in progress, the module is answering again
+  * @par Parameters: None
+  * @retval None
+  *****************************************************************************/
+void Esp8266_Recovered(void)
+{
+    LOG1(LOG_ESP_RECOVERED, healthStep);
+    lastStep = healthStep;
+    lastRecovery = Sched_GetTime();
+    healthStep = ESP8266_HEALTH_OK;
+}
+
+/*******************************************************************************
+  * @brief Reset the module and set it up again as it was at start up. The 
+  *        queues are emptied, the access point name is kept by the module.
+  * @par Parameters: None
+  * @retval None
+  *****************************************************************************/
+void Esp8266_Restart(void)
+{
+    unsigned long upTime = linkUpTime;
+    
+    resetTime = Sched_GetTime();
+    
+    //A module that still answers has not reported ready since the robot 
+    //started, so the start up probe resets it
+    Esp8266_Initialize(uartBaud);
+    linkUpTime = upTime;
+    linkProfile = ESP8266_PROFILE_NONE;
+    bulkLink = ESP8266_MAX_LINKS;
+    
+    if(clientIp)
+    {
+        Esp8266_StartClient(clientType, clientIp, clientPeerPort);
+    }
+    
+    if(serverPort)
+    {
+        Esp8266_StartTcpServer(serverPort);
+    }
+}
+
+/*******************************************************************************
+  * @brief Completion callback for the recovery commands. A resync that goes
+  *        unanswered resets the module, restarting the link would not get 
+  *        an answer either.
+  * @par Parameters:
+  * result - command result
+  * @retval None
+  *****************************************************************************/
+void Esp8266_HealthCallback(unsigned char result)
+{
+    const char probe[] = "AT\r\n";
+    
+    if(result == ESP8266_AT_OK)
+    {
+        if(healthStep == ESP8266_HEALTH_RELINK)
+        {
+            linkStatus = ESP8266_LINK_READY;
+        }
+        
+        Esp8266_Recovered();
+    }
+    else if(healthStep == ESP8266_HEALTH_RESYNC && 
+            ++healthTries < ESP8266_RESYNC_COUNT)
+    {
+        Esp8266_QueueFirst(probe, sizeof(probe)-1, ESP8266_OK_MESSAGE, 
+                           ESP8266_PROBE_INTERVAL, Esp8266_HealthCallback);
+    }
+    else
+    {
+        Esp8266_StartRecovery(ESP8266_HEALTH_RESET);
+    }
+}
+
+#endif
+
+#endif
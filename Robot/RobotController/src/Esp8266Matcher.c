@@ -0,0 +1,153 @@
+/*******************************************************************************
+  * @file Esp8266Matcher.c
+  * @brief ESP8266 response matcher tables, stored in flash
+  *
+  * Generated by tools/GenerateEsp8266Matcher.py, do not edit
+  *
+  * Tokens:
+  *   OK         "OK\r\n"
+  *   ERROR      "ERROR\r\n"
+  *   FAIL       "FAIL\r\n"
+  *   READY      "ready\r\n"
+  *   SEND_OK    "SEND OK\r\n"
+  *   SEND_FAIL  "SEND FAIL\r\n"
+  *   BUSY       "busy "
+  *   TX_READY   "> "
+  *   RX_HEADER  "+IPD,"
+  *   CONNECT    "CONNECT\r\n"
+  *   CLOSED     "CLOSED\r\n"
+  *   AP_NAME    "+CWSAP:""
+  *   LINK_STATUS "+CIPSTATUS:"
+  *****************************************************************************/
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Includes
+////////////////////////////////////////////////////////////////////////////////
+#include "Esp8266Matcher.h"
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Tables
+////////////////////////////////////////////////////////////////////////////////
+
+//Character class of each byte value, 0 for bytes not used by any token
+const unsigned char ESP8266_MATCH_CLASS[256] =
+{
+     0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  1,  0,  0,  2,  0,  0,
+     0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+     3,  0,  4,  0,  0,  0,  0,  0,  0,  0,  0,  5,  6,  0,  0,  0,
+     0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  7,  0,  0,  0,  8,  0,
+     0,  9,  0, 10, 11, 12, 13,  0,  0, 14,  0, 15, 16,  0, 17, 18,
+    19,  0, 20, 21, 22, 23,  0, 24,  0,  0,  0,  0,  0,  0,  0,  0,
+     0, 25, 26,  0, 27, 28,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+     0,  0, 29, 30,  0, 31,  0,  0,  0, 32,  0,  0,  0,  0,  0,  0,
+     0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+     0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+     0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+     0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+     0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+     0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+     0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+     0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0
+};
+
+//State transition table, classes: other '\n' '\r' ' ' '"' '+' ',' ':' '>' 'A' 'C' 'D' 'E' 'F' 'I' 'K' 'L' 'N' 'O' 'P' 'R' 'S' 'T' 'U' 'W' 'a' 'b' 'd' 'e' 'r' 's' 'u' 'y'
+const unsigned char ESP8266_MATCH_NEXT[ESP8266_MATCH_STATES][ESP8266_MATCH_CLASSES] =
+{
+    {0,0,0,0,0,47,0,0,45,0,52,0,5,12,0,0,0,0,1,0,0,25,0,0,0,0,40,0,0,18,0,0,0},
+    {0,0,0,0,0,47,0,0,45,0,52,0,5,12,0,2,0,0,1,0,0,25,0,0,0,0,40,0,0,18,0,0,0},
+    {0,0,3,0,0,47,0,0,45,0,52,0,5,12,0,0,0,0,1,0,0,25,0,0,0,0,40,0,0,18,0,0,0},
+    {0,4,0,0,0,47,0,0,45,0,52,0,5,12,0,0,0,0,1,0,0,25,0,0,0,0,40,0,0,18,0,0,0},
+    {0,0,0,0,0,47,0,0,45,0,52,0,5,12,0,0,0,0,1,0,0,25,0,0,0,0,40,0,0,18,0,0,0},
+    {0,0,0,0,0,47,0,0,45,0,52,0,5,12,0,0,0,0,1,0,6,25,0,0,0,0,40,0,0,18,0,0,0},
+    {0,0,0,0,0,47,0,0,45,0,52,0,5,12,0,0,0,0,1,0,7,25,0,0,0,0,40,0,0,18,0,0,0},
+    {0,0,0,0,0,47,0,0,45,0,52,0,5,12,0,0,0,0,8,0,0,25,0,0,0,0,40,0,0,18,0,0,0},
+    {0,0,0,0,0,47,0,0,45,0,52,0,5,12,0,2,0,0,1,0,9,25,0,0,0,0,40,0,0,18,0,0,0},
+    {0,0,10,0,0,47,0,0,45,0,52,0,5,12,0,0,0,0,1,0,0,25,0,0,0,0,40,0,0,18,0,0,0},
+    {0,11,0,0,0,47,0,0,45,0,52,0,5,12,0,0,0,0,1,0,0,25,0,0,0,0,40,0,0,18,0,0,0},
+    {0,0,0,0,0,47,0,0,45,0,52,0,5,12,0,0,0,0,1,0,0,25,0,0,0,0,40,0,0,18,0,0,0},
+    {0,0,0,0,0,47,0,0,45,13,52,0,5,12,0,0,0,0,1,0,0,25,0,0,0,0,40,0,0,18,0,0,0},
+    {0,0,0,0,0,47,0,0,45,0,52,0,5,12,14,0,0,0,1,0,0,25,0,0,0,0,40,0,0,18,0,0,0},
+    {0,0,0,0,0,47,0,0,45,0,52,0,5,12,0,0,15,0,1,0,0,25,0,0,0,0,40,0,0,18,0,0,0},
+    {0,0,16,0,0,47,0,0,45,0,52,0,5,12,0,0,0,0,1,0,0,25,0,0,0,0,40,0,0,18,0,0,0},
+    {0,17,0,0,0,47,0,0,45,0,52,0,5,12,0,0,0,0,1,0,0,25,0,0,0,0,40,0,0,18,0,0,0},
+    {0,0,0,0,0,47,0,0,45,0,52,0,5,12,0,0,0,0,1,0,0,25,0,0,0,0,40,0,0,18,0,0,0},
+    {0,0,0,0,0,47,0,0,45,0,52,0,5,12,0,0,0,0,1,0,0,25,0,0,0,0,40,0,19,18,0,0,0},
+    {0,0,0,0,0,47,0,0,45,0,52,0,5,12,0,0,0,0,1,0,0,25,0,0,0,20,40,0,0,18,0,0,0},
+    {0,0,0,0,0,47,0,0,45,0,52,0,5,12,0,0,0,0,1,0,0,25,0,0,0,0,40,21,0,18,0,0,0},
+    {0,0,0,0,0,47,0,0,45,0,52,0,5,12,0,0,0,0,1,0,0,25,0,0,0,0,40,0,0,18,0,0,22},
+    {0,0,23,0,0,47,0,0,45,0,52,0,5,12,0,0,0,0,1,0,0,25,0,0,0,0,40,0,0,18,0,0,0},
+    {0,24,0,0,0,47,0,0,45,0,52,0,5,12,0,0,0,0,1,0,0,25,0,0,0,0,40,0,0,18,0,0,0},
+    {0,0,0,0,0,47,0,0,45,0,52,0,5,12,0,0,0,0,1,0,0,25,0,0,0,0,40,0,0,18,0,0,0},
+    {0,0,0,0,0,47,0,0,45,0,52,0,26,12,0,0,0,0,1,0,0,25,0,0,0,0,40,0,0,18,0,0,0},
+    {0,0,0,0,0,47,0,0,45,0,52,0,5,12,0,0,0,27,1,0,6,25,0,0,0,0,40,0,0,18,0,0,0},
+    {0,0,0,0,0,47,0,0,45,0,52,28,5,12,0,0,0,0,1,0,0,25,0,0,0,0,40,0,0,18,0,0,0},
+    {0,0,0,29,0,47,0,0,45,0,52,0,5,12,0,0,0,0,1,0,0,25,0,0,0,0,40,0,0,18,0,0,0},
+    {0,0,0,0,0,47,0,0,45,0,52,0,5,34,0,0,0,0,30,0,0,25,0,0,0,0,40,0,0,18,0,0,0},
+    {0,0,0,0,0,47,0,0,45,0,52,0,5,12,0,31,0,0,1,0,0,25,0,0,0,0,40,0,0,18,0,0,0},
+    {0,0,32,0,0,47,0,0,45,0,52,0,5,12,0,0,0,0,1,0,0,25,0,0,0,0,40,0,0,18,0,0,0},
+    {0,33,0,0,0,47,0,0,45,0,52,0,5,12,0,0,0,0,1,0,0,25,0,0,0,0,40,0,0,18,0,0,0},
+    {0,0,0,0,0,47,0,0,45,0,52,0,5,12,0,0,0,0,1,0,0,25,0,0,0,0,40,0,0,18,0,0,0},
+    {0,0,0,0,0,47,0,0,45,35,52,0,5,12,0,0,0,0,1,0,0,25,0,0,0,0,40,0,0,18,0,0,0},
+    {0,0,0,0,0,47,0,0,45,0,52,0,5,12,36,0,0,0,1,0,0,25,0,0,0,0,40,0,0,18,0,0,0},
+    {0,0,0,0,0,47,0,0,45,0,52,0,5,12,0,0,37,0,1,0,0,25,0,0,0,0,40,0,0,18,0,0,0},
+    {0,0,38,0,0,47,0,0,45,0,52,0,5,12,0,0,0,0,1,0,0,25,0,0,0,0,40,0,0,18,0,0,0},
+    {0,39,0,0,0,47,0,0,45,0,52,0,5,12,0,0,0,0,1,0,0,25,0,0,0,0,40,0,0,18,0,0,0},
+    {0,0,0,0,0,47,0,0,45,0,52,0,5,12,0,0,0,0,1,0,0,25,0,0,0,0,40,0,0,18,0,0,0},
+    {0,0,0,0,0,47,0,0,45,0,52,0,5,12,0,0,0,0,1,0,0,25,0,0,0,0,40,0,0,18,0,41,0},
+    {0,0,0,0,0,47,0,0,45,0,52,0,5,12,0,0,0,0,1,0,0,25,0,0,0,0,40,0,0,18,42,0,0},
+    {0,0,0,0,0,47,0,0,45,0,52,0,5,12,0,0,0,0,1,0,0,25,0,0,0,0,40,0,0,18,0,0,43},
+    {0,0,0,44,0,47,0,0,45,0,52,0,5,12,0,0,0,0,1,0,0,25,0,0,0,0,40,0,0,18,0,0,0},
+    {0,0,0,0,0,47,0,0,45,0,52,0,5,12,0,0,0,0,1,0,0,25,0,0,0,0,40,0,0,18,0,0,0},
+    {0,0,0,46,0,47,0,0,45,0,52,0,5,12,0,0,0,0,1,0,0,25,0,0,0,0,40,0,0,18,0,0,0},
+    {0,0,0,0,0,47,0,0,45,0,52,0,5,12,0,0,0,0,1,0,0,25,0,0,0,0,40,0,0,18,0,0,0},
+    {0,0,0,0,0,47,0,0,45,0,68,0,5,12,48,0,0,0,1,0,0,25,0,0,0,0,40,0,0,18,0,0,0},
+    {0,0,0,0,0,47,0,0,45,0,52,0,5,12,0,0,0,0,1,49,0,25,0,0,0,0,40,0,0,18,0,0,0},
+    {0,0,0,0,0,47,0,0,45,0,52,50,5,12,0,0,0,0,1,0,0,25,0,0,0,0,40,0,0,18,0,0,0},
+    {0,0,0,0,0,47,51,0,45,0,52,0,5,12,0,0,0,0,1,0,0,25,0,0,0,0,40,0,0,18,0,0,0},
+    {0,0,0,0,0,47,0,0,45,0,52,0,5,12,0,0,0,0,1,0,0,25,0,0,0,0,40,0,0,18,0,0,0},
+    {0,0,0,0,0,47,0,0,45,0,52,0,5,12,0,0,61,0,53,0,0,25,0,0,0,0,40,0,0,18,0,0,0},
+    {0,0,0,0,0,47,0,0,45,0,52,0,5,12,0,2,0,54,1,0,0,25,0,0,0,0,40,0,0,18,0,0,0},
+    {0,0,0,0,0,47,0,0,45,0,52,0,5,12,0,0,0,55,1,0,0,25,0,0,0,0,40,0,0,18,0,0,0},
+    {0,0,0,0,0,47,0,0,45,0,52,0,56,12,0,0,0,0,1,0,0,25,0,0,0,0,40,0,0,18,0,0,0},
+    {0,0,0,0,0,47,0,0,45,0,57,0,5,12,0,0,0,0,1,0,6,25,0,0,0,0,40,0,0,18,0,0,0},
+    {0,0,0,0,0,47,0,0,45,0,52,0,5,12,0,0,61,0,53,0,0,25,58,0,0,0,40,0,0,18,0,0,0},
+    {0,0,59,0,0,47,0,0,45,0,52,0,5,12,0,0,0,0,1,0,0,25,0,0,0,0,40,0,0,18,0,0,0},
+    {0,60,0,0,0,47,0,0,45,0,52,0,5,12,0,0,0,0,1,0,0,25,0,0,0,0,40,0,0,18,0,0,0},
+    {0,0,0,0,0,47,0,0,45,0,52,0,5,12,0,0,0,0,1,0,0,25,0,0,0,0,40,0,0,18,0,0,0},
+    {0,0,0,0,0,47,0,0,45,0,52,0,5,12,0,0,0,0,62,0,0,25,0,0,0,0,40,0,0,18,0,0,0},
+    {0,0,0,0,0,47,0,0,45,0,52,0,5,12,0,2,0,0,1,0,0,63,0,0,0,0,40,0,0,18,0,0,0},
+    {0,0,0,0,0,47,0,0,45,0,52,0,64,12,0,0,0,0,1,0,0,25,0,0,0,0,40,0,0,18,0,0,0},
+    {0,0,0,0,0,47,0,0,45,0,52,65,5,12,0,0,0,27,1,0,6,25,0,0,0,0,40,0,0,18,0,0,0},
+    {0,0,66,0,0,47,0,0,45,0,52,0,5,12,0,0,0,0,1,0,0,25,0,0,0,0,40,0,0,18,0,0,0},
+    {0,67,0,0,0,47,0,0,45,0,52,0,5,12,0,0,0,0,1,0,0,25,0,0,0,0,40,0,0,18,0,0,0},
+    {0,0,0,0,0,47,0,0,45,0,52,0,5,12,0,0,0,0,1,0,0,25,0,0,0,0,40,0,0,18,0,0,0},
+    {0,0,0,0,0,47,0,0,45,0,52,0,5,12,75,0,61,0,53,0,0,25,0,0,69,0,40,0,0,18,0,0,0},
+    {0,0,0,0,0,47,0,0,45,0,52,0,5,12,0,0,0,0,1,0,0,70,0,0,0,0,40,0,0,18,0,0,0},
+    {0,0,0,0,0,47,0,0,45,71,52,0,26,12,0,0,0,0,1,0,0,25,0,0,0,0,40,0,0,18,0,0,0},
+    {0,0,0,0,0,47,0,0,45,0,52,0,5,12,0,0,0,0,1,72,0,25,0,0,0,0,40,0,0,18,0,0,0},
+    {0,0,0,0,0,47,0,73,45,0,52,0,5,12,0,0,0,0,1,0,0,25,0,0,0,0,40,0,0,18,0,0,0},
+    {0,0,0,0,74,47,0,0,45,0,52,0,5,12,0,0,0,0,1,0,0,25,0,0,0,0,40,0,0,18,0,0,0},
+    {0,0,0,0,0,47,0,0,45,0,52,0,5,12,0,0,0,0,1,0,0,25,0,0,0,0,40,0,0,18,0,0,0},
+    {0,0,0,0,0,47,0,0,45,0,52,0,5,12,0,0,0,0,1,76,0,25,0,0,0,0,40,0,0,18,0,0,0},
+    {0,0,0,0,0,47,0,0,45,0,52,0,5,12,0,0,0,0,1,0,0,77,0,0,0,0,40,0,0,18,0,0,0},
+    {0,0,0,0,0,47,0,0,45,0,52,0,26,12,0,0,0,0,1,0,0,25,78,0,0,0,40,0,0,18,0,0,0},
+    {0,0,0,0,0,47,0,0,45,79,52,0,5,12,0,0,0,0,1,0,0,25,0,0,0,0,40,0,0,18,0,0,0},
+    {0,0,0,0,0,47,0,0,45,0,52,0,5,12,0,0,0,0,1,0,0,25,80,0,0,0,40,0,0,18,0,0,0},
+    {0,0,0,0,0,47,0,0,45,0,52,0,5,12,0,0,0,0,1,0,0,25,0,81,0,0,40,0,0,18,0,0,0},
+    {0,0,0,0,0,47,0,0,45,0,52,0,5,12,0,0,0,0,1,0,0,82,0,0,0,0,40,0,0,18,0,0,0},
+    {0,0,0,0,0,47,0,83,45,0,52,0,26,12,0,0,0,0,1,0,0,25,0,0,0,0,40,0,0,18,0,0,0},
+    {0,0,0,0,0,47,0,0,45,0,52,0,5,12,0,0,0,0,1,0,0,25,0,0,0,0,40,0,0,18,0,0,0}
+};
+
+//Token completed on entering each state
+const unsigned char ESP8266_MATCH_TOKEN[ESP8266_MATCH_STATES] =
+{
+     0,  0,  0,  0,  1,  0,  0,  0,  0,  0,  0,  2,  0,  0,  0,  0,
+     0,  3,  0,  0,  0,  0,  0,  0,  4,  0,  0,  0,  0,  0,  0,  0,
+     0,  5,  0,  0,  0,  0,  0,  6,  0,  0,  0,  0,  7,  0,  8,  0,
+     0,  0,  0,  9,  0,  0,  0,  0,  0,  0,  0,  0, 10,  0,  0,  0,
+     0,  0,  0, 11,  0,  0,  0,  0,  0,  0, 12,  0,  0,  0,  0,  0,
+     0,  0,  0, 13
+};
\ No newline at end of file
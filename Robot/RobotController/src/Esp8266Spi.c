@@ -0,0 +1,1445 @@
+/*******************************************************************************
+  * @file Esp8266Spi.c
+  * @brief Implements the functions for interfacing to ESP8266 WIFI chip
+  *        running the SPI link firmware, in place of Esp8266.c, see
+  *        ESP8266_SPI_LINK. The robot is the bus master and moves one
+  *        transaction at a time from the main loop: Esp8266_Process starts
+  *        it and Esp8266_ProcessRx takes the result once the SPI interrupt
+  *        has clocked it through.
+  *
+  *        The status word is read whenever the module raises its ready
+  *        output, then the chunk it has waiting if any. Chunks go to the
+  *        module against the credit its last status word gave, set up
+  *        first, then the primary link, the observers and the bulk lane. A
+  *        new session in the status word is a module that booted, it is set
+  *        up again from what the robot asked for.
+  * @author David Sharpe
+  * @version V1.0.0
+  * @date 14-October-2026
+  *
+  * ST Visual Develop 4.2.1 using STM8 Cosmic C Compiler
+  *****************************************************************************/
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Includes
+////////////////////////////////////////////////////////////////////////////////
+#include "Esp8266.h"
+#include "Log.h"
+#include "Pool.h"
+#include "Power.h"
+#include "Ring.h"
+#include "Scheduler.h"
+#include "Spi.h"
+#include "Uart.h"
+#include "stm8s.h"
+#include "string.h"
+
+#if ESP8266_SPI_LINK
+
+////////////////////////////////////////////////////////////////////////////////
+// Definitions
+////////////////////////////////////////////////////////////////////////////////
+#if ESP8266_TRANSPARENT
+#error "The SPI link has no passthrough mode"
+#endif
+
+#if UART_FLOW_CONTROL
+#error "The SPI chip select is on the RTS pin"
+#endif
+
+#if ESP8266_TX_PACKET_SIZE > POOL_BLOCK_SIZE
+#error "Datagrams do not fit a pool block"
+#endif
+
+//Transaction lengths, the command and address bytes then the chunk, or the
+//command then the status word
+#define SPI_DATA_LENGTH     (2 + ESP8266_SPI_CHUNK_SIZE)
+#define SPI_STATUS_LENGTH   (1 + ESP8266_SPI_STATUS_SIZE)
+
+//Chunk fields, see ESP8266_SPI_CHUNK_SIZE
+#define CHUNK_TYPE          0
+#define CHUNK_LINK          1
+#define CHUNK_LENGTH        2
+#define CHUNK_PAYLOAD       3
+#define CHUNK_CHECK         (ESP8266_SPI_CHUNK_SIZE - 1)
+
+//Chunks a datagram takes
+#define CHUNK_COUNT(length) (((length) + ESP8266_SPI_PAYLOAD_SIZE - 1) / \
+                             ESP8266_SPI_PAYLOAD_SIZE)
+
+//Status word fields and the bits the mark is checked on
+#define STATUS_FLAGS        0
+#define STATUS_CREDIT       1
+#define STATUS_LINKS        2
+#define STATUS_SESSION      3
+#define STATUS_MARK_MASK    0xC0
+
+//Set up the link needs before it is ready
+#define SETUP_LINK          (ESP8266_SPI_SET_AP_NAME | ESP8266_SPI_SET_CLIENT | \
+                             ESP8266_SPI_SET_SERVER)
+
+//The module's ready output, high while it wants its status word read
+#define SPI_READY()         ((BOARD_SPI_READY_PORT->IDR & BOARD_SPI_READY_PIN) != 0)
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Prototypes
+////////////////////////////////////////////////////////////////////////////////
+void Esp8266_StartStatus(void);
+void Esp8266_StartRead(void);
+int  Esp8266_StartWrite(void);
+void Esp8266_StartDatagram(unsigned char link, const unsigned char *data,
+                           unsigned char length);
+void Esp8266_StartChunk(unsigned char type, unsigned char link,
+                        unsigned char length);
+unsigned char Esp8266_BuildSetup(unsigned char op, unsigned char *payload);
+void Esp8266_TakeStatus(void);
+void Esp8266_TakeChunk(void);
+void Esp8266_CompleteWrite(void);
+unsigned char Esp8266_Check(const unsigned char *chunk);
+void Esp8266_UpdateLinks(unsigned char links);
+void Esp8266_UpdateStatus(void);
+void Esp8266_UpdateProfile(void);
+void Esp8266_Fault(void);
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Variables
+////////////////////////////////////////////////////////////////////////////////
+//Transaction buffer. The SPI sends from it and receives into it, so a
+//write's chunk is gone once it has been clocked out. spiXfer is the
+//transaction in flight, see SpiTransaction.
+unsigned char spiFrame[SPI_DATA_LENGTH];
+unsigned char spiXfer = ESP8266_SPI_XFER_IDLE;
+
+//Module state from the last good status word. statusWanted asks for the
+//next one, statusDue is when it is read anyway.
+unsigned char moduleData = 0;
+unsigned char moduleCredit = 0;
+unsigned char moduleSession = 0;
+unsigned char sessionKnown = 0;
+unsigned char statusWanted = 1;
+unsigned long statusDue = 0;
+unsigned char linkStatus = ESP8266_LINK_DOWN;
+unsigned long linkUpTime = 0;
+unsigned char probeCount = 0;
+
+//Set up still to send and all the set up asked for, ESP8266_SPI_SET_ bits,
+//with what it is made of, kept to set the module up again after it boots
+unsigned char setupPending = 0;
+unsigned char setupAsked = 0;
+unsigned char sendSetup = 0;
+const char *apName = 0;
+unsigned char clientType = ESP8266_SPI_UDP;
+const char *clientIp = 0;
+unsigned short clientPeerPort = 0;
+unsigned short serverPort = 0;
+
+//Receive packet pool, as in Esp8266.c. rxCount is the length so far of the
+//datagram being put together from its chunks, rxSkip is set while the rest
+//of a dropped one goes by.
+unsigned char rxPool[ESP8266_RX_PACKET_COUNT][ESP8266_RX_BUFFER_SIZE];
+unsigned char rxPoolLength[ESP8266_RX_PACKET_COUNT];
+unsigned short rxPoolTime[ESP8266_RX_PACKET_COUNT];
+unsigned char rxPoolLink[ESP8266_RX_PACKET_COUNT];
+unsigned char rxPoolForeign[ESP8266_RX_PACKET_COUNT];
+unsigned char rxWriteIndex = 0;
+unsigned char rxReadIndex = 0;
+unsigned char rxCount = 0;
+unsigned char rxSkip = 0;
+unsigned short rxPacketCount = 0;
+unsigned short rxDropCount = 0;
+unsigned short rxOversizeCount = 0;
+PacketCallback priorityCallback = 0;
+
+//Connection table, the role of each link id
+unsigned char linkRole[ESP8266_MAX_LINKS];
+
+//Outgoing datagram queue, each held in a block from the pool until its
+//last chunk has gone. sendOffset is how much has gone of the datagram at
+//the head of sendLane's queue.
+unsigned char *txPool[ESP8266_TX_PACKET_COUNT];
+unsigned char txPoolLength[ESP8266_TX_PACKET_COUNT];
+unsigned short txPoolTime[ESP8266_TX_PACKET_COUNT];
+unsigned char txPoolEnqueueIndex = 0;
+unsigned char txPoolDequeueIndex = 0;
+unsigned char sendOffset = 0;
+unsigned char sendLength = 0;
+unsigned char sendLane = ESP8266_LANE_PRIMARY;
+unsigned char busyCounted = 0;
+unsigned short txFailCount = 0;
+unsigned short txBusyCount = 0;
+SendCallback sendCallback = 0;
+BaudCallback baudCallback = 0;
+
+//Observer datagram queue. The module sends each to every observer, so it
+//goes once.
+unsigned char *obsPool[ESP8266_OBSERVER_COUNT];
+unsigned char obsPoolLength[ESP8266_OBSERVER_COUNT];
+unsigned char obsEnqueueIndex = 0;
+unsigned char obsDequeueIndex = 0;
+
+//Bulk lane stream and the link it is for, ESP8266_MAX_LINKS once that link
+//has closed
+RING_DEFINE(bulkRing, ESP8266_BULK_BUFFER_SIZE);
+unsigned char bulkLink = ESP8266_MAX_LINKS;
+
+//Link profile last asked for, and the last datagram from the controller
+//for the automatic switch
+unsigned char linkProfile = ESP8266_PROFILE_NONE;
+unsigned long activityTime = 0;
+unsigned char activitySeen = 0;
+
+//Health, see ESP8266_HEALTH_MONITOR. faultCount is the bad status words
+//and chunks in a row.
+unsigned char healthStep = ESP8266_HEALTH_OK;
+unsigned char faultCount = 0;
+unsigned short recoveryCount = 0;
+
+
+/*******************************************************************************
+  * @brief Initialize the SPI and the module's ready input. The module is
+  *        set up once its first status word has been read, from the set up
+  *        asked for by then.
+  * @par Parameters:
+  * baud - not used, the module has no UART on this link
+  * @retval None
+  *****************************************************************************/
+void Esp8266_Initialize(unsigned long baud)
+{
+    unsigned char cc = 0;
+    unsigned char i = 0;
+    
+    linkStatus = ESP8266_LINK_DOWN;
+    linkUpTime = 0;
+    probeCount = 0;
+    spiXfer = ESP8266_SPI_XFER_IDLE;
+    moduleData = 0;
+    moduleCredit = 0;
+    sessionKnown = 0;
+    statusWanted = 1;
+    setupPending = 0;
+    setupAsked = 0;
+    healthStep = ESP8266_HEALTH_OK;
+    faultCount = 0;
+    
+    //Empty the queues
+    Pool_Release(POOL_TX_DATAGRAM);
+    Pool_Release(POOL_OBSERVER);
+    txPoolEnqueueIndex = 0;
+    txPoolDequeueIndex = 0;
+    obsEnqueueIndex = 0;
+    obsDequeueIndex = 0;
+    sendOffset = 0;
+    Ring_Clear(&bulkRing);
+    rxCount = 0;
+    rxSkip = 0;
+    
+    //No connections until the module reports them
+    for(i = 0; i < ESP8266_MAX_LINKS; i++)
+    {
+        linkRole[i] = ESP8266_ROLE_NONE;
+    }
+    
+    Spi_Initialize();
+    
+    //The ready output only wakes the main loop, which reads its level. The
+    //sensitivity can only be written with interrupts masked.
+    maskInterrupts(cc);
+    GPIO_Init(BOARD_SPI_READY_PORT, BOARD_SPI_READY_PIN, GPIO_MODE_IN_FL_IT);
+    EXTI_SetExtIntSensitivity(BOARD_SPI_READY_EXTI, EXTI_SENSITIVITY_RISE_ONLY);
+    restoreInterrupts(cc);
+}
+
+/*******************************************************************************
+  * @brief Let the start up keep a module that is found running. Nothing to
+  *        do on this link, the module is never reset by the robot and the 
+  *        set up it already has is sent again in a few chunks.
+  * @par Parameters: None
+  * @retval None
+  *****************************************************************************/
+void Esp8266_SetWarmStart(void)
+{
+}
+
+/*******************************************************************************
+  * @brief Set the access point name. The module only restarts its access
+  *        point for a name that differs from the one it has.
+  * @par Parameters:
+  * name - access point name, must stay valid
+  * @retval None
+  *****************************************************************************/
+void Esp8266_SetAccessPointName(const char *name)
+{
+    apName = name;
+    setupAsked |= ESP8266_SPI_SET_AP_NAME;
+    setupPending |= ESP8266_SPI_SET_AP_NAME;
+}
+
+/*******************************************************************************
+  * @brief Start the client link to the controller on ESP8266_PRIMARY_LINK
+  * @par Parameters:
+  * type - ESP8266_UDP or ESP8266_TCP
+  * ip - peer address, must stay valid
+  * port - peer port
+  * @retval None
+  *****************************************************************************/
+void Esp8266_StartClient(const char *type, const char *ip, const unsigned short port)
+{
+    clientType = (strcmp(type, ESP8266_TCP) == 0) ? ESP8266_SPI_TCP :
+                                                    ESP8266_SPI_UDP;
+    clientIp = ip;
+    clientPeerPort = port;
+    setupAsked |= ESP8266_SPI_SET_CLIENT;
+    setupPending |= ESP8266_SPI_SET_CLIENT;
+}
+
+/*******************************************************************************
+  * @brief Start the TCP server for observers, the module keeps its own
+  *        timeout
+  * @par Parameters:
+  * port - port to listen on
+  * @retval None
+  *****************************************************************************/
+void Esp8266_StartTcpServer(const unsigned short port)
+{
+    serverPort = port;
+    setupAsked |= ESP8266_SPI_SET_SERVER;
+    setupPending |= ESP8266_SPI_SET_SERVER;
+}
+
+/*******************************************************************************
+  * @brief Send a message on the primary link. The message is copied into the
+  *        datagram queue and sent once the module has room for it, this
+  *        does not block.
+  * @par Parameters:
+  * buffer - data to send
+  * length - data length in bytes
+  * @retval 1 if the message was queued, 0 if the link is not ready, the queue
+  *         is full or the message is larger than ESP8266_TX_PACKET_SIZE
+  *****************************************************************************/
+int Esp8266_SendMsg(const unsigned char *buffer, unsigned short length)
+{
+    unsigned char next = txPoolEnqueueIndex + 1;
+    unsigned char *block = 0;
+    
+    if(next >= ESP8266_TX_PACKET_COUNT)
+    {
+        next = 0;
+    }
+    
+    if(linkStatus != ESP8266_LINK_READY || next == txPoolDequeueIndex ||
+       length == 0 || length > ESP8266_TX_PACKET_SIZE ||
+       (block = Pool_Alloc(POOL_TX_DATAGRAM)) == 0)
+    {
+        return 0;
+    }
+    
+    memcpy(block, buffer, length);
+    txPool[txPoolEnqueueIndex] = block;
+    txPoolLength[txPoolEnqueueIndex] = (unsigned char)length;
+    txPoolTime[txPoolEnqueueIndex] = Sched_GetMicros();
+    txPoolEnqueueIndex = next;
+    
+    return 1;
+}
+
+/*******************************************************************************
+  * @brief Send a message to every observer link. The message is copied into
+  *        the observer queue and handed to the module once while nothing is
+  *        waiting for the primary link, this does not block.
+  * @par Parameters:
+  * buffer - data to send
+  * length - data length in bytes
+  * @retval 1 if the message was queued, 0 if no observer is connected, the
+  *         queue is full or the message is larger than ESP8266_TX_PACKET_SIZE
+  *****************************************************************************/
+int Esp8266_SendObservers(const unsigned char *buffer, unsigned short length)
+{
+    unsigned char next = obsEnqueueIndex + 1;
+    unsigned char found = 0;
+    unsigned char i = 0;
+    unsigned char *block = 0;
+    
+    if(next >= ESP8266_OBSERVER_COUNT)
+    {
+        next = 0;
+    }
+    
+    for(i = 0; i < ESP8266_MAX_LINKS; i++)
+    {
+        if(linkRole[i] == ESP8266_ROLE_OBSERVER)
+        {
+            found = 1;
+        }
+    }
+    
+    if(!found || next == obsDequeueIndex || length == 0 ||
+       length > ESP8266_TX_PACKET_SIZE || (block = Pool_Alloc(POOL_OBSERVER)) == 0)
+    {
+        return 0;
+    }
+    
+    memcpy(block, buffer, length);
+    obsPool[obsEnqueueIndex] = block;
+    obsPoolLength[obsEnqueueIndex] = (unsigned char)length;
+    obsEnqueueIndex = next;
+    
+    return 1;
+}
+
+/*******************************************************************************
+  * @brief Send a message on the bulk lane. The message is added to the
+  *        stream for the link and sent a chunk at a time while neither the
+  *        primary link nor the observers are waiting, this does not block.
+  * @par Parameters:
+  * link - observer link to send to
+  * buffer - data to send
+  * length - data length in bytes
+  * @retval 1 if the message was queued, 0 if the link is not an observer,
+  *         the lane is still sending to another link or there is no room
+  *****************************************************************************/
+int Esp8266_SendBulk(unsigned char link, const unsigned char *buffer,
+                     unsigned char length)
+{
+    if(Esp8266_GetLinkRole(link) != ESP8266_ROLE_OBSERVER ||
+       (Ring_Count(&bulkRing) && link != bulkLink) ||
+       !Ring_Write(&bulkRing, (unsigned char *)buffer, length))
+    {
+        return 0;
+    }
+    
+    bulkLink = link;
+    
+    return 1;
+}
+
+/*******************************************************************************
+  * @brief Get the role of a link in the connection table
+  * @par Parameters:
+  * link - link id
+  * @retval ESP8266_ROLE_NONE, ESP8266_ROLE_PRIMARY or ESP8266_ROLE_OBSERVER
+  *****************************************************************************/
+unsigned char Esp8266_GetLinkRole(unsigned char link)
+{
+    return (link < ESP8266_MAX_LINKS) ? linkRole[link] : ESP8266_ROLE_NONE;
+}
+
+/*******************************************************************************
+  * @brief Ask for a link profile, the module sets its sleep mode and
+  *        transmit power for it
+  * @par Parameters:
+  * profile - ESP8266_PROFILE_LOW_LATENCY or ESP8266_PROFILE_IDLE
+  * @retval 1, the profile always goes with the set up
+  *****************************************************************************/
+int Esp8266_SetLinkProfile(unsigned char profile)
+{
+    if(profile != linkProfile)
+    {
+        linkProfile = profile;
+        setupAsked |= ESP8266_SPI_SET_PROFILE;
+        setupPending |= ESP8266_SPI_SET_PROFILE;
+        activityTime = Sched_GetTime();
+        activitySeen = 0;
+    }
+    
+    return 1;
+}
+
+/*******************************************************************************
+  * @brief Get the link profile last asked for
+  * @par Parameters: None
+  * @retval LinkProfile value
+  *****************************************************************************/
+unsigned char Esp8266_GetLinkProfile(void)
+{
+    return linkProfile;
+}
+
+/*******************************************************************************
+  * @brief Switch the link profile on the controller's activity, see
+  *        ESP8266_AUTO_PROFILE. Starts low latency once the link is up.
+  * @par Parameters: None
+  * @retval None
+  *****************************************************************************/
+void Esp8266_UpdateProfile(void)
+{
+    if(linkStatus != ESP8266_LINK_READY)
+    {
+        return;
+    }
+    
+    if(linkProfile == ESP8266_PROFILE_NONE ||
+       (linkProfile == ESP8266_PROFILE_IDLE && activitySeen))
+    {
+        Esp8266_SetLinkProfile(ESP8266_PROFILE_LOW_LATENCY);
+    }
+    else if(linkProfile == ESP8266_PROFILE_LOW_LATENCY &&
+            Sched_IsExpired(activityTime + ESP8266_IDLE_TIMEOUT))
+    {
+        Esp8266_SetLinkProfile(ESP8266_PROFILE_IDLE);
+    }
+}
+
+/*******************************************************************************
+  * @brief Borrow the oldest received packet from the packet pool. The packet
+  *        stays valid until Esp8266_ReleasePacket is called.
+  * @par Parameters:
+  * packet - set to point at the packet data
+  * @retval number of bytes in the packet, 0 if no packet is waiting
+  *****************************************************************************/
+unsigned char Esp8266_AcquirePacket(const unsigned char **packet)
+{
+    unsigned char index = rxReadIndex;
+    
+    if(index == rxWriteIndex)
+    {
+        return 0;
+    }
+    
+    *packet = rxPool[index];
+    return rxPoolLength[index];
+}
+
+/*******************************************************************************
+  * @brief Get the time the packet returned by Esp8266_AcquirePacket started
+  *        to arrive
+  * @par Parameters: None
+  * @retval microsecond timestamp of its first chunk, see Sched_GetMicros
+  *****************************************************************************/
+unsigned short Esp8266_GetPacketTime(void)
+{
+    return rxPoolTime[rxReadIndex];
+}
+
+/*******************************************************************************
+  * @brief Get the link the packet returned by Esp8266_AcquirePacket came in
+  *        on
+  * @par Parameters: None
+  * @retval link id
+  *****************************************************************************/
+unsigned char Esp8266_GetPacketLink(void)
+{
+    return rxPoolLink[rxReadIndex];
+}
+
+/*******************************************************************************
+  * @brief Move the client link to the sender of the packet returned by
+  *        Esp8266_AcquirePacket if the module marked it as not from the
+  *        client's peer, see ESP8266_PEER_DISCOVERY. Call once the packet
+  *        has passed as a frame from the controller. The module moves the
+  *        link itself.
+  * @par Parameters: None
+  * @retval 1 if the link is being moved, 0 if not
+  *****************************************************************************/
+int Esp8266_FollowPeer(void)
+{
+#if ESP8266_PEER_DISCOVERY
+    unsigned char index = rxReadIndex;
+    
+    if(index == rxWriteIndex || rxPoolLink[index] != ESP8266_PRIMARY_LINK ||
+       !rxPoolForeign[index] || (setupPending & ESP8266_SPI_SET_FOLLOW))
+    {
+        return 0;
+    }
+    
+    setupPending |= ESP8266_SPI_SET_FOLLOW;
+    
+    return 1;
+#else
+    return 0;
+#endif
+}
+
+/*******************************************************************************
+  * @brief Hand the packet returned by Esp8266_AcquirePacket back to the pool
+  * @par Parameters: None
+  * @retval None
+  *****************************************************************************/
+void Esp8266_ReleasePacket(void)
+{
+    unsigned char index = rxReadIndex;
+    
+    if(index != rxWriteIndex)
+    {
+        //The controller is active, see ESP8266_AUTO_PROFILE
+        if(rxPoolLink[index] == ESP8266_PRIMARY_LINK)
+        {
+            activityTime = Sched_GetTime();
+            activitySeen = 1;
+        }
+    
+        if(++index >= ESP8266_RX_PACKET_COUNT)
+        {
+            index = 0;
+        }
+    
+        rxReadIndex = index;
+    }
+}
+
+/*******************************************************************************
+  * @brief Check the receive path has nothing in flight or waiting
+  * @par Parameters: None
+  * @retval 1 if idle, 0 otherwise
+  *****************************************************************************/
+int Esp8266_IsRxIdle(void)
+{
+    return (spiXfer == ESP8266_SPI_XFER_IDLE && rxCount == 0 && !moduleData &&
+            rxReadIndex == rxWriteIndex && !SPI_READY());
+}
+
+/*******************************************************************************
+  * @brief Get the number of received packets published to the pool
+  * @par Parameters: None
+  * @retval received packet count
+  *****************************************************************************/
+unsigned short Esp8266_GetRxPacketCount(void)
+{
+    return rxPacketCount;
+}
+
+/*******************************************************************************
+  * @brief Get the number of received packets that were dropped because the
+  *        packet pool was full or a chunk of them failed its check
+  * @par Parameters: None
+  * @retval dropped packet count
+  *****************************************************************************/
+unsigned short Esp8266_GetRxDropCount(void)
+{
+    return rxDropCount;
+}
+
+/*******************************************************************************
+  * @brief Get the number of received packets that were dropped because they
+  *        were larger than ESP8266_RX_BUFFER_SIZE
+  * @par Parameters: None
+  * @retval oversize packet count
+  *****************************************************************************/
+unsigned short Esp8266_GetRxOversizeCount(void)
+{
+    return rxOversizeCount;
+}
+
+/*******************************************************************************
+  * @brief Get the number of datagrams the module reported it failed to send
+  * @par Parameters: None
+  * @retval failed datagram count
+  *****************************************************************************/
+unsigned short Esp8266_GetTxFailCount(void)
+{
+    return txFailCount;
+}
+
+/*******************************************************************************
+  * @brief Get the number of times a datagram waited for the module to make
+  *        room for it
+  * @par Parameters: None
+  * @retval busy count
+  *****************************************************************************/
+unsigned short Esp8266_GetBusyCount(void)
+{
+    return txBusyCount;
+}
+
+/*******************************************************************************
+  * @brief Get the number of faults recovered from or being recovered from
+  * @par Parameters: None
+  * @retval recovery count
+  *****************************************************************************/
+unsigned short Esp8266_GetRecoveryCount(void)
+{
+    return recoveryCount;
+}
+
+/*******************************************************************************
+  * @brief Check the module still answers, for when the controller has gone
+  *        quiet. The status word is read at once, a bad one is a fault.
+  * @par Parameters: None
+  * @retval None
+  *****************************************************************************/
+void Esp8266_Probe(void)
+{
+    if(linkStatus == ESP8266_LINK_READY)
+    {
+        statusWanted = 1;
+    }
+}
+
+/*******************************************************************************
+  * @brief Get the recovery step in progress
+  * @par Parameters: None
+  * @retval ESP8266_HEALTH_OK, ESP8266_HEALTH_RESYNC while the status word
+  *         is bad or ESP8266_HEALTH_RESET while a module that booted is set
+  *         up again
+  *****************************************************************************/
+unsigned char Esp8266_GetHealth(void)
+{
+    return healthStep;
+}
+
+/*******************************************************************************
+  * @brief Set a callback to be invoked as each queued datagram is retired
+  * @par Parameters:
+  * callback - function invoked with ESP8266_AT_OK and the time the datagram
+  *            spent in the queue until its last chunk went, may be null
+  * @retval None
+  *****************************************************************************/
+void Esp8266_SetSendCallback(SendCallback callback)
+{
+    sendCallback = callback;
+}
+
+/*******************************************************************************
+  * @brief Set the baud rate callback, kept for the AT firmware. The SPI link
+  *        has no baud rate to settle, it is never invoked.
+  * @par Parameters:
+  * callback - function, may be null
+  * @retval None
+  *****************************************************************************/
+void Esp8266_SetBaudCallback(BaudCallback callback)
+{
+    baudCallback = callback;
+}
+
+/*******************************************************************************
+  * @brief Set a callback to be invoked as each packet from the controller
+  *        completes, before it waits its turn in the receive pool. It may
+  *        look at the packet but must not call back into the module driver.
+  * @par Parameters:
+  * callback - function invoked with the packet, its length and the time its
+  *            first chunk arrived in us, may be null
+  * @retval None
+  *****************************************************************************/
+void Esp8266_SetPriorityCallback(PacketCallback callback)
+{
+    priorityCallback = callback;
+}
+
+/*******************************************************************************
+  * @brief Take the result of the transaction the SPI has finished. Called
+  *        from the main loop.
+  * @par Parameters: None
+  * @retval 1 if a transaction finished, 0 if none or still in progress
+  *****************************************************************************/
+int Esp8266_ProcessRx(void)
+{
+    unsigned char xfer = spiXfer;
+    
+    if(xfer == ESP8266_SPI_XFER_IDLE || Spi_IsBusy())
+    {
+        return 0;
+    }
+    
+    spiXfer = ESP8266_SPI_XFER_IDLE;
+    
+    if(xfer == ESP8266_SPI_XFER_STATUS)
+    {
+        Esp8266_TakeStatus();
+    }
+    else if(xfer == ESP8266_SPI_XFER_READ)
+    {
+        Esp8266_TakeChunk();
+    }
+    else
+    {
+        Esp8266_CompleteWrite();
+    }
+    
+    return 1;
+}
+
+/*******************************************************************************
+  * @brief Start the next transaction: the status word when the module asks
+  *        for it or it is due, the chunk it has waiting, then the next chunk
+  *        for it. Called from the main loop.
+  * @par Parameters: None
+  * @retval 1 if a transaction started, 0 if one is in flight or there is
+  *         nothing to move
+  *****************************************************************************/
+int Esp8266_Process(void)
+{
+#if ESP8266_AUTO_PROFILE
+    Esp8266_UpdateProfile();
+#endif
+    
+    if(spiXfer != ESP8266_SPI_XFER_IDLE)
+    {
+        return 0;
+    }
+    
+    if(statusWanted || SPI_READY() || Sched_IsExpired(statusDue))
+    {
+        Esp8266_StartStatus();
+        return 1;
+    }
+    
+    if(moduleData)
+    {
+        Esp8266_StartRead();
+        return 1;
+    }
+    
+    return Esp8266_StartWrite();
+}
+
+/*******************************************************************************
+  * @brief Start reading the status word
+  * @par Parameters: None
+  * @retval None
+  *****************************************************************************/
+void Esp8266_StartStatus(void)
+{
+    spiFrame[0] = ESP8266_SPI_READ_STATUS;
+    memset(&spiFrame[1], 0, ESP8266_SPI_STATUS_SIZE);
+    
+    statusWanted = 0;
+    spiXfer = ESP8266_SPI_XFER_STATUS;
+    Spi_Transfer(spiFrame, spiFrame, SPI_STATUS_LENGTH);
+}
+
+/*******************************************************************************
+  * @brief Start reading the chunk the module has waiting
+  * @par Parameters: None
+  * @retval None
+  *****************************************************************************/
+void Esp8266_StartRead(void)
+{
+    spiFrame[0] = ESP8266_SPI_READ_DATA;
+    memset(&spiFrame[1], 0, SPI_DATA_LENGTH - 1);
+    
+    moduleData = 0;
+    spiXfer = ESP8266_SPI_XFER_READ;
+    Spi_Transfer(spiFrame, spiFrame, SPI_DATA_LENGTH);
+}
+
+/*******************************************************************************
+  * @brief Start writing the next chunk to the module: the rest of a
+  *        datagram that has started, then set up, lowest bit first, then
+  *        the primary link, the observers and the bulk lane. A datagram only
+  *        starts once the module has credit for all of it and holds back the
+  *        lanes behind it until then.
+  * @par Parameters: None
+  * @retval 1 if a chunk is being written, 0 if nothing can go
+  *****************************************************************************/
+int Esp8266_StartWrite(void)
+{
+    unsigned char op = 0;
+    unsigned char length = 0;
+    unsigned char *data = 0;
+    
+    if(!sessionKnown || moduleCredit == 0)
+    {
+        return 0;
+    }
+    
+    //sendOffset belongs to the lane the datagram started on, nothing goes
+    //between its chunks
+    if(sendOffset != 0)
+    {
+        sendSetup = 0;
+    
+        if(sendLane == ESP8266_LANE_OBSERVER)
+        {
+            Esp8266_StartDatagram(ESP8266_SPI_OBSERVERS,
+                                  obsPool[obsDequeueIndex],
+                                  obsPoolLength[obsDequeueIndex]);
+        }
+        else
+        {
+            Esp8266_StartDatagram(ESP8266_PRIMARY_LINK,
+                                  txPool[txPoolDequeueIndex],
+                                  txPoolLength[txPoolDequeueIndex]);
+        }
+    
+        return 1;
+    }
+    
+    if(setupPending)
+    {
+        for(op = 1; !(setupPending & op); op <<= 1)
+        {;}
+    
+        sendSetup = op;
+        length = Esp8266_BuildSetup(op, &spiFrame[2 + CHUNK_PAYLOAD]);
+        Esp8266_StartChunk(ESP8266_SPI_CONFIG, 0, length);
+        return 1;
+    }
+    
+    sendSetup = 0;
+    
+    if(txPoolDequeueIndex != txPoolEnqueueIndex)
+    {
+        length = txPoolLength[txPoolDequeueIndex];
+    
+        if(moduleCredit < CHUNK_COUNT(length))
+        {
+            //Counted once for each datagram that has to wait
+            if(!busyCounted)
+            {
+                txBusyCount++;
+                busyCounted = 1;
+            }
+    
+            return 0;
+        }
+    
+        busyCounted = 0;
+        sendLane = ESP8266_LANE_PRIMARY;
+        Esp8266_StartDatagram(ESP8266_PRIMARY_LINK, txPool[txPoolDequeueIndex],
+                              length);
+        return 1;
+    }
+    
+    if(obsDequeueIndex != obsEnqueueIndex)
+    {
+        length = obsPoolLength[obsDequeueIndex];
+    
+        if(moduleCredit < CHUNK_COUNT(length))
+        {
+            return 0;
+        }
+    
+        sendLane = ESP8266_LANE_OBSERVER;
+        Esp8266_StartDatagram(ESP8266_SPI_OBSERVERS, obsPool[obsDequeueIndex],
+                              length);
+        return 1;
+    }
+    
+    if(Ring_Count(&bulkRing))
+    {
+        //The rest of the stream for a link that closed is dropped
+        if(bulkLink >= ESP8266_MAX_LINKS)
+        {
+            Ring_Clear(&bulkRing);
+            return 1;
+        }
+    
+        length = Ring_PeekBlock(&bulkRing, &data);
+    
+        if(length > ESP8266_SPI_PAYLOAD_SIZE)
+        {
+            length = ESP8266_SPI_PAYLOAD_SIZE;
+        }
+    
+        memcpy(&spiFrame[2 + CHUNK_PAYLOAD], data, length);
+        sendLane = ESP8266_LANE_BULK;
+        sendLength = length;
+        Esp8266_StartChunk(ESP8266_SPI_DATAGRAM, bulkLink, length);
+        return 1;
+    }
+    
+    return 0;
+}
+
+/*******************************************************************************
+  * @brief Start writing the next chunk of a datagram, from sendOffset
+  * @par Parameters:
+  * link - link id or ESP8266_SPI_OBSERVERS
+  * data - the datagram
+  * length - datagram length in bytes
+  * @retval None
+  *****************************************************************************/
+void Esp8266_StartDatagram(unsigned char link, const unsigned char *data,
+                           unsigned char length)
+{
+    unsigned char type = ESP8266_SPI_DATAGRAM;
+    unsigned char chunk = 0;
+    
+    //An offset past the end is not this datagram's, it starts from its
+    //first chunk rather than going as the tail of another
+    if(sendOffset >= length)
+    {
+        sendOffset = 0;
+    }
+    
+    chunk = length - sendOffset;
+    
+    if(chunk > ESP8266_SPI_PAYLOAD_SIZE)
+    {
+        chunk = ESP8266_SPI_PAYLOAD_SIZE;
+        type |= ESP8266_SPI_MORE;
+    }
+    
+    if(sendOffset != 0)
+    {
+        type |= ESP8266_SPI_CONTINUED;
+    }
+    
+    memcpy(&spiFrame[2 + CHUNK_PAYLOAD], data + sendOffset, chunk);
+    sendLength = chunk;
+    Esp8266_StartChunk(type, link, chunk);
+}
+
+/*******************************************************************************
+  * @brief Fill in the header and check of the chunk whose payload is in
+  *        place and start writing it
+  * @par Parameters:
+  * type - ESP8266_SPI_ type and flags
+  * link - link id
+  * length - payload bytes
+  * @retval None
+  *****************************************************************************/
+void Esp8266_StartChunk(unsigned char type, unsigned char link,
+                        unsigned char length)
+{
+    unsigned char *chunk = &spiFrame[2];
+    
+    spiFrame[0] = ESP8266_SPI_WRITE_DATA;
+    spiFrame[1] = 0;
+    chunk[CHUNK_TYPE] = type;
+    chunk[CHUNK_LINK] = link;
+    chunk[CHUNK_LENGTH] = length;
+    memset(&chunk[CHUNK_PAYLOAD + length], 0, ESP8266_SPI_PAYLOAD_SIZE - length);
+    chunk[CHUNK_CHECK] = Esp8266_Check(chunk);
+    
+    moduleCredit--;
+    spiXfer = ESP8266_SPI_XFER_WRITE;
+    Spi_Transfer(spiFrame, spiFrame, SPI_DATA_LENGTH);
+}
+
+/*******************************************************************************
+  * @brief Write the payload of a set up chunk
+  * @par Parameters:
+  * op - ESP8266_SPI_SET_ value
+  * payload - where it goes, ESP8266_SPI_PAYLOAD_SIZE bytes
+  * @retval payload length
+  *****************************************************************************/
+unsigned char Esp8266_BuildSetup(unsigned char op, unsigned char *payload)
+{
+    unsigned char length = 1;
+    size_t text = 0;
+    
+    payload[0] = op;
+    
+    if(op == ESP8266_SPI_SET_AP_NAME && apName)
+    {
+        text = strlen(apName);
+        text = (text < ESP8266_SPI_PAYLOAD_SIZE - 1) ? text :
+                                                       ESP8266_SPI_PAYLOAD_SIZE - 1;
+        memcpy(&payload[1], apName, text);
+        length = (unsigned char)(1 + text);
+    }
+    else if(op == ESP8266_SPI_SET_CLIENT && clientIp)
+    {
+        payload[1] = clientType;
+        payload[2] = (unsigned char)clientPeerPort;
+        payload[3] = (unsigned char)(clientPeerPort >> 8);
+        text = strlen(clientIp);
+        text = (text < ESP8266_SPI_PAYLOAD_SIZE - 4) ? text :
+                                                       ESP8266_SPI_PAYLOAD_SIZE - 4;
+        memcpy(&payload[4], clientIp, text);
+        length = (unsigned char)(4 + text);
+    }
+    else if(op == ESP8266_SPI_SET_SERVER)
+    {
+        payload[1] = (unsigned char)serverPort;
+        payload[2] = (unsigned char)(serverPort >> 8);
+        length = 3;
+    }
+    else if(op == ESP8266_SPI_SET_PROFILE)
+    {
+        payload[1] = linkProfile;
+        payload[2] = (linkProfile == ESP8266_PROFILE_IDLE) ? ESP8266_IDLE_RFPOWER :
+                                                             ESP8266_FULL_RFPOWER;
+        length = 3;
+    }
+    
+    return length;
+}
+
+/*******************************************************************************
+  * @brief Take the status word just read. A first one, or one with a new
+  *        session, has the module set up from the start.
+  * @par Parameters: None
+  * @retval None
+  *****************************************************************************/
+void Esp8266_TakeStatus(void)
+{
+    const unsigned char *status = &spiFrame[1];
+    unsigned long now = Sched_GetTime();
+    
+    if((status[STATUS_FLAGS] & STATUS_MARK_MASK) != ESP8266_SPI_STATUS_MARK)
+    {
+        Esp8266_Fault();
+        statusDue = now + ((linkStatus == ESP8266_LINK_ERROR) ?
+                           ESP8266_RESET_RETRY : ESP8266_PROBE_INTERVAL);
+        return;
+    }
+    
+    faultCount = 0;
+    
+    if(healthStep == ESP8266_HEALTH_RESYNC)
+    {
+        LOG1(LOG_ESP_RECOVERED, healthStep);
+        healthStep = ESP8266_HEALTH_OK;
+    }
+    
+    if(status[STATUS_FLAGS] & ESP8266_SPI_STATUS_FAIL)
+    {
+        txFailCount++;
+    }
+    
+    moduleData = status[STATUS_FLAGS] & ESP8266_SPI_STATUS_DATA;
+    moduleCredit = status[STATUS_CREDIT];
+    
+    if(!sessionKnown || status[STATUS_SESSION] != moduleSession)
+    {
+        //A module that booted under a running link is a recovery
+        if(linkStatus == ESP8266_LINK_READY && healthStep == ESP8266_HEALTH_OK)
+        {
+            healthStep = ESP8266_HEALTH_RESET;
+            recoveryCount++;
+            LOG1(LOG_ESP_RECOVERY, healthStep);
+        }
+    
+        moduleSession = status[STATUS_SESSION];
+        sessionKnown = 1;
+        setupPending = setupAsked;
+    
+        //What was half sent or half received is started again or lost
+        sendOffset = 0;
+        rxCount = 0;
+    }
+    
+    Esp8266_UpdateLinks(status[STATUS_LINKS]);
+    Esp8266_UpdateStatus();
+    
+    if(linkStatus != ESP8266_LINK_READY)
+    {
+        statusDue = now + ESP8266_PROBE_INTERVAL;
+    }
+    else if(moduleCredit == 0 && Esp8266_IsBusy())
+    {
+        statusDue = now + ESP8266_BUSY_BACKOFF;
+    }
+    else
+    {
+        statusDue = now + TIMEOUT_SHORT;
+    }
+}
+
+/*******************************************************************************
+  * @brief Take the chunk just read. The chunks of a datagram are put
+  *        together in the next pool slot and published with the last one.
+  * @par Parameters: None
+  * @retval None
+  *****************************************************************************/
+void Esp8266_TakeChunk(void)
+{
+    const unsigned char *chunk = &spiFrame[2];
+    unsigned char type = chunk[CHUNK_TYPE];
+    unsigned char link = chunk[CHUNK_LINK];
+    unsigned char length = chunk[CHUNK_LENGTH];
+    unsigned char next = 0;
+    
+    //The status word says if another is waiting
+    statusWanted = 1;
+    
+    if(chunk[CHUNK_CHECK] != Esp8266_Check(chunk) || length == 0 ||
+       length > ESP8266_SPI_PAYLOAD_SIZE ||
+       (type & ESP8266_SPI_TYPE_MASK) != ESP8266_SPI_DATAGRAM)
+    {
+        //A datagram with a chunk missing is lost, the chunks left of it
+        //find no start and are dropped
+        rxDropCount++;
+        rxCount = 0;
+        Esp8266_Fault();
+        return;
+    }
+    
+    if(!(type & ESP8266_SPI_CONTINUED))
+    {
+        rxCount = 0;
+        rxSkip = 0;
+    
+        next = rxWriteIndex + 1;
+        if(next >= ESP8266_RX_PACKET_COUNT)
+        {
+            next = 0;
+        }
+    
+        if(next == rxReadIndex)
+        {
+            rxDropCount++;
+            rxSkip = 1;
+    
+            //A stop must not wait for the burst in front of it
+            if(priorityCallback && link == ESP8266_PRIMARY_LINK &&
+               !(type & ESP8266_SPI_MORE) && length <= ESP8266_RX_PRIORITY_SIZE)
+            {
+                priorityCallback(&chunk[CHUNK_PAYLOAD], length, Sched_GetMicros());
+            }
+    
+            return;
+        }
+    
+        rxPoolTime[rxWriteIndex] = Sched_GetMicros();
+        rxPoolLink[rxWriteIndex] = link;
+        rxPoolForeign[rxWriteIndex] = (type & ESP8266_SPI_FOREIGN) != 0;
+    }
+    else if(rxSkip || rxCount == 0)
+    {
+        return;
+    }
+    
+    if(rxCount + length > ESP8266_RX_BUFFER_SIZE)
+    {
+        rxOversizeCount++;
+        rxSkip = 1;
+        rxCount = 0;
+        return;
+    }
+    
+    memcpy(&rxPool[rxWriteIndex][rxCount], &chunk[CHUNK_PAYLOAD], length);
+    rxCount += length;
+    
+    if(type & ESP8266_SPI_MORE)
+    {
+        return;
+    }
+    
+    //Publish the packet to the main loop and move on to the next pool slot
+    rxPoolLength[rxWriteIndex] = rxCount;
+    
+    if(priorityCallback && rxPoolLink[rxWriteIndex] == ESP8266_PRIMARY_LINK)
+    {
+        priorityCallback(rxPool[rxWriteIndex], rxCount, rxPoolTime[rxWriteIndex]);
+    }
+    
+    next = rxWriteIndex + 1;
+    rxWriteIndex = (next >= ESP8266_RX_PACKET_COUNT) ? 0 : next;
+    rxPacketCount++;
+    rxCount = 0;
+}
+
+/*******************************************************************************
+  * @brief Retire what the chunk just written carried
+  * @par Parameters: None
+  * @retval None
+  *****************************************************************************/
+void Esp8266_CompleteWrite(void)
+{
+    if(sendSetup)
+    {
+        setupPending &= (unsigned char)~sendSetup;
+        Esp8266_UpdateStatus();
+        return;
+    }
+    
+    if(sendLane == ESP8266_LANE_BULK)
+    {
+        Ring_Discard(&bulkRing, sendLength);
+        return;
+    }
+    
+    sendOffset += sendLength;
+    
+    if(sendLane == ESP8266_LANE_OBSERVER)
+    {
+        if(sendOffset >= obsPoolLength[obsDequeueIndex])
+        {
+            sendOffset = 0;
+            Pool_Free(obsPool[obsDequeueIndex]);
+    
+            if(++obsDequeueIndex >= ESP8266_OBSERVER_COUNT)
+            {
+                obsDequeueIndex = 0;
+            }
+        }
+    
+        return;
+    }
+    
+    if(sendOffset >= txPoolLength[txPoolDequeueIndex])
+    {
+        sendOffset = 0;
+    
+        if(sendCallback)
+        {
+            sendCallback(ESP8266_AT_OK,
+                         Sched_GetMicros() - txPoolTime[txPoolDequeueIndex]);
+        }
+    
+        Pool_Free(txPool[txPoolDequeueIndex]);
+    
+        if(++txPoolDequeueIndex >= ESP8266_TX_PACKET_COUNT)
+        {
+            txPoolDequeueIndex = 0;
+        }
+    }
+}
+
+/*******************************************************************************
+  * @brief Work out the check byte of a chunk
+  * @par Parameters:
+  * chunk - the chunk
+  * @retval complement of the sum of the bytes before the check
+  *****************************************************************************/
+unsigned char Esp8266_Check(const unsigned char *chunk)
+{
+    unsigned char sum = 0;
+    unsigned char i = 0;
+    
+    for(i = 0; i < CHUNK_CHECK; i++)
+    {
+        sum += chunk[i];
+    }
+    
+    return (unsigned char)~sum;
+}
+
+/*******************************************************************************
+  * @brief Bring the connection table up to date with the links the module
+  *        reports connected
+  * @par Parameters:
+  * links - bit mask of the connected link ids
+  * @retval None
+  *****************************************************************************/
+void Esp8266_UpdateLinks(unsigned char links)
+{
+    unsigned char i = 0;
+    
+    for(i = 0; i < ESP8266_MAX_LINKS; i++)
+    {
+        if((links & (1 << i)) && linkRole[i] == ESP8266_ROLE_NONE)
+        {
+            linkRole[i] = (i == ESP8266_PRIMARY_LINK) ? ESP8266_ROLE_PRIMARY :
+                                                        ESP8266_ROLE_OBSERVER;
+            LOG2(LOG_LINK_OPENED, i, linkRole[i]);
+        }
+        else if(!(links & (1 << i)) && linkRole[i] != ESP8266_ROLE_NONE)
+        {
+            linkRole[i] = ESP8266_ROLE_NONE;
+            LOG1(LOG_LINK_CLOSED, i);
+    
+            //The rest of its stream is dropped by Esp8266_StartWrite
+            if(i == bulkLink)
+            {
+                bulkLink = ESP8266_MAX_LINKS;
+            }
+        }
+    }
+}
+
+/*******************************************************************************
+  * @brief Set the link status: ready once the module is set up and the
+  *        client link is connected
+  * @par Parameters: None
+  * @retval None
+  *****************************************************************************/
+void Esp8266_UpdateStatus(void)
+{
+    if(!sessionKnown || (setupPending & SETUP_LINK) ||
+       linkRole[ESP8266_PRIMARY_LINK] == ESP8266_ROLE_NONE)
+    {
+        linkStatus = ESP8266_LINK_DOWN;
+        return;
+    }
+    
+    if(linkStatus != ESP8266_LINK_READY)
+    {
+        linkStatus = ESP8266_LINK_READY;
+    
+        if(linkUpTime == 0)
+        {
+            linkUpTime = Sched_GetTime();
+        }
+    
+        if(healthStep == ESP8266_HEALTH_RESET)
+        {
+            LOG1(LOG_ESP_RECOVERED, healthStep);
+            healthStep = ESP8266_HEALTH_OK;
+        }
+    }
+}
+
+/*******************************************************************************
+  * @brief Count a bad status word or chunk. The first under a running link
+  *        starts a recovery. ESP8266_RESYNC_COUNT in a row take the module
+  *        as gone, it is set up again once it answers, and a module that
+  *        has not answered ESP8266_PROBE_COUNT times since start up is an
+  *        error, still tried every ESP8266_RESET_RETRY.
+  * @par Parameters: None
+  * @retval None
+  *****************************************************************************/
+void Esp8266_Fault(void)
+{
+    if(faultCount < 0xFF)
+    {
+        faultCount++;
+    }
+    
+    if(linkStatus == ESP8266_LINK_READY && healthStep == ESP8266_HEALTH_OK)
+    {
+        healthStep = ESP8266_HEALTH_RESYNC;
+        recoveryCount++;
+        LOG1(LOG_ESP_RECOVERY, healthStep);
+    }
+    
+    if(faultCount >= ESP8266_RESYNC_COUNT && sessionKnown)
+    {
+        if(healthStep == ESP8266_HEALTH_RESYNC)
+        {
+            healthStep = ESP8266_HEALTH_RESET;
+            LOG1(LOG_ESP_RECOVERY, healthStep);
+        }
+    
+        sessionKnown = 0;
+        moduleData = 0;
+        moduleCredit = 0;
+        Esp8266_UpdateStatus();
+    }
+    
+    if(!sessionKnown && linkUpTime == 0 && ++probeCount >= ESP8266_PROBE_COUNT)
+    {
+        linkStatus = ESP8266_LINK_ERROR;
+    }
+}
+
+/*******************************************************************************
+  * @brief Check if set up or datagrams are queued or in progress
+  * @par Parameters: None
+  * @retval 1 if busy, 0 if all the queues are empty
+  *****************************************************************************/
+int Esp8266_IsBusy(void)
+{
+    return setupPending || (txPoolDequeueIndex != txPoolEnqueueIndex) ||
+           (obsDequeueIndex != obsEnqueueIndex) ||
+           (Ring_Count(&bulkRing) != 0);
+}
+
+/*******************************************************************************
+  * @brief Get the link status
+  * @par Parameters: None
+  * @retval ESP8266_LINK_DOWN, ESP8266_LINK_READY or ESP8266_LINK_ERROR
+  *****************************************************************************/
+unsigned char Esp8266_GetLinkStatus(void)
+{
+    return linkStatus;
+}
+
+/*******************************************************************************
+  * @brief Get the time the link first became ready, for measuring start up
+  * @par Parameters: None
+  * @retval scheduler time in ms, 0 if the link has not been ready yet
+  *****************************************************************************/
+unsigned long Esp8266_GetLinkUpTime(void)
+{
+    return linkUpTime;
+}
+
+/*******************************************************************************
+  * @brief Interrupt service routine invoked when the module raises its ready
+  *        output. The main loop reads the status word, this only brings it
+  *        out of wfi at full speed.
+  * @par Parameters: None
+  * @retval None
+  *****************************************************************************/
+void Esp8266_ReadyISR(void)
+{
+    POWER_WAKE_FROM_ISR();
+}
+
+#endif
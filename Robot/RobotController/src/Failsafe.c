@@ -0,0 +1,130 @@
+/*******************************************************************************
+  * @file Failsafe.c
+  * @brief Implements the command failsafe. Every accepted frame feeds the 
+  *        failsafe, if the robot is moving and nothing arrives within the 
+  *        timeout the wheels are ramped to a stop. A lost stop command then
+  *        costs at most the timeout instead of driving on forever. The time
+  *        from the last frame to standstill is measured on each trip.
+  * @author David Sharpe
+  * @version V1.0.0
+  * @date 14-October-2026
+  *
+  * ST Visual Develop 4.2.1 using STM8 Cosmic C Compiler
+  *****************************************************************************/
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Includes
+////////////////////////////////////////////////////////////////////////////////
+#include "Failsafe.h"
+#include "DriveController.h"
+#include "Log.h"
+#include "Scheduler.h"
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Variables
+////////////////////////////////////////////////////////////////////////////////
+unsigned short failsafeTimeout = FAILSAFE_TIMEOUT_DEFAULT;
+unsigned long lastFeedTime = 0;
+
+//Set from the trip until the wheels have stopped or a frame arrives
+unsigned char tripped = 0;
+
+unsigned short tripCount = 0;
+unsigned short worstStop = 0;
+
+
+/*******************************************************************************
+  * @brief Initialize the failsafe, the timeout starts now
+  * @par Parameters: None
+  * @retval None
+  *****************************************************************************/
+void Failsafe_Initialize(void)
+{
+    lastFeedTime = Sched_GetTime();
+    tripped = 0;
+    tripCount = 0;
+    worstStop = 0;
+}
+
+/*******************************************************************************
+  * @brief Set the time allowed between frames while moving
+  * @par Parameters:
+  * ms - timeout in ms, 0 for the default
+  * @retval None
+  *****************************************************************************/
+void Failsafe_SetTimeout(unsigned short ms)
+{
+    if(ms == 0)
+    {
+        ms = FAILSAFE_TIMEOUT_DEFAULT;
+    }
+    
+    failsafeTimeout = (ms < FAILSAFE_TIMEOUT_MIN) ? FAILSAFE_TIMEOUT_MIN : ms;
+}
+
+/*******************************************************************************
+  * @brief Restart the timeout, called for each frame accepted from the remote
+  * @par Parameters: None
+  * @retval None
+  *****************************************************************************/
+void Failsafe_Feed(void)
+{
+    lastFeedTime = Sched_GetTime();
+    tripped = 0;
+}
+
+/*******************************************************************************
+  * @brief Failsafe task, stops the robot once the timeout has passed. Called
+  *        every FAILSAFE_PERIOD ms.
+  * @par Parameters: None
+  * @retval None
+  *****************************************************************************/
+void Failsafe_Task(void)
+{
+    unsigned long elapsed = Sched_GetTime() - lastFeedTime;
+    
+    if(!tripped)
+    {
+        if(elapsed >= failsafeTimeout && DriveCtrl_IsMoving())
+        {
+            //Ramp down rather than brake, the same as a stop command
+            DriveCtrl_SetWheelDuty(0, 0);
+            tripped = 1;
+            tripCount++;
+            LOG1(LOG_FAILSAFE_TRIP, (elapsed > 0xFFFF) ? 0xFFFF : 
+                                    (unsigned short)elapsed);
+        }
+    }
+    else if(!DriveCtrl_IsMoving())
+    {
+        if(elapsed > worstStop)
+        {
+            worstStop = (elapsed > 0xFFFF) ? 0xFFFF : (unsigned short)elapsed;
+        }
+        
+        tripped = 0;
+    }
+}
+
+/*******************************************************************************
+  * @brief Get the number of times the failsafe stopped the robot
+  * @par Parameters: None
+  * @retval trip count
+  *****************************************************************************/
+unsigned short Failsafe_GetTrips(void)
+{
+    return tripCount;
+}
+
+/*******************************************************************************
+  * @brief Get the longest time from the last frame to standstill over all 
+  *        trips
+  * @par Parameters: None
+  * @retval time in ms
+  *****************************************************************************/
+unsigned short Failsafe_GetWorstStop(void)
+{
+    return worstStop;
+}
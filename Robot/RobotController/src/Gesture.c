@@ -0,0 +1,191 @@
+/*******************************************************************************
+  * @file Gesture.c
+  * @brief Implements the touch key gesture decoder, a state machine stepped
+  *        with the key state after every touch acquisition. Times are taken
+  *        from the scheduler so the decoder does not depend on how often 
+  *        it is stepped.
+  * @author David Sharpe
+  * @version V1.0.0
+  * @date 14-October-2026
+  *
+  * ST Visual Develop 4.2.1 using STM8 Cosmic C Compiler
+  *****************************************************************************/
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Includes
+////////////////////////////////////////////////////////////////////////////////
+#include "Gesture.h"
+#include "Ring.h"
+#include "Scheduler.h"
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Definitions
+////////////////////////////////////////////////////////////////////////////////
+enum GestureState
+{
+    GESTURE_IDLE,       //key released
+    GESTURE_FIRST,      //first press, a tap or a long press
+    GESTURE_GAP,        //tapped once, waiting for a second press
+    GESTURE_SECOND,     //second press, a double tap or a long press
+    GESTURE_HELD        //long press reported, waiting for the release
+};
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Prototypes
+////////////////////////////////////////////////////////////////////////////////
+unsigned char QueueGesture(unsigned char event);
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Variables
+////////////////////////////////////////////////////////////////////////////////
+unsigned char gestureState = GESTURE_IDLE;
+unsigned long gestureTime = 0;
+
+//Events in the last report, removed once it is queued
+unsigned char gestureReported = 0;
+
+RING_DEFINE(gestureQueue, GESTURE_QUEUE_SIZE);
+
+
+/*******************************************************************************
+  * @brief Start with the key released and nothing queued
+  * @par Parameters: None
+  * @retval None
+  *****************************************************************************/
+void Gesture_Initialize(void)
+{
+    gestureState = GESTURE_IDLE;
+    gestureReported = 0;
+    Ring_Clear(&gestureQueue);
+}
+
+/*******************************************************************************
+  * @brief Step the decoder with the key state. Called after each touch 
+  *        acquisition.
+  * @par Parameters:
+  * pressed - 1 if the key is touched, 0 otherwise
+  * @retval event from GestureEvent, GESTURE_NONE if nothing happened
+  *****************************************************************************/
+unsigned char Gesture_Update(unsigned char pressed)
+{
+    unsigned long now = Sched_GetTime();
+    unsigned long held = now - gestureTime;
+    
+    switch(gestureState)
+    {
+        case GESTURE_IDLE:
+            if(pressed)
+            {
+                gestureState = GESTURE_FIRST;
+                gestureTime = now;
+                return GESTURE_TOUCH;
+            }
+            break;
+        
+        case GESTURE_FIRST:
+        case GESTURE_SECOND:
+            if(held >= GESTURE_LONG_TIME)
+            {
+                gestureState = GESTURE_HELD;
+                return QueueGesture(GESTURE_LONG_PRESS);
+            }
+            
+            if(!pressed && gestureState == GESTURE_SECOND)
+            {
+                gestureState = GESTURE_IDLE;
+                return QueueGesture(GESTURE_DOUBLE_TAP);
+            }
+            
+            if(!pressed)
+            {
+                gestureState = GESTURE_GAP;
+                gestureTime = now;
+            }
+            break;
+        
+        case GESTURE_GAP:
+            if(pressed)
+            {
+                gestureState = GESTURE_SECOND;
+                gestureTime = now;
+            }
+            else if(held >= GESTURE_GAP_TIME)
+            {
+                gestureState = GESTURE_IDLE;
+                return QueueGesture(GESTURE_TAP);
+            }
+            break;
+        
+        case GESTURE_HELD:
+            if(!pressed)
+            {
+                gestureState = GESTURE_IDLE;
+            }
+            break;
+        
+        default:
+            gestureState = GESTURE_IDLE;
+            break;
+    };
+    
+    return GESTURE_NONE;
+}
+
+/*******************************************************************************
+  * @brief Check if gestures are waiting for the remote
+  * @par Parameters: None
+  * @retval 1 if there are, 0 otherwise
+  *****************************************************************************/
+int Gesture_IsPending(void)
+{
+    return !RING_IS_EMPTY(gestureQueue);
+}
+
+/*******************************************************************************
+  * @brief Write the waiting gestures, oldest first. They stay queued until
+  *        Gesture_Release, so a report that cannot be queued is sent again.
+  * @par Parameters:
+  * report - buffer of at least GESTURE_QUEUE_SIZE bytes, one per event
+  * @retval report length in bytes
+  *****************************************************************************/
+unsigned char Gesture_GetReport(unsigned char *report)
+{
+    unsigned char i = 0;
+    
+    gestureReported = Ring_Count(&gestureQueue);
+    
+    for(i = 0; i < gestureReported; i++)
+    {
+        report[i] = Ring_PeekAt(&gestureQueue, i);
+    }
+    
+    return gestureReported;
+}
+
+/*******************************************************************************
+  * @brief Remove the gestures in the last report, once it has been queued
+  * @par Parameters: None
+  * @retval None
+  *****************************************************************************/
+void Gesture_Release(void)
+{
+    Ring_Discard(&gestureQueue, gestureReported);
+    gestureReported = 0;
+}
+
+/*******************************************************************************
+  * @brief Queue a gesture for the remote, it is lost if the queue is full
+  * @par Parameters:
+  * event - gesture
+  * @retval the gesture
+  *****************************************************************************/
+unsigned char QueueGesture(unsigned char event)
+{
+    Ring_Put(&gestureQueue, event);
+    
+    return event;
+}
@@ -0,0 +1,167 @@
+/*******************************************************************************
+  * @file Latency.c
+  * @brief Implements the latency probe. A stamp arms it with the times the
+  *        packet arrived and was taken, the next command dispatched from 
+  *        the frame is timed and the PWM interrupt that applies the next 
+  *        output change closes it. Stage times are 16-bit microseconds, so 
+  *        a stage longer than 65ms wraps.
+  * @author David Sharpe
+  * @version V1.0.0
+  * @date 14-October-2026
+  *
+  * ST Visual Develop 4.2.1 using STM8 Cosmic C Compiler
+  *****************************************************************************/
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Includes
+////////////////////////////////////////////////////////////////////////////////
+#include "Latency.h"
+#include "Protocol.h"
+#include "Scheduler.h"
+
+#if LATENCY_ENABLE
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Definitions
+////////////////////////////////////////////////////////////////////////////////
+enum LatencyState
+{
+    LATENCY_IDLE,
+    LATENCY_ARMED,      //stamped, waiting for the next command
+    LATENCY_DISPATCHED, //waiting for the PWM interrupt or the timeout
+    LATENCY_APPLIED     //report ready
+};
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Variables
+////////////////////////////////////////////////////////////////////////////////
+volatile unsigned char latencyState = LATENCY_IDLE;
+unsigned char latencyStamp[4];
+unsigned long latencyHeader = 0;
+unsigned short latencyUart = 0;
+unsigned short latencyParse = 0;
+
+//Times of the dispatch, the interrupt measures from the first
+unsigned short latencyDispatch = 0;
+unsigned long latencyDeadline = 0;
+unsigned short latencyApply = LATENCY_NONE;
+
+
+/*******************************************************************************
+  * @brief Arm the probe for the command that follows a stamp
+  * @par Parameters:
+  * stamp - controller time of the input, 4 bytes returned unchanged
+  * headerTime - time the +IPD header of the packet arrived in us
+  * takenTime - time the main loop took the packet in us
+  * @retval None
+  *****************************************************************************/
+void Latency_Stamp(const unsigned char *stamp, unsigned short headerTime, 
+                   unsigned short takenTime)
+{
+    unsigned short age = Sched_GetMicros() - headerTime;
+    unsigned char i = 0;
+    
+    //The interrupt only acts on a dispatched command
+    latencyState = LATENCY_IDLE;
+    
+    for(i = 0; i < sizeof(latencyStamp); i++)
+    {
+        latencyStamp[i] = stamp[i];
+    }
+    
+    latencyHeader = Sched_GetTime() - (age / 1000);
+    latencyUart = takenTime - headerTime;
+    latencyParse = takenTime;
+    latencyApply = LATENCY_NONE;
+    latencyState = LATENCY_ARMED;
+}
+
+/*******************************************************************************
+  * @brief Time the dispatch of the command after the stamp, called for 
+  *        every command dispatched
+  * @par Parameters:
+  * type - command type
+  * @retval None
+  *****************************************************************************/
+void Latency_Dispatch(unsigned char type)
+{
+    if(latencyState != LATENCY_ARMED || type == PROTO_CMD_STAMP)
+    {
+        return;
+    }
+    
+    latencyDispatch = Sched_GetMicros();
+    latencyParse = latencyDispatch - latencyParse;
+    latencyDeadline = Sched_GetTime() + LATENCY_TIMEOUT;
+    latencyState = LATENCY_DISPATCHED;
+}
+
+/*******************************************************************************
+  * @brief Time the output change after the dispatch, called from the TIM2 
+  *        update interrupt that loads the staged duties
+  * @par Parameters: None
+  * @retval None
+  *****************************************************************************/
+void Latency_ApplyISR(void)
+{
+    if(latencyState == LATENCY_DISPATCHED)
+    {
+        latencyApply = Sched_GetMicros() - latencyDispatch;
+        latencyState = LATENCY_APPLIED;
+    }
+}
+
+/*******************************************************************************
+  * @brief Check if the stage times of a stamped command are ready to send
+  * @par Parameters: None
+  * @retval 1 if the output change or the timeout has closed the probe, 0 
+  *         otherwise
+  *****************************************************************************/
+int Latency_IsReady(void)
+{
+    return latencyState == LATENCY_APPLIED || 
+           (latencyState == LATENCY_DISPATCHED && 
+            Sched_IsExpired(latencyDeadline));
+}
+
+/*******************************************************************************
+  * @brief Get the stage times and disarm the probe
+  * @par Parameters:
+  * report - buffer of LATENCY_REPORT_SIZE bytes
+  * @retval number of bytes written, 0 if the probe is not ready
+  *****************************************************************************/
+unsigned char Latency_GetReport(unsigned char *report)
+{
+    unsigned char i = 0;
+    
+    if(!Latency_IsReady())
+    {
+        return 0;
+    }
+    
+    //No interrupt may apply now, a late one would be counted as this stamp
+    latencyState = LATENCY_IDLE;
+    
+    for(i = 0; i < sizeof(latencyStamp); i++)
+    {
+        report[i] = latencyStamp[i];
+    }
+    
+    report[4] = (unsigned char)latencyHeader;
+    report[5] = (unsigned char)(latencyHeader >> 8);
+    report[6] = (unsigned char)(latencyHeader >> 16);
+    report[7] = (unsigned char)(latencyHeader >> 24);
+    report[8] = (unsigned char)latencyUart;
+    report[9] = (unsigned char)(latencyUart >> 8);
+    report[10] = (unsigned char)latencyParse;
+    report[11] = (unsigned char)(latencyParse >> 8);
+    report[12] = (unsigned char)latencyApply;
+    report[13] = (unsigned char)(latencyApply >> 8);
+    
+    return LATENCY_REPORT_SIZE;
+}
+
+#endif
@@ -0,0 +1,264 @@
+/*******************************************************************************
+  * @file Load.c
+  * @brief Implements the main loop load monitor. The loop calls Load_Loop
+  *        at the top of every iteration and Load_Sleep in place of its wfi.
+  *        A period covers the whole iteration, blocking waits included,
+  *        and is timed with the TIM1 microsecond count, the millisecond
+  *        time marks the ones too long for it. The interrupt that wakes
+  *        the loop runs before the sleep ends, so interrupt time is counted
+  *        as asleep: busy is the main loop's own share.
+  * @author David Sharpe
+  * @version V1.0.0
+  * @date 14-October-2026
+  *
+  * ST Visual Develop 4.2.1 using STM8 Cosmic C Compiler
+  *****************************************************************************/
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Includes
+////////////////////////////////////////////////////////////////////////////////
+#include "Load.h"
+#include "Scheduler.h"
+#include "stm8s.h"
+
+#if LOAD_ENABLE
+
+////////////////////////////////////////////////////////////////////////////////
+// Definitions
+////////////////////////////////////////////////////////////////////////////////
+
+//Loop periods this long in ms may have wrapped the microsecond count
+#define LOAD_WRAP_MS        60
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Prototypes
+////////////////////////////////////////////////////////////////////////////////
+void Load_Close(unsigned long now);
+void Load_PutShort(unsigned char *report, unsigned short value);
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Variables
+////////////////////////////////////////////////////////////////////////////////
+
+//Start of the last iteration and of the window
+unsigned short loopMicros = 0;
+unsigned long loopTime = 0;
+unsigned long windowStart = 0;
+unsigned char loopStarted = 0;
+
+//Window being measured
+unsigned long sleepMicros = 0;
+unsigned short loopCount = 0;
+unsigned short periodMin = LOAD_PERIOD_MAX;
+unsigned short periodMax = 0;
+unsigned short periodBins[LOAD_BINS];
+
+//Report of the last window closed, waiting for the telemetry
+unsigned char loadReport[LOAD_REPORT_SIZE];
+unsigned char loadPending = 0;
+
+
+/*******************************************************************************
+  * @brief Start the first window at the next iteration
+  * @par Parameters: None
+  * @retval None
+  *****************************************************************************/
+void Load_Initialize(void)
+{
+    unsigned char i = 0;
+    
+    loopStarted = 0;
+    sleepMicros = 0;
+    loopCount = 0;
+    periodMin = LOAD_PERIOD_MAX;
+    periodMax = 0;
+    loadPending = 0;
+    
+    for(i = 0; i < LOAD_BINS; i++)
+    {
+        periodBins[i] = 0;
+    }
+}
+
+/*******************************************************************************
+  * @brief Record the period of the iteration that just ended, call at the
+  *        top of every main loop iteration. Closes the window when it is
+  *        due.
+  * @par Parameters: None
+  * @retval None
+  *****************************************************************************/
+void Load_Loop(void)
+{
+    unsigned short micros = Sched_GetMicros();
+    unsigned long now = Sched_GetTime();
+    unsigned short period = micros - loopMicros;
+    unsigned char bin = 0;
+    
+    if(now - loopTime >= LOAD_WRAP_MS)
+    {
+        period = LOAD_PERIOD_MAX;
+    }
+    
+    loopMicros = micros;
+    loopTime = now;
+    
+    if(!loopStarted)
+    {
+        loopStarted = 1;
+        windowStart = now;
+        return;
+    }
+    
+    if(loopCount < 0xFFFF)
+    {
+        loopCount++;
+    }
+    
+    if(period < periodMin)
+    {
+        periodMin = period;
+    }
+    
+    if(period > periodMax)
+    {
+        periodMax = period;
+    }
+    
+    while(bin < LOAD_BINS - 1 && period >= ((unsigned short)LOAD_BIN_BASE << bin))
+    {
+        bin++;
+    }
+    
+    if(periodBins[bin] < 0xFFFF)
+    {
+        periodBins[bin]++;
+    }
+    
+    if(now - windowStart >= LOAD_WINDOW)
+    {
+        Load_Close(now);
+    }
+}
+
+/*******************************************************************************
+  * @brief Sleep until the next interrupt, counting the time asleep. Call in
+  *        place of the main loop's wfi.
+  * @par Parameters: None
+  * @retval None
+  *****************************************************************************/
+void Load_Sleep(void)
+{
+    unsigned short start = Sched_GetMicros();
+    
+    //The tick wakes the loop every ms, well inside the microsecond count
+    wfi();
+    
+    sleepMicros += (unsigned short)(Sched_GetMicros() - start);
+}
+
+/*******************************************************************************
+  * @brief Check if a window's report is waiting to be sent
+  * @par Parameters: None
+  * @retval 1 if a report is waiting, 0 otherwise
+  *****************************************************************************/
+int Load_IsPending(void)
+{
+    return loadPending;
+}
+
+/*******************************************************************************
+  * @brief Write the report of the last window closed. It stays pending until
+  *        Load_Release, so a report that cannot be queued is sent again.
+  * @par Parameters:
+  * report - buffer of LOAD_REPORT_SIZE bytes
+  * @retval report length in bytes
+  *****************************************************************************/
+unsigned char Load_GetReport(unsigned char *report)
+{
+    unsigned char i = 0;
+    
+    for(i = 0; i < LOAD_REPORT_SIZE; i++)
+    {
+        report[i] = loadReport[i];
+    }
+    
+    return LOAD_REPORT_SIZE;
+}
+
+/*******************************************************************************
+  * @brief Mark the last report sent
+  * @par Parameters: None
+  * @retval None
+  *****************************************************************************/
+void Load_Release(void)
+{
+    loadPending = 0;
+}
+
+/*******************************************************************************
+  * @brief Close the window, its report replaces any not yet sent, and start
+  *        the next
+  * @par Parameters:
+  * now - time in ms
+  * @retval None
+  *****************************************************************************/
+void Load_Close(unsigned long now)
+{
+    unsigned short elapsed = (unsigned short)(now - windowStart);
+    unsigned short asleep = (unsigned short)(sleepMicros / elapsed);
+    unsigned short below = 0;
+    unsigned short p99 = periodMax;
+    unsigned char i = 0;
+    
+    //The 99th percentile is the top of the bin that takes the count past
+    //99% of the loops, the last bin has no top
+    for(i = 0; i < LOAD_BINS - 1; i++)
+    {
+        below += periodBins[i];
+    
+        if(below >= loopCount - (loopCount / 100))
+        {
+            if(((unsigned short)LOAD_BIN_BASE << i) < periodMax)
+            {
+                p99 = (unsigned short)LOAD_BIN_BASE << i;
+            }
+            break;
+        }
+    }
+    
+    Load_PutShort(&loadReport[0], (asleep < 1000) ? 1000 - asleep : 0);
+    Load_PutShort(&loadReport[2], loopCount);
+    Load_PutShort(&loadReport[4], (loopCount > 0) ? periodMin : 0);
+    Load_PutShort(&loadReport[6], p99);
+    Load_PutShort(&loadReport[8], periodMax);
+    loadPending = 1;
+    
+    windowStart = now;
+    sleepMicros = 0;
+    loopCount = 0;
+    periodMin = LOAD_PERIOD_MAX;
+    periodMax = 0;
+    
+    for(i = 0; i < LOAD_BINS; i++)
+    {
+        periodBins[i] = 0;
+    }
+}
+
+/*******************************************************************************
+  * @brief Write a 16-bit value to a report, LSB first
+  * @par Parameters:
+  * report - where the value goes
+  * value - the value
+  * @retval None
+  *****************************************************************************/
+void Load_PutShort(unsigned char *report, unsigned short value)
+{
+    report[0] = (unsigned char)value;
+    report[1] = (unsigned char)(value >> 8);
+}
+
+#endif
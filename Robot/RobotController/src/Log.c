@@ -0,0 +1,140 @@
+/*******************************************************************************
+  * @file Log.c
+  * @brief Implements the event log. Writing a record is a masked copy of up
+  *        to 7 bytes into a ring, nothing is formatted on the robot. Batches
+  *        are taken from the ring only once they are queued to go, so a
+  *        congested link drops new records rather than ones in flight.
+  * @author David Sharpe
+  * @version V1.0.0
+  * @date 14-October-2026
+  *
+  * ST Visual Develop 4.2.1 using STM8 Cosmic C Compiler
+  *****************************************************************************/
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Includes
+////////////////////////////////////////////////////////////////////////////////
+#include "Log.h"
+#include "Ring.h"
+#include "Scheduler.h"
+
+#if LOG_ENABLE
+
+////////////////////////////////////////////////////////////////////////////////
+// Variables
+////////////////////////////////////////////////////////////////////////////////
+RING_DEFINE(logRing, LOG_SIZE);
+
+//Records lost to a full ring, and the part of the ring and the losses in the
+//last report
+unsigned char logDropped = 0;
+unsigned char logReportBytes = 0;
+unsigned char logReportDropped = 0;
+
+
+/*******************************************************************************
+  * @brief Add a record, called through the LOG macros. The record is dropped
+  *        if the ring does not have room for all of it.
+  * @par Parameters:
+  * header - LOG_HEADER of the id and the argument count
+  * a, b, c - arguments, only the first count are kept
+  * @retval None
+  *****************************************************************************/
+void Log_Write(unsigned char header, unsigned short a, unsigned short b,
+               unsigned short c)
+{
+    unsigned char record[LOG_RECORD_MAX];
+    unsigned char cc = 0;
+
+    record[0] = header;
+    record[1] = (unsigned char)a;
+    record[2] = (unsigned char)(a >> 8);
+    record[3] = (unsigned char)b;
+    record[4] = (unsigned char)(b >> 8);
+    record[5] = (unsigned char)c;
+    record[6] = (unsigned char)(c >> 8);
+
+    //An interrupt may log too, only one producer at a time
+    maskInterrupts(cc);
+
+    if(!Ring_Write(&logRing, record, 1 + ((header >> 6) * 2)) &&
+       logDropped < 0xFF)
+    {
+        logDropped++;
+    }
+
+    restoreInterrupts(cc);
+}
+
+/*******************************************************************************
+  * @brief Check for records or losses not sent yet
+  * @par Parameters: None
+  * @retval 1 if there is something to report, 0 otherwise
+  *****************************************************************************/
+int Log_IsPending(void)
+{
+    return Ring_Count(&logRing) != 0 || logDropped != 0;
+}
+
+/*******************************************************************************
+  * @brief Write a batch of the oldest records. They stay in the ring until
+  *        Log_Release, so a batch that cannot be queued is sent again.
+  * @par Parameters:
+  * report - buffer of at least LOG_REPORT_SIZE bytes
+  * @retval report length in bytes
+  *****************************************************************************/
+unsigned char Log_GetReport(unsigned char *report)
+{
+    unsigned char count = Ring_Count(&logRing);
+    unsigned char size = 0;
+    unsigned char i = 0;
+
+    logReportDropped = logDropped;
+    logReportBytes = 0;
+
+    //Records are written whole so the count always ends on one
+    while(logReportBytes < count)
+    {
+        size = 1 + ((Ring_PeekAt(&logRing, logReportBytes) >> 6) * 2);
+
+        if(logReportBytes + size > LOG_BATCH_SIZE)
+        {
+            break;
+        }
+
+        for(i = 0; i < size; i++)
+        {
+            report[1 + logReportBytes + i] =
+                Ring_PeekAt(&logRing, logReportBytes + i);
+        }
+
+        logReportBytes += size;
+    }
+
+    report[0] = logReportDropped;
+
+    return 1 + logReportBytes;
+}
+
+/*******************************************************************************
+  * @brief Remove the records and losses in the last report from the log, once
+  *        it has been queued to send
+  * @par Parameters: None
+  * @retval None
+  *****************************************************************************/
+void Log_Release(void)
+{
+    unsigned char cc = 0;
+
+    Ring_Discard(&logRing, logReportBytes);
+    logReportBytes = 0;
+
+    maskInterrupts(cc);
+    logDropped -= logReportDropped;
+    restoreInterrupts(cc);
+
+    logReportDropped = 0;
+}
+
+#endif
@@ -0,0 +1,145 @@
+/*******************************************************************************
+  * @file Memory.c
+  * @brief Implements the RAM budget report. The free stack is painted at
+  *        start up and the high-water mark is the lowest byte that no longer
+  *        holds the paint. A pushed byte that happens to equal the paint
+  *        reads as free, so the peak can be low by a byte or two but never
+  *        high. The buffer sizes are worked out at compile time and kept in
+  *        flash.
+  * @author David Sharpe
+  * @version V1.0.0
+  * @date 14-October-2026
+  *
+  * ST Visual Develop 4.2.1 using STM8 Cosmic C Compiler
+  *****************************************************************************/
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Includes
+////////////////////////////////////////////////////////////////////////////////
+#include "Memory.h"
+#include "Config.h"
+#include "Esp8266.h"
+#include "Log.h"
+#include "Pool.h"
+#include "Profile.h"
+#include "Scheduler.h"
+#include "Sequencer.h"
+#include "Telemetry.h"
+#include "TouchPanel.h"
+#include "Trace.h"
+#include "Uart.h"
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Variables
+////////////////////////////////////////////////////////////////////////////////
+
+//Bytes of each buffer, see MemoryBuffer
+const unsigned short MEMORY_BUDGET[MEMORY_BUFFER_COUNT] =
+{
+    UART_BUFFER_SIZE + UART_IDLE_MARKS,
+    UART_TX_BUFFER_SIZE,
+    (ESP8266_RX_PACKET_COUNT * ESP8266_RX_BUFFER_SIZE) + ESP8266_RX_PRIORITY_SIZE,
+    POOL_BLOCK_COUNT * POOL_BLOCK_SIZE,
+    ESP8266_BULK_BUFFER_SIZE,
+    ESP8266_CMD_QUEUE_SIZE * sizeof(AtCommand) + 
+    ESP8266_EVENT_COUNT * sizeof(Esp8266Event),
+    TELEMETRY_RING_SIZE * TELEMETRY_SAMPLE_SIZE,
+#if TRACE_ENABLE
+    TRACE_SIZE * sizeof(TraceEvent),
+#else
+    0,
+#endif
+#if LOG_ENABLE
+    LOG_SIZE,
+#else
+    0,
+#endif
+    SEQUENCER_MAX_STEPS * sizeof(SeqStep),
+    SCHED_MAX_TASKS * sizeof(SchedTask),
+    sizeof(ConfigRecord),
+#if PROFILE_ENABLE
+    PROFILE_POINT_COUNT * (sizeof(unsigned short) + sizeof(ProfileStat)),
+#else
+    0,
+#endif
+    NUMBER_OF_SINGLE_CHANNEL_KEYS * sizeof(Single_Channel_Complete_Info_T) +
+#if NUMBER_OF_MULTI_CHANNEL_KEYS > 0
+    NUMBER_OF_MULTI_CHANNEL_KEYS * sizeof(sMCKeyInfo[0]) +
+#endif
+    TOUCH_STATE_COUNT
+};
+
+
+/*******************************************************************************
+  * @brief Paint the stack below the caller's frame. Call first thing at
+  *        start up, nothing below it is in use yet.
+  * @par Parameters: None
+  * @retval None
+  *****************************************************************************/
+void Memory_PaintStack(void)
+{
+    unsigned char here = 0;
+    unsigned char *bottom = MEMORY_STACK_BOTTOM;
+    unsigned char *top = MEMORY_STACK_BOTTOM + MEMORY_STACK_SIZE;
+    unsigned char *end = &here;
+
+    //Off the stack region only in the host build, which paints the whole
+    //stand-in
+    if(end < bottom || end > top)
+    {
+        end = top + MEMORY_PAINT_MARGIN;
+    }
+
+    while(bottom + MEMORY_PAINT_MARGIN < end)
+    {
+        *bottom++ = MEMORY_PAINT;
+    }
+}
+
+/*******************************************************************************
+  * @brief Get the most stack used since start up. Scans up from the bottom
+  *        of the stack, so it is for reports rather than a fast path.
+  * @par Parameters: None
+  * @retval bytes used
+  *****************************************************************************/
+unsigned short Memory_GetStackPeak(void)
+{
+    const unsigned char *bottom = MEMORY_STACK_BOTTOM;
+    unsigned short unused = 0;
+
+    while(unused < MEMORY_STACK_SIZE && bottom[unused] == MEMORY_PAINT)
+    {
+        unused++;
+    }
+
+    return MEMORY_STACK_SIZE - unused;
+}
+
+/*******************************************************************************
+  * @brief Write the budget report
+  * @par Parameters:
+  * report - buffer of MEMORY_REPORT_SIZE bytes
+  * @retval report length in bytes
+  *****************************************************************************/
+unsigned char Memory_GetReport(unsigned char *report)
+{
+    unsigned short peak = Memory_GetStackPeak();
+    unsigned char length = 5;
+    unsigned char i = 0;
+
+    report[0] = (unsigned char)MEMORY_STACK_SIZE;
+    report[1] = (unsigned char)(MEMORY_STACK_SIZE >> 8);
+    report[2] = (unsigned char)peak;
+    report[3] = (unsigned char)(peak >> 8);
+    report[4] = MEMORY_BUFFER_COUNT;
+
+    for(i = 0; i < MEMORY_BUFFER_COUNT; i++)
+    {
+        report[length++] = (unsigned char)MEMORY_BUDGET[i];
+        report[length++] = (unsigned char)(MEMORY_BUDGET[i] >> 8);
+    }
+
+    return length + Pool_GetReport(&report[length]);
+}
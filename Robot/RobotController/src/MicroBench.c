@@ -0,0 +1,284 @@
+/*******************************************************************************
+  * @file MicroBench.c
+  * @brief Implements the microbenchmarks. A kernel times its own batch so 
+  *        any setup or clean up it needs stays out of the count, and the 
+  *        run leaves the state it touched as it found it. The parser is fed
+  *        a datagram only while the module is quiet, and the duty math runs
+  *        only while the robot is stopped, which is how it is left.
+  * @author David Sharpe
+  * @version V1.0.0
+  * @date 14-October-2026
+  *
+  * ST Visual Develop 4.2.1 using STM8 Cosmic C Compiler
+  *****************************************************************************/
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Includes
+////////////////////////////////////////////////////////////////////////////////
+#include "MicroBench.h"
+#include "CmdBuilder.h"
+#include "DriveController.h"
+#include "Esp8266.h"
+#include "Ring.h"
+
+#if MICRO_ENABLE
+
+////////////////////////////////////////////////////////////////////////////////
+// Definitions
+////////////////////////////////////////////////////////////////////////////////
+#define MICRO_RING_SIZE     16
+#define MICRO_CMD_SIZE      24
+
+//Times a batch, returns the counts it took
+typedef unsigned short(*MicroFunc)(void);
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Prototypes
+////////////////////////////////////////////////////////////////////////////////
+unsigned short RingBatch(void);
+unsigned short FifoBatch(void);
+unsigned short IpdBatch(void);
+unsigned short SpeedBatch(void);
+unsigned short CmdBatch(void);
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Variables
+////////////////////////////////////////////////////////////////////////////////
+const MicroFunc MICRO_KERNELS[MICRO_KERNEL_COUNT] =
+{
+    RingBatch, FifoBatch, IpdBatch, SpeedBatch, CmdBatch
+};
+
+//Calls in each kernel's batch
+const unsigned char MICRO_KERNEL_CALLS[MICRO_KERNEL_COUNT] =
+{
+    MICRO_CALLS, MICRO_CALLS, 1, MICRO_CALLS, MICRO_CALLS
+};
+
+//A keepalive as the module hands it over
+#if ESP8266_PEER_DISCOVERY
+const char MICRO_IPD[] = "+IPD,1,7,192.168.4.2,49999:\xA5\x10\x00\x02\x09\x00\x59";
+#else
+const char MICRO_IPD[] = "+IPD,1,7:\xA5\x10\x00\x02\x09\x00\x59";
+#endif
+
+//The UART receive FIFO is a ring named directly
+RING_DEFINE_TINY(microFifo, MICRO_RING_SIZE);
+
+//Read back so the reads are not optimized away
+volatile unsigned char microSink = 0;
+
+//Results in cycles per call, 0 for a kernel that did not run
+unsigned short microMin[MICRO_KERNEL_COUNT];
+unsigned short microMean[MICRO_KERNEL_COUNT];
+
+
+/*******************************************************************************
+  * @brief Run every kernel and keep the results for the report. Blocks for 
+  *        a few ms, well inside the watchdog timeout.
+  * @par Parameters: None
+  * @retval None
+  *****************************************************************************/
+void Micro_Run(void)
+{
+    unsigned char kernel = 0;
+    unsigned char batch = 0;
+    unsigned long sum = 0;
+    unsigned short cycles = 0;
+    
+    for(kernel = 0; kernel < MICRO_KERNEL_COUNT; kernel++)
+    {
+        microMin[kernel] = 0;
+        microMean[kernel] = 0;
+        
+        //The SPI link has no +IPD parser to time
+        if((kernel == MICRO_ESP_IPD && (ESP8266_SPI_LINK || !Esp8266_IsRxIdle())) ||
+           (kernel == MICRO_DRIVE_SPEED && DriveCtrl_IsMoving()))
+        {
+            continue;
+        }
+        
+        sum = 0;
+        
+        for(batch = 0; batch < MICRO_BATCHES; batch++)
+        {
+            cycles = (unsigned short)(((unsigned long)MICRO_KERNELS[kernel]() * 
+                                       MICRO_CYCLES_PER_COUNT) / 
+                                      MICRO_KERNEL_CALLS[kernel]);
+            sum += cycles;
+            
+            if(batch == 0 || cycles < microMin[kernel])
+            {
+                microMin[kernel] = cycles;
+            }
+        }
+        
+        microMean[kernel] = (unsigned short)(sum / MICRO_BATCHES);
+    }
+}
+
+/*******************************************************************************
+  * @brief Write the results of the last run
+  * @par Parameters:
+  * report - buffer of MICRO_REPORT_SIZE bytes
+  * @retval report length in bytes
+  *****************************************************************************/
+unsigned char Micro_GetReport(unsigned char *report)
+{
+    unsigned char length = 1;
+    unsigned char i = 0;
+    
+    report[0] = MICRO_KERNEL_COUNT;
+    
+    for(i = 0; i < MICRO_KERNEL_COUNT; i++)
+    {
+        report[length++] = (unsigned char)microMin[i];
+        report[length++] = (unsigned char)(microMin[i] >> 8);
+        report[length++] = (unsigned char)microMean[i];
+        report[length++] = (unsigned char)(microMean[i] >> 8);
+    }
+    
+    return length;
+}
+
+/*******************************************************************************
+  * @brief Put a byte in a ring and take it back out through the functions
+  * @par Parameters: None
+  * @retval counts taken
+  *****************************************************************************/
+unsigned short RingBatch(void)
+{
+    unsigned char buffer[MICRO_RING_SIZE];
+    Ring ring;
+    unsigned char byte = 0;
+    unsigned char i = 0;
+    unsigned short start = 0;
+    
+    ring.buffer = buffer;
+    ring.mask = MICRO_RING_SIZE - 1;
+    ring.head = 0;
+    ring.tail = 0;
+    
+    start = MICRO_CLOCK();
+    
+    for(i = 0; i < MICRO_CALLS; i++)
+    {
+        Ring_Put(&ring, i);
+        Ring_Get(&ring, &byte);
+    }
+    
+    start = MICRO_CLOCK() - start;
+    microSink = byte;
+    
+    return start;
+}
+
+/*******************************************************************************
+  * @brief Put a byte in a ring named directly and take it back out, the 
+  *        steps the UART receive interrupt and reader take
+  * @par Parameters: None
+  * @retval counts taken
+  *****************************************************************************/
+unsigned short FifoBatch(void)
+{
+    unsigned char byte = 0;
+    unsigned char i = 0;
+    unsigned short start = MICRO_CLOCK();
+    
+    for(i = 0; i < MICRO_CALLS; i++)
+    {
+        RING_PUT(microFifo, MICRO_RING_SIZE, i);
+        RING_GET(microFifo, MICRO_RING_SIZE, byte);
+    }
+    
+    start = MICRO_CLOCK() - start;
+    microSink = byte;
+    
+    return start;
+}
+
+/*******************************************************************************
+  * @brief Parse a datagram from its +IPD header, then drop the packet 
+  * @par Parameters: None
+  * @retval counts taken
+  *****************************************************************************/
+unsigned short IpdBatch(void)
+{
+    const unsigned char *packet = 0;
+    unsigned short start = MICRO_CLOCK();
+    
+#if !ESP8266_SPI_LINK
+    unsigned char i = 0;
+    
+    for(i = 0; i < sizeof(MICRO_IPD) - 1; i++)
+    {
+        Esp8266_ProcessRxByte((unsigned char)MICRO_IPD[i]);
+    }
+#endif
+    
+    start = MICRO_CLOCK() - start;
+    
+    if(Esp8266_AcquirePacket(&packet))
+    {
+        Esp8266_ReleasePacket();
+    }
+    
+    return start;
+}
+
+/*******************************************************************************
+  * @brief Scale the forward targets through the speeds, then stop again
+  * @par Parameters: None
+  * @retval counts taken
+  *****************************************************************************/
+unsigned short SpeedBatch(void)
+{
+    unsigned char i = 0;
+    unsigned short start = 0;
+    
+    DriveCtrl_Forward();
+    start = MICRO_CLOCK();
+    
+    for(i = 0; i < MICRO_CALLS; i++)
+    {
+        DriveCtrl_SetSpeed(i * (SPEED_FULL / MICRO_CALLS));
+    }
+    
+    start = MICRO_CLOCK() - start;
+    
+    //Nothing has driven the wheels yet, the drive update runs after
+    DriveCtrl_Stop();
+    DriveCtrl_SetSpeed(0);
+    
+    return start;
+}
+
+/*******************************************************************************
+  * @brief Build the AT+CIPSEND command for a datagram
+  * @par Parameters: None
+  * @retval counts taken
+  *****************************************************************************/
+unsigned short CmdBatch(void)
+{
+    unsigned char buffer[MICRO_CMD_SIZE];
+    CmdBuilder cmd;
+    unsigned char i = 0;
+    unsigned short start = MICRO_CLOCK();
+    
+    for(i = 0; i < MICRO_CALLS; i++)
+    {
+        Cmd_Begin(&cmd, buffer, sizeof(buffer));
+        Cmd_AppendText(&cmd, "AT+CIPSEND=");
+        Cmd_AppendUnsigned(&cmd, 1);
+        Cmd_AppendChar(&cmd, ',');
+        Cmd_AppendUnsigned(&cmd, i + 9);
+        microSink = Cmd_End(&cmd);
+    }
+    
+    return MICRO_CLOCK() - start;
+}
+
+#endif
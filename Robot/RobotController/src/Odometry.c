@@ -0,0 +1,292 @@
+/*******************************************************************************
+  * @file Odometry.c
+  * @brief Implements the wheel odometry. The edges each wheel saw since the
+  *        last update are turned into travel and the pose is advanced along
+  *        the mean heading of the step. Everything is fixed point: positions
+  *        are um in 32 bits, headings are binary angles and the trig comes
+  *        from a quarter wave sine table with linear interpolation. The
+  *        encoders have a single channel, so each wheel's direction is taken
+  *        from the duty applied to it, and from the last nonzero duty while
+  *        the wheel coasts.
+  * @author David Sharpe
+  * @version V1.0.0
+  * @date 14-October-2026
+  *
+  * ST Visual Develop 4.2.1 using STM8 Cosmic C Compiler
+  *****************************************************************************/
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Includes
+////////////////////////////////////////////////////////////////////////////////
+#include "Odometry.h"
+#include "DriveController.h"
+#include "Encoder.h"
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Definitions
+////////////////////////////////////////////////////////////////////////////////
+#define SIN_TABLE_STEPS     64  //entries per quarter turn, less the last
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Prototypes
+////////////////////////////////////////////////////////////////////////////////
+signed long WheelTravel(unsigned char encoder, unsigned char motor);
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Variables
+////////////////////////////////////////////////////////////////////////////////
+
+//Sine of the first quarter turn in Q14, one entry per 256 heading units
+const unsigned short SIN_TABLE[SIN_TABLE_STEPS + 1] =
+{
+        0,   402,   804,  1205,  1606,  2006,  2404,  2801,
+     3196,  3590,  3981,  4370,  4756,  5139,  5520,  5897,
+     6270,  6639,  7005,  7366,  7723,  8076,  8423,  8765,
+     9102,  9434,  9760, 10080, 10394, 10702, 11003, 11297,
+    11585, 11866, 12140, 12406, 12665, 12916, 13160, 13395,
+    13623, 13842, 14053, 14256, 14449, 14635, 14811, 14978,
+    15137, 15286, 15426, 15557, 15679, 15791, 15893, 15986,
+    16069, 16143, 16207, 16261, 16305, 16340, 16364, 16379,
+    16384
+};
+
+//Pose in um and heading units
+signed long poseX = 0;
+signed long poseY = 0;
+unsigned short heading = 0;
+
+//Heading change below one unit, Q16, kept so slow turns do not drift
+signed long headingFraction = 0;
+
+//Distance along the path and heading change, neither wraps
+signed long travel = 0;
+signed long rotation = 0;
+
+//Edge counts at the last update and the direction each wheel last turned
+unsigned short lastCount[ENCODER_COUNT];
+signed char wheelDir[ENCODER_COUNT];
+
+
+/*******************************************************************************
+  * @brief Initialize the odometry at the origin facing along x. The encoders
+  *        must have been initialized.
+  * @par Parameters: None
+  * @retval None
+  *****************************************************************************/
+void Odometry_Initialize(void)
+{
+    wheelDir[ENCODER_LEFT] = 1;
+    wheelDir[ENCODER_RIGHT] = 1;
+
+    Odometry_Reset();
+}
+
+/*******************************************************************************
+  * @brief Move the origin to where the robot is now, facing along x
+  * @par Parameters: None
+  * @retval None
+  *****************************************************************************/
+void Odometry_Reset(void)
+{
+    lastCount[ENCODER_LEFT] = Encoder_GetCount(ENCODER_LEFT);
+    lastCount[ENCODER_RIGHT] = Encoder_GetCount(ENCODER_RIGHT);
+
+    poseX = 0;
+    poseY = 0;
+    heading = 0;
+    headingFraction = 0;
+    travel = 0;
+    rotation = 0;
+}
+
+/*******************************************************************************
+  * @brief Advance the pose by the wheel travel since the last call. Called
+  *        from DriveCtrl_Update every DRIVE_UPDATE_PERIOD ms. The products
+  *        stay in 32 bits up to 2500 edges/s per wheel, well above
+  *        DRIVE_VELOCITY_MAX.
+  * @par Parameters: None
+  * @retval None
+  *****************************************************************************/
+void Odometry_Update(void)
+{
+    signed long left = WheelTravel(ENCODER_LEFT, MOTOR_LEFT);
+    signed long right = WheelTravel(ENCODER_RIGHT, MOTOR_RIGHT);
+    signed long center = 0;
+    signed short turn = 0;
+    unsigned short mean = 0;
+
+    if(left == 0 && right == 0)
+    {
+        return;
+    }
+
+    center = (left + right) >> 1;
+
+    //Whole heading units, the rest is carried to the next update
+    headingFraction += (right - left) * (signed long)ODOMETRY_TURN_SCALE;
+    turn = (signed short)(headingFraction >> 16);
+    headingFraction -= (signed long)turn << 16;
+
+    //Moving along the mean heading of the step follows an arc closely
+    mean = heading + (turn >> 1);
+    poseX += (center * Odometry_Cos(mean)) >> 14;
+    poseY += (center * Odometry_Sin(mean)) >> 14;
+
+    heading += turn;
+    travel += center;
+    rotation += turn;
+}
+
+/*******************************************************************************
+  * @brief Get the distance travelled along the path since the reset, going
+  *        backward counts down
+  * @par Parameters: None
+  * @retval distance in um
+  *****************************************************************************/
+signed long Odometry_GetTravel(void)
+{
+    return travel;
+}
+
+/*******************************************************************************
+  * @brief Get the heading change since the reset without wrapping, so whole
+  *        turns are counted
+  * @par Parameters: None
+  * @retval heading change, ODOMETRY_HEADING_TURN per counterclockwise turn
+  *****************************************************************************/
+signed long Odometry_GetRotation(void)
+{
+    return rotation;
+}
+
+/*******************************************************************************
+  * @brief Get the heading
+  * @par Parameters: None
+  * @retval binary angle, 0 along x and counterclockwise
+  *****************************************************************************/
+unsigned short Odometry_GetHeading(void)
+{
+    return heading;
+}
+
+/*******************************************************************************
+  * @brief Get the position along x
+  * @par Parameters: None
+  * @retval distance from the origin in mm
+  *****************************************************************************/
+signed long Odometry_GetX(void)
+{
+    return poseX / 1000;
+}
+
+/*******************************************************************************
+  * @brief Get the position along y
+  * @par Parameters: None
+  * @retval distance from the origin in mm
+  *****************************************************************************/
+signed long Odometry_GetY(void)
+{
+    return poseY / 1000;
+}
+
+/*******************************************************************************
+  * @brief Get the sine of a binary angle, interpolated between the table
+  *        entries
+  * @par Parameters:
+  * angle - binary angle, 65536 to the turn
+  * @retval sine in Q14
+  *****************************************************************************/
+signed short Odometry_Sin(unsigned short angle)
+{
+    unsigned short offset = angle & 0x3FFF;
+    unsigned char index = 0;
+    unsigned char fraction = 0;
+    signed short value = 0;
+
+    //The second and fourth quarters mirror the table
+    if(angle & 0x4000)
+    {
+        offset = 0x4000 - offset;
+    }
+
+    index = (unsigned char)(offset >> 8);
+    fraction = (unsigned char)offset;
+
+    if(index == SIN_TABLE_STEPS)
+    {
+        value = ODOMETRY_SIN_ONE;
+    }
+    else
+    {
+        //Steps are at most 402, 7 bits of fraction keep the product in 16
+        value = SIN_TABLE[index] + (signed short)(((unsigned short)
+                (SIN_TABLE[index + 1] - SIN_TABLE[index]) * (fraction >> 1)) >> 7);
+    }
+
+    //The second half turn is negative
+    return (angle & 0x8000) ? -value : value;
+}
+
+/*******************************************************************************
+  * @brief Get the cosine of a binary angle
+  * @par Parameters:
+  * angle - binary angle, 65536 to the turn
+  * @retval cosine in Q14
+  *****************************************************************************/
+signed short Odometry_Cos(unsigned short angle)
+{
+    return Odometry_Sin(angle + 0x4000);
+}
+
+/*******************************************************************************
+  * @brief Write the pose report
+  * @par Parameters:
+  * report - buffer of ODOMETRY_REPORT_SIZE bytes
+  * @retval report length in bytes
+  *****************************************************************************/
+unsigned char Odometry_GetReport(unsigned char *report)
+{
+    signed short x = (signed short)(poseX / 1000);
+    signed short y = (signed short)(poseY / 1000);
+
+    report[0] = (unsigned char)x;
+    report[1] = (unsigned char)((unsigned short)x >> 8);
+    report[2] = (unsigned char)y;
+    report[3] = (unsigned char)((unsigned short)y >> 8);
+    report[4] = (unsigned char)heading;
+    report[5] = (unsigned char)(heading >> 8);
+
+    return ODOMETRY_REPORT_SIZE;
+}
+
+/*******************************************************************************
+  * @brief Get the distance a wheel travelled since the last call
+  * @par Parameters:
+  * encoder - ENCODER_LEFT or ENCODER_RIGHT
+  * motor - MOTOR_LEFT or MOTOR_RIGHT, the motor turning the wheel
+  * @retval distance in um, negative backward
+  *****************************************************************************/
+signed long WheelTravel(unsigned char encoder, unsigned char motor)
+{
+    unsigned short count = Encoder_GetCount(encoder);
+    signed short edges = (signed short)(count - lastCount[encoder]);
+    signed char duty = DriveCtrl_GetDuty(motor);
+
+    lastCount[encoder] = count;
+
+    if(duty != 0)
+    {
+        wheelDir[encoder] = (duty > 0) ? 1 : -1;
+    }
+
+    if(wheelDir[encoder] < 0)
+    {
+        edges = -edges;
+    }
+
+    return (signed long)edges * ODOMETRY_UM_PER_EDGE;
+}
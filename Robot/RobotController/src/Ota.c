@@ -0,0 +1,528 @@
+/*******************************************************************************
+  * @file Ota.c
+  * @brief Implements the firmware update over the control link. Chunks are
+  *        gathered into a block buffer in order and each full block is
+  *        programmed into the staging region with FLASH_ProgramBlock, run
+  *        from RAM as the library requires, then read back. The CRC-16 of
+  *        the image is kept as the chunks arrive and checked at the end,
+  *        and only then is the staging header written for the boot copier.
+  *
+  *        The block write stalls the CPU for a few ms with interrupts off,
+  *        so it waits until the module has nothing in progress, up to
+  *        OTA_WRITE_WAIT.
+  * @author David Sharpe
+  * @version V1.0.0
+  * @date 14-October-2026
+  *
+  * ST Visual Develop 4.2.1 using STM8 Cosmic C Compiler
+  *****************************************************************************/
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Includes
+////////////////////////////////////////////////////////////////////////////////
+#include "Ota.h"
+#include "Esp8266.h"
+#include "Log.h"
+#include "Scheduler.h"
+#include "Uart.h"
+#include <string.h>
+
+#if OTA_ENABLE
+
+////////////////////////////////////////////////////////////////////////////////
+// Definitions
+////////////////////////////////////////////////////////////////////////////////
+#define OTA_CRC16_POLY      0x1021 //CRC-16/CCITT-FALSE
+#define OTA_CRC16_INIT      0xFFFF
+#define OTA_BLOCK_MASK      (OTA_BLOCK_SIZE - 1)
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Prototypes
+////////////////////////////////////////////////////////////////////////////////
+unsigned char Ota_Flush(void);
+int  Ota_WriteBlock(unsigned long address, unsigned char *data);
+void Ota_ClearHeader(void);
+void Ota_Fail(unsigned char result);
+
+#if defined(_COSMIC_) && defined(RAM_EXECUTION)
+//Cosmic library, copies the FLASH_CODE segment to RAM
+int _fctcpy(char name);
+#endif
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Variables
+////////////////////////////////////////////////////////////////////////////////
+unsigned char otaState = OTA_IDLE;
+unsigned char otaError = OTA_OK;    //Failure reported to the next chunk
+unsigned short otaLength = 0;
+unsigned short otaCrc = 0;          //CRC-16 the image is to have
+unsigned short otaRunCrc = 0;       //CRC-16 of the chunks taken
+unsigned short otaNext = 0;         //Offset of the next chunk
+unsigned char otaEnding = 0;        //The write is the last, then the header
+unsigned char otaReplyDue = 0;
+unsigned char otaReplyResult = OTA_OK;
+unsigned long otaWaitStart = 0;
+unsigned char otaBlock[OTA_BLOCK_SIZE];
+
+
+/*******************************************************************************
+  * @brief Start with no transfer. The block programming functions are put
+  *        in RAM for the writes.
+  * @par Parameters: None
+  * @retval None
+  *****************************************************************************/
+void Ota_Initialize(void)
+{
+#if defined(_COSMIC_) && defined(RAM_EXECUTION)
+    _fctcpy('F');
+#endif
+
+    otaState = OTA_IDLE;
+    otaError = OTA_OK;
+    otaReplyDue = 0;
+}
+
+/*******************************************************************************
+  * @brief Start a transfer, dropping any transfer in progress and any image
+  *        staged and not yet applied
+  * @par Parameters:
+  * length - image length in bytes
+  * crc - CRC-16 of the image
+  * @retval OTA_OK, OTA_REFUSED while a write or the reset is pending or
+  *         OTA_TOO_BIG
+  *****************************************************************************/
+unsigned char Ota_Begin(unsigned short length, unsigned short crc)
+{
+    if(otaState == OTA_WRITING || otaState == OTA_APPLYING)
+    {
+        return OTA_REFUSED;
+    }
+
+    if(length == 0 || length > OTA_IMAGE_MAX)
+    {
+        return OTA_TOO_BIG;
+    }
+
+    Ota_ClearHeader();
+
+    otaLength = length;
+    otaCrc = crc;
+    otaRunCrc = OTA_CRC16_INIT;
+    otaNext = 0;
+    otaEnding = 0;
+    otaError = OTA_OK;
+    otaState = OTA_RECEIVING;
+
+    LOG1(LOG_OTA_BEGIN, length / OTA_BLOCK_SIZE);
+    return OTA_OK;
+}
+
+/*******************************************************************************
+  * @brief Take a chunk of the image. A chunk already taken is answered
+  *        with the next offset again, so a sender that missed the report
+  *        may repeat it.
+  * @par Parameters:
+  * offset - offset of the chunk in the image
+  * data - chunk bytes
+  * length - chunk length in bytes
+  * @retval OTA_OK, OTA_PENDING when the chunk filled a block that must be
+  *         written before the report, OTA_REFUSED with no transfer,
+  *         OTA_BAD_CHUNK or the failure that ended the transfer
+  *****************************************************************************/
+unsigned char Ota_Chunk(unsigned short offset, const unsigned char *data,
+                        unsigned char length)
+{
+    unsigned char result = OTA_OK;
+
+    //With flow control the next chunk can arrive before the block is
+    //written
+    if(otaState == OTA_WRITING && !otaEnding)
+    {
+        result = Ota_Flush();
+
+        if(result != OTA_OK)
+        {
+            return result;
+        }
+    }
+
+    if(otaState != OTA_RECEIVING)
+    {
+        return (otaError != OTA_OK) ? otaError : OTA_REFUSED;
+    }
+
+    if(offset < otaNext && offset + length <= otaNext)
+    {
+        return OTA_OK;
+    }
+
+    if(offset != otaNext || length == 0 || length > OTA_CHUNK_MAX ||
+       (unsigned long)offset + length > otaLength ||
+       (offset & OTA_BLOCK_MASK) + length > OTA_BLOCK_SIZE)
+    {
+        return OTA_BAD_CHUNK;
+    }
+
+    memcpy(&otaBlock[offset & OTA_BLOCK_MASK], data, length);
+    otaRunCrc = Ota_Crc16(otaRunCrc, data, length);
+    otaNext += length;
+
+    if((otaNext & OTA_BLOCK_MASK) != 0)
+    {
+        return OTA_OK;
+    }
+
+    otaState = OTA_WRITING;
+    otaWaitStart = Sched_GetTime();
+
+#if UART_FLOW_CONTROL
+    return OTA_OK;
+#else
+    return OTA_PENDING;
+#endif
+}
+
+/*******************************************************************************
+  * @brief End the transfer. The image is checked against its CRC, then the
+  *        last block and the staging header are written.
+  * @par Parameters: None
+  * @retval OTA_PENDING, reported once written, OTA_REFUSED with no
+  *         transfer, OTA_BAD_CHUNK if chunks are missing or OTA_BAD_IMAGE
+  *****************************************************************************/
+unsigned char Ota_End(void)
+{
+    unsigned char result = OTA_OK;
+
+    if(otaState == OTA_WRITING && !otaEnding)
+    {
+        result = Ota_Flush();
+
+        if(result != OTA_OK)
+        {
+            return result;
+        }
+    }
+
+    if(otaState != OTA_RECEIVING)
+    {
+        return (otaError != OTA_OK) ? otaError : OTA_REFUSED;
+    }
+
+    if(otaNext != otaLength)
+    {
+        return OTA_BAD_CHUNK;
+    }
+
+    if(otaRunCrc != otaCrc)
+    {
+        Ota_Fail(OTA_BAD_IMAGE);
+        return OTA_BAD_IMAGE;
+    }
+
+    //The rest of a part block reads as erased
+    if(otaNext & OTA_BLOCK_MASK)
+    {
+        memset(&otaBlock[otaNext & OTA_BLOCK_MASK], 0,
+               OTA_BLOCK_SIZE - (otaNext & OTA_BLOCK_MASK));
+    }
+
+    otaEnding = 1;
+    otaState = OTA_WRITING;
+    otaWaitStart = Sched_GetTime();
+    return OTA_PENDING;
+}
+
+/*******************************************************************************
+  * @brief Reset into the boot copier once the report has been sent
+  * @par Parameters: None
+  * @retval OTA_OK or OTA_REFUSED with no image staged
+  *****************************************************************************/
+unsigned char Ota_Apply(void)
+{
+    if(otaState != OTA_STAGED)
+    {
+        return OTA_REFUSED;
+    }
+
+    otaState = OTA_APPLYING;
+    otaWaitStart = Sched_GetTime();
+    LOG0(LOG_OTA_APPLY);
+    return OTA_OK;
+}
+
+/*******************************************************************************
+  * @brief Drop the transfer, an image already staged is kept
+  * @par Parameters: None
+  * @retval None
+  *****************************************************************************/
+void Ota_Abort(void)
+{
+    if(otaState == OTA_RECEIVING || otaState == OTA_WRITING)
+    {
+        otaState = OTA_IDLE;
+        otaReplyDue = 0;
+    }
+}
+
+/*******************************************************************************
+  * @brief Check if a transfer is under way, the wheels stay stopped while
+  *        it is
+  * @par Parameters: None
+  * @retval 1 from OTA_BEGIN to the end of the transfer or the reset
+  *****************************************************************************/
+int Ota_IsActive(void)
+{
+    return otaState == OTA_RECEIVING || otaState == OTA_WRITING ||
+           otaState == OTA_APPLYING;
+}
+
+/*******************************************************************************
+  * @brief Get the transfer state
+  * @par Parameters: None
+  * @retval OtaState value
+  *****************************************************************************/
+unsigned char Ota_GetState(void)
+{
+    return otaState;
+}
+
+/*******************************************************************************
+  * @brief Fill a report for a command
+  * @par Parameters:
+  * result - OtaResult value of the command
+  * report - buffer of OTA_REPORT_SIZE bytes
+  * @retval None
+  *****************************************************************************/
+void Ota_GetReport(unsigned char result, unsigned char *report)
+{
+    report[0] = result;
+    report[1] = otaState;
+    report[2] = (unsigned char)otaNext;
+    report[3] = (unsigned char)(otaNext >> 8);
+}
+
+/*******************************************************************************
+  * @brief Check for the report of a command answered OTA_PENDING, once its
+  *        write is done
+  * @par Parameters:
+  * result - set to the OtaResult value to report
+  * @retval 1 if the report is to be sent, 0 otherwise
+  *****************************************************************************/
+int Ota_IsReplyDue(unsigned char *result)
+{
+    if(!otaReplyDue)
+    {
+        return 0;
+    }
+
+    otaReplyDue = 0;
+    *result = otaReplyResult;
+    return 1;
+}
+
+/*******************************************************************************
+  * @brief Write the full block or reset into the boot copier, called from
+  *        the main loop. Both wait for the module to finish what it is
+  *        sending, the report first of all.
+  * @par Parameters: None
+  * @retval 1 if there was work, 0 otherwise
+  *****************************************************************************/
+int Ota_Run(void)
+{
+    int waited = Sched_GetTime() - otaWaitStart >= OTA_WRITE_WAIT;
+    unsigned char result = OTA_OK;
+
+    if(otaState == OTA_APPLYING)
+    {
+        if(Esp8266_IsBusy() && !waited)
+        {
+            return 1;
+        }
+
+        //Stop here, the watchdog resets into the boot copier
+        for(;;)
+        {
+        }
+    }
+
+    if(otaState != OTA_WRITING || (Esp8266_IsBusy() && !waited))
+    {
+        return 0;
+    }
+
+#if UART_FLOW_CONTROL
+    //Hold the module, the next chunk waits in it while the block is written.
+    //What it was already sending is taken first.
+    Uart_SetRxHold(1);
+
+    if(!Esp8266_IsRxIdle() && !waited)
+    {
+        return 1;
+    }
+#endif
+
+    result = Ota_Flush();
+
+#if UART_FLOW_CONTROL
+    Uart_SetRxHold(0);
+
+    //The block's last chunk was reported, a failure goes to the next
+    if(result == OTA_OK && otaState == OTA_RECEIVING)
+    {
+        return 1;
+    }
+#endif
+
+    otaReplyResult = result;
+    otaReplyDue = 1;
+    return 1;
+}
+
+/*******************************************************************************
+  * @brief Compute the CRC-16/CCITT-FALSE of a buffer (poly 0x1021, init
+  *        0xFFFF), continuing from an earlier part
+  * @par Parameters:
+  * crc - CRC of the bytes before, OTA_CRC16_INIT to start
+  * data - buffer
+  * length - buffer length in bytes
+  * @retval CRC-16
+  *****************************************************************************/
+unsigned short Ota_Crc16(unsigned short crc, const unsigned char *data,
+                         unsigned char length)
+{
+    unsigned char i = 0;
+    unsigned char bit = 0;
+
+    for(i = 0; i < length; i++)
+    {
+        crc ^= (unsigned short)data[i] << 8;
+
+        for(bit = 0; bit < 8; bit++)
+        {
+            crc = (crc & 0x8000) ? (crc << 1) ^ OTA_CRC16_POLY : crc << 1;
+        }
+    }
+
+    return crc;
+}
+
+/*******************************************************************************
+  * @brief Write the block waiting and, at the end of the transfer, the
+  *        staging header after it
+  * @par Parameters: None
+  * @retval OTA_OK or OTA_WRITE_FAILED
+  *****************************************************************************/
+unsigned char Ota_Flush(void)
+{
+    unsigned long address = OTA_STAGING_START +
+                            ((otaNext - 1) & ~(unsigned short)OTA_BLOCK_MASK);
+
+    //A full last block was written with its last chunk
+    if((!otaEnding || (otaNext & OTA_BLOCK_MASK)) && 
+       !Ota_WriteBlock(address, otaBlock))
+    {
+        Ota_Fail(OTA_WRITE_FAILED);
+        return OTA_WRITE_FAILED;
+    }
+
+    if(!otaEnding)
+    {
+        otaState = OTA_RECEIVING;
+        return OTA_OK;
+    }
+
+    memset(otaBlock, 0, sizeof(otaBlock));
+    otaBlock[OTA_HEADER_MAGIC] = (unsigned char)OTA_MAGIC;
+    otaBlock[OTA_HEADER_MAGIC + 1] = (unsigned char)(OTA_MAGIC >> 8);
+    otaBlock[OTA_HEADER_LENGTH] = (unsigned char)otaLength;
+    otaBlock[OTA_HEADER_LENGTH + 1] = (unsigned char)(otaLength >> 8);
+    otaBlock[OTA_HEADER_CRC] = (unsigned char)otaCrc;
+    otaBlock[OTA_HEADER_CRC + 1] = (unsigned char)(otaCrc >> 8);
+
+    if(!Ota_WriteBlock(OTA_HEADER_START, otaBlock))
+    {
+        Ota_Fail(OTA_WRITE_FAILED);
+        return OTA_WRITE_FAILED;
+    }
+
+    otaState = OTA_STAGED;
+    LOG1(LOG_OTA_STAGED, otaLength / OTA_BLOCK_SIZE);
+    return OTA_OK;
+}
+
+/*******************************************************************************
+  * @brief Program a block of program memory and read it back. Nothing may
+  *        be fetched from flash while it is written, the vectors included,
+  *        so interrupts are off from the start of the write to its end.
+  * @par Parameters:
+  * address - first byte of the block
+  * data - OTA_BLOCK_SIZE bytes to write
+  * @retval 1 if written, 0 if the write failed or reads back wrong
+  *****************************************************************************/
+int Ota_WriteBlock(unsigned long address, unsigned char *data)
+{
+    FLASH_Status_TypeDef status = FLASH_STATUS_SUCCESSFUL_OPERATION;
+    unsigned char i = 0;
+
+    FLASH_Unlock(FLASH_MEMTYPE_PROG);
+
+    disableInterrupts();
+    FLASH_ProgramBlock((unsigned short)((address - FLASH_PROG_START_PHYSICAL_ADDRESS) /
+                                        OTA_BLOCK_SIZE),
+                       FLASH_MEMTYPE_PROG, FLASH_PROGRAMMODE_STANDARD, data);
+    status = FLASH_WaitForLastOperation(FLASH_MEMTYPE_PROG);
+    enableInterrupts();
+
+    FLASH_Lock(FLASH_MEMTYPE_PROG);
+
+    if(status != FLASH_STATUS_SUCCESSFUL_OPERATION)
+    {
+        return 0;
+    }
+
+    for(i = 0; i < OTA_BLOCK_SIZE; i++)
+    {
+        if(FLASH_ReadByte(address + i) != data[i])
+        {
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
+/*******************************************************************************
+  * @brief Drop a staged image by clearing the header, only written when it
+  *        holds the magic
+  * @par Parameters: None
+  * @retval None
+  *****************************************************************************/
+void Ota_ClearHeader(void)
+{
+    if(FLASH_ReadByte(OTA_HEADER_START + OTA_HEADER_MAGIC) != (unsigned char)OTA_MAGIC ||
+       FLASH_ReadByte(OTA_HEADER_START + OTA_HEADER_MAGIC + 1) != (unsigned char)(OTA_MAGIC >> 8))
+    {
+        return;
+    }
+
+    memset(otaBlock, 0, sizeof(otaBlock));
+    Ota_WriteBlock(OTA_HEADER_START, otaBlock);
+}
+
+/*******************************************************************************
+  * @brief End the transfer on a failure
+  * @par Parameters:
+  * result - OtaResult value reported to the chunks that follow
+  * @retval None
+  *****************************************************************************/
+void Ota_Fail(unsigned char result)
+{
+    otaState = OTA_IDLE;
+    otaError = result;
+    LOG1(LOG_OTA_FAILED, result);
+}
+
+#endif
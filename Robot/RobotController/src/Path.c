@@ -0,0 +1,260 @@
+/*******************************************************************************
+  * @file Path.c
+  * @brief Implements the waypoint follower. Every PATH_PERIOD the next 
+  *        waypoint is taken into the robot's own frame, ahead and to the 
+  *        side, and the curvature of the arc through it sets the ratio of
+  *        the wheel velocities. The outer wheel runs at the path velocity
+  *        and the velocity loops hold both to their targets.
+  *
+  *        All in 32-bit integers. Offsets are held to 16 bits so the 
+  *        squares and products cannot overflow, paths stay within 32m of
+  *        the robot.
+  * @author David Sharpe
+  * @version V1.0.0
+  * @date 14-October-2026
+  *
+  * ST Visual Develop 4.2.1 using STM8 Cosmic C Compiler
+  *****************************************************************************/
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Includes
+////////////////////////////////////////////////////////////////////////////////
+#include "Path.h"
+#include "Failsafe.h"
+#include "Log.h"
+#include "Odometry.h"
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Definitions
+////////////////////////////////////////////////////////////////////////////////
+#define PATH_TRACK_MM       (ODOMETRY_TRACK_UM / 1000)
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Prototypes
+////////////////////////////////////////////////////////////////////////////////
+signed short ClampOffset(signed long value);
+unsigned short SquareRoot(unsigned long value);
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Variables
+////////////////////////////////////////////////////////////////////////////////
+PathPoint pathPoints[PATH_MAX_POINTS];
+unsigned char pathCount = 0;
+unsigned char pathNext = 0;
+unsigned short pathVelocity = 0;
+unsigned char pathRunning = 0;
+
+
+/*******************************************************************************
+  * @brief Start with no path
+  * @par Parameters: None
+  * @retval None
+  *****************************************************************************/
+void Path_Initialize(void)
+{
+    pathCount = 0;
+    pathNext = 0;
+    pathRunning = 0;
+}
+
+/*******************************************************************************
+  * @brief Load a list of waypoints and start following it, replacing any
+  *        path already running. A list with no waypoints, a part waypoint
+  *        or more than PATH_MAX_POINTS is refused whole.
+  * @par Parameters:
+  * value - velocity then waypoints, see PATH_HEADER_SIZE
+  * length - value length in bytes
+  * @retval 1 if the path was started, 0 if it was refused
+  *****************************************************************************/
+int Path_Load(const unsigned char *value, unsigned char length)
+{
+    unsigned char count = 0;
+    unsigned char i = 0;
+    const unsigned char *point = value + PATH_HEADER_SIZE;
+    unsigned short velocity = 0;
+    
+    if(length <= PATH_HEADER_SIZE || 
+       (length - PATH_HEADER_SIZE) % PATH_POINT_SIZE != 0)
+    {
+        return 0;
+    }
+    
+    count = (length - PATH_HEADER_SIZE) / PATH_POINT_SIZE;
+    velocity = (unsigned short)(value[0] | (value[1] << 8));
+    
+    if(count > PATH_MAX_POINTS || velocity == 0 || 
+       velocity > DRIVE_VELOCITY_MAX)
+    {
+        return 0;
+    }
+    
+    for(i = 0; i < count; i++, point += PATH_POINT_SIZE)
+    {
+        pathPoints[i].x = (signed short)(point[0] | (point[1] << 8));
+        pathPoints[i].y = (signed short)(point[2] | (point[3] << 8));
+    }
+    
+    pathCount = count;
+    pathNext = 0;
+    pathVelocity = velocity;
+    pathRunning = 1;
+    
+    return 1;
+}
+
+/*******************************************************************************
+  * @brief Stop following the path. The wheels are left as they are for the
+  *        command that replaces it.
+  * @par Parameters: None
+  * @retval None
+  *****************************************************************************/
+void Path_Cancel(void)
+{
+    pathRunning = 0;
+}
+
+/*******************************************************************************
+  * @brief Check if a path is being followed
+  * @par Parameters: None
+  * @retval 1 if running, 0 otherwise
+  *****************************************************************************/
+int Path_IsRunning(void)
+{
+    return pathRunning;
+}
+
+/*******************************************************************************
+  * @brief Path task, steers for the next waypoint. Runs every PATH_PERIOD 
+  *        ms.
+  * @par Parameters: None
+  * @retval None
+  *****************************************************************************/
+void Path_Task(void)
+{
+    const PathPoint *point = &pathPoints[pathNext];
+    unsigned short heading = Odometry_GetHeading();
+    signed long dx = 0;
+    signed long dy = 0;
+    signed long ahead = 0;
+    signed long side = 0;
+    unsigned long across = 0;
+    unsigned long square = 0;
+    unsigned short distance = 0;
+    signed long velocity = pathVelocity;
+    signed long turn = 0;
+    unsigned short outer = 0;
+    
+    if(!pathRunning)
+    {
+        return;
+    }
+    
+    //The remote may be quiet on purpose while the path drives
+    Failsafe_Feed();
+    
+    dx = ClampOffset((signed long)point->x - Odometry_GetX());
+    dy = ClampOffset((signed long)point->y - Odometry_GetY());
+    
+    //Into the robot's frame, Q14 sines. Each sum is within 2^30 and the 
+    //square, the same as dx and dy give, within 2^31.
+    ahead = (dx * Odometry_Cos(heading) + dy * Odometry_Sin(heading)) >> 14;
+    side = (dy * Odometry_Cos(heading) - dx * Odometry_Sin(heading)) >> 14;
+    across = (unsigned long)((side < 0) ? -side : side);
+    square = (unsigned long)(dx * dx) + (unsigned long)(dy * dy);
+    
+    if(square <= (unsigned long)PATH_RADIUS * PATH_RADIUS)
+    {
+        if(++pathNext < pathCount)
+        {
+            return;
+        }
+        
+        pathRunning = 0;
+        DriveCtrl_SetWheelDuty(0, 0);
+        LOG1(LOG_PATH_DONE, pathCount);
+        return;
+    }
+    
+    //Slow down over the last stretch so the end is not overrun
+    if(pathNext == pathCount - 1)
+    {
+        distance = SquareRoot(square);
+        
+        if(distance < PATH_SLOW_DISTANCE)
+        {
+            velocity = velocity * distance / PATH_SLOW_DISTANCE;
+            velocity = (velocity < PATH_VELOCITY_MIN) ? PATH_VELOCITY_MIN : 
+                       velocity;
+        }
+    }
+    
+    //Pure pursuit: the arc through the waypoint has curvature 
+    //2 side / square, which sets the wheel difference over the track. The
+    //product is within 2^31 before the clamp.
+    if(ahead < 0)
+    {
+        turn = (side < 0) ? -PATH_TURN_MAX : PATH_TURN_MAX;
+    }
+    else
+    {
+        turn = (signed long)((across * PATH_TRACK_MM * PATH_TURN_ONE) / square);
+        turn = (turn > PATH_TURN_MAX) ? PATH_TURN_MAX : turn;
+        turn = (side < 0) ? -turn : turn;
+    }
+    
+    //The outer wheel runs at the velocity, positive turns are to the left
+    outer = (unsigned short)(PATH_TURN_ONE + ((turn < 0) ? -turn : turn));
+    DriveCtrl_SetWheelVelocity(
+        (signed short)(velocity * (PATH_TURN_ONE - turn) / outer),
+        (signed short)(velocity * (PATH_TURN_ONE + turn) / outer));
+}
+
+/*******************************************************************************
+  * @brief Hold an offset to 16 bits
+  * @par Parameters:
+  * value - offset in mm
+  * @retval the offset, at most 32767mm either way
+  *****************************************************************************/
+signed short ClampOffset(signed long value)
+{
+    return (signed short)((value > 32767) ? 32767 : 
+                          (value < -32767) ? -32767 : value);
+}
+
+/*******************************************************************************
+  * @brief Integer square root, a bit at a time
+  * @par Parameters:
+  * value - value to take the root of
+  * @retval the root, rounded down
+  *****************************************************************************/
+unsigned short SquareRoot(unsigned long value)
+{
+    unsigned long root = 0;
+    unsigned long bit = 1UL << 30;
+    
+    while(bit > value)
+    {
+        bit >>= 2;
+    }
+    
+    while(bit != 0)
+    {
+        if(value >= root + bit)
+        {
+            value -= root + bit;
+            root = (root >> 1) + bit;
+        }
+        else
+        {
+            root >>= 1;
+        }
+        
+        bit >>= 2;
+    }
+    
+    return (unsigned short)root;
+}
@@ -0,0 +1,209 @@
+/*******************************************************************************
+  * @file Pool.c
+  * @brief Implements the block pool. Free blocks are kept on a list of
+  *        block numbers, so taking and giving back a block is a masked
+  *        couple of assignments whatever the pool size, and either is safe
+  *        from an interrupt.
+  * @author David Sharpe
+  * @version V1.0.0
+  * @date 14-October-2026
+  *
+  * ST Visual Develop 4.2.1 using STM8 Cosmic C Compiler
+  *****************************************************************************/
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Includes
+////////////////////////////////////////////////////////////////////////////////
+#include "Pool.h"
+#include "Esp8266.h"
+#include "Scheduler.h"
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Definitions
+////////////////////////////////////////////////////////////////////////////////
+
+//Most blocks each class may hold, see PoolClass. The datagram queues keep
+//one slot of their ring free, so these follow the depths of their rings.
+#define POOL_TX_QUOTA           (ESP8266_TX_PACKET_COUNT - 1)
+#define POOL_OBSERVER_QUOTA     (ESP8266_OBSERVER_COUNT - 1)
+
+#if POOL_TX_QUOTA + POOL_OBSERVER_QUOTA > POOL_BLOCK_COUNT
+#error "The pool quotas add up to more blocks than the pool has"
+#endif
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Variables
+////////////////////////////////////////////////////////////////////////////////
+const unsigned char POOL_QUOTA[POOL_CLASS_COUNT] =
+{
+    POOL_TX_QUOTA,          //POOL_TX_DATAGRAM
+    POOL_OBSERVER_QUOTA     //POOL_OBSERVER
+};
+
+//Blocks, the next free block after each free one and the class holding
+//each one in use
+unsigned char poolBlocks[POOL_BLOCK_COUNT][POOL_BLOCK_SIZE];
+unsigned char poolNext[POOL_BLOCK_COUNT];
+unsigned char poolOwner[POOL_BLOCK_COUNT];
+unsigned char poolFree = POOL_NONE;
+
+//Usage of each class
+unsigned char poolUsed[POOL_CLASS_COUNT];
+unsigned char poolPeak[POOL_CLASS_COUNT];
+unsigned char poolFailed[POOL_CLASS_COUNT];
+
+
+/*******************************************************************************
+  * @brief Put every block on the free list and clear the usage, call before
+  *        any of the users are initialised
+  * @par Parameters: None
+  * @retval None
+  *****************************************************************************/
+void Pool_Initialize(void)
+{
+    unsigned char i = 0;
+
+    for(i = 0; i < POOL_BLOCK_COUNT; i++)
+    {
+        poolNext[i] = (i + 1 < POOL_BLOCK_COUNT) ? i + 1 : POOL_NONE;
+        poolOwner[i] = POOL_NONE;
+    }
+
+    poolFree = 0;
+
+    for(i = 0; i < POOL_CLASS_COUNT; i++)
+    {
+        poolUsed[i] = 0;
+        poolPeak[i] = 0;
+        poolFailed[i] = 0;
+    }
+}
+
+/*******************************************************************************
+  * @brief Give back every block a class holds, for a user emptying its
+  *        queues without walking them
+  * @par Parameters:
+  * poolClass - PoolClass value
+  * @retval None
+  *****************************************************************************/
+void Pool_Release(unsigned char poolClass)
+{
+    unsigned char i = 0;
+
+    for(i = 0; i < POOL_BLOCK_COUNT; i++)
+    {
+        if(poolOwner[i] == poolClass)
+        {
+            Pool_Free(poolBlocks[i]);
+        }
+    }
+}
+
+/*******************************************************************************
+  * @brief Take a block
+  * @par Parameters:
+  * poolClass - PoolClass value the block is for
+  * @retval POOL_BLOCK_SIZE bytes, 0 if the class is at its quota or the pool
+  *         is empty
+  *****************************************************************************/
+unsigned char *Pool_Alloc(unsigned char poolClass)
+{
+    unsigned char index = POOL_NONE;
+    unsigned char cc = 0;
+
+    maskInterrupts(cc);
+
+    if(poolFree != POOL_NONE && poolUsed[poolClass] < POOL_QUOTA[poolClass])
+    {
+        index = poolFree;
+        poolFree = poolNext[index];
+        poolOwner[index] = poolClass;
+
+        if(++poolUsed[poolClass] > poolPeak[poolClass])
+        {
+            poolPeak[poolClass] = poolUsed[poolClass];
+        }
+    }
+    else if(poolFailed[poolClass] < 0xFF)
+    {
+        poolFailed[poolClass]++;
+    }
+
+    restoreInterrupts(cc);
+
+    return (index != POOL_NONE) ? poolBlocks[index] : 0;
+}
+
+/*******************************************************************************
+  * @brief Give back a block, one that is already free is left alone
+  * @par Parameters:
+  * block - block from Pool_Alloc
+  * @retval None
+  *****************************************************************************/
+void Pool_Free(unsigned char *block)
+{
+    unsigned char index = (unsigned char)((block - poolBlocks[0]) / POOL_BLOCK_SIZE);
+    unsigned char cc = 0;
+
+    maskInterrupts(cc);
+
+    if(index < POOL_BLOCK_COUNT && poolOwner[index] != POOL_NONE)
+    {
+        poolUsed[poolOwner[index]]--;
+        poolOwner[index] = POOL_NONE;
+        poolNext[index] = poolFree;
+        poolFree = index;
+    }
+
+    restoreInterrupts(cc);
+}
+
+/*******************************************************************************
+  * @brief Get the blocks a class holds
+  * @par Parameters:
+  * poolClass - PoolClass value
+  * @retval blocks in use
+  *****************************************************************************/
+unsigned char Pool_GetUsed(unsigned char poolClass)
+{
+    return poolUsed[poolClass];
+}
+
+/*******************************************************************************
+  * @brief Get the most blocks a class has held since start up
+  * @par Parameters:
+  * poolClass - PoolClass value
+  * @retval high-water mark in blocks
+  *****************************************************************************/
+unsigned char Pool_GetPeak(unsigned char poolClass)
+{
+    return poolPeak[poolClass];
+}
+
+/*******************************************************************************
+  * @brief Write the usage report, the class count then POOL_CLASS_REPORT_SIZE
+  *        bytes for each class
+  * @par Parameters:
+  * report - buffer of POOL_REPORT_SIZE bytes
+  * @retval report length in bytes
+  *****************************************************************************/
+unsigned char Pool_GetReport(unsigned char *report)
+{
+    unsigned char length = 1;
+    unsigned char i = 0;
+
+    report[0] = POOL_CLASS_COUNT;
+
+    for(i = 0; i < POOL_CLASS_COUNT; i++)
+    {
+        report[length++] = POOL_QUOTA[i];
+        report[length++] = poolUsed[i];
+        report[length++] = poolPeak[i];
+        report[length++] = poolFailed[i];
+    }
+
+    return length;
+}
@@ -0,0 +1,173 @@
+/*******************************************************************************
+  * @file Power.c
+  * @brief Implements the CPU clock scaling. The main loop calls Power_Run
+  *        before it sleeps, so the CPU only slows once there is nothing left
+  *        to do. Power_Wake is safe from an interrupt: it restores full
+  *        speed at once and leaves restarting the idle time to Power_Run, so
+  *        the active path never waits on the slow clock for longer than the
+  *        start of the interrupt that brings the work in.
+  *
+  *        The touch sensing acquisition times its charge transfer bursts in
+  *        CPU cycles, so a scan holds full speed while it runs.
+  * @author David Sharpe
+  * @version V1.0.0
+  * @date 14-October-2026
+  *
+  * ST Visual Develop 4.2.1 using STM8 Cosmic C Compiler
+  *****************************************************************************/
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Includes
+////////////////////////////////////////////////////////////////////////////////
+#include "Power.h"
+#include "DriveController.h"
+#include "Scheduler.h"
+
+#if POWER_ENABLE
+
+////////////////////////////////////////////////////////////////////////////////
+// Variables
+////////////////////////////////////////////////////////////////////////////////
+
+//CPU slowed, and woken since Power_Run last looked
+volatile unsigned char powerSlow = 0;
+volatile unsigned char powerWoken = 0;
+
+//Start of the idle time and the times the CPU slowed
+unsigned long powerIdleStart = 0;
+unsigned short powerSlowCount = 0;
+
+
+/*******************************************************************************
+  * @brief Start at full speed with the idle time from now
+  * @par Parameters: None
+  * @retval None
+  *****************************************************************************/
+void Power_Initialize(void)
+{
+    CLK_SYSCLKConfig(CLK_PRESCALER_CPUDIV1);
+    
+    powerSlow = 0;
+    powerWoken = 0;
+    powerIdleStart = Sched_GetTime();
+    powerSlowCount = 0;
+}
+
+/*******************************************************************************
+  * @brief Slow the CPU once the robot has been parked with nothing coming in
+  *        for POWER_IDLE_TIME, call before the main loop sleeps
+  * @par Parameters: None
+  * @retval None
+  *****************************************************************************/
+void Power_Run(void)
+{
+    unsigned long now = Sched_GetTime();
+    unsigned char cc = 0;
+    
+    //A wake from an interrupt either comes before the change or sees it
+    maskInterrupts(cc);
+    
+    if(powerWoken || DriveCtrl_IsMoving() || DriveCtrl_IsMoveActive())
+    {
+        powerWoken = 0;
+        powerIdleStart = now;
+        
+        if(powerSlow)
+        {
+            CLK_SYSCLKConfig(CLK_PRESCALER_CPUDIV1);
+            powerSlow = 0;
+        }
+    }
+    else if(!powerSlow && now - powerIdleStart >= POWER_IDLE_TIME)
+    {
+        powerSlow = 1;
+        CLK_SYSCLKConfig(POWER_SLOW_DIVIDER);
+    
+        if(powerSlowCount < 0xFFFF)
+        {
+            powerSlowCount++;
+        }
+    }
+    
+    restoreInterrupts(cc);
+}
+
+/*******************************************************************************
+  * @brief Restore full speed and restart the idle time, for anything that
+  *        brings work in. Safe from an interrupt.
+  * @par Parameters: None
+  * @retval None
+  *****************************************************************************/
+void Power_Wake(void)
+{
+    powerWoken = 1;
+    
+    if(powerSlow)
+    {
+        CLK_SYSCLKConfig(CLK_PRESCALER_CPUDIV1);
+        powerSlow = 0;
+    }
+}
+
+/*******************************************************************************
+  * @brief Run at full speed for cycle timed work without restarting the idle
+  *        time
+  * @par Parameters: None
+  * @retval value for Power_Resume
+  *****************************************************************************/
+unsigned char Power_Hold(void)
+{
+    unsigned char held = powerSlow;
+    
+    if(held)
+    {
+        CLK_SYSCLKConfig(CLK_PRESCALER_CPUDIV1);
+        powerSlow = 0;
+    }
+    
+    return held;
+}
+
+/*******************************************************************************
+  * @brief Go back to the speed before Power_Hold, unless woken since
+  * @par Parameters:
+  * held - value returned by Power_Hold
+  * @retval None
+  *****************************************************************************/
+void Power_Resume(unsigned char held)
+{
+    unsigned char cc = 0;
+    
+    maskInterrupts(cc);
+    
+    if(held && !powerWoken)
+    {
+        powerSlow = 1;
+        CLK_SYSCLKConfig(POWER_SLOW_DIVIDER);
+    }
+    
+    restoreInterrupts(cc);
+}
+
+/*******************************************************************************
+  * @brief Check if the CPU is slowed
+  * @par Parameters: None
+  * @retval 1 if slowed, 0 at full speed
+  *****************************************************************************/
+int Power_IsSlow(void)
+{
+    return powerSlow;
+}
+
+/*******************************************************************************
+  * @brief Get the times the CPU has slowed since start up
+  * @par Parameters: None
+  * @retval count, saturates
+  *****************************************************************************/
+unsigned short Power_GetSlowCount(void)
+{
+    return powerSlowCount;
+}
+
+#endif
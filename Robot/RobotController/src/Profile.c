@@ -0,0 +1,145 @@
+/*******************************************************************************
+  * @file Profile.c
+  * @brief Implements the hot path profiling counters. Each probe pair
+  *        records the time spent in a section into min/max/mean counters
+  *        and a histogram that can be reported over the WiFi link.
+  * @author David Sharpe
+  * @version V1.0.0
+  * @date 14-October-2026
+  *
+  * ST Visual Develop 4.2.1 using STM8 Cosmic C Compiler
+  *****************************************************************************/
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Includes
+////////////////////////////////////////////////////////////////////////////////
+#include "Profile.h"
+#include "stm8s.h"
+
+#if PROFILE_ENABLE
+
+////////////////////////////////////////////////////////////////////////////////
+// Variables
+////////////////////////////////////////////////////////////////////////////////
+unsigned short profileStart[PROFILE_POINT_COUNT];
+ProfileStat profileStats[PROFILE_POINT_COUNT];
+
+
+/*******************************************************************************
+  * @brief Clear all counters
+  * @par Parameters: None
+  * @retval None
+  *****************************************************************************/
+void Profile_Reset(void)
+{
+    unsigned char i = 0;
+    unsigned char bin = 0;
+
+    disableInterrupts();
+
+    for(i = 0; i < PROFILE_POINT_COUNT; i++)
+    {
+        profileStats[i].count = 0;
+        profileStats[i].min = 0xFFFF;
+        profileStats[i].max = 0;
+        profileStats[i].sum = 0;
+
+        for(bin = 0; bin < PROFILE_BINS; bin++)
+        {
+            profileStats[i].bins[bin] = 0;
+        }
+    }
+
+    enableInterrupts();
+}
+
+/*******************************************************************************
+  * @brief Record the time spent in a section. Called by PROFILE_END, each
+  *        point is only recorded from one context.
+  * @par Parameters:
+  * point - profiled section
+  * micros - time spent in us
+  * @retval None
+  *****************************************************************************/
+void Profile_Record(unsigned char point, unsigned short micros)
+{
+    ProfileStat *stat = &profileStats[point];
+    unsigned short limit = 4;
+    unsigned char bin = 0;
+
+    //Counters stop at full scale rather than wrap
+    if(stat->count == 0xFFFF)
+    {
+        return;
+    }
+
+    stat->count++;
+    stat->sum += micros;
+
+    if(micros < stat->min)
+    {
+        stat->min = micros;
+    }
+
+    if(micros > stat->max)
+    {
+        stat->max = micros;
+    }
+
+    while(bin < PROFILE_BINS - 1 && micros >= limit)
+    {
+        limit <<= 1;
+        bin++;
+    }
+
+    stat->bins[bin]++;
+}
+
+/*******************************************************************************
+  * @brief Write the report for one section
+  * @par Parameters:
+  * point - profiled section
+  * report - buffer of at least PROFILE_REPORT_SIZE bytes
+  * @retval report length in bytes, 0 if the point is not valid
+  *****************************************************************************/
+unsigned char Profile_GetReport(unsigned char point, unsigned char *report)
+{
+    ProfileStat stat;
+    unsigned short values[4];
+    unsigned char length = 0;
+    unsigned char i = 0;
+
+    if(point >= PROFILE_POINT_COUNT)
+    {
+        return 0;
+    }
+
+    //Interrupt sections update the counters at any time, take a copy
+    disableInterrupts();
+    stat = profileStats[point];
+    enableInterrupts();
+
+    values[0] = stat.count;
+    values[1] = stat.count ? stat.min : 0;
+    values[2] = stat.max;
+    values[3] = stat.count ? (unsigned short)(stat.sum / stat.count) : 0;
+
+    report[length++] = point;
+
+    for(i = 0; i < 4; i++)
+    {
+        report[length++] = (unsigned char)values[i];
+        report[length++] = (unsigned char)(values[i] >> 8);
+    }
+
+    for(i = 0; i < PROFILE_BINS; i++)
+    {
+        report[length++] = (unsigned char)stat.bins[i];
+        report[length++] = (unsigned char)(stat.bins[i] >> 8);
+    }
+
+    return length;
+}
+
+#endif
@@ -0,0 +1,387 @@
+/*******************************************************************************
+  * @file Protocol.c
+  * @brief Implements the binary control protocol exchanged with the remote
+  * @author David Sharpe
+  * @version V1.0.0
+  * @date 14-October-2026
+  *
+  * ST Visual Develop 4.2.1 using STM8 Cosmic C Compiler
+  *****************************************************************************/
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Includes
+////////////////////////////////////////////////////////////////////////////////
+#include "Protocol.h"
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Definitions
+////////////////////////////////////////////////////////////////////////////////
+#define CRC8_POLY   0x07
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Prototypes
+////////////////////////////////////////////////////////////////////////////////
+unsigned char Protocol_Parse(const unsigned char *frame, unsigned char length, 
+                             ProtoHandler handler, unsigned char sequenced);
+unsigned char Protocol_Check(const unsigned char *frame, unsigned char length, 
+                             unsigned char sequenced);
+void Protocol_Recover(const unsigned char *value, unsigned char length, 
+                      ProtoHandler handler);
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Variables
+////////////////////////////////////////////////////////////////////////////////
+unsigned char lastSeq = 0;
+unsigned char haveSeq = 0;
+unsigned short rejectCount = 0;
+
+//Frames received out of the last PROTO_REPEAT_WINDOW, bit n for lastSeq - n,
+//and the repeated commands run in place of lost ones
+unsigned char seqSeen = 0;
+unsigned short recoveredCount = 0;
+unsigned char txSeq = 0;
+
+
+/*******************************************************************************
+  * @brief Initialize the protocol. The first frame received is accepted 
+  *        whatever its sequence number.
+  * @par Parameters: None
+  * @retval None
+  *****************************************************************************/
+void Protocol_Initialize(void)
+{
+    lastSeq = 0;
+    haveSeq = 0;
+    rejectCount = 0;
+    seqSeen = 0;
+    recoveredCount = 0;
+    txSeq = 0;
+}
+
+/*******************************************************************************
+  * @brief Validate a received frame and pass each command it carries to the
+  *        handler. Nothing is dispatched unless the whole frame is valid and
+  *        newer than the last accepted frame.
+  * @par Parameters:
+  * frame - received frame
+  * length - frame length in bytes
+  * handler - function invoked for each command
+  * @retval PROTO_OK, PROTO_BAD_FRAME, PROTO_BAD_CRC or PROTO_STALE
+  *****************************************************************************/
+unsigned char Protocol_ParseFrame(const unsigned char *frame, unsigned char length, 
+                                  ProtoHandler handler)
+{
+    return Protocol_Parse(frame, length, handler, 1);
+}
+
+/*******************************************************************************
+  * @brief Validate a frame received on the TCP bulk lane and pass each 
+  *        command it carries to the handler. The lane is reliable and in 
+  *        order, so the sequence number is neither checked nor recorded and
+  *        the control sequence is left alone.
+  * @par Parameters:
+  * frame - received frame
+  * length - frame length in bytes
+  * handler - function invoked for each command
+  * @retval PROTO_OK, PROTO_BAD_FRAME or PROTO_BAD_CRC
+  *****************************************************************************/
+unsigned char Protocol_ParseBulkFrame(const unsigned char *frame, unsigned char length, 
+                                      ProtoHandler handler)
+{
+    return Protocol_Parse(frame, length, handler, 0);
+}
+
+/*******************************************************************************
+  * @brief Validate a control frame ahead of its turn in the receive pool and
+  *        show each command it carries to the handler. Nothing is recorded,
+  *        the frame is parsed again with Protocol_ParseFrame in its turn.
+  * @par Parameters:
+  * frame - received frame
+  * length - frame length in bytes
+  * handler - function invoked for each command
+  * @retval PROTO_OK, PROTO_BAD_FRAME, PROTO_BAD_CRC or PROTO_STALE
+  *****************************************************************************/
+unsigned char Protocol_PeekFrame(const unsigned char *frame, unsigned char length, 
+                                 ProtoHandler handler)
+{
+    unsigned char result = Protocol_Check(frame, length, 1);
+    unsigned char i = 0;
+    
+    if(result != PROTO_OK)
+    {
+        return result;
+    }
+    
+    for(i = 0; i < frame[3]; i += frame[PROTO_HEADER_SIZE + i + 1] + 2)
+    {
+        handler(frame[PROTO_HEADER_SIZE + i], &frame[PROTO_HEADER_SIZE + i + 2], 
+                frame[PROTO_HEADER_SIZE + i + 1]);
+    }
+    
+    return PROTO_OK;
+}
+
+/*******************************************************************************
+  * @brief Make the control frames older than a peeked frame stale, so the
+  *        ones still waiting in the receive pool are dropped when their turn
+  *        comes, copies of them included. The peeked frame itself is still
+  *        accepted.
+  * @par Parameters:
+  * frame - frame that passed Protocol_PeekFrame
+  * @retval None
+  *****************************************************************************/
+void Protocol_Fence(const unsigned char *frame)
+{
+    lastSeq = frame[2] - 1;
+    haveSeq = 1;
+    seqSeen = 0xFF;
+}
+
+/*******************************************************************************
+  * @brief Validate a received frame and dispatch its commands
+  * @par Parameters:
+  * frame - received frame
+  * length - frame length in bytes
+  * handler - function invoked for each command
+  * sequenced - 1 to drop frames that are not newer than the last accepted
+  * @retval PROTO_OK, PROTO_BAD_FRAME, PROTO_BAD_CRC or PROTO_STALE
+  *****************************************************************************/
+unsigned char Protocol_Parse(const unsigned char *frame, unsigned char length, 
+                             ProtoHandler handler, unsigned char sequenced)
+{
+    unsigned char result = Protocol_Check(frame, length, sequenced);
+    unsigned char advance = 0;
+    unsigned char i = 0;
+    
+    if(result != PROTO_OK)
+    {
+        rejectCount++;
+        return result;
+    }
+    
+    if(sequenced)
+    {
+        //Frames from before a restart are not recovered
+        advance = frame[2] - lastSeq;
+        
+        if(!haveSeq || (frame[1] & PROTO_FLAG_SEQ_RESET))
+        {
+            seqSeen = 0xFF;
+        }
+        else
+        {
+            seqSeen = (advance < PROTO_REPEAT_WINDOW) ? 
+                      (unsigned char)((seqSeen << advance) | 1) : 1;
+        }
+        
+        lastSeq = frame[2];
+        haveSeq = 1;
+    }
+    
+    //Dispatch the commands in order, copies of lost ones included
+    for(i = 0; i < frame[3]; i += frame[PROTO_HEADER_SIZE + i + 1] + 2)
+    {
+        if(frame[PROTO_HEADER_SIZE + i] != PROTO_CMD_REPEAT)
+        {
+            handler(frame[PROTO_HEADER_SIZE + i], &frame[PROTO_HEADER_SIZE + i + 2], 
+                    frame[PROTO_HEADER_SIZE + i + 1]);
+        }
+        else if(sequenced)
+        {
+            Protocol_Recover(&frame[PROTO_HEADER_SIZE + i + 2], 
+                             frame[PROTO_HEADER_SIZE + i + 1], handler);
+        }
+    }
+    
+    return PROTO_OK;
+}
+
+/*******************************************************************************
+  * @brief Run a repeated command if the frame it first went in was lost. 
+  *        The frame is then marked received, so later copies are dropped.
+  * @par Parameters:
+  * value - command data, sequence then the inner command
+  * length - command data length in bytes
+  * handler - function invoked for the inner command
+  * @retval None
+  *****************************************************************************/
+void Protocol_Recover(const unsigned char *value, unsigned char length, 
+                      ProtoHandler handler)
+{
+    unsigned char age = 0;
+    
+    if(length < PROTO_REPEAT_HEADER || 
+       value[2] != length - PROTO_REPEAT_HEADER ||
+       value[1] == PROTO_CMD_REPEAT)
+    {
+        return;
+    }
+    
+    //Copies of the frame itself, of newer ones or of ones too old to tell
+    //are all outside the window
+    age = lastSeq - value[0];
+    
+    if(age == 0 || age >= PROTO_REPEAT_WINDOW || (seqSeen & (1 << age)))
+    {
+        return;
+    }
+    
+    seqSeen |= (unsigned char)(1 << age);
+    recoveredCount++;
+    
+    handler(value[1], value + PROTO_REPEAT_HEADER, value[2]);
+}
+
+/*******************************************************************************
+  * @brief Check a received frame is whole, intact and, when sequenced, newer
+  *        than the last accepted frame
+  * @par Parameters:
+  * frame - received frame
+  * length - frame length in bytes
+  * sequenced - 1 to check the sequence number
+  * @retval PROTO_OK, PROTO_BAD_FRAME, PROTO_BAD_CRC or PROTO_STALE
+  *****************************************************************************/
+unsigned char Protocol_Check(const unsigned char *frame, unsigned char length, 
+                             unsigned char sequenced)
+{
+    unsigned char payloadLength = 0;
+    unsigned char seq = 0;
+    unsigned char i = 0;
+    
+    //Check the header
+    if(length < PROTO_OVERHEAD || frame[0] != PROTO_SYNC || 
+       (frame[1] >> 4) != PROTO_VERSION)
+    {
+        return PROTO_BAD_FRAME;
+    }
+    
+    payloadLength = frame[3];
+    
+    if(payloadLength != length - PROTO_OVERHEAD)
+    {
+        return PROTO_BAD_FRAME;
+    }
+    
+    //CRC covers everything between the sync byte and the CRC
+    if(Protocol_Crc8(&frame[1], length - 2) != frame[length - 1])
+    {
+        return PROTO_BAD_CRC;
+    }
+    
+    //Drop replayed or out of order frames. The difference is taken modulo 
+    //256 so the sequence number can wrap.
+    seq = frame[2];
+    
+    if(sequenced && haveSeq && !(frame[1] & PROTO_FLAG_SEQ_RESET) && 
+       (signed char)(seq - lastSeq) <= 0)
+    {
+        return PROTO_STALE;
+    }
+    
+    //Make sure every command fits before acting on any of them
+    for(i = 0; i < payloadLength; i += frame[PROTO_HEADER_SIZE + i + 1] + 2)
+    {
+        if(i + 2 > payloadLength || 
+           i + 2 + frame[PROTO_HEADER_SIZE + i + 1] > payloadLength)
+        {
+            return PROTO_BAD_FRAME;
+        }
+    }
+    
+    return PROTO_OK;
+}
+
+/*******************************************************************************
+  * @brief Build a frame to send to the remote. The first frame after start up
+  *        carries the sequence reset flag.
+  * @par Parameters:
+  * frame - buffer for the frame, at least length + PROTO_OVERHEAD bytes
+  * payload - command list
+  * length - command list length in bytes
+  * @retval frame length in bytes
+  *****************************************************************************/
+unsigned char Protocol_BuildFrame(unsigned char *frame, const unsigned char *payload, 
+                                  unsigned char length)
+{
+    unsigned char i = 0;
+    
+    frame[0] = PROTO_SYNC;
+    frame[1] = (PROTO_VERSION << 4) | (txSeq == 0 ? PROTO_FLAG_SEQ_RESET : 0);
+    frame[2] = txSeq++;
+    frame[3] = length;
+    
+    for(i = 0; i < length; i++)
+    {
+        frame[PROTO_HEADER_SIZE + i] = payload[i];
+    }
+    
+    frame[PROTO_HEADER_SIZE + length] = Protocol_Crc8(&frame[1], length + 3);
+    
+    //Skip zero after wrapping so only the first frame has the reset flag
+    if(txSeq == 0)
+    {
+        txSeq = 1;
+    }
+    
+    return length + PROTO_OVERHEAD;
+}
+
+/*******************************************************************************
+  * @brief Compute the CRC-8 of a buffer (poly 0x07, init 0)
+  * @par Parameters:
+  * data - data buffer
+  * length - number of bytes
+  * @retval CRC-8
+  *****************************************************************************/
+unsigned char Protocol_Crc8(const unsigned char *data, unsigned char length)
+{
+    unsigned char crc = 0;
+    unsigned char bit = 0;
+    
+    while(length--)
+    {
+        crc ^= *data++;
+        
+        for(bit = 0; bit < 8; bit++)
+        {
+            crc = (crc & 0x80) ? (unsigned char)((crc << 1) ^ CRC8_POLY) : 
+                                 (unsigned char)(crc << 1);
+        }
+    }
+    
+    return crc;
+}
+
+/*******************************************************************************
+  * @brief Get the sequence number of the last accepted frame
+  * @par Parameters: None
+  * @retval sequence number
+  *****************************************************************************/
+unsigned char Protocol_GetLastSeq(void)
+{
+    return lastSeq;
+}
+
+/*******************************************************************************
+  * @brief Get the number of rejected frames
+  * @par Parameters: None
+  * @retval rejected frame count
+  *****************************************************************************/
+unsigned short Protocol_GetRejectCount(void)
+{
+    return rejectCount;
+}
+
+/*******************************************************************************
+  * @brief Get the number of repeated commands run in place of lost ones
+  * @par Parameters: None
+  * @retval recovered command count
+  *****************************************************************************/
+unsigned short Protocol_GetRecoveredCount(void)
+{
+    return recoveredCount;
+}
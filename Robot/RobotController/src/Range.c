@@ -0,0 +1,193 @@
+/*******************************************************************************
+  * @file Range.c
+  * @brief Implements the forward range sensor. TIM1 channel 4 captures the
+  *        scheduler count on each edge of the echo, so the interrupt only
+  *        has to turn the capture into a time and flip the edge it waits
+  *        for. The task sends the pings and turns each echo into a distance
+  *        for the drive reflex and the telemetry.
+  * @author David Sharpe
+  * @version V1.0.0
+  * @date 14-October-2026
+  *
+  * ST Visual Develop 4.2.1 using STM8 Cosmic C Compiler
+  *****************************************************************************/
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Includes
+////////////////////////////////////////////////////////////////////////////////
+#include "Range.h"
+#include "Scheduler.h"
+#include "FastIo.h"
+
+#if RANGE_ENABLE
+
+////////////////////////////////////////////////////////////////////////////////
+// Definitions
+////////////////////////////////////////////////////////////////////////////////
+
+//Echo of the last ping
+enum RangeEcho
+{
+    RANGE_ECHO_IDLE,    //passed on, or no ping yet
+    RANGE_ECHO_WAIT,    //ping sent, waiting for the rising edge
+    RANGE_ECHO_HIGH,    //waiting for the falling edge
+    RANGE_ECHO_DONE     //width measured
+};
+
+//Longest echo in range, us
+#define RANGE_ECHO_MAX  ((unsigned short)(((unsigned long)RANGE_MAX * \
+                                           RANGE_US_PER_10MM) / 10))
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Prototypes
+////////////////////////////////////////////////////////////////////////////////
+void Ping(void);
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Variables
+////////////////////////////////////////////////////////////////////////////////
+
+//Written by the capture interrupt
+volatile unsigned char echoState = RANGE_ECHO_IDLE;
+volatile unsigned short echoStart = 0;
+volatile unsigned short echoWidth = 0;
+
+unsigned short rangeDistance = RANGE_CLEAR;
+unsigned long pingTime = 0;
+
+
+/*******************************************************************************
+  * @brief Setup the trigger output and the echo capture. Call after
+  *        Sched_Initialize, which resets TIM1.
+  * @par Parameters: None
+  * @retval None
+  *****************************************************************************/
+void Range_Initialize(void)
+{
+    GPIO_Init(RANGE_TRIGGER_PORT, RANGE_TRIGGER_PIN, GPIO_MODE_OUT_PP_LOW_FAST);
+    GPIO_Init(RANGE_ECHO_PORT, RANGE_ECHO_PIN, GPIO_MODE_IN_FL_NO_IT);
+
+    //Capture the rising edge first, no filter
+    TIM1_ICInit(TIM1_CHANNEL_4, TIM1_ICPOLARITY_RISING,
+                TIM1_ICSELECTION_DIRECTTI, TIM1_ICPSC_DIV1, 0);
+    TIM1_ClearITPendingBit(TIM1_IT_CC4);
+    TIM1_ITConfig(TIM1_IT_CC4, ENABLE);
+
+    echoState = RANGE_ECHO_IDLE;
+    rangeDistance = RANGE_CLEAR;
+    pingTime = Sched_GetTime();
+}
+
+/*******************************************************************************
+  * @brief Pass on a finished echo and send the next ping when it is due.
+  *        Called every RANGE_PERIOD ms.
+  * @par Parameters: None
+  * @retval None
+  *****************************************************************************/
+void Range_Task(void)
+{
+    unsigned short width = 0;
+
+    if(echoState == RANGE_ECHO_DONE)
+    {
+        width = echoWidth;
+        echoState = RANGE_ECHO_IDLE;
+
+        rangeDistance = (width > RANGE_ECHO_MAX) ? RANGE_CLEAR :
+            (unsigned short)(((unsigned long)width * 10) / RANGE_US_PER_10MM);
+    }
+
+    if(!Sched_IsExpired(pingTime))
+    {
+        return;
+    }
+
+    //The last ping got no echo, or its echo never ended
+    if(echoState != RANGE_ECHO_IDLE)
+    {
+        rangeDistance = RANGE_CLEAR;
+    }
+
+    pingTime += RANGE_PING_PERIOD;
+    Ping();
+}
+
+/*******************************************************************************
+  * @brief Get the range to the nearest obstacle ahead from the last echo
+  * @par Parameters: None
+  * @retval distance in mm, RANGE_CLEAR if nothing is in range
+  *****************************************************************************/
+unsigned short Range_GetDistance(void)
+{
+    return rangeDistance;
+}
+
+/*******************************************************************************
+  * @brief Set the capture up for the rising edge of the echo and pulse the
+  *        trigger
+  * @par Parameters: None
+  * @retval None
+  *****************************************************************************/
+void Ping(void)
+{
+    unsigned short start = 0;
+
+    TIM1->CCER2 &= (unsigned char)~TIM1_CCER2_CC4P;
+    TIM1_ClearITPendingBit(TIM1_IT_CC4);
+    echoState = RANGE_ECHO_WAIT;
+
+    GPIO_WriteHigh(RANGE_TRIGGER_PORT, RANGE_TRIGGER_PIN);
+    start = Sched_GetMicros();
+
+    while((unsigned short)(Sched_GetMicros() - start) < RANGE_TRIGGER_US)
+    {
+    }
+
+    GPIO_WriteLow(RANGE_TRIGGER_PORT, RANGE_TRIGGER_PIN);
+}
+
+/*******************************************************************************
+  * @brief Interrupt service routine invoked on a TIM1 channel 4 capture, an
+  *        edge of the echo. Edges outside a ping are ignored.
+  * @par Parameters: None
+  * @retval None
+  *****************************************************************************/
+void Range_CaptureISR(void)
+{
+    unsigned short capture = 0;
+    unsigned short now = 0;
+    unsigned short count = 0;
+    unsigned short edge = 0;
+
+    FAST_TIM1_CAPTURE4(capture);
+    now = Sched_GetMicros();
+    FAST_TIM1_COUNTER(count);
+
+    TIM1_ClearITPendingBit(TIM1_IT_CC4);
+
+    //Back from now to the edge, the count wraps every tick
+    if(count < capture)
+    {
+        count += 1000 * SCHED_TICK;
+    }
+
+    edge = now - (count - capture);
+
+    if(echoState == RANGE_ECHO_WAIT)
+    {
+        echoStart = edge;
+        echoState = RANGE_ECHO_HIGH;
+        TIM1->CCER2 |= TIM1_CCER2_CC4P;
+    }
+    else if(echoState == RANGE_ECHO_HIGH)
+    {
+        echoWidth = edge - echoStart;
+        echoState = RANGE_ECHO_DONE;
+        TIM1->CCER2 &= (unsigned char)~TIM1_CCER2_CC4P;
+    }
+}
+
+#endif
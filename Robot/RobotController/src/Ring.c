@@ -0,0 +1,219 @@
+/*******************************************************************************
+  * @file Ring.c
+  * @brief Implements the single producer, single consumer byte ring. Data is
+  *        written before the index that publishes it, so the other side
+  *        never sees a byte that is not there yet or loses one still in use.
+  * @author David Sharpe
+  * @version V1.0.0
+  * @date 14-October-2026
+  *
+  * ST Visual Develop 4.2.1 using STM8 Cosmic C Compiler
+  *****************************************************************************/
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Includes
+////////////////////////////////////////////////////////////////////////////////
+#include "Ring.h"
+
+
+/*******************************************************************************
+  * @brief Add a byte to the ring
+  * @par Parameters:
+  * ring - the ring
+  * byte - the byte to add
+  * @retval 1 if added, 0 if the ring is full
+  *****************************************************************************/
+int Ring_Put(Ring *ring, unsigned char byte)
+{
+    unsigned char head = ring->head;
+
+    if((unsigned char)(head - ring->tail) > ring->mask)
+    {
+        return 0;
+    }
+
+    ring->buffer[head & ring->mask] = byte;
+    ring->head = head + 1;
+
+    return 1;
+}
+
+/*******************************************************************************
+  * @brief Add a block of bytes to the ring. Either all of them are added or
+  *        none are, so the consumer never sees part of a block.
+  * @par Parameters:
+  * ring - the ring
+  * data - the bytes to add
+  * length - number of bytes
+  * @retval 1 if added, 0 if the ring does not have room
+  *****************************************************************************/
+int Ring_Write(Ring *ring, unsigned char *data, unsigned char length)
+{
+    unsigned char head = ring->head;
+    unsigned char mask = ring->mask;
+
+    if(length > (unsigned char)(mask + 1 - (unsigned char)(head - ring->tail)))
+    {
+        return 0;
+    }
+
+    while(length--)
+    {
+        ring->buffer[head & mask] = *data++;
+        head++;
+    }
+
+    //Publish the whole block at once
+    ring->head = head;
+
+    return 1;
+}
+
+/*******************************************************************************
+  * @brief Get the number of bytes that can be added to the ring
+  * @par Parameters:
+  * ring - the ring
+  * @retval free bytes
+  *****************************************************************************/
+unsigned char Ring_Space(Ring *ring)
+{
+    return (unsigned char)(ring->mask + 1 - (unsigned char)(ring->head - ring->tail));
+}
+
+/*******************************************************************************
+  * @brief Remove the oldest byte from the ring
+  * @par Parameters:
+  * ring - the ring
+  * byte - receives the byte
+  * @retval 1 if a byte was removed, 0 if the ring is empty
+  *****************************************************************************/
+int Ring_Get(Ring *ring, unsigned char *byte)
+{
+    unsigned char tail = ring->tail;
+
+    if(tail == ring->head)
+    {
+        return 0;
+    }
+
+    *byte = ring->buffer[tail & ring->mask];
+    ring->tail = tail + 1;
+
+    return 1;
+}
+
+/*******************************************************************************
+  * @brief Look at the oldest byte in the ring without removing it
+  * @par Parameters:
+  * ring - the ring
+  * byte - receives the byte
+  * @retval 1 if there is a byte, 0 if the ring is empty
+  *****************************************************************************/
+int Ring_Peek(Ring *ring, unsigned char *byte)
+{
+    unsigned char tail = ring->tail;
+
+    if(tail == ring->head)
+    {
+        return 0;
+    }
+
+    *byte = ring->buffer[tail & ring->mask];
+
+    return 1;
+}
+
+/*******************************************************************************
+  * @brief Look at a byte in the ring without removing it, the caller must
+  *        have checked that Ring_Count covers it
+  * @par Parameters:
+  * ring - the ring
+  * offset - position from the oldest byte, 0 is the oldest
+  * @retval the byte
+  *****************************************************************************/
+unsigned char Ring_PeekAt(Ring *ring, unsigned char offset)
+{
+    return ring->buffer[(unsigned char)(ring->tail + offset) & ring->mask];
+}
+
+/*******************************************************************************
+  * @brief Look at the oldest bytes in the ring that sit next to each other in
+  *        the buffer, so they can be handed on without copying. They stay in
+  *        the ring until Ring_Discard, a block that wraps takes two calls.
+  * @par Parameters:
+  * ring - the ring
+  * data - set to point at the oldest byte
+  * @retval bytes in the block, 0 if the ring is empty
+  *****************************************************************************/
+unsigned char Ring_PeekBlock(Ring *ring, unsigned char **data)
+{
+    unsigned char tail = ring->tail;
+    unsigned char count = (unsigned char)(ring->head - tail);
+    unsigned char offset = tail & ring->mask;
+    unsigned char run = (unsigned char)(ring->mask - offset + 1);
+    
+    *data = &ring->buffer[offset];
+    
+    return (count < run) ? count : run;
+}
+
+/*******************************************************************************
+  * @brief Remove a block of bytes from the ring, the caller must have checked
+  *        that Ring_Count covers it
+  * @par Parameters:
+  * ring - the ring
+  * data - receives the bytes
+  * length - number of bytes
+  * @retval None
+  *****************************************************************************/
+void Ring_Read(Ring *ring, unsigned char *data, unsigned char length)
+{
+    unsigned char tail = ring->tail;
+    unsigned char mask = ring->mask;
+
+    while(length--)
+    {
+        *data++ = ring->buffer[tail & mask];
+        tail++;
+    }
+
+    //Hand the whole block back at once
+    ring->tail = tail;
+}
+
+/*******************************************************************************
+  * @brief Drop the oldest bytes from the ring, the caller must have checked
+  *        that Ring_Count covers them
+  * @par Parameters:
+  * ring - the ring
+  * length - number of bytes
+  * @retval None
+  *****************************************************************************/
+void Ring_Discard(Ring *ring, unsigned char length)
+{
+    ring->tail += length;
+}
+
+/*******************************************************************************
+  * @brief Drop everything in the ring. Nothing is zeroed, the tail just
+  *        catches up with the head.
+  * @par Parameters:
+  * ring - the ring
+  * @retval None
+  *****************************************************************************/
+void Ring_Clear(Ring *ring)
+{
+    ring->tail = ring->head;
+}
+
+/*******************************************************************************
+  * @brief Get the number of bytes in the ring
+  * @par Parameters:
+  * ring - the ring
+  * @retval bytes waiting
+  *****************************************************************************/
+unsigned char Ring_Count(Ring *ring)
+{
+    return (unsigned char)(ring->head - ring->tail);
+}
@@ -0,0 +1,307 @@
+/*******************************************************************************
+  * @file Scheduler.c
+  * @brief Implements the cooperative periodic task scheduler. TIM1 counts 
+  *        microseconds and its update event every 1ms tick counts a 32-bit 
+  *        millisecond time. The same tick drives the touch sensing library
+  *        timebase, so TIM4 and its interrupt are not used. Tasks are kept 
+  *        in rate-monotonic order (shortest period first) and the highest 
+  *        priority task that is due runs on each call to Sched_Run. Each 
+  *        task checks in with the watchdog when it runs.
+  * @author David Sharpe
+  * @version V1.0.0
+  * @date 14-October-2026
+  *
+  * ST Visual Develop 4.2.1 using STM8 Cosmic C Compiler
+  *****************************************************************************/
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Includes
+////////////////////////////////////////////////////////////////////////////////
+#include "Scheduler.h"
+#include "Profile.h"
+#include "stm8s.h"
+#include "FastIo.h"
+#include "stm8_tsl_api.h"
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Variables
+////////////////////////////////////////////////////////////////////////////////
+//Counted by the tick and read by every interrupt that stamps an event
+TINY volatile unsigned long schedTime = 0;
+
+SchedTask tasks[SCHED_MAX_TASKS];
+unsigned char taskCount = 0;
+
+//One bit per task that has run since the last watchdog reload
+unsigned short checkIns = 0;
+unsigned char watchdogEnabled = 0;
+
+
+/*******************************************************************************
+  * @brief Initialize the scheduler and start the TIM1 tick interrupt
+  * @par Parameters: None
+  * @retval None
+  *****************************************************************************/
+void Sched_Initialize(void)
+{
+    //Set prescaler for a 1MHz count
+    //Note final prescaler register value is prescaler + 1
+    uint16_t prescaler = CLK_GetClockFreq() / 1000000 - 1;
+
+    //Set base period for one tick
+    uint16_t period = 1000 * SCHED_TICK - 1;
+    
+    schedTime = 0;
+    taskCount = 0;
+
+    //Timer 1 Peripheral Configuration
+    TIM1_DeInit();
+
+    //Init timer 1 registers, update event every tick 
+    TIM1_TimeBaseInit(prescaler, TIM1_COUNTERMODE_UP, period, 0);
+
+    //Enables timer peripheral Preload register on ARR
+    TIM1_ARRPreloadConfig(ENABLE);
+    
+    //Count time from the update interrupt
+    TIM1_ITConfig(TIM1_IT_UPDATE, ENABLE);
+
+    //Enable timer
+    TIM1_Cmd(ENABLE);
+}
+
+/*******************************************************************************
+  * @brief Register a periodic task. Tasks with shorter periods get higher 
+  *        priority.
+  * @par Parameters:
+  * func - task function
+  * period - task period in ms
+  * offset - delay in ms before the first release, used to spread tasks out
+  * @retval 1 if the task was added, 0 if the task table is full
+  *****************************************************************************/
+int Sched_AddTask(TaskFunc func, unsigned short period, unsigned short offset)
+{
+    unsigned char i = 0;
+    
+    if(taskCount >= SCHED_MAX_TASKS || period == 0)
+    {
+        return 0;
+    }
+    
+    //Find the insertion point, equal periods keep registration order
+    i = taskCount;
+    
+    while(i > 0 && tasks[i - 1].period > period)
+    {
+        tasks[i] = tasks[i - 1];
+        i--;
+    }
+    
+    tasks[i].func = func;
+    tasks[i].period = period;
+    tasks[i].next = Sched_GetTime() + offset;
+    tasks[i].overruns = 0;
+    taskCount++;
+    
+    //Task indexes have moved
+    checkIns = 0;
+    
+    return 1;
+}
+
+/*******************************************************************************
+  * @brief Run the highest priority task that is due. A task that is still 
+  *        running when its next release comes has missed its deadline, the
+  *        overrun is counted and the missed releases are skipped.
+  * @par Parameters: None
+  * @retval 1 if a task was run, 0 if nothing was due
+  *****************************************************************************/
+int Sched_Run(void)
+{
+    unsigned long now = Sched_GetTime();
+    unsigned char i = 0;
+    SchedTask *task = 0;
+    
+    for(i = 0; i < taskCount; i++)
+    {
+        task = &tasks[i];
+        
+        if((signed long)(now - task->next) >= 0)
+        {
+            task->func();
+            task->next += task->period;
+            
+            //Reload the watchdog once all the tasks have checked in
+            checkIns |= (unsigned short)(1 << i);
+            
+            if(watchdogEnabled && checkIns == (unsigned short)((1 << taskCount) - 1))
+            {
+                IWDG_ReloadCounter();
+                checkIns = 0;
+            }
+            
+            //Check the deadline
+            now = Sched_GetTime();
+            
+            if((signed long)(now - task->next) >= 0)
+            {
+                task->overruns++;
+                task->next = now + task->period;
+            }
+            
+            return 1;
+        }
+    }
+    
+    return 0;
+}
+
+/*******************************************************************************
+  * @brief Start the independent watchdog. Once started it cannot be stopped,
+  *        call after the tasks are registered. Sched_Delay must not be used 
+  *        for longer than the timeout after this.
+  * @par Parameters: None
+  * @retval None
+  *****************************************************************************/
+void Sched_StartWatchdog(void)
+{
+    checkIns = 0;
+    
+    //Start the watchdog, then unlock the prescaler and reload registers
+    IWDG_Enable();
+    IWDG_WriteAccessCmd(IWDG_WriteAccess_Enable);
+    IWDG_SetPrescaler(IWDG_Prescaler_128);
+    IWDG_SetReload(SCHED_WATCHDOG_RELOAD);
+    IWDG_ReloadCounter();
+    
+    watchdogEnabled = 1;
+}
+
+/*******************************************************************************
+  * @brief Get the time since the scheduler started. The counter is updated by
+  *        the tick interrupt one byte at a time so it is read until stable.
+  * @par Parameters: None
+  * @retval time in ms
+  *****************************************************************************/
+unsigned long Sched_GetTime(void)
+{
+    unsigned long time = 0;
+    
+    do
+    {
+        time = schedTime;
+    } while(time != schedTime);
+    
+    return time;
+}
+
+/*******************************************************************************
+  * @brief Get a microsecond timestamp for measuring short intervals. Wraps 
+  *        every 65ms. Can be called from interrupts, a tick that is pending 
+  *        but not yet counted is allowed for.
+  * @par Parameters: None
+  * @retval time in us
+  *****************************************************************************/
+unsigned short Sched_GetMicros(void)
+{
+    unsigned short ms = 0;
+    unsigned short count = 0;
+    unsigned char pending = 0;
+    
+    do
+    {
+        ms = (unsigned short)schedTime;
+        FAST_TIM1_COUNTER(count);
+        pending = TIM1->SR1 & TIM1_SR1_UIF;
+    } while(ms != (unsigned short)schedTime);
+    
+    //The counter wrapped but the tick interrupt has not run yet
+    if(pending && count < 500)
+    {
+        ms += SCHED_TICK;
+    }
+    
+    return (ms * 1000) + count;
+}
+
+/*******************************************************************************
+  * @brief Check if a deadline has passed. Works across counter wrap.
+  * @par Parameters:
+  * deadline - time in ms
+  * @retval 1 if the deadline has passed, 0 otherwise
+  *****************************************************************************/
+int Sched_IsExpired(unsigned long deadline)
+{
+    return ((signed long)(Sched_GetTime() - deadline) >= 0);
+}
+
+/*******************************************************************************
+  * @brief Wait for a period of time, sleeping between ticks. Interrupts must
+  *        be enabled.
+  * @par Parameters:
+  * ms - time to wait in ms
+  * @retval None
+  *****************************************************************************/
+void Sched_Delay(unsigned short ms)
+{
+    unsigned long deadline = Sched_GetTime() + ms;
+    
+    while(!Sched_IsExpired(deadline))
+    {
+        wfi();
+    }
+}
+
+/*******************************************************************************
+  * @brief Get the number of missed deadlines of a task
+  * @par Parameters:
+  * func - task function
+  * @retval overrun count, 0 if the task is not registered
+  *****************************************************************************/
+unsigned short Sched_GetOverruns(TaskFunc func)
+{
+    unsigned char i = 0;
+    
+    for(i = 0; i < taskCount; i++)
+    {
+        if(tasks[i].func == func)
+        {
+            return tasks[i].overruns;
+        }
+    }
+    
+    return 0;
+}
+
+/*******************************************************************************
+  * @brief Interrupt service routine invoked on the TIM1 update event. Counts
+  *        the millisecond time and runs the touch sensing timebase, which 
+  *        expects a call every 0.5ms and derives its 10ms, 100ms and 1s 
+  *        ticks from them. It runs at a low priority, the UART receive and
+  *        encoder interrupts nest in the timebase.
+  * @par Parameters: None
+  * @retval None
+  *****************************************************************************/
+void Sched_TickISR(void)
+{
+    unsigned char cc = 0;
+    unsigned char i = 0;
+    
+    //The encoder and UART interrupts nest in this one and read the time, 
+    //they must see the flag and the count change together
+    maskInterrupts(cc);
+    TIM1_ClearITPendingBit(TIM1_IT_UPDATE);
+    schedTime += SCHED_TICK;
+    restoreInterrupts(cc);
+    
+    PROFILE_START(PROFILE_TICK_ISR);
+    
+    for(i = 0; i < SCHED_TSL_TICKS; i++)
+    {
+        TSL_Timer_ISR();
+    }
+    
+    PROFILE_END(PROFILE_TICK_ISR);
+}
@@ -0,0 +1,287 @@
+/*******************************************************************************
+  * @file Sequencer.c
+  * @brief Implements the motion sequencer. The steps are copied into a RAM
+  *        queue and run from a 1ms task through the drive controller, the
+  *        ramp engine shapes each change as it does for network commands.
+  *        Each hold ends a fixed time after the previous one did rather than
+  *        after the task noticed, so late runs do not add up over a
+  *        sequence. The wheels are ramped to a stop when the last step is
+  *        done. A running sequence holds off the failsafe, it is bounded by
+  *        its own holds and any drive command from the remote cancels it.
+  * @author David Sharpe
+  * @version V1.0.0
+  * @date 14-October-2026
+  *
+  * ST Visual Develop 4.2.1 using STM8 Cosmic C Compiler
+  *****************************************************************************/
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Includes
+////////////////////////////////////////////////////////////////////////////////
+#include "Sequencer.h"
+#include "DriveController.h"
+#include "Failsafe.h"
+#include "Scheduler.h"
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Prototypes
+////////////////////////////////////////////////////////////////////////////////
+void StartSequence(void);
+void RunSteps(void);
+void FinishSequence(void);
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Variables
+////////////////////////////////////////////////////////////////////////////////
+
+//Data bytes that follow each step type
+const unsigned char SEQ_STEP_SIZE[SEQ_OP_ACCEL + 1] = {0, 2, 4, 2, 1};
+
+SeqStep seqSteps[SEQUENCER_MAX_STEPS];
+unsigned char seqCount = 0;
+unsigned char seqIndex = 0;
+unsigned char seqRunning = 0;
+
+//Set while a hold is waiting for its end time
+unsigned char seqHolding = 0;
+unsigned long seqHoldEnd = 0;
+
+//Ramp step in use before the sequence, an accel step lasts until the end
+unsigned char seqSavedAccel = DRIVE_ACCEL_DEFAULT;
+
+
+/*******************************************************************************
+  * @brief Initialize the sequencer with nothing running
+  * @par Parameters: None
+  * @retval None
+  *****************************************************************************/
+void Sequencer_Initialize(void)
+{
+    seqCount = 0;
+    seqIndex = 0;
+    seqRunning = 0;
+    seqHolding = 0;
+}
+
+/*******************************************************************************
+  * @brief Load a list of steps and start running it, replacing any sequence
+  *        already running. The steps up to the first hold are applied at
+  *        once. A list that is cut short, has an unknown step or more than
+  *        SEQUENCER_MAX_STEPS steps is refused whole.
+  * @par Parameters:
+  * steps - step list, each step is a type from SeqOp then its data
+  * length - step list length in bytes
+  * @retval 1 if the sequence was started, 0 if it was refused
+  *****************************************************************************/
+int Sequencer_Load(const unsigned char *steps, unsigned char length)
+{
+    unsigned char offset = 0;
+    unsigned char count = 0;
+    const unsigned char *data = 0;
+
+    //Check the whole list before touching the running sequence
+    while(offset < length)
+    {
+        if(steps[offset] > SEQ_OP_ACCEL || count == SEQUENCER_MAX_STEPS ||
+           SEQ_STEP_SIZE[steps[offset]] > length - offset - 1)
+        {
+            return 0;
+        }
+
+        offset += SEQ_STEP_SIZE[steps[offset]] + 1;
+        count++;
+    }
+
+    if(count == 0)
+    {
+        return 0;
+    }
+
+    Sequencer_Cancel();
+
+    for(offset = 0, count = 0; offset < length; count++)
+    {
+        data = &steps[offset + 1];
+
+        seqSteps[count].op = steps[offset];
+        seqSteps[count].left = 0;
+        seqSteps[count].right = 0;
+
+        switch(steps[offset])
+        {
+            case SEQ_OP_WHEELS:
+                seqSteps[count].left = (signed char)data[0];
+                seqSteps[count].right = (signed char)data[1];
+                break;
+
+            case SEQ_OP_VELOCITY:
+                seqSteps[count].left = (signed short)(data[0] | (data[1] << 8));
+                seqSteps[count].right = (signed short)(data[2] | (data[3] << 8));
+                break;
+
+            case SEQ_OP_HOLD:
+                seqSteps[count].left = (signed short)(data[0] | (data[1] << 8));
+                break;
+
+            case SEQ_OP_ACCEL:
+                seqSteps[count].left = data[0];
+                break;
+        };
+
+        offset += SEQ_STEP_SIZE[steps[offset]] + 1;
+    }
+
+    seqCount = count;
+    StartSequence();
+
+    return 1;
+}
+
+/*******************************************************************************
+  * @brief Run the last sequence loaded again from its first step, replacing
+  *        any sequence already running. The steps are kept after a run ends
+  *        or is cancelled.
+  * @par Parameters: None
+  * @retval 1 if the sequence was started, 0 if none has been loaded
+  *****************************************************************************/
+int Sequencer_Replay(void)
+{
+    if(seqCount == 0)
+    {
+        return 0;
+    }
+
+    Sequencer_Cancel();
+    StartSequence();
+
+    return 1;
+}
+
+/*******************************************************************************
+  * @brief Stop running the sequence and put back the ramp step it started
+  *        with. The wheels are left as they are for the command that
+  *        replaces it.
+  * @par Parameters: None
+  * @retval None
+  *****************************************************************************/
+void Sequencer_Cancel(void)
+{
+    if(seqRunning)
+    {
+        DriveCtrl_SetAcceleration(seqSavedAccel);
+    }
+
+    seqRunning = 0;
+    seqHolding = 0;
+}
+
+/*******************************************************************************
+  * @brief Check if a sequence is running
+  * @par Parameters: None
+  * @retval 1 if running, 0 otherwise
+  *****************************************************************************/
+int Sequencer_IsRunning(void)
+{
+    return seqRunning;
+}
+
+/*******************************************************************************
+  * @brief Sequencer task, ends the hold that is due and runs the steps up to
+  *        the next one. Called every SEQUENCER_PERIOD ms.
+  * @par Parameters: None
+  * @retval None
+  *****************************************************************************/
+void Sequencer_Task(void)
+{
+    if(!seqRunning)
+    {
+        return;
+    }
+
+    //The remote may be quiet on purpose while the sequence drives
+    Failsafe_Feed();
+
+    if(seqHolding && Sched_IsExpired(seqHoldEnd))
+    {
+        seqHolding = 0;
+        RunSteps();
+    }
+}
+
+/*******************************************************************************
+  * @brief Start the loaded steps from the first, applying those up to the
+  *        first hold at once
+  * @par Parameters: None
+  * @retval None
+  *****************************************************************************/
+void StartSequence(void)
+{
+    seqIndex = 0;
+    seqRunning = 1;
+    seqHoldEnd = Sched_GetTime();
+    seqSavedAccel = DriveCtrl_GetAcceleration();
+
+    RunSteps();
+}
+
+/*******************************************************************************
+  * @brief Apply steps until a hold starts or the sequence is done. A hold
+  *        is timed from the end of the one before, or from the start.
+  * @par Parameters: None
+  * @retval None
+  *****************************************************************************/
+void RunSteps(void)
+{
+    SeqStep *step = 0;
+
+    while(!seqHolding)
+    {
+        if(seqIndex == seqCount)
+        {
+            FinishSequence();
+            return;
+        }
+
+        step = &seqSteps[seqIndex++];
+
+        switch(step->op)
+        {
+            case SEQ_OP_STOP:
+                DriveCtrl_SetWheelDuty(0, 0);
+                break;
+
+            case SEQ_OP_WHEELS:
+                DriveCtrl_SetWheelDuty((signed char)step->left,
+                                       (signed char)step->right);
+                break;
+
+            case SEQ_OP_VELOCITY:
+                DriveCtrl_SetWheelVelocity(step->left, step->right);
+                break;
+
+            case SEQ_OP_HOLD:
+                seqHoldEnd += (unsigned short)step->left;
+                seqHolding = 1;
+                break;
+
+            case SEQ_OP_ACCEL:
+                DriveCtrl_SetAcceleration((unsigned char)step->left);
+                break;
+        };
+    }
+}
+
+/*******************************************************************************
+  * @brief End the sequence, the wheels ramp to a stop at the ramp step the
+  *        sequence started with
+  * @par Parameters: None
+  * @retval None
+  *****************************************************************************/
+void FinishSequence(void)
+{
+    Sequencer_Cancel();
+    DriveCtrl_SetWheelDuty(0, 0);
+}
@@ -0,0 +1,210 @@
+/*******************************************************************************
+  * @file Setpoint.c
+  * @brief Implements the setpoint jitter buffer. The samples are held 
+  *        oldest first and the oldest is dropped once the playout time has 
+  *        passed the one after it, so the first two always bracket the 
+  *        playout time. The fraction of the way between them is Q8 fixed 
+  *        point, past the newest sample the same fraction carries the last
+  *        slope on.
+  * @author David Sharpe
+  * @version V1.0.0
+  * @date 14-October-2026
+  *
+  * ST Visual Develop 4.2.1 using STM8 Cosmic C Compiler
+  *****************************************************************************/
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Includes
+////////////////////////////////////////////////////////////////////////////////
+#include "Setpoint.h"
+#include "Clock.h"
+#include "Scheduler.h"
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Prototypes
+////////////////////////////////////////////////////////////////////////////////
+signed char Interpolate(signed char from, signed char to, unsigned short fraction);
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Variables
+////////////////////////////////////////////////////////////////////////////////
+
+//Held samples, oldest first
+SetpointSample setpoints[SETPOINT_BUFFER_SIZE];
+unsigned char setpointCount = 0;
+
+//Set while the buffer has the wheels
+unsigned char setpointActive = 0;
+
+
+/*******************************************************************************
+  * @brief Empty the buffer
+  * @par Parameters: None
+  * @retval None
+  *****************************************************************************/
+void Setpoint_Initialize(void)
+{
+    Setpoint_Cancel();
+}
+
+/*******************************************************************************
+  * @brief Add a sample to the buffer, the buffer takes the wheels
+  * @par Parameters:
+  * time - controller time the sample was taken, ms
+  * left - left wheel percent, negative is backward
+  * right - right wheel percent, negative is backward
+  * @retval None
+  *****************************************************************************/
+void Setpoint_Add(unsigned long time, signed char left, signed char right)
+{
+    unsigned long robotTime = Clock_GetRobotTime(time);
+    unsigned char i = 0;
+    
+    //A repeat or a sample overtaken on the link
+    if(setpointCount > 0 && 
+       (signed long)(robotTime - setpoints[setpointCount - 1].time) <= 0)
+    {
+        return;
+    }
+    
+    if(setpointCount == SETPOINT_BUFFER_SIZE)
+    {
+        for(i = 1; i < SETPOINT_BUFFER_SIZE; i++)
+        {
+            setpoints[i - 1] = setpoints[i];
+        }
+        
+        setpointCount--;
+    }
+    
+    setpoints[setpointCount].time = robotTime;
+    setpoints[setpointCount].left = left;
+    setpoints[setpointCount].right = right;
+    setpointCount++;
+    
+    setpointActive = 1;
+}
+
+/*******************************************************************************
+  * @brief Empty the buffer and give up the wheels, for any other command 
+  *        that takes them
+  * @par Parameters: None
+  * @retval None
+  *****************************************************************************/
+void Setpoint_Cancel(void)
+{
+    setpointActive = 0;
+    setpointCount = 0;
+}
+
+/*******************************************************************************
+  * @brief Check if the buffer has the wheels
+  * @par Parameters: None
+  * @retval 1 if playing out, 0 otherwise
+  *****************************************************************************/
+int Setpoint_IsActive(void)
+{
+    return setpointActive;
+}
+
+/*******************************************************************************
+  * @brief Setpoint task, sets the wheels from the samples at the playout
+  *        time. Runs every SETPOINT_PERIOD ms.
+  * @par Parameters: None
+  * @retval None
+  *****************************************************************************/
+void Setpoint_Task(void)
+{
+    unsigned long playout = 0;
+    unsigned long late = 0;
+    unsigned long elapsed = 0;
+    unsigned long span = 0;
+    unsigned short fraction = 0;
+    const SetpointSample *from = setpoints;
+    const SetpointSample *to = setpoints;
+    unsigned char i = 0;
+    
+    if(!setpointActive)
+    {
+        return;
+    }
+    
+    playout = Sched_GetTime() - SETPOINT_DELAY;
+    
+    //Not yet time for the first sample
+    if((signed long)(playout - setpoints[0].time) < 0)
+    {
+        return;
+    }
+    
+    //The last two are kept for the slope
+    while(setpointCount > 2 && 
+          (signed long)(playout - setpoints[1].time) >= 0)
+    {
+        for(i = 1; i < setpointCount; i++)
+        {
+            setpoints[i - 1] = setpoints[i];
+        }
+        
+        setpointCount--;
+    }
+    
+    late = playout - setpoints[setpointCount - 1].time;
+    
+    //Stalled past the extrapolation, the drive ramps the stop
+    if((signed long)late > SETPOINT_EXTRAPOLATE)
+    {
+        DriveCtrl_SetWheelDuty(0, 0);
+        Setpoint_Cancel();
+        return;
+    }
+    
+    //A single sample is held
+    if(setpointCount >= 2)
+    {
+        to = &setpoints[1];
+    }
+    
+    elapsed = playout - from->time;
+    span = to->time - from->time;
+    
+    if(span == 0)
+    {
+        DriveCtrl_SetWheelDuty(to->left, to->right);
+        return;
+    }
+    
+    //At most (span + SETPOINT_EXTRAPOLATE) / span, fits 16 bits
+    fraction = (unsigned short)((elapsed << 8) / span);
+    
+    DriveCtrl_SetWheelDuty(Interpolate(from->left, to->left, fraction),
+                           Interpolate(from->right, to->right, fraction));
+}
+
+/*******************************************************************************
+  * @brief Interpolate between two wheel percents, or past the second
+  * @par Parameters:
+  * from - percent at the first sample
+  * to - percent at the second sample
+  * fraction - Q8 fraction of the way from the first to the second
+  * @retval percent, held to full speed
+  *****************************************************************************/
+signed char Interpolate(signed char from, signed char to, unsigned short fraction)
+{
+    signed long value = from + 
+        ((signed long)(to - from) * (signed long)fraction) / 256;
+    
+    if(value > SPEED_FULL)
+    {
+        value = SPEED_FULL;
+    }
+    else if(value < -SPEED_FULL)
+    {
+        value = -SPEED_FULL;
+    }
+    
+    return (signed char)value;
+}
@@ -0,0 +1,145 @@
+/*******************************************************************************
+  * @file Soak.c
+  * @brief Implements the soak test counter snapshots. The main loop checks
+  *        Soak_IsDue and sends the report in a frame of its own, so the
+  *        snapshots keep coming with the telemetry off. Each counter is
+  *        read as it stands, the controller takes the differences.
+  * @author David Sharpe
+  * @version V1.0.0
+  * @date 14-October-2026
+  *
+  * ST Visual Develop 4.2.1 using STM8 Cosmic C Compiler
+  *****************************************************************************/
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Includes
+////////////////////////////////////////////////////////////////////////////////
+#include "Soak.h"
+#include "DriveController.h"
+#include "Esp8266.h"
+#include "Failsafe.h"
+#include "Memory.h"
+#include "Pool.h"
+#include "Protocol.h"
+#include "Scheduler.h"
+#include "Uart.h"
+
+#if SOAK_ENABLE
+
+////////////////////////////////////////////////////////////////////////////////
+// Prototypes
+////////////////////////////////////////////////////////////////////////////////
+unsigned char *Soak_PutShort(unsigned char *report, unsigned short value);
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Variables
+////////////////////////////////////////////////////////////////////////////////
+
+//Snapshot period, 0 while no soak test runs, and when the next is due
+unsigned long soakPeriod = 0;
+unsigned long soakDue = 0;
+unsigned short soakCount = 0;
+
+
+/*******************************************************************************
+  * @brief Start or stop the snapshots, the first goes at once
+  * @par Parameters:
+  * seconds - snapshot period, 0 stops
+  * @retval None
+  *****************************************************************************/
+void Soak_Start(unsigned char seconds)
+{
+    soakPeriod = (unsigned long)seconds * 1000;
+    soakDue = Sched_GetTime();
+    soakCount = 0;
+}
+
+/*******************************************************************************
+  * @brief Check if a snapshot is due
+  * @par Parameters: None
+  * @retval 1 if a snapshot should be sent, 0 otherwise
+  *****************************************************************************/
+int Soak_IsDue(void)
+{
+    return soakPeriod != 0 && (signed long)(Sched_GetTime() - soakDue) >= 0;
+}
+
+/*******************************************************************************
+  * @brief Write a snapshot of the counters
+  * @par Parameters:
+  * report - buffer of SOAK_REPORT_SIZE bytes
+  * @retval report length in bytes
+  *****************************************************************************/
+unsigned char Soak_GetReport(unsigned char *report)
+{
+    unsigned long now = Sched_GetTime();
+    unsigned char *next = report;
+    unsigned char i = 0;
+    
+    *next++ = (unsigned char)now;
+    *next++ = (unsigned char)(now >> 8);
+    *next++ = (unsigned char)(now >> 16);
+    *next++ = (unsigned char)(now >> 24);
+    next = Soak_PutShort(next, soakCount);
+    
+    next = Soak_PutShort(next, Esp8266_GetRxPacketCount());
+    next = Soak_PutShort(next, Esp8266_GetRxDropCount());
+    next = Soak_PutShort(next, Esp8266_GetRxOversizeCount());
+    next = Soak_PutShort(next, Esp8266_GetTxFailCount());
+    next = Soak_PutShort(next, Esp8266_GetBusyCount());
+    next = Soak_PutShort(next, Esp8266_GetRecoveryCount());
+    next = Soak_PutShort(next, Protocol_GetRejectCount());
+    next = Soak_PutShort(next, Protocol_GetRecoveredCount());
+    
+    for(i = 0; i < UART_ERROR_COUNT; i++)
+    {
+        next = Soak_PutShort(next, Uart_GetErrorCount(i));
+    }
+    
+    next = Soak_PutShort(next, Sched_GetOverruns(DriveCtrl_Update));
+    next = Soak_PutShort(next, DriveCtrl_GetTripCount());
+    next = Soak_PutShort(next, Failsafe_GetTrips());
+    next = Soak_PutShort(next, Memory_GetStackPeak());
+    next = Soak_PutShort(next, Pool_GetUsed(POOL_TX_DATAGRAM));
+    next = Soak_PutShort(next, Pool_GetPeak(POOL_TX_DATAGRAM));
+    
+    return (unsigned char)(next - report);
+}
+
+/*******************************************************************************
+  * @brief Schedule the next snapshot once one has been handed to the module
+  * @par Parameters:
+  * queued - nonzero if the snapshot was queued, it is tried again soon if
+  *          not
+  * @retval None
+  *****************************************************************************/
+void Soak_Release(int queued)
+{
+    if(!queued)
+    {
+        soakDue = Sched_GetTime() + SOAK_RETRY;
+        return;
+    }
+    
+    soakDue = Sched_GetTime() + soakPeriod;
+    soakCount++;
+}
+
+/*******************************************************************************
+  * @brief Write a 16-bit value to a report, LSB first
+  * @par Parameters:
+  * report - where the value goes
+  * value - the value
+  * @retval the byte after the value
+  *****************************************************************************/
+unsigned char *Soak_PutShort(unsigned char *report, unsigned short value)
+{
+    report[0] = (unsigned char)value;
+    report[1] = (unsigned char)(value >> 8);
+    
+    return report + 2;
+}
+
+#endif
@@ -0,0 +1,123 @@
+/*******************************************************************************
+  * @file Spi.c
+  * @brief Implements the SPI master transfers. Writing the first byte
+  *        starts the clock, each receive interrupt then takes the byte that
+  *        came back and writes the next one, and the last one raises the
+  *        chip select. Full duplex, a transfer sends and receives the same
+  *        number of bytes.
+  * @author David Sharpe
+  * @version V1.0.0
+  * @date 14-October-2026
+  *
+  * ST Visual Develop 4.2.1 using STM8 Cosmic C Compiler
+  *****************************************************************************/
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Includes
+////////////////////////////////////////////////////////////////////////////////
+#include "Spi.h"
+#include "stm8s.h"
+#include "FastIo.h"
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Variables
+////////////////////////////////////////////////////////////////////////////////
+
+//Transfer in progress. The interrupt runs for every byte, so its state is
+//in page zero.
+const unsigned char *spiTx = 0;
+unsigned char *spiRx = 0;
+TINY unsigned char spiLength = 0;
+TINY unsigned char spiIndex = 0;
+TINY volatile unsigned char spiBusy = 0;
+
+
+/*******************************************************************************
+  * @brief Initialize the SPI as master with the chip select high
+  * @par Parameters: None
+  * @retval None
+  *****************************************************************************/
+void Spi_Initialize(void)
+{
+    //The slave only listens while its chip select is low
+    GPIO_Init(SPI_CS_PORT, SPI_CS_PIN, GPIO_MODE_OUT_PP_HIGH_FAST);
+    
+    //Software NSS, the chip select is an ordinary pin
+    SPI_DeInit();
+    SPI_Init(SPI_FIRSTBIT_MSB, SPI_BAUD_PRESCALER, SPI_MODE_MASTER,
+             SPI_CLOCKPOLARITY_LOW, SPI_CLOCKPHASE_1EDGE,
+             SPI_DATADIRECTION_2LINES_FULLDUPLEX, SPI_NSS_SOFT, 0x07);
+    SPI_Cmd(ENABLE);
+    
+    spiBusy = 0;
+}
+
+/*******************************************************************************
+  * @brief Start a transfer, this does not block. Both buffers must stay
+  *        valid until Spi_IsBusy returns 0.
+  * @par Parameters:
+  * tx - bytes to send
+  * rx - receives the bytes clocked in, may be tx
+  * length - bytes each way, at least 1
+  * @retval 1 if the transfer started, 0 if one is still in progress
+  *****************************************************************************/
+int Spi_Transfer(const unsigned char *tx, unsigned char *rx,
+                 unsigned char length)
+{
+    if(spiBusy || length == 0)
+    {
+        return 0;
+    }
+    
+    spiTx = tx;
+    spiRx = rx;
+    spiLength = length;
+    spiIndex = 0;
+    spiBusy = 1;
+    
+    GPIO_WriteLow(SPI_CS_PORT, SPI_CS_PIN);
+    
+    //The first byte starts the clock, the interrupt sends the rest
+    SPI_SendData(tx[0]);
+    SPI_ITConfig(SPI_IT_RXNE, ENABLE);
+    
+    return 1;
+}
+
+/*******************************************************************************
+  * @brief Check if a transfer is in progress
+  * @par Parameters: None
+  * @retval 1 if busy, 0 once the last transfer has finished
+  *****************************************************************************/
+int Spi_IsBusy(void)
+{
+    return spiBusy;
+}
+
+/*******************************************************************************
+  * @brief Interrupt service routine invoked when a byte has been clocked in
+  * @par Parameters: None
+  * @retval None
+  *****************************************************************************/
+void Spi_ISR(void)
+{
+    unsigned char index = spiIndex;
+    
+    //Reading DR clears RXNE
+    spiRx[index] = SPI_ReceiveData();
+    
+    if(++index < spiLength)
+    {
+        SPI_SendData(spiTx[index]);
+        spiIndex = index;
+    }
+    else
+    {
+        //The last byte is in, RXNE is only set once its clock has ended
+        SPI_ITConfig(SPI_IT_RXNE, DISABLE);
+        GPIO_WriteHigh(SPI_CS_PORT, SPI_CS_PIN);
+        spiBusy = 0;
+    }
+}
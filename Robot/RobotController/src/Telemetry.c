@@ -0,0 +1,505 @@
+/*******************************************************************************
+  * @file Telemetry.c
+  * @brief Implements the battery, motor current and drive telemetry. ADC1 
+  *        scans the analog inputs into its data buffer on every TIM1 update,
+  *        so the conversions need no CPU time until the end of conversion 
+  *        interrupt filters the results. Samples are taken at the configured
+  *        rate into a ring and reported in batches, the rate backs off while
+  *        the send pipeline is congested. The compact format sends each
+  *        sample as the change from the one before it.
+  * @author David Sharpe
+  * @version V1.0.0
+  * @date 14-October-2026
+  *
+  * ST Visual Develop 4.2.1 using STM8 Cosmic C Compiler
+  *****************************************************************************/
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Includes
+////////////////////////////////////////////////////////////////////////////////
+#include "Telemetry.h"
+#include "Board.h"
+#include "DriveController.h"
+#include "Range.h"
+#include "Ring.h"
+#include "Scheduler.h"
+#include "stm8s.h"
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Definitions
+////////////////////////////////////////////////////////////////////////////////
+#define TELEMETRY_PORT  BOARD_ANALOG_PORT
+#define TELEMETRY_PINS  BOARD_ANALOG_PINS
+
+//Filtered value to mV at the pin, the filter holds 2^TELEMETRY_FILTER_SHIFT
+//times the 10-bit average
+#define TELEMETRY_TO_MV(filter, scale) \
+    ((unsigned short)(((unsigned long)(filter) * (scale)) >> (10 + TELEMETRY_FILTER_SHIFT)))
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Prototypes
+////////////////////////////////////////////////////////////////////////////////
+void TakeSample(unsigned short battery);
+unsigned char GetCompactSamples(unsigned char *report, unsigned char room);
+unsigned char CodeSample(const unsigned char *sample, signed short *values,
+                         unsigned char *coded);
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Variables
+////////////////////////////////////////////////////////////////////////////////
+
+//Written by the ADC interrupt, 16-bit reads are single instructions. In page
+//zero for short addressing in the interrupt.
+TINY volatile unsigned short adcFilter[TELEMETRY_CHANNEL_COUNT];
+TINY volatile unsigned char adcPrimed = 0;
+
+//Sample period in Telemetry_Update calls, 0 when off
+unsigned char samplePeriod = 0;
+unsigned short sampleCountdown = 0;
+
+//Rate adaptation, the period is shifted left by rateShift
+unsigned char rateShift = 0;
+unsigned char cleanBatches = 0;
+
+//Sample ring, both ends are in the telemetry task
+RING_DEFINE(sampleRing, TELEMETRY_RING_SIZE * TELEMETRY_SAMPLE_SIZE);
+unsigned char sampleDropped = 0;
+
+unsigned short batteryMin = 0xFFFF;
+unsigned short rangeMin = RANGE_CLEAR;
+
+//Compact format, the fields of the last sample sent and the report count.
+//A keyframe is due when the count is a multiple of TELEMETRY_KEY_INTERVAL.
+unsigned char reportFormat = TELEMETRY_FORMAT_FULL;
+unsigned char reportCount = 0;
+signed short lastValues[TELEMETRY_FIELD_COUNT];
+
+
+/*******************************************************************************
+  * @brief Initialize ADC1 to scan the analog inputs on each TIM1 update. The
+  *        scheduler must have set up TIM1.
+  * @par Parameters: None
+  * @retval None
+  *****************************************************************************/
+void Telemetry_Initialize(void)
+{
+    unsigned char i = 0;
+    
+    for(i = 0; i < TELEMETRY_CHANNEL_COUNT; i++)
+    {
+        adcFilter[i] = 0;
+    }
+    
+    adcPrimed = 0;
+    batteryMin = 0xFFFF;
+    rangeMin = RANGE_CLEAR;
+    
+    //Analog inputs, floating without interrupt
+    GPIO_Init(TELEMETRY_PORT, TELEMETRY_PINS, GPIO_MODE_IN_FL_NO_IT);
+    
+    //Scan up to the last channel on the TIM1 trigger output, results are 
+    //kept in the data buffer
+    ADC1_DeInit();
+    ADC1_Init(ADC1_CONVERSIONMODE_SINGLE, ADC1_CHANNEL_2, ADC1_PRESSEL_FCPU_D8,
+              ADC1_EXTTRIG_TIM, ENABLE, ADC1_ALIGN_RIGHT,
+              ADC1_SCHMITTTRIG_CHANNEL0, DISABLE);
+    ADC1_SchmittTriggerConfig(ADC1_SCHMITTTRIG_CHANNEL1, DISABLE);
+    ADC1_SchmittTriggerConfig(ADC1_SCHMITTTRIG_CHANNEL2, DISABLE);
+    ADC1_ScanModeCmd(ENABLE);
+    ADC1_DataBufferCmd(ENABLE);
+    ADC1_ITConfig(ADC1_IT_EOCIE, ENABLE);
+    
+    //TIM1 update also triggers the conversions
+    TIM1_SelectOutputTrigger(TIM1_TRGOSOURCE_UPDATE);
+    
+    //Power up the converter
+    ADC1_Cmd(ENABLE);
+}
+
+/*******************************************************************************
+  * @brief Set the sample rate, a report is due every TELEMETRY_BATCH samples.
+  *        On a change pending samples are discarded and the rate adaptation 
+  *        restarts.
+  * @par Parameters:
+  * ms - sample period in ms, 0 to stop reporting
+  * @retval None
+  *****************************************************************************/
+void Telemetry_SetPeriod(unsigned short ms)
+{
+    ms /= TELEMETRY_PERIOD;
+    
+    if(ms > 0xFF)
+    {
+        ms = 0xFF;
+    }
+    
+    if((unsigned char)ms == samplePeriod)
+    {
+        return;
+    }
+    
+    samplePeriod = (unsigned char)ms;
+    sampleCountdown = samplePeriod;
+    
+    rateShift = 0;
+    cleanBatches = 0;
+    Ring_Clear(&sampleRing);
+    sampleDropped = 0;
+    reportCount = 0;
+}
+
+/*******************************************************************************
+  * @brief Set the report format. On a change pending samples are discarded
+  *        and the next compact report is a keyframe.
+  * @par Parameters:
+  * format - TelemetryFormat value
+  * @retval None
+  *****************************************************************************/
+void Telemetry_SetFormat(unsigned char format)
+{
+    if(format >= TELEMETRY_FORMAT_COUNT || format == reportFormat)
+    {
+        return;
+    }
+    
+    reportFormat = format;
+    reportCount = 0;
+    Ring_Clear(&sampleRing);
+    sampleDropped = 0;
+}
+
+/*******************************************************************************
+  * @brief Get the report format
+  * @par Parameters: None
+  * @retval TelemetryFormat value
+  *****************************************************************************/
+unsigned char Telemetry_GetFormat(void)
+{
+    return reportFormat;
+}
+
+/*******************************************************************************
+  * @brief Track the battery and range minimums and take a sample when one
+  *        is due. 
+  *        Called every TELEMETRY_PERIOD ms.
+  * @par Parameters: None
+  * @retval 1 if a batch is ready to report, 0 otherwise
+  *****************************************************************************/
+int Telemetry_Update(void)
+{
+    unsigned short battery = Telemetry_GetBattery();
+    
+    if(adcPrimed && battery < batteryMin)
+    {
+        batteryMin = battery;
+    }
+    
+    if(Range_GetDistance() < rangeMin)
+    {
+        rangeMin = Range_GetDistance();
+    }
+    
+    if(samplePeriod == 0 || --sampleCountdown > 0)
+    {
+        return 0;
+    }
+    
+    sampleCountdown = (unsigned short)samplePeriod << rateShift;
+    TakeSample(battery);
+    
+    return Ring_Count(&sampleRing) >= TELEMETRY_BATCH * TELEMETRY_SAMPLE_SIZE;
+}
+
+/*******************************************************************************
+  * @brief Adapt the sample rate to the send pipeline, called once per batch
+  * @par Parameters:
+  * congested - 1 if the batch could not be queued or the module reported 
+  *             busy since the last batch, 0 otherwise
+  * @retval None
+  *****************************************************************************/
+void Telemetry_SetCongested(int congested)
+{
+    if(congested)
+    {
+        cleanBatches = 0;
+        
+        if(rateShift < TELEMETRY_MAX_SHIFT)
+        {
+            rateShift++;
+        }
+        return;
+    }
+    
+    if(rateShift > 0 && ++cleanBatches >= TELEMETRY_RECOVER_BATCHES)
+    {
+        rateShift--;
+        cleanBatches = 0;
+    }
+}
+
+/*******************************************************************************
+  * @brief Get the filtered battery voltage
+  * @par Parameters: None
+  * @retval voltage in mV
+  *****************************************************************************/
+unsigned short Telemetry_GetBattery(void)
+{
+    return TELEMETRY_TO_MV(adcFilter[TELEMETRY_BATTERY], 
+                           TELEMETRY_VREF_MV * TELEMETRY_BATTERY_RATIO);
+}
+
+/*******************************************************************************
+  * @brief Get the filtered current of a motor
+  * @par Parameters:
+  * motor - MOTOR_LEFT or MOTOR_RIGHT
+  * @retval current in mA
+  *****************************************************************************/
+unsigned short Telemetry_GetCurrent(unsigned char motor)
+{
+    unsigned char channel = (motor == MOTOR_RIGHT) ? TELEMETRY_RIGHT_CURRENT : 
+                                                     TELEMETRY_LEFT_CURRENT;
+    
+    return TELEMETRY_TO_MV(adcFilter[channel], 
+                           TELEMETRY_VREF_MV * TELEMETRY_MA_PER_V / 1000);
+}
+
+/*******************************************************************************
+  * @brief Write the next batch of samples and start new minimums, in the
+  *        report format
+  * @par Parameters:
+  * report - buffer of TELEMETRY_REPORT_SIZE bytes
+  * @retval report length in bytes
+  *****************************************************************************/
+unsigned char Telemetry_GetReport(unsigned char *report)
+{
+    unsigned short period = (unsigned short)samplePeriod << rateShift;
+    unsigned short minimum = Telemetry_GetBattery();
+    unsigned char count = Ring_Count(&sampleRing) / TELEMETRY_SAMPLE_SIZE;
+    unsigned char i = 0;
+    
+    if(count > TELEMETRY_BATCH)
+    {
+        count = TELEMETRY_BATCH;
+    }
+    
+    if(batteryMin < minimum)
+    {
+        minimum = batteryMin;
+    }
+    
+    report[0] = (period > 0xFF) ? 0xFF : (unsigned char)period;
+    report[1] = count;
+    report[2] = sampleDropped;
+    report[3] = (unsigned char)Sched_GetOverruns(DriveCtrl_Update);
+    report[4] = (unsigned char)minimum;
+    report[5] = (unsigned char)(minimum >> 8);
+    report[6] = (unsigned char)rangeMin;
+    report[7] = (unsigned char)(rangeMin >> 8);
+    
+    sampleDropped = 0;
+    batteryMin = 0xFFFF;
+    rangeMin = RANGE_CLEAR;
+    
+    if(reportFormat == TELEMETRY_FORMAT_COMPACT)
+    {
+        return TELEMETRY_HEADER_SIZE + 
+               GetCompactSamples(report, TELEMETRY_REPORT_SIZE - 
+                                         TELEMETRY_HEADER_SIZE);
+    }
+    
+    report += TELEMETRY_HEADER_SIZE;
+    
+    for(i = 0; i < count; i++)
+    {
+        Ring_Read(&sampleRing, report, TELEMETRY_SAMPLE_SIZE);
+        report += TELEMETRY_SAMPLE_SIZE;
+    }
+    
+    return TELEMETRY_HEADER_SIZE + count * TELEMETRY_SAMPLE_SIZE;
+}
+
+/*******************************************************************************
+  * @brief Write the key byte and code the samples of a compact report, as 
+  *        many as fit. The count in the header is set to the samples coded.
+  * @par Parameters:
+  * report - report with its header written
+  * room - bytes free after the header
+  * @retval bytes written after the header
+  *****************************************************************************/
+unsigned char GetCompactSamples(unsigned char *report, unsigned char room)
+{
+    unsigned char sample[TELEMETRY_SAMPLE_SIZE];
+    unsigned char coded[TELEMETRY_CODED_MAX];
+    signed short values[TELEMETRY_FIELD_COUNT];
+    unsigned char length = 1;
+    unsigned char size = 0;
+    unsigned char count = 0;
+    unsigned char i = 0;
+    
+    report[TELEMETRY_HEADER_SIZE] = reportCount & ~TELEMETRY_KEY_FLAG;
+    
+    if(reportCount % TELEMETRY_KEY_INTERVAL == 0)
+    {
+        report[TELEMETRY_HEADER_SIZE] |= TELEMETRY_KEY_FLAG;
+        
+        for(i = 0; i < TELEMETRY_FIELD_COUNT; i++)
+        {
+            lastValues[i] = 0;
+        }
+    }
+    
+    reportCount++;
+    
+    //Each sample is coded aside and taken once it is known to fit, at most
+    //TELEMETRY_RING_SIZE codings of TELEMETRY_CODED_MAX bytes a report
+    while(Ring_Count(&sampleRing) >= TELEMETRY_SAMPLE_SIZE)
+    {
+        for(i = 0; i < TELEMETRY_SAMPLE_SIZE; i++)
+        {
+            sample[i] = Ring_PeekAt(&sampleRing, i);
+        }
+        
+        size = CodeSample(sample, values, coded);
+        
+        if(length + size > room)
+        {
+            break;
+        }
+        
+        for(i = 0; i < size; i++)
+        {
+            report[TELEMETRY_HEADER_SIZE + length + i] = coded[i];
+        }
+        
+        for(i = 0; i < TELEMETRY_FIELD_COUNT; i++)
+        {
+            lastValues[i] = values[i];
+        }
+        
+        Ring_Discard(&sampleRing, TELEMETRY_SAMPLE_SIZE);
+        length += size;
+        count++;
+    }
+    
+    report[1] = count;
+    
+    return length;
+}
+
+/*******************************************************************************
+  * @brief Code a sample against the last one sent
+  * @par Parameters:
+  * sample - sample as kept in the ring
+  * values - set to the fields of the sample
+  * coded - buffer of TELEMETRY_CODED_MAX bytes for the coding
+  * @retval coded length in bytes
+  *****************************************************************************/
+unsigned char CodeSample(const unsigned char *sample, signed short *values,
+                         unsigned char *coded)
+{
+    unsigned short change = 0;
+    unsigned char length = 1;
+    unsigned char i = 0;
+    
+    values[0] = (signed short)(sample[0] | (sample[1] << 8));
+    values[1] = (signed short)(sample[2] | (sample[3] << 8));
+    values[2] = (signed short)(sample[4] | (sample[5] << 8));
+    values[3] = (signed char)sample[6];
+    values[4] = (signed char)sample[7];
+    
+    coded[0] = 0;
+    
+    for(i = 0; i < TELEMETRY_FIELD_COUNT; i++)
+    {
+        if(values[i] == lastValues[i])
+        {
+            continue;
+        }
+        
+        coded[0] |= 1 << i;
+        
+        //Zig-zag, so small changes either way stay small. The fields are 
+        //well within 15 bits, the change fits 16.
+        change = (unsigned short)(values[i] - lastValues[i]);
+        change = (change & 0x8000) ? (unsigned short)~(change << 1) : 
+                                     (unsigned short)(change << 1);
+        
+        while(change > 0x7F)
+        {
+            coded[length++] = (unsigned char)(change | 0x80);
+            change >>= 7;
+        }
+        
+        coded[length++] = (unsigned char)change;
+    }
+    
+    return length;
+}
+
+/*******************************************************************************
+  * @brief Add a sample to the ring, dropping the oldest if it is full
+  * @par Parameters:
+  * battery - filtered battery voltage, mV
+  * @retval None
+  *****************************************************************************/
+void TakeSample(unsigned short battery)
+{
+    unsigned char sample[TELEMETRY_SAMPLE_SIZE];
+    unsigned short left = Telemetry_GetCurrent(MOTOR_LEFT);
+    unsigned short right = Telemetry_GetCurrent(MOTOR_RIGHT);
+    
+    //Safe from the producer side only because the report is taken in 
+    //the same task
+    if(Ring_Space(&sampleRing) < TELEMETRY_SAMPLE_SIZE)
+    {
+        Ring_Discard(&sampleRing, TELEMETRY_SAMPLE_SIZE);
+        
+        if(sampleDropped < 0xFF)
+        {
+            sampleDropped++;
+        }
+    }
+    
+    sample[0] = (unsigned char)battery;
+    sample[1] = (unsigned char)(battery >> 8);
+    sample[2] = (unsigned char)left;
+    sample[3] = (unsigned char)(left >> 8);
+    sample[4] = (unsigned char)right;
+    sample[5] = (unsigned char)(right >> 8);
+    sample[6] = (unsigned char)DriveCtrl_GetDuty(MOTOR_LEFT);
+    sample[7] = (unsigned char)DriveCtrl_GetDuty(MOTOR_RIGHT);
+    
+    Ring_Write(&sampleRing, sample, TELEMETRY_SAMPLE_SIZE);
+}
+
+/*******************************************************************************
+  * @brief Interrupt service routine invoked at the end of each scan, adds 
+  *        the buffered conversions to the filters
+  * @par Parameters: None
+  * @retval None
+  *****************************************************************************/
+void Telemetry_ADCISR(void)
+{
+    unsigned char i = 0;
+    
+    for(i = 0; i < TELEMETRY_CHANNEL_COUNT; i++)
+    {
+        //The first scan starts the filters so they do not rise from zero
+        if(!adcPrimed)
+        {
+            adcFilter[i] = ADC1_GetBufferValue(i) << TELEMETRY_FILTER_SHIFT;
+            continue;
+        }
+        
+        adcFilter[i] += ADC1_GetBufferValue(i) - 
+                        (adcFilter[i] >> TELEMETRY_FILTER_SHIFT);
+    }
+    
+    adcPrimed = 1;
+    
+    ADC1_ClearITPendingBit(ADC1_IT_EOC);
+}
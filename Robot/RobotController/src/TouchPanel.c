@@ -0,0 +1,211 @@
+/*******************************************************************************
+  * @file TouchPanel.c
+  * @brief Implements the touch panel scan schedule. Each state of the 
+  *        library's scan is timed every time it runs and the worst time kept,
+  *        a step is left for the next call when that time would take the 
+  *        call over TOUCH_BUDGET. The first run of each step is not known in
+  *        advance and may go over once. A scan always stops at the idle 
+  *        state, where the key states are read. The acquisition is timed
+  *        in CPU cycles, so a scan runs at full speed however the CPU is
+  *        scaled, and a key or the slider touched wakes it.
+  *
+  *        With SLICED_ACQUISITION set in stm8_tsl_conf.h an acquisition step
+  *        takes one sample of one key and its state is run again until the
+  *        keys are measured, so the worst time kept for it is one sample
+  *        rather than the whole port.
+  *
+  *        The profiling counters keep the time of each step, 
+  *        PROFILE_TSL_ACTION, and of each call, PROFILE_TOUCH_SCAN, whose 
+  *        longest time is held to the budget.
+  * @author David Sharpe
+  * @version V1.0.0
+  * @date 14-October-2026
+  *
+  * ST Visual Develop 4.2.1 using STM8 Cosmic C Compiler
+  *****************************************************************************/
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Includes
+////////////////////////////////////////////////////////////////////////////////
+#include "TouchPanel.h"
+#include "Power.h"
+#include "Profile.h"
+#include "Scheduler.h"
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Prototypes
+////////////////////////////////////////////////////////////////////////////////
+int ReadKeys(void);
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Variables
+////////////////////////////////////////////////////////////////////////////////
+
+//Worst time of each library state, TOUCH_COST_UNIT units
+unsigned char touchCost[TOUCH_STATE_COUNT];
+
+//Key states and slider position as of the last finished scan
+unsigned char touchKeys = 0;
+unsigned char touchSlider = TOUCH_NO_SLIDER;
+
+
+/*******************************************************************************
+  * @brief Initialize the Touch Sensing library with every key implemented 
+  *        and enabled, and start its timebase
+  * @par Parameters: None
+  * @retval None
+  *****************************************************************************/
+void TouchPanel_Initialize(void)
+{
+    u8 i;
+
+    //Initialize Touch Sensing library
+    TSL_Init();
+    
+    //All keys are implemented and enabled
+
+    for (i = 0; i < NUMBER_OF_SINGLE_CHANNEL_KEYS; i++)
+    {
+        sSCKeyInfo[i].Setting.b.IMPLEMENTED = 1;
+        sSCKeyInfo[i].Setting.b.ENABLED = 1;
+        sSCKeyInfo[i].DxSGroup = 0x01; //Put 0x00 to disable the DES on these pins
+    }
+
+#if NUMBER_OF_MULTI_CHANNEL_KEYS > 0
+    for (i = 0; i < NUMBER_OF_MULTI_CHANNEL_KEYS; i++)
+    {
+        sMCKeyInfo[i].Setting.b.IMPLEMENTED = 1;
+        sMCKeyInfo[i].Setting.b.ENABLED = 1;
+        sMCKeyInfo[i].DxSGroup = 0x01; //Put 0x00 to disable the DES on these pins
+    }
+#endif
+    
+    for(i = 0; i < TOUCH_STATE_COUNT; i++)
+    {
+        touchCost[i] = 0;
+    }
+    
+    touchKeys = 0;
+    touchSlider = TOUCH_NO_SLIDER;
+    
+    //Start the 100ms timebase Timer
+    TSL_Tick_Flags.b.User1_Start_100ms = 1;
+}
+
+/*******************************************************************************
+  * @brief Run the steps of the scan that fit the acquisition budget
+  * @par Parameters: None
+  * @retval 1 if a scan finished and a key or the slider changed, 0 otherwise
+  *****************************************************************************/
+int TouchPanel_Scan(void)
+{
+    unsigned short start = Sched_GetMicros();
+    unsigned short step = 0;
+    unsigned short cost = 0;
+    unsigned char state = 0;
+    int changed = 0;
+#if POWER_ENABLE
+    unsigned char held = Power_Hold();
+#endif
+    
+    PROFILE_START(PROFILE_TOUCH_SCAN);
+    
+    do
+    {
+        state = TSLState;
+        step = Sched_GetMicros();
+        
+        //Main function of the Touch Sensing library
+        PROFILE_START(PROFILE_TSL_ACTION);
+        TSL_Action();
+        PROFILE_END(PROFILE_TSL_ACTION);
+        
+        cost = (unsigned short)(Sched_GetMicros() - step + 
+                                TOUCH_COST_UNIT - 1) / TOUCH_COST_UNIT;
+        
+        if(state < TOUCH_STATE_COUNT && cost > touchCost[state])
+        {
+            touchCost[state] = (cost > 0xFF) ? 0xFF : (unsigned char)cost;
+        }
+    }
+    while(TSLState != TSL_IDLE_STATE && TSLState < TOUCH_STATE_COUNT &&
+          (unsigned short)(Sched_GetMicros() - start) + 
+          touchCost[TSLState] * TOUCH_COST_UNIT <= TOUCH_BUDGET);
+    
+    PROFILE_END(PROFILE_TOUCH_SCAN);
+    
+    changed = ReadKeys();
+    
+#if POWER_ENABLE
+    Power_Resume(held);
+    
+    if(touchKeys != 0 || touchSlider != TOUCH_NO_SLIDER)
+    {
+        Power_Wake();
+    }
+#endif
+    
+    return changed;
+}
+
+/*******************************************************************************
+  * @brief Get the keys touched as of the last finished scan
+  * @par Parameters: None
+  * @retval mask of TOUCH_KEY_ bits, one per key in the library's order
+  *****************************************************************************/
+unsigned char TouchPanel_GetKeys(void)
+{
+    return touchKeys;
+}
+
+/*******************************************************************************
+  * @brief Get the slider position as of the last finished scan
+  * @par Parameters: None
+  * @retval position from 0 to TOUCH_SLIDER_STEPS - 1, TOUCH_NO_SLIDER if it
+  *         is not touched or there is no slider
+  *****************************************************************************/
+unsigned char TouchPanel_GetSlider(void)
+{
+    return touchSlider;
+}
+
+/*******************************************************************************
+  * @brief Take the key states once a scan has finished with a change
+  * @par Parameters: None
+  * @retval 1 if they were taken, 0 otherwise
+  *****************************************************************************/
+int ReadKeys(void)
+{
+    unsigned char i = 0;
+    
+    //The global flags are those of every key together, a slider that moved
+    //has its position changed flag set until it is cleared here
+    if(!(TSL_GlobalSetting.b.CHANGED || TSL_GlobalSetting.b.POSCHANGED) || 
+       TSLState != TSL_IDLE_STATE)
+    {
+        return 0;
+    }
+    
+    TSL_GlobalSetting.b.CHANGED = 0;
+    TSL_GlobalSetting.b.POSCHANGED = 0;
+    touchKeys = 0;
+    
+    for(i = 0; i < NUMBER_OF_SINGLE_CHANNEL_KEYS; i++)
+    {
+        if(sSCKeyInfo[i].Setting.b.DETECTED)
+        {
+            touchKeys |= (unsigned char)(1 << i);
+        }
+    }
+    
+#if NUMBER_OF_MULTI_CHANNEL_KEYS > 0
+    sMCKeyInfo[0].Setting.b.POSCHANGED = 0;
+    touchSlider = sMCKeyInfo[0].Setting.b.DETECTED ? sMCKeyInfo[0].Position : 
+                                                      TOUCH_NO_SLIDER;
+#endif
+    
+    return 1;
+}
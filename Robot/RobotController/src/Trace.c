@@ -0,0 +1,132 @@
+/*******************************************************************************
+  * @file Trace.c
+  * @brief Implements the link trace recorder. Events from the UART
+  *        interrupts, the receive parser and the command dispatch go into a
+  *        ring that overwrites the oldest, so it always holds the traffic
+  *        just before it was stopped. Nothing is formatted on the robot, an
+  *        observer reads the ring back a page at a time over the bulk lane.
+  * @author David Sharpe
+  * @version V1.0.0
+  * @date 14-October-2026
+  *
+  * ST Visual Develop 4.2.1 using STM8 Cosmic C Compiler
+  *****************************************************************************/
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Includes
+////////////////////////////////////////////////////////////////////////////////
+#include "Trace.h"
+#include "Scheduler.h"
+#include "stm8s.h"
+
+#if TRACE_ENABLE
+
+////////////////////////////////////////////////////////////////////////////////
+// Variables
+////////////////////////////////////////////////////////////////////////////////
+//The indices are used by the UART interrupts for every byte, page zero
+TraceEvent traceRing[TRACE_SIZE];
+TINY unsigned char traceHead = 0;
+TINY unsigned char traceCount = 0;
+TINY unsigned char traceRunning = 0;
+
+
+/*******************************************************************************
+  * @brief Empty the ring and start recording
+  * @par Parameters: None
+  * @retval None
+  *****************************************************************************/
+void Trace_Start(void)
+{
+    disableInterrupts();
+    traceHead = 0;
+    traceCount = 0;
+    traceRunning = 1;
+    enableInterrupts();
+}
+
+/*******************************************************************************
+  * @brief Stop recording, the ring is kept so it can be read back as it was
+  * @par Parameters: None
+  * @retval None
+  *****************************************************************************/
+void Trace_Stop(void)
+{
+    traceRunning = 0;
+}
+
+/*******************************************************************************
+  * @brief Record an event. Called through TRACE from the main loop and from
+  *        interrupts of any level.
+  * @par Parameters:
+  * type - event type, see TraceType
+  * data - event data
+  * @retval None
+  *****************************************************************************/
+void Trace_Record(unsigned char type, unsigned char data)
+{
+    TraceEvent *event = 0;
+    unsigned char cc = 0;
+
+    if(!traceRunning)
+    {
+        return;
+    }
+
+    //A nested interrupt may record too, claim and fill the slot in one go
+    maskInterrupts(cc);
+
+    event = &traceRing[traceHead];
+    traceHead = (traceHead + 1) & (TRACE_SIZE - 1);
+
+    if(traceCount < TRACE_SIZE)
+    {
+        traceCount++;
+    }
+
+    event->type = type;
+    event->data = data;
+    event->time = (unsigned short)Sched_GetTime();
+
+    restoreInterrupts(cc);
+}
+
+/*******************************************************************************
+  * @brief Write a page of the report. Stop the recorder first for a
+  *        consistent read of the whole ring.
+  * @par Parameters:
+  * first - index of the first event to report, 0 is the oldest
+  * report - buffer of at least TRACE_REPORT_SIZE bytes
+  * @retval report length in bytes
+  *****************************************************************************/
+unsigned char Trace_GetReport(unsigned char first, unsigned char *report)
+{
+    TraceEvent *event = 0;
+    unsigned char oldest = 0;
+    unsigned char length = 2;
+    unsigned char i = 0;
+
+    disableInterrupts();
+
+    oldest = (traceHead - traceCount) & (TRACE_SIZE - 1);
+
+    report[0] = first;
+    report[1] = traceCount;
+
+    for(i = 0; i < TRACE_PAGE && first + i < traceCount; i++)
+    {
+        event = &traceRing[(oldest + first + i) & (TRACE_SIZE - 1)];
+
+        report[length++] = event->type;
+        report[length++] = event->data;
+        report[length++] = (unsigned char)event->time;
+        report[length++] = (unsigned char)(event->time >> 8);
+    }
+
+    enableInterrupts();
+
+    return length;
+}
+
+#endif
@@ -1,303 +1,444 @@
-/*******************************************************************************
-  * @file Uart.c
-  * @brief Implements the functions for interfacing with the STM8S UART
-  * @author David Sharpe
-  * @version V1.0.0
-  * @date 02-June-2015
-  *
-  * ST Visual Develop 4.2.1 using STM8 Cosmic C Compiler
-  *****************************************************************************/
-
-
-////////////////////////////////////////////////////////////////////////////////
-// Includes
-////////////////////////////////////////////////////////////////////////////////
-#include "Uart.h"
-#include "stm8s.h"
-#include "string.h"
-
-
-////////////////////////////////////////////////////////////////////////////////
-// Definitions
-////////////////////////////////////////////////////////////////////////////////
-
-
-////////////////////////////////////////////////////////////////////////////////
-// Prototypes
-////////////////////////////////////////////////////////////////////////////////
-int Uart_FifoEnqueue(unsigned char data);
-unsigned char Uart_FifoDequeue(void);
-bool Uart_FifoIsEmpty(void);
-bool Uart_FifoIsFull(void);
-void Uart_FifoClear(void);
-unsigned long Uart_FifoGetNextIndex(unsigned long index);
-
-
-////////////////////////////////////////////////////////////////////////////////
-// Variables
-////////////////////////////////////////////////////////////////////////////////
-unsigned char fifo[UART_BUFFER_SIZE] = {0};
-unsigned long enqueueIndex = 0;
-unsigned long dequeueIndex = 0;
-Callback rxCallback = 0;
-
-
-/*******************************************************************************
-  * @brief Insert data into the FIFO
-  * @par Parameters: 
-  * data - byte of data to insert
-  * @retval 1 is inserted succesfully, 0 otherwise
-  *****************************************************************************/
-int Uart_FifoEnqueue(unsigned char data)
-{
-    //Make sure we have allocated a memory buffer  
-    //to store the data in and that it is not full
-    if(!Uart_FifoIsFull())
-    {
-        //Insert a byte into the queue
-        fifo[enqueueIndex] = data;
-
-        //Circularly increment the enqueue index
-        enqueueIndex = Uart_FifoGetNextIndex(enqueueIndex);
-            
-        return 1;
-    }
-
-    return 0;	
-}
-
-/*******************************************************************************
-  * @brief Remove an element from the FIFO
-  * @par Parameters: 
-  * None
-  * @retval The dequeued element
-  *****************************************************************************/
-unsigned char Uart_FifoDequeue(void)
-{
-    unsigned char data = 0;
-
-    //Make sure we have allocated a memory buffer to 
-    //retrieve the data from and that the queue is not empty
-    if(!Uart_FifoIsEmpty())
-    {
-        //Remove a byte from the queue 
-        data = fifo[dequeueIndex];
-
-        //Circularly increment the dequeue index 
-        dequeueIndex = Uart_FifoGetNextIndex(dequeueIndex);
-    }
-
-    return data;		
-}
-
-/*******************************************************************************
-  * @brief Checks if the FIFO is empty
-  * @par Parameters: 
-  * None
-  * @retval true if FIFO is empty
-  *****************************************************************************/
-bool Uart_FifoIsEmpty(void)
-{
-    //If read index equals the write index, then FIFO is empty
-    return (dequeueIndex == enqueueIndex);
-}
-
-/*******************************************************************************
-  * @brief Checks if the FIFO is full
-  * @par Parameters: 
-  * None
-  * @retval true if FIFO is full
-  *****************************************************************************/
-bool Uart_FifoIsFull(void)
-{
-    //Compute the next index for a write operation
-    //If the next write index equals the read 
-    //index then the FIFO is considered full
-    return (Uart_FifoGetNextIndex(enqueueIndex) == dequeueIndex);		
-}
-
-/*******************************************************************************
-  * @brief Clear/Reset the FIFO
-  * @par Parameters: 
-  * None
-  * @retval None
-  *****************************************************************************/
-void Uart_FifoClear(void)
-{
-    unsigned long i = 0;
-
-    //Set the FIFO buffer to all zeros
-    for(i=0; i<UART_BUFFER_SIZE; ++i)
-    {
-        fifo[i] = 0;
-    }
-
-    //Reset insert and remove indexes
-    dequeueIndex = 0;
-    enqueueIndex = 0;
-}
-
-/*******************************************************************************
-  * @brief Compute the next buffer index
-  * @par Parameters: 
-  * index - Current buffer index value
-  * @retval Updated index
-  *****************************************************************************/
-unsigned long Uart_FifoGetNextIndex(unsigned long index)
-{
-    unsigned long next_index = index + 1;
-	
-    //Wrap the index value if it has gone beyond the end of the buffer
-    if(next_index >= UART_BUFFER_SIZE)
-    {
-        next_index = 0;
-    }
-	
-    return next_index;
-}
-  
-    
-/*******************************************************************************
-  * @brief Initialize the UART
-  * @par Parameters:
-  * None
-  * @retval None
-  *****************************************************************************/
-void Uart_Initialize(unsigned long baud)
-{
-    //Setup UART
-    UART2_DeInit();
-    
-    UART2_Init(baud,                          
-               UART2_WORDLENGTH_8D,
-               UART2_STOPBITS_1,
-               UART2_PARITY_NO,
-               UART2_SYNCMODE_CLOCK_DISABLE,  //no sync
-               UART2_MODE_TXRX_ENABLE);       //TX and RX enabled 
-
-    UART2_Cmd(ENABLE);
-}
-
-/*******************************************************************************
-  * @brief Send data using the UART
-  * @par Parameters:
-  * buffer - the data buffer
-  * length - number of bytes to send
-  * @retval None
-  *****************************************************************************/
-void Uart_Send(unsigned char *buffer, unsigned long length)
-{  
-    int i = 0;
-    
-    for(i = 0; i < length; ++i)
-    {
-        //Transmit data using UART
-        UART2_SendData8(buffer[i]);
-        
-        while(UART2_GetFlagStatus(UART2_FLAG_TXE) != SET)
-        {;}
-    }
-}
-
-/*******************************************************************************
-  * @brief Send a single byte using the UART
-  * @par Parameters:
-  * byte - the byte to send
-  * @retval None
-  *****************************************************************************/
-void Uart_SendByte(unsigned char byte)
-{  
-    //Transmit data using UART
-    UART2_SendData8(byte);
-        
-    while(UART2_GetFlagStatus(UART2_FLAG_TXE) != SET)
-    {;}
-}
-
-/*******************************************************************************
-  * @brief Interrupt service routine invoked when received data is ready 
-  * @par Parameters: None
-  * @retval None
-  *****************************************************************************/
-void Uart_ReceiveISR()
-{
-    unsigned char byte = 0;
-    
-    //UART2_ClearITPendingBit(UART2_IT_RXNE);
-    
-    byte = UART2_ReceiveData8();
-    
-    if(rxCallback)
-    {
-        rxCallback(byte);
-    }
-    
-    //Uart_FifoEnqueue(byte);
-}
-
-/*******************************************************************************
-  * @brief Checks if receive data is available in the FIFO
-  * @par Parameters: None
-  * @retval 1 if data is ready, 0 otherwise
-  *****************************************************************************/
-int Uart_IsRxDataReady(void)
-{
-    //If there is data in the RX FIFO
-    if(!Uart_FifoIsEmpty())
-    {
-        return 1;
-    }
-    
-    return 0;
-}
-
-/*******************************************************************************
-  * @brief Get a byte from the receive FIFO
-  * @par Parameters: None
-  * @retval byte from FIFO
-  *****************************************************************************/
-unsigned char Uart_GetRxData(void)
-{ 
-    return Uart_FifoDequeue();
-}
-
-/*******************************************************************************
-  * @brief Clear all data from the receive FIFO
-  * @par Parameters: None
-  * @retval None
-  *****************************************************************************/
-void Uart_ClearRxFifo(void)
-{ 
-    Uart_FifoClear();
-}
-
-/*******************************************************************************
-  * @brief Enable UART receive interrupt
-  * @par Parameters: None
-  * @retval None
-  *****************************************************************************/
-void Uart_EnableRxInterrupt(void)
-{
-    UART2_ITConfig(UART2_IT_RXNE, ENABLE);
-}
-
-/*******************************************************************************
-  * @brief Set a callback to be invoked when UART receive interrupt occurs
-  * @par Parameters: callback function pointer
-  * @retval None
-  *****************************************************************************/
-void Uart_SetRxCallback(Callback func)
-{
-    rxCallback = func;
-}
-
-/*******************************************************************************
-  * @brief Send a string using the UART
-  * @par Parameters: 
-  * str - null terminated string to send
-  * @retval None
-  *****************************************************************************/
-void Uart_Print(char *str)
-{
-    Uart_Send(str, strlen(str));
+/*******************************************************************************
+  * @file Uart.c
+  * @brief Implements the functions for interfacing with the STM8S UART
+  * @author David Sharpe
+  * @version V1.0.0
+  * @date 02-June-2015
+  *
+  * ST Visual Develop 4.2.1 using STM8 Cosmic C Compiler
+  *****************************************************************************/
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Includes
+////////////////////////////////////////////////////////////////////////////////
+#include "Uart.h"
+#include "Power.h"
+#include "Profile.h"
+#include "Ring.h"
+#include "Scheduler.h"
+#include "Trace.h"
+#include "stm8s.h"
+#include "FastIo.h"
+#include "string.h"
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Definitions
+////////////////////////////////////////////////////////////////////////////////
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Variables
+////////////////////////////////////////////////////////////////////////////////
+
+//Receive ring, filled by the UART2 RX interrupt and drained from main 
+//context. The idle ring holds the receive ring head at each idle line so 
+//the consumer sees the idle in order with the data. The interrupts run for
+//every byte, so the rings they touch and the error counts are in page zero.
+RING_DEFINE_TINY(rxRing, UART_BUFFER_SIZE);
+RING_DEFINE_TINY(idleRing, UART_IDLE_MARKS);
+
+//Receive error counts, see UartError
+TINY volatile unsigned short rxErrors[UART_ERROR_COUNT] = {0};
+
+//Transmit ring, filled from main context and drained by the UART2 TX 
+//interrupt
+RING_DEFINE_TINY(txRing, UART_TX_BUFFER_SIZE);
+
+  
+/*******************************************************************************
+  * @brief Initialize the UART. May be called again to change the baud rate,
+  *        the interrupts are disabled and must be enabled again.
+  * @par Parameters:
+  * baud - baud rate
+  * @retval None
+  *****************************************************************************/
+void Uart_Initialize(unsigned long baud)
+{
+    unsigned short divider = 0;
+    
+    //Setup UART
+    UART2_DeInit();
+    
+    UART2_Init(baud,                          
+               UART2_WORDLENGTH_8D,
+               UART2_STOPBITS_1,
+               UART2_PARITY_NO,
+               UART2_SYNCMODE_CLOCK_DISABLE,  //no sync
+               UART2_MODE_TXRX_ENABLE);       //TX and RX enabled 
+
+    //The library truncates the divider, 2.1% fast at 460800 baud from 
+    //16MHz. Round it to the nearest instead, BRR2 must be written first.
+    divider = (unsigned short)((CLK_GetClockFreq() + baud / 2) / baud);
+    UART2->BRR2 = (unsigned char)(((divider >> 8) & 0xF0) | (divider & 0x0F));
+    UART2->BRR1 = (unsigned char)(divider >> 4);
+
+    UART2_Cmd(ENABLE);
+    
+#if UART_FLOW_CONTROL
+    //RTS is active low, the module may send
+    GPIO_Init(UART_RTS_PORT, UART_RTS_PIN, GPIO_MODE_OUT_PP_LOW_FAST);
+#endif
+}
+
+/*******************************************************************************
+  * @brief Send data using the UART. Data is queued in the transmit ring 
+  *        buffer, this only blocks while waiting for room in the ring.
+  * @par Parameters:
+  * buffer - the data buffer
+  * length - number of bytes to send
+  * @retval None
+  *****************************************************************************/
+void Uart_Send(unsigned char *buffer, unsigned short length)
+{  
+    unsigned short i = 0;
+    
+    for(i = 0; i < length; ++i)
+    {
+        Uart_SendByte(buffer[i]);
+    }
+}
+
+/*******************************************************************************
+  * @brief Send a single byte using the UART. Blocks while the transmit ring
+  *        buffer is full.
+  * @par Parameters:
+  * byte - the byte to send
+  * @retval None
+  *****************************************************************************/
+void Uart_SendByte(unsigned char byte)
+{  
+    //Wait for the TX interrupt to make room in the ring
+    while(!Ring_Put(&txRing, byte))
+    {;}
+    
+    //Make sure the TX interrupt is running to drain the ring
+    UART2_ITConfig(UART2_IT_TXE, ENABLE);
+}
+
+/*******************************************************************************
+  * @brief Queue data for transmission without blocking. Either the whole 
+  *        buffer is queued or nothing is, so messages are never split.
+  * @par Parameters:
+  * buffer - the data buffer
+  * length - number of bytes to send
+  * @retval 1 if the data was queued, 0 if the ring does not have room
+  *****************************************************************************/
+int Uart_SendAsync(unsigned char *buffer, unsigned short length)
+{
+    //Report back-pressure if the whole message does not fit
+    if(length > Uart_GetTxSpace() || 
+       !Ring_Write(&txRing, buffer, (unsigned char)length))
+    {
+        return 0;
+    }
+    
+    //Start the TX interrupt to drain the ring
+    UART2_ITConfig(UART2_IT_TXE, ENABLE);
+    
+    return 1;
+}
+
+/*******************************************************************************
+  * @brief Start building a command straight into the transmit ring, see 
+  *        CmdBuilder.h. Nothing is sent until Uart_EndCommand.
+  * @par Parameters:
+  * cmd - the builder
+  * @retval None
+  *****************************************************************************/
+void Uart_BeginCommand(CmdBuilder *cmd)
+{
+    Cmd_BeginRing(cmd, &txRing);
+}
+
+/*******************************************************************************
+  * @brief Send the command built since Uart_BeginCommand. Like 
+  *        Uart_SendAsync, the whole command is sent or none of it.
+  * @par Parameters:
+  * cmd - the builder
+  * @retval 1 if the command was queued, 0 if the ring does not have room
+  *****************************************************************************/
+int Uart_EndCommand(CmdBuilder *cmd)
+{
+    if(!Cmd_End(cmd))
+    {
+        return 0;
+    }
+    
+    //Start the TX interrupt to drain the ring
+    UART2_ITConfig(UART2_IT_TXE, ENABLE);
+    
+    return 1;
+}
+
+/*******************************************************************************
+  * @brief Get the number of free bytes in the transmit ring buffer
+  * @par Parameters: None
+  * @retval number of bytes that can be queued
+  *****************************************************************************/
+unsigned short Uart_GetTxSpace(void)
+{
+    return Ring_Space(&txRing);
+}
+
+/*******************************************************************************
+  * @brief Checks if all queued transmit data has been handed to the UART
+  * @par Parameters: None
+  * @retval 1 if the transmit ring is empty, 0 otherwise
+  *****************************************************************************/
+int Uart_IsTxEmpty(void)
+{
+    return (Ring_Count(&txRing) == 0);
+}
+
+/*******************************************************************************
+  * @brief Interrupt service routine invoked when the transmit data register 
+  *        is empty. Sends the next byte from the transmit ring.
+  * @par Parameters: None
+  * @retval None
+  *****************************************************************************/
+void Uart_TransmitISR(void)
+{
+    unsigned char byte = 0;
+    
+    if(!RING_IS_EMPTY(txRing))
+    {
+        RING_GET(txRing, UART_TX_BUFFER_SIZE, byte);
+        
+        //Send the next byte, writing the data register clears TXE
+        UART2_SendData8(byte);
+        TRACE(TRACE_UART_TX, byte);
+    }
+    else
+    {
+        //Nothing left to send, stop the interrupt until more data is queued
+        UART2_ITConfig(UART2_IT_TXE, DISABLE);
+    }
+}
+
+/*******************************************************************************
+  * @brief Interrupt service routine invoked when received data is ready or
+  *        the receive line goes idle
+  * @par Parameters: None
+  * @retval None
+  *****************************************************************************/
+void Uart_ReceiveISR()
+{
+    unsigned char byte = 0;
+    unsigned char sr = UART2->SR;
+    
+    //The rest of the frame comes in at full speed
+    POWER_WAKE_FROM_ISR();
+    
+    PROFILE_START(PROFILE_UART_RX_ISR);
+    
+    //UART2_ClearITPendingBit(UART2_IT_RXNE);
+    
+    //Reading SR then DR clears RXNE, IDLE and the error flags
+    byte = UART2_ReceiveData8();
+    
+    //The byte in DR is good after an overrun, the ones after it were lost
+    if(sr & (UART2_SR_OR | UART2_SR_NF | UART2_SR_FE))
+    {
+        TRACE(TRACE_UART_ERROR, sr);
+        
+        if(sr & UART2_SR_OR)
+        {
+            rxErrors[UART_ERROR_OVERRUN]++;
+        }
+        
+        if(sr & UART2_SR_NF)
+        {
+            rxErrors[UART_ERROR_NOISE]++;
+        }
+        
+        if(sr & UART2_SR_FE)
+        {
+            rxErrors[UART_ERROR_FRAMING]++;
+            sr &= ~UART2_SR_RXNE;
+        }
+    }
+    
+    //Only queue the byte, it is parsed from main context
+    if(sr & UART2_SR_RXNE)
+    {
+        TRACE(TRACE_UART_RX, byte);
+        
+        if(RING_IS_FULL(rxRing, UART_BUFFER_SIZE))
+        {
+            rxErrors[UART_ERROR_RING_FULL]++;
+        }
+        else
+        {
+            RING_PUT(rxRing, UART_BUFFER_SIZE, byte);
+        }
+    }
+    
+    //Mark the idle line after the last byte
+    if((sr & UART2_SR_IDLE) && !RING_IS_FULL(idleRing, UART_IDLE_MARKS))
+    {
+        RING_PUT(idleRing, UART_IDLE_MARKS, rxRing.head);
+    }
+    
+#if UART_FLOW_CONTROL
+    //Hold the module until the consumer catches up, it lets go again
+    if((unsigned char)(rxRing.head - rxRing.tail) >= UART_RX_HIGH_WATER)
+    {
+        UART_RTS_PORT->ODR |= UART_RTS_PIN;
+    }
+#endif
+    
+    PROFILE_END(PROFILE_UART_RX_ISR);
+}
+
+/*******************************************************************************
+  * @brief Get the next receive event, a byte or the idle line that followed
+  *        a burst, in the order they happened
+  * @par Parameters:
+  * byte - receives the byte for UART_RX_BYTE
+  * @retval UART_RX_NONE, UART_RX_BYTE or UART_RX_IDLE
+  *****************************************************************************/
+unsigned char Uart_GetRxEvent(unsigned char *byte)
+{
+    unsigned char mark = 0;
+    
+    //An idle line is due once the bytes before it have been taken
+    if(Ring_Peek(&idleRing, &mark) && mark == rxRing.tail)
+    {
+        Ring_Get(&idleRing, &mark);
+        return UART_RX_IDLE;
+    }
+    
+    return Ring_Get(&rxRing, byte) ? UART_RX_BYTE : UART_RX_NONE;
+}
+
+/*******************************************************************************
+  * @brief Get the number of received bytes waiting
+  * @par Parameters: None
+  * @retval byte count
+  *****************************************************************************/
+unsigned char Uart_GetRxCount(void)
+{
+    return Ring_Count(&rxRing);
+}
+
+/*******************************************************************************
+  * @brief Checks if receive data is available in the FIFO
+  * @par Parameters: None
+  * @retval 1 if data is ready, 0 otherwise
+  *****************************************************************************/
+int Uart_IsRxDataReady(void)
+{
+    return (Ring_Count(&rxRing) != 0);
+}
+
+/*******************************************************************************
+  * @brief Get a byte from the receive FIFO, idle line events are skipped
+  * @par Parameters: None
+  * @retval byte from FIFO, 0 if it is empty
+  *****************************************************************************/
+unsigned char Uart_GetRxData(void)
+{ 
+    unsigned char byte = 0;
+    
+    while(Uart_GetRxEvent(&byte) == UART_RX_IDLE)
+    {;}
+    
+    return byte;
+}
+
+/*******************************************************************************
+  * @brief Clear all data and idle line events from the receive FIFO
+  * @par Parameters: None
+  * @retval None
+  *****************************************************************************/
+void Uart_ClearRxFifo(void)
+{ 
+    Ring_Clear(&rxRing);
+    Ring_Clear(&idleRing);
+}
+
+/*******************************************************************************
+  * @brief Enable UART receive interrupt
+  * @par Parameters: None
+  * @retval None
+  *****************************************************************************/
+void Uart_EnableRxInterrupt(void)
+{
+    UART2_ITConfig(UART2_IT_RXNE, ENABLE);
+}
+
+/*******************************************************************************
+  * @brief Enable UART idle line interrupt
+  * @par Parameters: None
+  * @retval None
+  *****************************************************************************/
+void Uart_EnableIdleInterrupt(void)
+{
+    UART2_ITConfig(UART2_IT_IDLE, ENABLE);
+}
+
+/*******************************************************************************
+  * @brief Get the number of receive errors of one kind since start up. The
+  *        RX interrupt counts them, so the two bytes are read with it 
+  *        masked.
+  * @par Parameters:
+  * error - one of UartError
+  * @retval error count
+  *****************************************************************************/
+unsigned short Uart_GetErrorCount(unsigned char error)
+{
+    unsigned short count = 0;
+    unsigned char cc = 0;
+    
+    if(error >= UART_ERROR_COUNT)
+    {
+        return 0;
+    }
+    
+    maskInterrupts(cc);
+    count = rxErrors[error];
+    restoreInterrupts(cc);
+    
+    return count;
+}
+
+/*******************************************************************************
+  * @brief Ask the module to hold its data, or let it send again. The module
+  *        is also held while the receive ring is above UART_RX_HIGH_WATER. 
+  *        Call from main context after draining the ring to release that 
+  *        hold. Does nothing unless UART_FLOW_CONTROL is set.
+  * @par Parameters:
+  * hold - 1 to hold the data, 0 to let it send
+  * @retval None
+  *****************************************************************************/
+void Uart_SetRxHold(unsigned char hold)
+{
+#if UART_FLOW_CONTROL
+    //The RX interrupt may set the hold between the check and the write
+    disableInterrupts();
+    
+    if(hold || Ring_Count(&rxRing) >= UART_RX_HIGH_WATER)
+    {
+        UART_RTS_PORT->ODR |= UART_RTS_PIN;
+    }
+    else
+    {
+        UART_RTS_PORT->ODR &= (unsigned char)~UART_RTS_PIN;
+    }
+    
+    enableInterrupts();
+#endif
+}
+
+/*******************************************************************************
+  * @brief Send a string using the UART
+  * @par Parameters: 
+  * str - null terminated string to send
+  * @retval None
+  *****************************************************************************/
+void Uart_Print(char *str)
+{
+    Uart_Send(str, strlen(str));
 }
\ No newline at end of file
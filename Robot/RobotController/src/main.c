@@ -1,300 +1,1688 @@
-/*******************************************************************************
-  * @file main.c
-  * @brief This file contains the main function for the robot driver
-  * @author David Sharpe
-  * @version V1.0.0
-  * @date 02-June-2015
-  *
-  * ST Visual Develop 4.2.1 using STM8 Cosmic C Compiler
-  *****************************************************************************/
-
-
-////////////////////////////////////////////////////////////////////////////////
-// Includes
-////////////////////////////////////////////////////////////////////////////////
-#include "DriveController.h"
-#include "Esp8266.h"
-#include "Uart.h"
-#include "stm8s.h"
-#include "stm8_tsl_api.h"
-
-
-////////////////////////////////////////////////////////////////////////////////
-// Definitions
-////////////////////////////////////////////////////////////////////////////////
-#define TICK_TIMEOUT    1 //ms
-
-
-/*******************************************************************************
-  * @brief Configures STM8 clocks
-  * @par Parameters: None
-  * @retval None
-  *****************************************************************************/
-void CLK_Configuration(void)
-{
-    //Fmaster = 16MHz
-
-    //Scale master clock prescaler 
-    CLK_HSIPrescalerConfig(CLK_PRESCALER_HSIDIV1);
-
-    //Set CPU clock prescaler
-    CLK_SYSCLKConfig(CLK_PRESCALER_CPUDIV1);
-
-    //Disable unused peripheral clocks to save power
-    CLK_PeripheralClockConfig(CLK_PERIPHERAL_I2C, DISABLE);
-    CLK_PeripheralClockConfig(CLK_PERIPHERAL_SPI, DISABLE);    
-    CLK_PeripheralClockConfig(CLK_PERIPHERAL_ADC, DISABLE);
-    CLK_PeripheralClockConfig(CLK_PERIPHERAL_AWU, DISABLE);
-    //CLK_PeripheralClockConfig(CLK_PERIPHERAL_TIMER3, DISABLE); //For TSL
-    CLK_PeripheralClockConfig(CLK_PERIPHERAL_TIMER4, DISABLE);
-    //CLK_PeripheralClockConfig(CLK_PERIPHERAL_TIMER1, DISABLE);
-    //CLK_PeripheralClockConfig(CLK_PERIPHERAL_TIMER2, DISABLE);
-    //CLK_PeripheralClockConfig(CLK_PERIPHERAL_UART2, DISABLE);
-}
-
-/*******************************************************************************
-  * @brief Configures timer used for timing/scheduling
-  * @par Parameters: None
-  * @retval None
-  *****************************************************************************/
-void Init_Timer(void)
-{
-    //Number of periods that pass before update event occurs
-    uint32_t timeout = TICK_TIMEOUT;
-
-    //Set prescaler for master clock
-    //Note final prescaler register value is prescaler + 1
-    uint16_t prescaler = 1000 - 1;
-
-    //Set base period for 1ms
-    uint16_t period = CLK_GetClockFreq() / 1000000 - 1;
-
-    //Timer 1 Peripheral Configuration
-    TIM1_DeInit();
-
-    //Init timer 1 registers  
-    TIM1_TimeBaseInit(prescaler, TIM1_COUNTERMODE_UP, period, timeout - 1);
-
-    //Enables timer peripheral Preload register on ARR
-    TIM1_ARRPreloadConfig(ENABLE);
-
-    //Enable timer
-    TIM1_Cmd(ENABLE);
-}
-
-/*******************************************************************************
-  * @brief Configures LED GPIO
-  * @par Parameters: None
-  * @retval None
-  *****************************************************************************/
-void InitLED(void)
-{
-    //Reset GPIO port A, D, and G
-    GPIO_DeInit(GPIOD);
-  
-    //Configure PD0 (LED1) as output push-pull low (led switched on)
-    GPIO_Init(GPIOD, GPIO_PIN_0, GPIO_MODE_OUT_PP_LOW_FAST);
-}
-
-/*******************************************************************************
-  * @brief Toggle PD0 (Led LD1)
-  * @par Parameters: None
-  * @retval None
-  *****************************************************************************/
-void ToggleLED(void)
-{
-    GPIO_WriteReverse(GPIOD, GPIO_PIN_0);
-}
-
-/*******************************************************************************
-  * @brief Initialize the capacitive touch button
-  * @par Parameters: None
-  * @retval None
-  *****************************************************************************/
-void TouchSensePadInit(void)
-{
-    u8 i;
-
-    //Initialize Touch Sensing library
-    TSL_Init();
-    
-    //All keys are implemented and enabled
-
-    for (i = 0; i < NUMBER_OF_SINGLE_CHANNEL_KEYS; i++)
-    {
-        sSCKeyInfo[i].Setting.b.IMPLEMENTED = 1;
-        sSCKeyInfo[i].Setting.b.ENABLED = 1;
-        sSCKeyInfo[i].DxSGroup = 0x01; //Put 0x00 to disable the DES on these pins
-    }
-
-#if NUMBER_OF_MULTI_CHANNEL_KEYS > 0
-    for (i = 0; i < NUMBER_OF_MULTI_CHANNEL_KEYS; i++)
-    {
-        sMCKeyInfo[i].Setting.b.IMPLEMENTED = 1;
-        sMCKeyInfo[i].Setting.b.ENABLED = 1;
-        sMCKeyInfo[i].DxSGroup = 0x01; //Put 0x00 to disable the DES on these pins
-    }
-#endif
-    
-    //Start the 100ms timebase Timer
-    TSL_Tick_Flags.b.User1_Start_100ms = 1;
-}
-
-/*******************************************************************************
-  * @brief Check if touch sense pad has been touched
-  * @par Parameters: None
-  * @retval 1 if touched, 0 otherwise
-  *****************************************************************************/
-int IsTouchSensePressed(void)
-{
-    if ((TSL_GlobalSetting.b.CHANGED) && (TSLState == TSL_IDLE_STATE))
-    {
-        TSL_GlobalSetting.b.CHANGED = 0;
-
-        // If KEY 1 touched
-        if (sSCKeyInfo[0].Setting.b.DETECTED) 
-        {
-            return 1;
-        }
-    }
-
-    return 0; 
-}
-
-/*******************************************************************************
-  * @brief Check timer status
-  * @par Parameters: None
-  * @retval 1 if timer update event is set, 0 otherwise
-  *****************************************************************************/
-int IsTimerExpired(void)
-{
-    if (TIM1_GetFlagStatus(TIM1_FLAG_UPDATE) == SET)
-    {
-      TIM1_ClearFlag(TIM1_FLAG_UPDATE);
-      return 1;
-    }
-    
-    return 0;
-}
-
-/*******************************************************************************
-  * @brief Initialize the system
-  * @par Parameters: None
-  * @retval None
-  *****************************************************************************/
-void Initialize(void)
-{
-    int i = 1000;
-    
-    //Configures clocks
-    CLK_Configuration();
-
-    //Configures LED GPIO
-    InitLED();
-    
-    //Initialize the timer for process timing
-    Init_Timer();
-    
-    //Initialize Touch Sensing button
-    TouchSensePadInit();
-    
-    //Initialize the motor drive controller
-    DriveCtrl_Initialize();
-    
-    while(i)
-    {  
-        if(IsTimerExpired())
-        {
-            i--;          
-        }
-    }
-  
-    enableInterrupts();
-    
-    //Initialize WiFi interface
-    Esp8266_Initialize();
-    
-    //Set the access point name
-    Esp8266_SetAccessPointName("STM8S_Robot");
-    
-    //Set up a UDP socket
-    Esp8266_StartClient(ESP8266_UDP, "192.168.4.2", 49999);
-    
-    //Start TCP server
-    //Esp8266_StartTcpServer(49999);
-}
-
-/*******************************************************************************
-  * @brief main entry point
-  * @par Parameters: None
-  * @retval None
-  *****************************************************************************/
-void main(void)
-{
-    int led_count = 0;
-
-    unsigned char packet[ESP8266_RX_BUFFER_SIZE] = {0};
-    unsigned short length = 0;
-    
-    //Initialize the system
-    Initialize();
-    
-    //Set initial state to stopped
-    DriveCtrl_SetSpeed(0);
-    DriveCtrl_Stop();
-    
-    // Main loop
-    while (1)
-    {    
-        if (IsTimerExpired())
-        {     
-            if(++led_count >= 250)
-            {
-                ToggleLED();
-                led_count = 0;          
-            }
-        }     
-
-        //Check for received Wifi packets
-        if(length = Esp8266_ReceiveMsg(packet))
-        {
-            //Process the message received from the controller. 
-            switch(packet[0])
-            {
-                case STOP:
-                    DriveCtrl_Stop();
-                    DriveCtrl_SetSpeed(0);
-                    break;
-                case FORWARD:
-                    DriveCtrl_Forward();
-                    DriveCtrl_SetSpeed(packet[1]);
-                    break;
-                case BACKWARD:
-                    DriveCtrl_Backward();
-                    DriveCtrl_SetSpeed(packet[1]);
-                    break;
-                case LEFT:
-                    DriveCtrl_Turn(LEFT);
-                    DriveCtrl_SetSpeed(packet[1]);
-                    break;
-                case RIGHT:
-                    DriveCtrl_Turn(RIGHT);
-                    DriveCtrl_SetSpeed(packet[1]);
-                    break;
-            };
-            
-            //Echo packet
-            Esp8266_SendMsg(packet, length);
-        }
-  
-        //Main function of the Touch Sensing library
-        TSL_Action();
-        
-        //Has touch sense button been touched
-        if(IsTouchSensePressed())
-        {       
-            Esp8266_SendMsg("Hello", 5);
-        }
-    }
-}
-
+/*******************************************************************************
+  * @file main.c
+  * @brief This file contains the main function for the robot driver
+  * @author David Sharpe
+  * @version V1.0.0
+  * @date 02-June-2015
+  *
+  * ST Visual Develop 4.2.1 using STM8 Cosmic C Compiler
+  *****************************************************************************/
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Includes
+////////////////////////////////////////////////////////////////////////////////
+#include "Benchmark.h"
+#include "Board.h"
+#include "Calibration.h"
+#include "Clock.h"
+#include "Config.h"
+#include "DriveController.h"
+#include "Esp8266.h"
+#include "Failsafe.h"
+#include "Gesture.h"
+#include "Latency.h"
+#include "Load.h"
+#include "Log.h"
+#include "Memory.h"
+#include "MicroBench.h"
+#include "Odometry.h"
+#include "Ota.h"
+#include "Path.h"
+#include "Pool.h"
+#include "Power.h"
+#include "Profile.h"
+#include "Protocol.h"
+#include "Range.h"
+#include "Scheduler.h"
+#include "Sequencer.h"
+#include "Setpoint.h"
+#include "Soak.h"
+#include "Telemetry.h"
+#include "TouchPanel.h"
+#include "Trace.h"
+#include "Uart.h"
+#include "stm8s.h"
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Definitions
+////////////////////////////////////////////////////////////////////////////////
+//Task periods
+#define LED_PERIOD          250 //ms
+#define TOUCH_PERIOD        5   //ms between touch acquisition steps
+
+//Set to 1 to skip touch acquisition while the motor outputs are changing,
+//a false touch is most likely then
+#define TOUCH_SKIP_SWITCHING    1
+#define TOUCH_SETTLE_TIME       3 //ms after a motor output change
+#define ACK_INTERVAL        50 //ms between cumulative acknowledgements
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Variables
+////////////////////////////////////////////////////////////////////////////////
+unsigned char ackMode = PROTO_ACK_CUMULATIVE;
+unsigned char ackPending = 0;
+
+//Arrival time of the packet being processed, for the benchmark
+unsigned short packetTime = 0;
+
+#if LATENCY_ENABLE
+//Time the main loop took the packet being processed, for the latency probe
+unsigned short packetTaken = 0;
+#endif
+
+//Busy count at the last telemetry batch, for the rate adaptation
+unsigned short telemetryBusy = 0;
+
+//Link the frame being processed came in on, reports go back on it
+unsigned char replyLink = ESP8266_PRIMARY_LINK;
+
+//Set by PeekCommand when the frame being peeked stopped the wheels
+unsigned char stopApplied = 0;
+
+//Set by a touch of the key, the remote may not move the wheels until a
+//double tap or a long press lets them go
+unsigned char touchHold = 0;
+
+#if TOUCH_PANEL_ENABLE
+//Panel keys down at the last touch task run, a preset is taken as its key 
+//goes down
+unsigned char touchPresets = 0;
+#endif
+
+#if MICRO_ENABLE
+//Microbenchmark requested, run once the packet asking for it is released
+unsigned char microPending = 0;
+unsigned char microLink = ESP8266_PRIMARY_LINK;
+#endif
+
+
+/*******************************************************************************
+  * @brief Configures STM8 clocks
+  * @par Parameters: None
+  * @retval None
+  *****************************************************************************/
+void CLK_Configuration(void)
+{
+    //Fmaster = 16MHz
+
+    //Scale master clock prescaler 
+    CLK_HSIPrescalerConfig(CLK_PRESCALER_HSIDIV1);
+
+    //Set CPU clock prescaler
+    CLK_SYSCLKConfig(CLK_PRESCALER_CPUDIV1);
+
+    //Disable unused peripheral clocks to save power
+    CLK_PeripheralClockConfig(CLK_PERIPHERAL_I2C, DISABLE);
+#if !ESP8266_SPI_LINK
+    CLK_PeripheralClockConfig(CLK_PERIPHERAL_SPI, DISABLE);    
+#endif
+    //CLK_PeripheralClockConfig(CLK_PERIPHERAL_ADC, DISABLE); //For telemetry
+    CLK_PeripheralClockConfig(CLK_PERIPHERAL_AWU, DISABLE);
+    //CLK_PeripheralClockConfig(CLK_PERIPHERAL_TIMER3, DISABLE); //For TSL
+    CLK_PeripheralClockConfig(CLK_PERIPHERAL_TIMER4, DISABLE); //TSL ticks on TIM1
+    //CLK_PeripheralClockConfig(CLK_PERIPHERAL_TIMER1, DISABLE);
+    //CLK_PeripheralClockConfig(CLK_PERIPHERAL_TIMER2, DISABLE);
+#if ESP8266_SPI_LINK
+    CLK_PeripheralClockConfig(CLK_PERIPHERAL_UART2, DISABLE); //Module on SPI
+#else
+    //CLK_PeripheralClockConfig(CLK_PERIPHERAL_UART2, DISABLE);
+#endif
+}
+
+/*******************************************************************************
+  * @brief Set the interrupt software priorities. A higher level nests in a 
+  *        lower one, so a received byte is taken from the UART within a few
+  *        cycles whatever else is running. An encoder edge is timestamped
+  *        next, level with the PWM commit so the motor pins follow their
+  *        duty closely, and with the overcurrent trip that shares the pins.
+  *        The tick with the touch timebase, the ADC scan, the range echo
+  *        capture and UART transmit can wait. On the SPI link the SPI takes
+  *        the UART receive level and the module's ready input waits.
+  * @par Parameters: None
+  * @retval None
+  *****************************************************************************/
+void ITC_Configuration(void)
+{
+    //The priorities can only be written with interrupts masked
+    disableInterrupts();
+    
+    ITC_SetSoftwarePriority(ITC_IRQ_UART2_RX, ITC_PRIORITYLEVEL_3);
+    ITC_SetSoftwarePriority(ITC_IRQ_PORTB, ITC_PRIORITYLEVEL_2);
+    ITC_SetSoftwarePriority(ITC_IRQ_TIM2_OVF, ITC_PRIORITYLEVEL_2);
+    ITC_SetSoftwarePriority(ITC_IRQ_PORTE, ITC_PRIORITYLEVEL_2);
+    ITC_SetSoftwarePriority(ITC_IRQ_TIM1_OVF, ITC_PRIORITYLEVEL_1);
+    ITC_SetSoftwarePriority(ITC_IRQ_ADC1, ITC_PRIORITYLEVEL_1);
+    ITC_SetSoftwarePriority(ITC_IRQ_TIM1_CAPCOM, ITC_PRIORITYLEVEL_1);
+    ITC_SetSoftwarePriority(ITC_IRQ_UART2_TX, ITC_PRIORITYLEVEL_1);
+#if ESP8266_SPI_LINK
+    ITC_SetSoftwarePriority(ITC_IRQ_SPI, ITC_PRIORITYLEVEL_3);
+    ITC_SetSoftwarePriority(ITC_IRQ_PORTD, ITC_PRIORITYLEVEL_1);
+#endif
+}
+
+/*******************************************************************************
+  * @brief Configures LED GPIO
+  * @par Parameters: None
+  * @retval None
+  *****************************************************************************/
+void InitLED(void)
+{
+    //Reset the LED port
+    GPIO_DeInit(BOARD_LED_PORT);
+  
+    //Configure the LED as output push-pull low (led switched on)
+    GPIO_Init(BOARD_LED_PORT, BOARD_LED_PIN, GPIO_MODE_OUT_PP_LOW_FAST);
+}
+
+/*******************************************************************************
+  * @brief Toggle the status LED
+  * @par Parameters: None
+  * @retval None
+  *****************************************************************************/
+void ToggleLED(void)
+{
+    GPIO_WriteReverse(BOARD_LED_PORT, BOARD_LED_PIN);
+}
+
+/*******************************************************************************
+  * @brief Answer a ping straight away. The time taken to get here from the 
+  *        +IPD header and to queue the pong is recorded by the benchmark.
+  * @par Parameters:
+  * tag - 16-bit ping tag, returned unchanged
+  * @retval None
+  *****************************************************************************/
+void SendPong(const unsigned char *tag)
+{
+    unsigned char payload[4];
+    unsigned char frame[4 + PROTO_OVERHEAD];
+    unsigned char length = 0;
+    unsigned short dispatchTime = Sched_GetMicros();
+    
+    Bench_Record(BENCH_RX_TO_DISPATCH, dispatchTime - packetTime);
+    
+    payload[0] = PROTO_CMD_PONG;
+    payload[1] = 2;
+    payload[2] = tag[0];
+    payload[3] = tag[1];
+    
+    length = Protocol_BuildFrame(frame, payload, sizeof(payload));
+    Esp8266_SendMsg(frame, length);
+    
+    Bench_Record(BENCH_DISPATCH_TO_SENT, Sched_GetMicros() - dispatchTime);
+}
+
+/*******************************************************************************
+  * @brief Answer a clock query straight away with the controller's time and
+  *        the robot's, the controller halves the round trip to find the 
+  *        offset
+  * @par Parameters:
+  * time - controller time of the query, 4 bytes returned unchanged
+  * @retval None
+  *****************************************************************************/
+void SendClock(const unsigned char *time)
+{
+    unsigned char payload[10];
+    unsigned char frame[10 + PROTO_OVERHEAD];
+    unsigned char length = 0;
+    unsigned long now = Sched_GetTime();
+    
+    payload[0] = PROTO_CMD_CLOCK_REPLY;
+    payload[1] = 8;
+    payload[2] = time[0];
+    payload[3] = time[1];
+    payload[4] = time[2];
+    payload[5] = time[3];
+    payload[6] = (unsigned char)now;
+    payload[7] = (unsigned char)(now >> 8);
+    payload[8] = (unsigned char)(now >> 16);
+    payload[9] = (unsigned char)(now >> 24);
+    
+    length = Protocol_BuildFrame(frame, payload, sizeof(payload));
+    Esp8266_SendMsg(frame, length);
+}
+
+/*******************************************************************************
+  * @brief Send a reply to the frame being processed, on the bulk lane if it 
+  *        came from an observer
+  * @par Parameters:
+  * frame - frame to send
+  * length - frame length in bytes
+  * @retval 1 if the reply was queued, 0 otherwise
+  *****************************************************************************/
+int SendReply(const unsigned char *frame, unsigned char length)
+{
+    if(replyLink == ESP8266_PRIMARY_LINK)
+    {
+        return Esp8266_SendMsg(frame, length);
+    }
+    
+    return Esp8266_SendBulk(replyLink, frame, length);
+}
+
+/*******************************************************************************
+  * @brief Send the benchmark statistics
+  * @par Parameters: None
+  * @retval None
+  *****************************************************************************/
+void SendBenchReport(void)
+{
+    unsigned char payload[2 + BENCH_REPORT_SIZE];
+    unsigned char frame[2 + BENCH_REPORT_SIZE + PROTO_OVERHEAD];
+    unsigned char length = 0;
+    
+    payload[0] = PROTO_CMD_STATS;
+    payload[1] = Bench_GetReport(&payload[2]);
+    
+    length = Protocol_BuildFrame(frame, payload, payload[1] + 2);
+    SendReply(frame, length);
+}
+
+#if MICRO_ENABLE
+/*******************************************************************************
+  * @brief Run the microbenchmarks and send the cycles each kernel took
+  *        back on the link that asked. Called from the main loop with no
+  *        packet held, so the receive kernel has the pool to itself.
+  * @par Parameters: None
+  * @retval None
+  *****************************************************************************/
+void SendMicroReport(void)
+{
+    unsigned char payload[2 + MICRO_REPORT_SIZE];
+    unsigned char frame[2 + MICRO_REPORT_SIZE + PROTO_OVERHEAD];
+    unsigned char length = 0;
+    
+    Micro_Run();
+    
+    payload[0] = PROTO_CMD_MICRO_REPORT;
+    payload[1] = Micro_GetReport(&payload[2]);
+    
+    length = Protocol_BuildFrame(frame, payload, payload[1] + 2);
+    replyLink = microLink;
+    SendReply(frame, length);
+    replyLink = ESP8266_PRIMARY_LINK;
+}
+#endif
+
+#if PROFILE_ENABLE
+/*******************************************************************************
+  * @brief Send the profiling counters of one section, or clear them all
+  * @par Parameters:
+  * point - profiled section, PROFILE_RESET to clear the counters
+  * @retval None
+  *****************************************************************************/
+void SendProfileReport(unsigned char point)
+{
+    unsigned char payload[2 + PROFILE_REPORT_SIZE];
+    unsigned char frame[2 + PROFILE_REPORT_SIZE + PROTO_OVERHEAD];
+    unsigned char length = 0;
+    
+    if(point == PROFILE_RESET)
+    {
+        Profile_Reset();
+        return;
+    }
+    
+    payload[0] = PROTO_CMD_TIMING;
+    payload[1] = Profile_GetReport(point, &payload[2]);
+    
+    //Unknown sections are not answered
+    if(payload[1] == 0)
+    {
+        return;
+    }
+    
+    length = Protocol_BuildFrame(frame, payload, payload[1] + 2);
+    SendReply(frame, length);
+}
+#endif
+
+#if TRACE_ENABLE
+/*******************************************************************************
+  * @brief Send a page of the link trace
+  * @par Parameters:
+  * first - index of the first event, 0 is the oldest
+  * @retval None
+  *****************************************************************************/
+void SendTraceReport(unsigned char first)
+{
+    unsigned char payload[2 + TRACE_REPORT_SIZE];
+    unsigned char frame[2 + TRACE_REPORT_SIZE + PROTO_OVERHEAD];
+    unsigned char length = 0;
+    
+    payload[0] = PROTO_CMD_TRACE_LOG;
+    payload[1] = Trace_GetReport(first, &payload[2]);
+    
+    length = Protocol_BuildFrame(frame, payload, payload[1] + 2);
+    SendReply(frame, length);
+}
+#endif
+
+/*******************************************************************************
+  * @brief Send the RAM budget, the stack high-water mark and the buffer sizes
+  * @par Parameters: None
+  * @retval None
+  *****************************************************************************/
+void SendMemoryReport(void)
+{
+    unsigned char payload[2 + MEMORY_REPORT_SIZE];
+    unsigned char frame[2 + MEMORY_REPORT_SIZE + PROTO_OVERHEAD];
+    unsigned char length = 0;
+    
+    payload[0] = PROTO_CMD_MEMORY_REPORT;
+    payload[1] = Memory_GetReport(&payload[2]);
+    
+    length = Protocol_BuildFrame(frame, payload, payload[1] + 2);
+    SendReply(frame, length);
+}
+
+#if OTA_ENABLE
+/*******************************************************************************
+  * @brief Send the firmware update progress
+  * @par Parameters:
+  * result - OtaResult value of the command answered
+  * @retval None
+  *****************************************************************************/
+void SendOtaReport(unsigned char result)
+{
+    unsigned char payload[2 + OTA_REPORT_SIZE];
+    unsigned char frame[2 + OTA_REPORT_SIZE + PROTO_OVERHEAD];
+    unsigned char length = 0;
+    
+    payload[0] = PROTO_CMD_OTA_REPORT;
+    payload[1] = OTA_REPORT_SIZE;
+    Ota_GetReport(result, &payload[2]);
+    
+    length = Protocol_BuildFrame(frame, payload, sizeof(payload));
+    Esp8266_SendMsg(frame, length);
+}
+#endif
+
+/*******************************************************************************
+  * @brief Send the touch gestures in a frame of its own, they are only taken
+  *        from the queue once queued
+  * @par Parameters: None
+  * @retval None
+  *****************************************************************************/
+void SendGestures(void)
+{
+    unsigned char payload[2 + GESTURE_QUEUE_SIZE];
+    unsigned char frame[2 + GESTURE_QUEUE_SIZE + PROTO_OVERHEAD];
+    unsigned char length = 0;
+    
+    payload[0] = PROTO_CMD_GESTURE;
+    payload[1] = Gesture_GetReport(&payload[2]);
+    
+    length = Protocol_BuildFrame(frame, payload, payload[1] + 2);
+    
+    if(Esp8266_SendMsg(frame, length))
+    {
+        Gesture_Release();
+    }
+    
+    Esp8266_SendObservers(frame, length);
+}
+
+#if LATENCY_ENABLE
+/*******************************************************************************
+  * @brief Send the stage times of the stamped command once its output 
+  *        change is applied. A report the send queue cannot take is lost, 
+  *        the controller gives up on it.
+  * @par Parameters: None
+  * @retval None
+  *****************************************************************************/
+void SendLatency(void)
+{
+    unsigned char payload[2 + LATENCY_REPORT_SIZE];
+    unsigned char frame[2 + LATENCY_REPORT_SIZE + PROTO_OVERHEAD];
+    unsigned char length = 0;
+    
+    payload[0] = PROTO_CMD_LATENCY;
+    payload[1] = Latency_GetReport(&payload[2]);
+    
+    length = Protocol_BuildFrame(frame, payload, sizeof(payload));
+    Esp8266_SendMsg(frame, length);
+}
+#endif
+
+#if LOAD_ENABLE
+/*******************************************************************************
+  * @brief Send the main loop load of the last window in a frame of its own,
+  *        it stays pending until queued
+  * @par Parameters: None
+  * @retval None
+  *****************************************************************************/
+void SendLoad(void)
+{
+    unsigned char payload[2 + LOAD_REPORT_SIZE];
+    unsigned char frame[2 + LOAD_REPORT_SIZE + PROTO_OVERHEAD];
+    unsigned char length = 0;
+    
+    payload[0] = PROTO_CMD_LOAD_REPORT;
+    payload[1] = Load_GetReport(&payload[2]);
+    
+    length = Protocol_BuildFrame(frame, payload, payload[1] + 2);
+    
+    if(Esp8266_SendMsg(frame, length))
+    {
+        Load_Release();
+    }
+    
+    Esp8266_SendObservers(frame, length);
+}
+#endif
+
+#if SOAK_ENABLE
+/*******************************************************************************
+  * @brief Send a snapshot of the counters in a frame of its own, tried
+  *        again shortly if it cannot be queued
+  * @par Parameters: None
+  * @retval None
+  *****************************************************************************/
+void SendSoak(void)
+{
+    unsigned char payload[2 + SOAK_REPORT_SIZE];
+    unsigned char frame[2 + SOAK_REPORT_SIZE + PROTO_OVERHEAD];
+    unsigned char length = 0;
+    
+    payload[0] = PROTO_CMD_SOAK_REPORT;
+    payload[1] = Soak_GetReport(&payload[2]);
+    
+    length = Protocol_BuildFrame(frame, payload, payload[1] + 2);
+    Soak_Release(Esp8266_SendMsg(frame, length));
+    Esp8266_SendObservers(frame, length);
+}
+#endif
+
+#if LOG_ENABLE
+/*******************************************************************************
+  * @brief Send a batch of log records in a frame of its own, they are only
+  *        taken from the log once queued
+  * @par Parameters: None
+  * @retval None
+  *****************************************************************************/
+void SendLog(void)
+{
+    unsigned char payload[2 + LOG_REPORT_SIZE];
+    unsigned char frame[2 + LOG_REPORT_SIZE + PROTO_OVERHEAD];
+    unsigned char length = 0;
+    
+    payload[0] = PROTO_CMD_LOG;
+    payload[1] = Log_GetReport(&payload[2]);
+    
+    length = Protocol_BuildFrame(frame, payload, payload[1] + 2);
+    
+    if(Esp8266_SendMsg(frame, length))
+    {
+        Log_Release();
+    }
+    
+    Esp8266_SendObservers(frame, length);
+}
+#endif
+
+/*******************************************************************************
+  * @brief Send a batch of telemetry samples with the pose as it is now. The
+  *        batch counts as congested if it cannot be queued or the module was
+  *        busy since the last one.
+  * @par Parameters: None
+  * @retval None
+  *****************************************************************************/
+void SendTelemetry(void)
+{
+    unsigned char payload[4 + TELEMETRY_REPORT_SIZE + ODOMETRY_REPORT_SIZE];
+    unsigned char frame[4 + TELEMETRY_REPORT_SIZE + ODOMETRY_REPORT_SIZE + 
+                        PROTO_OVERHEAD];
+    unsigned char length = 0;
+    unsigned char pose = 0;
+    unsigned short busy = Esp8266_GetBusyCount();
+    int queued = 0;
+    
+    payload[0] = (Telemetry_GetFormat() == TELEMETRY_FORMAT_COMPACT) ? 
+                 PROTO_CMD_TELEMETRY_COMPACT : PROTO_CMD_TELEMETRY;
+    payload[1] = Telemetry_GetReport(&payload[2]);
+    
+    pose = payload[1] + 2;
+    payload[pose] = PROTO_CMD_POSE;
+    payload[pose + 1] = Odometry_GetReport(&payload[pose + 2]);
+    
+    length = Protocol_BuildFrame(frame, payload, pose + payload[pose + 1] + 2);
+    queued = Esp8266_SendMsg(frame, length);
+    
+    //Observers get a copy when there is room, it does not count as congestion
+    Esp8266_SendObservers(frame, length);
+    
+    Telemetry_SetCongested(!queued || busy != telemetryBusy);
+    telemetryBusy = busy;
+    
+    //Gestures, the load and the log ride along with the telemetry, behind 
+    //each batch that went
+    if(queued && Gesture_IsPending())
+    {
+        SendGestures();
+    }
+    
+#if LOAD_ENABLE
+    if(queued && Load_IsPending())
+    {
+        SendLoad();
+    }
+#endif
+    
+#if LOG_ENABLE
+    if(queued && Log_IsPending())
+    {
+        SendLog();
+    }
+#endif
+}
+
+/*******************************************************************************
+  * @brief Apply the configuration settings that take effect at once, the
+  *        network settings are used at the next start up
+  * @par Parameters: None
+  * @retval None
+  *****************************************************************************/
+void ApplyConfig(void)
+{
+    ConfigRecord *config = Config_Get();
+    
+    DriveCtrl_SetTrim(config->trim[0], config->trim[1]);
+    DriveCtrl_SetAcceleration(config->accel);
+    DriveCtrl_SetPwmProfile(config->pwmProfile);
+    ackMode = config->ackMode;
+    Failsafe_SetTimeout((unsigned short)config->failsafe * 10);
+    Telemetry_SetPeriod((unsigned short)config->telemetry * 10);
+    Telemetry_SetFormat(config->telemetryFormat);
+}
+
+/*******************************************************************************
+  * @brief Baud rate callback, saves the rate the module link settled at so 
+  *        the next start up begins with it
+  * @par Parameters:
+  * baud - baud rate
+  * @retval None
+  *****************************************************************************/
+void SaveBaud(unsigned long baud)
+{
+    ConfigRecord *config = Config_Get();
+    unsigned char value[4];
+    
+    //Only written when it changes, the EEPROM wears
+    if(config->baud != baud)
+    {
+        value[0] = (unsigned char)baud;
+        value[1] = (unsigned char)(baud >> 8);
+        value[2] = (unsigned char)(baud >> 16);
+        value[3] = (unsigned char)(baud >> 24);
+        
+        if(Config_SetField(CONFIG_FIELD_BAUD, value, sizeof(value)))
+        {
+            Config_Save();
+        }
+        
+        LOG1(LOG_BAUD_SETTLED, (unsigned short)(baud / 100));
+    }
+}
+
+/*******************************************************************************
+  * @brief Process a configuration command
+  * @par Parameters:
+  * value - field, then the field data
+  * length - command data length in bytes
+  * @retval None
+  *****************************************************************************/
+void ProcessConfig(const unsigned char *value, unsigned char length)
+{
+    switch(value[0])
+    {
+        case CONFIG_FIELD_SAVE:
+            Config_Save();
+            break;
+        
+        case CONFIG_FIELD_DEFAULTS:
+            Config_SetDefaults();
+            ApplyConfig();
+            break;
+        
+        default:
+            if(Config_SetField(value[0], &value[1], length - 1))
+            {
+                ApplyConfig();
+            }
+            break;
+    };
+}
+
+/*******************************************************************************
+  * @brief Take the wheels back for the remote from a running sequence,
+  *        characterization run, setpoint stream or path
+  * @par Parameters: None
+  * @retval None
+  *****************************************************************************/
+void TakeWheels(void)
+{
+    Sequencer_Cancel();
+    Calibration_Cancel();
+    Setpoint_Cancel();
+    Path_Cancel();
+}
+
+/*******************************************************************************
+  * @brief Hold a timed command until its time. A fleet command is cut down
+  *        to this robot's own targets so it fits the queue. Timed clock 
+  *        commands, timed stamps and timed timed commands are refused.
+  * @par Parameters:
+  * value - command data, time then the inner command
+  * length - command data length in bytes
+  * @retval None
+  *****************************************************************************/
+void ProcessTimed(const unsigned char *value, unsigned char length)
+{
+    unsigned long time = 0;
+    unsigned char type = 0;
+    unsigned char size = 0;
+    const unsigned char *inner = value + PROTO_AT_HEADER;
+    unsigned char i = 0;
+    
+    if(length < PROTO_AT_HEADER || 
+       value[5] > length - PROTO_AT_HEADER)
+    {
+        return;
+    }
+    
+    time = (unsigned long)value[0] | ((unsigned long)value[1] << 8) |
+           ((unsigned long)value[2] << 16) | ((unsigned long)value[3] << 24);
+    type = value[4];
+    size = value[5];
+    
+    if(type == PROTO_CMD_AT || type == PROTO_CMD_CLOCK || 
+       type == PROTO_CMD_STAMP)
+    {
+        return;
+    }
+    
+    if(type == PROTO_CMD_FLEET)
+    {
+        for(i = 0; i + PROTO_FLEET_ENTRY <= size; i += PROTO_FLEET_ENTRY)
+        {
+            if(inner[i] == Config_Get()->robotId || 
+               inner[i] == PROTO_FLEET_ALL)
+            {
+                Clock_Schedule(time, PROTO_CMD_WHEELS, inner + i + 1, 2);
+                break;
+            }
+        }
+        
+        return;
+    }
+    
+    Clock_Schedule(time, type, inner, size);
+}
+
+/*******************************************************************************
+  * @brief Check if a command would move the wheels, they are refused while 
+  *        held by the touch key
+  * @par Parameters:
+  * type - command type
+  * value - command data
+  * length - command data length in bytes
+  * @retval 1 if the command moves the wheels, 0 otherwise
+  *****************************************************************************/
+int IsMotion(unsigned char type, const unsigned char *value, 
+             unsigned char length)
+{
+    switch(type)
+    {
+        case PROTO_CMD_DRIVE:
+            return length >= 1 && value[0] != STOP;
+        
+        case PROTO_CMD_WHEELS:
+        case PROTO_CMD_TWIST:
+        case PROTO_CMD_SETPOINT:
+        case PROTO_CMD_FLEET:
+        case PROTO_CMD_VELOCITY:
+        case PROTO_CMD_SEQUENCE:
+        case PROTO_CMD_CALIBRATE:
+        case PROTO_CMD_MOVE:
+        case PROTO_CMD_PATH:
+            return 1;
+    };
+    
+    return 0;
+}
+
+#if OTA_ENABLE
+/*******************************************************************************
+  * @brief Process a firmware update command from the controller. A 
+  *        transfer is only started with the wheels stopped. Commands 
+  *        answered OTA_PENDING are reported from the main loop once written.
+  * @par Parameters:
+  * value - command data, the action first
+  * length - command data length in bytes
+  * @retval None
+  *****************************************************************************/
+void ProcessOta(const unsigned char *value, unsigned char length)
+{
+    unsigned char result = OTA_BAD_CHUNK;
+    
+    if(length < 1)
+    {
+        return;
+    }
+    
+    switch(value[0])
+    {
+        case OTA_STATUS:
+            result = OTA_OK;
+            break;
+        
+        case OTA_BEGIN:
+            if(length >= 5)
+            {
+                result = DriveCtrl_IsMoving() ? OTA_REFUSED :
+                         Ota_Begin(value[1] | (unsigned short)value[2] << 8,
+                                   value[3] | (unsigned short)value[4] << 8);
+            }
+            break;
+        
+        case OTA_CHUNK:
+            if(length > OTA_CHUNK_HEADER)
+            {
+                result = Ota_Chunk(value[1] | (unsigned short)value[2] << 8,
+                                   &value[OTA_CHUNK_HEADER], 
+                                   length - OTA_CHUNK_HEADER);
+            }
+            break;
+        
+        case OTA_END:
+            result = Ota_End();
+            break;
+        
+        case OTA_APPLY:
+            result = Ota_Apply();
+            break;
+        
+        case OTA_ABORT:
+            Ota_Abort();
+            result = OTA_OK;
+            break;
+    };
+    
+    if(result != OTA_PENDING)
+    {
+        SendOtaReport(result);
+    }
+}
+#endif
+
+/*******************************************************************************
+  * @brief Process a command received from the controller
+  * @par Parameters:
+  * type - command type
+  * value - command data
+  * length - command data length in bytes
+  * @retval None
+  *****************************************************************************/
+void ProcessCommand(unsigned char type, const unsigned char *value, 
+                    unsigned char length)
+{
+    unsigned char i = 0;
+    
+    PROFILE_START(PROFILE_COMMAND);
+    TRACE(TRACE_COMMAND, type);
+    
+#if LATENCY_ENABLE
+    Latency_Dispatch(type);
+#endif
+    
+    //The wheels stay stopped until they are let go at the robot, and while
+    //the firmware is being updated
+    if((touchHold || Ota_IsActive()) && IsMotion(type, value, length))
+    {
+        PROFILE_END(PROFILE_COMMAND);
+        return;
+    }
+    
+    switch(type)
+    {
+        case PROTO_CMD_DRIVE:
+            if(length < 2)
+            {
+                break;
+            }
+            
+            //The remote takes the wheels back from a running sequence
+            TakeWheels();
+            
+            switch(value[0])
+            {
+                case STOP:
+                    DriveCtrl_Stop();
+                    DriveCtrl_SetSpeed(0);
+                    break;
+                case FORWARD:
+                    DriveCtrl_Forward();
+                    DriveCtrl_SetSpeed(value[1]);
+                    break;
+                case BACKWARD:
+                    DriveCtrl_Backward();
+                    DriveCtrl_SetSpeed(value[1]);
+                    break;
+                case LEFT:
+                    DriveCtrl_Turn(LEFT);
+                    DriveCtrl_SetSpeed(value[1]);
+                    break;
+                case RIGHT:
+                    DriveCtrl_Turn(RIGHT);
+                    DriveCtrl_SetSpeed(value[1]);
+                    break;
+            };
+            break;
+        
+        case PROTO_CMD_WHEELS:
+            if(length >= 2)
+            {
+                TakeWheels();
+                DriveCtrl_SetWheelDuty((signed char)value[0], 
+                                       (signed char)value[1]);
+            }
+            break;
+        
+        case PROTO_CMD_TWIST:
+            if(length >= 2)
+            {
+                TakeWheels();
+                DriveCtrl_SetTwist((signed char)value[0], (signed char)value[1]);
+            }
+            break;
+        
+        //Played out of the jitter buffer, which keeps the wheels from one 
+        //sample to the next
+        case PROTO_CMD_SETPOINT:
+            if(length >= 6)
+            {
+                Sequencer_Cancel();
+                Calibration_Cancel();
+                Path_Cancel();
+                Setpoint_Add((unsigned long)value[0] | 
+                             ((unsigned long)value[1] << 8) |
+                             ((unsigned long)value[2] << 16) | 
+                             ((unsigned long)value[3] << 24),
+                             (signed char)value[4], (signed char)value[5]);
+            }
+            break;
+        
+        case PROTO_CMD_FLEET:
+            //The first entry for this robot, the rest are for others
+            for(i = 0; i + PROTO_FLEET_ENTRY <= length; i += PROTO_FLEET_ENTRY)
+            {
+                if(value[i] == Config_Get()->robotId || 
+                   value[i] == PROTO_FLEET_ALL)
+                {
+                    TakeWheels();
+                    DriveCtrl_SetWheelDuty((signed char)value[i + 1], 
+                                           (signed char)value[i + 2]);
+                    break;
+                }
+            }
+            break;
+        
+        case PROTO_CMD_VELOCITY:
+            if(length >= 4)
+            {
+                TakeWheels();
+                DriveCtrl_SetWheelVelocity(
+                    (signed short)(value[0] | (value[1] << 8)), 
+                    (signed short)(value[2] | (value[3] << 8)));
+            }
+            break;
+        
+        //Nothing held from before the stop may undo it
+        case PROTO_CMD_ESTOP:
+            TakeWheels();
+            Clock_Clear();
+            DriveCtrl_EmergencyStop();
+            break;
+        
+        case PROTO_CMD_CLOCK:
+            if(length < 5)
+            {
+                break;
+            }
+            
+            if(value[0] == PROTO_CLOCK_QUERY)
+            {
+                SendClock(value + 1);
+            }
+            else if(value[0] == PROTO_CLOCK_SET)
+            {
+                Clock_SetOffset((unsigned long)value[1] | 
+                                ((unsigned long)value[2] << 8) |
+                                ((unsigned long)value[3] << 16) | 
+                                ((unsigned long)value[4] << 24));
+            }
+            break;
+        
+        case PROTO_CMD_AT:
+            ProcessTimed(value, length);
+            break;
+        
+        case PROTO_CMD_PING:
+            if(length >= 2)
+            {
+                SendPong(value);
+            }
+            break;
+        
+#if LATENCY_ENABLE
+        case PROTO_CMD_STAMP:
+            if(length >= 4)
+            {
+                Latency_Stamp(value, packetTime, packetTaken);
+            }
+            break;
+#endif
+        
+        case PROTO_CMD_BENCH:
+            if(length >= 1)
+            {
+                switch(value[0])
+                {
+                    case PROTO_BENCH_STOP:
+                        Bench_Stop();
+                        break;
+                    case PROTO_BENCH_START:
+                        Bench_Start();
+                        break;
+                    case PROTO_BENCH_REPORT:
+                        SendBenchReport();
+                        break;
+#if MICRO_ENABLE
+                    case PROTO_BENCH_MICRO:
+                        microPending = 1;
+                        microLink = replyLink;
+                        break;
+#endif
+#if SOAK_ENABLE
+                    case PROTO_BENCH_SOAK:
+                        Soak_Start((length >= 2) ? value[1] : 0);
+                        break;
+#endif
+                };
+            }
+            break;
+        
+        case PROTO_CMD_SEQUENCE:
+            if(!Sequencer_Load(value, length))
+            {
+                LOG1(LOG_SEQUENCE_REFUSED, length);
+            }
+            else
+            {
+                Calibration_Cancel();
+                Setpoint_Cancel();
+                Path_Cancel();
+            }
+            break;
+        
+        //Loaded before the wheels are taken, a refused path leaves the 
+        //running one alone
+        case PROTO_CMD_PATH:
+            if(!Path_Load(value, length))
+            {
+                LOG1(LOG_PATH_REFUSED, length);
+            }
+            else
+            {
+                Sequencer_Cancel();
+                Calibration_Cancel();
+                Setpoint_Cancel();
+            }
+            break;
+        
+        case PROTO_CMD_CALIBRATE:
+            TakeWheels();
+            Calibration_Start();
+            break;
+        
+        case PROTO_CMD_MOVE:
+            if(length >= 1 && value[0] == PROTO_MOVE_RESET_POSE)
+            {
+                Odometry_Reset();
+            }
+            else if(length >= 5)
+            {
+                TakeWheels();
+                
+                if(value[0] == PROTO_MOVE_DISTANCE)
+                {
+                    DriveCtrl_DriveDistance(
+                        (signed short)(value[1] | (value[2] << 8)),
+                        (unsigned short)(value[3] | (value[4] << 8)));
+                }
+                else if(value[0] == PROTO_MOVE_TURN)
+                {
+                    DriveCtrl_TurnAngle(
+                        (signed short)(value[1] | (value[2] << 8)),
+                        (unsigned short)(value[3] | (value[4] << 8)));
+                }
+            }
+            break;
+        
+        //Only feeds the failsafe, as every accepted frame does
+        //Any frame moves the link to the controller, see Esp8266_FollowPeer
+        case PROTO_CMD_KEEPALIVE:
+        case PROTO_CMD_DISCOVER:
+            break;
+        
+        //Kept in the configuration so applying another field keeps it
+        case PROTO_CMD_ACK_MODE:
+            if(Config_SetField(CONFIG_FIELD_ACK_MODE, value, length))
+            {
+                ackMode = value[0];
+            }
+            break;
+        
+        case PROTO_CMD_CONFIG:
+            if(length >= 1)
+            {
+                ProcessConfig(value, length);
+            }
+            break;
+        
+#if PROFILE_ENABLE
+        case PROTO_CMD_PROFILE:
+            if(length >= 1)
+            {
+                SendProfileReport(value[0]);
+            }
+            break;
+#endif
+        
+#if TRACE_ENABLE
+        case PROTO_CMD_TRACE:
+            if(length >= 1)
+            {
+                switch(value[0])
+                {
+                    case PROTO_TRACE_STOP:
+                        Trace_Stop();
+                        break;
+                    case PROTO_TRACE_START:
+                        Trace_Start();
+                        break;
+                    case PROTO_TRACE_REPORT:
+                        SendTraceReport(length >= 2 ? value[1] : 0);
+                        break;
+                };
+            }
+            break;
+#endif
+        
+        case PROTO_CMD_MEMORY:
+            SendMemoryReport();
+            break;
+        
+#if OTA_ENABLE
+        //Only from the controller, observers never get here
+        case PROTO_CMD_OTA:
+            ProcessOta(value, length);
+            break;
+#endif
+        
+        //Unknown commands are skipped
+        default:
+            break;
+    };
+    
+    PROFILE_END(PROFILE_COMMAND);
+}
+
+/*******************************************************************************
+  * @brief Process a command received from an observer on the bulk lane. 
+  *        Observers may ask for reports and change the configuration, but 
+  *        nothing that moves the robot, holds off the failsafe or replaces 
+  *        the firmware.
+  * @par Parameters:
+  * type - command type
+  * value - command data
+  * length - command data length in bytes
+  * @retval None
+  *****************************************************************************/
+void ProcessBulkCommand(unsigned char type, const unsigned char *value, 
+                        unsigned char length)
+{
+    switch(type)
+    {
+        case PROTO_CMD_BENCH:
+        case PROTO_CMD_PROFILE:
+        case PROTO_CMD_CONFIG:
+        case PROTO_CMD_TRACE:
+        case PROTO_CMD_MEMORY:
+            ProcessCommand(type, value, length);
+            break;
+        
+        default:
+            break;
+    };
+}
+
+/*******************************************************************************
+  * @brief Apply the stop commands of a frame seen ahead of its turn. The
+  *        commands are applied again when the frame is processed, which
+  *        leaves the wheels as they are.
+  * @par Parameters:
+  * type - command type
+  * value - command data
+  * length - command data length in bytes
+  * @retval None
+  *****************************************************************************/
+void PeekCommand(unsigned char type, const unsigned char *value, 
+                 unsigned char length)
+{
+    if(type == PROTO_CMD_ESTOP)
+    {
+        TakeWheels();
+        DriveCtrl_EmergencyStop();
+        stopApplied = 1;
+    }
+    else if(type == PROTO_CMD_DRIVE && length >= 2 && value[0] == STOP)
+    {
+        TakeWheels();
+        DriveCtrl_Stop();
+        DriveCtrl_SetSpeed(0);
+        stopApplied = 1;
+    }
+}
+
+/*******************************************************************************
+  * @brief Priority lane, called by the receive parser as each packet from the
+  *        controller completes. A stop is applied straight away rather than
+  *        behind the packets and datagrams queued in front of it, and the
+  *        older frames still queued are made stale so they cannot start the
+  *        wheels again.
+  * @par Parameters:
+  * packet - received packet
+  * length - packet length in bytes
+  * micros - time the packet header arrived in us
+  * @retval None
+  *****************************************************************************/
+void PriorityFilter(const unsigned char *packet, unsigned char length, 
+                    unsigned short micros)
+{
+    stopApplied = 0;
+    
+    if(Protocol_PeekFrame(packet, length, PeekCommand) == PROTO_OK && stopApplied)
+    {
+        Protocol_Fence(packet);
+        Bench_Record(BENCH_RX_TO_STOP, Sched_GetMicros() - micros);
+    }
+}
+
+/*******************************************************************************
+  * @brief Send the cumulative acknowledgement holding the sequence number of 
+  *        the last accepted frame
+  * @par Parameters: None
+  * @retval None
+  *****************************************************************************/
+void SendAck(void)
+{
+    unsigned char payload[3];
+    unsigned char frame[3 + PROTO_OVERHEAD];
+    unsigned char length = 0;
+    
+    payload[0] = PROTO_CMD_ACK;
+    payload[1] = 1;
+    payload[2] = Protocol_GetLastSeq();
+    
+    length = Protocol_BuildFrame(frame, payload, sizeof(payload));
+    
+    //Try again on the next interval if the send queue is full
+    if(Esp8266_SendMsg(frame, length))
+    {
+        ackPending = 0;
+    }
+}
+
+/*******************************************************************************
+  * @brief Heartbeat task, blinks the LED
+  * @par Parameters: None
+  * @retval None
+  *****************************************************************************/
+void LedTask(void)
+{
+    ToggleLED();
+}
+
+/*******************************************************************************
+  * @brief Acknowledgement task, acknowledges the frames accepted since the 
+  *        last interval
+  * @par Parameters: None
+  * @retval None
+  *****************************************************************************/
+void AckTask(void)
+{
+    if(ackPending && ackMode == PROTO_ACK_CUMULATIVE)
+    {
+        SendAck();
+    }
+}
+
+/*******************************************************************************
+  * @brief Clock task, runs every held timed command that has come due
+  * @par Parameters: None
+  * @retval None
+  *****************************************************************************/
+void ClockTask(void)
+{
+    while(Clock_Run(ProcessCommand))
+    {;}
+}
+
+/*******************************************************************************
+  * @brief Telemetry task, samples at the configured rate and sends a batch
+  *        when one is ready
+  * @par Parameters: None
+  * @retval None
+  *****************************************************************************/
+void TelemetryTask(void)
+{
+    if(Telemetry_Update())
+    {
+        SendTelemetry();
+    }
+}
+
+#if TOUCH_PANEL_ENABLE
+/*******************************************************************************
+  * @brief Speed selector on the touch panel. A preset key sets the speed 
+  *        limit as it is touched, the slider sets it from one step to full
+  *        speed along its length.
+  * @par Parameters:
+  * keys - panel keys touched, TOUCH_KEY_ bits
+  * slider - slider position, TOUCH_NO_SLIDER when it is not touched
+  * @retval None
+  *****************************************************************************/
+void SelectSpeed(unsigned char keys, unsigned char slider)
+{
+    unsigned char touched = keys & (unsigned char)~touchPresets;
+    unsigned char limit = DriveCtrl_GetSpeedLimit();
+    
+    touchPresets = keys;
+    
+    if(touched & TOUCH_KEY_SLOW)
+    {
+        limit = TOUCH_PRESET_SLOW;
+    }
+    
+    if(touched & TOUCH_KEY_FULL)
+    {
+        limit = SPEED_FULL;
+    }
+    
+    if(slider != TOUCH_NO_SLIDER)
+    {
+        limit = (unsigned char)(((slider + 1) * SPEED_FULL) / 
+                                TOUCH_SLIDER_STEPS);
+    }
+    
+    if(limit != DriveCtrl_GetSpeedLimit())
+    {
+        DriveCtrl_SetSpeedLimit(limit);
+        LOG1(LOG_SPEED_LIMIT, limit);
+    }
+}
+#endif
+
+/*******************************************************************************
+  * @brief Touch sense task, runs the Touch Sensing library and acts on the
+  *        gestures of the key. A touch stops the robot at once and holds it
+  *        stopped, a double tap lets it go again and a long press lets it go
+  *        and runs the last sequence loaded. The gestures are sent to the
+  *        remote behind the telemetry, or from here when that is off.
+  * @par Parameters: None
+  * @retval None
+  *****************************************************************************/
+void TouchTask(void)
+{
+#if TOUCH_SKIP_SWITCHING
+    //Wait for the motor supply to settle, the acquisition picks up from 
+    //where it was on the next run
+    if(!Sched_IsExpired(DriveCtrl_GetSwitchTime() + TOUCH_SETTLE_TIME))
+    {
+        return;
+    }
+#endif
+    
+    TouchPanel_Scan();
+    
+    switch(Gesture_Update((TouchPanel_GetKeys() & TOUCH_KEY_STOP) != 0))
+    {
+        //Nothing held from before the stop may undo it
+        case GESTURE_TOUCH:
+            TakeWheels();
+            Clock_Clear();
+            DriveCtrl_EmergencyStop();
+            touchHold = 1;
+            break;
+        
+        case GESTURE_DOUBLE_TAP:
+            touchHold = 0;
+            break;
+        
+        case GESTURE_LONG_PRESS:
+            touchHold = 0;
+            Sequencer_Replay();
+            break;
+    };
+    
+    if(Config_Get()->telemetry == 0 && Gesture_IsPending())
+    {
+        SendGestures();
+    }
+    
+#if TOUCH_PANEL_ENABLE
+    SelectSpeed(TouchPanel_GetKeys(), TouchPanel_GetSlider());
+#endif
+}
+
+/*******************************************************************************
+  * @brief Check if the last reset came from inside the robot, the watchdogs,
+  *        an illegal opcode, the debugger or a corrupted register, so the
+  *        module kept its power. A power up or brown out sets no flag, nor 
+  *        does the reset pin. The flags are cleared so the next reset is 
+  *        told apart.
+  * @par Parameters: None
+  * @retval 1 if only the robot was reset, 0 otherwise
+  *****************************************************************************/
+unsigned char IsWarmReset(void)
+{
+    const RST_Flag_TypeDef flags[] = 
+    {
+        RST_FLAG_IWDGF, RST_FLAG_WWDGF, RST_FLAG_ILLOPF, RST_FLAG_SWIMF, 
+        RST_FLAG_EMCF
+    };
+    unsigned char warm = 0;
+    unsigned char i = 0;
+    
+    for(i = 0; i < sizeof(flags) / sizeof(flags[0]); i++)
+    {
+        if(RST_GetFlagStatus(flags[i]) == SET)
+        {
+            RST_ClearFlag(flags[i]);
+            warm = 1;
+        }
+    }
+    
+    return warm;
+}
+
+/*******************************************************************************
+  * @brief Initialize the system. Nothing here waits, the Esp8266 boots 
+  *        while the rest of the robot starts and its start up commands are
+  *        run from the main loop.
+  * @par Parameters: None
+  * @retval None
+  *****************************************************************************/
+void Initialize(void)
+{
+    ConfigRecord *config = 0;
+    
+    //Paint the stack before anything is below this frame
+    Memory_PaintStack();
+    
+    //Interrupt priorities first, the drivers unmask interrupts as they start
+    ITC_Configuration();
+    
+    //Configures clocks
+    CLK_Configuration();
+    
+    //Load the saved configuration
+    Config_Load();
+    config = Config_Get();
+
+    //Configures LED GPIO
+    InitLED();
+    
+    //Initialize the scheduler tick
+    Sched_Initialize();
+    
+    //Share the buffer blocks out before anything takes one
+    Pool_Initialize();
+    
+    //Sample the battery and motor currents on the tick
+    Telemetry_Initialize();
+    
+#if RANGE_ENABLE
+    //Time the range echoes on the tick count
+    Range_Initialize();
+#endif
+    
+    //Initialize Touch Sensing keys
+    TouchPanel_Initialize();
+    
+    //Initialize the motor drive controller
+    DriveCtrl_Initialize();
+    Failsafe_Initialize();
+    Sequencer_Initialize();
+    Path_Initialize();
+#if OTA_ENABLE
+    Ota_Initialize();
+#endif
+    Gesture_Initialize();
+#if LOAD_ENABLE
+    Load_Initialize();
+#endif
+#if POWER_ENABLE
+    Power_Initialize();
+#endif
+    Clock_Initialize();
+    Setpoint_Initialize();
+    ApplyConfig();
+    
+    enableInterrupts();
+    
+#if TRACE_ENABLE
+    //Record the link from the first AT command
+    Trace_Start();
+#endif
+    
+    //Initialize the control protocol
+    Protocol_Initialize();
+    
+    //Initialize WiFi interface, starting from the last baud rate
+    Esp8266_Initialize(config->baud);
+    Esp8266_SetBaudCallback(SaveBaud);
+    
+    //A module that kept its power through the reset may still be set up
+    if(IsWarmReset())
+    {
+        Esp8266_SetWarmStart();
+    }
+    
+    //Set the access point name
+    Esp8266_SetAccessPointName(config->apName);
+    
+    //Time each datagram for the benchmark
+    Esp8266_SetSendCallback(Bench_SendCallback);
+    
+    //Stops jump the receive queue
+    Esp8266_SetPriorityCallback(PriorityFilter);
+    
+#if PROFILE_ENABLE
+    //Start the profiling counters empty
+    Profile_Reset();
+#endif
+    
+    //Set up a UDP socket
+    Esp8266_StartClient(ESP8266_UDP, config->peerIp, config->peerPort);
+    
+#if !ESP8266_TRANSPARENT
+    //Start the TCP server for observers and the bulk lane
+    Esp8266_StartTcpServer(ESP8266_SERVER_PORT);
+#endif
+    
+    //Register the periodic tasks
+    Sched_AddTask(TouchTask, TOUCH_PERIOD, 0);
+    Sched_AddTask(DriveCtrl_Update, DRIVE_UPDATE_PERIOD, 3);
+    Sched_AddTask(Failsafe_Task, FAILSAFE_PERIOD, 6);
+    Sched_AddTask(AckTask, ACK_INTERVAL, 1);
+    Sched_AddTask(TelemetryTask, TELEMETRY_PERIOD, 7);
+    Sched_AddTask(LedTask, LED_PERIOD, 2);
+    Sched_AddTask(Config_Task, CONFIG_WRITE_PERIOD, 4);
+    Sched_AddTask(Sequencer_Task, SEQUENCER_PERIOD, 0);
+    Sched_AddTask(Calibration_Task, CALIBRATION_PERIOD, 5);
+    Sched_AddTask(ClockTask, CLOCK_PERIOD, 0);
+    Sched_AddTask(Setpoint_Task, SETPOINT_PERIOD, 0);
+    Sched_AddTask(Path_Task, PATH_PERIOD, 0);
+#if RANGE_ENABLE
+    Sched_AddTask(Range_Task, RANGE_PERIOD, 2);
+#endif
+    
+    //Supervise the tasks from here on
+    Sched_StartWatchdog();
+}
+
+/*******************************************************************************
+  * @brief main entry point
+  * @par Parameters: None
+  * @retval None
+  *****************************************************************************/
+void main(void)
+{
+    const unsigned char *packet = 0;
+    unsigned char length = 0;
+    unsigned char link = 0;
+    unsigned char busy = 0;
+#if OTA_ENABLE
+    unsigned char otaResult = OTA_OK;
+#endif
+    unsigned short failsafeTrips = 0;
+    
+    //Initialize the system
+    Initialize();
+    
+    //Set initial state to stopped
+    DriveCtrl_EmergencyStop();
+    
+    // Main loop
+    while (1)
+    {    
+#if LOAD_ENABLE
+        //Time the iteration that just ended, blocking waits and all
+        Load_Loop();
+#endif
+        
+        //Run the periodic task that is due
+        busy = Sched_Run();
+
+        //Parse what the module sent, then advance the queued AT commands
+        busy |= Esp8266_ProcessRx();
+        busy |= Esp8266_Process();
+        
+        //The controller going quiet may be the module, check it answers
+        if(Failsafe_GetTrips() != failsafeTrips)
+        {
+            failsafeTrips = Failsafe_GetTrips();
+            Esp8266_Probe();
+        }
+        
+#if OTA_ENABLE
+        //Write the update block that is due, then report it
+        busy |= Ota_Run();
+        
+        if(Ota_IsReplyDue(&otaResult))
+        {
+            SendOtaReport(otaResult);
+        }
+#endif
+
+        //Check for received Wifi packets
+        if(length = Esp8266_AcquirePacket(&packet))
+        {
+            busy = 1;
+            packetTime = Esp8266_GetPacketTime();
+#if LATENCY_ENABLE
+            packetTaken = Sched_GetMicros();
+#endif
+            link = Esp8266_GetPacketLink();
+            
+            //Only the controller on the primary link is obeyed, observers
+            //are answered on the bulk lane
+            if(link != ESP8266_PRIMARY_LINK)
+            {
+                replyLink = link;
+                Protocol_ParseBulkFrame(packet, length, ProcessBulkCommand);
+                replyLink = ESP8266_PRIMARY_LINK;
+            }
+            else
+            {
+                //Process the commands in the frame received from the controller
+                if(Protocol_ParseFrame(packet, length, ProcessCommand) == PROTO_OK)
+                {
+                    ackPending = 1;
+                    Failsafe_Feed();
+#if POWER_ENABLE
+                    //Controlled, not parked
+                    Power_Wake();
+#endif
+                    
+                    //Answer the controller wherever it is now
+                    Esp8266_FollowPeer();
+                }
+                
+                //Echo packet when debugging
+                if(ackMode == PROTO_ACK_ECHO)
+                {
+                    Esp8266_SendMsg(packet, length);
+                }
+            }
+            
+            //Done with the packet, return it to the pool
+            Esp8266_ReleasePacket();
+        }
+        
+#if LATENCY_ENABLE
+        //The stamped command's output change has been applied
+        if(Latency_IsReady())
+        {
+            SendLatency();
+        }
+#endif
+        
+#if SOAK_ENABLE
+        //Counters for the soak test, whether the telemetry is on or not
+        if(Soak_IsDue())
+        {
+            SendSoak();
+        }
+#endif
+        
+#if MICRO_ENABLE
+        if(microPending)
+        {
+            microPending = 0;
+            SendMicroReport();
+        }
+#endif
+        
+        //Nothing left to do, sleep until the next UART, TSL or tick 
+        //interrupt. Work an interrupt brings in just before the wfi waits 
+        //for the next tick at most.
+        if(!busy)
+        {
+#if POWER_ENABLE
+            //Slow the CPU while parked, the next byte or touch speeds it up
+            Power_Run();
+#endif
+#if LOAD_ENABLE
+            Load_Sleep();
+#else
+            wfi();
+#endif
+        }
+    }
+}
@@ -1,90 +1,194 @@
-/**
-  ******************************************************************************
-  * @file STM8_interrupt_vector.c
-  * @brief Basic interrupt vector table for STM8S devices
-  * @author STMicroelectronics - MCD Application Team
-  * @version V2.0.0
-  * @date 15-March-2011
-  ******************************************************************************
-  *
-  * THE PRESENT FIRMWARE WHICH IS FOR GUIDANCE ONLY AIMS AT PROVIDING CUSTOMERS
-  * WITH CODING INFORMATION REGARDING THEIR PRODUCTS IN ORDER FOR THEM TO SAVE
-  * TIME. AS A RESULT, STMICROELECTRONICS SHALL NOT BE HELD LIABLE FOR ANY
-  * DIRECT, INDIRECT OR CONSEQUENTIAL DAMAGES WITH RESPECT TO ANY CLAIMS ARISING
-  * FROM THE CONTENT OF SUCH FIRMWARE AND/OR THE USE MADE BY CUSTOMERS OF THE
-  * CODING INFORMATION CONTAINED HEREIN IN CONNECTION WITH THEIR PRODUCTS.
-  *
-  * <h2><center>&copy; COPYRIGHT 2008 STMicroelectronics</center></h2>
-  * @image html logo.bmp
-  ******************************************************************************
-  */
-
-#include "STM8_TSL_API.h"
-#include "STM8_TSL_timebase.h"
-#include "Uart.h"
-
-typedef void @far (*interrupt_handler_t)(void);
-
-struct interrupt_vector
-{
-  unsigned char interrupt_instruction;
-  interrupt_handler_t interrupt_handler;
-};
-
-@far @interrupt void Uart2RxInterrupt (void)
-{
-  Uart_ReceiveISR();
-  return;
-}
-
-@far @interrupt void NonHandledInterrupt (void)
-{
-  /* in order to detect unexpected events during development,
-     it is recommended to set a breakpoint on the following instruction
-  */
-  return;
-}
-
-extern void _stext();     /* startup routine */
-void main(void);
-
-struct interrupt_vector const _vectab[] =
-  {
-    {
-      0x82, (interrupt_handler_t)_stext
-    }
-    , /* reset */
-    //{0x82, (interrupt_handler_t)main}, /* reset */
-    {0x82, NonHandledInterrupt}, /* trap */
-    {0x82, NonHandledInterrupt}, /* irq0 - tli */
-    {0x82, NonHandledInterrupt}, /* irq1 - awu */
-    {0x82, NonHandledInterrupt}, /* irq2 - clk */
-    {0x82, NonHandledInterrupt}, /* irq3 - exti0 */
-    {0x82, NonHandledInterrupt}, /* irq4 - exti1 */
-    {0x82, NonHandledInterrupt}, /* irq5 - exti2 */
-    {0x82, NonHandledInterrupt}, /* irq6 - exti3 */
-    {0x82, NonHandledInterrupt}, /* irq7 - exti4 */
-    {0x82, NonHandledInterrupt}, /* irq8 - can rx */
-    {0x82, NonHandledInterrupt}, /* irq9 - can tx */
-    {0x82, NonHandledInterrupt}, /* irq10 - spi*/
-    {0x82, NonHandledInterrupt}, /* irq11 - tim1 */
-    {0x82, NonHandledInterrupt}, /* irq12 - tim1 */
-    {0x82, NonHandledInterrupt}, /* irq13 - tim2 */
-    {0x82, NonHandledInterrupt}, /* irq14 - tim2 */
-    {0x82, NonHandledInterrupt}, /* irq15 - tim3 */
-    {0x82, NonHandledInterrupt}, /* irq16 - tim3 */
-    {0x82, NonHandledInterrupt}, /* irq17 - uart1 */
-    {0x82, NonHandledInterrupt}, /* irq18 - uart1 */
-    {0x82, NonHandledInterrupt}, /* irq19 - i2c */
-    {0x82, NonHandledInterrupt}, /* irq20 - uart2/3 */
-    //{0x82, NonHandledInterrupt},  /* irq21 - uart2/3 */
-    {0x82, (interrupt_handler_t)Uart2RxInterrupt}, /* irq21 - uart2/3 */
-    {0x82, NonHandledInterrupt}, /* irq22 - adc */
-    {0x82, (interrupt_handler_t)TSL_Timer_ISR}, /* irq23 - tim4 */
-    {0x82, NonHandledInterrupt}, /* irq24 - flash */
-    {0x82, NonHandledInterrupt}, /* irq25 - reserved */
-    {0x82, NonHandledInterrupt}, /* irq26 - reserved */
-    {0x82, NonHandledInterrupt}, /* irq27 - reserved */
-    {0x82, NonHandledInterrupt}, /* irq28 - reserved */
-    {0x82, NonHandledInterrupt}  /* irq29 - reserved */
-  };
+/**
+  ******************************************************************************
+  * @file STM8_interrupt_vector.c
+  * @brief Basic interrupt vector table for STM8S devices
+  * @author STMicroelectronics - MCD Application Team
+  * @version V2.0.0
+  * @date 15-March-2011
+  ******************************************************************************
+  *
+  * THE PRESENT FIRMWARE WHICH IS FOR GUIDANCE ONLY AIMS AT PROVIDING CUSTOMERS
+  * WITH CODING INFORMATION REGARDING THEIR PRODUCTS IN ORDER FOR THEM TO SAVE
+  * TIME. AS A RESULT, STMICROELECTRONICS SHALL NOT BE HELD LIABLE FOR ANY
+  * DIRECT, INDIRECT OR CONSEQUENTIAL DAMAGES WITH RESPECT TO ANY CLAIMS ARISING
+  * FROM THE CONTENT OF SUCH FIRMWARE AND/OR THE USE MADE BY CUSTOMERS OF THE
+  * CODING INFORMATION CONTAINED HEREIN IN CONNECTION WITH THEIR PRODUCTS.
+  *
+  * <h2><center>&copy; COPYRIGHT 2008 STMicroelectronics</center></h2>
+  * @image html logo.bmp
+  ******************************************************************************
+  */
+
+#include "STM8_TSL_API.h"
+#include "STM8_TSL_timebase.h"
+#include "Uart.h"
+#include "Scheduler.h"
+#include "Encoder.h"
+#include "Telemetry.h"
+#include "DriveController.h"
+#include "Range.h"
+#include "Boot.h"
+#include "Esp8266.h"
+#include "Spi.h"
+
+typedef void @far (*interrupt_handler_t)(void);
+
+struct interrupt_vector
+{
+  unsigned char interrupt_instruction;
+  interrupt_handler_t interrupt_handler;
+};
+
+@far @interrupt void Uart2RxInterrupt (void)
+{
+  Uart_ReceiveISR();
+  return;
+}
+
+@far @interrupt void Uart2TxInterrupt (void)
+{
+  Uart_TransmitISR();
+  return;
+}
+
+@far @interrupt void Tim1UpdateInterrupt (void)
+{
+  Sched_TickISR();
+  return;
+}
+
+@far @interrupt void Tim2UpdateInterrupt (void)
+{
+  DriveCtrl_PwmISR();
+  return;
+}
+
+@far @interrupt void Tim1CaptureInterrupt (void)
+{
+#if RANGE_ENABLE
+  Range_CaptureISR();
+#endif
+  return;
+}
+
+@far @interrupt void ExtiPortBInterrupt (void)
+{
+  Encoder_ISR();
+  return;
+}
+
+@far @interrupt void ExtiPortEInterrupt (void)
+{
+  DriveCtrl_TripISR();
+  return;
+}
+
+@far @interrupt void Adc1Interrupt (void)
+{
+  Telemetry_ADCISR();
+  return;
+}
+
+#if ESP8266_SPI_LINK
+@far @interrupt void SpiInterrupt (void)
+{
+  Spi_ISR();
+  return;
+}
+
+@far @interrupt void ExtiPortDInterrupt (void)
+{
+  Esp8266_ReadyISR();
+  return;
+}
+#endif
+
+@far @interrupt void NonHandledInterrupt (void)
+{
+  /* in order to detect unexpected events during development,
+     it is recommended to set a breakpoint on the following instruction
+  */
+  return;
+}
+
+extern void _stext();     /* startup routine */
+void main(void);
+
+/* The application's entry for each vector, see Ota.h. The boot table at
+   0x8000 is never updated over the air, each of its vectors jumps to the
+   same vector here. The reset goes to the boot copier first. */
+#define BOOT_FORWARD(n) {0x82, (interrupt_handler_t)(OTA_APP_START + 4 * (n))}
+
+struct interrupt_vector const _vectab[] =
+  {
+    {0x82, (interrupt_handler_t)Boot_Reset}, /* reset */
+    BOOT_FORWARD(1),  BOOT_FORWARD(2),  BOOT_FORWARD(3),  BOOT_FORWARD(4),
+    BOOT_FORWARD(5),  BOOT_FORWARD(6),  BOOT_FORWARD(7),  BOOT_FORWARD(8),
+    BOOT_FORWARD(9),  BOOT_FORWARD(10), BOOT_FORWARD(11), BOOT_FORWARD(12),
+    BOOT_FORWARD(13), BOOT_FORWARD(14), BOOT_FORWARD(15), BOOT_FORWARD(16),
+    BOOT_FORWARD(17), BOOT_FORWARD(18), BOOT_FORWARD(19), BOOT_FORWARD(20),
+    BOOT_FORWARD(21), BOOT_FORWARD(22), BOOT_FORWARD(23), BOOT_FORWARD(24),
+    BOOT_FORWARD(25), BOOT_FORWARD(26), BOOT_FORWARD(27), BOOT_FORWARD(28),
+    BOOT_FORWARD(29), BOOT_FORWARD(30), BOOT_FORWARD(31)
+  };
+
+#pragma section const {appvect}
+
+struct interrupt_vector const _appvectab[] =
+  {
+    {
+      0x82, (interrupt_handler_t)_stext
+    }
+    , /* reset */
+    //{0x82, (interrupt_handler_t)main}, /* reset */
+    {0x82, NonHandledInterrupt}, /* trap */
+    {0x82, NonHandledInterrupt}, /* irq0 - tli */
+    {0x82, NonHandledInterrupt}, /* irq1 - awu */
+    {0x82, NonHandledInterrupt}, /* irq2 - clk */
+    {0x82, NonHandledInterrupt}, /* irq3 - exti0 */
+    //{0x82, NonHandledInterrupt}, /* irq4 - exti1 */
+    {0x82, (interrupt_handler_t)ExtiPortBInterrupt}, /* irq4 - exti1 */
+    {0x82, NonHandledInterrupt}, /* irq5 - exti2 */
+#if ESP8266_SPI_LINK
+    {0x82, (interrupt_handler_t)ExtiPortDInterrupt}, /* irq6 - exti3 */
+#else
+    {0x82, NonHandledInterrupt}, /* irq6 - exti3 */
+#endif
+    //{0x82, NonHandledInterrupt}, /* irq7 - exti4 */
+    {0x82, (interrupt_handler_t)ExtiPortEInterrupt}, /* irq7 - exti4 */
+    {0x82, NonHandledInterrupt}, /* irq8 - can rx */
+    {0x82, NonHandledInterrupt}, /* irq9 - can tx */
+#if ESP8266_SPI_LINK
+    {0x82, (interrupt_handler_t)SpiInterrupt}, /* irq10 - spi*/
+#else
+    {0x82, NonHandledInterrupt}, /* irq10 - spi*/
+#endif
+    //{0x82, NonHandledInterrupt}, /* irq11 - tim1 */
+    {0x82, (interrupt_handler_t)Tim1UpdateInterrupt}, /* irq11 - tim1 */
+    //{0x82, NonHandledInterrupt}, /* irq12 - tim1 */
+    {0x82, (interrupt_handler_t)Tim1CaptureInterrupt}, /* irq12 - tim1 */
+    //{0x82, NonHandledInterrupt}, /* irq13 - tim2 */
+    {0x82, (interrupt_handler_t)Tim2UpdateInterrupt}, /* irq13 - tim2 */
+    {0x82, NonHandledInterrupt}, /* irq14 - tim2 */
+    {0x82, NonHandledInterrupt}, /* irq15 - tim3 */
+    {0x82, NonHandledInterrupt}, /* irq16 - tim3 */
+    {0x82, NonHandledInterrupt}, /* irq17 - uart1 */
+    {0x82, NonHandledInterrupt}, /* irq18 - uart1 */
+    {0x82, NonHandledInterrupt}, /* irq19 - i2c */
+    //{0x82, NonHandledInterrupt}, /* irq20 - uart2/3 */
+    {0x82, (interrupt_handler_t)Uart2TxInterrupt}, /* irq20 - uart2/3 */
+    //{0x82, NonHandledInterrupt},  /* irq21 - uart2/3 */
+    {0x82, (interrupt_handler_t)Uart2RxInterrupt}, /* irq21 - uart2/3 */
+    //{0x82, NonHandledInterrupt}, /* irq22 - adc */
+    {0x82, (interrupt_handler_t)Adc1Interrupt}, /* irq22 - adc */
+    //{0x82, (interrupt_handler_t)TSL_Timer_ISR}, /* irq23 - tim4 */
+    {0x82, NonHandledInterrupt}, /* irq23 - tim4, TSL timebase runs on tim1 */
+    {0x82, NonHandledInterrupt}, /* irq24 - flash */
+    {0x82, NonHandledInterrupt}, /* irq25 - reserved */
+    {0x82, NonHandledInterrupt}, /* irq26 - reserved */
+    {0x82, NonHandledInterrupt}, /* irq27 - reserved */
+    {0x82, NonHandledInterrupt}, /* irq28 - reserved */
+    {0x82, NonHandledInterrupt}  /* irq29 - reserved */
+  };
+
+#pragma section const {}
@@ -0,0 +1,298 @@
+#!/usr/bin/env python3
+###############################################################################
+# @file BenchmarkLink.py
+# @brief Load generator for the robot link benchmark
+#
+# Sends ping frames to the robot at rising rates and measures the loss and
+# round trip time of the pongs. The robot records where the time goes
+# between the +IPD header, the command dispatch and SEND OK, and its
+# statistics report is printed at the end. With --profile the firmware hot
+# path counters are printed too, these need a build with PROFILE_ENABLE.
+# With --memory the stack high-water mark after the run, the RAM budget and
+# the block pool usage are printed.
+#
+# The robot connects to 192.168.4.2:49999, so this host must join the
+# STM8S_Robot access point with that address.
+#
+# Usage: python3 BenchmarkLink.py [--rates 10,20,50,100,200] [--seconds 5]
+#                                 [--csv results.csv] [--plot] [--profile]
+#                                 [--memory]
+###############################################################################
+import argparse
+import socket
+import struct
+import threading
+import time
+
+SYNC = 0xA5
+VERSION = 1
+FLAG_SEQ_RESET = 0x01
+
+CMD_ACK_MODE = 0x03
+CMD_BENCH = 0x05
+CMD_PING = 0x06
+CMD_PROFILE = 0x07
+CMD_MEMORY = 0x0E
+CMD_PONG = 0x81
+CMD_STATS = 0x82
+CMD_TIMING = 0x83
+CMD_MEMORY_REPORT = 0x88
+
+ACK_NONE = 0
+BENCH_STOP = 0
+BENCH_START = 1
+BENCH_REPORT = 2
+
+INTERVALS = ["rx to dispatch", "dispatch to sent", "sent to done"]
+PROFILE_POINTS = ["uart rx isr", "esp rx byte", "tsl action", "command",
+                  "send msg"]
+PROFILE_RESET = 0xFF
+
+# Must match MemoryBuffer in Memory.h
+MEMORY_BUFFERS = ["uart rx", "uart tx", "esp rx pool", "esp tx pools",
+                  "esp bulk lane", "esp commands", "telemetry", "trace", "log",
+                  "sequencer", "scheduler", "config", "profile", "touch"]
+
+# Must match PoolClass in Pool.h
+POOL_CLASSES = ["tx datagrams", "observer datagrams"]
+
+
+def crc8(data):
+    crc = 0
+    for byte in data:
+        crc ^= byte
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x07) & 0xFF if crc & 0x80 else (crc << 1) & 0xFF
+    return crc
+
+
+class Link:
+    """Framed UDP link to the robot, see Protocol.h"""
+
+    def __init__(self, robot, port):
+        self.robot = (robot, port)
+        self.sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+        self.sock.bind(("", port))
+        self.sock.settimeout(0.2)
+        self.seq = 0
+        self.first = True
+        self.lock = threading.Lock()
+
+    def send(self, payload):
+        with self.lock:
+            flags = FLAG_SEQ_RESET if self.first else 0
+            self.first = False
+            body = bytes([(VERSION << 4) | flags, self.seq, len(payload)]) + payload
+            self.seq = (self.seq + 1) & 0xFF or 1
+        self.sock.sendto(bytes([SYNC]) + body + bytes([crc8(body)]), self.robot)
+
+    def receive(self):
+        """Returns the list of (type, value) commands of the next valid frame"""
+        try:
+            frame, _ = self.sock.recvfrom(256)
+        except socket.timeout:
+            return None
+        if (len(frame) < 5 or frame[0] != SYNC or frame[3] != len(frame) - 5
+                or crc8(frame[1:-1]) != frame[-1]):
+            return []
+        commands = []
+        payload = frame[4:-1]
+        i = 0
+        while i + 2 <= len(payload):
+            length = payload[i + 1]
+            commands.append((payload[i], payload[i + 2:i + 2 + length]))
+            i += length + 2
+        return commands
+
+
+class Receiver(threading.Thread):
+    """Collects pong arrival times and the statistics report"""
+
+    def __init__(self, link):
+        super().__init__(daemon=True)
+        self.link = link
+        self.pongs = {}
+        self.stats = None
+        self.timings = {}
+        self.memory = None
+        self.running = True
+
+    def run(self):
+        while self.running:
+            commands = self.link.receive()
+            now = time.monotonic()
+            for kind, value in commands or []:
+                if kind == CMD_PONG and len(value) >= 2:
+                    self.pongs.setdefault(struct.unpack("<H", value[:2])[0], now)
+                elif kind == CMD_STATS:
+                    self.stats = value
+                elif kind == CMD_TIMING and len(value) >= 1:
+                    self.timings[value[0]] = value[1:]
+                elif kind == CMD_MEMORY_REPORT and len(value) >= 5:
+                    self.memory = value
+
+
+def percentile(values, fraction):
+    if not values:
+        return float("nan")
+    values = sorted(values)
+    return values[min(len(values) - 1, int(fraction * len(values)))]
+
+
+def run_step(link, receiver, rate, seconds, tag):
+    """Ping at one rate, returns the result row and the next tag"""
+    sent = {}
+    period = 1.0 / rate
+    start = time.monotonic()
+    deadline = start
+    while time.monotonic() - start < seconds:
+        deadline += period
+        sent[tag] = time.monotonic()
+        link.send(bytes([CMD_PING, 2]) + struct.pack("<H", tag))
+        tag = (tag + 1) & 0xFFFF
+        delay = deadline - time.monotonic()
+        if delay > 0:
+            time.sleep(delay)
+
+    # Give the last pongs time to arrive
+    time.sleep(0.5)
+    rtts = [(receiver.pongs[t] - s) * 1000.0 for t, s in sent.items()
+            if t in receiver.pongs]
+    loss = 100.0 * (len(sent) - len(rtts)) / len(sent)
+    row = (rate, len(sent), len(rtts), loss, percentile(rtts, 0.0),
+           percentile(rtts, 0.5), percentile(rtts, 0.95), percentile(rtts, 1.0))
+    return row, tag
+
+
+def print_stats(stats):
+    values = struct.unpack("<%dH" % (len(stats) // 2), stats)
+    print("robot: %u pings" % values[0])
+    for i, name in enumerate(INTERVALS):
+        low, high, mean = values[1 + i * 3:4 + i * 3]
+        print("  %-18s min %6u  max %6u  mean %6u us" % (name, low, high, mean))
+    print("  rx lost %u, tx failed %u" % (values[-2], values[-1]))
+
+
+def print_timings(timings):
+    print("profile: section        count    min    max   mean us  "
+          "<4 <8 <16 <32 <64 <128 <256 more")
+    for point, name in enumerate(PROFILE_POINTS):
+        if point not in timings:
+            print("  %-20s no report" % name)
+            continue
+        values = struct.unpack("<%dH" % (len(timings[point]) // 2),
+                               timings[point])
+        print("  %-20s %6u %6u %6u %6u     %s" % ((name,) + values[:4] +
+              (" ".join("%u" % v for v in values[4:]),)))
+
+
+def print_memory(memory):
+    size, peak, count = struct.unpack("<HHB", memory[:5])
+    sizes = struct.unpack("<%dH" % count, memory[5:5 + count * 2])
+    print("memory: stack %u of %u bytes used at the peak, %u spare" %
+          (peak, size, size - peak))
+    for i, value in enumerate(sizes):
+        name = MEMORY_BUFFERS[i] if i < len(MEMORY_BUFFERS) else "buffer %d" % i
+        print("  %-18s %5u bytes" % (name, value))
+    print("  %-18s %5u bytes" % ("total", sum(sizes)))
+    pool = memory[5 + count * 2:]
+    if pool:
+        print("pool: quota, used, peak and refused blocks")
+        for i in range(pool[0]):
+            name = POOL_CLASSES[i] if i < len(POOL_CLASSES) else "class %d" % i
+            print("  %-18s %5u %5u %5u %5u" % ((name,) +
+                                              tuple(pool[1 + i * 4:5 + i * 4])))
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Robot link benchmark")
+    parser.add_argument("--robot", default="192.168.4.1")
+    parser.add_argument("--port", type=int, default=49999)
+    parser.add_argument("--rates", default="10,20,50,100,200",
+                        help="ping rates in Hz, comma separated")
+    parser.add_argument("--seconds", type=float, default=5.0,
+                        help="time at each rate")
+    parser.add_argument("--csv", help="write the results to a CSV file")
+    parser.add_argument("--plot", action="store_true",
+                        help="plot loss and round trip time (needs matplotlib)")
+    parser.add_argument("--profile", action="store_true",
+                        help="clear the firmware profiling counters before "
+                             "the run and print them after")
+    parser.add_argument("--memory", action="store_true",
+                        help="print the stack high-water mark and the RAM "
+                             "budget after the run")
+    args = parser.parse_args()
+
+    link = Link(args.robot, args.port)
+    receiver = Receiver(link)
+    receiver.start()
+
+    # Acknowledgements would share the link with the pongs, turn them off
+    link.send(bytes([CMD_ACK_MODE, 1, ACK_NONE, CMD_BENCH, 1, BENCH_START]))
+    if args.profile:
+        link.send(bytes([CMD_PROFILE, 1, PROFILE_RESET]))
+    time.sleep(0.2)
+
+    rows = []
+    tag = 0
+    print("rate Hz   sent  recv  loss %   rtt min    p50    p95    max ms")
+    for rate in [float(r) for r in args.rates.split(",")]:
+        row, tag = run_step(link, receiver, rate, args.seconds, tag)
+        rows.append(row)
+        print("%7.0f %6u %5u %7.1f %9.1f %6.1f %6.1f %6.1f" % row)
+
+    link.send(bytes([CMD_BENCH, 1, BENCH_REPORT]))
+    for _ in range(10):
+        if receiver.stats is not None:
+            break
+        time.sleep(0.1)
+    link.send(bytes([CMD_BENCH, 1, BENCH_STOP]))
+
+    # One report per section, each fills a datagram
+    if args.profile:
+        for point in range(len(PROFILE_POINTS)):
+            link.send(bytes([CMD_PROFILE, 1, point]))
+            time.sleep(0.1)
+        time.sleep(0.3)
+    if args.memory:
+        link.send(bytes([CMD_MEMORY, 0]))
+        time.sleep(0.3)
+    receiver.running = False
+
+    if receiver.stats is not None:
+        print_stats(receiver.stats)
+    else:
+        print("robot: no statistics report")
+
+    if args.profile:
+        print_timings(receiver.timings)
+
+    if args.memory:
+        if receiver.memory is not None:
+            print_memory(receiver.memory)
+        else:
+            print("memory: no report")
+
+    if args.csv:
+        with open(args.csv, "w") as out:
+            out.write("rate,sent,received,loss,rtt_min,rtt_p50,rtt_p95,rtt_max\n")
+            for row in rows:
+                out.write(",".join("%g" % v for v in row) + "\n")
+
+    if args.plot:
+        import matplotlib.pyplot as plt
+        rates = [r[0] for r in rows]
+        figure, (loss_axis, rtt_axis) = plt.subplots(2, 1, sharex=True)
+        loss_axis.plot(rates, [r[3] for r in rows], "o-")
+        loss_axis.set_ylabel("loss %")
+        rtt_axis.plot(rates, [r[5] for r in rows], "o-", label="p50")
+        rtt_axis.plot(rates, [r[6] for r in rows], "o-", label="p95")
+        rtt_axis.set_ylabel("round trip ms")
+        rtt_axis.set_xlabel("ping rate Hz")
+        rtt_axis.legend()
+        figure.suptitle("Robot link benchmark")
+        plt.show()
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,187 @@
+#!/usr/bin/env python3
+###############################################################################
+# @file GenerateEsp8266Matcher.py
+# @brief Generates the ESP8266 response matcher tables (Esp8266Matcher.h/.c)
+#
+# The ESP8266 response tokens below are compiled into an Aho-Corasick
+# automaton and flattened into a deterministic state transition table so the
+# RX interrupt can match every token at once with one table lookup per byte.
+# Bytes are first mapped to a small character class to keep the table compact.
+#
+# Usage: python3 GenerateEsp8266Matcher.py (run from any directory)
+###############################################################################
+import os
+
+# (token name, response text). Order defines the token numbers.
+TOKENS = [
+    ("OK",        b"OK\r\n"),
+    ("ERROR",     b"ERROR\r\n"),
+    ("FAIL",      b"FAIL\r\n"),
+    ("READY",     b"ready\r\n"),
+    ("SEND_OK",   b"SEND OK\r\n"),
+    ("SEND_FAIL", b"SEND FAIL\r\n"),
+    ("BUSY",      b"busy "),
+    ("TX_READY",  b"> "),
+    ("RX_HEADER", b"+IPD,"),
+    ("CONNECT",   b"CONNECT\r\n"),
+    ("CLOSED",    b"CLOSED\r\n"),
+    ("AP_NAME",   b"+CWSAP:\""),
+    ("LINK_STATUS", b"+CIPSTATUS:"),
+]
+
+ROOT = os.path.join(os.path.dirname(os.path.abspath(__file__)), "..")
+
+
+def build():
+    # Character classes, class 0 is every byte not used by a token
+    chars = sorted(set(c for _, text in TOKENS for c in text))
+    char_class = [0] * 256
+    for i, c in enumerate(chars):
+        char_class[c] = i + 1
+    num_classes = len(chars) + 1
+
+    # Trie
+    goto = [{}]
+    output = [0]
+    for number, (_, text) in enumerate(TOKENS):
+        state = 0
+        for c in text:
+            if c not in goto[state]:
+                goto.append({})
+                output.append(0)
+                goto[state][c] = len(goto) - 1
+            state = goto[state][c]
+        output[state] = number + 1
+
+    # Failure links (breadth first) and the flattened transition table.
+    # Only the token owned by a state is reported so the longest token
+    # wins, e.g. "SEND OK\r\n" is never also reported as "OK\r\n".
+    fail = [0] * len(goto)
+    table = [[0] * num_classes for _ in goto]
+    order = []
+    queue = list(goto[0].values())
+    order.extend(queue)
+    while queue:
+        nxt = []
+        for state in queue:
+            for c, child in goto[state].items():
+                f = fail[state]
+                while f and c not in goto[f]:
+                    f = fail[f]
+                fail[child] = goto[f].get(c, 0) if goto[f].get(c, 0) != child else 0
+                nxt.append(child)
+        order.extend(nxt)
+        queue = nxt
+
+    for state in [0] + order:
+        for cls in range(num_classes):
+            table[state][cls] = table[fail[state]][cls] if state else 0
+        for c, child in goto[state].items():
+            table[state][char_class[c]] = child
+
+    # Byte values that are not used by any token always go back to the root
+    # unless a token can restart on them, class 0 covers them all.
+    return chars, char_class, num_classes, table, output
+
+
+def c_char(c):
+    if c == ord("\r"):
+        return "'\\r'"
+    if c == ord("\n"):
+        return "'\\n'"
+    return "'%s'" % chr(c)
+
+
+def main():
+    chars, char_class, num_classes, table, output = build()
+    assert len(table) < 256
+
+    header = []
+    header.append("/*******************************************************************************")
+    header.append("  * @file Esp8266Matcher.h")
+    header.append("  * @brief ESP8266 response matcher tables")
+    header.append("  *")
+    header.append("  * Generated by tools/GenerateEsp8266Matcher.py, do not edit")
+    header.append("  *****************************************************************************/")
+    header.append("#ifndef ESP_8266_MATCHER_H")
+    header.append("#define ESP_8266_MATCHER_H")
+    header.append("")
+    header.append("////////////////////////////////////////////////////////////////////////////////")
+    header.append("// Definitions")
+    header.append("////////////////////////////////////////////////////////////////////////////////")
+    header.append("#define ESP8266_MATCH_STATES   %d" % len(table))
+    header.append("#define ESP8266_MATCH_CLASSES  %d" % num_classes)
+    header.append("")
+    header.append("//Tokens reported by the matcher")
+    header.append("enum MatchToken")
+    header.append("{")
+    header.append("    ESP8266_TOKEN_NONE,")
+    for i, (name, _) in enumerate(TOKENS):
+        sep = "," if i < len(TOKENS) - 1 else ""
+        header.append("    ESP8266_TOKEN_%s%s" % (name, sep))
+    header.append("};")
+    header.append("")
+    header.append("//Next state = ESP8266_MATCH_NEXT[state][ESP8266_MATCH_CLASS[byte]]")
+    header.append("extern const unsigned char ESP8266_MATCH_CLASS[256];")
+    header.append("extern const unsigned char ESP8266_MATCH_NEXT[ESP8266_MATCH_STATES][ESP8266_MATCH_CLASSES];")
+    header.append("extern const unsigned char ESP8266_MATCH_TOKEN[ESP8266_MATCH_STATES];")
+    header.append("")
+    header.append("#endif")
+
+    source = []
+    source.append("/*******************************************************************************")
+    source.append("  * @file Esp8266Matcher.c")
+    source.append("  * @brief ESP8266 response matcher tables, stored in flash")
+    source.append("  *")
+    source.append("  * Generated by tools/GenerateEsp8266Matcher.py, do not edit")
+    source.append("  *")
+    source.append("  * Tokens:")
+    for name, text in TOKENS:
+        source.append("  *   %-10s \"%s\"" % (name, text.decode().replace("\r", "\\r").replace("\n", "\\n")))
+    source.append("  *****************************************************************************/")
+    source.append("")
+    source.append("")
+    source.append("////////////////////////////////////////////////////////////////////////////////")
+    source.append("// Includes")
+    source.append("////////////////////////////////////////////////////////////////////////////////")
+    source.append("#include \"Esp8266Matcher.h\"")
+    source.append("")
+    source.append("")
+    source.append("////////////////////////////////////////////////////////////////////////////////")
+    source.append("// Tables")
+    source.append("////////////////////////////////////////////////////////////////////////////////")
+    source.append("")
+    source.append("//Character class of each byte value, 0 for bytes not used by any token")
+    source.append("const unsigned char ESP8266_MATCH_CLASS[256] =")
+    source.append("{")
+    for row in range(0, 256, 16):
+        vals = ", ".join("%2d" % v for v in char_class[row:row + 16])
+        sep = "," if row < 240 else ""
+        source.append("    %s%s" % (vals, sep))
+    source.append("};")
+    source.append("")
+    source.append("//State transition table, classes: other %s" % " ".join(c_char(c) for c in chars))
+    source.append("const unsigned char ESP8266_MATCH_NEXT[ESP8266_MATCH_STATES][ESP8266_MATCH_CLASSES] =")
+    source.append("{")
+    for i, row in enumerate(table):
+        sep = "," if i < len(table) - 1 else ""
+        source.append("    {%s}%s" % (",".join("%d" % v for v in row), sep))
+    source.append("};")
+    source.append("")
+    source.append("//Token completed on entering each state")
+    source.append("const unsigned char ESP8266_MATCH_TOKEN[ESP8266_MATCH_STATES] =")
+    source.append("{")
+    for row in range(0, len(output), 16):
+        vals = ", ".join("%2d" % v for v in output[row:row + 16])
+        sep = "," if row + 16 < len(output) else ""
+        source.append("    %s%s" % (vals, sep))
+    source.append("};")
+
+    with open(os.path.join(ROOT, "inc", "Esp8266Matcher.h"), "wb") as f:
+        f.write("\r\n".join(header).encode())
+    with open(os.path.join(ROOT, "src", "Esp8266Matcher.c"), "wb") as f:
+        f.write("\r\n".join(source).encode())
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,203 @@
+#!/usr/bin/env python3
+###############################################################################
+# @file GenerateLogTable.py
+# @brief Generates the log message table (LogMessages.h for the robot and
+#        LogMessages.java for the remote) and decodes log batches on a host
+#
+# The robot never formats a log. A record is the message id and up to three
+# raw 16-bit arguments, the text lives only here and in the generated tables
+# so it costs no flash on the robot. Add a message at the end of MESSAGES so
+# the ids of the others do not move, and run the script to regenerate both
+# tables.
+#
+# Formats take %u (unsigned), %d (signed) and %x (hex) arguments, each one a
+# 16-bit value, at most three to a message.
+#
+# Usage: python3 GenerateLogTable.py                 regenerate the tables
+#        python3 GenerateLogTable.py --decode HEX    print a log command value
+###############################################################################
+import os
+import re
+import sys
+
+# (message name, format). Order defines the message ids.
+MESSAGES = [
+    ("FAILSAFE_TRIP",      "Failsafe stopped the robot %u ms after the last command"),
+    ("BAUD_SETTLED",       "Module link settled at %u00 baud"),
+    ("CONFIG_SAVED",       "Configuration saved to slot %u"),
+    ("CONFIG_SAVE_FAILED", "Configuration save to slot %u failed to verify"),
+    ("SEQUENCE_REFUSED",   "Sequence of %u bytes refused"),
+    ("LINK_OPENED",        "Link %u connected, role %u"),
+    ("LINK_CLOSED",        "Link %u closed"),
+    ("CALIBRATION_POINT",  "Calibration at duty %u, left %u right %u edges/s"),
+    ("CALIBRATION_FAILED", "Calibration stopped, a wheel did not turn at full duty"),
+    ("REFLEX_LIMIT",       "Obstacle at %u mm, forward speed held to %u percent"),
+    ("PEER_FOLLOWED",      "Link moved to the controller at *.*.%u.%u port %u"),
+    ("SPEED_LIMIT",        "Speed limit set to %u percent on the robot"),
+    ("PATH_REFUSED",       "Path of %u bytes refused"),
+    ("PATH_DONE",          "Path of %u waypoints finished"),
+    ("OTA_BEGIN",          "Firmware update of %u blocks started"),
+    ("OTA_FAILED",         "Firmware update failed, result %u"),
+    ("OTA_STAGED",         "Firmware update of %u blocks staged"),
+    ("OTA_APPLY",          "Resetting to apply the firmware update"),
+    ("ESP_RECOVERY",       "Module fault, recovery step %u started"),
+    ("ESP_RECOVERED",      "Module recovered at step %u"),
+    ("DRIVE_TRIP",         "Overcurrent trip %u, speed held to %u percent"),
+    ("DRIVE_LATCHED",      "Overcurrent trip %u in a row, motors off until the commands stop"),
+]
+
+# Must match Log.h in the robot firmware
+LOG_ID_MAX = 64
+LOG_ARGS_MAX = 3
+
+ROOT = os.path.join(os.path.dirname(os.path.abspath(__file__)), "..")
+JAVA = os.path.join(ROOT, "..", "..", "RobotRemote", "src", "com", "sharpedev",
+                    "robotremote", "LogMessages.java")
+
+SPEC = re.compile(r"%[udx]")
+
+
+def arg_count(fmt):
+    return len(SPEC.findall(fmt))
+
+
+def format_record(msg_id, args):
+    if msg_id >= len(MESSAGES):
+        return "Unknown log %d %s" % (msg_id, " ".join("%d" % a for a in args))
+    values = iter(args)
+
+    def sub(match):
+        value = next(values, 0)
+        if match.group(0) == "%d":
+            return "%d" % (value - 0x10000 if value & 0x8000 else value)
+        if match.group(0) == "%x":
+            return "%x" % value
+        return "%u" % value
+    return SPEC.sub(sub, MESSAGES[msg_id][1])
+
+
+def decode(value):
+    # Same layout as Log_GetBatch: dropped count, then the records
+    lines = []
+    if value[0]:
+        lines.append("%d log records dropped" % value[0])
+    i = 1
+    while i < len(value):
+        header = value[i]
+        count = header >> 6
+        args = [value[i + 1 + 2 * n] | (value[i + 2 + 2 * n] << 8) for n in range(count)]
+        lines.append(format_record(header & (LOG_ID_MAX - 1), args))
+        i += 1 + 2 * count
+    return lines
+
+
+def main():
+    assert len(MESSAGES) <= LOG_ID_MAX
+    for name, fmt in MESSAGES:
+        assert arg_count(fmt) <= LOG_ARGS_MAX, name
+
+    header = []
+    header.append("/*******************************************************************************")
+    header.append("  * @file LogMessages.h")
+    header.append("  * @brief Log message ids, the text is only on the remote and the host")
+    header.append("  *")
+    header.append("  * Generated by tools/GenerateLogTable.py, do not edit")
+    header.append("  *****************************************************************************/")
+    header.append("#ifndef LOG_MESSAGES_H")
+    header.append("#define LOG_MESSAGES_H")
+    header.append("")
+    header.append("////////////////////////////////////////////////////////////////////////////////")
+    header.append("// Definitions")
+    header.append("////////////////////////////////////////////////////////////////////////////////")
+    header.append("")
+    header.append("//Messages, log each with LOG0 to LOG3 to match its arguments")
+    header.append("enum LogId")
+    header.append("{")
+    width = max(len(name) for name, _ in MESSAGES) + 1
+    for i, (name, fmt) in enumerate(MESSAGES):
+        sep = "," if i < len(MESSAGES) - 1 else ""
+        header.append("    LOG_%-*s //%d: \"%s\"" % (width, name + sep, arg_count(fmt), fmt))
+    header.append("};")
+    header.append("")
+    header.append("#endif")
+
+    java = []
+    java.append("/******************************************************************************")
+    java.append(" * NAME: LogMessages")
+    java.append(" *")
+    java.append(" * DESCRIPTION:")
+    java.append(" *   Formats the log records sent by the robot.")
+    java.append(" *")
+    java.append(" *   Generated by Robot/RobotController/tools/GenerateLogTable.py, do not")
+    java.append(" *   edit")
+    java.append(" *****************************************************************************/")
+    java.append("package com.sharpedev.robotremote;")
+    java.append("")
+    java.append("public class LogMessages {")
+    java.append("")
+    java.append("    static final String[] FORMATS = {")
+    for i, (name, fmt) in enumerate(MESSAGES):
+        sep = "," if i < len(MESSAGES) - 1 else ""
+        java.append("        \"%s\"%s //%s" % (fmt, sep, name))
+    java.append("    };")
+    java.append("")
+    java.append("    /**")
+    java.append("     * Format a log record")
+    java.append("     *")
+    java.append("     * @param id - message id")
+    java.append("     * @param args - 16-bit arguments, unsigned")
+    java.append("     * @return the message text")
+    java.append("     */")
+    java.append("    public static String format(int id, int[] args) {")
+    java.append("")
+    java.append("        if(id >= FORMATS.length)")
+    java.append("        {")
+    java.append("            return \"Unknown log \" + id;")
+    java.append("        }")
+    java.append("")
+    java.append("        String        format = FORMATS[id];")
+    java.append("        StringBuilder text   = new StringBuilder();")
+    java.append("        int           arg    = 0;")
+    java.append("")
+    java.append("        for(int i = 0; i < format.length(); i++)")
+    java.append("        {")
+    java.append("            char c = format.charAt(i);")
+    java.append("")
+    java.append("            if(c != '%' || i + 1 >= format.length() || arg >= args.length)")
+    java.append("            {")
+    java.append("                text.append(c);")
+    java.append("                continue;")
+    java.append("            }")
+    java.append("")
+    java.append("            int value = args[arg++];")
+    java.append("")
+    java.append("            switch(format.charAt(++i))")
+    java.append("            {")
+    java.append("                case 'd':")
+    java.append("                    text.append((short) value);")
+    java.append("                    break;")
+    java.append("                case 'x':")
+    java.append("                    text.append(Integer.toHexString(value));")
+    java.append("                    break;")
+    java.append("                default:")
+    java.append("                    text.append(value);")
+    java.append("                    break;")
+    java.append("            }")
+    java.append("        }")
+    java.append("")
+    java.append("        return text.toString();")
+    java.append("    }")
+    java.append("}")
+
+    with open(os.path.join(ROOT, "inc", "LogMessages.h"), "wb") as f:
+        f.write("\r\n".join(header).encode())
+    with open(JAVA, "wb") as f:
+        f.write("\r\n".join(java).encode())
+
+
+if __name__ == "__main__":
+    if len(sys.argv) == 3 and sys.argv[1] == "--decode":
+        for line in decode(bytes.fromhex(sys.argv[2])):
+            print(line)
+    else:
+        main()
@@ -0,0 +1,175 @@
+#!/usr/bin/env python3
+###############################################################################
+# @file OtaUpload.py
+# @brief Firmware update over the robot's TCP bulk lane
+#
+# Streams an application image to the robot in chunks, see Ota.h. Each chunk
+# waits for the robot's report before the next is sent, a report naming
+# another offset moves the transfer there. Once the robot has checked the
+# staged image it is told to reset into the boot copier, unless --no-apply
+# is given.
+#
+# The image is the application from 0x8800, a raw binary or the Motorola
+# S-record file the Cosmic hex converter writes. The boot segment below
+# 0x8800 is not sent, it is only ever flashed with the ST-Link.
+#
+# Usage: python3 OtaUpload.py image.s19 [--robot 192.168.4.1]
+#                             [--port 49999] [--no-apply]
+###############################################################################
+import argparse
+import socket
+import struct
+import sys
+
+SYNC = 0xA5
+VERSION = 1
+OVERHEAD = 5
+
+CMD_OTA = 0x17
+CMD_OTA_REPORT = 0x8E
+
+# Must match Ota.h
+APP_START = 0x8800
+IMAGE_MAX = 0x3B80
+BLOCK_SIZE = 128
+CHUNK_MAX = 32
+
+OTA_STATUS, OTA_BEGIN, OTA_CHUNK, OTA_END, OTA_APPLY, OTA_ABORT = range(6)
+RESULTS = ["ok", "refused", "too big", "bad chunk", "bad image",
+           "write failed", "pending"]
+STATES = ["idle", "receiving", "writing", "staged", "applying"]
+
+
+def crc8(data):
+    crc = 0
+    for byte in data:
+        crc ^= byte
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x07) & 0xFF if crc & 0x80 else (crc << 1) & 0xFF
+    return crc
+
+
+def crc16(data):
+    """CRC-16/CCITT-FALSE, the same as Ota_Crc16"""
+    crc = 0xFFFF
+    for byte in data:
+        crc ^= byte << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021) & 0xFFFF if crc & 0x8000 else (crc << 1) & 0xFFFF
+    return crc
+
+
+def load_image(path):
+    """Returns the application bytes, gaps in an S-record file read as erased"""
+    with open(path, "rb") as source:
+        data = source.read()
+    if not data.startswith(b"S"):
+        return data
+    memory = {}
+    for line in data.decode("ascii").split():
+        kind = line[1]
+        if kind not in "123":
+            continue
+        size = 2 + int(kind)
+        record = bytes.fromhex(line[2:])
+        address = int.from_bytes(record[1:size - 1], "big")
+        for i, byte in enumerate(record[size - 1:-1]):
+            memory[address + i] = byte
+    if min(memory) < APP_START:
+        sys.exit("image has code below 0x%04X, check the linker segments" %
+                 APP_START)
+    end = max(memory) + 1
+    return bytes(memory.get(a, 0) for a in range(APP_START, end))
+
+
+class BulkLink:
+    """Framed TCP link to the robot's bulk lane, see Protocol.h"""
+
+    def __init__(self, robot, port):
+        self.sock = socket.create_connection((robot, port), timeout=5.0)
+        self.stream = b""
+
+    def send(self, kind, value):
+        payload = bytes([kind, len(value)]) + value
+        body = bytes([VERSION << 4, 0, len(payload)]) + payload
+        self.sock.sendall(bytes([SYNC]) + body + bytes([crc8(body)]))
+
+    def receive(self, kind):
+        """Returns the value of the next command of that type"""
+        while True:
+            start = self.stream.find(bytes([SYNC]))
+            if start < 0:
+                self.stream = b""
+            else:
+                self.stream = self.stream[start:]
+            if len(self.stream) >= 4 and len(self.stream) >= self.stream[3] + OVERHEAD:
+                frame = self.stream[:self.stream[3] + OVERHEAD]
+                if crc8(frame[1:-1]) != frame[-1]:
+                    self.stream = self.stream[1:]
+                    continue
+                self.stream = self.stream[len(frame):]
+                payload = frame[4:-1]
+                i = 0
+                while i + 2 <= len(payload):
+                    length = payload[i + 1]
+                    if payload[i] == kind:
+                        return payload[i + 2:i + 2 + length]
+                    i += length + 2
+                continue
+            data = self.sock.recv(256)
+            if not data:
+                sys.exit("robot closed the link")
+            self.stream += data
+
+    def request(self, value):
+        """Sends an OTA command, returns the result, state and next offset"""
+        self.send(CMD_OTA, value)
+        return struct.unpack("<BBH", self.receive(CMD_OTA_REPORT)[:4])
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Robot firmware update")
+    parser.add_argument("image", help="application image, .bin or .s19")
+    parser.add_argument("--robot", default="192.168.4.1")
+    parser.add_argument("--port", type=int, default=49999)
+    parser.add_argument("--no-apply", action="store_true",
+                        help="stage the image but leave the robot running")
+    args = parser.parse_args()
+
+    image = load_image(args.image)
+    if len(image) > IMAGE_MAX:
+        sys.exit("image of %u bytes, the most is %u" % (len(image), IMAGE_MAX))
+    link = BulkLink(args.robot, args.port)
+
+    result, state, _ = link.request(struct.pack("<BHH", OTA_BEGIN, len(image),
+                                                crc16(image)))
+    if result != 0:
+        sys.exit("begin: %s" % RESULTS[result])
+
+    offset = 0
+    while offset < len(image):
+        # Chunks stop at the end of each block
+        length = min(CHUNK_MAX, BLOCK_SIZE - offset % BLOCK_SIZE,
+                     len(image) - offset)
+        result, state, offset = link.request(
+            struct.pack("<BH", OTA_CHUNK, offset) + image[offset:offset + length])
+        if result not in (0, 3):
+            link.send(CMD_OTA, bytes([OTA_ABORT]))
+            sys.exit("chunk: %s" % RESULTS[result])
+        print("\r%u of %u bytes" % (offset, len(image)), end="", flush=True)
+    print()
+
+    result, state, _ = link.request(bytes([OTA_END]))
+    if result != 0:
+        sys.exit("end: %s, state %s" % (RESULTS[result], STATES[state]))
+    print("image of %u bytes staged, crc 0x%04X" % (len(image), crc16(image)))
+
+    if not args.no_apply:
+        result, state, _ = link.request(bytes([OTA_APPLY]))
+        if result != 0:
+            sys.exit("apply: %s" % RESULTS[result])
+        print("robot resetting, the copy takes up to 20 s")
+
+
+if __name__ == "__main__":
+    main()
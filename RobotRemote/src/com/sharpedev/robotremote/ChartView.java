@@ -0,0 +1,138 @@
+/******************************************************************************
+ * NAME: ChartView
+ *
+ * DESCRIPTION:
+ *   Strip chart of one or more series over a fixed range, the oldest point
+ *   on the left and the newest on the right. Points outside the range are
+ *   drawn at its edge and Float.NaN points are left out. The points are
+ *   copied in, so the caller may reuse its arrays as soon as setPoints
+ *   returns.
+ *****************************************************************************/
+package com.sharpedev.robotremote;
+
+import android.content.Context;
+import android.graphics.Canvas;
+import android.graphics.Color;
+import android.graphics.Paint;
+import android.util.AttributeSet;
+import android.view.View;
+
+public class ChartView extends View {
+
+    //Title text size, px
+    static final float TITLE_SIZE = 16;
+
+    Paint     framePaint = new Paint();
+    Paint     titlePaint = new Paint(Paint.ANTI_ALIAS_FLAG);
+    Paint[]   linePaints = new Paint[0];
+    float[][] points     = new float[0][];
+    String    title      = "";
+    float     min        = 0;
+    float     max        = 1;
+
+    public ChartView(Context context) {
+        super(context);
+        init();
+    }
+
+    public ChartView(Context context, AttributeSet attrs) {
+        super(context, attrs);
+        init();
+    }
+
+    /**
+     * Set up the paints
+     */
+    void init() {
+
+        framePaint.setColor(Color.GRAY);
+        framePaint.setStyle(Paint.Style.STROKE);
+        titlePaint.setColor(Color.GRAY);
+        titlePaint.setTextSize(TITLE_SIZE);
+    }
+
+    /**
+     * Set the title, range and series colours
+     *
+     * @param title - shown at the top left
+     * @param min - value at the bottom edge
+     * @param max - value at the top edge
+     * @param colors - colour of each series
+     */
+    public void setup(String title, float min, float max, int... colors) {
+
+        this.title = title;
+        this.min   = min;
+        this.max   = max;
+
+        linePaints = new Paint[colors.length];
+        points     = new float[colors.length][];
+
+        for(int i = 0; i < colors.length; i++)
+        {
+            linePaints[i] = new Paint(Paint.ANTI_ALIAS_FLAG);
+            linePaints[i].setColor(colors[i]);
+            linePaints[i].setStrokeWidth(2);
+        }
+
+        invalidate();
+    }
+
+    /**
+     * Set the points of a series and redraw
+     *
+     * @param series - series number, in the order of the setup colours
+     * @param values - points, oldest first
+     */
+    public void setPoints(int series, float[] values) {
+
+        if(points[series] == null || points[series].length != values.length)
+        {
+            points[series] = new float[values.length];
+        }
+
+        System.arraycopy(values, 0, points[series], 0, values.length);
+        invalidate();
+    }
+
+    /**
+     * Height of a value, clamped to the range
+     */
+    float getY(float value) {
+
+        float fraction = (value - min) / (max - min);
+
+        return (getHeight() - 1) * (1 - Math.max(0, Math.min(1, fraction)));
+    }
+
+    /**
+     * @see android.view.View#onDraw(android.graphics.Canvas)
+     */
+    @Override
+    protected void onDraw(Canvas canvas) {
+
+        canvas.drawRect(0, 0, getWidth() - 1, getHeight() - 1, framePaint);
+        canvas.drawText(title, 4, TITLE_SIZE, titlePaint);
+
+        for(int i = 0; i < points.length; i++)
+        {
+            float[] values = points[i];
+
+            if(values == null || values.length < 2)
+            {
+                continue;
+            }
+
+            float step = (float)(getWidth() - 1) / (values.length - 1);
+
+            for(int j = 1; j < values.length; j++)
+            {
+                if(!Float.isNaN(values[j - 1]) && !Float.isNaN(values[j]))
+                {
+                    canvas.drawLine((j - 1) * step, getY(values[j - 1]),
+                                    j * step, getY(values[j]), linePaints[i]);
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,101 @@
+/******************************************************************************
+ * NAME: ClockSync
+ *
+ * DESCRIPTION:
+ *   Measures the offset of this phone's clock from the robot's 1ms tick. A
+ *   clock query carries the phone's time, the reply echoes it with the
+ *   robot's time when it answered. Taking the robot's time to be halfway
+ *   through the round trip, the offset is the midpoint of the query's send
+ *   and receive times less the robot's time.
+ *
+ *   A query delayed on the way out or back moves its midpoint, so only the
+ *   query with the shortest round trip of the last SAMPLES is used, it
+ *   suffered the least queueing. The error is then at most half that round
+ *   trip.
+ *
+ *   Times are 32-bit ms counts that wrap, as on the robot.
+ *****************************************************************************/
+package com.sharpedev.robotremote;
+
+public class ClockSync {
+
+    static final int  SAMPLES     = 8;
+    static final long MAX_RTT     = 500; //ms, slower replies are ignored
+
+    long[] rtts    = new long[SAMPLES];
+    long[] offsets = new long[SAMPLES];
+    int    count   = 0;
+    int    next    = 0;
+
+    /**
+     * Get the phone's time in the robot's format
+     *
+     * @param uptime - phone time in ms
+     * @return the time as the 32-bit count sent to the robot
+     */
+    public static long toTime(long uptime) {
+
+        return uptime & 0xFFFFFFFFL;
+    }
+
+    /**
+     * Forget the replies, for a new link to a robot that may have restarted
+     */
+    public synchronized void reset() {
+
+        count = 0;
+        next  = 0;
+    }
+
+    /**
+     * Record a clock reply
+     *
+     * @param sent - phone time echoed by the robot, 32-bit
+     * @param robot - robot time in the reply, 32-bit
+     * @param received - phone time the reply arrived, 32-bit
+     */
+    public synchronized void onReply(long sent, long robot, long received) {
+
+        long rtt = (received - sent) & 0xFFFFFFFFL;
+
+        if(rtt > MAX_RTT)
+        {
+            return;
+        }
+
+        rtts[next]    = rtt;
+        offsets[next] = (sent + rtt / 2 - robot) & 0xFFFFFFFFL;
+        next          = (next + 1) % SAMPLES;
+        count         = Math.min(count + 1, SAMPLES);
+    }
+
+    /**
+     * Check if the offset has been measured
+     *
+     * @return true once a reply has been recorded
+     */
+    public synchronized boolean isSynced() {
+
+        return count > 0;
+    }
+
+    /**
+     * Get the offset from the reply with the shortest round trip
+     *
+     * @return phone time minus robot time, 32-bit, 0 until synced
+     */
+    public synchronized long getOffset() {
+
+        int best = -1;
+
+        for(int i = 0; i < count; i++)
+        {
+            if(best < 0 || rtts[i] < rtts[best])
+            {
+                best = i;
+            }
+        }
+
+        return (best < 0) ? 0 : offsets[best];
+    }
+}
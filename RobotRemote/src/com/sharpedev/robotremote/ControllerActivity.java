@@ -1,226 +1,444 @@
-/******************************************************************************
- * NAME: ControllerActivity
- * 
- * DESCRIPTION:
- *   Main user interface for sending commands and displaying status from the 
- *   device under control. 
- *****************************************************************************/
-package com.sharpedev.robotremote;
-
-
-import android.os.Bundle;
-import android.os.Handler;
-import android.os.Message;
-import android.app.Activity;
-import android.app.AlertDialog;
-import android.util.Log;
-import android.view.Menu;
-import android.view.MotionEvent;
-import android.view.View;
-import android.view.View.OnTouchListener;
-import android.widget.ImageButton;
-
-public class ControllerActivity extends Activity {  
-    
-    RobotRemoteApp  app           = null;
-    AlertDialog     alertDialog   = null;
-    ImageButton     forwardButton = null;
-    ImageButton     backButton    = null;
-    ImageButton     rightButton   = null;
-    ImageButton     leftButton    = null;
-    Thread          monitorThread = null;
-    
-    //Constants for UI messages sent from threads to UI thread
-    private class UiMsg {
-        public final static int DISMISS_ALERT = 0;
-        public final static int SHOW_ALERT    = 1;
-    }
-    
-    //Inner class to process UI messaging from non-UI threads to the UI thread
-    Handler uiMsgHandler = new Handler () {
-        
-        public void handleMessage (Message msg) {
-
-            switch(msg.what) {
-                case UiMsg.DISMISS_ALERT:
-                    alertDialog.dismiss();
-                    break;
-                case UiMsg.SHOW_ALERT:
-                    alertDialog.show();
-                    break;
-            }         
-        }
-    };
-    
-    /**
-     * Create the activity. Get the context of the application 
-     * object which will be responsible for keeping the 
-     * interface for the device under control persistent 
-     * through activity starts and stops.
-     * 
-     * @see android.app.Activity#onCreate(android.os.Bundle)
-     */
-    @Override
-    protected void onCreate(Bundle savedInstanceState) {
-        super.onCreate(savedInstanceState);
-        setContentView(R.layout.activity_main);
-        
-        //Record the application class. This is the owner of the UDP interface.
-        //Commands will be sent through the application class
-        app = (RobotRemoteApp)getApplication();     
-        
-        //Create a dialog to alert the user when connection with robot is lost
-        alertDialog = new AlertDialog.Builder(this).create();
-        alertDialog.setTitle("Robot Remote");
-        alertDialog.setMessage("Waiting for robot network connection...");
-        
-        //Get the button objects
-        forwardButton = (ImageButton)findViewById(R.id.buttonFwd);
-        backButton    = (ImageButton)findViewById(R.id.buttonBack);
-        rightButton   = (ImageButton)findViewById(R.id.buttonRight);
-        leftButton    = (ImageButton)findViewById(R.id.buttonLeft);
-        
-        //Inner class for common button touch handling code
-        class ButtonEventHandler implements OnTouchListener {
-            @Override
-            public boolean onTouch(View view, MotionEvent event) {
-                
-                //Assume we do not handle the event
-                boolean ret = false;
-                
-                if(event.getAction() == MotionEvent.ACTION_DOWN) {
-                    
-                    //Determine which button was pressed and 
-                    //send that direction command to the robot
-                    //TODO allow user to control speed value in sendCommand method call
-                    switch (view.getId()) {
-                        case R.id.buttonFwd:
-                            app.sendCommand(Directions.FORWARD, 100);
-                            ret = true;
-                            break;
-                        case R.id.buttonBack:
-                            app.sendCommand(Directions.BACKWARD, 100);
-                            ret = true;
-                            break;
-                        case R.id.buttonRight:
-                            app.sendCommand(Directions.RIGHT, 100); 
-                            ret = true;
-                            break;
-                        case R.id.buttonLeft:
-                            app.sendCommand(Directions.LEFT, 100); 
-                            ret = true;
-                            break;
-                        default: 
-                            break;
-                    }
-                } 
-                else if (event.getAction() == MotionEvent.ACTION_UP) {
-                    
-                    //All up events send stop command to the robot
-                    app.sendCommand(Directions.STOP, 0);
-                    ret = true;
-                }
-                
-                return ret;
-            }
-        }
-                
-        //Set listeners for the robot movement buttons
-        forwardButton.setOnTouchListener(new ButtonEventHandler());
-        backButton.setOnTouchListener(new ButtonEventHandler());
-        rightButton.setOnTouchListener(new ButtonEventHandler());
-        leftButton.setOnTouchListener(new ButtonEventHandler());                    
-    }
-    
-    /**
-     * @see android.app.Activity#onResume()
-     */
-    @Override
-    protected void onResume() {
-        super.onResume();
-        // The activity has become visible
-        
-        //If monitor thread is not already running 
-        if(monitorThread == null) {
-            
-            //Start a thread to monitor for the robot connection
-            runConnectionMonitor(); 
-        }
-    }
-    
-    /**
-     * @see android.app.Activity#onPause()
-     */
-    @Override
-    protected void onPause() {
-        super.onPause();
-        
-        // Another activity is taking focus. Stop the monitor thread
-        monitorThread.interrupt();
-    }
-    
-    /* (non-Javadoc)
-     * @see android.app.Activity#onCreateOptionsMenu(android.view.Menu)
-     */
-    @Override
-    public boolean onCreateOptionsMenu(Menu menu) {
-        // Inflate the menu; this adds items to the action bar if it is present.
-        getMenuInflater().inflate(R.menu.main, menu);
-        return true;
-    }   
-    
-    /**
-     * Run a thread that checks if the connection to the device is still active.
-     * If it is not then the activity displays a message to alert the user that 
-     * communications with the controlled device have been lost.
-     */
-    public void runConnectionMonitor() {                                        
-        
-        //Start a thread to monitor for the robots connection status
-        monitorThread = new Thread() {
-            @Override
-            public void run() {             
-                try {                   
-                    
-                    while(!monitorThread.isInterrupted()) {
-                        
-                        if(!app.isRobotConnected()) {
-                            
-                            Log.i("RobotRemote", "Activity waiting for robot to connect");
-                                                    
-                            //Show a dialog until the app is connected to the robot
-                            uiMsgHandler.sendEmptyMessage(UiMsg.SHOW_ALERT); 
-                            
-                            //check if connected!
-                            while (!app.isRobotConnected()) { 
-                                
-                                //Wait for connect
-                                Thread.sleep(1000);                     
-                            }
-                            
-                            //Robot is connected, dismiss the alert dialog
-                            uiMsgHandler.sendEmptyMessage(UiMsg.DISMISS_ALERT);
-                            
-                            Log.i("RobotRemote", "Activity ready"); 
-                        }
-                        
-                        Thread.sleep(1000);
-                    }                                        
-                } 
-                catch(InterruptedException e) {
-                    
-                    monitorThread = null;
-                    return;
-                }
-                catch (Exception e) {
-                    
-                    Log.e("RobotRemote", "Activity connect monitor exception");
-                    e.printStackTrace();
-                }                
-            }
-        };
-        
-        monitorThread.start();               
-    }
-}
-
+/******************************************************************************
+ * NAME: ControllerActivity
+ * 
+ * DESCRIPTION:
+ *   Main user interface for sending commands and displaying status from the 
+ *   device under control. 
+ *
+ *   A Bluetooth or USB gamepad drives too. Its stick axes arrive as generic
+ *   motion events and go straight to the app's coalesced wheel targets, 
+ *   with no view in between, the left stick's vertical axis for speed and 
+ *   the horizontal axis of either stick for turning.
+ *
+ *   Telemetry and the link quality reach the screen through the dashboard,
+ *   which folds them into one frame per display refresh on a thread of its
+ *   own, so the UI thread gets at most one message per frame however fast
+ *   the robot reports.
+ *****************************************************************************/
+package com.sharpedev.robotremote;
+
+
+import android.os.Bundle;
+import android.os.Handler;
+import android.os.Message;
+import android.os.SystemClock;
+import android.app.Activity;
+import android.app.AlertDialog;
+import android.graphics.Color;
+import android.util.Log;
+import android.view.InputDevice;
+import android.view.Menu;
+import android.view.MotionEvent;
+import android.view.View;
+import android.view.View.OnTouchListener;
+import android.widget.ImageButton;
+import android.widget.TextView;
+
+public class ControllerActivity extends Activity {  
+    
+    RobotRemoteApp  app           = null;
+    AlertDialog     alertDialog   = null;
+    ImageButton     forwardButton = null;
+    ImageButton     backButton    = null;
+    ImageButton     rightButton   = null;
+    ImageButton     leftButton    = null;
+    TextView        telemetryText = null;
+    TextView        linkText      = null;
+    JoystickView    joystick      = null;
+    ChartView       dutyChart     = null;
+    ChartView       batteryChart  = null;
+    ChartView       rttChart      = null;
+    ChartView       lossChart     = null;
+    
+    //Telemetry and link quality are charted at the display frame rate
+    TelemetryDashboard dashboard  = null;
+    
+    //Chart ranges
+    static final float DUTY_MAX    = 100;  //percent
+    static final float BATTERY_MIN = 6.0f; //V
+    static final float BATTERY_MAX = 8.4f; //V
+    static final float RTT_MAX     = 300;  //ms
+    static final float LOSS_MAX    = 100;  //percent
+    
+    //Stick positions inside this fraction of full travel count as centered
+    //when the device does not give its own flat range
+    static final float GAMEPAD_DEAD_ZONE = 0.1f;
+    boolean         gamepadDriving = false;
+    
+    //Constants for UI messages sent from threads to UI thread
+    private class UiMsg {
+        public final static int DISMISS_ALERT = 0;
+        public final static int SHOW_ALERT    = 1;
+        public final static int DASHBOARD     = 2;
+    }
+    
+    //Inner class to process UI messaging from non-UI threads to the UI thread
+    Handler uiMsgHandler = new Handler () {
+        
+        public void handleMessage (Message msg) {
+
+            switch(msg.what) {
+                case UiMsg.DISMISS_ALERT:
+                    alertDialog.dismiss();
+                    break;
+                case UiMsg.SHOW_ALERT:
+                    alertDialog.show();
+                    break;
+                case UiMsg.DASHBOARD:
+                    showDashboard((TelemetryDashboard.Frame)msg.obj);
+                    break;
+            }         
+        }
+    };
+    
+    //Passes the dashboard frames from the dashboard thread to the UI thread
+    TelemetryDashboard.Listener dashboardListener = 
+            new TelemetryDashboard.Listener() {
+        
+        public void onFrame(TelemetryDashboard.Frame frame) {
+            
+            uiMsgHandler.obtainMessage(UiMsg.DASHBOARD, frame).sendToTarget();
+        }
+    };
+    
+    //Shows the alert while the robot network is down
+    WifiMonitor.Listener connectionListener = new WifiMonitor.Listener() {
+        
+        public void onConnectionChanged(boolean connected) {
+            
+            Log.i("RobotRemote", connected ? "Activity ready" : 
+                                             "Activity waiting for robot to connect");
+            
+            uiMsgHandler.sendEmptyMessage(connected ? UiMsg.DISMISS_ALERT : 
+                                                      UiMsg.SHOW_ALERT);
+        }
+    };
+    
+    /**
+     * Create the activity. Get the context of the application 
+     * object which will be responsible for keeping the 
+     * interface for the device under control persistent 
+     * through activity starts and stops.
+     * 
+     * @see android.app.Activity#onCreate(android.os.Bundle)
+     */
+    @Override
+    protected void onCreate(Bundle savedInstanceState) {
+        super.onCreate(savedInstanceState);
+        setContentView(R.layout.activity_main);
+        
+        //Record the application class. This is the owner of the UDP interface.
+        //Commands will be sent through the application class
+        app = (RobotRemoteApp)getApplication();     
+        
+        //Create a dialog to alert the user when connection with robot is lost
+        alertDialog = new AlertDialog.Builder(this).create();
+        alertDialog.setTitle("Robot Remote");
+        alertDialog.setMessage("Waiting for robot network connection...");
+        
+        //Get the button objects
+        forwardButton = (ImageButton)findViewById(R.id.buttonFwd);
+        backButton    = (ImageButton)findViewById(R.id.buttonBack);
+        rightButton   = (ImageButton)findViewById(R.id.buttonRight);
+        leftButton    = (ImageButton)findViewById(R.id.buttonLeft);
+        telemetryText = (TextView)findViewById(R.id.textTelemetry);
+        linkText      = (TextView)findViewById(R.id.textLink);
+        joystick      = (JoystickView)findViewById(R.id.joystick);
+        dutyChart     = (ChartView)findViewById(R.id.chartDuty);
+        batteryChart  = (ChartView)findViewById(R.id.chartBattery);
+        rttChart      = (ChartView)findViewById(R.id.chartRtt);
+        lossChart     = (ChartView)findViewById(R.id.chartLoss);
+        
+        dutyChart.setup(getString(R.string.chart_duty), -DUTY_MAX, DUTY_MAX,
+                        Color.BLUE, Color.RED);
+        batteryChart.setup(getString(R.string.chart_battery), BATTERY_MIN, 
+                           BATTERY_MAX, Color.GREEN);
+        rttChart.setup(getString(R.string.chart_rtt), 0, RTT_MAX, Color.YELLOW);
+        lossChart.setup(getString(R.string.chart_loss), 0, LOSS_MAX, Color.MAGENTA);
+        
+        dashboard = new TelemetryDashboard();
+        dashboard.setListener(dashboardListener);
+        
+        //Inner class for common button touch handling code
+        class ButtonEventHandler implements OnTouchListener {
+            @Override
+            public boolean onTouch(View view, MotionEvent event) {
+                
+                //Assume we do not handle the event. The event time stamps
+                //the command for the latency trace.
+                boolean ret = false;
+                
+                if(event.getAction() == MotionEvent.ACTION_DOWN) {
+                    
+                    //Determine which button was pressed and 
+                    //send that direction command to the robot
+                    //TODO allow user to control speed value in sendCommand method call
+                    switch (view.getId()) {
+                        case R.id.buttonFwd:
+                            app.sendCommand(Directions.FORWARD, 100, 
+                                            event.getEventTime());
+                            ret = true;
+                            break;
+                        case R.id.buttonBack:
+                            app.sendCommand(Directions.BACKWARD, 100, 
+                                            event.getEventTime());
+                            ret = true;
+                            break;
+                        case R.id.buttonRight:
+                            app.sendCommand(Directions.RIGHT, 100, 
+                                            event.getEventTime()); 
+                            ret = true;
+                            break;
+                        case R.id.buttonLeft:
+                            app.sendCommand(Directions.LEFT, 100, 
+                                            event.getEventTime()); 
+                            ret = true;
+                            break;
+                        default: 
+                            break;
+                    }
+                } 
+                else if (event.getAction() == MotionEvent.ACTION_UP ||
+                         event.getAction() == MotionEvent.ACTION_CANCEL) {
+                    
+                    //All up events send stop command to the robot. A 
+                    //cancelled touch stops too or the keepalives would 
+                    //keep the robot driving.
+                    app.sendCommand(Directions.STOP, 0, event.getEventTime());
+                    ret = true;
+                }
+                
+                return ret;
+            }
+        }
+                
+        //Set listeners for the robot movement buttons
+        forwardButton.setOnTouchListener(new ButtonEventHandler());
+        backButton.setOnTouchListener(new ButtonEventHandler());
+        rightButton.setOnTouchListener(new ButtonEventHandler());
+        leftButton.setOnTouchListener(new ButtonEventHandler());                    
+        
+        //The joystick mixes forward speed and turn into wheel targets, the
+        //app sends the latest at the control rate. Letting go stops at once.
+        joystick.setOnMoveListener(new JoystickView.OnMoveListener() {
+            
+            public void onMove(float x, float y) {
+                
+                setMixedTargets(x, y, SystemClock.uptimeMillis());
+            }
+            
+            public void onRelease() {
+                
+                app.stopWheels();
+            }
+        });
+    }
+    
+    /**
+     * Drive from a gamepad's sticks. Only the newest position in the event
+     * is used, the app sends the latest targets at the control rate anyway.
+     * Centering the sticks stops the wheels once.
+     * 
+     * @see android.app.Activity#onGenericMotionEvent(android.view.MotionEvent)
+     */
+    @Override
+    public boolean onGenericMotionEvent(MotionEvent event) {
+        
+        if((event.getSource() & InputDevice.SOURCE_JOYSTICK) != InputDevice.SOURCE_JOYSTICK ||
+           event.getAction() != MotionEvent.ACTION_MOVE)
+        {
+            return super.onGenericMotionEvent(event);
+        }
+        
+        float x = getCenteredAxis(event, MotionEvent.AXIS_X);
+        float y = -getCenteredAxis(event, MotionEvent.AXIS_Y);
+        
+        if(x == 0)
+        {
+            x = getCenteredAxis(event, MotionEvent.AXIS_Z);
+        }
+        
+        if(x == 0 && y == 0)
+        {
+            if(gamepadDriving)
+            {
+                gamepadDriving = false;
+                app.stopWheels();
+            }
+            return true;
+        }
+        
+        gamepadDriving = true;
+        setMixedTargets(x, y, event.getEventTime());
+        return true;
+    }
+    
+    /**
+     * Get an axis of a gamepad event, zero inside the axis' flat range
+     * 
+     * @param event - joystick motion event
+     * @param axis - MotionEvent axis
+     * @return position, -1 to 1
+     */
+    static float getCenteredAxis(MotionEvent event, int axis) {
+        
+        InputDevice device = event.getDevice();
+        InputDevice.MotionRange range = (device == null) ? null : 
+                device.getMotionRange(axis, event.getSource());
+        
+        if(range == null)
+        {
+            return 0;
+        }
+        
+        float flat  = Math.max(range.getFlat(), GAMEPAD_DEAD_ZONE);
+        float value = event.getAxisValue(axis);
+        
+        return (Math.abs(value) > flat) ? value : 0;
+    }
+    
+    /**
+     * Mix forward speed and turn into wheel targets for the app to send
+     * 
+     * @param x - turn, -1 full left to 1 full right
+     * @param y - speed, -1 full backward to 1 full forward
+     * @param time - uptime of the input, ms
+     */
+    void setMixedTargets(float x, float y, long time) {
+        
+        int left  = Math.round(Math.max(-1, Math.min(1, y + x)) * 100);
+        int right = Math.round(Math.max(-1, Math.min(1, y - x)) * 100);
+        
+        app.setWheelTargets(left, right, time);
+    }
+    
+    /**
+     * @see android.app.Activity#onResume()
+     */
+    @Override
+    protected void onResume() {
+        super.onResume();
+        // The activity has become visible
+        
+        //Chart the robot telemetry while visible
+        dashboard.start();
+        app.setTelemetryListener(dashboard);
+        app.setLinkListener(dashboard);
+        
+        //Alert the user until the robot network is connected
+        if(!app.isRobotConnected()) {
+            
+            uiMsgHandler.sendEmptyMessage(UiMsg.SHOW_ALERT);
+        }
+        
+        app.setConnectionListener(connectionListener);
+    }
+    
+    /**
+     * @see android.app.Activity#onPause()
+     */
+    @Override
+    protected void onPause() {
+        super.onPause();
+        
+        // Another activity is taking focus. Stop listening to the robot
+        //and stop a gamepad drive, its centering would not be seen
+        if(gamepadDriving)
+        {
+            gamepadDriving = false;
+            app.stopWheels();
+        }
+        
+        app.setConnectionListener(null);
+        app.setTelemetryListener(null);
+        app.setLinkListener(null);
+        dashboard.stop();
+    }
+    
+    /**
+     * @see android.app.Activity#onDestroy()
+     */
+    @Override
+    protected void onDestroy() {
+        super.onDestroy();
+        
+        dashboard.quit();
+    }
+    
+    /* (non-Javadoc)
+     * @see android.app.Activity#onCreateOptionsMenu(android.view.Menu)
+     */
+    @Override
+    public boolean onCreateOptionsMenu(Menu menu) {
+        // Inflate the menu; this adds items to the action bar if it is present.
+        getMenuInflater().inflate(R.menu.main, menu);
+        return true;
+    }   
+    
+    /**
+     * Show a dashboard frame, the newest telemetry and link quality and the
+     * charts, then hand it back for the next
+     * 
+     * @param frame - frame from the dashboard
+     */
+    void showDashboard(TelemetryDashboard.Frame frame) {
+        
+        if(frame.batch != null)
+        {
+            showTelemetry(frame.batch);
+        }
+        
+        if(frame.quality != null)
+        {
+            showLinkQuality(frame.quality);
+        }
+        
+        dutyChart.setPoints(0, frame.series[TelemetryDashboard.SERIES_LEFT_DUTY]);
+        dutyChart.setPoints(1, frame.series[TelemetryDashboard.SERIES_RIGHT_DUTY]);
+        batteryChart.setPoints(0, frame.series[TelemetryDashboard.SERIES_BATTERY]);
+        rttChart.setPoints(0, frame.series[TelemetryDashboard.SERIES_RTT]);
+        lossChart.setPoints(0, frame.series[TelemetryDashboard.SERIES_LOSS]);
+        
+        dashboard.release();
+    }
+    
+    /**
+     * Show the newest sample of a telemetry batch
+     * 
+     * @param batch - telemetry received from the robot
+     */
+    void showTelemetry(TelemetryBatch batch) {
+        
+        TelemetryBatch.Sample sample = batch.getLatest();
+        
+        if(sample == null)
+        {
+            return;
+        }
+        
+        String range = (batch.rangeMin == TelemetryBatch.RANGE_CLEAR) ?
+                       getString(R.string.range_clear) :
+                       getString(R.string.range_format, batch.rangeMin);
+        
+        telemetryText.setText(getString(R.string.telemetry_format, 
+                                        sample.battery / 1000.0,
+                                        batch.batteryMin / 1000.0,
+                                        sample.leftCurrent / 1000.0,
+                                        sample.leftDuty,
+                                        sample.rightCurrent / 1000.0,
+                                        sample.rightDuty) + "\n" + range);
+    }
+    
+    /**
+     * Show the link quality
+     * 
+     * @param quality - link quality measured by the app
+     */
+    void showLinkQuality(LinkMonitor.Quality quality) {
+        
+        linkText.setText(getString(R.string.link_format, quality.rtt,
+                                   Math.round(quality.loss * 100),
+                                   quality.rssi));
+    }
+}
+
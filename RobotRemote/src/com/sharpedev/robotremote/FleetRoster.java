@@ -0,0 +1,264 @@
+/******************************************************************************
+ * NAME: FleetRoster
+ *
+ * DESCRIPTION:
+ *   The robots driven together as a fleet. Each member has its fleet id,
+ *   its address on the robot network, the wheel targets for the next fleet
+ *   frame and a link monitor of its own fed by its acknowledgements. One
+ *   fleet frame carries the targets of every member and is broadcast, each
+ *   robot obeys its own entry. Once every member's clock is synced the
+ *   frame can be timed, each robot converts the phone time with its own
+ *   offset so they all start together.
+ *
+ *   The robots have to share a network for this, a robot running its own
+ *   access point only ever hears the one phone joined to it.
+ *****************************************************************************/
+package com.sharpedev.robotremote;
+
+import java.net.InetAddress;
+import java.util.ArrayList;
+
+public class FleetRoster {
+
+    /**
+     * A robot in the fleet
+     */
+    public static class Member {
+        public final int         id;
+        public final InetAddress address;
+        public final LinkMonitor link = new LinkMonitor();
+        public final ClockSync   clock = new ClockSync();
+        int left  = 0;
+        int right = 0;
+
+        Member(int id, InetAddress address) {
+
+            this.id      = id;
+            this.address = address;
+        }
+    }
+
+    //Entries that fit a timed frame, the time takes the room of two
+    static final int FLEET_AT_MAX = RobotProtocol.FLEET_MAX - 2;
+
+    final ArrayList<Member> members = new ArrayList<Member>();
+    boolean pending = false;
+
+    //Entries of the frame being built
+    int[] ids    = new int[RobotProtocol.FLEET_MAX];
+    int[] lefts  = new int[RobotProtocol.FLEET_MAX];
+    int[] rights = new int[RobotProtocol.FLEET_MAX];
+
+    /**
+     * Add a robot to the fleet, replacing any member with the same id
+     *
+     * @param id - fleet id set on the robot, 1 to 254
+     * @param address - the robot's address, its acknowledgements come from it
+     * @return the member, null if the fleet is full
+     */
+    public synchronized Member add(int id, InetAddress address) {
+
+        remove(id);
+
+        if(members.size() >= RobotProtocol.FLEET_MAX)
+        {
+            return null;
+        }
+
+        Member member = new Member(id, address);
+
+        members.add(member);
+        return member;
+    }
+
+    /**
+     * Remove a robot from the fleet
+     *
+     * @param id - fleet id
+     */
+    public synchronized void remove(int id) {
+
+        for(int i = 0; i < members.size(); i++)
+        {
+            if(members.get(i).id == id)
+            {
+                members.remove(i);
+                return;
+            }
+        }
+    }
+
+    /**
+     * Find the member a datagram came from
+     *
+     * @param address - sender address
+     * @return the member, null if the sender is not in the fleet
+     */
+    public synchronized Member find(InetAddress address) {
+
+        for(Member member : members)
+        {
+            if(member.address.equals(address))
+            {
+                return member;
+            }
+        }
+
+        return null;
+    }
+
+    /**
+     * Get a copy of the member list
+     *
+     * @return the members
+     */
+    public synchronized Member[] getMembers() {
+
+        return members.toArray(new Member[members.size()]);
+    }
+
+    /**
+     * Set the wheel targets of one robot for the next fleet frame
+     *
+     * @param id - fleet id
+     * @param left - left wheel speed (-100% to 100%)
+     * @param right - right wheel speed (-100% to 100%)
+     */
+    public synchronized void setTargets(int id, int left, int right) {
+
+        for(Member member : members)
+        {
+            if(member.id == id)
+            {
+                member.left  = left;
+                member.right = right;
+                pending      = true;
+            }
+        }
+    }
+
+    /**
+     * Stop every robot in the fleet with the next fleet frame
+     */
+    public synchronized void stopAll() {
+
+        for(Member member : members)
+        {
+            member.left  = 0;
+            member.right = 0;
+        }
+
+        pending = true;
+    }
+
+    /**
+     * Check if targets have been set since the last fleet frame
+     *
+     * @return true if a fleet frame is due
+     */
+    public synchronized boolean isPending() {
+
+        return pending;
+    }
+
+    /**
+     * Check if any member is commanded to move, the fleet frame is then
+     * repeated to hold off the robots' failsafe
+     *
+     * @return true if a member is moving
+     */
+    public synchronized boolean isMoving() {
+
+        for(Member member : members)
+        {
+            if(member.left != 0 || member.right != 0)
+            {
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    /**
+     * Check if every member's clock is synced, so a timed frame runs on all
+     * of them
+     *
+     * @return true if the fleet may be sent timed frames
+     */
+    public synchronized boolean isSynced() {
+
+        for(Member member : members)
+        {
+            if(!member.clock.isSynced())
+            {
+                return false;
+            }
+        }
+
+        return members.size() > 0 && members.size() <= FLEET_AT_MAX;
+    }
+
+    /**
+     * Add the targets of every member to the frame being built
+     *
+     * @param protocol - frame builder, the caller holds its lock
+     * @param time - phone time for the members to run them at, 32-bit, -1
+     *               to run them on arrival
+     * @return number of members in the frame
+     */
+    public synchronized int addFrame(RobotProtocol protocol, long time) {
+
+        int count = members.size();
+
+        for(int i = 0; i < count; i++)
+        {
+            Member member = members.get(i);
+
+            ids[i]    = member.id;
+            lefts[i]  = member.left;
+            rights[i] = member.right;
+        }
+
+        if(count > 0 && time >= 0)
+        {
+            protocol.beginAt(time);
+            protocol.addFleet(ids, lefts, rights, count);
+            protocol.endAt();
+        }
+        else if(count > 0)
+        {
+            protocol.addFleet(ids, lefts, rights, count);
+        }
+
+        pending = false;
+        return count;
+    }
+
+    /**
+     * Record a fleet frame being sent on every member's link
+     *
+     * @param seq - frame sequence number
+     * @param now - time in ms
+     */
+    public synchronized void onSend(int seq, long now) {
+
+        for(Member member : members)
+        {
+            member.link.onSend(seq, now);
+        }
+    }
+
+    /**
+     * Time out lost frames on every member's link
+     *
+     * @param now - time in ms
+     */
+    public synchronized void update(long now) {
+
+        for(Member member : members)
+        {
+            member.link.update(now);
+        }
+    }
+}
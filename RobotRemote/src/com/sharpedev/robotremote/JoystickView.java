@@ -0,0 +1,142 @@
+/******************************************************************************
+ * NAME: JoystickView
+ *
+ * DESCRIPTION:
+ *   Virtual joystick. The knob follows the touch inside the base circle and
+ *   springs back to the centre when released. The position is reported as
+ *   x (right positive) and y (up positive), each from -1 to 1.
+ *****************************************************************************/
+package com.sharpedev.robotremote;
+
+import android.content.Context;
+import android.graphics.Canvas;
+import android.graphics.Color;
+import android.graphics.Paint;
+import android.util.AttributeSet;
+import android.view.MotionEvent;
+import android.view.View;
+
+public class JoystickView extends View {
+
+    /**
+     * Receives the joystick position, called on the UI thread
+     */
+    public interface OnMoveListener {
+        void onMove(float x, float y);
+        void onRelease();
+    }
+
+    //Knob radius as a fraction of the base radius
+    static final float KNOB_RATIO = 0.3f;
+
+    Paint          basePaint = new Paint(Paint.ANTI_ALIAS_FLAG);
+    Paint          knobPaint = new Paint(Paint.ANTI_ALIAS_FLAG);
+    float          knobX     = 0;
+    float          knobY     = 0;
+    OnMoveListener listener  = null;
+
+    public JoystickView(Context context) {
+        super(context);
+        init();
+    }
+
+    public JoystickView(Context context, AttributeSet attrs) {
+        super(context, attrs);
+        init();
+    }
+
+    /**
+     * Set up the paints
+     */
+    void init() {
+
+        basePaint.setColor(Color.GRAY);
+        basePaint.setStyle(Paint.Style.STROKE);
+        basePaint.setStrokeWidth(4);
+        knobPaint.setColor(Color.DKGRAY);
+    }
+
+    /**
+     * Set the listener for joystick movement
+     *
+     * @param listener - the listener, null to stop listening
+     */
+    public void setOnMoveListener(OnMoveListener listener) {
+
+        this.listener = listener;
+    }
+
+    /**
+     * Radius the knob centre can move within
+     */
+    float getTravel() {
+
+        return Math.min(getWidth(), getHeight()) / 2 * (1 - KNOB_RATIO);
+    }
+
+    /**
+     * @see android.view.View#onDraw(android.graphics.Canvas)
+     */
+    @Override
+    protected void onDraw(Canvas canvas) {
+
+        float centreX = getWidth() / 2;
+        float centreY = getHeight() / 2;
+        float radius  = Math.min(centreX, centreY);
+        float travel  = getTravel();
+
+        canvas.drawCircle(centreX, centreY, radius - 2, basePaint);
+        canvas.drawCircle(centreX + knobX * travel, centreY - knobY * travel,
+                          radius * KNOB_RATIO, knobPaint);
+    }
+
+    /**
+     * Move the knob with the touch, limited to the base circle
+     *
+     * @see android.view.View#onTouchEvent(android.view.MotionEvent)
+     */
+    @Override
+    public boolean onTouchEvent(MotionEvent event) {
+
+        switch(event.getAction()) {
+            case MotionEvent.ACTION_DOWN:
+            case MotionEvent.ACTION_MOVE:
+                float travel = getTravel();
+                float x = (event.getX() - getWidth() / 2) / travel;
+                float y = (getHeight() / 2 - event.getY()) / travel;
+                float length = (float) Math.sqrt(x * x + y * y);
+
+                if(length > 1) {
+
+                    x /= length;
+                    y /= length;
+                }
+
+                knobX = x;
+                knobY = y;
+
+                if(listener != null) {
+
+                    listener.onMove(x, y);
+                }
+                break;
+
+            case MotionEvent.ACTION_UP:
+            case MotionEvent.ACTION_CANCEL:
+                knobX = 0;
+                knobY = 0;
+
+                if(listener != null) {
+
+                    listener.onRelease();
+                }
+                break;
+
+            default:
+                return false;
+        }
+
+        invalidate();
+        return true;
+    }
+}
@@ -0,0 +1,234 @@
+/******************************************************************************
+ * NAME: LatencyTrace
+ *
+ * DESCRIPTION:
+ *   Breaks the delay from a touch to the robot's motors changing down into
+ *   stages. One frame at a time is stamped with the time of the touch event
+ *   that caused it. The phone notes when the frame was queued and when the
+ *   send thread handed it to the socket, and the robot sends back its own
+ *   stage times with the stamp:
+ *
+ *     UI        touch event to the frame queued
+ *     socket    queued to the socket send returning
+ *     air       sent to the +IPD header on the robot's UART
+ *     UART      the rest of the datagram and its wait in the receive pool
+ *     parse     packet taken to the command dispatched
+ *     dispatch  dispatch to the PWM period with the new duty
+ *
+ *   The air stage compares the phone's clock with the robot's, so it needs
+ *   the clock synced and is off by as much as the sync error. The phone
+ *   stages are only as fine as its 1ms clock, the robot's are microseconds.
+ *   Each stage keeps a histogram of power of 2 buckets of microseconds.
+ *
+ *   Times are phone uptime in ms, as in the touch events.
+ *****************************************************************************/
+package com.sharpedev.robotremote;
+
+public class LatencyTrace implements UdpSocket.SendListener {
+
+    static final String[] STAGES = { "UI", "socket", "air", "UART", "parse",
+                                     "dispatch" };
+    static final int UI       = 0;
+    static final int SOCKET   = 1;
+    static final int AIR      = 2;
+    static final int UART     = 3;
+    static final int PARSE    = 4;
+    static final int DISPATCH = 5;
+
+    //Bucket n holds times from 2^n to 2^(n+1) - 1 us, the last anything
+    //longer
+    static final int  BUCKETS  = 18;
+    static final long TIMEOUT  = 1000;   //ms for the robot's report
+    static final int  NONE     = 0xFFFF; //the robot saw no output change
+
+    int[][] histograms = new int[STAGES.length][BUCKETS];
+    int[]   counts     = new int[STAGES.length];
+    long[]  sums       = new long[STAGES.length]; //us
+    boolean enabled    = false;
+
+    //Stamp in flight, touch time -1 when there is none
+    long touchTime = -1;
+    long startTime = 0;
+    long queueTime = -1;
+    long sentTime  = -1;
+    int  seq       = -1;
+
+    /**
+     * Start or stop stamping frames, the histograms are kept
+     *
+     * @param enabled - true to trace
+     */
+    public synchronized void setEnabled(boolean enabled) {
+
+        this.enabled = enabled;
+        touchTime    = -1;
+    }
+
+    /**
+     * Clear the histograms
+     */
+    public synchronized void reset() {
+
+        histograms = new int[STAGES.length][BUCKETS];
+        counts     = new int[STAGES.length];
+        sums       = new long[STAGES.length];
+    }
+
+    /**
+     * Start tracing a frame if none is in flight, the caller then stamps it
+     *
+     * @param touch - time of the touch event, ms
+     * @param now - time in ms
+     * @return true if the frame is to carry the stamp
+     */
+    public synchronized boolean begin(long touch, long now) {
+
+        if(!enabled || touch < 0 || (touchTime >= 0 && now - startTime < TIMEOUT))
+        {
+            return false;
+        }
+
+        touchTime = touch;
+        startTime = now;
+        queueTime = -1;
+        sentTime  = -1;
+        seq       = -1;
+        return true;
+    }
+
+    /**
+     * Record the stamped frame being queued for the send thread
+     *
+     * @param seq - frame sequence number
+     * @param now - time in ms
+     */
+    public synchronized void onQueued(int seq, long now) {
+
+        if(touchTime >= 0 && queueTime < 0)
+        {
+            this.seq  = seq;
+            queueTime = now;
+        }
+    }
+
+    /**
+     * Record a frame leaving the socket, called on the send thread
+     *
+     * @param msg - the frame
+     * @param length - frame length in bytes
+     * @param now - time the socket send returned, ms
+     */
+    public synchronized void onSent(byte[] msg, int length, long now) {
+
+        if(queueTime >= 0 && sentTime < 0 && length > 2 && (msg[2] & 0xFF) == seq)
+        {
+            sentTime = now;
+        }
+    }
+
+    /**
+     * Record the robot's stage times for the stamped frame
+     *
+     * @param report - stamp, robot header time, UART, parse and dispatch
+     *                 times, see RobotProtocol.parseLatency
+     * @param clock - the robot's clock sync
+     * @return true if the report was for the frame in flight
+     */
+    public synchronized boolean onReport(long[] report, ClockSync clock) {
+
+        if(touchTime < 0 || report[0] != ClockSync.toTime(touchTime) || sentTime < 0)
+        {
+            return false;
+        }
+
+        record(UI, (queueTime - touchTime) * 1000);
+        record(SOCKET, (sentTime - queueTime) * 1000);
+
+        if(clock.isSynced())
+        {
+            //The header time on the phone's clock, less the send time
+            int air = (int) ((report[1] + clock.getOffset() -
+                              ClockSync.toTime(sentTime)) & 0xFFFFFFFFL);
+
+            record(AIR, Math.max(air, 0) * 1000L);
+        }
+
+        record(UART, report[2]);
+        record(PARSE, report[3]);
+
+        if(report[4] != NONE)
+        {
+            record(DISPATCH, report[4]);
+        }
+
+        touchTime = -1;
+        return true;
+    }
+
+    /**
+     * Add a time to a stage's histogram
+     *
+     * @param stage - stage index
+     * @param us - time in us
+     */
+    void record(int stage, long us) {
+
+        int bucket = 0;
+
+        while(bucket < BUCKETS - 1 && (us >> (bucket + 1)) > 0)
+        {
+            bucket++;
+        }
+
+        histograms[stage][bucket]++;
+        counts[stage]++;
+        sums[stage] += us;
+    }
+
+    /**
+     * Get the number of frames traced
+     *
+     * @return count of robot reports recorded
+     */
+    public synchronized int getCount() {
+
+        return counts[UI];
+    }
+
+    /**
+     * Get a copy of a stage's histogram
+     *
+     * @param stage - stage index, UI to DISPATCH
+     * @return count in each bucket
+     */
+    public synchronized int[] getHistogram(int stage) {
+
+        return histograms[stage].clone();
+    }
+
+    /**
+     * Get the mean and the histogram of every stage, one line each
+     *
+     * @return the summary
+     */
+    public synchronized String getSummary() {
+
+        StringBuilder text = new StringBuilder();
+
+        for(int stage = 0; stage < STAGES.length; stage++)
+        {
+            text.append(String.format("%-8s %5d  mean %8.2f ms ", STAGES[stage],
+                        counts[stage], (counts[stage] == 0) ? 0.0 :
+                        sums[stage] / (counts[stage] * 1000.0)));
+
+            for(int bucket = 0; bucket < BUCKETS; bucket++)
+            {
+                text.append(' ').append(histograms[stage][bucket]);
+            }
+
+            text.append('\n');
+        }
+
+        return text.toString();
+    }
+}
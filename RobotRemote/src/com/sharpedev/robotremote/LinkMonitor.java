@@ -0,0 +1,198 @@
+/******************************************************************************
+ * NAME: LinkMonitor
+ *
+ * DESCRIPTION:
+ *   Measures the quality of the link to the robot from the acknowledgements
+ *   it sends back. The robot acknowledges the last sequence number it
+ *   accepted, at most every 50ms, so an acknowledgement covers every frame
+ *   up to that number and the round trip time of the acknowledged frame
+ *   includes up to one acknowledgement interval. A frame not covered by an
+ *   acknowledgement within LOSS_TIMEOUT counts as lost. Because only the
+ *   newest command matters to the robot this is the loss that affects
+ *   control: a lost frame followed by one that arrives is not counted.
+ *
+ *   The send rate and redundancy for the control commands are derived from
+ *   the smoothed round trip time and loss.
+ *
+ *   Frames may skip sequence numbers when the ones in between went to other
+ *   robots, as with one monitor per fleet member. The skipped numbers are 
+ *   neither lost nor acknowledged.
+ *****************************************************************************/
+package com.sharpedev.robotremote;
+
+public class LinkMonitor {
+
+    static final long LOSS_TIMEOUT = 500; //ms without acknowledgement
+    static final int  MAX_PENDING  = 128; //frames, half the sequence space
+
+    //Control rates and the link quality each needs
+    static final long INTERVAL_FAST   = 20;  //ms
+    static final long INTERVAL_MEDIUM = 40;  //ms
+    static final long INTERVAL_SLOW   = 80;  //ms
+    static final int  RTT_MEDIUM      = 150; //ms
+    static final int  RTT_SLOW        = 300; //ms
+    static final float LOSS_MEDIUM    = 0.1f;
+    static final float LOSS_SLOW      = 0.3f;
+
+    //Copies of the earlier control commands each control frame carries, 
+    //and the times the last one is repeated, for lossy links
+    static final float LOSS_REPEAT_1  = 0.05f;
+    static final float LOSS_REPEAT_2  = 0.2f;
+
+    /**
+     * Snapshot of the link quality
+     */
+    public static class Quality {
+        public int   rtt;  //smoothed round trip time, ms, 0 until measured
+        public float loss; //fraction of frames lost
+        public int   rssi; //received signal strength, dBm
+    }
+
+    long[]  sendTimes = new long[256];
+    boolean[] sent    = new boolean[256]; //frame went to this robot
+    boolean started   = false;
+    int     resolved  = 0; //oldest frame not yet acknowledged or lost
+    int     nextSeq   = 0; //sequence after the last frame sent
+    float   srtt      = 0; //ms
+    float   loss      = 0;
+
+    /**
+     * Record a frame being sent
+     *
+     * @param seq - frame sequence number
+     * @param now - time in ms
+     */
+    public synchronized void onSend(int seq, long now) {
+
+        if(!started || ((seq - nextSeq) & 0xFF) >= MAX_PENDING)
+        {
+            //First frame or the sequence was reset, start over
+            resolved = seq;
+            nextSeq  = seq;
+            started  = true;
+        }
+
+        //Frames in between went to other robots
+        while(nextSeq != seq)
+        {
+            sent[nextSeq] = false;
+            nextSeq = (nextSeq + 1) & 0xFF;
+        }
+
+        sent[seq]      = true;
+        sendTimes[seq] = now;
+        nextSeq = (seq + 1) & 0xFF;
+
+        //Keep acknowledgements unambiguous
+        if(((nextSeq - resolved) & 0xFF) > MAX_PENDING)
+        {
+            record(true);
+        }
+    }
+
+    /**
+     * Record an acknowledgement from the robot
+     *
+     * @param seq - last sequence number accepted by the robot
+     * @param now - time in ms
+     * @return round trip time of the acknowledged frame in ms, -1 if the
+     *         acknowledgement was ignored
+     */
+    public synchronized long onAck(int seq, long now) {
+
+        int covered = ((seq - resolved) & 0xFF) + 1;
+
+        //Ignore acknowledgements of frames already resolved
+        if(!started || covered > ((nextSeq - resolved) & 0xFF))
+        {
+            return -1;
+        }
+
+        long rtt = now - sendTimes[seq];
+
+        srtt = (srtt == 0) ? rtt : srtt + (rtt - srtt) / 8;
+
+        while(covered-- > 0)
+        {
+            record(false);
+        }
+
+        return rtt;
+    }
+
+    /**
+     * Count the frames that have waited too long as lost
+     *
+     * @param now - time in ms
+     */
+    public synchronized void update(long now) {
+
+        while(started && resolved != nextSeq &&
+              (!sent[resolved] || now - sendTimes[resolved] > LOSS_TIMEOUT))
+        {
+            record(true);
+        }
+    }
+
+    /**
+     * Resolve the oldest pending frame and add it to the loss average if it 
+     * went to this robot
+     */
+    void record(boolean lost) {
+
+        if(sent[resolved])
+        {
+            loss += ((lost ? 1 : 0) - loss) / 16;
+        }
+
+        resolved = (resolved + 1) & 0xFF;
+    }
+
+    /**
+     * Get the interval between control commands the link can carry
+     *
+     * @return interval in ms
+     */
+    public synchronized long getSendInterval() {
+
+        if(srtt < RTT_MEDIUM && loss < LOSS_MEDIUM)
+        {
+            return INTERVAL_FAST;
+        }
+
+        if(srtt < RTT_SLOW && loss < LOSS_SLOW)
+        {
+            return INTERVAL_MEDIUM;
+        }
+
+        return INTERVAL_SLOW;
+    }
+
+    /**
+     * Get the number of earlier control commands each control frame should
+     * carry copies of, also the times the last one should be repeated
+     *
+     * @return copies to send, at most RobotProtocol.REPEAT_MAX
+     */
+    public synchronized int getRedundancy() {
+
+        return (loss < LOSS_REPEAT_1) ? 0 : (loss < LOSS_REPEAT_2) ? 1 : 2;
+    }
+
+    /**
+     * Get a snapshot of the link quality
+     *
+     * @param rssi - received signal strength in dBm
+     * @return the link quality
+     */
+    public synchronized Quality getQuality(int rssi) {
+
+        Quality quality = new Quality();
+
+        quality.rtt  = Math.round(srtt);
+        quality.loss = loss;
+        quality.rssi = rssi;
+
+        return quality;
+    }
+}
@@ -0,0 +1,85 @@
+/******************************************************************************
+ * NAME: LogMessages
+ *
+ * DESCRIPTION:
+ *   Formats the log records sent by the robot.
+ *
+ *   Generated by Robot/RobotController/tools/GenerateLogTable.py, do not
+ *   edit
+ *****************************************************************************/
+package com.sharpedev.robotremote;
+
+public class LogMessages {
+
+    static final String[] FORMATS = {
+        "Failsafe stopped the robot %u ms after the last command", //FAILSAFE_TRIP
+        "Module link settled at %u00 baud", //BAUD_SETTLED
+        "Configuration saved to slot %u", //CONFIG_SAVED
+        "Configuration save to slot %u failed to verify", //CONFIG_SAVE_FAILED
+        "Sequence of %u bytes refused", //SEQUENCE_REFUSED
+        "Link %u connected, role %u", //LINK_OPENED
+        "Link %u closed", //LINK_CLOSED
+        "Calibration at duty %u, left %u right %u edges/s", //CALIBRATION_POINT
+        "Calibration stopped, a wheel did not turn at full duty", //CALIBRATION_FAILED
+        "Obstacle at %u mm, forward speed held to %u percent", //REFLEX_LIMIT
+        "Link moved to the controller at *.*.%u.%u port %u", //PEER_FOLLOWED
+        "Speed limit set to %u percent on the robot", //SPEED_LIMIT
+        "Path of %u bytes refused", //PATH_REFUSED
+        "Path of %u waypoints finished", //PATH_DONE
+        "Firmware update of %u blocks started", //OTA_BEGIN
+        "Firmware update failed, result %u", //OTA_FAILED
+        "Firmware update of %u blocks staged", //OTA_STAGED
+        "Resetting to apply the firmware update", //OTA_APPLY
+        "Module fault, recovery step %u started", //ESP_RECOVERY
+        "Module recovered at step %u", //ESP_RECOVERED
+        "Overcurrent trip %u, speed held to %u percent", //DRIVE_TRIP
+        "Overcurrent trip %u in a row, motors off until the commands stop" //DRIVE_LATCHED
+    };
+
+    /**
+     * Format a log record
+     *
+     * @param id - message id
+     * @param args - 16-bit arguments, unsigned
+     * @return the message text
+     */
+    public static String format(int id, int[] args) {
+
+        if(id >= FORMATS.length)
+        {
+            return "Unknown log " + id;
+        }
+
+        String        format = FORMATS[id];
+        StringBuilder text   = new StringBuilder();
+        int           arg    = 0;
+
+        for(int i = 0; i < format.length(); i++)
+        {
+            char c = format.charAt(i);
+
+            if(c != '%' || i + 1 >= format.length() || arg >= args.length)
+            {
+                text.append(c);
+                continue;
+            }
+
+            int value = args[arg++];
+
+            switch(format.charAt(++i))
+            {
+                case 'd':
+                    text.append((short) value);
+                    break;
+                case 'x':
+                    text.append(Integer.toHexString(value));
+                    break;
+                default:
+                    text.append(value);
+                    break;
+            }
+        }
+
+        return text.toString();
+    }
+}
\ No newline at end of file
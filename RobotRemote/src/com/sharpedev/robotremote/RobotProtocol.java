@@ -0,0 +1,862 @@
+/******************************************************************************
+ * NAME: RobotProtocol
+ * 
+ * DESCRIPTION:
+ *   Builds the binary control frames understood by the robot and decodes 
+ *   the frames it sends back. A frame holds a header, a sequence number, a 
+ *   list of commands and a CRC-8 so several commands can share one datagram
+ *   and the robot can drop stale frames. Must match Protocol.h in the robot
+ *   firmware.
+ *
+ *   Frame layout:
+ *     [0]       sync byte 0xA5
+ *     [1]       version (high nibble) and flags (low nibble)
+ *     [2]       sequence number
+ *     [3]       length of the command list in bytes
+ *     [4..n-2]  command list, each command is type, length, value
+ *     [n-1]     CRC-8 (poly 0x07, init 0) of bytes 1 through n-2
+ *****************************************************************************/
+package com.sharpedev.robotremote;
+
+import java.util.ArrayList;
+
+public class RobotProtocol {
+    
+    //Frame constants
+    static final int SYNC           = 0xA5;
+    static final int VERSION        = 1;
+    static final int HEADER_SIZE    = 4;
+    static final int MAX_FRAME      = 64; //Robot receive buffer size
+    static final int MAX_COMMANDS   = MAX_FRAME - HEADER_SIZE - 1;
+    static final int FLAG_SEQ_RESET = 0x01;
+    
+    //Command types
+    static final int CMD_DRIVE      = 0x01;
+    static final int CMD_WHEELS     = 0x02;
+    static final int CMD_ACK_MODE   = 0x03;
+    static final int CMD_VELOCITY   = 0x04;
+    static final int CMD_BENCH      = 0x05;
+    static final int CMD_CONFIG     = 0x08;
+    static final int CMD_KEEPALIVE  = 0x09;
+    static final int CMD_DISCOVER   = 0x10;
+    static final int CMD_FLEET      = 0x11;
+    static final int CMD_CLOCK      = 0x12;
+    static final int CMD_AT         = 0x13;
+    static final int CMD_SETPOINT   = 0x14;
+    static final int CMD_STAMP      = 0x15;
+    static final int CMD_PATH       = 0x16;
+    static final int CMD_REPEAT     = 0x18;
+    static final int CMD_TWIST      = 0x19;
+    static final int CMD_ACK        = 0x80;
+    static final int CMD_TELEMETRY  = 0x84;
+    static final int CMD_LOG        = 0x87;
+    static final int CMD_CLOCK_REPLY = 0x89;
+    static final int CMD_GESTURE    = 0x8B;
+    static final int CMD_LATENCY    = 0x8C;
+    static final int CMD_TELEMETRY_COMPACT = 0x8D;
+    static final int CMD_LOAD       = 0x8F;
+    static final int CMD_SOAK       = 0x90;
+    
+    //Touch key gestures, must match Gesture.h in the robot firmware
+    static final String[] GESTURES = { "none", "touch", "tap", "double tap", 
+                                       "long press" };
+    
+    //Configuration fields
+    static final int CONFIG_TELEMETRY = 8; //sample period, 10ms units
+    static final int CONFIG_ROBOT_ID  = 11; //fleet id
+    static final int CONFIG_TELEMETRY_FORMAT = 12;
+    
+    //Telemetry formats
+    static final int TELEMETRY_FULL    = 0;
+    static final int TELEMETRY_COMPACT = 1; //changes only, see TelemetryDecoder
+    
+    //Fleet entries, id then signed left and right percent
+    static final int FLEET_ENTRY    = 3;
+    static final int FLEET_ALL      = 0xFF; //entry for every robot
+    static final int FLEET_MAX      = (MAX_COMMANDS - 2) / FLEET_ENTRY;
+    
+    //Paths, velocity then signed x and y mm of each waypoint, must match 
+    //Path.h in the robot firmware
+    static final int PATH_POINT     = 4;
+    static final int PATH_MAX       = 12;
+    
+    //Clock actions
+    static final int CLOCK_QUERY    = 0;
+    static final int CLOCK_SET      = 1;
+    
+    //Benchmark actions
+    static final int BENCH_SOAK     = 4;
+    
+    //Soak snapshots, uptime then 16-bit counters. Must match Soak.h in the
+    //robot firmware.
+    static final int SOAK_REPORT    = 42;
+    static final int SOAK_COUNTERS  = (SOAK_REPORT - 4) / 2;
+    
+    //Acknowledgement modes
+    static final int ACK_NONE       = 0;
+    static final int ACK_CUMULATIVE = 1;
+    static final int ACK_ECHO       = 2;
+    
+    //Repeated control commands, sequence of the frame each first went in
+    //then the command. Must match PROTO_REPEAT_WINDOW in the robot 
+    //firmware, older copies are ignored.
+    static final int REPEAT_HEADER  = 3;
+    static final int REPEAT_MAX     = 2;
+    static final int REPEAT_WINDOW  = 8;
+    
+    int     sequence      = 0;
+    boolean seqReset      = true;
+    byte[]  commands      = new byte[MAX_COMMANDS];
+    int     commandLength = 0;
+    int     commandStart  = 0;  //last command added
+    int     atStart       = -1; //timed command being built
+    
+    //Last control commands kept by endControl, newest last
+    byte[][] controlHistory = new byte[REPEAT_MAX][];
+    int[]    controlSeq     = new int[REPEAT_MAX];
+    int      controlCount   = 0;
+    
+    /**
+     * Add a drive command to the frame being built
+     * 
+     * @param cmd - the direction the robot should move
+     * @param speed - the speed the robot should move (0% to 100%)
+     */
+    public synchronized void addDrive(Directions cmd, int speed) {
+        
+        startCommand(CMD_DRIVE, 2);
+        put(cmd.ordinal());
+        put(speed);
+    }
+    
+    /**
+     * Add a per wheel speed command to the frame being built
+     * 
+     * @param left - left wheel speed (-100% to 100%)
+     * @param right - right wheel speed (-100% to 100%)
+     */
+    public synchronized void addWheels(int left, int right) {
+        
+        startCommand(CMD_WHEELS, 2);
+        put(left);
+        put(right);
+    }
+    
+    /**
+     * Add an arc command to the frame being built. The robot gives the 
+     * wheels the speed less and plus the turn, scaled back together past 
+     * full speed so the arc keeps its curvature.
+     * 
+     * @param speed - forward speed (-100% to 100%)
+     * @param turn - turn rate (-100% to 100%), positive is counterclockwise
+     */
+    public synchronized void addTwist(int speed, int turn) {
+        
+        startCommand(CMD_TWIST, 2);
+        put(speed);
+        put(turn);
+    }
+    
+    /**
+     * Add a closed loop wheel velocity command to the frame being built
+     * 
+     * @param left - left wheel velocity in encoder edges per second
+     * @param right - right wheel velocity in encoder edges per second
+     */
+    public synchronized void addVelocity(int left, int right) {
+        
+        startCommand(CMD_VELOCITY, 4);
+        put(left);
+        put(left >> 8);
+        put(right);
+        put(right >> 8);
+    }
+    
+    /**
+     * Add a wheel setpoint to the frame being built. The robot plays the 
+     * samples out a fixed delay after they were taken, interpolating 
+     * between them, so the phone's clock must be synced to the robot's.
+     * 
+     * @param time - phone time the sample was taken, 32-bit
+     * @param left - left wheel speed (-100% to 100%)
+     * @param right - right wheel speed (-100% to 100%)
+     */
+    public synchronized void addSetpoint(long time, int left, int right) {
+        
+        startCommand(CMD_SETPOINT, 6);
+        putLong(time);
+        put(left);
+        put(right);
+    }
+    
+    /**
+     * Stamp the frame being built with the time of the input that caused
+     * it. The robot traces the next command added and sends back its stage
+     * times, see LatencyTrace.
+     * 
+     * @param time - phone time of the input, 32-bit
+     */
+    public synchronized void addStamp(long time) {
+        
+        startCommand(CMD_STAMP, 4);
+        putLong(time);
+    }
+    
+    /**
+     * Add a path to the frame being built. The robot steers through the 
+     * waypoints on its own odometry, from the pose it was last reset at,
+     * and stops at the last.
+     * 
+     * @param velocity - outer wheel velocity in encoder edges per second
+     * @param x - waypoint distances ahead of the reset pose in mm
+     * @param y - waypoint distances to the left of the reset pose in mm
+     * @param count - number of waypoints, at most PATH_MAX
+     */
+    public synchronized void addPath(int velocity, int[] x, int[] y, int count) {
+        
+        startCommand(CMD_PATH, 2 + count * PATH_POINT);
+        put(velocity);
+        put(velocity >> 8);
+        
+        for(int i = 0; i < count; i++)
+        {
+            put(x[i]);
+            put(x[i] >> 8);
+            put(y[i]);
+            put(y[i] >> 8);
+        }
+    }
+    
+    /**
+     * Add a keepalive to the frame being built. The robot stops if it is 
+     * moving and no frame arrives within its failsafe timeout.
+     */
+    public synchronized void addKeepalive() {
+        
+        startCommand(CMD_KEEPALIVE, 0);
+    }
+    
+    /**
+     * Start or stop the robot's soak test counter snapshots, see 
+     * parseSoak
+     * 
+     * @param seconds - snapshot period, 1 to 255, 0 stops
+     */
+    public synchronized void addSoak(int seconds) {
+        
+        startCommand(CMD_BENCH, 2);
+        put(BENCH_SOAK);
+        put(seconds);
+    }
+    
+    /**
+     * Add a discovery beacon to the frame being built. The robot moves its 
+     * link to wherever a valid frame comes from, the beacon makes sure one
+     * arrives as soon as the link starts.
+     */
+    public synchronized void addDiscover() {
+        
+        startCommand(CMD_DISCOVER, 0);
+    }
+    
+    /**
+     * Add an acknowledgement mode command to the frame being built
+     * 
+     * @param mode - ACK_NONE, ACK_CUMULATIVE or ACK_ECHO
+     */
+    public synchronized void addAckMode(int mode) {
+        
+        startCommand(CMD_ACK_MODE, 1);
+        put(mode);
+    }
+    
+    /**
+     * Add fleet wheel targets to the frame being built. Each robot obeys 
+     * the entry with its own id or FLEET_ALL and ignores the rest.
+     * 
+     * @param ids - robot ids
+     * @param left - left wheel speed of each robot (-100% to 100%)
+     * @param right - right wheel speed of each robot (-100% to 100%)
+     * @param count - number of entries, at most FLEET_MAX
+     */
+    public synchronized void addFleet(int[] ids, int[] left, int[] right, int count) {
+        
+        startCommand(CMD_FLEET, count * FLEET_ENTRY);
+        
+        for(int i = 0; i < count; i++)
+        {
+            put(ids[i]);
+            put(left[i]);
+            put(right[i]);
+        }
+    }
+    
+    /**
+     * Add a clock query to the frame being built, the robot answers at once
+     * with the time echoed and its own time
+     * 
+     * @param time - phone time, 32-bit, see ClockSync
+     */
+    public synchronized void addClockQuery(long time) {
+        
+        startCommand(CMD_CLOCK, 5);
+        put(CLOCK_QUERY);
+        putLong(time);
+    }
+    
+    /**
+     * Set the offset the robot applies to the time of timed commands
+     * 
+     * @param offset - phone time minus robot time, 32-bit
+     */
+    public synchronized void addClockSet(long offset) {
+        
+        startCommand(CMD_CLOCK, 5);
+        put(CLOCK_SET);
+        putLong(offset);
+    }
+    
+    /**
+     * Start a timed command, the next command added is held by the robot 
+     * until the time and endAt must follow it. A timed fleet command is cut 
+     * down to the robot's own entry, so it may hold only FLEET_MAX - 2 
+     * entries to leave room for the time.
+     * 
+     * @param time - phone time to run at, 32-bit
+     */
+    public synchronized void beginAt(long time) {
+        
+        startCommand(CMD_AT, 0);
+        atStart = commandLength - 2;
+        putLong(time);
+    }
+    
+    /**
+     * Finish the timed command started by beginAt
+     */
+    public synchronized void endAt() {
+        
+        if(atStart >= 0)
+        {
+            commands[atStart + 1] = (byte) (commandLength - atStart - 2);
+            atStart = -1;
+        }
+    }
+    
+    /**
+     * Start a control command, such as a drive, wheels or setpoint. Copies
+     * of the last control commands sent go in first, oldest first, and the 
+     * robot runs a copy only if the frame it first went in was lost, so a 
+     * lost command is made good by the next frame rather than by a resend.
+     * The control command and endControl must follow. Copies that are too 
+     * old for the robot to tell from ones received or that do not fit are
+     * left out.
+     * 
+     * @param copies - control commands to copy, at most REPEAT_MAX
+     */
+    public synchronized void beginControl(int copies) {
+        
+        int first = Math.max(controlCount - copies, 0);
+        
+        for(int i = first; i < controlCount; i++)
+        {
+            byte[] command = controlHistory[i];
+            
+            if(((sequence - controlSeq[i]) & 0xFF) >= REPEAT_WINDOW ||
+               commandLength + 2 + 1 + command.length > MAX_COMMANDS)
+            {
+                continue;
+            }
+            
+            startCommand(CMD_REPEAT, command.length + 1);
+            put(controlSeq[i]);
+            System.arraycopy(command, 0, commands, commandLength, command.length);
+            commandLength += command.length;
+        }
+    }
+    
+    /**
+     * Finish the control command started by beginControl, keeping it to 
+     * copy into the next control frames
+     */
+    public synchronized void endControl() {
+        
+        if(controlCount == REPEAT_MAX)
+        {
+            System.arraycopy(controlHistory, 1, controlHistory, 0, REPEAT_MAX - 1);
+            System.arraycopy(controlSeq, 1, controlSeq, 0, REPEAT_MAX - 1);
+            controlCount--;
+        }
+        
+        controlHistory[controlCount] = new byte[commandLength - commandStart];
+        System.arraycopy(commands, commandStart, controlHistory[controlCount], 0, 
+                         commandLength - commandStart);
+        controlSeq[controlCount] = sequence;
+        controlCount++;
+    }
+    
+    /**
+     * Set the robot's fleet id, kept until the robot is reset unless the
+     * configuration is saved
+     * 
+     * @param id - fleet id, 1 to 254
+     */
+    public synchronized void addRobotId(int id) {
+        
+        startCommand(CMD_CONFIG, 2);
+        put(CONFIG_ROBOT_ID);
+        put(id);
+    }
+    
+    /**
+     * Add a telemetry rate command to the frame being built. The robot 
+     * sends the samples in batches and may lower the rate while its link is
+     * congested.
+     * 
+     * @param period - sample period in ms, 0 to stop telemetry
+     */
+    public synchronized void addTelemetryPeriod(int period) {
+        
+        startCommand(CMD_CONFIG, 2);
+        put(CONFIG_TELEMETRY);
+        put(Math.min(period / 10, 255));
+    }
+    
+    /**
+     * Add a telemetry format command to the frame being built
+     * 
+     * @param format - TELEMETRY_FULL or TELEMETRY_COMPACT
+     */
+    public synchronized void addTelemetryFormat(int format) {
+        
+        startCommand(CMD_CONFIG, 2);
+        put(CONFIG_TELEMETRY_FORMAT);
+        put(format);
+    }
+    
+    /**
+     * Add a command to the frame being built
+     * 
+     * @param type - command type
+     * @param value - command data
+     */
+    public synchronized void addCommand(int type, byte[] value) {
+        
+        startCommand(type, value.length);
+        System.arraycopy(value, 0, commands, commandLength, value.length);
+        commandLength += value.length;
+    }
+    
+    /**
+     * Start a command in the frame being built, the value bytes follow
+     * 
+     * @param type - command type
+     * @param length - value length in bytes
+     */
+    void startCommand(int type, int length) {
+        
+        if(commandLength + 2 + length > MAX_COMMANDS)
+        {
+            throw new IllegalStateException("Frame full");
+        }
+        
+        commandStart = commandLength;
+        put(type);
+        put(length);
+    }
+    
+    /**
+     * Add a byte to the command list
+     */
+    void put(int value) {
+        
+        commands[commandLength++] = (byte) value;
+    }
+    
+    /**
+     * Add a 32-bit value to the command list, LSB first
+     */
+    void putLong(long value) {
+        
+        put((int) value);
+        put((int) (value >> 8));
+        put((int) (value >> 16));
+        put((int) (value >> 24));
+    }
+    
+    /**
+     * Finish the frame holding all the commands added since the last call. 
+     * The first frame carries the sequence reset flag so the robot accepts
+     * it whatever sequence number it last saw.
+     * 
+     * @param frame - buffer for the frame, at least MAX_FRAME bytes
+     * @return the frame length in bytes
+     */
+    public synchronized int buildFrame(byte[] frame) {
+        
+        int length = HEADER_SIZE + commandLength + 1;
+        
+        frame[0] = (byte) SYNC;
+        frame[1] = (byte) ((VERSION << 4) | (seqReset ? FLAG_SEQ_RESET : 0));
+        frame[2] = (byte) sequence;
+        frame[3] = (byte) commandLength;
+        System.arraycopy(commands, 0, frame, HEADER_SIZE, commandLength);
+        frame[length - 1] = crc8(frame, 1, length - 2);
+        
+        sequence = (sequence + 1) & 0xFF;
+        seqReset = false;
+        commandLength = 0;
+        
+        return length;
+    }
+    
+    /**
+     * Give a frame built earlier, such as a recorded one, the next sequence
+     * number and a new CRC so the robot takes it as the newest frame. The 
+     * copies it holds are moved along with it so they still refer to the 
+     * frames before it.
+     * 
+     * @param frame - the frame
+     * @param length - frame length in bytes
+     */
+    public synchronized void renumber(byte[] frame, int length) {
+        
+        int shift = sequence - frame[2];
+        
+        for(int i = HEADER_SIZE; i + 2 < length - 1; i += (frame[i + 1] & 0xFF) + 2)
+        {
+            if((frame[i] & 0xFF) == CMD_REPEAT && frame[i + 1] > 0)
+            {
+                frame[i + 2] += shift;
+            }
+        }
+        
+        frame[1] = (byte) ((VERSION << 4) | (seqReset ? FLAG_SEQ_RESET : 0));
+        frame[2] = (byte) sequence;
+        frame[length - 1] = crc8(frame, 1, length - 2);
+        
+        sequence = (sequence + 1) & 0xFF;
+        seqReset = false;
+    }
+    
+    /**
+     * Decode the telemetry in a frame received from the robot
+     * 
+     * @param data - received datagram
+     * @param length - datagram length in bytes
+     * @param decoder - decoder of the robot's compact reports, null to 
+     *                  take full reports only
+     * @return the telemetry batch, null if the frame is invalid or holds no
+     *         telemetry that can be decoded
+     */
+    public static TelemetryBatch parseTelemetry(byte[] data, int length,
+                                                TelemetryDecoder decoder) {
+        
+        int value = findCommand(data, length, CMD_TELEMETRY);
+        
+        if(value >= 0)
+        {
+            return TelemetryBatch.decode(data, value, data[value - 1] & 0xFF);
+        }
+        
+        value = findCommand(data, length, CMD_TELEMETRY_COMPACT);
+        
+        if(value < 0 || decoder == null)
+        {
+            return null;
+        }
+        
+        return decoder.decode(data, value, data[value - 1] & 0xFF);
+    }
+    
+    /**
+     * Decode the log records in a frame received from the robot. The value
+     * is the number of records dropped, then records of a header byte with
+     * the argument count in the top 2 bits and the message id below, each
+     * followed by its 16-bit arguments LSB first. Must match Log.h in the
+     * robot firmware.
+     * 
+     * @param data - received datagram
+     * @param length - datagram length in bytes
+     * @return the formatted messages, null if the frame is invalid or holds
+     *         no log
+     */
+    public static String[] parseLog(byte[] data, int length) {
+        
+        int value = findCommand(data, length, CMD_LOG);
+        
+        if(value < 0 || data[value - 1] < 1)
+        {
+            return null;
+        }
+        
+        int end     = value + (data[value - 1] & 0xFF);
+        int dropped = data[value] & 0xFF;
+        
+        ArrayList<String> lines = new ArrayList<String>();
+        
+        if(dropped > 0)
+        {
+            lines.add(dropped + " log records dropped");
+        }
+        
+        for(int i = value + 1; i < end; )
+        {
+            int   header = data[i] & 0xFF;
+            int[] args   = new int[header >> 6];
+            
+            if(i + 1 + args.length * 2 > end)
+            {
+                break;
+            }
+            
+            for(int n = 0; n < args.length; n++)
+            {
+                args[n] = TelemetryBatch.getShort(data, i + 1 + n * 2);
+            }
+            
+            lines.add(LogMessages.format(header & 0x3F, args));
+            i += 1 + args.length * 2;
+        }
+        
+        return lines.toArray(new String[lines.size()]);
+    }
+    
+    /**
+     * Decode the touch key gestures in a frame received from the robot, one
+     * byte each, oldest first. The robot has already acted on them.
+     * 
+     * @param data - received datagram
+     * @param length - datagram length in bytes
+     * @return the gesture names, null if the frame is invalid or holds no
+     *         gestures
+     */
+    public static String[] parseGestures(byte[] data, int length) {
+        
+        int value = findCommand(data, length, CMD_GESTURE);
+        
+        if(value < 0)
+        {
+            return null;
+        }
+        
+        String[] gestures = new String[data[value - 1] & 0xFF];
+        
+        for(int i = 0; i < gestures.length; i++)
+        {
+            int gesture = data[value + i] & 0xFF;
+            
+            gestures[i] = (gesture < GESTURES.length) ? GESTURES[gesture] : 
+                          "gesture " + gesture;
+        }
+        
+        return gestures;
+    }
+    
+    /**
+     * Get the acknowledged sequence number in a frame received from the robot
+     * 
+     * @param data - received datagram
+     * @param length - datagram length in bytes
+     * @return the last sequence number the robot accepted, -1 if the frame 
+     *         is invalid or holds no acknowledgement
+     */
+    public static int parseAck(byte[] data, int length) {
+        
+        int value = findCommand(data, length, CMD_ACK);
+        
+        if(value < 0 || data[value - 1] < 1)
+        {
+            return -1;
+        }
+        
+        return data[value] & 0xFF;
+    }
+    
+    /**
+     * Get the times in a clock reply received from the robot
+     * 
+     * @param data - received datagram
+     * @param length - datagram length in bytes
+     * @return the phone time echoed and the robot time, 32-bit, null if the
+     *         frame is invalid or holds no clock reply
+     */
+    public static long[] parseClock(byte[] data, int length) {
+        
+        int value = findCommand(data, length, CMD_CLOCK_REPLY);
+        
+        if(value < 0 || (data[value - 1] & 0xFF) < 8)
+        {
+            return null;
+        }
+        
+        return new long[] { getLong(data, value), getLong(data, value + 4) };
+    }
+    
+    /**
+     * Get the stage times of a stamped frame received from the robot. Must
+     * match Latency.h in the robot firmware.
+     * 
+     * @param data - received datagram
+     * @param length - datagram length in bytes
+     * @return the stamp, the robot time the +IPD header arrived in ms, and 
+     *         the UART, parse and dispatch times in us, the last 
+     *         LatencyTrace.NONE if the outputs did not change. Null if the
+     *         frame is invalid or holds no stage times.
+     */
+    public static long[] parseLatency(byte[] data, int length) {
+        
+        int value = findCommand(data, length, CMD_LATENCY);
+        
+        if(value < 0 || (data[value - 1] & 0xFF) < 14)
+        {
+            return null;
+        }
+        
+        return new long[] { getLong(data, value), getLong(data, value + 4),
+                            TelemetryBatch.getShort(data, value + 8),
+                            TelemetryBatch.getShort(data, value + 10),
+                            TelemetryBatch.getShort(data, value + 12) };
+    }
+    
+    /**
+     * Get the main loop load of the last window in a frame received from the
+     * robot. Must match Load.h in the robot firmware.
+     * 
+     * @param data - received datagram
+     * @param length - datagram length in bytes
+     * @return the busy permille, the loop count, then the min, 99th 
+     *         percentile and max loop period in us. Null if the frame is 
+     *         invalid or holds no load report.
+     */
+    public static int[] parseLoad(byte[] data, int length) {
+        
+        int value = findCommand(data, length, CMD_LOAD);
+        
+        if(value < 0 || (data[value - 1] & 0xFF) < 10)
+        {
+            return null;
+        }
+        
+        int[] load = new int[5];
+        
+        for(int i = 0; i < load.length; i++)
+        {
+            load[i] = TelemetryBatch.getShort(data, value + (i * 2));
+        }
+        
+        return load;
+    }
+    
+    /**
+     * Get a soak test counter snapshot in a frame received from the robot.
+     * Must match Soak.h in the robot firmware.
+     * 
+     * @param data - received datagram
+     * @param length - datagram length in bytes
+     * @return the robot's uptime in ms then the snapshot number and the 
+     *         counters in the order of Soak.h. Null if the frame is invalid
+     *         or holds no snapshot.
+     */
+    public static long[] parseSoak(byte[] data, int length) {
+        
+        int value = findCommand(data, length, CMD_SOAK);
+        
+        if(value < 0 || (data[value - 1] & 0xFF) < SOAK_REPORT)
+        {
+            return null;
+        }
+        
+        long[] soak = new long[1 + SOAK_COUNTERS];
+        
+        soak[0] = getLong(data, value);
+        
+        for(int i = 0; i < SOAK_COUNTERS; i++)
+        {
+            soak[1 + i] = TelemetryBatch.getShort(data, value + 4 + (i * 2));
+        }
+        
+        return soak;
+    }
+    
+    /**
+     * Read a 32-bit value, LSB first
+     */
+    static long getLong(byte[] data, int offset) {
+        
+        return (data[offset] & 0xFFL) | ((data[offset + 1] & 0xFFL) << 8) | 
+               ((data[offset + 2] & 0xFFL) << 16) | 
+               ((data[offset + 3] & 0xFFL) << 24);
+    }
+    
+    /**
+     * Check a frame received from the robot and find a command in it
+     * 
+     * @param data - received datagram
+     * @param length - datagram length in bytes
+     * @param type - command type to find
+     * @return offset of the command value, the length is in the byte before,
+     *         -1 if the frame is invalid or does not hold the command
+     */
+    public static int findCommand(byte[] data, int length, int type) {
+        
+        if(length < HEADER_SIZE + 1 || (data[0] & 0xFF) != SYNC || 
+           ((data[1] & 0xFF) >> 4) != VERSION)
+        {
+            return -1;
+        }
+        
+        int end = HEADER_SIZE + (data[3] & 0xFF);
+        
+        if(end + 1 != length || crc8(data, 1, end - 1) != data[end])
+        {
+            return -1;
+        }
+        
+        //Walk the command list
+        for(int i = HEADER_SIZE; i + 2 <= end; )
+        {
+            int valueLength = data[i + 1] & 0xFF;
+            
+            if(i + 2 + valueLength > end)
+            {
+                break;
+            }
+            
+            if((data[i] & 0xFF) == type)
+            {
+                return i + 2;
+            }
+            
+            i += 2 + valueLength;
+        }
+        
+        return -1;
+    }
+    
+    /**
+     * Compute the CRC-8 of part of a buffer (poly 0x07, init 0)
+     * 
+     * @param data - data buffer
+     * @param offset - first byte
+     * @param length - number of bytes
+     * @return the CRC-8
+     */
+    public static byte crc8(byte[] data, int offset, int length) {
+        
+        int crc = 0;
+        
+        for(int i = offset; i < offset + length; i++)
+        {
+            crc ^= data[i] & 0xFF;
+            
+            for(int bit = 0; bit < 8; bit++)
+            {
+                crc = ((crc & 0x80) != 0) ? ((crc << 1) ^ 0x07) : (crc << 1);
+                crc &= 0xFF;
+            }
+        }
+        
+        return (byte) crc;
+    }
+}
@@ -1,168 +1,980 @@
-/******************************************************************************
- * NAME: RobotRemoteApp
- * 
- * DESCRIPTION:
- *   Main application object. This is utilized to allow the interface  
- *   to the device under control to persist through various activity starts 
- *   and stops. For example we do not want to disconnect and reconnect to WIFI
- *   every time the controller activity loses focus.
- *****************************************************************************/
-package com.sharpedev.robotremote;
-
-import java.net.DatagramPacket;
-import java.net.InetAddress;
-
-import android.app.Application;
-import android.util.Log;
-
-/**
- * Enumeration of robot direction commands
- */
-enum Directions
-{
-  STOP,          
-  FORWARD,       
-  BACKWARD, 
-  LEFT,
-  SHARP_LEFT,    
-  RIGHT,         
-  SHARP_RIGHT        
-};
-
-public class RobotRemoteApp extends Application {
-    
-    UdpSocket   udp  = null;
-    WifiMonitor wifi = null;
-    
-    //TODO Allow user to set these parameters from an activity
-    String robotSsid = "STM8S_Robot";
-    String robotPwd  = "";
-    String robotIp   = "192.168.4.1";
-    int    robotPort = 49999;
-    
-    /**
-     * Create the WIFI monitor the connection to the robot and prepare
-     * a UDP socket for communicating with the robot. Start a thread 
-     * to monitor for a valid connection and open the UDP socket once 
-     * we are connected to the robot's WIFI network access point.  
-     * 
-     * @see android.app.Application#onCreate()
-     */
-    @Override
-    public void onCreate() {
-        super.onCreate();
-        try {
-                        
-            wifi = new WifiMonitor(this);  
-            udp  = new UdpSocket(robotPort); //Robot and remote use same port
-            
-            //Set the network credentials for the network to be monitored
-            wifi.setNetwork(robotSsid, robotPwd);
-            wifi.enableAutoConnect();
-            
-            //Set robot address and port number
-            udp.connect(InetAddress.getByName(robotIp), robotPort);
-            
-            //Run application thread
-            runAppThread();   
-        }
-        catch (Exception e) {
-            
-            Log.e("RobotRemote", "App Create Exception");           
-        }
-    }    
-    
-    /**
-     * Thread to monitor for a valid connection to the robot's WIFI network 
-     * access point and monitor for received messages from the UDP socket 
-     */
-    public void runAppThread() {         
-       
-        //Start a thread to process events for the app
-        Thread t = new Thread() {
-            @Override
-            public void run() {
-                try 
-                {    
-                    while(true)
-                    {
-                        //Wait for connection to the robots WIFI access point 
-/*                      if (!wifi.isConnected()) 
-                        {         
-                            //Lost WIFI connection. Stop UDP client.
-                            udp.stop();
-                        }                                             
-*/                                              
-                        //If WIFI is connected but UDP socket is not running (i.e. bound) then start it
-                        if(wifi.isConnected() && !udp.isRunning())
-                        {
-                            udp.start();
-                        }
-                        
-                        //Check if received data from the robot is available
-                        if(udp.isRxDataReady()) {
-                            
-                            DatagramPacket packet = udp.recv();
-                            
-                            //TODO process received packets
-                            Log.d("RobotRemote", "RX packet from " + packet.getAddress() + ":" + packet.getPort());
-                                                        
-                        }
-                        
-                        Thread.sleep(1000);
-                    }                           
-                } 
-                catch (Exception e) {
-                    
-                    Log.e("RobotRemote", "App Monitor Thread Exception");
-                    e.printStackTrace();
-                }
-            }
-        };
-        t.start();
-    }
-    
-    /**
-     * Send a movement command message to the robot
-     * 
-     * @param cmd - the direction the robot should move
-     * @param speed - the speed the robot should move (0% to 100%)
-     */
-    public void sendCommand(Directions cmd, int speed) {
-        
-        //Robot command message structure constants
-        final int DIRECTION     = 0;
-        final int SPEED         = 1;
-        final int NUM_MSG_BYTES = 2;
-        
-        //Create message buffer
-        byte[] msg = new byte[NUM_MSG_BYTES];
-        
-        //Set direction
-        msg[DIRECTION] = (byte) cmd.ordinal();
-        
-        //Set speed
-        msg[SPEED] = (byte) speed;          
-                
-        //Send message to robot
-        udp.send(msg, msg.length);      
-    }
-    
-    /**
-     * Check if the robot communication interface is currently connected.
-     * 
-     * @return true if robot interface is connected, false otherwise
-     */
-    public boolean isRobotConnected() {
-        
-        boolean isConnected = false;
-        
-        if(wifi != null)
-        {
-            isConnected = wifi.isConnected();
-        }
-        
-        return isConnected;
-    }
-}
-
+/******************************************************************************
+ * NAME: RobotRemoteApp
+ * 
+ * DESCRIPTION:
+ *   Main application object. This is utilized to allow the interface  
+ *   to the device under control to persist through various activity starts 
+ *   and stops. For example we do not want to disconnect and reconnect to WIFI
+ *   every time the controller activity loses focus.
+ *****************************************************************************/
+package com.sharpedev.robotremote;
+
+import java.io.File;
+import java.io.IOException;
+import java.net.DatagramPacket;
+import java.net.InetAddress;
+
+import android.app.Application;
+import android.os.SystemClock;
+import android.util.Log;
+
+/**
+ * Enumeration of robot direction commands
+ */
+enum Directions
+{
+  STOP,          
+  FORWARD,       
+  BACKWARD, 
+  LEFT,
+  SHARP_LEFT,    
+  RIGHT,         
+  SHARP_RIGHT        
+};
+
+public class RobotRemoteApp extends Application {
+    
+    /**
+     * Receives the telemetry decoded from the robot, called on the app 
+     * thread
+     */
+    public interface TelemetryListener {
+        void onTelemetry(TelemetryBatch batch);
+    }
+    
+    /**
+     * Receives the link quality every LINK_REPORT_INTERVAL, called on the 
+     * app thread
+     */
+    public interface LinkListener {
+        void onLinkQuality(LinkMonitor.Quality quality);
+    }
+    
+    UdpSocket     udp      = null;
+    WifiMonitor   wifi     = null;
+    RobotProtocol protocol = new RobotProtocol();
+    LinkMonitor   link     = new LinkMonitor();
+    FleetRoster   fleet    = new FleetRoster();
+    ClockSync     clock    = new ClockSync();
+    LatencyTrace  latency  = new LatencyTrace();
+    
+    //The robot being driven sends its telemetry compact, coded against the
+    //samples before
+    TelemetryDecoder telemetry = new TelemetryDecoder();
+    
+    //Every frame sent can be recorded and a recording played back in place
+    //of the controls
+    SessionRecorder recorder = new SessionRecorder();
+    SessionPlayer   player   = new SessionPlayer();
+    
+    //Hours of random driving with the robot's counters charted, see 
+    //SoakTest
+    SoakTest        soak     = new SoakTest(this);
+    
+    //Frames are built here and copied into the socket's send queue while 
+    //holding the protocol lock, which makes the lock holder the queue's 
+    //only producer
+    byte[]        txFrame  = new byte[RobotProtocol.MAX_FRAME];
+    
+    //Keepalives are sent while the robot is commanded to move so that it 
+    //stops by itself if the stop command is lost. Must be well inside the 
+    //robot's failsafe timeout (300ms by default).
+    static final long KEEPALIVE_INTERVAL = 100; //ms
+    volatile boolean  driving            = false;
+    volatile long     lastSendTime       = 0;
+    
+    //Joystick wheel targets are coalesced, only the latest is sent once per
+    //control interval however many touch events arrive. The interval 
+    //follows the link quality. On lossy links every control frame carries 
+    //copies of the commands before it, and the last target, which no frame
+    //follows, is repeated.
+    //Guarded by the protocol lock so a stop can never be overtaken by an 
+    //older target.
+    int               leftTarget         = 0;
+    int               rightTarget        = 0;
+    boolean           targetPending      = false;
+    int               targetRepeats      = 0;
+    
+    //Once the robot's clock is synced the targets go as setpoints stamped
+    //with the time they were set, which the robot smooths over the link's
+    //jitter. Repeats carry the same stamp and the robot drops them. The 
+    //robot stops a stream that stalls, so held targets are restamped in 
+    //place of keepalives.
+    long              targetTime         = 0;
+    boolean           streaming          = false;
+    
+    //Telemetry sample period requested when the link starts, the robot 
+    //sends four samples per datagram
+    static final int  TELEMETRY_PERIOD   = 50;  //ms
+    static final long RX_TIMEOUT         = 100; //ms
+    volatile TelemetryListener telemetryListener = null;
+    
+    static final long LINK_REPORT_INTERVAL = 1000; //ms
+    volatile LinkListener      linkListener      = null;
+    
+    //Hears about the robot network coming and going
+    volatile WifiMonitor.Listener connectionListener = null;
+    
+    //TODO Allow user to set these parameters from an activity
+    String robotSsid = "STM8S_Robot";
+    String robotPwd  = "";
+    String robotIp   = "192.168.4.1";
+    int    robotPort = 49999;
+    
+    //Fleet frames are broadcast on the network the robots share
+    String fleetIp   = "192.168.4.255";
+    volatile long fleetSendTime = 0;
+    
+    //Each robot's clock is read every CLOCK_SYNC_INTERVAL and its offset
+    //set. Fleet frames are then timed to run scheduleDelay after they are 
+    //sent, which must cover the link's worst delivery time so every robot 
+    //starts together however late its copy of the frame arrived.
+    static final long CLOCK_SYNC_INTERVAL = 2000; //ms
+    volatile long     scheduleDelay       = 60;   //ms
+    long              clockSyncTime       = 0;
+    
+    //While latency tracing is on the stage histograms are logged every
+    //LATENCY_LOG_COUNT traced frames
+    static final int  LATENCY_LOG_COUNT   = 20;
+    
+    /**
+     * Create the WIFI monitor the connection to the robot and prepare
+     * a UDP socket for communicating with the robot. Start a thread 
+     * to monitor for a valid connection and open the UDP socket once 
+     * we are connected to the robot's WIFI network access point.  
+     * 
+     * @see android.app.Application#onCreate()
+     */
+    @Override
+    public void onCreate() {
+        super.onCreate();
+        try {
+                        
+            wifi = new WifiMonitor(this);  
+            udp  = new UdpSocket(robotPort); //Robot and remote use same port
+            
+            //Set the network credentials for the network to be monitored
+            wifi.setNetwork(robotSsid, robotPwd);
+            wifi.enableAutoConnect();
+            
+            //Set robot address and port number
+            udp.connect(InetAddress.getByName(robotIp), robotPort);
+            
+            //Times the stamped frames leaving the socket
+            udp.setSendListener(latency);
+            
+            //Restart the link as soon as the robot network comes back
+            wifi.setListener(new WifiMonitor.Listener() {
+                
+                public void onConnectionChanged(boolean connected) {
+                    
+                    if(connected)
+                    {
+                        restartLink();
+                    }
+                    else
+                    {
+                        stopLink();
+                    }
+                    
+                    WifiMonitor.Listener listener = connectionListener;
+                    
+                    if(listener != null)
+                    {
+                        listener.onConnectionChanged(connected);
+                    }
+                }
+            });
+            
+            //Run application thread
+            runAppThread();   
+            
+            //Run the control thread
+            runControlThread();
+        }
+        catch (Exception e) {
+            
+            Log.e("RobotRemote", "App Create Exception");           
+        }
+    }    
+    
+    /**
+     * Thread to process received messages from the UDP socket and track 
+     * the link quality
+     */
+    public void runAppThread() {         
+       
+        //Start a thread to process events for the app
+        Thread t = new Thread() {
+            @Override
+            public void run() {
+                try 
+                {    
+                    long linkReportTime = 0;
+                    
+                    while(true)
+                    {
+                        //Wait for data from the robot, the timeout only 
+                        //paces the loss timeouts below
+                        DatagramPacket packet = udp.recv(RX_TIMEOUT);
+                        
+                        long now = SystemClock.uptimeMillis();
+                        
+                        if(packet != null) {
+                            
+                            int ack = RobotProtocol.parseAck(
+                                    packet.getData(), packet.getLength());
+                            TelemetryBatch batch  = RobotProtocol.parseTelemetry(
+                                    packet.getData(), packet.getLength(),
+                                    packet.getAddress().equals(udp.remoteIp) ? 
+                                    telemetry : null);
+                            String[] log = RobotProtocol.parseLog(
+                                    packet.getData(), packet.getLength());
+                            long[] times = RobotProtocol.parseClock(
+                                    packet.getData(), packet.getLength());
+                            String[] gestures = RobotProtocol.parseGestures(
+                                    packet.getData(), packet.getLength());
+                            long[] stages = RobotProtocol.parseLatency(
+                                    packet.getData(), packet.getLength());
+                            int[] load = RobotProtocol.parseLoad(
+                                    packet.getData(), packet.getLength());
+                            long[] counters = RobotProtocol.parseSoak(
+                                    packet.getData(), packet.getLength());
+                            TelemetryListener listener = telemetryListener;
+                            
+                            FleetRoster.Member member = fleet.find(packet.getAddress());
+                            
+                            if(ack >= 0 && member != null)
+                            {
+                                member.link.onAck(ack, now);
+                            }
+                            
+                            if(ack >= 0 && packet.getAddress().equals(udp.remoteIp))
+                            {
+                                long rtt = link.onAck(ack, now);
+                                
+                                if(rtt >= 0)
+                                {
+                                    soak.onRtt(rtt);
+                                }
+                            }
+                            
+                            if(counters != null && packet.getAddress().equals(udp.remoteIp))
+                            {
+                                soak.onSnapshot(counters);
+                            }
+                            
+                            if(times != null)
+                            {
+                                onClockReply(packet.getAddress(), member, 
+                                             times, now);
+                            }
+                            
+                            if(batch != null && listener != null)
+                            {
+                                listener.onTelemetry(batch);
+                            }
+                            
+                            for(int i = 0; log != null && i < log.length; i++)
+                            {
+                                Log.i("Robot", log[i]);
+                            }
+                            
+                            for(int i = 0; gestures != null && i < gestures.length; i++)
+                            {
+                                Log.i("Robot", "Touch key " + gestures[i]);
+                            }
+                            
+                            if(load != null)
+                            {
+                                Log.i("Robot", "Load " + (load[0] / 10.0) + "%, " + 
+                                      load[1] + " loops, period " + load[2] + 
+                                      "/" + load[3] + "/" + load[4] + "us");
+                            }
+                            
+                            if(stages != null && latency.onReport(stages, clock) &&
+                               latency.getCount() % LATENCY_LOG_COUNT == 0)
+                            {
+                                Log.i("RobotRemote", "Latency\n" + latency.getSummary());
+                            }
+                        }
+                        
+                        //Time out lost frames and report the link quality
+                        link.update(now);
+                        fleet.update(now);
+                        
+                        LinkListener listener = linkListener;
+                        
+                        if(listener != null && now - linkReportTime >= LINK_REPORT_INTERVAL)
+                        {
+                            linkReportTime = now;
+                            listener.onLinkQuality(link.getQuality(wifi.getRssi()));
+                        }
+                    }                           
+                } 
+                catch (Exception e) {
+                    
+                    Log.e("RobotRemote", "App Monitor Thread Exception");
+                    e.printStackTrace();
+                }
+            }
+        };
+        t.start();
+    }
+    
+    /**
+     * Open a fresh UDP socket on the robot network, announce this phone to 
+     * the robot and ask for telemetry. Called on the WIFI monitor thread 
+     * when the connection comes up.
+     */
+    synchronized void restartLink() {
+        
+        if(udp.isRunning())
+        {
+            udp.stop();
+        }
+        
+        udp.start();
+        clock.reset();
+        telemetry.reset();
+        sendDiscover();
+        sendTelemetryFormat(RobotProtocol.TELEMETRY_COMPACT);
+        sendTelemetryPeriod(TELEMETRY_PERIOD);
+    }
+    
+    /**
+     * Close the UDP socket, called on the WIFI monitor thread when the 
+     * connection is lost
+     */
+    synchronized void stopLink() {
+        
+        if(udp.isRunning())
+        {
+            udp.stop();
+        }
+    }
+    
+    /**
+     * Thread to send the latest wheel targets at the control rate and 
+     * keepalives to the robot while it is moving
+     */
+    public void runControlThread() {
+        
+        Thread t = new Thread() {
+            @Override
+            public void run() {
+                try 
+                {
+                    while(true)
+                    {
+                        Thread.sleep(link.getSendInterval());
+                        
+                        if(!udp.isRunning())
+                        {
+                            continue;
+                        }
+                        
+                        synchronized(protocol) {
+                            
+                            if(targetPending)
+                            {
+                                targetPending = false;
+                                targetRepeats = link.getRedundancy();
+                                sendTargets();
+                            }
+                            else if(targetRepeats > 0)
+                            {
+                                targetRepeats--;
+                                sendTargets();
+                            }
+                            else if(streaming && SystemClock.uptimeMillis() - 
+                                    lastSendTime >= KEEPALIVE_INTERVAL)
+                            {
+                                targetTime = SystemClock.uptimeMillis();
+                                sendTargets();
+                            }
+                            else if(driving && SystemClock.uptimeMillis() - 
+                                    lastSendTime >= KEEPALIVE_INTERVAL)
+                            {
+                                sendKeepalive();
+                            }
+                            
+                            if(SystemClock.uptimeMillis() - clockSyncTime >= 
+                               CLOCK_SYNC_INTERVAL)
+                            {
+                                sendClockQueries();
+                            }
+                            
+                            //The fleet frame also serves as the fleet's 
+                            //keepalive while any member is moving
+                            if(fleet.isPending() || (fleet.isMoving() && 
+                               SystemClock.uptimeMillis() - fleetSendTime >= 
+                               KEEPALIVE_INTERVAL))
+                            {
+                                sendFleet();
+                            }
+                        }
+                    }
+                } 
+                catch (InterruptedException e) {
+                    
+                    Log.i("RobotRemote", "Control Thread Stopped");
+                }
+            }
+        };
+        t.start();
+    }
+    
+    /**
+     * Set per wheel targets from continuous input such as the joystick. The
+     * control thread sends the latest targets at the control rate.
+     * 
+     * @param left - left wheel speed (-100% to 100%)
+     * @param right - right wheel speed (-100% to 100%)
+     */
+    public void setWheelTargets(int left, int right) {
+        
+        setWheelTargets(left, right, SystemClock.uptimeMillis());
+    }
+    
+    /**
+     * Set per wheel targets from input that carries its own time, such as 
+     * a motion event, so the setpoint is stamped with when the input was 
+     * made rather than when it was handled
+     * 
+     * @param left - left wheel speed (-100% to 100%)
+     * @param right - right wheel speed (-100% to 100%)
+     * @param time - uptime of the input, ms
+     */
+    public void setWheelTargets(int left, int right, long time) {
+        
+        synchronized(protocol) {
+            leftTarget    = left;
+            rightTarget   = right;
+            targetTime    = time;
+            targetPending = true;
+        }
+    }
+    
+    /**
+     * Stop the wheels at once, any pending targets are dropped. The stop is
+     * repeated like any other target on a lossy link.
+     */
+    public void stopWheels() {
+        
+        synchronized(protocol) {
+            leftTarget    = 0;
+            rightTarget   = 0;
+            targetPending = false;
+            targetRepeats = link.getRedundancy();
+            sendWheels(0, 0);
+        }
+    }
+    
+    /**
+     * Send a movement command message to the robot
+     * 
+     * @param cmd - the direction the robot should move
+     * @param speed - the speed the robot should move (0% to 100%)
+     */
+    public void sendCommand(Directions cmd, int speed) {
+        
+        sendCommand(cmd, speed, -1);
+    }
+    
+    /**
+     * Send a movement command message to the robot, stamped with the time 
+     * of the touch while latency tracing is on
+     * 
+     * @param cmd - the direction the robot should move
+     * @param speed - the speed the robot should move (0% to 100%)
+     * @param touchTime - uptime of the touch event in ms, -1 if none
+     */
+    public void sendCommand(Directions cmd, int speed, long touchTime) {
+        
+        //Build a single command frame and send it to the robot
+        synchronized(protocol) {
+            targetPending = false;
+            targetRepeats = 0;
+            streaming     = false;
+            
+            boolean stamped = latency.begin(touchTime, SystemClock.uptimeMillis());
+            
+            //The stamp traces the command after it, so the copies go first
+            protocol.beginControl(link.getRedundancy());
+            
+            if(stamped)
+            {
+                protocol.addStamp(ClockSync.toTime(touchTime));
+            }
+            
+            protocol.addDrive(cmd, speed);
+            protocol.endControl();
+            sendFrame();
+            
+            if(stamped)
+            {
+                latency.onQueued(txFrame[2] & 0xFF, lastSendTime);
+            }
+        }
+        
+        driving = (cmd != Directions.STOP && speed > 0);
+    }
+    
+    /**
+     * Send per wheel speeds to the robot
+     * 
+     * @param left - left wheel speed (-100% to 100%)
+     * @param right - right wheel speed (-100% to 100%)
+     */
+    public void sendWheels(int left, int right) {
+        
+        synchronized(protocol) {
+            streaming = false;
+            protocol.beginControl(link.getRedundancy());
+            protocol.addWheels(left, right);
+            protocol.endControl();
+            sendFrame();
+        }
+        
+        driving = (left != 0 || right != 0);
+    }
+    
+    /**
+     * Send an arc to the robot, one command in place of a chain of turns 
+     * and drives
+     * 
+     * @param speed - forward speed (-100% to 100%)
+     * @param turn - turn rate (-100% to 100%), positive is counterclockwise
+     */
+    public void sendTwist(int speed, int turn) {
+        
+        synchronized(protocol) {
+            streaming = false;
+            protocol.beginControl(link.getRedundancy());
+            protocol.addTwist(speed, turn);
+            protocol.endControl();
+            sendFrame();
+        }
+        
+        driving = (speed != 0 || turn != 0);
+    }
+    
+    /**
+     * Send a path for the robot to follow on its own, see 
+     * RobotProtocol.addPath. Any drive command ends it early.
+     * 
+     * @param velocity - outer wheel velocity in encoder edges per second
+     * @param x - waypoint distances ahead in mm
+     * @param y - waypoint distances to the left in mm
+     * @param count - number of waypoints, at most RobotProtocol.PATH_MAX
+     */
+    public void sendPath(int velocity, int[] x, int[] y, int count) {
+        
+        synchronized(protocol) {
+            streaming = false;
+            protocol.addPath(velocity, x, y, count);
+            sendFrame();
+        }
+        
+        driving = true;
+    }
+    
+    /**
+     * Send the latest joystick targets, as a setpoint once the robot's clock
+     * is synced. The caller must hold the protocol lock.
+     */
+    void sendTargets() {
+        
+        if(!clock.isSynced())
+        {
+            sendWheels(leftTarget, rightTarget);
+            return;
+        }
+        
+        protocol.beginControl(link.getRedundancy());
+        protocol.addSetpoint(ClockSync.toTime(targetTime), leftTarget, rightTarget);
+        protocol.endControl();
+        sendFrame();
+        driving   = (leftTarget != 0 || rightTarget != 0);
+        streaming = driving;
+    }
+    
+    /**
+     * Send a keepalive to the robot, the commanded motion is unchanged
+     */
+    public void sendKeepalive() {
+        
+        synchronized(protocol) {
+            protocol.addKeepalive();
+            sendFrame();
+        }
+    }
+    
+    /**
+     * Broadcast one frame with the wheel targets of every robot in the 
+     * fleet. Every robot on the network hears it, each acknowledges it to 
+     * this phone and is tracked by its own link monitor.
+     */
+    public void sendFleet() {
+        
+        synchronized(protocol) {
+            
+            long now  = SystemClock.uptimeMillis();
+            long time = fleet.isSynced() ? 
+                        ClockSync.toTime(now + scheduleDelay) : -1;
+            
+            if(fleet.addFrame(protocol, time) == 0)
+            {
+                return;
+            }
+            
+            int length = protocol.buildFrame(txFrame);
+            
+            fleetSendTime = now;
+            
+            try {
+                
+                InetAddress broadcast = InetAddress.getByName(fleetIp);
+                
+                recorder.record(txFrame, length, broadcast);
+                
+                if(udp.send(broadcast, robotPort, txFrame, length) != 0)
+                {
+                    //The robot being driven hears the broadcast too
+                    link.onSend(txFrame[2] & 0xFF, now);
+                    fleet.onSend(txFrame[2] & 0xFF, now);
+                }
+            }
+            catch (Exception e) {
+                
+                Log.e("RobotRemote", "Fleet Send Exception");
+            }
+        }
+    }
+    
+    /**
+     * Query the clock of the robot being driven and of every fleet member
+     */
+    void sendClockQueries() {
+        
+        synchronized(protocol) {
+            
+            clockSyncTime = SystemClock.uptimeMillis();
+            
+            protocol.addClockQuery(ClockSync.toTime(clockSyncTime));
+            sendFrame();
+            
+            for(FleetRoster.Member member : fleet.getMembers())
+            {
+                protocol.addClockQuery(ClockSync.toTime(SystemClock.uptimeMillis()));
+                sendFrameTo(member.address);
+            }
+        }
+    }
+    
+    /**
+     * Record a clock reply and set the robot's offset from the best reply
+     * so far. Called on the app thread.
+     * 
+     * @param address - robot the reply came from
+     * @param member - its fleet entry, null if it is not in the fleet
+     * @param times - phone and robot times in the reply
+     * @param now - time the reply arrived, ms
+     */
+    void onClockReply(InetAddress address, FleetRoster.Member member, 
+                      long[] times, long now) {
+        
+        ClockSync sync = (member != null) ? member.clock : 
+                         address.equals(udp.remoteIp) ? clock : null;
+        
+        if(sync == null)
+        {
+            return;
+        }
+        
+        sync.onReply(times[0], times[1], ClockSync.toTime(now));
+        
+        if(sync.isSynced())
+        {
+            synchronized(protocol) {
+                protocol.addClockSet(sync.getOffset());
+                sendFrameTo(address);
+            }
+        }
+    }
+    
+    /**
+     * Set the delay between sending a timed frame and the robots running 
+     * it, longer rides out worse link jitter
+     * 
+     * @param delay - delay in ms
+     */
+    public void setScheduleDelay(long delay) {
+        
+        scheduleDelay = delay;
+    }
+    
+    /**
+     * Start or stop tracing the latency from a touch to the robot's motors,
+     * see LatencyTrace
+     * 
+     * @param enabled - true to stamp the button commands
+     */
+    public void setLatencyTracing(boolean enabled) {
+        
+        latency.setEnabled(enabled);
+    }
+    
+    /**
+     * Get the latency histograms
+     * 
+     * @return the trace
+     */
+    public LatencyTrace getLatencyTrace() {
+        
+        return latency;
+    }
+    
+    /**
+     * Start recording every frame sent, see SessionRecorder
+     */
+    public void startRecording() {
+        
+        recorder.start();
+    }
+    
+    /**
+     * Stop recording and write the session to a file
+     * 
+     * @param file - file to write
+     * @throws IOException if the file cannot be written
+     */
+    public void stopRecording(File file) throws IOException {
+        
+        recorder.stop(file);
+    }
+    
+    /**
+     * Play a recorded session back to the robot, see SessionPlayer. The 
+     * frames are renumbered in with the app's own, so the controls should
+     * be left alone while it plays.
+     * 
+     * @param file - file written by stopRecording
+     * @param speed - playback speed, 1 as recorded
+     * @param repeats - times to play the session through
+     * @throws IOException if the file cannot be read
+     */
+    public void playSession(File file, double speed, int repeats) throws IOException {
+        
+        player.stop();
+        player.load(file);
+        player.play(new SessionPlayer.Sender() {
+            
+            public void send(byte[] frame, int length, InetAddress address) {
+                
+                synchronized(protocol) {
+                    
+                    protocol.renumber(frame, length);
+                    lastSendTime = SystemClock.uptimeMillis();
+                    
+                    if(address != null)
+                    {
+                        udp.send(address, robotPort, frame, length);
+                    }
+                    else if(udp.send(frame, length) != 0)
+                    {
+                        link.onSend(frame[2] & 0xFF, lastSendTime);
+                    }
+                }
+            }
+        }, speed, repeats);
+    }
+    
+    /**
+     * Stop a session playing back
+     */
+    public void stopSession() {
+        
+        player.stop();
+    }
+    
+    /**
+     * Start a soak test, see SoakTest. The controls should be left alone 
+     * while it runs.
+     * 
+     * @param seed - seed of the command mix, the same seed sends the same
+     *               commands
+     * @param duration - length of the run in ms
+     * @param file - report to write
+     * @throws IOException if the report cannot be opened
+     */
+    public void startSoak(long seed, long duration, File file) throws IOException {
+        
+        soak.start(seed, duration, file);
+    }
+    
+    /**
+     * End a soak test early, the report is kept
+     */
+    public void stopSoak() {
+        
+        soak.stop();
+    }
+    
+    /**
+     * Start or stop the robot's counter snapshots
+     * 
+     * @param seconds - snapshot period, 0 stops
+     */
+    public void sendSoakPeriod(int seconds) {
+        
+        synchronized(protocol) {
+            protocol.addSoak(seconds);
+            sendFrame();
+        }
+    }
+    
+    /**
+     * Get the session player, for its timing summary
+     * 
+     * @return the player
+     */
+    public SessionPlayer getSessionPlayer() {
+        
+        return player;
+    }
+    
+    /**
+     * Get the fleet roster, members are added with their id and address
+     * 
+     * @return the roster
+     */
+    public FleetRoster getFleet() {
+        
+        return fleet;
+    }
+    
+    /**
+     * Announce this phone's address to the robot, whatever lease the robot 
+     * network gave it
+     */
+    public void sendDiscover() {
+        
+        synchronized(protocol) {
+            protocol.addDiscover();
+            sendFrame();
+        }
+    }
+    
+    /**
+     * Set the robot's telemetry sample period
+     * 
+     * @param period - sample period in ms, 0 to stop telemetry
+     */
+    public void sendTelemetryPeriod(int period) {
+        
+        synchronized(protocol) {
+            protocol.addTelemetryPeriod(period);
+            sendFrame();
+        }
+    }
+    
+    /**
+     * Set the robot's telemetry format, the decoder takes either
+     * 
+     * @param format - RobotProtocol.TELEMETRY_FULL or TELEMETRY_COMPACT
+     */
+    public void sendTelemetryFormat(int format) {
+        
+        synchronized(protocol) {
+            protocol.addTelemetryFormat(format);
+            sendFrame();
+        }
+    }
+    
+    /**
+     * Build the frame holding the commands added to the protocol and queue it
+     * for the robot. The caller must hold the protocol lock.
+     */
+    void sendFrame() {
+        
+        int length = protocol.buildFrame(txFrame);
+        
+        lastSendTime = SystemClock.uptimeMillis();
+        recorder.record(txFrame, length, null);
+        
+        if(udp.send(txFrame, length) != 0)
+        {
+            link.onSend(txFrame[2] & 0xFF, lastSendTime);
+        }
+    }
+    
+    /**
+     * Build the frame holding the commands added to the protocol and queue it
+     * for one robot. The caller must hold the protocol lock.
+     * 
+     * @param address - the robot's address
+     */
+    void sendFrameTo(InetAddress address) {
+        
+        int length = protocol.buildFrame(txFrame);
+        
+        recorder.record(txFrame, length, address);
+        udp.send(address, robotPort, txFrame, length);
+    }
+    
+    /**
+     * Set the listener for telemetry from the robot
+     * 
+     * @param listener - the listener, null to stop listening
+     */
+    public void setTelemetryListener(TelemetryListener listener) {
+        
+        telemetryListener = listener;
+    }
+    
+    /**
+     * Set the listener for the robot network connection. A listener set 
+     * while connected hears about it straight away.
+     * 
+     * @param listener - the listener, null to stop listening
+     */
+    public void setConnectionListener(WifiMonitor.Listener listener) {
+        
+        connectionListener = listener;
+        
+        if(listener != null && isRobotConnected())
+        {
+            listener.onConnectionChanged(true);
+        }
+    }
+    
+    /**
+     * Set the listener for the link quality
+     * 
+     * @param listener - the listener, null to stop listening
+     */
+    public void setLinkListener(LinkListener listener) {
+        
+        linkListener = listener;
+    }
+    
+    /**
+     * Check if the robot communication interface is currently connected.
+     * 
+     * @return true if robot interface is connected, false otherwise
+     */
+    public boolean isRobotConnected() {
+        
+        boolean isConnected = false;
+        
+        if(wifi != null)
+        {
+            isConnected = wifi.isConnected();
+        }
+        
+        return isConnected;
+    }
+}
+
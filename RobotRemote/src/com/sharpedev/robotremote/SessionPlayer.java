@@ -0,0 +1,367 @@
+/******************************************************************************
+ * NAME: SessionPlayer
+ *
+ * DESCRIPTION:
+ *   Plays a session written by SessionRecorder back to the robot with the
+ *   timing it was recorded with, or scaled by a speed factor, to reproduce
+ *   a field problem or as a repeatable load and latency benchmark.
+ *
+ *   Frames go out from a thread of their own at audio priority. It parks
+ *   until SPIN_TIME before a frame is due and spins on the monotonic clock
+ *   for the rest, parking alone being good to a millisecond or two at best.
+ *   How late each frame went out is kept so the timing can be checked.
+ *
+ *   The robot only takes frames newer than the last it accepted, so each
+ *   frame is given the app's next sequence number as it goes out. Times in
+ *   setpoints, timed commands and stamps are moved by the time between the
+ *   recording and the playback starting, and with the frames when the 
+ *   speed is changed, so they stay as far from the send time. Frames with
+ *   clock commands are skipped, the app keeps the clock synced itself.
+ *****************************************************************************/
+package com.sharpedev.robotremote;
+
+import java.io.DataInputStream;
+import java.io.File;
+import java.io.FileInputStream;
+import java.io.IOException;
+import java.net.InetAddress;
+import java.util.ArrayList;
+import java.util.concurrent.locks.LockSupport;
+
+import android.os.SystemClock;
+import android.util.Log;
+
+public class SessionPlayer {
+
+    /**
+     * Sends the frames being played, called on the playback thread
+     */
+    public interface Sender {
+        /**
+         * Renumber and send a frame
+         *
+         * @param frame - the frame, its sequence number and CRC may be
+         *                rewritten
+         * @param length - frame length in bytes
+         * @param address - address to send to, null for the robot being
+         *                  driven
+         */
+        void send(byte[] frame, int length, InetAddress address);
+    }
+
+    static final long SPIN_TIME = 2000000; //ns
+    static final long LATE      = 1000000; //ns, a frame this late is counted
+
+    /**
+     * A recorded frame
+     */
+    static class Record {
+        long        time;    //ns from the start of the recording
+        InetAddress address; //null for the robot being driven
+        byte[]      frame;
+    }
+
+    final ArrayList<Record> records = new ArrayList<Record>();
+    long          startTime = 0; //uptime the recording started, ms
+    Thread        thread    = null;
+    volatile boolean playing = false;
+
+    //Timing of the frames sent since play was called
+    int  sent     = 0;
+    int  late     = 0;
+    long lateSum  = 0; //ns
+    long lateMax  = 0; //ns
+
+    /**
+     * Load a session file
+     *
+     * @param file - file written by SessionRecorder
+     * @throws IOException if the file cannot be read or is not a session
+     */
+    public synchronized void load(File file) throws IOException {
+
+        DataInputStream in = new DataInputStream(new FileInputStream(file));
+
+        try {
+
+            byte[] magic = new byte[SessionRecorder.MAGIC.length];
+            long   time  = 0;
+
+            in.readFully(magic);
+
+            for(int i = 0; i < magic.length; i++)
+            {
+                if(magic[i] != SessionRecorder.MAGIC[i])
+                {
+                    throw new IOException("Not a session file");
+                }
+            }
+
+            startTime = in.readLong();
+            records.clear();
+
+            while(in.available() > 0)
+            {
+                Record record = new Record();
+
+                time += getVarint(in);
+                record.time = time;
+
+                if(in.readUnsignedByte() == SessionRecorder.DEST_ADDR)
+                {
+                    byte[] address = new byte[4];
+
+                    in.readFully(address);
+                    record.address = InetAddress.getByAddress(address);
+                }
+
+                record.frame = new byte[in.readUnsignedByte()];
+                in.readFully(record.frame);
+                records.add(record);
+            }
+        }
+        finally {
+
+            in.close();
+        }
+    }
+
+    /**
+     * Start playing the loaded session, stopping any playback in progress
+     *
+     * @param sender - sends the frames
+     * @param speed - playback speed, 1 as recorded, 2 twice as fast
+     * @param repeats - times to play the session through
+     */
+    public void play(final Sender sender, final double speed, final int repeats) {
+
+        stop();
+
+        synchronized(this) {
+            sent    = 0;
+            late    = 0;
+            lateSum = 0;
+            lateMax = 0;
+            playing = true;
+        }
+
+        Thread player = new Thread() {
+            @Override
+            public void run() {
+
+                android.os.Process.setThreadPriority(
+                        android.os.Process.THREAD_PRIORITY_URGENT_AUDIO);
+
+                for(int pass = 0; pass < repeats && playing; pass++)
+                {
+                    playOnce(sender, speed);
+                }
+
+                playing = false;
+                Log.i("RobotRemote", "Playback done, " + getSummary());
+            }
+        };
+
+        synchronized(this) {
+            thread = player;
+        }
+
+        player.start();
+    }
+
+    /**
+     * Stop the playback, waiting for the playback thread to finish. The lock
+     * is not held while waiting, the thread takes it to record its timing.
+     */
+    public void stop() {
+
+        Thread player = null;
+
+        synchronized(this) {
+            playing = false;
+            player  = thread;
+            thread  = null;
+        }
+
+        if(player != null)
+        {
+            player.interrupt();
+
+            try {
+
+                player.join();
+            }
+            catch (InterruptedException e) {
+
+                Thread.currentThread().interrupt();
+            }
+        }
+    }
+
+    /**
+     * Check if a session is playing
+     *
+     * @return true until the last pass has been played or stop is called
+     */
+    public boolean isPlaying() {
+
+        return playing;
+    }
+
+    /**
+     * Play the session through once, called on the playback thread
+     *
+     * @param sender - sends the frames
+     * @param speed - playback speed
+     */
+    void playOnce(Sender sender, double speed) {
+
+        long start = System.nanoTime();
+        long shift = SystemClock.uptimeMillis() - startTime;
+        byte[] frame = new byte[RobotProtocol.MAX_FRAME];
+
+        for(Record record : records)
+        {
+            long due = start + (long) (record.time / speed);
+
+            //Park for most of the wait, then spin for the last of it
+            for(long wait = due - System.nanoTime(); wait > 0 && playing;
+                wait = due - System.nanoTime())
+            {
+                if(wait > SPIN_TIME)
+                {
+                    LockSupport.parkNanos(wait - SPIN_TIME);
+                }
+            }
+
+            if(!playing)
+            {
+                return;
+            }
+
+            int length = record.frame.length;
+
+            System.arraycopy(record.frame, 0, frame, 0, length);
+
+            //The phone times in the frame move with the frame
+            if(!shiftTimes(frame, length, shift + (long) (record.time / 1000000 *
+                           (1 / speed - 1))))
+            {
+                continue;
+            }
+
+            sender.send(frame, length, record.address);
+            recordTiming(System.nanoTime() - due);
+        }
+    }
+
+    /**
+     * Move the phone times in a frame's commands, frames the robot's clock
+     * commands are in are not to be sent
+     *
+     * @param frame - the frame
+     * @param length - frame length in bytes
+     * @param shift - time to add, ms
+     * @return false if the frame holds a clock command
+     */
+    static boolean shiftTimes(byte[] frame, int length, long shift) {
+
+        int end = Math.min(RobotProtocol.HEADER_SIZE + (frame[3] & 0xFF), length - 1);
+
+        for(int i = RobotProtocol.HEADER_SIZE; i + 2 <= end; )
+        {
+            int type        = frame[i] & 0xFF;
+            int valueLength = frame[i + 1] & 0xFF;
+
+            if(i + 2 + valueLength > end)
+            {
+                break;
+            }
+
+            switch(type)
+            {
+                case RobotProtocol.CMD_CLOCK:
+                    return false;
+
+                //Timed commands and setpoints start with the time, only the
+                //outer time of a timed command is moved
+                case RobotProtocol.CMD_AT:
+                case RobotProtocol.CMD_SETPOINT:
+                case RobotProtocol.CMD_STAMP:
+                    if(valueLength >= 4)
+                    {
+                        putLong(frame, i + 2, RobotProtocol.getLong(frame, i + 2) + shift);
+                    }
+                    break;
+
+                default:
+                    break;
+            }
+
+            i += 2 + valueLength;
+        }
+
+        return true;
+    }
+
+    /**
+     * Write a 32-bit value, LSB first
+     */
+    static void putLong(byte[] data, int offset, long value) {
+
+        data[offset]     = (byte) value;
+        data[offset + 1] = (byte) (value >> 8);
+        data[offset + 2] = (byte) (value >> 16);
+        data[offset + 3] = (byte) (value >> 24);
+    }
+
+    /**
+     * Read an unsigned LEB128 varint
+     */
+    static long getVarint(DataInputStream in) throws IOException {
+
+        long value = 0;
+        int  shift = 0;
+        int  next  = 0;
+
+        do
+        {
+            next   = in.readUnsignedByte();
+            value |= (long) (next & 0x7F) << shift;
+            shift += 7;
+        }
+        while((next & 0x80) != 0);
+
+        return value;
+    }
+
+    /**
+     * Record how late a frame went out
+     *
+     * @param lateness - send time less the due time, ns
+     */
+    synchronized void recordTiming(long lateness) {
+
+        sent++;
+        lateSum += lateness;
+        lateMax  = Math.max(lateMax, lateness);
+
+        if(lateness >= LATE)
+        {
+            late++;
+        }
+    }
+
+    /**
+     * Get the timing of the frames sent since play was called
+     *
+     * @return the frame count, mean and worst lateness and the number late
+     *         by a millisecond or more
+     */
+    public synchronized String getSummary() {
+
+        return String.format("%d frames, mean %.1f us, max %.1f us late, %d over 1ms",
+                             sent, (sent == 0) ? 0.0 : lateSum / (sent * 1000.0),
+                             lateMax / 1000.0, late);
+    }
+}
@@ -0,0 +1,155 @@
+/******************************************************************************
+ * NAME: SessionRecorder
+ *
+ * DESCRIPTION:
+ *   Records every frame sent to the robots with the monotonic time it was
+ *   sent, so a session can be played back to the firmware the same way
+ *   again, see SessionPlayer. Records are kept in memory while recording, a
+ *   frame is tens of bytes so an hour of driving is a few MB, and written
+ *   out when recording stops so no file I/O lands on the send path.
+ *
+ *   File layout, multi-byte values big-endian:
+ *     [0..3]    magic "RRS" and format version 1
+ *     [4..11]   phone uptime when recording started, ms. Frame times
+ *               taken from it are moved to the playback time.
+ *     then one record per frame:
+ *       time    ns since the previous record, or since the start for the
+ *               first, unsigned LEB128 varint
+ *       dest    0 for the robot being driven, 1 for an IPv4 address that
+ *               follows in 4 bytes, such as the fleet broadcast
+ *       length  frame length in bytes
+ *       frame   the frame as sent
+ *****************************************************************************/
+package com.sharpedev.robotremote;
+
+import java.io.ByteArrayOutputStream;
+import java.io.File;
+import java.io.FileOutputStream;
+import java.io.IOException;
+import java.net.InetAddress;
+
+import android.os.SystemClock;
+
+public class SessionRecorder {
+
+    static final byte[] MAGIC     = { 'R', 'R', 'S', 1 };
+    static final int    DEST_LINK = 0;
+    static final int    DEST_ADDR = 1;
+
+    ByteArrayOutputStream records   = new ByteArrayOutputStream();
+    boolean               recording = false;
+    long                  startTime = 0; //uptime, ms
+    long                  lastNanos = 0;
+    int                   count     = 0;
+
+    /**
+     * Start a new recording, any frames recorded before are dropped
+     */
+    public synchronized void start() {
+
+        records.reset();
+        startTime = SystemClock.uptimeMillis();
+        lastNanos = System.nanoTime();
+        count     = 0;
+        recording = true;
+    }
+
+    /**
+     * Check if frames are being recorded
+     *
+     * @return true while recording
+     */
+    public synchronized boolean isRecording() {
+
+        return recording;
+    }
+
+    /**
+     * Get the number of frames recorded
+     *
+     * @return frame count
+     */
+    public synchronized int getCount() {
+
+        return count;
+    }
+
+    /**
+     * Record a frame being sent, nothing is done unless recording
+     *
+     * @param frame - the frame
+     * @param length - frame length in bytes
+     * @param address - address the frame was sent to, null for the robot
+     *                  being driven
+     */
+    public synchronized void record(byte[] frame, int length, InetAddress address) {
+
+        if(!recording)
+        {
+            return;
+        }
+
+        long now = System.nanoTime();
+
+        putVarint(now - lastNanos);
+        lastNanos = now;
+
+        if(address == null)
+        {
+            records.write(DEST_LINK);
+        }
+        else
+        {
+            records.write(DEST_ADDR);
+            records.write(address.getAddress(), 0, 4);
+        }
+
+        records.write(length);
+        records.write(frame, 0, length);
+        count++;
+    }
+
+    /**
+     * Stop recording and write the session to a file
+     *
+     * @param file - file to write, replaced if it exists
+     * @throws IOException if the file cannot be written
+     */
+    public synchronized void stop(File file) throws IOException {
+
+        recording = false;
+
+        FileOutputStream out = new FileOutputStream(file);
+
+        try {
+
+            out.write(MAGIC);
+
+            for(int i = 56; i >= 0; i -= 8)
+            {
+                out.write((int) (startTime >> i));
+            }
+
+            records.writeTo(out);
+        }
+        finally {
+
+            out.close();
+        }
+    }
+
+    /**
+     * Add an unsigned LEB128 varint, 7 bits per byte with the top bit set on
+     * all but the last
+     */
+    void putVarint(long value) {
+
+        while((value & ~0x7FL) != 0)
+        {
+            records.write((int) ((value & 0x7F) | 0x80));
+            value >>>= 7;
+        }
+
+        records.write((int) value);
+    }
+}
@@ -0,0 +1,379 @@
+/******************************************************************************
+ * NAME: SoakTest
+ *
+ * DESCRIPTION:
+ *   Drives the robot with a random mix of control commands for hours to
+ *   bring out the faults that only show after a long run: a parser that
+ *   loses sync, a FIFO that overruns, a module that wedges, a buffer that
+ *   leaks. The mix comes from a seeded generator, so a run with the same
+ *   seed sends the same commands in the same order.
+ *
+ *   The robot is asked to snapshot its counters every SNAPSHOT_PERIOD, see
+ *   RobotProtocol.parseSoak. Every REPORT_INTERVAL a line goes to the
+ *   report, a CSV file with one column per figure:
+ *
+ *     minutes               since the start
+ *     sent, received        control frames sent, datagrams the robot got
+ *     rtt p50, p95, p99,    acknowledgement round trip times, ms
+ *     max
+ *     loss                  smoothed frame loss, percent
+ *     then the growth of each robot counter over the interval, then the
+ *     stack peak and transmit pool blocks as they stand, the restarts
+ *     seen and the snapshots that never arrived
+ *
+ *   The lines are flushed as they are written, a run that ends badly
+ *   leaves its report up to the last interval.
+ *****************************************************************************/
+package com.sharpedev.robotremote;
+
+import android.os.Handler;
+import android.os.HandlerThread;
+import android.os.SystemClock;
+import android.util.Log;
+
+import java.io.File;
+import java.io.FileWriter;
+import java.io.IOException;
+import java.io.PrintWriter;
+import java.util.Arrays;
+import java.util.Random;
+
+public class SoakTest {
+
+    //Tag for the thread and the log
+    private final String TAG = this.getClass().getSimpleName();
+
+    static final long COMMAND_INTERVAL = 50;    //ms between commands
+    static final long REPORT_INTERVAL  = 60000; //ms between report lines
+    static final int  SNAPSHOT_PERIOD  = 10;    //s between robot snapshots
+    static final int  RTT_MAX_SAMPLES  = 4096;  //per interval, later ones dropped
+
+    //A robot that restarted has stopped its snapshots, they are asked for
+    //again after this many periods without one
+    static final int  SNAPSHOT_LOST    = 3;
+
+    //Robot counters, indexes of a snapshot past the uptime, see Soak.h
+    static final int SNAPSHOT       = 1;
+    static final int RX_PACKETS     = 2;
+    static final int FIRST_COUNTER  = 2;
+    static final int LAST_COUNTER   = 16; //failsafe trips, the last that only grows
+    static final int STACK_PEAK     = 17;
+    static final int POOL_PEAK      = 19;
+
+    static final String HEADER =
+        "minutes,sent,received,rtt p50,rtt p95,rtt p99,rtt max,loss," +
+        "rx packets,rx dropped,rx oversize,tx failed,module busy," +
+        "module recoveries,frames rejected,commands recovered,uart overrun," +
+        "uart noise,uart framing,uart ring full,drive overruns," +
+        "overcurrent trips,failsafe trips,stack peak,pool used,pool peak," +
+        "restarts,snapshots missed";
+
+    static final Directions[] DIRECTIONS = { Directions.FORWARD,
+        Directions.BACKWARD, Directions.LEFT, Directions.RIGHT };
+
+    RobotRemoteApp app         = null;
+    HandlerThread  soakThread  = null;
+    Handler        handler     = null;
+    Random         random      = null;
+    PrintWriter    report      = null;
+    volatile boolean running   = false;
+    long           startTime   = 0;
+    long           endTime     = 0;
+    long           reportTime  = 0;
+
+    //Interval being measured
+    int            sent        = 0;
+    int[]          rtts        = new int[RTT_MAX_SAMPLES];
+    int            rttCount    = 0;
+
+    //Snapshots, the last one of the interval before and the newest
+    long[]         baseline    = null;
+    long[]         snapshot    = null;
+    long           snapshotTime = 0;
+    int            restarts    = 0;
+    int            missed      = 0;
+
+    //Sends the next command of the mix, ends the run when it is over
+    Runnable commandTask = new Runnable() {
+        public void run() {
+
+            if(!running)
+            {
+                return;
+            }
+
+            long now = SystemClock.uptimeMillis();
+
+            sendCommand();
+
+            synchronized(SoakTest.this) {
+                if(now - snapshotTime > SNAPSHOT_LOST * SNAPSHOT_PERIOD * 1000L)
+                {
+                    snapshotTime = now;
+                    app.sendSoakPeriod(SNAPSHOT_PERIOD);
+                }
+            }
+
+            if(now - reportTime >= REPORT_INTERVAL)
+            {
+                reportTime += REPORT_INTERVAL;
+                writeLine(now);
+            }
+
+            if(now >= endTime)
+            {
+                finish();
+                return;
+            }
+
+            handler.postDelayed(this, COMMAND_INTERVAL);
+        }
+    };
+
+
+    /**
+     * Class Constructor
+     *
+     * @param app - application that sends the commands
+     */
+    public SoakTest(RobotRemoteApp app) {
+
+        this.app = app;
+    }
+
+    /**
+     * Start a run, any run in progress is ended first
+     *
+     * @param seed - seed of the command mix
+     * @param duration - length of the run in ms
+     * @param file - report to write
+     * @throws IOException if the report cannot be opened
+     */
+    public synchronized void start(long seed, long duration, File file)
+            throws IOException {
+
+        stop();
+
+        report = new PrintWriter(new FileWriter(file));
+        report.println(HEADER);
+        report.flush();
+
+        random     = new Random(seed);
+        startTime  = SystemClock.uptimeMillis();
+        endTime    = startTime + duration;
+        reportTime = startTime;
+        sent       = 0;
+        rttCount   = 0;
+        baseline   = null;
+        snapshot   = null;
+        restarts   = 0;
+        missed     = 0;
+        running    = true;
+        snapshotTime = startTime;
+
+        Log.i(TAG, "Soak test seed " + seed + " for " + (duration / 60000) + " minutes");
+
+        app.sendSoakPeriod(SNAPSHOT_PERIOD);
+
+        soakThread = new HandlerThread(TAG);
+        soakThread.start();
+        handler = new Handler(soakThread.getLooper());
+        handler.post(commandTask);
+    }
+
+    /**
+     * End the run early, the report is written up to the last interval
+     */
+    public synchronized void stop() {
+
+        if(running)
+        {
+            handler.removeCallbacks(commandTask);
+        }
+
+        finish();
+    }
+
+    /**
+     * Check if a run is in progress
+     *
+     * @return true while running
+     */
+    public boolean isRunning() {
+
+        return running;
+    }
+
+    /**
+     * Take the round trip time of an acknowledged frame, called on the app
+     * thread
+     *
+     * @param rtt - round trip time in ms
+     */
+    public synchronized void onRtt(long rtt) {
+
+        if(running && rttCount < RTT_MAX_SAMPLES)
+        {
+            rtts[rttCount++] = (int)rtt;
+        }
+    }
+
+    /**
+     * Take a counter snapshot from the robot, called on the app thread
+     *
+     * @param soak - snapshot from RobotProtocol.parseSoak
+     */
+    public synchronized void onSnapshot(long[] soak) {
+
+        if(!running)
+        {
+            return;
+        }
+
+        if(snapshot != null && soak[0] < snapshot[0])
+        {
+            //The robot restarted, its counters started again from zero
+            restarts++;
+            baseline = new long[soak.length];
+        }
+        else if(snapshot != null && soak[SNAPSHOT] > snapshot[SNAPSHOT] + 1)
+        {
+            missed += (int)(soak[SNAPSHOT] - snapshot[SNAPSHOT] - 1);
+        }
+
+        if(baseline == null)
+        {
+            baseline = soak;
+        }
+
+        snapshot = soak;
+        snapshotTime = SystemClock.uptimeMillis();
+    }
+
+    /**
+     * Send the next command of the mix. Arcs and wheel speeds make up most
+     * of it, with drive commands, stops and keepalives in between.
+     */
+    void sendCommand() {
+
+        int pick = random.nextInt(100);
+
+        if(pick < 35)
+        {
+            app.sendTwist(random.nextInt(201) - 100, random.nextInt(201) - 100);
+        }
+        else if(pick < 55)
+        {
+            app.sendWheels(random.nextInt(201) - 100, random.nextInt(201) - 100);
+        }
+        else if(pick < 70)
+        {
+            app.sendCommand(DIRECTIONS[random.nextInt(DIRECTIONS.length)],
+                            random.nextInt(101));
+        }
+        else if(pick < 80)
+        {
+            app.stopWheels();
+        }
+        else
+        {
+            app.sendKeepalive();
+        }
+
+        synchronized(this) {
+            sent++;
+        }
+    }
+
+    /**
+     * Write the line of the interval just ended and start the next
+     *
+     * @param now - time in ms
+     */
+    synchronized void writeLine(long now) {
+
+        StringBuilder line = new StringBuilder();
+        int[] sorted = new int[rttCount];
+        long received = 0;
+
+        System.arraycopy(rtts, 0, sorted, 0, rttCount);
+        Arrays.sort(sorted);
+
+        if(snapshot != null)
+        {
+            received = snapshot[RX_PACKETS] - baseline[RX_PACKETS];
+        }
+
+        line.append((now - startTime) / 60000).append(',');
+        line.append(sent).append(',').append(received).append(',');
+        line.append(percentile(sorted, 50)).append(',');
+        line.append(percentile(sorted, 95)).append(',');
+        line.append(percentile(sorted, 99)).append(',');
+        line.append(percentile(sorted, 100)).append(',');
+        line.append(Math.round(app.link.getQuality(0).loss * 100)).append(',');
+
+        for(int i = FIRST_COUNTER; i <= LAST_COUNTER; i++)
+        {
+            line.append((snapshot != null) ? snapshot[i] - baseline[i] : 0);
+            line.append(',');
+        }
+
+        for(int i = STACK_PEAK; i <= POOL_PEAK; i++)
+        {
+            line.append((snapshot != null) ? snapshot[i] : 0).append(',');
+        }
+
+        line.append(restarts).append(',').append(missed);
+
+        report.println(line);
+        report.flush();
+
+        sent     = 0;
+        rttCount = 0;
+        baseline = snapshot;
+    }
+
+    /**
+     * Get a percentile of sorted samples
+     *
+     * @param sorted - samples, ascending
+     * @param percent - 1 to 100
+     * @return the sample, 0 if there are none
+     */
+    static int percentile(int[] sorted, int percent) {
+
+        if(sorted.length == 0)
+        {
+            return 0;
+        }
+
+        int index = (sorted.length * percent + 99) / 100 - 1;
+
+        return sorted[Math.max(0, Math.min(sorted.length - 1, index))];
+    }
+
+    /**
+     * Stop the robot and the snapshots, write the last partial interval
+     * and close the report
+     */
+    synchronized void finish() {
+
+        if(!running)
+        {
+            return;
+        }
+
+        running = false;
+        app.stopWheels();
+        app.sendSoakPeriod(0);
+
+        if(SystemClock.uptimeMillis() > reportTime)
+        {
+            writeLine(SystemClock.uptimeMillis());
+        }
+
+        report.close();
+        soakThread.quit();
+        Log.i(TAG, "Soak test done, " + restarts + " restarts");
+    }
+}
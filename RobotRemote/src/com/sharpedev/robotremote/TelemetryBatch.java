@@ -0,0 +1,110 @@
+/******************************************************************************
+ * NAME: TelemetryBatch
+ *
+ * DESCRIPTION:
+ *   A batch of telemetry samples sent by the robot in one telemetry command.
+ *   Must match Telemetry.h in the robot firmware.
+ *
+ *   Command value layout, 16-bit values LSB first:
+ *     [0]       sample period, 10ms units
+ *     [1]       number of samples
+ *     [2]       samples dropped by the robot since the last batch
+ *     [3]       drive update overruns, low byte
+ *     [4..5]    lowest battery voltage since the last batch, mV
+ *     [6..7]    nearest obstacle ahead since the last batch, mm, 0xFFFF
+ *               when nothing was in range
+ *     [8..]     samples, oldest first, each holding the battery voltage in
+ *               mV, the left and right motor currents in mA and the left
+ *               and right duty in percent (signed)
+ *****************************************************************************/
+package com.sharpedev.robotremote;
+
+public class TelemetryBatch {
+
+    static final int HEADER_SIZE = 8;
+    static final int SAMPLE_SIZE = 8;
+    static final int RANGE_CLEAR = 0xFFFF;
+
+    /**
+     * One telemetry sample
+     */
+    public static class Sample {
+        public int battery;      //mV
+        public int leftCurrent;  //mA
+        public int rightCurrent; //mA
+        public int leftDuty;     //percent, negative is backward
+        public int rightDuty;    //percent, negative is backward
+    }
+
+    public int      period     = 0; //ms between samples
+    public int      dropped    = 0;
+    public int      overruns   = 0;
+    public int      batteryMin = 0; //mV
+    public int      rangeMin   = RANGE_CLEAR; //mm
+    public Sample[] samples    = new Sample[0];
+
+    /**
+     * Decode a telemetry command value
+     *
+     * @param data - buffer holding the value
+     * @param offset - first byte of the value
+     * @param length - value length in bytes
+     * @return the batch, null if the value is malformed
+     */
+    public static TelemetryBatch decode(byte[] data, int offset, int length) {
+
+        if(length < HEADER_SIZE)
+        {
+            return null;
+        }
+
+        int count = data[offset + 1] & 0xFF;
+
+        if(length < HEADER_SIZE + count * SAMPLE_SIZE)
+        {
+            return null;
+        }
+
+        TelemetryBatch batch = new TelemetryBatch();
+
+        batch.period     = (data[offset] & 0xFF) * 10;
+        batch.dropped    = data[offset + 2] & 0xFF;
+        batch.overruns   = data[offset + 3] & 0xFF;
+        batch.batteryMin = getShort(data, offset + 4);
+        batch.rangeMin   = getShort(data, offset + 6);
+        batch.samples    = new Sample[count];
+
+        for(int i = 0; i < count; i++)
+        {
+            int    index  = offset + HEADER_SIZE + i * SAMPLE_SIZE;
+            Sample sample = new Sample();
+
+            sample.battery      = getShort(data, index);
+            sample.leftCurrent  = getShort(data, index + 2);
+            sample.rightCurrent = getShort(data, index + 4);
+            sample.leftDuty     = data[index + 6];
+            sample.rightDuty    = data[index + 7];
+            batch.samples[i]    = sample;
+        }
+
+        return batch;
+    }
+
+    /**
+     * Get the newest sample in the batch
+     *
+     * @return the sample, null if the batch is empty
+     */
+    public Sample getLatest() {
+
+        return (samples.length > 0) ? samples[samples.length - 1] : null;
+    }
+
+    /**
+     * Read an unsigned 16-bit LSB first value
+     */
+    static int getShort(byte[] data, int index) {
+
+        return (data[index] & 0xFF) | ((data[index + 1] & 0xFF) << 8);
+    }
+}
@@ -0,0 +1,286 @@
+/******************************************************************************
+ * NAME: TelemetryDashboard
+ *
+ * DESCRIPTION:
+ *   Turns the telemetry and link reports into chart frames for the display.
+ *   The app thread hands each decoded batch and link report over to the
+ *   dashboard thread, which folds them into the point of the current frame:
+ *   the mean duty of each wheel and the lowest battery voltage of the
+ *   samples, the newest round trip time and loss. Once per FRAME_INTERVAL
+ *   the point is added to the history and the frame published, at most one
+ *   frame is out at a time so a busy UI thread is never queued more than
+ *   one message however fast the telemetry comes in. A frame that is still
+ *   out when the next is due is skipped, its point still goes in the
+ *   history.
+ *****************************************************************************/
+package com.sharpedev.robotremote;
+
+import android.os.Handler;
+import android.os.HandlerThread;
+import android.os.SystemClock;
+
+import java.util.Arrays;
+
+public class TelemetryDashboard implements RobotRemoteApp.TelemetryListener,
+                                           RobotRemoteApp.LinkListener {
+
+    //Tag for the thread
+    private final String TAG = this.getClass().getSimpleName();
+
+    static final long FRAME_INTERVAL = 33;  //ms, the display frame rate
+    static final int  HISTORY        = 150; //points, 5s of frames
+
+    //Chart series, points oldest first
+    static final int SERIES_LEFT_DUTY  = 0; //percent
+    static final int SERIES_RIGHT_DUTY = 1; //percent
+    static final int SERIES_BATTERY    = 2; //V
+    static final int SERIES_RTT        = 3; //ms
+    static final int SERIES_LOSS       = 4; //percent
+    static final int SERIES_COUNT      = 5;
+
+    /**
+     * Receives the frames, called on the dashboard thread. The frame must
+     * be handed back with release once shown.
+     */
+    public interface Listener {
+        void onFrame(Frame frame);
+    }
+
+    /**
+     * One frame of the dashboard. Points are Float.NaN until there is data
+     * for them.
+     */
+    public static class Frame {
+        public TelemetryBatch      batch   = null; //newest batch, null if none
+        public LinkMonitor.Quality quality = null; //newest report, null if none
+        public float[][]           series  = new float[SERIES_COUNT][HISTORY];
+    }
+
+    HandlerThread     dashboardThread = null;
+    Handler           handler         = null;
+    volatile Listener listener        = null;
+
+    //History, a ring per series with the oldest point at next
+    float[][] history = new float[SERIES_COUNT][HISTORY];
+    int       next    = 0;
+
+    //Point of the frame being built
+    float     leftSum    = 0;
+    float     rightSum   = 0;
+    int       samples    = 0;
+    float     batteryMin = Float.NaN;
+    float     rtt        = Float.NaN;
+    float     loss       = Float.NaN;
+    long      lastData   = 0;
+
+    //Only one frame is lent to the UI thread at a time
+    Frame               frame    = new Frame();
+    TelemetryBatch      batch    = null;
+    LinkMonitor.Quality quality  = null;
+    volatile boolean    frameOut = false;
+    boolean             running  = false;
+
+    //Adds the point of the frame just ended and publishes it
+    Runnable frameTask = new Runnable() {
+        public void run() {
+
+            if(running)
+            {
+                endFrame(SystemClock.uptimeMillis());
+                handler.postDelayed(this, FRAME_INTERVAL);
+            }
+        }
+    };
+
+
+    /**
+     * Class Constructor, starts the dashboard thread
+     */
+    public TelemetryDashboard() {
+
+        for(int i = 0; i < SERIES_COUNT; i++)
+        {
+            Arrays.fill(history[i], Float.NaN);
+        }
+
+        dashboardThread = new HandlerThread(TAG);
+        dashboardThread.start();
+        handler = new Handler(dashboardThread.getLooper());
+    }
+
+    /**
+     * Set the listener for the frames
+     *
+     * @param listener - the listener, null to stop listening
+     */
+    public void setListener(Listener listener) {
+
+        this.listener = listener;
+    }
+
+    /**
+     * Start publishing frames
+     */
+    public void start() {
+
+        handler.post(new Runnable() {
+            public void run() {
+
+                if(!running)
+                {
+                    running = true;
+                    handler.postDelayed(frameTask, FRAME_INTERVAL);
+                }
+            }
+        });
+    }
+
+    /**
+     * Stop publishing frames, the history is kept
+     */
+    public void stop() {
+
+        handler.post(new Runnable() {
+            public void run() {
+
+                running = false;
+                handler.removeCallbacks(frameTask);
+            }
+        });
+    }
+
+    /**
+     * Stop the dashboard thread, the dashboard cannot be used after
+     */
+    public void quit() {
+
+        stop();
+        dashboardThread.quit();
+    }
+
+    /**
+     * Hand back the frame last published, call on the UI thread once it is
+     * shown
+     */
+    public void release() {
+
+        frameOut = false;
+    }
+
+    /**
+     * Take a batch of telemetry, called on the app thread
+     *
+     * @see RobotRemoteApp.TelemetryListener#onTelemetry(TelemetryBatch)
+     */
+    public void onTelemetry(final TelemetryBatch batch) {
+
+        handler.post(new Runnable() {
+            public void run() {
+
+                addBatch(batch);
+            }
+        });
+    }
+
+    /**
+     * Take a link report, called on the app thread
+     *
+     * @see RobotRemoteApp.LinkListener#onLinkQuality(LinkMonitor.Quality)
+     */
+    public void onLinkQuality(final LinkMonitor.Quality quality) {
+
+        handler.post(new Runnable() {
+            public void run() {
+
+                TelemetryDashboard.this.quality = quality;
+                rtt  = (quality.rtt > 0) ? quality.rtt : Float.NaN;
+                loss = quality.loss * 100;
+                lastData = SystemClock.uptimeMillis();
+            }
+        });
+    }
+
+    /**
+     * Fold a batch into the point of the frame being built
+     *
+     * @param batch - telemetry received from the robot
+     */
+    void addBatch(TelemetryBatch batch) {
+
+        for(int i = 0; i < batch.samples.length; i++)
+        {
+            TelemetryBatch.Sample sample = batch.samples[i];
+            float battery = sample.battery / 1000f;
+
+            leftSum  += sample.leftDuty;
+            rightSum += sample.rightDuty;
+            samples++;
+
+            if(Float.isNaN(batteryMin) || battery < batteryMin)
+            {
+                batteryMin = battery;
+            }
+        }
+
+        this.batch = batch;
+        lastData = SystemClock.uptimeMillis();
+    }
+
+    /**
+     * Add the point of the frame just ended to the history and publish the
+     * frame. Nothing moves once there has been no data for a whole history,
+     * frames in between hold the last point of each series.
+     *
+     * @param now - time in ms
+     */
+    void endFrame(long now) {
+
+        if(lastData == 0 || now - lastData > HISTORY * FRAME_INTERVAL)
+        {
+            return;
+        }
+
+        int last = (next + HISTORY - 1) % HISTORY;
+
+        if(samples > 0)
+        {
+            history[SERIES_LEFT_DUTY][next]  = leftSum / samples;
+            history[SERIES_RIGHT_DUTY][next] = rightSum / samples;
+            history[SERIES_BATTERY][next]    = batteryMin;
+        }
+        else
+        {
+            history[SERIES_LEFT_DUTY][next]  = history[SERIES_LEFT_DUTY][last];
+            history[SERIES_RIGHT_DUTY][next] = history[SERIES_RIGHT_DUTY][last];
+            history[SERIES_BATTERY][next]    = history[SERIES_BATTERY][last];
+        }
+
+        history[SERIES_RTT][next]  = rtt;
+        history[SERIES_LOSS][next] = loss;
+        next = (next + 1) % HISTORY;
+
+        leftSum    = 0;
+        rightSum   = 0;
+        samples    = 0;
+        batteryMin = Float.NaN;
+
+        Listener listener = this.listener;
+
+        if(listener == null || frameOut)
+        {
+            return;
+        }
+
+        //The UI thread has handed the frame back, fill it again
+        for(int i = 0; i < SERIES_COUNT; i++)
+        {
+            System.arraycopy(history[i], next, frame.series[i], 0, HISTORY - next);
+            System.arraycopy(history[i], 0, frame.series[i], HISTORY - next, next);
+        }
+
+        frame.batch   = batch;
+        frame.quality = quality;
+        frameOut = true;
+        listener.onFrame(frame);
+    }
+}
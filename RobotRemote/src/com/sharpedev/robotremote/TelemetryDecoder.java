@@ -0,0 +1,149 @@
+/******************************************************************************
+ * NAME: TelemetryDecoder
+ *
+ * DESCRIPTION:
+ *   Decodes the compact telemetry reports of one robot. Each sample comes
+ *   as the change from the one before it, so the decoder keeps the last
+ *   sample and the report count across reports. Must match Telemetry.h in
+ *   the robot firmware.
+ *
+ *   Command value layout, 16-bit values LSB first:
+ *     [0..7]    the TelemetryBatch header, the count being the samples
+ *               in this report
+ *     [8]       bit 7 set on a keyframe, bits 0 to 6 count the reports
+ *     [9..]     samples, oldest first, each a mask with bit n set for each
+ *               field that changed, battery, left current, right current,
+ *               left duty then right duty, followed by the change of each
+ *               as a zig-zag varint, 7 bits a byte LSB first with bit 7
+ *               set on all but the last. The first sample of a keyframe
+ *               is coded against zero.
+ *
+ *   When a report is lost the changes after it cannot be applied, the
+ *   reports up to the next keyframe are dropped. The robot sends one every
+ *   KEY_INTERVAL reports.
+ *****************************************************************************/
+package com.sharpedev.robotremote;
+
+public class TelemetryDecoder {
+
+    static final int KEY_SIZE     = 1;
+    static final int KEY_FLAG     = 0x80;
+    static final int COUNT_MASK   = 0x7F;
+    static final int KEY_INTERVAL = 8;
+    static final int FIELD_COUNT  = 5;
+
+    int[]   last    = new int[FIELD_COUNT];
+    int     next    = -1; //report count expected, -1 to wait for a keyframe
+    int     skipped = 0;
+
+    /**
+     * Forget the last sample, the next report used is a keyframe
+     */
+    public synchronized void reset() {
+
+        next = -1;
+    }
+
+    /**
+     * Get the number of reports dropped waiting for a keyframe
+     *
+     * @return report count
+     */
+    public synchronized int getSkipped() {
+
+        return skipped;
+    }
+
+    /**
+     * Decode a compact telemetry command value
+     *
+     * @param data - buffer holding the value
+     * @param offset - first byte of the value
+     * @param length - value length in bytes
+     * @return the batch, null if the value is malformed or follows a lost
+     *         report
+     */
+    public synchronized TelemetryBatch decode(byte[] data, int offset, int length) {
+
+        if(length < TelemetryBatch.HEADER_SIZE + KEY_SIZE)
+        {
+            return null;
+        }
+
+        int key   = data[offset + TelemetryBatch.HEADER_SIZE] & 0xFF;
+        int count = data[offset + 1] & 0xFF;
+        int end   = offset + length;
+        int index = offset + TelemetryBatch.HEADER_SIZE + KEY_SIZE;
+
+        if((key & KEY_FLAG) != 0)
+        {
+            last = new int[FIELD_COUNT];
+        }
+        else if((key & COUNT_MASK) != next)
+        {
+            next = -1;
+            skipped++;
+            return null;
+        }
+
+        TelemetryBatch batch = new TelemetryBatch();
+
+        batch.period     = (data[offset] & 0xFF) * 10;
+        batch.dropped    = data[offset + 2] & 0xFF;
+        batch.overruns   = data[offset + 3] & 0xFF;
+        batch.batteryMin = TelemetryBatch.getShort(data, offset + 4);
+        batch.rangeMin   = TelemetryBatch.getShort(data, offset + 6);
+        batch.samples    = new TelemetryBatch.Sample[count];
+
+        for(int i = 0; i < count; i++)
+        {
+            if(index >= end)
+            {
+                next = -1;
+                return null;
+            }
+
+            int mask = data[index++] & 0xFF;
+
+            for(int field = 0; field < FIELD_COUNT; field++)
+            {
+                if((mask & (1 << field)) == 0)
+                {
+                    continue;
+                }
+
+                int change = 0;
+                int shift  = 0;
+                int octet  = 0;
+
+                do
+                {
+                    if(index >= end)
+                    {
+                        next = -1;
+                        return null;
+                    }
+
+                    octet   = data[index++] & 0xFF;
+                    change |= (octet & 0x7F) << shift;
+                    shift  += 7;
+                }
+                while((octet & 0x80) != 0);
+
+                last[field] += (change >>> 1) ^ -(change & 1);
+            }
+
+            TelemetryBatch.Sample sample = new TelemetryBatch.Sample();
+
+            sample.battery      = last[0];
+            sample.leftCurrent  = last[1];
+            sample.rightCurrent = last[2];
+            sample.leftDuty     = last[3];
+            sample.rightDuty    = last[4];
+            batch.samples[i]    = sample;
+        }
+
+        next = ((key & COUNT_MASK) + 1) & COUNT_MASK;
+        return batch;
+    }
+}
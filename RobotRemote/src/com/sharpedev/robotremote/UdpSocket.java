@@ -1,256 +1,545 @@
-/******************************************************************************
- * NAME: UdpSocket
- * 
- * DESCRIPTION:
- *   Class for handling a single UDP socket. Creates the socket using the 
- *   specified port (or ephemeral if no port specified). Implements basic 
- *   send and receive functionality for the socket. Creates a thread 
- *   to process incoming received messages and places the received messages
- *   in a queue for the user.
- *****************************************************************************/
-package com.sharpedev.robotremote;
-
-import java.net.DatagramPacket;
-import java.net.DatagramSocket;
-import java.net.InetAddress;
-import java.net.SocketException;
-import java.util.LinkedList;
-import java.util.Queue;
-import android.util.Log;
-
-public class UdpSocket implements Runnable {
-    
-    private final String TAG = this.getClass().getSimpleName();
-    
-    boolean        isRunning    = false;
-    boolean        isConnected  = false;    
-    byte[]         rxBuffer     = new byte[1500];
-    DatagramSocket socket       = null;
-    DatagramPacket packet       = null;
-    Thread         rxThread     = null;
-    int            localPort    = 0;
-    int            remotePort   = 0;
-    InetAddress    remoteIp     = null;
-    
-    //Queue for received messages
-    Queue<DatagramPacket> packetQueue = new LinkedList<DatagramPacket>();;      
-    
-    /**
-     * Default Class constructor
-     */
-    public UdpSocket() {
-        
-        //Let the OS assign an ephemeral port for us
-        localPort = 0;      
-    }
-    
-    /**
-     * Constructs a UDP socket using the specified port
-     * 
-     * @param port - the local UDP port for the UDP socket
-     */
-    public UdpSocket(int port) {
-        
-        //Use the specified port for the local port
-        localPort = port;       
-    }   
-    
-    /**
-     * Set the remote end point IP address and port. No connection 
-     * actually takes place. This method allows the socket to set
-     * the end point parameters once instead of passing them repeatedly 
-     * to the sendto method.
-     * 
-     * @param ip - remote IP address
-     * @param port - remote port
-     */
-    public void connect(InetAddress ip, int port) {
-        
-        //No actual connection. 
-        //Just record the remote end point information
-        remoteIp    = ip;
-        remotePort  = port; 
-        isConnected = true;
-    }
-    
-    /**
-     * Open the datagram socket and start the receive thread
-     */
-    public void start() {
-        
-        //Log.d(TAG, "Starting UDP");
-                
-        try {
-            
-            //Create the socket
-            socket = new DatagramSocket(localPort);
-            
-            //Start the receive thread
-            rxThread = new Thread(this);    
-            rxThread.start();
-            
-        } 
-        catch (SocketException e) {
-            
-            Log.e(TAG, "UDP Client start exception");
-            e.printStackTrace();
-        }               
-    }
-    
-    /**
-     * Stop the receive thread and close the socket if not already closed
-     */
-    public void stop() {
-        
-        //Log.d(TAG, "Stopping UDP");
-        
-        //Stop the receive thread
-        isRunning = false;  
-        rxThread.interrupt();
-        
-        //Close the socket
-        if (socket != null) {
-                        
-            socket.close();
-        }
-    }
-    
-    /** 
-     * The UDP socket receive thread. This thread waits for received packets 
-     * on the socket and inserts the received packet in a queue for the user
-     * to retrieve 
-     * 
-     * @see java.lang.Runnable#run()
-     */
-    @Override
-    public void run() {
-        
-        //Run the receive thread in the background
-        android.os.Process.setThreadPriority(android.os.Process.THREAD_PRIORITY_BACKGROUND);            
-
-        try  {                                            
-                        
-            Log.d(TAG, "Enterring UDP receive loop");
-            
-            isRunning = true;
-
-            while(isRunning) {
-                
-                //Create an RX packet buffer
-                packet = new DatagramPacket(rxBuffer, rxBuffer.length);
-                
-                //Wait for received data
-                socket.receive(packet);
-                Log.d(TAG, "Received UDP packet"); 
-                
-                //Add to received packet queue
-                packetQueue.add(packet);                
-            }
-        } 
-        catch (Throwable e) {
-            
-            Log.e(TAG, "UDP Client RX Exception");
-            e.printStackTrace();
-        } 
-        finally {
-            
-            //Clear flag
-            isRunning = false; 
-            
-            //Close the socket when thread exits
-            if (socket != null) {
-                
-                socket.close();
-            }
-        }
-    }
-    
-    /**
-     * Send a UDP packet to the specified IP address and port
-     * 
-     * @param ip - destination IP address
-     * @param port - destination port
-     * @param msg - message to send
-     * @param length - number of bytes to send
-     * @return 1 if success, 0 otherwise
-     */
-    public int sendto(InetAddress ip, int port, byte[] msg, int length) {
-        
-        try {
-                        
-            DatagramPacket p = new DatagramPacket(msg, length, ip, port);           
-            socket.send(p);
-            Log.d(TAG, "Sent UDP packet");
-            return 1;
-        } 
-        catch (Throwable e) {
-            
-            Log.e(TAG, "UDP Client TX Exception");
-            e.printStackTrace();
-        } 
-                
-        return 0;
-    }
-    
-    /**
-     * Send a message to the IP address and port set using the connect method
-     * 
-     * @param msg - message to send
-     * @param length - number of bytes to send
-     * @return 1 if success, 0 otherwise
-     */
-    public int send(byte[] msg, int length) {
-                        
-        if(isConnected) {
-            
-            return sendto(remoteIp, remotePort, msg, length);
-        } 
-                
-        return 0;
-    }
-    
-    /**
-     * Get the next packet from the received message queue
-     * 
-     * @return Next UDP packet from the queue or null if queue is empty
-     */
-    public DatagramPacket recv() {
-        
-        if(!packetQueue.isEmpty()) {
-                            
-            return packetQueue.remove();
-        }
-                
-        return null;
-    }
-    
-    /**
-     * Check if the receive queue has a message in it
-     * 
-     * @return true if queue has a message waiting in it, false if queue is empty
-     */
-    public boolean isRxDataReady() {
-        
-        return !packetQueue.isEmpty();
-    }
-    
-    /**
-     * Check if the receive thread is running
-     * 
-     * @return true if receive thread is running, false otherwise
-     */
-    public boolean isRunning() {
-        
-        return isRunning;
-    }
-
-    /**
-     * Check if the destination IP address and port have been set using connect method 
-     * 
-     * @return true if destination IP address and port are set, false otherwise     
-     */
-    public boolean isConnected() {
-        
-        return isConnected;
-    }
-}
+/******************************************************************************
+ * NAME: UdpSocket
+ * 
+ * DESCRIPTION:
+ *   Class for handling a single UDP socket. Creates the socket using the 
+ *   specified port (or ephemeral if no port specified). Implements basic 
+ *   send and receive functionality for the socket. Creates a thread 
+ *   to process incoming received messages and places the received messages
+ *   in a queue for the user. Outgoing messages are copied into a lock-free
+ *   queue of preallocated slots and sent by a thread of their own, so the
+ *   caller never blocks on the network. Received messages land directly in 
+ *   a lock-free queue of preallocated packets that the user waits on.
+ *****************************************************************************/
+package com.sharpedev.robotremote;
+
+import java.net.DatagramPacket;
+import java.net.DatagramSocket;
+import java.net.InetAddress;
+import java.net.SocketException;
+import java.util.concurrent.locks.LockSupport;
+import android.os.SystemClock;
+import android.util.Log;
+
+public class UdpSocket {
+    
+    /**
+     * Hears about each queued message as its socket send returns, called on
+     * the send thread
+     */
+    public interface SendListener {
+        void onSent(byte[] msg, int length, long now);
+    }
+    
+    private final String TAG = this.getClass().getSimpleName();
+    
+    //Set to log every datagram sent and received
+    static final boolean DEBUG = false;
+    
+    //Send queue depth (power of 2) and the largest message it takes, deep
+    //enough for a clock query to every fleet member in one go
+    static final int TX_QUEUE_SIZE = 32;
+    static final int TX_SLOT_SIZE  = 64;
+    
+    //Receive queue depth (power of 2) and the largest message it takes, the
+    //robot sends nothing close to the module's 2048 byte maximum
+    static final int RX_QUEUE_SIZE = 16;
+    static final int RX_SLOT_SIZE  = 512;
+    
+    volatile boolean isRunning  = false;
+    boolean        isConnected  = false;    
+    DatagramSocket socket       = null;
+    Thread         rxThread     = null;
+    volatile Thread txThread    = null;
+    int            localPort    = 0;
+    int            remotePort   = 0;
+    InetAddress    remoteIp     = null;
+    
+    //Receive queue. The head is written by the receive thread and the tail
+    //by the one thread calling recv, the volatile writes publish the 
+    //packets. The packet last returned by recv stays at the tail until the
+    //next call so it is not overwritten while in use.
+    DatagramPacket[] rxPackets   = new DatagramPacket[RX_QUEUE_SIZE];
+    DatagramPacket   rxSpare     = new DatagramPacket(new byte[RX_SLOT_SIZE], RX_SLOT_SIZE);
+    volatile int     rxHead      = 0;
+    volatile int     rxTail      = 0;
+    boolean          rxHeld      = false;
+    volatile Thread  rxWaiter    = null;
+    int              rxDropped   = 0;
+    
+    //Send queue. Only one thread may call send at a time, the head is 
+    //written by it and the tail by the send thread. The volatile writes 
+    //publish the slot contents. Each slot carries where it goes.
+    byte[][]       txSlots      = new byte[TX_QUEUE_SIZE][TX_SLOT_SIZE];
+    int[]          txLengths    = new int[TX_QUEUE_SIZE];
+    InetAddress[]  txAddresses  = new InetAddress[TX_QUEUE_SIZE];
+    int[]          txPorts      = new int[TX_QUEUE_SIZE];
+    volatile int   txHead       = 0;
+    volatile int   txTail       = 0;
+    DatagramPacket txPacket     = new DatagramPacket(txSlots[0], 0);
+    int            txDropped    = 0;
+    volatile SendListener sendListener = null;
+    
+    /**
+     * Default Class constructor
+     */
+    public UdpSocket() {
+        
+        //Let the OS assign an ephemeral port for us
+        this(0);
+    }
+    
+    /**
+     * Constructs a UDP socket using the specified port
+     * 
+     * @param port - the local UDP port for the UDP socket
+     */
+    public UdpSocket(int port) {
+        
+        //Use the specified port for the local port
+        localPort = port;       
+        
+        for(int i = 0; i < RX_QUEUE_SIZE; i++) {
+            
+            rxPackets[i] = new DatagramPacket(new byte[RX_SLOT_SIZE], RX_SLOT_SIZE);
+        }
+    }   
+    
+    /**
+     * Set the remote end point IP address and port. No connection 
+     * actually takes place. This method allows the socket to set
+     * the end point parameters once instead of passing them repeatedly 
+     * to the sendto method.
+     * 
+     * @param ip - remote IP address
+     * @param port - remote port
+     */
+    public void connect(InetAddress ip, int port) {
+        
+        //No actual connection. 
+        //Just record the remote end point information
+        remoteIp    = ip;
+        remotePort  = port; 
+        isConnected = true;
+    }
+    
+    /**
+     * Open the datagram socket and start the receive and send threads. The
+     * threads of a previous session are stopped first, including those of 
+     * one whose receive thread ended on its own.
+     */
+    public synchronized void start() {
+        
+        //Log.d(TAG, "Starting UDP");
+        
+        stop();
+                
+        try {
+            
+            //Create the socket, the threads are given it so they only ever
+            //close their own
+            final DatagramSocket s = new DatagramSocket(localPort);
+            
+            //Fleet frames go to the network broadcast address
+            s.setBroadcast(true);
+            
+            socket = s;
+            
+            //Running from here on so the caller does not start it twice
+            isRunning = true;
+            
+            //Start the send thread
+            final Thread sender = new Thread() {
+                @Override
+                public void run() {
+                    runSender(s);
+                }
+            };
+            txThread = sender;
+            txThread.start();
+            
+            //Start the receive thread
+            rxThread = new Thread() {
+                @Override
+                public void run() {
+                    runReceiver(s, sender);
+                }
+            };
+            rxThread.start();
+            
+        } 
+        catch (SocketException e) {
+            
+            Log.e(TAG, "UDP Client start exception");
+            e.printStackTrace();
+        }               
+    }
+    
+    /**
+     * Stop the receive and send threads, close the socket if not already 
+     * closed and wait for both threads to exit
+     */
+    public synchronized void stop() {
+        
+        //Log.d(TAG, "Stopping UDP");
+        
+        //Stop the receive and send threads
+        isRunning = false;  
+        
+        if (rxThread != null) {
+            
+            rxThread.interrupt();
+            txThread.interrupt();
+        }
+        
+        //Close the socket, which ends a receive in progress
+        if (socket != null) {
+                        
+            socket.close();
+        }
+        
+        //The next session must not share the queues with these threads
+        try {
+            
+            if (rxThread != null) {
+                
+                rxThread.join();
+                txThread.join();
+            }
+        }
+        catch (InterruptedException e) {
+            
+            Thread.currentThread().interrupt();
+        }
+        
+        rxThread = null;
+        txThread = null;
+        socket   = null;
+    }
+    
+    /** 
+     * The UDP socket receive thread. This thread waits for received packets 
+     * on the socket and inserts the received packet in a queue for the user
+     * to retrieve. Packets that arrive while the queue is full are dropped.
+     * 
+     * @param socket - the session's socket, closed when the thread exits
+     * @param sender - the session's send thread, stopped when this exits
+     */
+    void runReceiver(DatagramSocket socket, Thread sender) {
+        
+        //Run the receive thread in the background
+        android.os.Process.setThreadPriority(android.os.Process.THREAD_PRIORITY_BACKGROUND);            
+
+        try  {                                            
+                        
+            if (DEBUG) Log.d(TAG, "Enterring UDP receive loop");
+            
+            while(isRunning) {
+                
+                int head = rxHead;
+                int next = (head + 1) & (RX_QUEUE_SIZE - 1);
+                
+                //Receive into the free slot, or the spare when full
+                DatagramPacket packet = (next != rxTail) ? rxPackets[head] : rxSpare;
+                packet.setLength(RX_SLOT_SIZE);
+                
+                //Wait for received data
+                socket.receive(packet);
+                if (DEBUG) Log.d(TAG, "Received UDP packet"); 
+                
+                if(packet == rxSpare) {
+                    
+                    rxDropped++;
+                    continue;
+                }
+                
+                //Add to received packet queue and wake the user
+                rxHead = next;
+                
+                Thread waiter = rxWaiter;
+                
+                if(waiter != null) {
+                    
+                    LockSupport.unpark(waiter);
+                }
+            }
+        } 
+        catch (Throwable e) {
+            
+            Log.e(TAG, "UDP Client RX Exception");
+            e.printStackTrace();
+        } 
+        finally {
+            
+            //Clear flag
+            isRunning = false; 
+            
+            //The send thread cannot outlive the socket
+            sender.interrupt();
+            
+            //Close the socket when thread exits
+            socket.close();
+        }
+    }
+    
+    /**
+     * The send thread. This thread waits for messages in the send queue and 
+     * sends them to the IP address and port queued with each, reusing the 
+     * same packet for each.
+     * 
+     * @param socket - the session's socket
+     */
+    void runSender(DatagramSocket socket) {
+        
+        //Sending is on the path from a touch to the robot moving
+        android.os.Process.setThreadPriority(android.os.Process.THREAD_PRIORITY_URGENT_DISPLAY);
+        
+        while(!Thread.interrupted()) {
+            
+            int tail = txTail;
+            
+            //Sleep until send publishes a message
+            if(tail == txHead) {
+                
+                LockSupport.park();
+                continue;
+            }
+            
+            try {
+                
+                txPacket.setData(txSlots[tail], 0, txLengths[tail]);
+                txPacket.setAddress(txAddresses[tail]);
+                txPacket.setPort(txPorts[tail]);
+                socket.send(txPacket);
+                if (DEBUG) Log.d(TAG, "Sent UDP packet");
+                
+                SendListener listener = sendListener;
+                
+                if(listener != null) {
+                    
+                    listener.onSent(txSlots[tail], txLengths[tail], 
+                                    SystemClock.uptimeMillis());
+                }
+            } 
+            catch (Throwable e) {
+                
+                Log.e(TAG, "UDP Client TX Exception");
+                e.printStackTrace();
+            }
+            
+            //Hand the slot back
+            txTail = (tail + 1) & (TX_QUEUE_SIZE - 1);
+        }
+    }
+    
+    /**
+     * Send a UDP packet to the specified IP address and port. This blocks the
+     * caller until the packet is sent.
+     * 
+     * @param ip - destination IP address
+     * @param port - destination port
+     * @param msg - message to send
+     * @param length - number of bytes to send
+     * @return 1 if success, 0 otherwise
+     */
+    public int sendto(InetAddress ip, int port, byte[] msg, int length) {
+        
+        try {
+                        
+            DatagramPacket p = new DatagramPacket(msg, length, ip, port);           
+            socket.send(p);
+            if (DEBUG) Log.d(TAG, "Sent UDP packet");
+            return 1;
+        } 
+        catch (Throwable e) {
+            
+            Log.e(TAG, "UDP Client TX Exception");
+            e.printStackTrace();
+        } 
+                
+        return 0;
+    }
+    
+    /**
+     * Queue a message for the IP address and port set using the connect 
+     * method. The message is copied so the caller may reuse its buffer. Only
+     * one thread may call this at a time.
+     * 
+     * @param msg - message to send
+     * @param length - number of bytes to send
+     * @return 1 if queued, 0 if not connected, the queue is full or the 
+     *         message is larger than TX_SLOT_SIZE
+     */
+    public int send(byte[] msg, int length) {
+        
+        if(!isConnected) {
+            
+            return 0;
+        }
+        
+        return send(remoteIp, remotePort, msg, length);
+    }
+    
+    /**
+     * Queue a message for the specified IP address and port. The message is
+     * copied so the caller may reuse its buffer. Only one thread may call 
+     * this or send at a time.
+     * 
+     * @param ip - destination IP address
+     * @param port - destination port
+     * @param msg - message to send
+     * @param length - number of bytes to send
+     * @return 1 if queued, 0 if not started, the queue is full or the 
+     *         message is larger than TX_SLOT_SIZE
+     */
+    public int send(InetAddress ip, int port, byte[] msg, int length) {
+        
+        int head = txHead;
+        int next = (head + 1) & (TX_QUEUE_SIZE - 1);
+        Thread sender = txThread;
+        
+        if(sender == null || length > TX_SLOT_SIZE) {
+            
+            return 0;
+        }
+        
+        if(next == txTail) {
+            
+            txDropped++;
+            return 0;
+        }
+        
+        System.arraycopy(msg, 0, txSlots[head], 0, length);
+        txLengths[head]   = length;
+        txAddresses[head] = ip;
+        txPorts[head]     = port;
+        txHead = next;
+        
+        //Wake the send thread, a wake before it parks is not lost
+        LockSupport.unpark(sender);
+        
+        return 1;
+    }
+    
+    /**
+     * Set the listener for queued messages being sent
+     * 
+     * @param listener - the listener, null to stop listening
+     */
+    public void setSendListener(SendListener listener) {
+        
+        sendListener = listener;
+    }
+    
+    /**
+     * Get the number of messages dropped because the send queue was full
+     * 
+     * @return dropped message count
+     */
+    public int getTxDropped() {
+        
+        return txDropped;
+    }
+    
+    /**
+     * Get the next packet from the received message queue. The packet and 
+     * its data are valid until the next call. Only one thread may call this.
+     * 
+     * @return Next UDP packet from the queue or null if queue is empty
+     */
+    public DatagramPacket recv() {
+        
+        //Hand the packet returned last time back to the receive thread
+        if(rxHeld) {
+            
+            rxTail = (rxTail + 1) & (RX_QUEUE_SIZE - 1);
+            rxHeld = false;
+        }
+        
+        int tail = rxTail;
+        
+        if(tail == rxHead) {
+            
+            return null;
+        }
+        
+        rxHeld = true;
+        
+        return rxPackets[tail];
+    }
+    
+    /**
+     * Wait for the next packet from the received message queue. The packet 
+     * and its data are valid until the next call. Only one thread may call 
+     * this.
+     * 
+     * @param timeout - longest wait in ms
+     * @return Next UDP packet from the queue or null if none arrived in time
+     */
+    public DatagramPacket recv(long timeout) {
+        
+        long deadline = System.nanoTime() + timeout * 1000000L;
+        long remaining;
+        
+        //Register before looking so a packet published in between wakes us
+        rxWaiter = Thread.currentThread();
+        
+        DatagramPacket packet = recv();
+        
+        //Check again after each wake, a packet published before parking 
+        //makes the park return at once
+        while(packet == null && 
+              (remaining = deadline - System.nanoTime()) > 0 &&
+              !Thread.currentThread().isInterrupted()) {
+            
+            LockSupport.parkNanos(remaining);
+            packet = recv();
+        }
+        
+        rxWaiter = null;
+        
+        return packet;
+    }
+    
+    /**
+     * Check if the receive queue has a message in it
+     * 
+     * @return true if queue has a message waiting in it, false if queue is empty
+     */
+    public boolean isRxDataReady() {
+        
+        int tail = rxHeld ? ((rxTail + 1) & (RX_QUEUE_SIZE - 1)) : rxTail;
+        
+        return tail != rxHead;
+    }
+    
+    /**
+     * Get the number of packets dropped because the receive queue was full
+     * 
+     * @return dropped packet count
+     */
+    public int getRxDropped() {
+        
+        return rxDropped;
+    }
+    
+    /**
+     * Check if the receive thread is running
+     * 
+     * @return true if receive thread is running, false otherwise
+     */
+    public boolean isRunning() {
+        
+        return isRunning;
+    }
+
+    /**
+     * Check if the destination IP address and port have been set using connect method 
+     * 
+     * @return true if destination IP address and port are set, false otherwise     
+     */
+    public boolean isConnected() {
+        
+        return isConnected;
+    }
+}
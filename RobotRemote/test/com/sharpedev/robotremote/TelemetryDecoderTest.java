@@ -0,0 +1,182 @@
+/******************************************************************************
+ * NAME: TelemetryDecoderTest
+ *
+ * DESCRIPTION:
+ *   Decodes compact telemetry frames sent by the robot firmware. The frames
+ *   are the ones the host simulator's telemetry_compact trace sends, the
+ *   robot at rest, ramping up to full speed then settled, so the decoder
+ *   is checked against Telemetry.c rather than against itself.
+ *****************************************************************************/
+package com.sharpedev.robotremote;
+
+import static org.junit.Assert.assertEquals;
+import static org.junit.Assert.assertNotNull;
+import static org.junit.Assert.assertNull;
+
+import org.junit.Before;
+import org.junit.Test;
+
+public class TelemetryDecoderTest {
+
+    static final int VALUE_OFFSET = 6; //start, flags, sequence, length, type, length
+
+    //Reports 0 to 7 then the keyframe that follows them
+    static final String[] FRAMES = {
+        "A5 11 00 19 8D 0F 05 04 00 00 E5 1C FF FF 80 01 CA 73 00 00 00 85 06 00 00 00 00 00 00 D1",
+        "A5 10 02 17 8D 0D 05 04 00 00 E5 1C FF FF 01 00 00 00 00 85 06 00 00 00 00 00 00 6C",
+        "A5 10 03 2E 8D 24 05 03 00 00 78 1B FF FF 02 1F 83 01 90 02 90 02 32 32 1F CB 01 8C 03 8C 03 32 32 1F BF 01 90 03 90 03 32 32 85 06 B2 00 00 00 00 00 E4",
+        "A5 10 04 22 8D 18 05 04 00 00 59 1B FF FF 03 1F C9 01 90 03 90 03 32 32 07 3D 7A 7A 00 00 85 06 5A 02 00 00 00 00 64",
+        "A5 10 05 17 8D 0D 05 04 00 00 59 1B FF FF 04 00 00 00 00 85 06 BE 04 00 00 00 00 7D",
+        "A5 10 07 17 8D 0D 05 04 00 00 59 1B FF FF 05 00 00 00 00 85 06 23 07 00 00 00 00 1C",
+        "A5 10 08 17 8D 0D 05 04 00 00 59 1B FF FF 06 00 00 00 00 85 06 88 09 00 00 00 00 43",
+        "A5 10 09 17 8D 0D 05 04 00 00 59 1B FF FF 07 00 00 00 00 85 06 EC 0B 00 00 00 00 08",
+        "A5 10 0A 21 8D 17 05 04 00 00 59 1B FF FF 88 1F B2 6D B6 0C B6 0C C8 01 C8 01 00 00 00 85 06 51 0E 00 00 00 00 49"
+    };
+
+    TelemetryDecoder decoder;
+
+    @Before
+    public void setUp() {
+
+        decoder = new TelemetryDecoder();
+    }
+
+    /**
+     * The first keyframe codes the battery against zero, the steady samples
+     * after it carry the same values
+     */
+    @Test
+    public void keyframe() {
+
+        TelemetryBatch batch = decode(0);
+
+        assertNotNull(batch);
+        assertEquals(50, batch.period);
+        assertEquals(0, batch.dropped);
+        assertEquals(0, batch.overruns);
+        assertEquals(7397, batch.batteryMin);
+        assertEquals(TelemetryBatch.RANGE_CLEAR, batch.rangeMin);
+        assertEquals(4, batch.samples.length);
+
+        for(TelemetryBatch.Sample sample : batch.samples)
+        {
+            assertSample(sample, 7397, 0, 0, 0, 0);
+        }
+    }
+
+    /**
+     * The changes of each report carry on from the last sample of the one
+     * before, through the ramp to the values of the next keyframe
+     */
+    @Test
+    public void changes() {
+
+        assertNotNull(decode(0));
+        assertNotNull(decode(1));
+
+        TelemetryBatch batch = decode(2);
+
+        assertNotNull(batch);
+        assertEquals(7032, batch.batteryMin);
+        assertEquals(3, batch.samples.length);
+        assertSample(batch.samples[0], 7331, 136, 136, 25, 25);
+        assertSample(batch.samples[1], 7229, 334, 334, 50, 50);
+        assertSample(batch.samples[2], 7133, 534, 534, 75, 75);
+
+        batch = decode(3);
+
+        assertNotNull(batch);
+        assertSample(batch.samples[0], 7032, 734, 734, 100, 100);
+        assertSample(batch.samples[3], 7001, 795, 795, 100, 100);
+
+        for(int i = 4; i < FRAMES.length; i++)
+        {
+            batch = decode(i);
+            assertNotNull(batch);
+            assertSample(batch.samples[batch.samples.length - 1],
+                         7001, 795, 795, 100, 100);
+        }
+
+        assertEquals(0, decoder.getSkipped());
+    }
+
+    /**
+     * Once a report is lost the ones after it are dropped until the next
+     * keyframe
+     */
+    @Test
+    public void lostReport() {
+
+        assertNotNull(decode(0));
+
+        for(int i = 2; i < FRAMES.length - 1; i++)
+        {
+            assertNull(decode(i));
+        }
+
+        assertEquals(FRAMES.length - 3, decoder.getSkipped());
+
+        TelemetryBatch batch = decode(FRAMES.length - 1);
+
+        assertNotNull(batch);
+        assertSample(batch.samples[0], 7001, 795, 795, 100, 100);
+    }
+
+    /**
+     * A report cut short inside a sample is refused
+     */
+    @Test
+    public void truncated() {
+
+        byte[] frame = parse(FRAMES[FRAMES.length - 1]);
+
+        assertNull(decoder.decode(frame, VALUE_OFFSET, 12));
+    }
+
+    /**
+     * Decode the telemetry command of one of the frames
+     *
+     * @param index - FRAMES index
+     * @return the batch
+     */
+    TelemetryBatch decode(int index) {
+
+        byte[] frame = parse(FRAMES[index]);
+
+        assertEquals(RobotProtocol.CMD_TELEMETRY_COMPACT, frame[VALUE_OFFSET - 2] & 0xFF);
+        return decoder.decode(frame, VALUE_OFFSET, frame[VALUE_OFFSET - 1] & 0xFF);
+    }
+
+    /**
+     * Convert space separated hex bytes
+     *
+     * @param hex - bytes as hex
+     * @return the bytes
+     */
+    static byte[] parse(String hex) {
+
+        String[] octets = hex.split(" ");
+        byte[]   data   = new byte[octets.length];
+
+        for(int i = 0; i < octets.length; i++)
+        {
+            data[i] = (byte)Integer.parseInt(octets[i], 16);
+        }
+
+        return data;
+    }
+
+    /**
+     * Check the values of a sample
+     */
+    static void assertSample(TelemetryBatch.Sample sample, int battery,
+                             int leftCurrent, int rightCurrent,
+                             int leftDuty, int rightDuty) {
+
+        assertEquals(battery, sample.battery);
+        assertEquals(leftCurrent, sample.leftCurrent);
+        assertEquals(rightCurrent, sample.rightCurrent);
+        assertEquals(leftDuty, sample.leftDuty);
+        assertEquals(rightDuty, sample.rightDuty);
+    }
+}